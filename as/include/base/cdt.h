@@ -130,6 +130,8 @@ typedef struct cdt_context_s {
 	uint32_t list_nil_pad;
 
 	const uint8_t *create_hdr_ptr;
+
+	bool use_ctx_cache; // read may resume from levels resolved by earlier ops
 } cdt_context;
 
 typedef bool (*cdt_subcontext_fn)(cdt_context *ctx, msgpack_in_vec *val);
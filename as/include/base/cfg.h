@@ -71,6 +71,7 @@ struct as_namespace_s;
 #define MAX_FEATURE_KEY_FILES 32
 
 #define MAX_BATCH_THREADS 256
+#define MAX_PROFILE_SAMPLE_RATE 1000
 #define MAX_TLS_SPECS 10
 
 typedef struct as_config_s {
@@ -84,10 +85,12 @@ typedef struct as_config_s {
 
 	// Note - advertise-ipv6 affects a cf_socket_ee.c global, so can't be here.
 	cf_topo_auto_pin auto_pin;
+	uint32_t		background_dispatch_ratio; // busy service thread passes per background transaction, 0 = no priority
 	uint32_t		n_batch_index_threads;
 	uint32_t		batch_max_buffers_per_queue; // maximum number of buffers allowed in a buffer queue at any one time, fail batch if full
 	uint32_t		batch_max_requests; // maximum count of database requests in a single batch
 	uint32_t		batch_max_unused_buffers; // maximum number of buffers allowed in buffer pool at any one time
+	uint32_t		busy_poll_us; // SO_BUSY_POLL on client sockets (0 = off)
 	char			cluster_name[AS_CLUSTER_NAME_SZ];
 	as_clustering_config clustering_config;
 	cf_alloc_debug	debug_allocations; // how to instrument the memory allocation API
@@ -100,27 +103,40 @@ typedef struct as_config_s {
 	const char*		feature_key_files[MAX_FEATURE_KEY_FILES];
 	uint32_t		n_feature_key_files; // indirect config
 	gid_t			gid;
+	uint32_t		hist_significant_digits; // HDR precision of latency histograms
 	bool			indent_allocations; // pointer indentation for better double-free detection
+	uint32_t		index_tree_gc_max_rate; // elements freed per second, 0 means unlimited
+	uint32_t		n_index_tree_gc_threads;
+	uint32_t		info_cache_ms; // max age of cached expensive info stats, 0 = off
 	uint32_t		n_info_threads;
 	bool			keep_caps_ssd_health;
 	// Note - log-local-time affects a cf_fault.c global, so can't be here.
 	bool			microsecond_histograms;
+	uint32_t		migrate_compression_level; // zlib level for migrated records, 0 = off
 	uint32_t		migrate_fill_delay; // enterprise-only
 	uint32_t		migrate_max_num_incoming;
 	uint32_t		n_migrate_threads;
 	char*			node_id_interface;
 	char*			pidfile;
+	uint32_t		profile_sample_rate; // stack samples per thread CPU-second, 0 = off
+	bool			proto_capture_redact_values; // zero string & blob values in captured protos
+	uint32_t		proto_capture_sample_period; // capture 1 in N client protos, 0 = off
 	int				proto_fd_idle_ms; // after this many milliseconds, connections are aborted unless transaction is in progress
 	uint32_t		n_proto_fd_max;
 	uint32_t		query_max_done; // maximum number of finished queries kept for monitoring
+	uint32_t		query_max_rps; // budget shared by all long queries - 0 means no budget
 	uint32_t		n_query_threads_limit;
 	bool			run_as_daemon;
 	bool			salt_allocations; // initialize with junk - for internal use only
 	uint32_t		n_service_threads;
 	uint32_t		sindex_builder_threads; // secondary index builder thread pool size
+	uint32_t		sindex_gc_max_lock_us; // max time a gc step holds a btree lock
 	uint32_t		sindex_gc_period; // same as nsup_period for sindex gc
+	uint32_t		slow_transaction_log_size; // slowest transactions kept per window, 0 = off
+	uint32_t		stats_snapshot_period; // seconds between stats snapshot publishes, 0 = off
 	bool			stay_quiesced; // enterprise-only
 	uint32_t		ticker_interval;
+	uint32_t		n_tls_handshake_threads; // 0 means handshakes run on service threads
 	uint64_t		transaction_max_ns;
 	uint32_t		transaction_retry_ms;
 	uid_t			uid;
@@ -161,8 +177,11 @@ typedef struct as_config_s {
 	// Normally hidden:
 
 	uint32_t		n_fabric_channel_fds[AS_FABRIC_N_CHANNELS];
+	uint32_t		n_fabric_channel_fds_max[AS_FABRIC_N_CHANNELS]; // 0 = fixed at fds
 	uint32_t		n_fabric_channel_recv_pools[AS_FABRIC_N_CHANNELS];
 	uint32_t		n_fabric_channel_recv_threads[AS_FABRIC_N_CHANNELS];
+	uint32_t		fabric_bulk_send_max_mb; // MiB/s across send threads, 0 = unlimited
+	uint32_t		fabric_rw_busy_poll_us; // SO_BUSY_POLL on RW channel sockets (0 = off)
 	bool			fabric_keepalive_enabled;
 	int				fabric_keepalive_intvl;
 	int				fabric_keepalive_probes;
@@ -76,14 +76,18 @@
 /* Forward declarations */
 typedef struct as_index_s as_record;
 
+struct as_device_heat_s;
 struct as_exp_ctx_s;
+struct as_hot_keys_s;
 struct as_index_ref_s;
 struct as_index_tree_s;
 struct as_msg_s;
 struct as_msg_field_s;
 struct as_msg_op_s;
 struct as_namespace_s;
+struct as_nsup_expire_index_s;
 struct as_set_s;
+struct as_set_hist_s;
 struct as_sindex_s;
 struct as_sindex_arena_s;
 struct as_sindex_config_s;
@@ -180,6 +184,7 @@ COMPILER_ASSERT(sizeof(as_bin_no_meta) == offsetof(as_bin, id) + 2);
 // structs in memory, accessed via this struct.
 typedef struct as_bin_space_s {
 	uint16_t n_bins;
+	uint16_t packed_sz; // small particles packed after bins, in same allocation
 	as_bin bins[0]; // may be array of as_bin or as_min_bin
 } __attribute__ ((__packed__)) as_bin_space;
 
@@ -281,6 +286,7 @@ bool as_bin_particle_bool_value(const as_bin *b);
 uint32_t as_bin_particle_string_ptr(const as_bin *b, char **p_value);
 
 // blob:
+uint32_t as_bin_particle_blob_ptr(const as_bin *b, const uint8_t **p_value);
 int as_bin_bits_modify_tr(as_bin *b, const struct as_msg_op_s *msg_op, cf_ll_buf *particles_llb);
 int as_bin_bits_read_tr(const as_bin *b, const struct as_msg_op_s *msg_op, as_bin *result);
 int as_bin_bits_modify_exp(as_bin *b, msgpack_in_vec* mv, bool alloc_ns);
@@ -299,6 +305,7 @@ typedef void *geo_region_t;
 #define MAX_REGION_CELLS    256
 #define MAX_REGION_LEVELS   30
 size_t as_bin_particle_geojson_cellids(const as_bin *b, uint64_t **pp_cells);
+uint64_t as_particle_geojson_point_cellid(const as_particle *p);
 bool as_particle_geojson_match(as_particle *p, uint64_t cellid, geo_region_t region, bool is_strict);
 bool as_particle_geojson_match_msgpack(msgpack_in* element, uint64_t cellid, geo_region_t region, bool is_strict);
 char const *as_geojson_mem_jsonstr(const as_particle *p, size_t *p_jsonsz);
@@ -314,6 +321,7 @@ void as_bin_particle_list_get_packed_val(const as_bin *b, struct cdt_payload_s *
 
 int as_bin_cdt_modify_tr(as_bin *b, const struct as_msg_op_s *op, as_bin *result, cf_ll_buf *particles_llb);
 int as_bin_cdt_read_tr(const as_bin *b, const struct as_msg_op_s *op, as_bin *result);
+void as_bin_cdt_ctx_cache_reset(void);
 int as_bin_cdt_modify_exp(as_bin *b, msgpack_in_vec* mv, as_bin *result, bool alloc_ns);
 int as_bin_cdt_read_exp(const as_bin *b, msgpack_in_vec* mv, as_bin *result, bool alloc_ns);
 bool as_bin_cdt_get_by_context(const as_bin *b, const uint8_t* ctx, uint32_t ctx_sz, as_bin *result, bool alloc_ns);
@@ -432,7 +440,11 @@ bool as_bin_get_id_w_len(const struct as_namespace_s *ns, const char *name, size
 bool as_bin_get_or_assign_id_w_len(struct as_namespace_s *ns, const char *name, size_t len, uint16_t *id);
 const char* as_bin_get_name_from_id(const struct as_namespace_s *ns, uint16_t id);
 int as_storage_rd_load_bins(struct as_storage_rd_s *rd, as_bin *stack_bins);
+uint16_t as_bin_load_stored(const as_record* r, as_bin* bins);
+const as_particle* as_bin_get_stored_particle(const as_record* r, uint16_t id);
 void as_storage_rd_update_bin_space(struct as_storage_rd_s* rd);
+void as_bin_destroy_all_stored(const as_record* r, as_bin* bins, uint32_t n_bins);
+uint32_t as_bin_relocate_stored(struct as_namespace_s* ns, as_record* r, const cf_alloc_bin_util* util, uint32_t lwm_pct);
 as_bin *as_bin_get_by_id_live(struct as_storage_rd_s *rd, uint32_t id);
 as_bin *as_bin_get(struct as_storage_rd_s *rd, const char *name);
 as_bin *as_bin_get_w_len(struct as_storage_rd_s *rd, const uint8_t *name, size_t len);
@@ -574,6 +586,9 @@ typedef struct as_index_tree_shared_s {
 	// Number of sprigs per partition tree.
 	uint32_t		n_sprigs;
 
+	// Bytes per half of each partition tree's Bloom filter - 0 means none.
+	uint32_t		bloom_size;
+
 	// Bit-shifts used to calculate indexes from digest bits.
 	uint32_t		locks_shift;
 	uint32_t		sprigs_shift;
@@ -665,6 +680,7 @@ typedef struct as_namespace_s {
 	cf_mutex		cold_start_evict_lock;
 	uint32_t		cold_start_record_add_count;
 	uint32_t		cold_start_now;
+	linear_hist*	cold_start_evict_hist; // void-times of loaded evictable records
 
 	// For sanity checking at startup (also used during warm or cool restart).
 	uint32_t		startup_max_void_time;
@@ -681,6 +697,7 @@ typedef struct as_namespace_s {
 
 	// Common partition tree information. Contains two configuration items.
 	as_index_tree_shared tree_shared;
+	uint32_t		sprigs_splitting; // set while trees split to a raised partition-tree-sprigs
 
 	//--------------------------------------------
 	// Storage management.
@@ -691,7 +708,10 @@ typedef struct as_namespace_s {
 
 	uint64_t		drive_size; // discovered (and rounded) size of drive
 	uint32_t		storage_max_write_q; // storage_max_write_cache is converted to this
-	cf_atomic32		n_wblocks_to_flush; // on write queues or shadow queues
+	cf_atomic32		n_wblocks_to_flush; // on write queues, or shadow queues if shadow-max-lag is 0
+	cf_atomic32		n_shadow_wblocks_lagging; // on shadow queues, counted against shadow-max-lag
+	cf_atomic64		n_shadow_lag_throttles; // writes failed because shadow lag exceeded shadow-max-lag
+	uint32_t		storage_shadow_max_lag_q; // storage_shadow_max_lag is converted to this
 	uint32_t		saved_defrag_sleep; // restore after defrag at startup is done
 	uint32_t		defrag_lwm_size; // storage_defrag_lwm_pct % of storage_write_block_size
 
@@ -700,6 +720,10 @@ typedef struct as_namespace_s {
 	cf_atomic32		n_reads_from_cache;
 	cf_atomic32		n_reads_from_device;
 
+	// Smoothed device read latency, tracked while storage_read_offload_us is
+	// set - drives offloading device-bound transactions off service threads.
+	uint32_t		storage_read_latency_us;
+
 	uint8_t			storage_encryption_key[64];
 	uint8_t			storage_encryption_old_key[64];
 
@@ -710,6 +734,12 @@ typedef struct as_namespace_s {
 	uint32_t		smd_evict_void_time;
 	uint32_t		evict_void_time;
 
+	//--------------------------------------------
+	// Expiration.
+	//
+
+	struct as_nsup_expire_index_s* expire_index; // NULL unless nsup-expire-index
+
 	//--------------------------------------------
 	// Truncate records.
 	//
@@ -728,6 +758,7 @@ typedef struct as_namespace_s {
 	uint8_t*		si_startup_gc_bitmap; // optimize sindex startup GC
 	bool			si_startup_gc_needed; // may not need sindex startup GC
 	bool			sindexes_resumed_readable; // optimize startup populate and cool start
+	bool			sindexes_built_at_load; // cold start sweep fed sindexes - skip startup populate
 	uint64_t		si_n_recs_checked; // used only by startup ticker
 
 	uint32_t		n_setless_sindexes;
@@ -741,6 +772,10 @@ typedef struct as_namespace_s {
 	cf_queue*		si_gc_rlist;
 	cf_queue*		si_gc_tlist;
 	bool			si_gc_tlist_map[AS_PARTITIONS][MAX_NUM_TREE_IDS];
+	uint32_t		si_gc_rlist_n_pid[AS_PARTITIONS]; // rlist records per partition
+	// Bulk loads holding off GC - epoch flipped under si_gc_list_mutex.
+	uint32_t		si_gc_hold_epoch;
+	uint32_t		si_gc_n_holds[2];
 
 	//--------------------------------------------
 	// XDR.
@@ -758,6 +793,7 @@ typedef struct as_namespace_s {
 
 	bool			allow_ttl_without_nsup;
 	uint32_t		background_query_max_rps;
+	bool			batch_index_prefetch;
 	conflict_resolution_pol conflict_resolution_policy;
 	bool			conflict_resolve_writes;
 	bool			cp; // relevant only for enterprise edition
@@ -775,34 +811,52 @@ typedef struct as_namespace_s {
 	bool			write_benchmarks_enabled;
 	bool			proxy_hist_enabled;
 	uint32_t		evict_hist_buckets;
+	uint32_t		evict_sample_pct; // 0 means build histogram from all records
 	uint32_t		evict_tenths_pct;
 	uint32_t		hwm_disk_pct;
 	uint32_t		hwm_memory_pct;
+	uint32_t		hot_key_sample_period; // track 1 in this many reads & writes, 0 = off
 	bool			ignore_migrate_fill_delay;
+	bool			index_compact_entries;
+	cf_arenax_mem_cfg index_mem_cfg;
 	uint64_t		index_stage_size;
 	uint32_t		max_record_size;
+	uint32_t		memory_defrag_lwm_pct; // size classes less full than this are relocated from
+	uint32_t		memory_defrag_period; // seconds - 0 means data-in-memory particles aren't defragged
 	uint64_t		memory_size;
+	char*			memory_snapshot_file; // CE record checkpoint for storage-engine memory, written on clean shutdown
 	uint32_t		migrate_order;
 	uint32_t		migrate_retransmit_ms;
 	uint32_t		migrate_sleep;
+	bool			nsup_expire_index; // bucket handles by void-time - nsup visits only due buckets
 	uint32_t		nsup_hist_period;
 	uint32_t		nsup_period;
+	bool			nsup_single_pass; // expire, prep eviction & collect histograms in one sweep
 	uint32_t		n_nsup_threads;
+	bool			optimistic_reads; // metadata-only reads validate lockless lookups instead of locking
 	bool			cfg_prefer_uniform_balance; // relevant only for enterprise edition
 	bool			prefer_uniform_balance; // indirect config - can become disabled if any other node reports disabled
+	uint64_t		query_result_cache_size; // bytes - 0 means basic si-query responses aren't cached
 	uint32_t		rack_id;
 	as_read_consistency_level read_consistency_level;
+	bool			read_steer_device_outliers; // proxy master reads to a prole while a local device is a latency outlier
 	bool			reject_non_xdr_writes;
 	bool			reject_xdr_writes;
 	uint32_t		cfg_replication_factor;
 	uint32_t		replication_factor; // indirect config - can become less than cfg_replication_factor
+	const char*		service_thread_cpus; // OS CPU list for the namespace's service threads - NULL means unpinned
+	uint32_t		n_service_threads; // dedicated to the namespace's client transactions - 0 means shared
+	const char*		sindex_flash_dir; // if set, sindex arena stages are files here, mapped and paged by the OS
 	uint64_t		sindex_stage_size;
+	bool			sindex_ordered_strings;
 	bool			single_bin; // restrict the namespace to objects with exactly one bin
 	uint32_t		n_single_query_threads;
 	uint32_t		stop_writes_pct;
 	uint32_t		tomb_raider_eligible_age; // relevant only for enterprise edition
 	uint32_t		tomb_raider_period; // relevant only for enterprise edition
 	uint32_t		transaction_pending_limit; // 0 means no limit
+	uint32_t		truncate_latency_ms; // read/write latency above which truncate backs off - 0 means off
+	uint32_t		truncate_max_rate; // records deleted per second - 0 means unlimited
 	uint32_t		n_truncate_threads;
 	as_write_commit_level write_commit_level;
 	uint64_t		xdr_bin_tombstone_ttl_ms;
@@ -823,34 +877,55 @@ typedef struct as_namespace_s {
 	const char*		storage_shadows[AS_STORAGE_MAX_DEVICES];
 	uint32_t		n_storage_shadows; // indirect config
 
+	uint32_t		storage_background_read_depth; // per device, per background I/O class (0 = no limit)
 	bool			storage_cache_replica_writes;
+	bool			storage_coalesce_batch_reads;
 	bool			storage_cold_start_empty;
-	bool			storage_commit_to_device; // relevant only for enterprise edition
+	uint32_t		storage_cold_start_threads;
+	bool			storage_commit_to_device; // CE group commits - EE commits per write
 	uint32_t		storage_commit_min_size; // relevant only for enterprise edition
+	uint32_t		storage_commit_window_us; // group commit leader waits this long to gather writes
 	as_compression_method storage_compression; // relevant only for enterprise edition
 	uint32_t		storage_compression_level; // relevant only for enterprise edition
 	bool			storage_data_in_memory;
+	bool			storage_dax_map; // files on a DAX filesystem - mapped, no read or write syscalls
 	uint32_t		storage_defrag_lwm_pct;
 	uint32_t		storage_defrag_queue_min;
 	uint32_t		storage_defrag_sleep;
 	uint32_t		storage_defrag_startup_minimum;
+	uint32_t		storage_defrag_target_read_us; // pace defrag to keep device reads under this (0 = fixed defrag-sleep)
 	bool			storage_direct_files;
 	bool			storage_disable_odsync;
 	bool			storage_benchmarks_enabled; // histograms are per-drive except device-read-size & device-write-size
+	bool			storage_latency_map_enabled; // per-device time x latency heat maps
 	as_encryption_method storage_encryption; // relevant only for enterprise edition
 	char*			storage_encryption_key_file; // relevant only for enterprise edition
 	char*			storage_encryption_old_key_file; // relevant only for enterprise edition
 	uint64_t		storage_filesize;
 	uint64_t		storage_flush_max_us;
+	uint64_t		storage_flush_max_defer_us; // longest to hold an under-filled current write buffer (0 = never)
+	uint32_t		storage_flush_min_fill_pct; // defer flushing current write buffers filled less than this
+	char*			storage_index_snapshot_file; // CE index checkpoint written on clean shutdown
+	uint32_t		storage_large_record_stream_size; // records this big or bigger get their own write stream (0 = off)
 	uint64_t		storage_max_write_cache;
 	uint32_t		storage_min_avail_pct;
+	bool			storage_numa_local_write_buffers; // write buffers on device NUMA node, huge pages if possible
 	cf_atomic32 	storage_post_write_queue; // number of swbs/device held after writing to device
+	uint64_t		storage_read_cache_size; // 0 means no record cache
+	bool			storage_read_io_uring;
+	uint32_t		storage_read_offload_us; // offload device-bound transactions above this read latency (0 = never)
 	bool			storage_read_page_cache;
+	bool			storage_record_checksums; // CRC32C end marks, verified on device reads
+	bool			storage_scan_device_order; // PI queries read each chunk of a partition in device order
 	char*			storage_scheduler_mode; // relevant for devices only, not files
 	bool			storage_serialize_tomb_raider; // relevant only for enterprise edition
+	uint64_t		storage_shadow_max_lag; // per device - shadow writes may trail primary by this much (0 = lockstep)
+	uint32_t		storage_shed_low_priority_pct; // shed batch/background/XDR work above this % of max write queue (0 = never)
 	bool			storage_sindex_startup_device_scan;
 	uint32_t		storage_tomb_raider_sleep; // relevant only for enterprise edition
+	uint32_t		storage_ttl_write_streams; // client write streams, split by TTL band
 	uint32_t		storage_write_block_size;
+	bool			storage_write_lifetime_hints;
 
 	bool			geo2dsphere_within_strict;
 	uint16_t		geo2dsphere_within_min_level;
@@ -892,6 +967,8 @@ typedef struct as_namespace_s {
 
 	uint32_t		nsup_cycle_duration; // seconds taken for most recent nsup cycle
 
+	uint64_t		n_memory_defrag_moved; // allocations relocated by memory defrag
+
 	// Sindex GC stats.
 
 	uint64_t		n_sindex_gc_cleaned;
@@ -930,7 +1007,7 @@ typedef struct as_namespace_s {
 	cf_atomic_int	appeals_tx_remaining; // relevant only for enterprise edition
 
 	// Per-record migration stats:
-	cf_atomic_int	migrate_records_skipped; // relevant only for enterprise edition
+	cf_atomic_int	migrate_records_skipped; // by meta-batch merge or delta migration
 	cf_atomic_int	migrate_records_transmitted;
 	cf_atomic_int	migrate_record_retransmits;
 	cf_atomic_int	migrate_record_receives;
@@ -1191,11 +1268,21 @@ typedef struct as_namespace_s {
 	uint64_t		n_si_query_ops_bg_error;
 	uint64_t		n_si_query_ops_bg_abort;
 
+	uint64_t		n_si_query_index_only_records; // answered without reading record
+
+	uint64_t		n_si_query_cache_hits; // partitions answered from result cache
+	uint64_t		n_si_query_cache_misses;
+	uint64_t		si_query_cache_bytes;
+
+	// Record writes per partition, only counted if result cache is configured.
+	uint64_t		si_query_cache_writes[AS_PARTITIONS];
+
 	// Geospatial query stats:
 	cf_atomic64		geo_region_query_count;		// number of region queries
 	cf_atomic64		geo_region_query_cells;		// number of cells used by region queries
 	cf_atomic64		geo_region_query_points;	// number of valid points found
 	cf_atomic64		geo_region_query_falsepos;	// number of false positives found
+	cf_atomic64		geo_region_query_cache_hits; // region coverings found in cache
 
 	// Re-replication stats - relevant only for enterprise edition.
 
@@ -1215,6 +1302,15 @@ typedef struct as_namespace_s {
 	// Special non-error counters:
 
 	cf_atomic64		n_deleted_last_bin;
+	cf_atomic64		n_reads_steered;
+
+	// Top-K sketch of sampled hot keys.
+
+	struct as_hot_keys_s* hot_keys;
+
+	// Per-device latency heat maps - null if namespace has no devices.
+
+	struct as_device_heat_s* device_heat;
 
 	// One-way automatically activated histograms.
 
@@ -1236,6 +1332,10 @@ typedef struct as_namespace_s {
 	bool			si_query_rec_count_hist_active;
 	bool			re_repl_hist_active; // relevant only for enterprise edition
 
+	// Per-set histograms - one-way activated when any set enables them.
+
+	bool			set_hist_active;
+
 	// Activate-by-config histograms.
 
 	histogram*		proxy_hist;
@@ -1244,13 +1344,15 @@ typedef struct as_namespace_s {
 	histogram*		read_restart_hist;
 	histogram*		read_dup_res_hist;
 	histogram*		read_repl_ping_hist;
+	histogram*		read_record_lock_hist; // finding and locking the record
 	histogram*		read_local_hist;
 	histogram*		read_response_hist;
 
 	histogram*		write_start_hist;
 	histogram*		write_restart_hist;
 	histogram*		write_dup_res_hist;
-	histogram*		write_master_hist; // split this?
+	histogram*		write_record_lock_hist; // finding (or creating) and locking the record
+	histogram*		write_master_hist; // split further?
 	histogram*		write_repl_write_hist;
 	histogram*		write_response_hist;
 
@@ -1359,7 +1461,8 @@ typedef struct as_set_s {
 	bool			eviction_disabled;	// don't evict anything in this set (note - expiration still works)
 	bool			index_enabled;
 	bool			index_populating;
-	uint8_t			pad[9];
+	bool			hist_enabled;		// per-set latency histograms & op counters
+	struct as_set_hist_s* hist;			// allocated on first enable, never freed
 } as_set;
 
 COMPILER_ASSERT(sizeof(as_set) == 128);
@@ -1419,9 +1522,11 @@ struct as_set_s* as_namespace_get_record_set(as_namespace *ns, const as_record *
 void as_namespace_get_set_info(as_namespace *ns, const char *set_name, cf_dyn_buf *db);
 void as_namespace_adjust_set_memory(as_namespace *ns, uint16_t set_id, int64_t delta_bytes);
 void as_namespace_adjust_set_device_bytes(as_namespace *ns, uint16_t set_id, int64_t delta_bytes);
+void as_namespace_reserve_set_id(as_namespace *ns, uint16_t set_id);
 void as_namespace_release_set_id(as_namespace *ns, uint16_t set_id);
 void as_namespace_get_bins_info(as_namespace *ns, cf_dyn_buf *db, bool show_ns);
 void as_namespace_get_hist_info(as_namespace *ns, char *set_name, char *hist_name, cf_dyn_buf *db);
+bool as_namespace_split_sprigs(as_namespace *ns, uint32_t n_sprigs);
 
 static inline bool
 as_namespace_like_data_in_memory(const as_namespace *ns)
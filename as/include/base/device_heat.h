@@ -0,0 +1,103 @@
+/*
+ * device_heat.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+#include "citrusleaf/cf_clock.h"
+
+#include "dynbuf.h"
+
+#include "base/datamodel.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+typedef enum {
+	AS_DEVICE_HEAT_READ,
+	AS_DEVICE_HEAT_WRITE,
+
+	AS_DEVICE_HEAT_N_TYPES
+} as_device_heat_type;
+
+#define AS_DEVICE_HEAT_READ_SAMPLING_MASK 0xF // 1 out of 16 reads
+#define AS_DEVICE_HEAT_N_SLICES 60
+#define AS_DEVICE_HEAT_SLICE_SEC 10
+#define AS_DEVICE_HEAT_N_BUCKETS 24 // bucket i is [2^i, 2^(i+1)) us, 0 includes 0
+
+typedef struct as_device_heat_slice_s {
+	uint64_t period; // slice-sec periods since clock start
+	uint32_t counts[AS_DEVICE_HEAT_N_BUCKETS];
+} as_device_heat_slice;
+
+// One per device - a ring of time slices per op type.
+typedef struct as_device_heat_s {
+	as_device_heat_slice slices[AS_DEVICE_HEAT_N_TYPES][AS_DEVICE_HEAT_N_SLICES];
+} as_device_heat;
+
+
+//==========================================================
+// Globals.
+//
+
+extern __thread uint32_t g_device_heat_read_counter;
+
+
+//==========================================================
+// Public API.
+//
+
+as_device_heat* as_device_heat_create(const as_namespace* ns);
+void as_device_heat_get(const as_namespace* ns, cf_dyn_buf* db);
+
+// Not called directly - called by inline wrappers below.
+void device_heat_add(as_device_heat* heat, as_device_heat_type type, uint64_t start_us);
+
+static inline uint64_t
+as_device_heat_read_start(const as_namespace* ns)
+{
+	return ns->storage_latency_map_enabled &&
+			(g_device_heat_read_counter++ &
+					AS_DEVICE_HEAT_READ_SAMPLING_MASK) == 0 ? cf_getus() : 0;
+}
+
+static inline uint64_t
+as_device_heat_write_start(const as_namespace* ns)
+{
+	return ns->storage_latency_map_enabled ? cf_getus() : 0;
+}
+
+static inline void
+as_device_heat_add(as_namespace* ns, uint32_t d_id, as_device_heat_type type,
+		uint64_t start_us)
+{
+	if (start_us != 0) {
+		device_heat_add(&ns->device_heat[d_id], type, start_us);
+	}
+}
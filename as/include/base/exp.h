@@ -34,11 +34,21 @@
 #include "base/datamodel.h"
 #include "base/index.h"
 
-
 //==========================================================
 // Typedefs & constants.
 //
 
+#define AS_EXP_MAX_META_TERMS 4
+
+// Comparison of a record metadata field with a constant - the batchable terms
+// of a metadata filter.
+typedef struct as_exp_meta_term_s {
+	uint8_t field; // metadata op code
+	uint8_t cmp; // compare op code, metadata on the left
+	int32_t mod; // for digest modulo
+	int64_t value;
+} as_exp_meta_term;
+
 typedef struct as_exp_s {
 	uint8_t version;
 	uint32_t expected_type;
@@ -46,6 +56,13 @@ typedef struct as_exp_s {
 	uint32_t cleanup_stack_ix;
 	uint8_t* buf_cleanup;
 	uint32_t max_var_count;
+	uint32_t bin_slot_count; // distinct bins referenced
+	const uint8_t* ref_bin_name; // first bin referenced, if any
+	uint32_t ref_bin_name_sz;
+	bool refs_other_data; // another bin, or the record key
+	bool refs_meta; // record metadata
+	uint32_t n_meta_terms; // if any term is false, so is the expression
+	as_exp_meta_term meta_terms[AS_EXP_MAX_META_TERMS];
 	uint8_t mem[];
 } as_exp;
 
@@ -72,5 +89,19 @@ as_exp* as_exp_build_buf(const uint8_t* buf, uint32_t buf_sz, bool cpy_wire);
 bool as_exp_eval(const as_exp* exp, const as_exp_ctx* ctx, as_bin* rb, cf_ll_buf* particles_llb, bool is_modify);
 as_exp_trilean as_exp_matches_metadata(const as_exp* predexp, const as_exp_ctx* ctx);
 bool as_exp_matches_record(const as_exp* predexp, const as_exp_ctx* ctx);
+void as_exp_matches_metadata_batch(const as_exp* predexp, as_record* const* rs, uint32_t n_rs, uint8_t* keep);
+bool as_exp_refs_only_bin(const as_exp* exp, const char* name);
+bool as_exp_is_bin_function(const as_exp* exp, const char* name);
 bool as_exp_display(const as_exp* exp, cf_dyn_buf* db);
 void as_exp_destroy(as_exp* exp);
+
+
+//==========================================================
+// Inlines & macros.
+//
+
+static inline bool
+as_exp_metadata_batchable(const as_exp* predexp)
+{
+	return predexp->n_meta_terms != 0;
+}
@@ -62,6 +62,7 @@ typedef enum {
 //
 
 extern bool g_health_enabled;
+extern bool g_health_device_outlier[]; // per namespace, from last detection
 
 extern __thread uint64_t g_device_read_counter;
 extern __thread uint64_t g_replica_write_counter;
@@ -73,6 +74,7 @@ extern __thread uint64_t g_replica_write_counter;
 
 void as_health_get_outliers(cf_dyn_buf* db);
 void as_health_get_stats(cf_dyn_buf* db);
+bool as_health_recent_read_latency(uint32_t ns_ix, uint32_t* lat_us);
 void as_health_start();
 
 // Not called directly - called by inline wrappers below.
@@ -94,6 +96,12 @@ as_health_sample_replica_write()
 			(g_replica_write_counter++ & AS_HEALTH_SAMPLING_MASK) == 0;
 }
 
+static inline bool
+as_health_has_device_outlier(uint32_t ns_ix)
+{
+	return g_health_enabled && g_health_device_outlier[ns_ix];
+}
+
 static inline void
 as_health_add_device_latency(uint32_t ns_ix, uint32_t d_id, uint64_t start_us)
 {
@@ -0,0 +1,72 @@
+/*
+ * hot_keys.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "citrusleaf/cf_digest.h"
+
+#include "dynbuf.h"
+
+#include "base/datamodel.h"
+
+
+//==========================================================
+// Forward declarations.
+//
+
+struct as_hot_keys_s;
+
+
+//==========================================================
+// Globals.
+//
+
+extern __thread uint32_t g_hot_key_counter;
+
+
+//==========================================================
+// Public API.
+//
+
+struct as_hot_keys_s* as_hot_keys_create(void);
+void as_hot_keys_get(as_namespace* ns, uint32_t max_keys, cf_dyn_buf* db);
+
+// Not called directly - called by inline wrapper below.
+void hot_keys_add(struct as_hot_keys_s* hk, uint32_t sample_period, const cf_digest* keyd, bool is_write);
+
+static inline void
+as_hot_keys_sample(as_namespace* ns, const cf_digest* keyd, bool is_write)
+{
+	uint32_t period = ns->hot_key_sample_period;
+
+	if (period != 0 && ++g_hot_key_counter >= period) {
+		g_hot_key_counter = 0;
+		hot_keys_add(ns->hot_keys, period, keyd, is_write);
+	}
+}
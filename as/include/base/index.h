@@ -112,6 +112,12 @@ COMPILER_ASSERT(sizeof(as_index) == 64);
 
 #define AS_INDEX_SINGLE_BIN_OFFSET 55 // can't use offsetof() with bit fields
 
+// Data-not-in-memory namespaces may drop dim - arena elements are then this
+// size, and dim must never be touched.
+#define AS_INDEX_COMPACT_SIZE 56
+
+#define MAX_INDEX_TREE_GC_THREADS 32
+
 
 //==========================================================
 // Accessor functions for bits in as_index.
@@ -133,7 +139,7 @@ COMPILER_ASSERT(sizeof(as_index) == 64);
 // Note - relies on current layout and size of as_index!
 // FIXME - won't be able to "rescue" with future sindex method - will go away.
 static inline void
-as_index_clear_record_info(as_index* index)
+as_index_clear_record_info(as_index* index, bool has_dim)
 {
 	*(uint16_t*)((uint8_t*)index + 34) = 0;
 	*(uint32_t*)((uint8_t*)index + 36) = 0;
@@ -142,7 +148,11 @@ as_index_clear_record_info(as_index* index)
 
 	*p_clear++	= 0;
 	*p_clear++	= 0;
-	*p_clear	= 0;
+
+	// Compact (data-not-in-memory) elements end before dim.
+	if (has_dim) {
+		*p_clear = 0;
+	}
 }
 
 // Generation 0 is never written, and generation plays no role in record
@@ -273,6 +283,37 @@ struct as_set_index_tree_s;
 
 typedef void (*as_index_tree_done_fn) (uint8_t id, void* udata);
 
+#define NUM_LOCK_PAIRS 256 // per partition
+
+typedef struct as_sprig_s {
+	uint64_t root_h: 40;
+} __attribute__((packed)) as_sprig;
+
+// A tree's sprig roots and the shift that indexes them. Replaced whole when
+// the tree's sprig count is doubled - see as_index_tree_split_sprigs().
+typedef struct as_sprig_layout_s {
+	uint32_t shift;
+	uint32_t n_sprigs;
+	as_sprig* sprigs;
+	struct as_sprig_layout_s* next_retired;
+} as_sprig_layout;
+
+// Blocked Bloom filter over a tree's digests, so lookups of absent keys can
+// skip the sprig lock and descent. Bits are never cleared in place - deletes
+// leave stale bits, which a rebuild into the idle half purges before the
+// halves are swapped.
+typedef struct as_index_bloom_s {
+	uint32_t gen; // bumped by each swap - low bit picks the half probed
+	uint32_t valid; // 0 until built, for trees resumed with elements
+	uint32_t building; // inserts set bits in both halves while set
+	uint32_t n_blocks; // per half - a power of 2
+	uint64_t n_deletes; // since the last rebuild started
+	uint64_t* halves[2];
+} as_index_bloom;
+
+#define AS_INDEX_BLOOM_MIN_SIZE 64 // one block - a cache line
+#define AS_INDEX_BLOOM_MAX_SIZE (16 * 1024 * 1024)
+
 typedef struct as_index_tree_s {
 	uint8_t id;
 	as_index_tree_done_fn done_cb;
@@ -283,6 +324,19 @@ typedef struct as_index_tree_s {
 
 	uint64_t n_elements;
 
+	// Starts as base_layout (variable length data), may be doubled online.
+	as_sprig_layout* layout;
+	as_sprig_layout* split_layout; // set while splitting
+	uint64_t split_groups[NUM_LOCK_PAIRS / 64]; // lock pairs in split_layout
+	as_sprig_layout* retired_layouts; // lockless readers may still use these
+	as_sprig_layout base_layout;
+
+	// Splits wait for reduces to drain, and block new ones.
+	uint32_t n_reducers;
+	uint32_t splitting;
+
+	as_index_bloom* bloom; // null unless partition-tree-bloom-size is set
+
 	cf_mutex set_trees_lock;
 	struct as_set_index_tree_s* set_trees[1 + AS_SET_MAX_COUNT]; // 32M/cluster
 
@@ -295,20 +349,20 @@ typedef struct as_index_tree_s {
 // as_index_tree variable length data components.
 //
 
-#define NUM_LOCK_PAIRS 256 // per partition
+// Trees are split into this many slices (of whole sprigs) so full-namespace
+// jobs can share out work finer than a partition.
+#define AS_INDEX_N_REDUCE_SLICES 16
+#define AS_INDEX_N_REDUCE_ITEMS (AS_PARTITIONS * AS_INDEX_N_REDUCE_SLICES)
 
 typedef struct as_lock_pair_s {
 	// Note: reduce_lock's scope is always inside of lock's scope.
 	cf_mutex lock;        // insert, delete vs. insert, delete, get
 	cf_mutex reduce_lock; // insert, delete vs. reduce
+	uint32_t seq;         // odd while lock is held - validates optimistic reads
 } as_lock_pair;
 
 #define NUM_SPRIG_BITS 28 // 3.5 bytes - yes, that's a lot of sprigs
 
-typedef struct as_sprig_s {
-	uint64_t root_h: 40;
-} __attribute__((packed)) as_sprig;
-
 static inline as_lock_pair*
 tree_locks(as_index_tree* tree)
 {
@@ -318,7 +372,7 @@ tree_locks(as_index_tree* tree)
 static inline as_sprig*
 tree_sprigs(as_index_tree* tree)
 {
-	return (as_sprig*)(tree->data + tree->shared->sprigs_offset);
+	return tree->layout->sprigs;
 }
 
 static inline cf_arenax_puddle*
@@ -356,6 +410,8 @@ tree_puddles_count(as_index_tree_shared* shared)
 
 void as_index_tree_gc_init();
 uint32_t as_index_tree_gc_queue_size();
+uint32_t as_index_tree_gc_n_active();
+uint64_t as_index_tree_gc_n_freed();
 void as_index_tree_gc(as_index_tree* tree);
 
 as_index_tree* as_index_tree_create(as_index_tree_shared* shared, uint8_t id, as_index_tree_done_fn cb, void* udata);
@@ -364,18 +420,51 @@ void as_index_tree_block(as_index_tree* tree);
 void as_index_tree_reserve(as_index_tree* tree);
 void as_index_tree_release(as_namespace* ns, as_index_tree* tree);
 uint64_t as_index_tree_size(as_index_tree* tree);
+bool as_index_tree_split_sprigs(as_index_tree* tree);
+bool as_index_tree_rebuild_bloom(as_index_tree* tree);
 
 typedef bool (*as_index_reduce_fn) (as_index_ref* value, void* udata);
 
 bool as_index_reduce(as_index_tree* tree, as_index_reduce_fn cb, void* udata);
 bool as_index_reduce_from(as_index_tree* tree, const cf_digest* keyd, as_index_reduce_fn cb, void* udata);
 
+bool as_index_reduce_slice(as_index_tree* tree, uint32_t slice_i, as_index_reduce_fn cb, void* udata);
+bool as_index_reduce_blocked(as_index_tree* tree, as_index_reduce_fn cb, void* udata);
+
 bool as_index_reduce_live(as_index_tree* tree, as_index_reduce_fn cb, void* udata);
 bool as_index_reduce_from_live(as_index_tree* tree, const cf_digest* keyd, as_index_reduce_fn cb, void* udata);
 
+// Sets keep[i] to 0 if rs[i] needn't be passed to the reduce callback.
+typedef void (*as_index_filter_fn) (as_index* const* rs, uint32_t n_rs, uint8_t* keep, void* udata);
+
+bool as_index_reduce_from_filtered(as_index_tree* tree, const cf_digest* keyd, as_index_filter_fn filter, as_index_reduce_fn cb, void* udata);
+bool as_index_reduce_from_live_filtered(as_index_tree* tree, const cf_digest* keyd, as_index_filter_fn filter, as_index_reduce_fn cb, void* udata);
+
+// Position in a tree's descending digest order, for reducing in bounded
+// chunks. Position is a boundary digest, not a node, so it stays valid however
+// the tree changes between chunks.
+typedef struct as_index_cursor_s {
+	as_index_tree* tree;
+	uint32_t sprigs_shift; // layout sprig_i refers to - tree may split meanwhile
+	int32_t sprig_i; // next sprig to reduce - negative when done
+	bool has_keyd;
+	cf_digest keyd; // boundary within sprig_i - excluded, like reduce_from
+} as_index_cursor;
+
+void as_index_cursor_init(as_index_cursor* cursor, as_index_tree* tree, const cf_digest* keyd);
+bool as_index_cursor_next(as_index_cursor* cursor, uint32_t max_n, as_index_reduce_fn cb, void* udata);
+
+static inline bool
+as_index_cursor_done(const as_index_cursor* cursor)
+{
+	return cursor->sprig_i < 0;
+}
+
 int as_index_get_vlock(as_index_tree* tree, const cf_digest* keyd, as_index_ref* index_ref);
+int as_index_get_optimistic(as_index_tree* tree, const cf_digest* keyd, as_index* snapshot);
 int as_index_get_insert_vlock(as_index_tree* tree, const cf_digest* keyd, as_index_ref* index_ref);
 void as_index_delete(as_index_tree* tree, const cf_digest* keyd);
+void as_index_prefetch_multi(as_index_tree* const* trees, const cf_digest* keyds, uint32_t n_keys);
 
 // Used by queries when reserving arena refs.
 
@@ -393,6 +482,29 @@ as_index_olock_from_keyd(as_index_tree* tree, const cf_digest* keyd)
 	return &((tree_locks(tree) + lock_i))->lock;
 }
 
+// Every holder of a record (sprig) lock must use these - the seq bumps let
+// optimistic readers detect that they may have raced with the holder.
+
+static inline void
+as_index_olock_lock(cf_mutex* olock)
+{
+	as_lock_pair* pair = (as_lock_pair*)olock; // lock is first member
+
+	cf_mutex_lock(olock);
+	as_store_uint32(&pair->seq, pair->seq + 1);
+	as_fence_rls();
+}
+
+static inline void
+as_index_olock_unlock(cf_mutex* olock)
+{
+	as_lock_pair* pair = (as_lock_pair*)olock; // lock is first member
+
+	as_fence_rls();
+	as_store_uint32(&pair->seq, pair->seq + 1);
+	cf_mutex_unlock(olock);
+}
+
 static inline cf_mutex*
 as_index_rlock_from_keyd(as_index_tree* tree, const cf_digest* keyd)
 {
@@ -439,6 +551,8 @@ void as_index_grow_ph_array(as_index_ph_array* ph_a);
 
 // Container for sprig-level function parameters.
 typedef struct as_index_sprig_s {
+	as_index_tree* tree;
+
 	as_index_value_destructor destructor;
 	void* destructor_udata;
 
@@ -455,40 +569,69 @@ int as_index_sprig_get_vlock(as_index_sprig* isprig, const cf_digest* keyd, as_i
 int as_index_sprig_delete(as_index_sprig* isprig, const cf_digest* keyd);
 
 static inline uint32_t
-as_index_sprig_i_from_keyd(as_index_tree* tree, const cf_digest* keyd)
+as_index_sprig_bits(const cf_digest* keyd)
 {
 	// Get the 28 most significant non-pid bits in the digest. Note - this is
 	// hardwired around the way we currently extract the (12 bit) partition-ID
 	// from the digest.
-	uint32_t bits = (((uint32_t)keyd->digest[1] & 0xF0) << 20) |
+	return (((uint32_t)keyd->digest[1] & 0xF0) << 20) |
 			((uint32_t)keyd->digest[2] << 16) |
 			((uint32_t)keyd->digest[3] << 8) |
 			(uint32_t)keyd->digest[4];
+}
 
-	return bits >> tree->shared->sprigs_shift;
+// Exact only under the lock pair - without it, the layout may be stale but is
+// still safe to read.
+static inline as_sprig_layout*
+as_index_layout_for_lock(as_index_tree* tree, uint32_t lock_i)
+{
+	if ((as_load_uint64(&tree->split_groups[lock_i / 64]) &
+			(1UL << (lock_i % 64))) != 0) {
+		as_sprig_layout* split_layout = tree->split_layout;
+
+		if (split_layout != NULL) {
+			return split_layout;
+		}
+	}
+
+	return tree->layout;
+}
+
+// Only for reduces - splits are kept out while they run.
+static inline uint32_t
+as_index_sprig_i_from_keyd(as_index_tree* tree, const cf_digest* keyd)
+{
+	return as_index_sprig_bits(keyd) >> tree->layout->shift;
+}
+
+// Callers that made isprig without holding its lock pair must locate again
+// once they hold it - the sprig may have moved in a split.
+static inline void
+as_index_sprig_locate(as_index_sprig* isprig, const cf_digest* keyd)
+{
+	as_index_tree* tree = isprig->tree;
+	uint32_t bits = as_index_sprig_bits(keyd);
+	as_sprig_layout* layout = as_index_layout_for_lock(tree,
+			bits >> tree->shared->locks_shift);
+	uint32_t sprig_i = bits >> layout->shift;
+
+	isprig->sprig = layout->sprigs + sprig_i;
+	isprig->puddle = tree_puddle_for_sprig(tree, sprig_i);
 }
 
 static inline void
 as_index_sprig_from_keyd(as_index_tree* tree, as_index_sprig* isprig,
 		const cf_digest* keyd)
 {
-	// Get the 28 most significant non-pid bits in the digest. Note - this is
-	// hardwired around the way we currently extract the (12 bit) partition-ID
-	// from the digest.
-	uint32_t bits = (((uint32_t)keyd->digest[1] & 0xF0) << 20) |
-			((uint32_t)keyd->digest[2] << 16) |
-			((uint32_t)keyd->digest[3] << 8) |
-			(uint32_t)keyd->digest[4];
-
-	uint32_t lock_i = bits >> tree->shared->locks_shift;
-	uint32_t sprig_i = bits >> tree->shared->sprigs_shift;
+	uint32_t lock_i = as_index_sprig_bits(keyd) >> tree->shared->locks_shift;
 
+	isprig->tree = tree;
 	isprig->destructor = tree->shared->destructor;
 	isprig->destructor_udata = tree->shared->destructor_udata;
 	isprig->arena = tree->shared->arena;
 	isprig->pair = tree_locks(tree) + lock_i;
-	isprig->sprig = tree_sprigs(tree) + sprig_i;
-	isprig->puddle = tree_puddle_for_sprig(tree, sprig_i);
+
+	as_index_sprig_locate(isprig, keyd);
 }
 
 #define RESOLVE(__h) ((as_index*)cf_arenax_resolve(isprig->arena, __h))
@@ -69,6 +69,7 @@ typedef struct as_mon_jobstat_s {
 	uint64_t	recs_throttled;
 	uint64_t	recs_filtered_meta;
 	uint64_t	recs_filtered_bins;
+	uint64_t	recs_filtered_and;
 	uint64_t	recs_succeeded;
 	uint64_t	recs_failed;
 	uint64_t	net_io_bytes;
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "arenax.h"
 #include "dynbuf.h"
 
 
@@ -50,4 +51,9 @@ bool as_nsup_handle_clock_skew(struct as_namespace_s* ns, uint64_t skew_ms);
 
 void as_nsup_eviction_reset_cmd(const char* ns_name, const char* ttl_str, cf_dyn_buf* db);
 
+void as_cold_start_evict_init(struct as_namespace_s* ns, uint32_t now);
+void as_cold_start_evict_hist_update(struct as_namespace_s* ns, uint32_t old_void_time, uint32_t new_void_time);
 bool as_cold_start_evict_if_needed(struct as_namespace_s* ns);
+void as_cold_start_evict_done(struct as_namespace_s* ns);
+
+void as_nsup_expire_index_add(struct as_namespace_s* ns, uint32_t pid, cf_arenax_handle r_h, uint32_t void_time);
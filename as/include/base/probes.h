@@ -0,0 +1,75 @@
+/*
+ * probes.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * USDT probes of provider "asd" - see probes.d for the list. Built with
+ * USE_USDT=1 each probe is a single nop plus an ELF note, usable from
+ * bpftrace or SystemTap, e.g. usdt:/usr/bin/asd:asd:trans__response. Without
+ * it the macros are empty and arguments are not evaluated.
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+#include "citrusleaf/cf_digest.h"
+
+#ifdef USE_USDT
+#include <sys/sdt.h>
+#endif
+
+
+//==========================================================
+// Public API.
+//
+
+#ifdef USE_USDT
+
+#define ASD_PROBE1(name, a1) \
+	DTRACE_PROBE1(asd, name, a1)
+#define ASD_PROBE2(name, a1, a2) \
+	DTRACE_PROBE2(asd, name, a1, a2)
+#define ASD_PROBE3(name, a1, a2, a3) \
+	DTRACE_PROBE3(asd, name, a1, a2, a3)
+#define ASD_PROBE4(name, a1, a2, a3, a4) \
+	DTRACE_PROBE4(asd, name, a1, a2, a3, a4)
+
+#else
+
+#define ASD_PROBE1(name, a1)
+#define ASD_PROBE2(name, a1, a2)
+#define ASD_PROBE3(name, a1, a2, a3)
+#define ASD_PROBE4(name, a1, a2, a3, a4)
+
+#endif
+
+// Correlates a transaction's probes - the digest bytes partition ids aren't
+// taken from, so they're well spread.
+static inline uint64_t
+as_probe_keyd(const cf_digest* keyd)
+{
+	return *(const uint64_t*)&keyd->digest[CF_DIGEST_KEY_SZ - sizeof(uint64_t)];
+}
@@ -195,7 +195,7 @@ typedef struct as_msg_s {
 	uint8_t info1;
 	uint8_t info2;
 	uint8_t info3;
-	uint8_t unused;
+	uint8_t info4;
 	uint8_t result_code;
 	uint32_t generation;
 	uint32_t record_ttl;
@@ -241,6 +241,9 @@ typedef struct cl_msg_s {
 #define AS_MSG_INFO3_SC_READ_TYPE           (1 << 6) // (enterprise only)
 #define AS_MSG_INFO3_SC_READ_RELAX          (1 << 7) // (enterprise only)
 
+// Bits in info4 - responses only.
+#define AS_MSG_INFO4_PARTITION_MAP_STALE    (1 << 0) // transaction was proxied - client should refresh its partition map
+
 // Interpret SC_READ bits in info3.
 //
 // RELAX   TYPE
@@ -281,11 +284,14 @@ typedef struct as_msg_field_s {
 #define AS_MSG_FIELD_TYPE_SAMPLE_MAX        13
 #define AS_MSG_FIELD_TYPE_LUT               14 // for XDR writes only
 #define AS_MSG_FIELD_TYPE_BVAL_ARRAY        15
+#define AS_MSG_FIELD_TYPE_TOP_K             16
+#define AS_MSG_FIELD_TYPE_RAW_FLAT          17 // no value - flag only
 
 // Secondary index.
 #define AS_MSG_FIELD_TYPE_INDEX_NAME        21 // was superfluous - but reserved for future use
 #define AS_MSG_FIELD_TYPE_INDEX_RANGE       22
 #define AS_MSG_FIELD_TYPE_INDEX_CONTEXT     23
+#define AS_MSG_FIELD_TYPE_INDEX_EXPRESSION  24
 #define AS_MSG_FIELD_TYPE_INDEX_TYPE        26
 
 // UDF.
@@ -323,6 +329,12 @@ typedef struct as_msg_field_s {
 #define AS_MSG_FIELD_BIT_BATCH              (1 << 19)
 #define AS_MSG_FIELD_BIT_BATCH_WITH_SET     (1 << 20)
 #define AS_MSG_FIELD_BIT_PREDEXP            (1 << 21)
+#define AS_MSG_FIELD_BIT_TOP_K              (1 << 22)
+#define AS_MSG_FIELD_BIT_RAW_FLAT           (1 << 23)
+
+// Raw flat records travel as a single blob op with this name - storage
+// version 3 flat format, bins still compressed as stored.
+#define AS_MSG_RAW_FLAT_FORMAT "flat-3"
 
 //------------------------------------------------
 // as_msg_op.
@@ -680,6 +692,8 @@ cl_msg* as_msg_make_response_msg(uint32_t result_code, uint32_t generation,
 int32_t as_msg_make_response_bufbuilder(cf_buf_builder** bb_r,
 		struct as_storage_rd_s* rd, bool no_bin_data,
 		const cf_vector* select_bins, bool send_bval, int64_t bval);
+void as_msg_make_raw_flat_response_bufbuilder(cf_buf_builder** bb_r,
+		const struct as_storage_rd_s* rd, bool send_bval, int64_t bval);
 void as_msg_pid_done_bufbuilder(cf_buf_builder** bb_r, uint32_t pid,
 		int result);
 void as_msg_fin_bufbuilder(cf_buf_builder** bb_r, int result);
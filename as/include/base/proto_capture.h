@@ -0,0 +1,89 @@
+/*
+ * proto_capture.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+#include "base/cfg.h"
+#include "base/proto.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Layout of <work-directory>/proto.capture - a header, then records, each
+// followed by the captured proto (header in network byte order) exactly as a
+// client would send it. Read by tools/bin/asd-replay.
+
+#define AS_PROTO_CAPTURE_MAGIC 0x31504143444e5341UL // "ASNDCAP1"
+#define AS_PROTO_CAPTURE_VERSION 1
+
+#define AS_PROTO_CAPTURE_FLAG_REDACTED 0x1
+
+typedef struct as_proto_capture_hdr_s {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t flags;
+	uint64_t start_epoch_ns; // wall clock of first record
+} __attribute__((__packed__)) as_proto_capture_hdr;
+
+typedef struct as_proto_capture_rec_s {
+	uint64_t offset_ns; // since first record
+	uint32_t conn_id; // same for protos from the same client connection
+	uint32_t sz; // of proto that follows, including its header
+} __attribute__((__packed__)) as_proto_capture_rec;
+
+
+//==========================================================
+// Globals.
+//
+
+extern __thread uint32_t g_proto_capture_counter;
+
+
+//==========================================================
+// Public API.
+//
+
+void as_proto_capture_init(void);
+
+// Not called directly - called by inline wrapper below.
+void proto_capture_add(const as_proto* proto, uint64_t start_ns, const void* conn);
+
+// Proto header must already be in host byte order.
+static inline void
+as_proto_capture_sample(const as_proto* proto, uint64_t start_ns,
+		const void* conn)
+{
+	uint32_t period = g_config.proto_capture_sample_period;
+
+	if (period != 0 && ++g_proto_capture_counter >= period) {
+		g_proto_capture_counter = 0;
+		proto_capture_add(proto, start_ns, conn);
+	}
+}
@@ -60,6 +60,8 @@ typedef struct as_service_access_s {
 } as_service_access;
 
 #define MAX_SERVICE_THREADS 4096
+#define MAX_TLS_HANDSHAKE_THREADS 64
+#define MAX_NS_SERVICE_THREADS 256
 #define MIN_PROTO_FD_MAX 1024
 #define MAX_PROTO_FD_MAX (2 * 1024 * 1024)
 
@@ -83,6 +85,7 @@ void as_service_set_threads(uint32_t n_threads);
 bool as_service_set_proto_fd_max(uint32_t val);
 void as_service_rearm(struct as_file_handle_s* fd_h);
 void as_service_enqueue_internal_raw(struct as_transaction_s* tr, const cf_digest* d, uint32_t max_threads, bool use_pid);
+void as_service_enqueue_background_batch(struct as_transaction_s* trs, uint32_t n_trs);
 
 static inline void
 as_service_enqueue_internal(struct as_transaction_s* tr)
@@ -0,0 +1,85 @@
+/*
+ * set_hist.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dynbuf.h"
+#include "hist.h"
+
+#include "base/datamodel.h"
+#include "base/transaction.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+typedef enum {
+	AS_SET_HIST_READ,
+	AS_SET_HIST_WRITE,
+	AS_SET_HIST_UDF,
+	AS_SET_HIST_BATCH_SUB,
+
+	AS_SET_HIST_N_TYPES
+} as_set_hist_type;
+
+#define AS_SET_HIST_N_SHARDS 8 // must be power of 2
+
+// One cache line per shard - 4 types x (ops + errors) x 8 bytes.
+typedef struct as_set_hist_counts_s {
+	uint64_t n_ops[AS_SET_HIST_N_TYPES];
+	uint64_t n_errors[AS_SET_HIST_N_TYPES];
+} as_set_hist_counts;
+
+typedef struct as_set_hist_s {
+	histogram* hists[AS_SET_HIST_N_TYPES];
+	as_set_hist_counts counts[AS_SET_HIST_N_SHARDS];
+} as_set_hist;
+
+
+//==========================================================
+// Public API.
+//
+
+void as_set_hist_enable(as_namespace* ns, as_set* p_set);
+void as_set_hist_disable(as_set* p_set);
+void as_set_hist_append_stats(const as_set* p_set, cf_dyn_buf* db);
+void as_set_hist_get_latencies(as_namespace* ns, bool percentiles, cf_dyn_buf* db);
+void as_set_hist_dump(as_namespace* ns);
+
+// Not called directly - called by inline wrapper below.
+void set_hist_insert(const as_transaction* tr, as_set_hist_type type);
+
+static inline void
+as_set_hist_insert(const as_transaction* tr, as_set_hist_type type)
+{
+	if (tr->rsv.ns->set_hist_active && tr->set_id != INVALID_SET_ID) {
+		set_hist_insert(tr, type);
+	}
+}
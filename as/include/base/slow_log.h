@@ -0,0 +1,88 @@
+/*
+ * slow_log.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+#include "citrusleaf/cf_clock.h"
+
+#include "dynbuf.h"
+
+#include "base/cfg.h"
+#include "base/transaction.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+typedef enum {
+	AS_SLOW_LOG_READ,
+	AS_SLOW_LOG_WRITE,
+	AS_SLOW_LOG_UDF,
+	AS_SLOW_LOG_BATCH_SUB,
+
+	AS_SLOW_LOG_N_TYPES
+} as_slow_log_type;
+
+#define MAX_SLOW_LOG_SIZE 1024
+
+
+//==========================================================
+// Public API.
+//
+
+void as_slow_log_get(cf_dyn_buf* db);
+
+// Not called directly - called by inline wrapper below.
+void slow_log_insert(const as_transaction* tr, as_slow_log_type type);
+
+static inline void
+as_slow_log_insert(const as_transaction* tr, as_slow_log_type type)
+{
+	if (g_config.slow_transaction_log_size != 0) {
+		slow_log_insert(tr, type);
+	}
+}
+
+// Stage marks are only taken while the log is on - a zero mark means the
+// transaction started before it was switched on.
+static inline void
+as_slow_log_mark_dispatch(as_transaction* tr)
+{
+	if (g_config.slow_transaction_log_size != 0) {
+		tr->dispatch_time = cf_getns();
+	}
+}
+
+static inline void
+as_slow_log_mark_master_done(as_transaction* tr)
+{
+	if (tr->dispatch_time != 0) {
+		tr->master_done_time = cf_getns();
+	}
+}
@@ -57,10 +57,15 @@ typedef struct as_stats_s {
 
 	// Demarshal stats.
 	uint64_t		reaper_count; // not in ticker - incremented only in reaper thread
+	uint64_t		rebalance_count; // not in ticker - incremented only in reaper thread
 
 	// Info stats.
 	cf_atomic64		info_complete;
 
+	// Proto capture stats.
+	cf_atomic64		proto_capture_records;
+	cf_atomic64		proto_capture_dropped;
+
 	// Early transaction errors.
 	cf_atomic64		n_demarshal_error;
 	cf_atomic64		n_tsvc_client_error;
@@ -0,0 +1,96 @@
+/*
+ * stats_snapshot.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+#include "dynbuf.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Layout of <work-directory>/stats.snapshot - a header page followed by two
+// slots. The ticker thread fills the slot not currently published, then bumps
+// seq. A reader loads seq, copies slot (seq & 1), and accepts the copy only if
+// seq is unchanged afterwards. A seq of 0 means nothing is published yet.
+
+#define AS_STATS_SNAPSHOT_MAGIC 0x53534153 // "SASS" in memory order
+#define AS_STATS_SNAPSHOT_VERSION 1
+
+#define AS_STATS_SNAPSHOT_HDR_SZ 4096
+#define AS_STATS_SNAPSHOT_SLOT_SZ (1024 * 1024)
+
+typedef struct as_stats_snapshot_hdr_s {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_offset; // of slot 0 - slot 1 follows directly
+	uint32_t slot_sz;
+	uint64_t seq;
+} as_stats_snapshot_hdr;
+
+#define AS_STATS_SNAPSHOT_TRUNCATED 0x1
+
+typedef struct as_stats_snapshot_slot_s {
+	uint64_t seq; // matches header seq when this slot was published
+	uint64_t clepoch_ms; // publish time, milliseconds since citrusleaf epoch
+	uint32_t n_entries;
+	uint32_t used_sz; // including this struct
+	uint32_t flags;
+	uint32_t unused;
+	uint8_t entries[]; // of as_stats_snapshot_entry, 8-byte aligned
+} as_stats_snapshot_slot;
+
+typedef enum {
+	AS_STATS_SNAPSHOT_UINT64,
+	AS_STATS_SNAPSHOT_INT64,
+	AS_STATS_SNAPSHOT_DOUBLE,
+	AS_STATS_SNAPSHOT_BOOL
+} as_stats_snapshot_type;
+
+// Names are "statistics/<stat>" or "namespace/<ns>/<stat>".
+typedef struct as_stats_snapshot_entry_s {
+	union {
+		uint64_t u64;
+		int64_t i64;
+		double d;
+	} value;
+	uint8_t type; // as_stats_snapshot_type
+	uint8_t name_len; // excluding null-terminator
+	uint16_t entry_sz; // including padding - next entry is this far along
+	char name[]; // null-terminated
+} as_stats_snapshot_entry;
+
+
+//==========================================================
+// Public API.
+//
+
+void as_stats_snapshot_init(void);
+void as_stats_snapshot_update(uint64_t now_ns);
+void as_stats_snapshot_get(cf_dyn_buf* db);
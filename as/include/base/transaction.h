@@ -131,6 +131,10 @@ typedef struct as_file_handle_s {
 	bool		move_me;		// redistribute to another service thread
 	bool		reap_me;		// force reaping (overrides in_transaction)
 	bool		is_xdr;			// XDR client connection
+	uint32_t	move_sid;		// service thread to move to, if chosen by reaper
+	struct as_namespace_s *group_ns; // owner of service thread group serving us, NULL if shared
+	uint32_t	n_reqs;			// requests started - for load rebalancing
+	uint32_t	n_reqs_seen;	// reaper's last snapshot of n_reqs
 	as_proto	proto_hdr;		// space for header when reading it from socket
 	as_proto	*proto;			// complete request message
 	uint64_t	proto_unread;	// bytes not yet read from socket
@@ -228,6 +232,9 @@ typedef struct as_transaction_s {
 	uint16_t	generation;
 	uint32_t	void_time;
 	uint64_t	last_update_time;
+	uint16_t	set_id; // of record once found - for per-set histograms
+	uint64_t	dispatch_time; // for slow transaction log - 0 if off
+	uint64_t	master_done_time; // for slow transaction log - 0 if off
 
 } as_transaction;
 
@@ -382,6 +389,18 @@ as_transaction_has_predexp(const as_transaction *tr)
 	return (tr->msg_fields & AS_MSG_FIELD_BIT_PREDEXP) != 0;
 }
 
+static inline bool
+as_transaction_has_top_k(const as_transaction *tr)
+{
+	return (tr->msg_fields & AS_MSG_FIELD_BIT_TOP_K) != 0;
+}
+
+static inline bool
+as_transaction_has_raw_flat(const as_transaction *tr)
+{
+	return (tr->msg_fields & AS_MSG_FIELD_BIT_RAW_FLAT) != 0;
+}
+
 // For now it's not worth storing the trid in the as_transaction struct since we
 // only parse it from the msg once per transaction anyway.
 static inline uint64_t
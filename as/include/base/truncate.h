@@ -61,7 +61,7 @@ typedef struct as_truncate_s {
 	truncate_state state;
 	cf_mutex state_lock;
 	uint32_t n_threads_running;
-	uint32_t pid;
+	uint32_t item; // next tree slice to reduce
 	uint64_t n_records_this_run;
 	uint64_t n_records;
 } as_truncate;
@@ -107,6 +107,13 @@ int udf_record_open(udf_record* urecord);
 void udf_record_close(udf_record* urecord);
 int udf_record_load(udf_record* urecord);
 
+// Scalar bin access without as_val boxing - plain C ABI for LuaJIT FFI.
+int udf_record_get_integer(const as_rec* rec, const char* name, int64_t* value);
+int udf_record_get_float(const as_rec* rec, const char* name, double* value);
+int udf_record_get_bytes(const as_rec* rec, const char* name, const uint8_t** buf, uint32_t* sz);
+int udf_record_set_integer(const as_rec* rec, const char* name, int64_t value);
+int udf_record_set_float(const as_rec* rec, const char* name, double value);
+
 
 //==========================================================
 // Public API - rec hooks.
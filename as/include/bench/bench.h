@@ -0,0 +1,62 @@
+/*
+ * bench.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Does n_ops operations - called once per round, so must leave state such that
+// the next round does the same work.
+typedef void (*as_bench_fn)(void* udata, uint32_t n_ops);
+
+
+//==========================================================
+// Public API.
+//
+
+void as_bench_run(const char* name, as_bench_fn fn, void* udata, uint32_t n_ops);
+
+// For benchmarks that time and report themselves.
+bool as_bench_selected(const char* name);
+uint32_t as_bench_msg_sizes(const uint32_t** sizes);
+uint32_t as_bench_channel_counts(const uint32_t** counts);
+
+// Benchmark groups - one per source file.
+void as_bench_cdt(void);
+void as_bench_exp(void);
+void as_bench_fabric(void);
+void as_bench_flat(void);
+void as_bench_hash(void);
+void as_bench_hll(void);
+void as_bench_index(void);
+void as_bench_msg(void);
+void as_bench_msgpack(void);
@@ -30,6 +30,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "dynbuf.h"
 #include "log.h"
 #include "vector.h"
 
@@ -276,6 +277,12 @@ as_clustering_cf_node_array_event(severity, context, __FILENAME__,			\
 bool
 as_clustering_has_integrity();
 
+/**
+ * Append phase durations of the last cluster change to an info buffer.
+ */
+void
+as_clustering_info_phase_times(cf_dyn_buf* db);
+
 /**
  * Indicates if self node is orphaned.
  */
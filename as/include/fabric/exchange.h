@@ -51,8 +51,10 @@
  *  9 - 5.4.0.3 - for (stripping) bin src-id or bin metadata and tombstones.
  * 10 - 5.5.0 - for converting bin cemeteries to regular tombstones.
  * 11 - 6.0.0 - for AER-6487 (revived nodes) & AER-6513 (storage end mark).
+ * 12 - for sparse HLL particles.
+ * 13 - for exchanging partition version deltas.
  */
-#define AS_EXCHANGE_COMPATIBILITY_ID 11
+#define AS_EXCHANGE_COMPATIBILITY_ID 13
 
 /**
  * Number of quantum intervals in orphan state after which client transactions
@@ -185,6 +187,11 @@ as_exchange_max_compatibility_id(void);
  */
 void as_exchange_cluster_info(cf_dyn_buf* db);
 
+/**
+ * Output exchange and balance durations of the last cluster change for info.
+ */
+void as_exchange_info_phase_times(cf_dyn_buf* db);
+
 /**
  * Lock before setting or getting exchanged info from non-exchange thread.
  */
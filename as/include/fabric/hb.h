@@ -192,7 +192,30 @@ typedef enum
 	/**
 	 * Local physical clock monotonic timestamp for when the message was sent.
 	 */
-	AS_HB_MSG_SKEW_MONITOR_DATA
+	AS_HB_MSG_SKEW_MONITOR_DATA,
+
+	/**
+	 * Order independent digest of the sender's full adjacency list. Its
+	 * presence also advertises that the sender understands adjacency deltas.
+	 */
+	AS_HB_MSG_ADJ_DIGEST,
+
+	/**
+	 * Nodes added to the adjacency list since the previous pulse, sent instead
+	 * of AS_HB_MSG_HB_DATA.
+	 */
+	AS_HB_MSG_ADJ_ADDED,
+
+	/**
+	 * Nodes removed from the adjacency list since the previous pulse.
+	 */
+	AS_HB_MSG_ADJ_REMOVED,
+
+	/**
+	 * Nodes whose deltas did not match their digest and should send their full
+	 * adjacency list in their next pulse.
+	 */
+	AS_HB_MSG_ADJ_FULL_REQUEST
 } as_hb_msg_fields;
 
 /**
@@ -73,6 +73,9 @@ struct pb_task_s;
 #define TX_FLAGS_LEAD           ((uint32_t) 0x2)
 #define TX_FLAGS_CONTINGENT     ((uint32_t) 0x4)
 
+// Digest ranges per partition compared by delta migration.
+#define MIG_N_RANGES 256
+
 
 //==========================================================
 // Public API.
@@ -120,6 +123,9 @@ typedef enum {
 	MIG_FIELD_UNUSED_27,
 	MIG_FIELD_UNUSED_28,
 	MIG_FIELD_EMIG_INSERT_ID,
+	MIG_FIELD_RECORD_ORIG_SZ, // if set, MIG_FIELD_RECORD is zlib compressed
+	MIG_FIELD_RECORD_COUNT, // if set, MIG_FIELD_RECORD is a batch of records
+	MIG_FIELD_RANGE_SUMMARY, // immigrator's per-digest-range fingerprints
 
 	NUM_MIG_FIELDS
 } migrate_msg_fields;
@@ -139,12 +145,17 @@ typedef enum {
 #define OPERATION_MERGE_META_ACK 12
 #define OPERATION_ALL_DONE 13
 #define OPERATION_ALL_DONE_ACK 14
+#define OPERATION_INSERT_OVERLOADED 15
 
 #define MIG_INFO_UNUSED_1       0x0001
 #define MIG_INFO_UNUSED_2       0x0002
 #define MIG_INFO_UNREPLICATED   0x0004 // enterprise only
 
 #define MIG_FEATURE_MERGE 0x00000001U
+#define MIG_FEATURE_COMPRESS 0x00000002U
+#define MIG_FEATURE_BATCH 0x00000004U
+#define MIG_FEATURE_DELTA 0x00000008U
+#define MIG_FEATURE_OVERLOAD_SIGNAL 0x00000010U
 #define MIG_FEATURES_SEEN 0x80000000U // needed for backward compatibility
 extern const uint32_t MY_MIG_FEATURES;
 
@@ -156,9 +167,16 @@ typedef struct emigration_s {
 	uint32_t    tx_flags;
 	cf_atomic32 state;
 	bool        from_replica;
+	uint32_t    dest_features; // features acked by destination
+	struct emigration_batch_s *batch; // NULL if destination can't take batches
+	uint64_t    *dest_range_sums; // NULL unless destination sent a summary
+	uint64_t    skip_ranges[MIG_N_RANGES / 64]; // bit set if range matches
 	uint64_t    wait_until_ms;
 
 	cf_atomic32 bytes_emigrating;
+	cf_atomic32 window; // limit on bytes_emigrating - adapted AIMD-style
+	uint64_t    min_ack_us; // lowest insert ack latency seen
+	uint64_t    backoff_until_ms; // don't shrink window again before this
 	cf_shash    *reinsert_hash;
 	uint64_t    insert_id;
 	cf_queue    *ctrl_q;
@@ -181,6 +199,7 @@ typedef struct immigration_s {
 
 	as_migrate_result start_result;
 	uint32_t        features;
+	uint64_t        *range_sums; // sent in start ack - NULL if not delta
 	struct as_namespace_s *ns; // for statistics only
 
 	as_partition_reservation rsv;
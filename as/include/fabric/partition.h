@@ -99,10 +99,13 @@ typedef struct as_partition_s {
 	uint32_t n_replicas;
 	uint32_t n_dupl;
 
-	// @ 48 bytes - room for 2 replicas within above 64-byte cache line.
+	cf_atomic32 seq; // odd while a writer holds lock - see as_partition_lock()
+	uint8_t align_0[4];
+
+	// @ 56 bytes - room for 1 replica within above 64-byte cache line.
 	cf_node replicas[AS_CLUSTER_SZ];
 
-	uint8_t align_1[16];
+	uint8_t align_1[8];
 	// @ 64-byte-aligned boundary.
 
 	//--------------------------------------------
@@ -128,7 +131,11 @@ typedef struct as_partition_s {
 	// @ 40 bytes - room for 3 duplicates within above 64-byte cache line.
 	cf_node dupls[AS_CLUSTER_SZ];
 
-	uint8_t align_2[24];
+	// Proxies and duplicate resolutions since the last rebalance - hot
+	// partitions migrate first.
+	cf_atomic32 n_unmigrated_hits;
+
+	uint8_t align_2[20];
 	// @ 64-byte-aligned boundary.
 
 	bool immigrators[AS_CLUSTER_SZ];
@@ -201,12 +208,15 @@ uint32_t as_partition_get_other_replicas(as_partition* p, cf_node* nv);
 
 cf_node as_partition_writable_node(struct as_namespace_s* ns, uint32_t pid);
 cf_node as_partition_proxyee_redirect(struct as_namespace_s* ns, uint32_t pid);
+cf_node as_partition_steer_read_node(struct as_namespace_s* ns, uint32_t pid);
 
 void as_partition_get_replicas_master_str(cf_dyn_buf* db);
 void as_partition_get_replicas_all_str(cf_dyn_buf* db, bool include_regime, uint32_t max_repls);
 
 void as_partition_get_replica_stats(struct as_namespace_s* ns, repl_stats* p_stats);
 
+void as_partition_wait_for_readers(void);
+
 void as_partition_reserve(struct as_namespace_s* ns, uint32_t pid, as_partition_reservation* rsv);
 int as_partition_reserve_replica(struct as_namespace_s* ns, uint32_t pid, as_partition_reservation* rsv);
 int as_partition_reserve_write(struct as_namespace_s* ns, uint32_t pid, as_partition_reservation* rsv, cf_node* node);
@@ -273,6 +283,22 @@ as_partition_version_same(const as_partition_version* v1, const as_partition_ver
 	return *(uint64_t*)v1 == *(uint64_t*)v2;
 }
 
+// Anything changing partition state must lock via these, so that lock-free
+// reservations (see as_partition_reserve_write()) notice and retry.
+static inline void
+as_partition_lock(as_partition* p)
+{
+	cf_mutex_lock(&p->lock);
+	cf_atomic32_incr(&p->seq);
+}
+
+static inline void
+as_partition_unlock(as_partition* p)
+{
+	cf_atomic32_incr(&p->seq);
+	cf_mutex_unlock(&p->lock);
+}
+
 static inline uint32_t
 as_partition_getid(const cf_digest* d)
 {
@@ -46,6 +46,13 @@ extern bool geo_region_cover(const as_namespace * ns,
 							 uint64_t * cellmaxp,
 							 uint32_t * numcellsp);
 
+extern bool geo_region_interior(const as_namespace * ns,
+								geo_region_t region,
+								uint32_t maxnumcells,
+								uint64_t * cellminp,
+								uint64_t * cellmaxp,
+								uint32_t * numcellsp);
+
 extern bool geo_point_centers(uint64_t cellidval,
 							  uint32_t maxnumcenters,
 							  uint64_t * center,
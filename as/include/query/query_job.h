@@ -55,6 +55,9 @@ struct as_transaction_s;
 #define AS_QUERY_RESPONSE_ERROR   (-1)
 #define AS_QUERY_RESPONSE_TIMEOUT (-2)
 
+// Integer ranges on other indexed bins, ANDed with the query's range.
+#define AS_QUERY_MAX_AND_RANGES 3
+
 typedef struct as_query_range_start_end_s {
 	int64_t start;
 	int64_t end;  // -1 means infinity
@@ -65,6 +68,8 @@ typedef struct as_query_geo_range_s {
 	geo_region_t region;  // target of points-in-region query
 	as_query_range_start_end* r;
 	uint8_t num_r;
+	uint8_t num_interior;
+	as_query_range_start_end* interior;  // sorted cells inside region, or NULL
 } as_query_geo_range;
 
 typedef struct as_query_range_s {
@@ -76,6 +81,10 @@ typedef struct as_query_range_s {
 	uint32_t str_len;
 	char str_stub[16];
 
+	bool str_ordered; // sindex-ordered-strings - range of full strings
+	uint32_t str_end_len;
+	char* str_buf; // start string followed by end string
+
 	uint16_t bin_id;
 	as_particle_type bin_type;
 	as_sindex_type itype;
@@ -84,6 +93,8 @@ typedef struct as_query_range_s {
 	char bin_name[AS_BIN_NAME_MAX_SZ];
 	uint8_t* ctx_buf;
 	uint32_t ctx_buf_sz;
+	uint8_t* exp_buf;
+	uint32_t exp_buf_sz;
 } as_query_range;
 
 typedef void (*as_query_slice_fn)(struct as_query_job_s* _job, struct as_partition_reservation_s* rsv, cf_buf_builder** bb_r);
@@ -116,6 +127,9 @@ typedef struct as_query_job_s {
 	struct as_namespace_s* ns;
 	struct as_sindex_s* si;
 	struct as_query_range_s* range;
+	struct as_sindex_s* and_sis[AS_QUERY_MAX_AND_RANGES];
+	struct as_query_range_s* and_ranges[AS_QUERY_MAX_AND_RANGES];
+	uint32_t n_and_ranges;
 	char si_name[INAME_MAX_SZ];
 	char set_name[AS_SET_NAME_MAX_SIZE];
 	uint16_t set_id;
@@ -129,11 +143,15 @@ typedef struct as_query_job_s {
 	// Handle active phase:
 	uint32_t n_threads;
 	uint32_t pid;
+	uint16_t* pid_order; // long jobs - biggest partitions first
 	uint64_t start_ms_clepoch;
 	volatile int abandoned;
 
 	// For throttling:
 	uint32_t rps;
+	uint32_t weight; // share of global query-max-rps budget, relative
+	uint32_t fair_rps; // rps allowed within global budget
+	uint32_t throttle_rps; // rps last throttled at
 	bool started;
 	pid_t base_sys_tid;
 	uint64_t base_us;
@@ -151,6 +169,7 @@ typedef struct as_query_job_s {
 	uint64_t n_throttled;
 	uint64_t n_filtered_meta;
 	uint64_t n_filtered_bins;
+	uint64_t n_filtered_and; // skipped by index intersection, never read
 	uint64_t n_succeeded;
 	uint64_t n_failed;
 } as_query_job;
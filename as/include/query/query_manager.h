@@ -46,10 +46,15 @@ struct as_query_job_s;
 // Typedefs & constants.
 //
 
+// Relative shares of the global query-max-rps budget.
+#define QUERY_WEIGHT_FOREGROUND 4
+#define QUERY_WEIGHT_BACKGROUND 1
+
 typedef struct as_query_manager_s {
 	cf_mutex lock;
 	cf_queue* active_jobs;
 	cf_queue* finished_jobs;
+	uint32_t fair_max_rps; // query-max-rps the fair shares were assigned for
 } as_query_manager;
 
 
@@ -76,3 +81,4 @@ void as_query_manager_limit_finished_jobs(void);
 struct as_mon_jobstat_s* as_query_manager_get_job_info(uint64_t trid);
 struct as_mon_jobstat_s* as_query_manager_get_info(int* size);
 uint32_t as_query_manager_get_active_job_count(void);
+uint32_t as_query_manager_job_rps(struct as_query_job_s* _job);
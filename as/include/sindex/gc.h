@@ -22,6 +22,13 @@
 
 #pragma once
 
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+
 //==========================================================
 // Forward declarations.
 //
@@ -41,3 +48,6 @@ void* as_sindex_run_gc(void* udata);
 void as_sindex_gc_record(struct as_namespace_s* ns, struct as_index_ref_s* r_ref);
 void as_sindex_gc_record_throttle(struct as_namespace_s* ns);
 void as_sindex_gc_tree(struct as_namespace_s* ns, struct as_index_tree_s* tree);
+
+uint32_t as_sindex_gc_hold(struct as_namespace_s* ns);
+void as_sindex_gc_release_hold(struct as_namespace_s* ns, uint32_t epoch);
@@ -30,7 +30,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
+#include "citrusleaf/cf_byte_order.h"
 #include "citrusleaf/cf_hash_math.h"
 
 #include "arenax.h"
@@ -45,8 +47,11 @@
 // Forward declarations.
 //
 
+struct as_exp_s;
 struct as_index_ref_s;
 struct as_namespace_s;
+struct as_sindex_bulk_s;
+struct as_sindex_count_filter_s;
 struct as_storage_rd_s;
 struct si_btree_s;
 
@@ -65,6 +70,7 @@ struct si_btree_s;
 #define INDEXTYPE_MAX_SZ 10 // (default/list/mapkeys/mapvalues)
 #define INDEXDATA_MAX_SZ (AS_BIN_NAME_MAX_SZ + 11 + 1) // bin-name,key-type (string/numeric/geo2dsphere)
 #define CTX_B64_MAX_SZ 2048
+#define EXP_B64_MAX_SZ 2048 // sindex has context or expression, not both
 #define SINDEX_SMD_KEY_MAX_SZ (AS_ID_NAMESPACE_SZ + AS_SET_NAME_MAX_SIZE + AS_BIN_NAME_MAX_SZ + 2 + 2 + CTX_B64_MAX_SZ)
 
 typedef enum {
@@ -81,6 +87,8 @@ typedef enum {
 	AS_SINDEX_N_ITYPES        = 4
 } as_sindex_type;
 
+#define SINDEX_HIST_N_BUCKETS 64
+
 typedef struct as_sindex_s {
 	struct as_namespace_s* ns;
 	char iname[INAME_MAX_SZ];
@@ -98,6 +106,12 @@ typedef struct as_sindex_s {
 	uint8_t* ctx_buf;
 	uint32_t ctx_buf_sz;
 
+	// Expression over the bin - its value is indexed instead of the bin's.
+	char* exp_b64;
+	uint8_t* exp_buf;
+	uint32_t exp_buf_sz;
+	struct as_exp_s* exp; // built from exp_buf
+
 	uint32_t id;
 
 	bool readable; // false while building sindex
@@ -105,6 +119,9 @@ typedef struct as_sindex_s {
 
 	uint64_t keys_per_bval;
 	uint64_t keys_per_rec;
+	// Equi-depth bval histogram - bucket i spans hist_bounds[i .. i + 1].
+	bool has_hist;
+	int64_t hist_bounds[SINDEX_HIST_N_BUCKETS + 1];
 	uint64_t load_time;
 	uint32_t populate_pct;
 	uint64_t n_gc_cleaned;
@@ -143,6 +160,7 @@ void as_sindex_release_arr(as_sindex* si_arr[], uint32_t si_arr_sz);
 // Populate sindexes.
 void as_sindex_put_all_rd(struct as_namespace_s* ns, struct as_storage_rd_s* rd, struct as_index_ref_s* r_ref);
 void as_sindex_put_rd(as_sindex* si, struct as_storage_rd_s* rd, struct as_index_ref_s* r_ref);
+void as_sindex_bulk_put_rd(struct as_sindex_bulk_s* bulk, struct as_storage_rd_s* rd, struct as_index_ref_s* r_ref);
 
 // Modify sindexes from writes/deletes.
 uint32_t as_sindex_arr_lookup_by_set_and_bin_lockfree(const struct as_namespace_s* ns, uint16_t set_id, uint16_t bin_id, as_sindex** si_arr);
@@ -151,7 +169,8 @@ void as_sindex_update_by_sbin(as_sindex_bin* start_sbin, uint32_t n_sbins, cf_ar
 void as_sindex_sbin_free_all(as_sindex_bin* sbin, uint32_t n_sbins);
 
 // Query.
-as_sindex* as_sindex_lookup_by_defn(const struct as_namespace_s* ns, uint16_t set_id, uint16_t bin_id, as_particle_type ktype, as_sindex_type itype, const uint8_t* ctx_buf, uint32_t ctx_buf_sz);
+as_sindex* as_sindex_lookup_by_defn(const struct as_namespace_s* ns, uint16_t set_id, uint16_t bin_id, as_particle_type ktype, as_sindex_type itype, const uint8_t* ctx_buf, uint32_t ctx_buf_sz, const uint8_t* exp_buf, uint32_t exp_buf_sz);
+bool as_sindex_exp_eval(const as_sindex* si, const as_bin* b, as_bin* rb);
 
 // GC.
 as_sindex* as_sindex_lookup_by_iname_lockfree(const struct as_namespace_s* ns, const char* iname);
@@ -161,9 +180,13 @@ as_particle_type as_sindex_ktype_from_string(const char* ktype_str);
 as_sindex_type as_sindex_itype_from_string(const char* itype_str);
 bool as_sindex_exists(const struct as_namespace_s* ns, const char* iname);
 bool as_sindex_stats_str(struct as_namespace_s* ns, char* iname, cf_dyn_buf* db);
+bool as_sindex_estimate_str(struct as_namespace_s* ns, const char* iname, int64_t start, int64_t end, cf_dyn_buf* db);
+bool as_sindex_aggregate_str(struct as_namespace_s* ns, const char* iname, bool master_only, cf_dyn_buf* db);
+bool as_sindex_count_str(struct as_namespace_s* ns, const char* iname, int64_t start, int64_t end, bool master_only, const struct as_sindex_count_filter_s* filter, cf_dyn_buf* db);
 void as_sindex_list_str(const struct as_namespace_s* ns, bool b64, cf_dyn_buf* db);
-void as_sindex_build_smd_key(const char* ns_name, const char* set_name, const char* bin_name, const char* cdt_ctx, as_sindex_type itype, as_particle_type ktype, char* smd_key);
+void as_sindex_build_smd_key(const char* ns_name, const char* set_name, const char* bin_name, const char* cdt_ctx, const char* exp, as_sindex_type itype, as_particle_type ktype, char* smd_key);
 int32_t as_sindex_cdt_ctx_b64_decode(const char* ctx_b64, uint32_t ctx_b64_len, uint8_t** buf_r);
+int32_t as_sindex_exp_b64_decode(const char* exp_b64, uint32_t exp_b64_len, const char* bin_name, uint8_t** buf_r, struct as_exp_s** exp_r);
 
 static inline uint32_t
 as_sindex_n_sindexes(const as_namespace* ns)
@@ -171,10 +194,21 @@ as_sindex_n_sindexes(const as_namespace* ns)
 	return cf_shash_get_size(ns->sindex_iname_hash);
 }
 
+// With sindex-ordered-strings, bval is the first 8 bytes read big-endian,
+// with the sign bit flipped so signed bval order is byte-wise string order.
+// Strings sharing an 8-byte prefix collide - queries re-check the full value.
 static inline int64_t
-as_sindex_string_to_bval(const char* s, size_t len)
+as_sindex_string_to_bval(const as_namespace* ns, const char* s, size_t len)
 {
-	return (int64_t)cf_wyhash64((const void*)s, len);
+	if (! ns->sindex_ordered_strings) {
+		return (int64_t)cf_wyhash64((const void*)s, len);
+	}
+
+	uint64_t v = 0;
+
+	memcpy(&v, s, len < sizeof(v) ? len : sizeof(v));
+
+	return (int64_t)(cf_swap_from_be64(v) ^ ((uint64_t)1 << 63));
 }
 
 static inline uint64_t
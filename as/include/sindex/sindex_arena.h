@@ -50,6 +50,7 @@ typedef uint32_t si_arena_handle;
 
 typedef struct as_sindex_arena_s {
 	key_t key_base; // enterprise only - to create stage (xmem) blocks
+	const char* flash_dir; // if set, stages are mapped files in this directory
 
 	// Configuration (passed in constructors).
 	uint32_t ele_sz;
@@ -85,7 +86,7 @@ typedef struct si_arena_free_ele_s {
 // Public API.
 //
 
-void as_sindex_arena_init(as_sindex_arena* arena, key_t key_base, uint32_t ele_sz, size_t stage_sz);
+void as_sindex_arena_init(as_sindex_arena* arena, key_t key_base, uint32_t ele_sz, size_t stage_sz, const char* flash_dir);
 
 si_arena_handle as_sindex_arena_alloc(as_sindex_arena* arena);
 void as_sindex_arena_free(as_sindex_arena* arena, si_arena_handle h);
@@ -46,7 +46,9 @@ struct as_partition_reservation_s;
 struct as_query_range_s;
 struct as_sindex_s;
 struct as_sindex_arena_s;
+struct si_btree_key_s;
 struct si_btree_node_s;
+struct si_bulk_key_s;
 
 
 //==========================================================
@@ -55,6 +57,32 @@ struct si_btree_node_s;
 
 typedef bool (*as_sindex_reduce_fn)(struct as_index_ref_s* value, int64_t bval, void* udata);
 
+// Entry aggregates, accumulated over partitions. Sum wraps on overflow. Min and
+// max are only meaningful if n_keys is non-zero.
+typedef struct as_sindex_tree_agg_s {
+	uint64_t n_keys;
+	int64_t sum;
+	int64_t min;
+	int64_t max;
+} as_sindex_tree_agg;
+
+// Metadata filter for counts - checked against the primary index only.
+typedef struct as_sindex_count_filter_s {
+	bool has_set;
+	uint16_t set_id;
+	uint32_t min_void_time; // 0 means no bound - never-expiring records pass
+	uint32_t max_void_time; // 0 means no bound - never-expiring records fail
+} as_sindex_count_filter;
+
+// Collects one partition's keys for a sorted bottom-up build.
+typedef struct as_sindex_bulk_s {
+	struct as_sindex_s* si;
+	uint32_t pid;
+	uint32_t n_keys;
+	uint32_t capacity;
+	struct si_bulk_key_s* keys;
+} as_sindex_bulk;
+
 // In header for enterprise separation only - not public.
 
 typedef struct si_btree_s {
@@ -71,6 +99,12 @@ typedef struct si_btree_s {
 	si_arena_handle root_h;
 	uint64_t n_nodes;
 	uint64_t n_keys;
+	uint64_t sum_bvals; // of keys - maintained with n_keys, wraps
+	uint64_t n_mods; // puts and deletes - validates cached query results
+	bool bulk_loading;
+	uint32_t n_bulk_deletes;
+	uint32_t bulk_deletes_capacity;
+	struct si_btree_key_s* bulk_deletes; // writer deletes during bulk load
 } si_btree;
 
 typedef struct si_btree_node_s {
@@ -108,14 +142,24 @@ void as_sindex_tree_destroy(struct as_sindex_s* si);
 
 uint64_t as_sindex_tree_n_keys(const struct as_sindex_s* si);
 uint64_t as_sindex_tree_mem_size(const struct as_sindex_s* si);
+uint64_t as_sindex_tree_n_mods(const struct as_sindex_s* si, uint32_t pid);
+void as_sindex_tree_aggregate(const struct as_sindex_s* si, uint32_t pid, as_sindex_tree_agg* agg);
 
-void as_sindex_tree_gc(struct as_sindex_s* si);
+void as_sindex_tree_gc(struct as_sindex_s* si, const uint16_t* pids, uint32_t n_pids);
 
 bool as_sindex_tree_put(struct as_sindex_s* si, int64_t bval, cf_arenax_handle r_h);
 bool as_sindex_tree_delete(struct as_sindex_s* si, int64_t bval, cf_arenax_handle r_h);
 void as_sindex_tree_query(struct as_sindex_s* si, const struct as_query_range_s* range, struct as_partition_reservation_s* rsv, int64_t bval, cf_digest* keyd, as_sindex_reduce_fn cb, void* udata);
 
+uint64_t as_sindex_tree_count(struct as_sindex_s* si, struct as_partition_reservation_s* rsv, int64_t start, int64_t end, const as_sindex_count_filter* filter);
+uint32_t as_sindex_tree_collect_handles(struct as_sindex_s* si, const struct as_query_range_s* range, uint32_t pid, cf_arenax_handle** handles_r);
+
 void as_sindex_tree_collect_cardinality(struct as_sindex_s* si);
+uint64_t as_sindex_tree_estimate_range(const struct as_sindex_s* si, int64_t start, int64_t end);
+
+void as_sindex_tree_bulk_start(struct as_sindex_s* si, uint32_t pid, as_sindex_bulk* bulk);
+void as_sindex_tree_bulk_add(as_sindex_bulk* bulk, int64_t bval, cf_arenax_handle r_h);
+void as_sindex_tree_bulk_finish(as_sindex_bulk* bulk, bool abort);
 
 
 //==========================================================
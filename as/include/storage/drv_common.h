@@ -30,6 +30,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "log.h"
 
@@ -192,3 +193,4 @@ bool drv_is_set_evictable(const struct as_namespace_s* ns, const struct as_flat_
 void drv_apply_opt_meta(struct as_index_s* r, struct as_namespace_s* ns, const struct as_flat_opt_meta_s* opt_meta);
 bool pread_all(int fd, void* buf, size_t size, off_t offset);
 bool pwrite_all(int fd, const void* buf, size_t size, off_t offset);
+bool pwritev_all(int fd, struct iovec* iov, int n_iov, off_t offset);
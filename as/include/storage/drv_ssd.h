@@ -28,6 +28,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -38,9 +39,11 @@
 
 #include "cf_mutex.h"
 #include "cf_thread.h"
+#include "crc32c.h"
 #include "hist.h"
 #include "log.h"
 #include "pool.h"
+#include "ring_queue.h"
 
 #include "base/datamodel.h"
 #include "fabric/partition.h"
@@ -85,12 +88,15 @@ typedef struct {
 	cf_atomic32			n_writers;	// number of concurrent writers
 	bool				dirty;		// written to since last flushed
 	bool				use_post_write_q;
+	bool				shadow_lagging;	// counted against shadow-max-lag, not write queue
 	uint32_t			n_vacated;
 	uint32_t			vacated_capacity;
 	vacated_wblock		*vacated_wblocks;
 	struct drv_ssd_s	*ssd;
 	uint32_t			wblock_id;
 	uint32_t			pos;
+	uint32_t			dirty_lo;	// lowest offset written since last group commit
+	uint64_t			write_life;	// RWH_WRITE_LIFE_* hint for this stream
 	uint8_t				*buf;
 } ssd_write_buf;
 
@@ -104,9 +110,18 @@ typedef struct ssd_wblock_state_s {
 	ssd_write_buf		*swb;		// pending writes for the wblock, also treated as a cache for reads
 	uint32_t			state;		// for now just a defrag flag
 	cf_atomic32			n_vac_dests; // number of wblocks into which this wblock defragged
+	uint32_t			n_frees;	// bumped when freed - validates batch prefetch data
+	uint32_t			write_time; // seconds - when last allocated for writing
 } ssd_wblock_state;
 
 
+// Current write buffers - SWB_MASTER etc. - are each split by TTL band, plus
+// one more stream for large records.
+#define N_STREAMS_PER_CURRENT_SWB (MAX_TTL_WRITE_STREAMS + 1)
+#define LARGE_RECORD_STREAM MAX_TTL_WRITE_STREAMS
+#define N_CURRENT_SWB_STREAMS (N_CURRENT_SWBS * N_STREAMS_PER_CURRENT_SWB)
+
+
 //------------------------------------------------
 // Per current write buffer information.
 //
@@ -128,11 +143,22 @@ typedef struct drv_ssd_s {
 
 	uint32_t		running;
 
-	current_swb		current_swbs[N_CURRENT_SWBS];
+	current_swb		current_swbs[N_CURRENT_SWB_STREAMS];
 
 	int				commit_fd;			// relevant for enterprise edition only
 	int				shadow_commit_fd;	// relevant for enterprise edition only
 
+	pthread_mutex_t	commit_lock;		// group commit - leader election
+	pthread_cond_t	commit_cond;		// group commit - followers wait here
+	uint64_t		commit_seq_started;	// last group commit begun
+	uint64_t		commit_seq_done;	// last group commit made durable
+	bool			committing;			// a group commit leader is active
+
+	cf_atomic64		n_wblocks_queued;	// total swbs pushed to swb_write_q
+	cf_atomic64		n_wblocks_flushed;	// total swbs written (and shadowed) off swb_write_q
+	cf_atomic64		n_group_commits;	// total group commits
+	cf_atomic64		n_group_commit_writes;	// total writes acknowledged by group commits
+
 	cf_mutex		defrag_lock;		// lock protects writes to defrag swb
 	ssd_write_buf	*defrag_swb;		// swb currently being filled by defrag
 
@@ -149,7 +175,7 @@ typedef struct drv_ssd_s {
 
 	cf_queue		*swb_write_q;		// pointers to swbs ready to write
 	cf_queue		*swb_shadow_q;		// pointers to swbs ready to write to shadow, if any
-	cf_queue		*swb_free_q;		// pointers to swbs free and waiting
+	cf_ring_queue	swb_free_q;			// pointers to swbs free and waiting
 	cf_queue		*post_write_q;		// pointers to swbs that have been written but are cached
 
 	uint8_t			encryption_key[64];		// relevant for enterprise edition only
@@ -160,6 +186,22 @@ typedef struct drv_ssd_s {
 	cf_atomic64		n_wblock_defrag_io_skips;	// total number of wblocks empty on defrag_wblock_q pop
 	cf_atomic64		n_wblock_direct_frees;		// total number of wblocks freed by other than defrag
 
+	cf_atomic64		n_defrag_bytes_moved;		// total bytes of live records rewritten by defrag
+	cf_atomic64		n_defrag_bytes_reclaimed;	// total bytes of dead space recovered by defrag
+	uint32_t		n_defrag_held;				// wblocks off defrag_wblock_q awaiting selection
+
+	uint32_t		read_latency_us;	// smoothed, tracked while defrag-target-read-us is set
+	uint64_t		n_timed_reads;		// reads contributing to read_latency_us
+	uint32_t		defrag_sleep_us;	// current pacing, if defrag-target-read-us is set
+
+	uint32_t		n_class_reads[AS_STORAGE_N_IO_CLASSES];	// in flight, if background-read-depth is set
+
+	cf_atomic64		n_shadow_batches;			// total shadow thread write passes
+	cf_atomic64		n_shadow_batch_wblocks;		// total swbs written by those passes
+
+	cf_atomic64		n_partial_flushes;			// total number of swbs flushed before full
+	cf_atomic64		n_partial_flush_bytes;		// total bytes used in swbs flushed before full
+
 	volatile uint64_t n_tomb_raider_reads;	// relevant for enterprise edition only
 
 	cf_atomic32		defrag_sweep;		// defrag sweep flag
@@ -167,8 +209,15 @@ typedef struct drv_ssd_s {
 	uint64_t		file_size;
 	int				file_id;
 
+	uint8_t			*dax_map;			// whole file, if dax-map - reads and wblock writes bypass fds
+
 	uint32_t		open_flag;
 
+	uint64_t		write_life;			// RWH_WRITE_LIFE_* hint last set on device
+
+	uint16_t		swb_numa_node;		// OS NUMA node for write buffers, if numa-local
+	bool			pi_protected;		// device has end-to-end protection - skip read checksums
+
 	uint64_t		io_min_size;		// device IO operations are aligned and sized in multiples of this
 	uint64_t		shadow_io_min_size;	// shadow device IO operations are aligned and sized in multiples of this
 
@@ -184,6 +233,7 @@ typedef struct drv_ssd_s {
 
 	uint32_t			n_wblocks;		// number of wblocks on this device
 	ssd_wblock_state	*wblock_state;	// array of info per wblock on this device
+	uint8_t				*si_wblock_marks;	// used only at startup - wblocks with sindexed records
 
 	uint32_t		sweep_wblock_id;				// wblocks read at startup
 	uint64_t		record_add_older_counter;		// records not inserted due to better existing one
@@ -199,6 +249,9 @@ typedef struct drv_ssd_s {
 	histogram		*hist_large_block_read;
 	histogram		*hist_write;
 	histogram		*hist_shadow_write;
+	histogram		*hist_wblock_fill;
+	histogram		*hist_defrag_wblock_age;
+	histogram		*hist_defrag_wblock_live;
 } drv_ssd;
 
 
@@ -220,8 +273,13 @@ typedef struct drv_ssds_s {
 	// Used only at startup, set true if all devices are fresh.
 	bool all_fresh;
 
+	// Not set if storage never activated, e.g. offline index snapshot build.
+	bool write_threads_started;
+
 	cf_mutex			flush_lock;
 
+	struct as_record_cache_s *read_cache; // NULL unless read-cache-size set
+
 	int					n_ssds;
 	drv_ssd				ssds[];
 } drv_ssds;
@@ -283,6 +341,7 @@ uint64_t ssd_flush_max_us(const struct as_namespace_s *ns);
 void ssd_post_write(drv_ssd *ssd, ssd_write_buf *swb);
 int ssd_write_bins(struct as_storage_rd_s *rd);
 int ssd_buffer_bins(struct as_storage_rd_s *rd);
+void ssd_group_commit(drv_ssd *ssd);
 ssd_write_buf *swb_get(drv_ssd *ssd, bool use_reserve);
 bool write_uses_post_write_q(struct as_storage_rd_s *rd);
 
@@ -305,6 +364,22 @@ ssd_add_end_mark(uint8_t *mark, const as_flat_record *flat)
 	*(uint32_t*)mark = ssd_make_end_mark(flat);
 }
 
+static inline uint32_t
+ssd_make_crc_end_mark(const as_flat_record *flat, const uint8_t *mark)
+{
+	// CRC32C of everything preceding the mark.
+	uint32_t crc = cf_crc32c(0, flat, (size_t)(mark - (const uint8_t*)flat));
+
+	// Reserve a bit for signature flag.
+	return cf_swap_to_le32(crc & 0x7FFFffff);
+}
+
+static inline void
+ssd_add_crc_end_mark(uint8_t *mark, const as_flat_record *flat)
+{
+	*(uint32_t*)mark = ssd_make_crc_end_mark(flat, mark);
+}
+
 
 //
 // Conversions between bytes/rblocks and wblocks.
@@ -120,6 +120,7 @@ typedef struct ssd_comp_meta_s {
 	as_compression_method method;
 	uint32_t orig_sz;
 	uint32_t comp_sz;
+	uint32_t dict_id; // zstd dictionary version - 0 means no dictionary
 } as_flat_comp_meta;
 
 // Per-record optional metadata container.
@@ -134,6 +135,13 @@ typedef struct as_flat_opt_meta_s {
 	as_flat_comp_meta cm;
 } as_flat_opt_meta;
 
+// Names of the only bins a reader needs unpacked.
+typedef struct as_flat_bin_proj_s {
+	uint32_t n_names;
+	const uint8_t* const* names;
+	const uint8_t* name_lens;
+} as_flat_bin_proj;
+
 // Can't use a struct with bit fields since has-meta flag must be MSB.
 #define BIN_HAS_META			0x80
 
@@ -159,6 +167,7 @@ typedef struct flat_bin_lut_s {
 void as_flat_pickle_record(struct as_storage_rd_s* rd);
 uint32_t as_flat_record_size(const struct as_storage_rd_s* rd);
 void as_flat_pack_record(const struct as_storage_rd_s* rd, uint32_t n_rblocks, bool dirty, as_flat_record* flat);
+bool as_flat_touch_record(const struct as_index_s* r, as_flat_record* flat);
 
 as_flat_record* as_flat_compress_bins_and_pack_record(const struct as_storage_rd_s* rd, uint32_t max_orig_sz, bool dirty, bool will_mark_end, uint32_t* flat_sz);
 
@@ -167,6 +176,7 @@ const uint8_t* as_flat_unpack_record_meta(const as_flat_record* flat, const uint
 bool as_flat_fix_padded_rr(struct as_remote_record_s* rr, bool single_bin); // TODO - remove in "six months"
 int as_flat_unpack_remote_bins(struct as_remote_record_s* rr, struct as_bin_s* bins);
 int as_flat_unpack_bins(struct as_namespace_s* ns, const uint8_t* at, const uint8_t* end, uint16_t n_bins, struct as_bin_s* bins);
+int as_flat_unpack_projected_bins(struct as_namespace_s* ns, const uint8_t* at, const uint8_t* end, uint16_t n_bins, const as_flat_bin_proj* proj, struct as_bin_s* bins);
 const uint8_t* as_flat_check_packed_bins(const uint8_t* at, const uint8_t* end, uint32_t n_bins, bool single_bin);
 
 uint32_t as_flat_orig_pickle_size(const struct as_remote_record_s* rr, uint32_t pickle_sz);
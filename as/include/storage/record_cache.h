@@ -0,0 +1,52 @@
+/*
+ * record_cache.h
+ *
+ * Copyright (C) 2020 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+
+#include "citrusleaf/cf_digest.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+typedef struct as_record_cache_s as_record_cache;
+
+
+//==========================================================
+// Public API.
+//
+
+as_record_cache* as_record_cache_create(uint64_t max_bytes);
+
+uint8_t* as_record_cache_get(as_record_cache* rc, const cf_digest* keyd, uint64_t rblock_id, uint32_t size);
+void as_record_cache_put(as_record_cache* rc, const cf_digest* keyd, uint64_t rblock_id, const uint8_t* buf, uint32_t size);
+void as_record_cache_update(as_record_cache* rc, const cf_digest* keyd, uint64_t rblock_id, const uint8_t* buf, uint32_t size);
+void as_record_cache_remove(as_record_cache* rc, const cf_digest* keyd);
+
+void as_record_cache_stats(as_record_cache* rc, uint64_t* n_bytes, uint64_t* n_hits, uint64_t* n_misses);
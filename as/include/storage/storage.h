@@ -90,9 +90,21 @@ typedef enum {
 
 #define N_CURRENT_SWBS	3
 
+// Each current write buffer may be split into streams by TTL band.
+#define MAX_TTL_WRITE_STREAMS 8
+
 #define DEFAULT_POST_WRITE_QUEUE 256
 #define MAX_POST_WRITE_QUEUE (8 * 1024)
 
+// Device I/O priority class of the calling thread.
+typedef enum {
+	AS_STORAGE_IO_FOREGROUND,	// transactions
+	AS_STORAGE_IO_BACKGROUND,	// long queries, migrations
+	AS_STORAGE_IO_DEFRAG,
+
+	AS_STORAGE_N_IO_CLASSES
+} as_storage_io_class;
+
 typedef struct as_storage_rd_s {
 	struct as_index_s		*r;
 	struct as_namespace_s	*ns;
@@ -113,6 +125,7 @@ typedef struct as_storage_rd_s {
 
 	uint8_t					which_current_swb;
 	bool					read_page_cache;
+	const struct as_flat_bin_proj_s *bin_proj; // if set, load only these bins
 	bool					resolve_writes; // relevant only for enterprise edition
 	bool					xdr_bin_writes; // relevant only for enterprise edition
 	bool					bin_luts;
@@ -148,6 +161,11 @@ typedef struct storage_device_stats_s {
 	uint32_t defrag_q_sz;
 	uint64_t n_defrag_reads;
 	uint64_t n_defrag_writes;
+	uint64_t n_defrag_bytes_moved;
+	uint64_t n_defrag_bytes_reclaimed;
+
+	uint64_t n_partial_flushes;
+	uint64_t n_partial_flush_bytes;
 
 	uint32_t shadow_write_q_sz;
 } storage_device_stats;
@@ -158,6 +176,7 @@ typedef struct storage_device_stats_s {
 //
 
 extern uint64_t g_unique_data_size;
+extern __thread as_storage_io_class g_storage_io_class;
 
 //------------------------------------------------
 // Generic "base class" functions that call
@@ -186,6 +205,7 @@ int as_storage_record_write(as_storage_rd *rd);
 
 // Storage capacity monitoring.
 bool as_storage_overloaded(const struct as_namespace_s *ns, uint32_t margin, const char* tag); // returns true if write queue is too backed up
+bool as_storage_shed_low_priority(const struct as_namespace_s *ns, const char* tag); // returns true if low priority writes should back off
 void as_storage_defrag_sweep(struct as_namespace_s *ns);
 
 // Storage of generic data into device headers.
@@ -208,6 +228,9 @@ void as_storage_histogram_clear_all(struct as_namespace_s *ns); // clears all SS
 // Get record storage metadata.
 uint32_t as_storage_record_device_size(const struct as_namespace_s *ns, const struct as_index_s *r);
 
+void as_storage_read_prefetch(struct as_namespace_s *ns, const cf_digest *keyds, uint32_t n_keys);
+void as_storage_read_prefetch_clear(void); // clears prefetch results held by calling thread
+
 //------------------------------------------------
 // Generic functions that don't use "v-tables".
 //
@@ -220,17 +243,23 @@ void as_storage_record_get_set_name(as_storage_rd *rd);
 bool as_storage_rd_load_key(as_storage_rd *rd);
 bool as_storage_rd_load_pickle(as_storage_rd *rd);
 
+// Returns the previous class, for pooled threads to restore.
+as_storage_io_class as_storage_set_thread_io_class(as_storage_io_class io_class);
+
 //------------------------------------------------
 // AS_STORAGE_ENGINE_MEMORY functions.
 //
 
 void as_storage_init_memory(struct as_namespace_s *ns);
+void as_storage_load_memory(struct as_namespace_s *ns, cf_queue *complete_q); // table used directly in as_storage_init()
 void as_storage_start_tomb_raider_memory(struct as_namespace_s *ns);
 
 int as_storage_record_write_memory(as_storage_rd *rd);
 
 void as_storage_load_pmeta_memory(struct as_namespace_s *ns, struct as_partition_s *p);
 
+void as_storage_shutdown_memory(struct as_namespace_s *ns);
+
 void as_storage_stats_memory(struct as_namespace_s *ns, int *available_pct, uint64_t *used_bytes);
 
 //------------------------------------------------
@@ -275,9 +304,13 @@ void as_storage_device_stats_ssd(const struct as_namespace_s *ns, uint32_t devic
 void as_storage_ticker_stats_ssd(struct as_namespace_s *ns);
 void as_storage_dump_wb_summary_ssd(const struct as_namespace_s *ns);
 void as_storage_histogram_clear_ssd(struct as_namespace_s *ns);
+bool as_storage_read_cache_stats_ssd(const struct as_namespace_s *ns, uint64_t *n_bytes, uint64_t *n_hits, uint64_t *n_misses); // called directly without any table
 
 uint32_t as_storage_record_device_size_ssd(const struct as_index_s *r);
 
+void as_storage_read_prefetch_ssd(struct as_namespace_s *ns, const cf_digest *keyds, uint32_t n_keys);
+void as_storage_read_prefetch_clear_ssd(void); // called directly without any table
+
 //------------------------------------------------
 // AS_STORAGE_ENGINE_PMEM functions.
 //
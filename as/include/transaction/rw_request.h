@@ -109,6 +109,9 @@ typedef struct rw_request_s {
 	uint16_t			generation;
 	uint32_t			void_time;
 	uint64_t			last_update_time;
+	uint16_t			set_id;
+	uint64_t			dispatch_time;
+	uint64_t			master_done_time;
 
 	//
 	// End of as_transaction look-alike.
@@ -175,6 +178,7 @@ typedef struct rw_request_s {
 // Public API.
 //
 
+void rw_request_init(void);
 rw_request* rw_request_create();
 void rw_request_destroy(rw_request* rw);
 void rw_request_wait_q_push(rw_request* rw, struct as_transaction_s* tr);
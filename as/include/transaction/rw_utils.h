@@ -138,6 +138,7 @@ void remove_from_sindex(struct as_namespace_s* ns, struct as_index_ref_s* r_ref)
 void remove_from_sindex_bins(struct as_namespace_s* ns, struct as_index_ref_s* r_ref, struct as_bin_s* bins, uint32_t n_bins);
 void write_dim_single_bin_unwind(struct as_bin_s* old_bin, uint32_t n_old_bins, struct as_bin_s* new_bin, uint32_t n_new_bins, struct as_bin_s* cleanup_bins, uint32_t n_cleanup_bins);
 void write_dim_unwind(struct as_bin_s* old_bins, uint32_t n_old_bins, struct as_bin_s* new_bins, uint32_t n_new_bins, struct as_bin_s* cleanup_bins, uint32_t n_cleanup_bins);
+void write_dim_unwind_stored(const struct as_index_s* r, struct as_bin_s* new_bins, uint32_t n_new_bins, struct as_bin_s* cleanup_bins, uint32_t n_cleanup_bins);
 
 
 static inline bool
@@ -166,6 +167,17 @@ respond_on_master_complete(as_transaction* tr)
 }
 
 
+// Batch and background sub-transactions, and XDR writes, are shed first when
+// the node is backing up, to protect foreground client latency.
+static inline bool
+is_low_priority(const as_transaction* tr)
+{
+	return tr->origin == FROM_BATCH || tr->origin == FROM_IUDF ||
+			tr->origin == FROM_IOPS ||
+			(tr->origin == FROM_CLIENT && as_transaction_is_xdr(tr));
+}
+
+
 // FIXME - switch p_n_bins to uint16_t*.
 static inline void
 append_bin_to_destroy(as_bin* b, as_bin* bins, uint32_t* p_n_bins)
@@ -332,7 +332,7 @@ as_aggr_keys_release_cb(cf_ll_element* ele, void* udata)
 				.olock = as_index_olock_from_keyd(tree, &r->keyd)
 		};
 
-		cf_mutex_lock(r_ref.olock);
+		as_index_olock_lock(r_ref.olock);
 
 		as_index_release(r);
 		as_record_done(&r_ref, ns);
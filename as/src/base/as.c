@@ -100,6 +100,7 @@ static const struct option CMD_OPTS[] = {
 		{ "early-verbose", no_argument, NULL, 'e' },
 		{ "cold-start", no_argument, NULL, 'c' },
 		{ "instance", required_argument, NULL, 'n' },
+		{ "build-index-snapshot", no_argument, NULL, 'b' },
 		{ NULL, 0, NULL, 0 }
 };
 
@@ -151,6 +152,13 @@ static const char HELP[] =
 		"(Enterprise edition only.) If running multiple instances of Aerospike on one\n"
 		"machine (not recommended), each instance must be uniquely designated via this\n"
 		"option.\n"
+		"\n"
+		"--build-index-snapshot"
+		"\n"
+		"Cold start offline - scan all devices to build the index, write each\n"
+		"namespace's index-snapshot-file, and exit without joining the cluster. The next\n"
+		"start on these devices is then a warm restart. The devices must not be in use by\n"
+		"another asd process.\n"
 		;
 
 static const char USAGE[] =
@@ -165,7 +173,8 @@ static const char USAGE[] =
 		"[--fgdaemon] "
 		"[--early-verbose] "
 		"[--cold-start] "
-		"[--instance <0-15>]\n"
+		"[--instance <0-15>] "
+		"[--build-index-snapshot]\n"
 		;
 
 static const char DEFAULT_CONFIG_FILE[] = "/etc/aerospike/aerospike.conf";
@@ -194,6 +203,8 @@ extern void as_signal_setup();
 static void write_pidfile(char *pidfile);
 static void validate_directory(const char *path, const char *log_tag);
 static void validate_smd_directory();
+static void validate_index_snapshot_files(void);
+static void build_index_snapshots(uint32_t instance);
 
 
 //==========================================================
@@ -212,6 +223,7 @@ as_run(int argc, char **argv)
 	bool new_style_daemon = false;
 	bool early_verbose = false;
 	bool cold_start_cmd = false;
+	bool build_snapshot_cmd = false;
 	uint32_t instance = 0;
 
 	// Parse command line options.
@@ -254,6 +266,13 @@ as_run(int argc, char **argv)
 		case 'n':
 			instance = (uint32_t)strtol(optarg, NULL, 0);
 			break;
+		case 'b':
+			// Always a full scan, never daemonized, and no pid file - this is
+			// not the serving process.
+			build_snapshot_cmd = true;
+			cold_start_cmd = true;
+			run_in_foreground = true;
+			break;
 		default:
 			// fprintf() since we don't want cf_log's prefix.
 			fprintf(stderr, "%s\n", USAGE);
@@ -306,6 +325,11 @@ as_run(int argc, char **argv)
 		cf_process_daemonize();
 	}
 
+	// Start the background log writer - after daemonizing, since fork() doesn't
+	// carry threads. From here, most log lines are queued and written by the
+	// writer thread.
+	cf_log_start_async();
+
 	// Log which build this is - should be the first line in the log file.
 	cf_info(AS_AS, "<><><><><><><><><><>  %s build %s  <><><><><><><><><><>",
 			aerospike_build_type, aerospike_build_id);
@@ -319,7 +343,10 @@ as_run(int argc, char **argv)
 	}
 
 	// Write the pid file, if specified.
-	if (! new_style_daemon) {
+	if (build_snapshot_cmd) {
+		// Not the serving process - leave the pid file alone.
+	}
+	else if (! new_style_daemon) {
 		write_pidfile(c->pidfile);
 	}
 	else {
@@ -333,10 +360,16 @@ as_run(int argc, char **argv)
 	validate_directory(c->mod_lua.user_path, "Lua user");
 	validate_smd_directory();
 
+	if (build_snapshot_cmd) {
+		validate_index_snapshot_files();
+	}
+
 	// Initialize subsystems. At this point we're allocating local resources,
 	// starting worker threads, etc. (But no communication with other server
 	// nodes or clients yet.)
 
+	cf_thread_profile_set_rate(c->profile_sample_rate); // before threads start
+
 	as_json_init();				// Jansson JSON API used by System Metadata
 	as_index_tree_gc_init();	// thread to purge dropped index trees
 	as_nsup_init();				// load previous evict-void-time(s)
@@ -375,6 +408,12 @@ as_run(int argc, char **argv)
 	as_storage_load();
 	// ... This could block for hours ......................
 
+	// Offline index build is done - CE sindexes are always rebuilt at startup,
+	// so there's nothing more to persist.
+	if (build_snapshot_cmd) {
+		build_index_snapshots(instance);
+	}
+
 	// Populate data-not-in-memory namespaces' secondary indexes.
 	as_sindex_load();
 	// ... This could block for a while ....................
@@ -460,11 +499,15 @@ as_run(int argc, char **argv)
 
 	if (! as_storage_shutdown(instance)) {
 		cf_warning(AS_AS, "failed clean shutdown - exiting");
+		cf_log_stop_async();
 		_exit(1);
 	}
 
 	cf_info(AS_AS, "finished clean shutdown - exiting");
 
+	// Flush queued log lines.
+	cf_log_stop_async();
+
 	// If shutdown was totally clean (all threads joined) we could just return,
 	// but for now we exit to make sure all threads die.
 #ifdef DOPROFILE
@@ -538,3 +581,54 @@ validate_smd_directory()
 	strcpy(smd_path + len, SMD_DIR_NAME);
 	validate_directory(smd_path, "system metadata");
 }
+
+static void
+validate_index_snapshot_files(void)
+{
+	uint32_t n_snapshots = 0;
+
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		as_namespace *ns = g_config.namespaces[ns_ix];
+
+		if (ns->storage_index_snapshot_file != NULL) {
+			n_snapshots++;
+		}
+		else if (ns->storage_type != AS_STORAGE_ENGINE_MEMORY) {
+			cf_warning(AS_AS, "{%s} no index-snapshot-file - will scan but not build snapshot",
+					ns->name);
+		}
+	}
+
+	if (n_snapshots == 0) {
+		cf_crash_nostack(AS_AS, "--build-index-snapshot but no namespace configures index-snapshot-file");
+	}
+}
+
+static void
+build_index_snapshots(uint32_t instance)
+{
+	cf_info(AS_AS, "devices scanned - writing index snapshots ...");
+
+	// Flushes nothing, marks devices trusted, then writes the snapshots.
+	bool ok = as_storage_shutdown(instance);
+
+	// A snapshot failure isn't a failed shutdown - check the files themselves.
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		as_namespace *ns = g_config.namespaces[ns_ix];
+		const char *path = ns->storage_index_snapshot_file;
+
+		if (path != NULL && access(path, F_OK) != 0) {
+			cf_warning(AS_AS, "{%s} index snapshot %s not written", ns->name,
+					path);
+			ok = false;
+		}
+	}
+
+	cf_info(AS_AS, "%s building index snapshots - exiting",
+			ok ? "finished" : "failed");
+
+	// Flush queued log lines.
+	cf_log_stop_async();
+
+	_exit(ok ? 0 : 1);
+}
@@ -38,6 +38,8 @@
 #include "base/stats.h"
 #include "base/thr_tsvc.h"
 #include "base/transaction.h"
+#include "fabric/partition.h"
+#include "storage/storage.h"
 #include "cf_mutex.h"
 #include "cf_thread.h"
 #include "hardware.h"
@@ -45,6 +47,7 @@
 #include "socket.h"
 #include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 //---------------------------------------------------------
@@ -139,6 +142,12 @@ typedef struct {
 	bool complete;
 } as_batch_work;
 
+// Inline device sub-transaction held back until its reads are prefetched.
+typedef struct {
+	as_namespace* ns;
+	as_transaction tr;
+} as_batch_deferred;
+
 //--------------------------------------
 // thread_pool class.
 //
@@ -190,7 +199,7 @@ as_batch_send_error(as_transaction* btr, int result_code)
 	m.msg.info1 = 0;
 	m.msg.info2 = 0;
 	m.msg.info3 = AS_MSG_INFO3_LAST;
-	m.msg.unused = 0;
+	m.msg.info4 = 0;
 	m.msg.result_code = result_code;
 	m.msg.generation = 0;
 	m.msg.record_ttl = 0;
@@ -312,7 +321,7 @@ as_batch_send_trailer(as_batch_queue* queue, as_batch_shared* shared, as_batch_b
 	msg->info1 = 0;
 	msg->info2 = 0;
 	msg->info3 = AS_MSG_INFO3_LAST;
-	msg->unused = 0;
+	msg->info4 = 0;
 	msg->result_code = shared->result_code;
 	msg->generation = 0;
 	msg->record_ttl = 0;
@@ -790,6 +799,107 @@ as_batch_terminate(as_batch_shared* shared, uint32_t tran_count, int result_code
 	as_batch_transaction_end(shared, buffer, complete);
 }
 
+static void
+as_batch_prefetch_index(as_namespace* ns, const cf_digest* keyds,
+		uint32_t n_keys)
+{
+	as_partition_reservation* rsvs =
+			cf_malloc(n_keys * sizeof(as_partition_reservation));
+	as_index_tree** trees = cf_malloc(n_keys * sizeof(as_index_tree*));
+	uint32_t n_rsvs = 0;
+
+	// Reservations keep the trees alive while their sprigs are walked. Keys
+	// arrive grouped by partition, so reserve once per group.
+	for (uint32_t i = 0; i < n_keys; i++) {
+		uint32_t pid = as_partition_getid(&keyds[i]);
+
+		if (n_rsvs == 0 || rsvs[n_rsvs - 1].p->id != pid) {
+			as_partition_reserve(ns, pid, &rsvs[n_rsvs++]);
+		}
+
+		trees[i] = rsvs[n_rsvs - 1].tree;
+	}
+
+	as_index_prefetch_multi(trees, keyds, n_keys);
+
+	for (uint32_t i = 0; i < n_rsvs; i++) {
+		as_partition_release(&rsvs[i]);
+	}
+
+	cf_free(trees);
+	cf_free(rsvs);
+}
+
+static int
+deferred_compare(const void* pa, const void* pb)
+{
+	const as_batch_deferred* a = (const as_batch_deferred*)pa;
+	const as_batch_deferred* b = (const as_batch_deferred*)pb;
+
+	if (a->ns->ix != b->ns->ix) {
+		return a->ns->ix < b->ns->ix ? -1 : 1;
+	}
+
+	uint32_t a_pid = as_partition_getid(&a->tr.keyd);
+	uint32_t b_pid = as_partition_getid(&b->tr.keyd);
+
+	if (a_pid != b_pid) {
+		return a_pid < b_pid ? -1 : 1;
+	}
+
+	// Keep client order within a partition.
+	uint32_t a_ix = a->tr.from_data.batch_index;
+	uint32_t b_ix = b->tr.from_data.batch_index;
+
+	return a_ix < b_ix ? -1 : (a_ix > b_ix ? 1 : 0);
+}
+
+static void
+as_batch_process_deferred(as_batch_deferred* deferred, uint32_t n_deferred)
+{
+	// Group by partition - each group then shares one prefetch reservation,
+	// and its sub-transactions run back to back against a warm tree.
+	qsort(deferred, n_deferred, sizeof(as_batch_deferred), deferred_compare);
+
+	cf_digest* keyds = cf_malloc(n_deferred * sizeof(cf_digest));
+	bool prefetched[AS_NAMESPACE_SZ] = { false };
+
+	// Prefetch per namespace - batches rarely span more than one.
+	for (uint32_t i = 0; i < n_deferred; i++) {
+		as_namespace* ns = deferred[i].ns;
+
+		if (prefetched[ns->ix]) {
+			continue;
+		}
+
+		uint32_t n_keys = 0;
+
+		for (uint32_t j = i; j < n_deferred; j++) {
+			if (deferred[j].ns == ns) {
+				keyds[n_keys++] = deferred[j].tr.keyd;
+			}
+		}
+
+		if (ns->batch_index_prefetch) {
+			as_batch_prefetch_index(ns, keyds, n_keys);
+		}
+
+		if (ns->storage_coalesce_batch_reads) {
+			as_storage_read_prefetch(ns, keyds, n_keys);
+		}
+
+		prefetched[ns->ix] = true;
+	}
+
+	cf_free(keyds);
+
+	for (uint32_t i = 0; i < n_deferred; i++) {
+		as_tsvc_process_transaction(&deferred[i].tr);
+	}
+
+	as_storage_read_prefetch_clear();
+}
+
 //---------------------------------------------------------
 // FUNCTIONS
 //---------------------------------------------------------
@@ -978,6 +1088,9 @@ as_batch_queue_task(as_transaction* btr)
 
 	as_namespace* ns = NULL; // namespace of current sub-transaction
 
+	as_batch_deferred* deferred = NULL;
+	uint32_t n_deferred = 0;
+
 	// Split batch rows into separate single record read transactions.
 	// The read transactions are located in the same memory block as
 	// the original batch transactions. This allows us to avoid performing
@@ -1039,7 +1152,7 @@ as_batch_queue_task(as_transaction* btr)
 						(AS_MSG_INFO3_SC_READ_RELAX | AS_MSG_INFO3_SC_READ_TYPE);
 			}
 
-			out->msg.unused = 0;
+			out->msg.info4 = 0;
 			out->msg.result_code = 0;
 
 			if (has_generation) {
@@ -1142,9 +1255,24 @@ as_batch_queue_task(as_transaction* btr)
 			tr.benchmark_time = 0;
 		}
 
+		bool like_dim = as_namespace_like_data_in_memory(ns);
+
 		// Submit transaction.
-		if (tran_count == 1 || (as_namespace_like_data_in_memory(ns) ?
-				inline_dim : inline_dev)) {
+		if (tran_count != 1 && ((inline_dev && ns->storage_coalesce_batch_reads &&
+				ns->storage_type == AS_STORAGE_ENGINE_SSD &&
+				! ns->storage_data_in_memory) ||
+				(ns->batch_index_prefetch && (like_dim ? inline_dim : inline_dev)))) {
+			// Process after all keys are known, so device reads can merge and
+			// index lookups can overlap.
+			if (deferred == NULL) {
+				deferred = cf_malloc(tran_count * sizeof(as_batch_deferred));
+			}
+
+			deferred[n_deferred].ns = ns;
+			deferred[n_deferred].tr = tr;
+			n_deferred++;
+		}
+		else if (tran_count == 1 || (like_dim ? inline_dim : inline_dev)) {
 			as_tsvc_process_transaction(&tr);
 		}
 		else {
@@ -1156,6 +1284,11 @@ as_batch_queue_task(as_transaction* btr)
 	}
 
 TranEnd:
+	if (deferred != NULL) {
+		as_batch_process_deferred(deferred, n_deferred);
+		cf_free(deferred);
+	}
+
 	if (tran_row < tran_count) {
 		// Mismatch between tran_count and actual data.  Terminate transaction.
 		cf_warning(AS_BATCH, "Batch keys mismatch. Expected %u Received %u", tran_count, tran_row);
@@ -1209,7 +1342,7 @@ as_batch_add_result(as_transaction* tr, uint16_t n_bins, as_bin** bins,
 		m->info1 = 0;
 		m->info2 = 0;
 		m->info3 = 0;
-		m->unused = 0;
+		m->info4 = 0;
 		m->result_code = tr->result_code;
 		m->generation = plain_generation(tr->generation, ns);
 		m->record_ttl = tr->void_time;
@@ -1283,7 +1416,7 @@ as_batch_add_ack(as_transaction* tr)
 		m->info1 = 0;
 		m->info2 = 0;
 		m->info3 = 0;
-		m->unused = 0;
+		m->info4 = 0;
 		m->result_code = tr->result_code;
 		m->generation = plain_generation(tr->generation, tr->rsv.ns);
 		m->record_ttl = tr->void_time;
@@ -1311,7 +1444,7 @@ as_batch_add_error(as_batch_shared* shared, uint32_t index, int result_code)
 		m->info1 = 0;
 		m->info2 = 0;
 		m->info3 = 0;
-		m->unused = 0;
+		m->info4 = 0;
 		m->result_code = result_code;
 		m->generation = 0;
 		m->record_ttl = 0;
@@ -31,6 +31,7 @@
 
 #include "citrusleaf/alloc.h"
 
+#include "enhanced_alloc.h"
 #include "log.h"
 #include "vmapx.h"
 
@@ -40,6 +41,33 @@
 #include "storage/storage.h"
 
 
+//==========================================================
+// Typedefs & constants.
+//
+
+// Small string and blob particles are packed into the bin space allocation.
+#define MAX_PACKED_PARTICLE_SZ 64
+
+// Per-thread direct-mapped cache of bin name to id, in front of the namespace's
+// bin name vmap. Names are never removed from the vmap, and namespaces are
+// never freed, so entries never go stale.
+#define BIN_NAME_CACHE_SZ 256
+
+typedef struct bin_name_cache_ele_s {
+	const as_namespace* ns;
+	uint16_t id;
+	uint8_t len;
+	char name[AS_BIN_NAME_MAX_SZ];
+} bin_name_cache_ele;
+
+
+//==========================================================
+// Globals.
+//
+
+static __thread bin_name_cache_ele g_bin_name_cache[BIN_NAME_CACHE_SZ];
+
+
 //==========================================================
 // Inlines & macros.
 //
@@ -67,6 +95,102 @@ safe_n_bins(const as_record* r)
 	return bin_space ? bin_space->n_bins : 0;
 }
 
+static inline const uint8_t*
+packed_particles(const as_record* r, const as_bin_space* bin_space)
+{
+	return (const uint8_t*)bin_space->bins + bin_space->n_bins *
+			(r->has_bin_meta == 0 ? sizeof(as_bin_no_meta) : sizeof(as_bin));
+}
+
+// Cheaper than the vmap's hash - names are short, so just mix two words.
+static inline bin_name_cache_ele*
+bin_name_cache_ele_for(const char* name, size_t len)
+{
+	uint64_t w0 = 0;
+	uint64_t w1 = 0;
+
+	if (len > sizeof(w0)) {
+		memcpy(&w0, name, sizeof(w0));
+		memcpy(&w1, name + sizeof(w0), len - sizeof(w0));
+	}
+	else {
+		memcpy(&w0, name, len);
+	}
+
+	uint64_t h = (w0 * 0x9E3779B97F4A7C15UL) ^ (w1 * 0xC2B2AE3D27D4EB4FUL) ^
+			len;
+
+	return &g_bin_name_cache[(h ^ (h >> 32)) % BIN_NAME_CACHE_SZ];
+}
+
+static inline bool
+get_bin_name_id(const as_namespace* ns, const char* name, size_t len,
+		uint32_t* id)
+{
+	if (len >= AS_BIN_NAME_MAX_SZ) {
+		return false; // vmap wouldn't have it either
+	}
+
+	bin_name_cache_ele* ele = bin_name_cache_ele_for(name, len);
+
+	if (ele->ns == ns && ele->len == len && memcmp(ele->name, name, len) == 0) {
+		*id = ele->id;
+		return true;
+	}
+
+	if (cf_vmapx_get_index_w_len(ns->p_bin_name_vmap, name, len, id) !=
+			CF_VMAPX_OK) {
+		return false; // not cached - name may be added later
+	}
+
+	ele->ns = ns;
+	ele->id = (uint16_t)*id;
+	ele->len = (uint8_t)len;
+	memcpy(ele->name, name, len);
+
+	return true;
+}
+
+static inline bool
+is_packed_particle(const as_record* r, const as_bin_space* bin_space,
+		const as_particle* p)
+{
+	if (bin_space == NULL || bin_space->packed_sz == 0) {
+		return false;
+	}
+
+	const uint8_t* start = packed_particles(r, bin_space);
+
+	return (const uint8_t*)p >= start &&
+			(const uint8_t*)p < start + bin_space->packed_sz;
+}
+
+static inline uint32_t
+packable_size(as_bin* b)
+{
+	if (! as_bin_is_external_particle(b)) {
+		return 0;
+	}
+
+	switch (as_bin_get_particle_type(b)) {
+	case AS_PARTICLE_TYPE_STRING:
+	case AS_PARTICLE_TYPE_BLOB:
+	case AS_PARTICLE_TYPE_JAVA_BLOB:
+	case AS_PARTICLE_TYPE_CSHARP_BLOB:
+	case AS_PARTICLE_TYPE_PYTHON_BLOB:
+	case AS_PARTICLE_TYPE_RUBY_BLOB:
+	case AS_PARTICLE_TYPE_PHP_BLOB:
+	case AS_PARTICLE_TYPE_ERLANG_BLOB:
+		break;
+	default:
+		return 0;
+	}
+
+	uint32_t sz = as_bin_particle_size(b);
+
+	return sz <= MAX_PACKED_PARTICLE_SZ ? sz : 0;
+}
+
 
 //==========================================================
 // Public API.
@@ -91,7 +215,7 @@ as_bin_get_id(const as_namespace* ns, const char* name, uint16_t* id)
 
 	uint32_t idx;
 
-	if (cf_vmapx_get_index(ns->p_bin_name_vmap, name, &idx) == CF_VMAPX_OK) {
+	if (get_bin_name_id(ns, name, strlen(name), &idx)) {
 		*id = (uint16_t)idx;
 		return true;
 	}
@@ -107,8 +231,7 @@ as_bin_get_id_w_len(const as_namespace* ns, const char* name, size_t len,
 
 	uint32_t idx;
 
-	if (cf_vmapx_get_index_w_len(ns->p_bin_name_vmap, name, len, &idx) ==
-			CF_VMAPX_OK) {
+	if (get_bin_name_id(ns, name, len, &idx)) {
 		*id = (uint16_t)idx;
 		return true;
 	}
@@ -127,8 +250,7 @@ as_bin_get_or_assign_id_w_len(as_namespace* ns, const char* name, size_t len,
 
 	uint32_t idx;
 
-	if (cf_vmapx_get_index_w_len(ns->p_bin_name_vmap, name, len, &idx) ==
-			CF_VMAPX_OK) {
+	if (get_bin_name_id(ns, name, len, &idx)) {
 		*id = (uint16_t)idx;
 		return true;
 	}
@@ -187,28 +309,7 @@ as_storage_rd_load_bins(as_storage_rd* rd, as_bin* stack_bins)
 		}
 		else {
 			rd->bins = stack_bins;
-			rd->n_bins = safe_n_bins(r);
-
-			if (rd->n_bins == 0) {
-				return 0;
-			}
-
-			as_bin_space* bin_space = as_index_get_bin_space(r);
-
-			if (r->has_bin_meta == 0) {
-				as_bin_no_meta* stored_bins = (as_bin_no_meta*)bin_space->bins;
-
-				for (uint16_t i = 0; i < rd->n_bins; i++) {
-					as_bin* b = &rd->bins[i];
-
-					*(as_bin_no_meta*)b = stored_bins[i];
-					as_bin_clear_meta(b);
-				}
-			}
-			else {
-				memcpy((void*)rd->bins, (const void*)bin_space->bins,
-						rd->n_bins * sizeof(as_bin));
-			}
+			rd->n_bins = as_bin_load_stored(r, stack_bins);
 		}
 
 		return 0;
@@ -226,8 +327,69 @@ as_storage_rd_load_bins(as_storage_rd* rd, as_bin* stack_bins)
 	return 0;
 }
 
+// Called only for multi-bin data-in-memory. Copies the record's stored bins
+// into bins, returning how many there are.
+uint16_t
+as_bin_load_stored(const as_record* r, as_bin* bins)
+{
+	uint16_t n_bins = safe_n_bins(r);
+
+	if (n_bins == 0) {
+		return 0;
+	}
+
+	as_bin_space* bin_space = as_index_get_bin_space(r);
+
+	if (r->has_bin_meta == 0) {
+		as_bin_no_meta* stored_bins = (as_bin_no_meta*)bin_space->bins;
+
+		for (uint16_t i = 0; i < n_bins; i++) {
+			as_bin* b = &bins[i];
+
+			*(as_bin_no_meta*)b = stored_bins[i];
+			as_bin_clear_meta(b);
+		}
+	}
+	else {
+		memcpy((void*)bins, (const void*)bin_space->bins,
+				n_bins * sizeof(as_bin));
+	}
+
+	return n_bins;
+}
+
+// Called only for multi-bin data-in-memory. Returns the external particle of
+// the record's stored bin with this id, or NULL - without copying the bins.
+const as_particle*
+as_bin_get_stored_particle(const as_record* r, uint16_t id)
+{
+	as_bin_space* bin_space = safe_bin_space(r);
+
+	if (bin_space == NULL) {
+		return NULL;
+	}
+
+	// Stored bins may lack meta - only fields up to id are read.
+	size_t bin_size = r->has_bin_meta == 0 ?
+			sizeof(as_bin_no_meta) : sizeof(as_bin);
+	const uint8_t* at = (const uint8_t*)bin_space->bins;
+
+	for (uint16_t i = 0; i < bin_space->n_bins; i++) {
+		const as_bin* b = (const as_bin*)at;
+
+		if (b->id == id) {
+			return as_bin_is_external_particle(b) ? b->particle : NULL;
+		}
+
+		at += bin_size;
+	}
+
+	return NULL;
+}
+
 // Where should this be?
 // Called only for multi-bin data-in-memory.
+// - may repoint rd->bins particles into the new bin space!
 void
 as_storage_rd_update_bin_space(as_storage_rd* rd)
 {
@@ -235,31 +397,84 @@ as_storage_rd_update_bin_space(as_storage_rd* rd)
 
 	as_bin_space* old_bin_space = as_index_get_bin_space(r);
 
-	if (old_bin_space != NULL) {
-		cf_free(old_bin_space);
-	}
-
-	r->has_bin_meta = 0;
-
 	if (rd->n_bins == 0) {
+		if (old_bin_space != NULL) {
+			cf_free(old_bin_space);
+		}
+
+		r->has_bin_meta = 0;
 		as_index_set_bin_space(r, NULL);
 		return;
 	}
 
-	size_t bins_size = rd->n_bins * sizeof(as_bin_no_meta);
+	bool has_bin_meta = false;
 
 	for (uint16_t i = 0; i < rd->n_bins; i++) {
 		if (as_bin_has_meta(&rd->bins[i])) {
-			r->has_bin_meta = 1;
-			bins_size = rd->n_bins * sizeof(as_bin);
+			has_bin_meta = true;
 			break;
 		}
 	}
 
+	size_t bins_size = rd->n_bins *
+			(has_bin_meta ? sizeof(as_bin) : sizeof(as_bin_no_meta));
+
+	// Small particles are copied in after the bins, so the whole record is one
+	// allocation - size them first.
+
+	uint32_t packed_sz = 0;
+
+	for (uint16_t i = 0; i < rd->n_bins; i++) {
+		uint32_t sz = packable_size(&rd->bins[i]);
+
+		if (sz != 0 && packed_sz + sz <= UINT16_MAX) {
+			packed_sz += sz;
+		}
+	}
+
 	as_bin_space* new_bin_space = (as_bin_space*)
-			cf_malloc_ns(sizeof(as_bin_space) + bins_size);
+			cf_malloc_ns(sizeof(as_bin_space) + bins_size + packed_sz);
 
 	new_bin_space->n_bins = rd->n_bins;
+	new_bin_space->packed_sz = (uint16_t)packed_sz;
+
+	uint8_t* start = (uint8_t*)new_bin_space->bins + bins_size;
+	uint8_t* at = start;
+
+	for (uint16_t i = 0; i < rd->n_bins; i++) {
+		as_bin* b = &rd->bins[i];
+		uint32_t sz = packable_size(b);
+
+		if (sz == 0 || (uint32_t)(at - start) + sz > UINT16_MAX) {
+			// Very many small bins - out of room, so unpack if necessary.
+			if (sz != 0 && is_packed_particle(r, old_bin_space, b->particle)) {
+				as_particle* p = cf_malloc_ns(sz);
+
+				memcpy(p, b->particle, sz);
+				b->particle = p;
+			}
+
+			continue;
+		}
+
+		memcpy(at, b->particle, sz);
+
+		// Packed particles in the old bin space go with it - others were
+		// allocated separately, and are now replaced by their packed copy.
+		if (! is_packed_particle(r, old_bin_space, b->particle)) {
+			cf_free(b->particle);
+		}
+
+		b->particle = (as_particle*)at;
+		at += sz;
+	}
+
+	// Now that its packed particles are copied, the old bin space can go.
+	if (old_bin_space != NULL) {
+		cf_free(old_bin_space);
+	}
+
+	r->has_bin_meta = has_bin_meta ? 1 : 0;
 
 	if (r->has_bin_meta == 0) {
 		as_bin_no_meta* stored_bins = (as_bin_no_meta*)new_bin_space->bins;
@@ -275,6 +490,113 @@ as_storage_rd_update_bin_space(as_storage_rd* rd)
 	as_index_set_bin_space(r, new_bin_space);
 }
 
+// Called only for multi-bin data-in-memory, before the record's bin space is
+// updated or freed - particles packed in the bin space are freed with it.
+void
+as_bin_destroy_all_stored(const as_record* r, as_bin* bins, uint32_t n_bins)
+{
+	as_bin_space* bin_space = safe_bin_space(r);
+
+	for (uint32_t i = 0; i < n_bins; i++) {
+		as_bin* b = &bins[i];
+
+		if (as_bin_is_external_particle(b) &&
+				is_packed_particle(r, bin_space, b->particle)) {
+			as_bin_set_empty(b);
+			b->particle = NULL;
+			continue;
+		}
+
+		as_bin_particle_destroy(b);
+	}
+}
+
+// Called under the record lock, for data-in-memory. Moves separately allocated
+// particles, then the bin space, to fresh regions if their size classes are
+// sparsely occupied. Returns the number of allocations moved.
+uint32_t
+as_bin_relocate_stored(as_namespace* ns, as_record* r,
+		const cf_alloc_bin_util* util, uint32_t lwm_pct)
+{
+	if (ns->single_bin) {
+		as_bin* b = as_index_get_single_bin(r);
+
+		if (! as_bin_is_external_particle(b)) {
+			return 0;
+		}
+
+		uint32_t sz = as_bin_particle_size(b);
+
+		if (! cf_alloc_bin_util_sparse(util, sz, lwm_pct)) {
+			return 0;
+		}
+
+		b->particle = cf_alloc_relocate_arena(b->particle, sz, ns->jem_arena);
+
+		return 1;
+	}
+
+	as_bin_space* bin_space = safe_bin_space(r);
+
+	if (bin_space == NULL) {
+		return 0;
+	}
+
+	size_t stride = r->has_bin_meta == 0 ?
+			sizeof(as_bin_no_meta) : sizeof(as_bin);
+	uint32_t n_moved = 0;
+
+	// State and particle are within as_bin_no_meta, so valid for either size.
+	for (uint16_t i = 0; i < bin_space->n_bins; i++) {
+		as_bin* b = (as_bin*)((uint8_t*)bin_space->bins + i * stride);
+
+		if (! as_bin_is_external_particle(b) ||
+				is_packed_particle(r, bin_space, b->particle)) {
+			continue;
+		}
+
+		uint32_t sz = as_bin_particle_size(b);
+
+		if (cf_alloc_bin_util_sparse(util, sz, lwm_pct)) {
+			b->particle = cf_alloc_relocate_arena(b->particle, sz,
+					ns->jem_arena);
+			n_moved++;
+		}
+	}
+
+	size_t space_sz = sizeof(as_bin_space) + bin_space->n_bins * stride +
+			bin_space->packed_sz;
+
+	if (! cf_alloc_bin_util_sparse(util, space_sz, lwm_pct)) {
+		return n_moved;
+	}
+
+	const uint8_t* old_packed = packed_particles(r, bin_space);
+	as_bin_space* new_bin_space = cf_alloc_relocate_arena(bin_space, space_sz,
+			ns->jem_arena);
+
+	// Packed particles moved with the bin space - rebase their pointers.
+	if (new_bin_space->packed_sz != 0) {
+		uint8_t* new_packed = (uint8_t*)packed_particles(r, new_bin_space);
+
+		for (uint16_t i = 0; i < new_bin_space->n_bins; i++) {
+			as_bin* b = (as_bin*)((uint8_t*)new_bin_space->bins + i * stride);
+
+			if (as_bin_is_external_particle(b) &&
+					(const uint8_t*)b->particle >= old_packed &&
+					(const uint8_t*)b->particle <
+							old_packed + new_bin_space->packed_sz) {
+				b->particle = (as_particle*)(new_packed +
+						((const uint8_t*)b->particle - old_packed));
+			}
+		}
+	}
+
+	as_index_set_bin_space(r, new_bin_space);
+
+	return n_moved + 1;
+}
+
 as_bin*
 as_bin_get_by_id_live(as_storage_rd* rd, uint32_t id)
 {
@@ -304,8 +626,7 @@ as_bin_get_w_len(as_storage_rd* rd, const uint8_t* name, size_t len)
 
 	uint32_t id;
 
-	if (cf_vmapx_get_index_w_len(rd->ns->p_bin_name_vmap, (const char*)name,
-			len, &id) != CF_VMAPX_OK) {
+	if (! get_bin_name_id(rd->ns, (const char*)name, len, &id)) {
 		return NULL;
 	}
 
@@ -335,8 +656,7 @@ as_bin_get_live_w_len(as_storage_rd* rd, const uint8_t* name, size_t len)
 
 	uint32_t id;
 
-	if (cf_vmapx_get_index_w_len(rd->ns->p_bin_name_vmap, (const char*)name,
-			len, &id) != CF_VMAPX_OK) {
+	if (! get_bin_name_id(rd->ns, (const char*)name, len, &id)) {
 		return NULL;
 	}
 
@@ -377,8 +697,7 @@ as_bin_get_or_create_w_len(as_storage_rd* rd, const uint8_t* name, size_t len,
 
 	uint32_t id;
 
-	if (cf_vmapx_get_index_w_len(ns->p_bin_name_vmap, (const char*)name, len,
-			&id) == CF_VMAPX_OK) {
+	if (get_bin_name_id(ns, (const char*)name, len, &id)) {
 		for (uint16_t i = 0; i < rd->n_bins; i++) {
 			as_bin* b = &rd->bins[i];
 
@@ -445,8 +764,7 @@ as_bin_pop_w_len(as_storage_rd* rd, const uint8_t* name, size_t len,
 
 	uint32_t id;
 
-	if (cf_vmapx_get_index_w_len(rd->ns->p_bin_name_vmap, (const char*)name,
-			len, &id) != CF_VMAPX_OK) {
+	if (! get_bin_name_id(rd->ns, (const char*)name, len, &id)) {
 		return false;
 	}
 
@@ -47,6 +47,24 @@
 #define VA_FIRST(first, ...)	first
 #define VA_REST(first, ...)		__VA_ARGS__
 
+// Resolved read context levels for the particle last dug into - lets sibling
+// ops in a request share the traversal of a common context path prefix.
+#define CTX_CACHE_MAX_LEVELS 16
+#define CTX_CACHE_MAX_SZ 512
+
+typedef struct ctx_cache_level_s {
+	uint32_t end; // end of this level's (type, value) pair in buf
+	uint32_t data_offset;
+	uint32_t data_sz;
+} ctx_cache_level;
+
+typedef struct ctx_cache_s {
+	const as_particle *particle; // NULL means empty
+	uint32_t n_levels;
+	ctx_cache_level levels[CTX_CACHE_MAX_LEVELS];
+	uint8_t buf[CTX_CACHE_MAX_SZ];
+} ctx_cache;
+
 #define CDT_OP_ENTRY(op, type, ...) [op].name = # op, [op].args = (const as_cdt_paramtype[]){VA_REST(__VA_ARGS__, 0)}, [op].count = VA_NARGS(__VA_ARGS__) - 1, [op].opt_args = VA_FIRST(__VA_ARGS__)
 
 const cdt_op_table_entry cdt_op_table[] = {
@@ -255,6 +273,10 @@ static const char* cdt_exp_display_names[] = {
 
 static const size_t n_cdt_exp_display_names = sizeof(cdt_exp_display_names) / sizeof(char*);
 
+// Only valid within one transaction's ops loop - particles are freed, and
+// their memory reused, between transactions.
+static __thread ctx_cache g_ctx_cache;
+
 
 //==========================================================
 // Forward declares.
@@ -287,11 +309,14 @@ static void cdt_context_fill_unpacker(cdt_context *ctx, msgpack_in *mp);
 
 static void cdt_context_unwind(cdt_context *ctx);
 
+static uint32_t ctx_cache_resume(ctx_cache *cache, cdt_context *ctx, msgpack_vec *vec, uint32_t n_levels);
+static void ctx_cache_add(ctx_cache *cache, uint32_t level, const uint8_t *pair, uint32_t pair_sz, const cdt_context *ctx);
+
 static bool cdt_context_type_is_read(uint8_t ctx_type);
 
 // as_bin_cdt_packed functions
 static int cdt_packed_modify(cdt_process_state *state, as_bin *b, as_bin *result, cf_ll_buf *particles_llb, bool alloc_ns);
-static int cdt_packed_read(cdt_process_state *state, const as_bin *b, as_bin *result, bool alloc_ns);
+static int cdt_packed_read(cdt_process_state *state, const as_bin *b, as_bin *result, bool alloc_ns, bool use_ctx_cache);
 
 // cdt_check
 static bool cdt_check_list(msgpack_in *mp);
@@ -2045,7 +2070,15 @@ cdt_context_dig(cdt_context *ctx, msgpack_in_vec *mv, bool is_modify)
 		return -AS_ERR_PARAMETER;
 	}
 
-	for (uint32_t i = 0; i < ctx_param_count; i += 2) {
+	ctx_cache *cache = NULL;
+	uint32_t i = 0;
+
+	if (ctx->use_ctx_cache && ! is_modify && mv->n_vecs == 1) {
+		cache = &g_ctx_cache;
+		i = ctx_cache_resume(cache, ctx, vec, ctx_param_count / 2) * 2;
+	}
+
+	for (; i < ctx_param_count; i += 2) {
 		uint64_t ctx_type;
 		bool ret;
 		uint32_t start_off = vec->offset;
@@ -2134,11 +2167,83 @@ cdt_context_dig(cdt_context *ctx, msgpack_in_vec *mv, bool is_modify)
 
 			break;
 		}
+
+		if (cache != NULL) {
+			ctx_cache_add(cache, i / 2, vec->buf + start_off,
+					vec->offset - start_off, ctx);
+		}
 	}
 
 	return AS_OK;
 }
 
+// Matches the context's leading (type, value) pairs bytewise against the
+// cached ones - msgpack is self-delimiting, so an exact match is the same
+// pair. Positions the context after the last matched level.
+static uint32_t
+ctx_cache_resume(ctx_cache *cache, cdt_context *ctx, msgpack_vec *vec,
+		uint32_t n_levels)
+{
+	if (cache->particle != ctx->b->particle) {
+		cache->particle = ctx->b->particle;
+		cache->n_levels = 0;
+		return 0;
+	}
+
+	uint32_t level = 0;
+	uint32_t start = 0;
+
+	while (level < cache->n_levels && level < n_levels) {
+		uint32_t end = cache->levels[level].end;
+		uint32_t sz = end - start;
+
+		if (vec->buf_sz - vec->offset < sz ||
+				memcmp(vec->buf + vec->offset, cache->buf + start, sz) != 0) {
+			break;
+		}
+
+		vec->offset += sz;
+		start = end;
+		level++;
+	}
+
+	// Deeper levels belong to a different path - this dig replaces them.
+	cache->n_levels = level;
+
+	if (level != 0) {
+		ctx->data_offset = cache->levels[level - 1].data_offset;
+		ctx->data_sz = cache->levels[level - 1].data_sz;
+	}
+
+	return level;
+}
+
+static void
+ctx_cache_add(ctx_cache *cache, uint32_t level, const uint8_t *pair,
+		uint32_t pair_sz, const cdt_context *ctx)
+{
+	// Levels must stay contiguous - stop at the first one that doesn't fit.
+	if (level != cache->n_levels || level == CTX_CACHE_MAX_LEVELS) {
+		return;
+	}
+
+	uint32_t start = level == 0 ? 0 : cache->levels[level - 1].end;
+
+	if (start + pair_sz > CTX_CACHE_MAX_SZ) {
+		return;
+	}
+
+	memcpy(cache->buf + start, pair, pair_sz);
+
+	cache->levels[level] = (ctx_cache_level){
+			.end = start + pair_sz,
+			.data_offset = ctx->data_offset,
+			.data_sz = ctx->data_sz
+	};
+
+	cache->n_levels++;
+}
+
 bool
 cdt_context_read_check_peek(const msgpack_in_vec *ctx)
 {
@@ -2292,6 +2397,9 @@ static int
 cdt_packed_modify(cdt_process_state *state, as_bin *b, as_bin *result,
 		cf_ll_buf *particles_llb, bool alloc_ns)
 {
+	// Old particle may be freed, and its memory reused by later ops.
+	as_bin_cdt_ctx_cache_reset();
+
 	define_rollback_alloc(alloc_buf, particles_llb, 1, alloc_ns);
 	define_rollback_alloc(alloc_result, NULL, 1, false); // results always on the heap
 	define_rollback_alloc(alloc_idx, NULL, 8, false); // for temp indexes
@@ -2337,7 +2445,7 @@ cdt_packed_modify(cdt_process_state *state, as_bin *b, as_bin *result,
 
 static int
 cdt_packed_read(cdt_process_state *state, const as_bin *b, as_bin *result,
-		bool alloc_ns)
+		bool alloc_ns, bool use_ctx_cache)
 {
 	define_rollback_alloc(alloc_result, NULL, 1, alloc_ns); // results always on the heap
 	define_rollback_alloc(alloc_idx, NULL, 8, false); // for temp indexes
@@ -2345,7 +2453,8 @@ cdt_packed_read(cdt_process_state *state, const as_bin *b, as_bin *result,
 	cdt_op_mem com = {
 			.ctx = {
 					.b = (as_bin *)b,
-					.alloc_buf = NULL
+					.alloc_buf = NULL,
+					.use_ctx_cache = use_ctx_cache
 			},
 			.result = {
 					.result = result,
@@ -2419,7 +2528,14 @@ as_bin_cdt_read_tr(const as_bin *b, const as_msg_op *op, as_bin *result)
 		return -AS_ERR_PARAMETER;
 	}
 
-	return cdt_packed_read(&state, b, result, false);
+	return cdt_packed_read(&state, b, result, false, true);
+}
+
+// Call before each transaction's ops loop.
+void
+as_bin_cdt_ctx_cache_reset(void)
+{
+	g_ctx_cache.particle = NULL;
 }
 
 int
@@ -2445,7 +2561,7 @@ as_bin_cdt_read_exp(const as_bin *b, msgpack_in_vec* mv, as_bin *result,
 		return -AS_ERR_PARAMETER;
 	}
 
-	return cdt_packed_read(&state, b, result, alloc_ns);
+	return cdt_packed_read(&state, b, result, alloc_ns, false);
 }
 
 bool
@@ -63,10 +63,13 @@
 #include "xmem.h"
 
 #include "base/datamodel.h"
+#include "base/device_heat.h"
+#include "base/hot_keys.h"
 #include "base/index.h"
 #include "base/proto.h"
 #include "base/security_config.h"
 #include "base/service.h"
+#include "base/slow_log.h"
 #include "base/stats.h"
 #include "base/thr_info.h"
 #include "base/thr_info_port.h"
@@ -157,11 +160,15 @@ cfg_set_defaults()
 
 	c->uid = (uid_t)-1;
 	c->gid = (gid_t)-1;
+	c->hist_significant_digits = 1;
 	c->n_proto_fd_max = 15000;
+	c->proto_capture_redact_values = true;
+	c->background_dispatch_ratio = 4;
 	c->batch_max_buffers_per_queue = 255; // maximum number of buffers allowed in a single queue
 	c->batch_max_requests = 5000; // maximum requests/digests in a single batch
 	c->batch_max_unused_buffers = 256; // maximum number of buffers allowed in batch buffer pool
 	c->feature_key_files[0] = "/etc/aerospike/features.conf";
+	c->n_index_tree_gc_threads = 1;
 	c->n_info_threads = 16;
 	c->migrate_max_num_incoming = AS_MIGRATE_DEFAULT_MAX_NUM_INCOMING; // for receiver-side migration flow-control
 	c->n_migrate_threads = 1;
@@ -170,8 +177,10 @@ cfg_set_defaults()
 	c->n_query_threads_limit = 128;
 	c->run_as_daemon = true; // set false only to run in debugger & see console output
 	c->sindex_builder_threads = 4;
+	c->sindex_gc_max_lock_us = 1000;
 	c->sindex_gc_period = 10; // every 10 seconds
 	c->ticker_interval = 10;
+	c->n_tls_handshake_threads = 4;
 	c->transaction_max_ns = 1000 * 1000 * 1000; // 1 second
 	c->transaction_retry_ms = 1000 + 2; // 1 second + epsilon, so default timeout happens first
 	c->work_directory = "/opt/aerospike";
@@ -257,10 +266,12 @@ typedef enum {
 	// Service options:
 	CASE_SERVICE_ADVERTISE_IPV6,
 	CASE_SERVICE_AUTO_PIN,
+	CASE_SERVICE_BACKGROUND_DISPATCH_RATIO,
 	CASE_SERVICE_BATCH_INDEX_THREADS,
 	CASE_SERVICE_BATCH_MAX_BUFFERS_PER_QUEUE,
 	CASE_SERVICE_BATCH_MAX_REQUESTS,
 	CASE_SERVICE_BATCH_MAX_UNUSED_BUFFERS,
+	CASE_SERVICE_BUSY_POLL_US,
 	CASE_SERVICE_CLUSTER_NAME,
 	CASE_SERVICE_DEBUG_ALLOCATIONS,
 	CASE_SERVICE_DISABLE_UDF_EXECUTION,
@@ -270,12 +281,17 @@ typedef enum {
 	CASE_SERVICE_ENFORCE_BEST_PRACTICES,
 	CASE_SERVICE_FEATURE_KEY_FILE,
 	CASE_SERVICE_GROUP,
+	CASE_SERVICE_HISTOGRAM_SIGNIFICANT_DIGITS,
 	CASE_SERVICE_INDENT_ALLOCATIONS,
+	CASE_SERVICE_INDEX_TREE_GC_MAX_RATE,
+	CASE_SERVICE_INDEX_TREE_GC_THREADS,
+	CASE_SERVICE_INFO_CACHE_MS,
 	CASE_SERVICE_INFO_THREADS,
 	CASE_SERVICE_KEEP_CAPS_SSD_HEALTH,
 	CASE_SERVICE_LOG_LOCAL_TIME,
 	CASE_SERVICE_LOG_MILLIS,
 	CASE_SERVICE_MICROSECOND_HISTOGRAMS,
+	CASE_SERVICE_MIGRATE_COMPRESSION_LEVEL,
 	CASE_SERVICE_MIGRATE_FILL_DELAY,
 	CASE_SERVICE_MIGRATE_MAX_NUM_INCOMING,
 	CASE_SERVICE_MIGRATE_THREADS,
@@ -284,17 +300,25 @@ typedef enum {
 	CASE_SERVICE_NODE_ID_INTERFACE,
 	CASE_SERVICE_OS_GROUP_PERMS,
 	CASE_SERVICE_PIDFILE,
+	CASE_SERVICE_PROFILE_SAMPLE_RATE,
+	CASE_SERVICE_PROTO_CAPTURE_REDACT_VALUES,
+	CASE_SERVICE_PROTO_CAPTURE_SAMPLE_PERIOD,
 	CASE_SERVICE_PROTO_FD_IDLE_MS,
 	CASE_SERVICE_PROTO_FD_MAX,
 	CASE_SERVICE_QUERY_MAX_DONE,
+	CASE_SERVICE_QUERY_MAX_RPS,
 	CASE_SERVICE_QUERY_THREADS_LIMIT,
 	CASE_SERVICE_RUN_AS_DAEMON,
 	CASE_SERVICE_SALT_ALLOCATIONS,
 	CASE_SERVICE_SERVICE_THREADS,
 	CASE_SERVICE_SINDEX_BUILDER_THREADS,
+	CASE_SERVICE_SINDEX_GC_MAX_LOCK_US,
 	CASE_SERVICE_SINDEX_GC_PERIOD,
+	CASE_SERVICE_SLOW_TRANSACTION_LOG_SIZE,
+	CASE_SERVICE_STATS_SNAPSHOT_PERIOD,
 	CASE_SERVICE_STAY_QUIESCED,
 	CASE_SERVICE_TICKER_INTERVAL,
+	CASE_SERVICE_TLS_HANDSHAKE_THREADS,
 	CASE_SERVICE_TRANSACTION_MAX_MS,
 	CASE_SERVICE_TRANSACTION_RETRY_MS,
 	CASE_SERVICE_USER,
@@ -395,12 +419,16 @@ typedef enum {
 	// Network fabric options:
 	CASE_NETWORK_FABRIC_ADDRESS,
 	CASE_NETWORK_FABRIC_CHANNEL_BULK_FDS,
+	CASE_NETWORK_FABRIC_CHANNEL_BULK_FDS_MAX,
 	CASE_NETWORK_FABRIC_CHANNEL_BULK_RECV_THREADS,
+	CASE_NETWORK_FABRIC_CHANNEL_BULK_SEND_MAX_MB,
 	CASE_NETWORK_FABRIC_CHANNEL_CTRL_FDS,
 	CASE_NETWORK_FABRIC_CHANNEL_CTRL_RECV_THREADS,
 	CASE_NETWORK_FABRIC_CHANNEL_META_FDS,
 	CASE_NETWORK_FABRIC_CHANNEL_META_RECV_THREADS,
+	CASE_NETWORK_FABRIC_CHANNEL_RW_BUSY_POLL_US,
 	CASE_NETWORK_FABRIC_CHANNEL_RW_FDS,
+	CASE_NETWORK_FABRIC_CHANNEL_RW_FDS_MAX,
 	CASE_NETWORK_FABRIC_CHANNEL_RW_RECV_POOLS,
 	CASE_NETWORK_FABRIC_CHANNEL_RW_RECV_THREADS,
 	CASE_NETWORK_FABRIC_KEEPALIVE_ENABLED,
@@ -432,6 +460,7 @@ typedef enum {
 	// Namespace options:
 	CASE_NAMESPACE_ALLOW_TTL_WITHOUT_NSUP,
 	CASE_NAMESPACE_BACKGROUND_QUERY_MAX_RPS,
+	CASE_NAMESPACE_BATCH_INDEX_PREFETCH,
 	CASE_NAMESPACE_CONFLICT_RESOLUTION_POLICY,
 	CASE_NAMESPACE_CONFLICT_RESOLVE_WRITES,
 	CASE_NAMESPACE_DATA_IN_INDEX,
@@ -447,26 +476,44 @@ typedef enum {
 	CASE_NAMESPACE_ENABLE_BENCHMARKS_WRITE,
 	CASE_NAMESPACE_ENABLE_HIST_PROXY,
 	CASE_NAMESPACE_EVICT_HIST_BUCKETS,
+	CASE_NAMESPACE_EVICT_SAMPLE_PCT,
 	CASE_NAMESPACE_EVICT_TENTHS_PCT,
 	CASE_NAMESPACE_HIGH_WATER_DISK_PCT,
 	CASE_NAMESPACE_HIGH_WATER_MEMORY_PCT,
+	CASE_NAMESPACE_HOT_KEY_SAMPLE_PERIOD,
 	CASE_NAMESPACE_IGNORE_MIGRATE_FILL_DELAY,
+	CASE_NAMESPACE_INDEX_COMPACT_ENTRIES,
+	CASE_NAMESPACE_INDEX_STAGE_HUGE_PAGES,
+	CASE_NAMESPACE_INDEX_STAGE_INTERLEAVE,
 	CASE_NAMESPACE_INDEX_STAGE_SIZE,
 	CASE_NAMESPACE_MAX_RECORD_SIZE,
+	CASE_NAMESPACE_MEMORY_DEFRAG_LWM_PCT,
+	CASE_NAMESPACE_MEMORY_DEFRAG_PERIOD,
 	CASE_NAMESPACE_MEMORY_SIZE,
+	CASE_NAMESPACE_MEMORY_SNAPSHOT_FILE,
 	CASE_NAMESPACE_MIGRATE_ORDER,
 	CASE_NAMESPACE_MIGRATE_RETRANSMIT_MS,
 	CASE_NAMESPACE_MIGRATE_SLEEP,
+	CASE_NAMESPACE_NSUP_EXPIRE_INDEX,
 	CASE_NAMESPACE_NSUP_HIST_PERIOD,
 	CASE_NAMESPACE_NSUP_PERIOD,
+	CASE_NAMESPACE_NSUP_SINGLE_PASS,
 	CASE_NAMESPACE_NSUP_THREADS,
+	CASE_NAMESPACE_OPTIMISTIC_READS,
+	CASE_NAMESPACE_PARTITION_TREE_BLOOM_SIZE,
 	CASE_NAMESPACE_PARTITION_TREE_SPRIGS,
 	CASE_NAMESPACE_PREFER_UNIFORM_BALANCE,
+	CASE_NAMESPACE_QUERY_RESULT_CACHE_SIZE,
 	CASE_NAMESPACE_RACK_ID,
 	CASE_NAMESPACE_READ_CONSISTENCY_LEVEL_OVERRIDE,
+	CASE_NAMESPACE_READ_STEER_DEVICE_OUTLIERS,
 	CASE_NAMESPACE_REJECT_NON_XDR_WRITES,
 	CASE_NAMESPACE_REJECT_XDR_WRITES,
 	CASE_NAMESPACE_REPLICATION_FACTOR,
+	CASE_NAMESPACE_SERVICE_THREAD_CPUS,
+	CASE_NAMESPACE_SERVICE_THREADS,
+	CASE_NAMESPACE_SINDEX_FLASH_DIR,
+	CASE_NAMESPACE_SINDEX_ORDERED_STRINGS,
 	CASE_NAMESPACE_SINDEX_STAGE_SIZE,
 	CASE_NAMESPACE_SINGLE_BIN,
 	CASE_NAMESPACE_SINGLE_QUERY_THREADS,
@@ -476,6 +523,8 @@ typedef enum {
 	CASE_NAMESPACE_TOMB_RAIDER_ELIGIBLE_AGE,
 	CASE_NAMESPACE_TOMB_RAIDER_PERIOD,
 	CASE_NAMESPACE_TRANSACTION_PENDING_LIMIT,
+	CASE_NAMESPACE_TRUNCATE_LATENCY_MS,
+	CASE_NAMESPACE_TRUNCATE_MAX_RATE,
 	CASE_NAMESPACE_TRUNCATE_THREADS,
 	CASE_NAMESPACE_WRITE_COMMIT_LEVEL_OVERRIDE,
 	CASE_NAMESPACE_XDR_BIN_TOMBSTONE_TTL,
@@ -548,36 +597,57 @@ typedef enum {
 	CASE_NAMESPACE_STORAGE_PMEM_TOMB_RAIDER_SLEEP,
 
 	// Namespace storage-engine device options:
+	CASE_NAMESPACE_STORAGE_DEVICE_BACKGROUND_READ_DEPTH,
 	CASE_NAMESPACE_STORAGE_DEVICE_CACHE_REPLICA_WRITES,
+	CASE_NAMESPACE_STORAGE_DEVICE_COALESCE_BATCH_READS,
 	CASE_NAMESPACE_STORAGE_DEVICE_COLD_START_EMPTY,
+	CASE_NAMESPACE_STORAGE_DEVICE_COLD_START_THREADS,
 	CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_TO_DEVICE,
 	CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_MIN_SIZE,
+	CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_WINDOW_US,
 	CASE_NAMESPACE_STORAGE_DEVICE_COMPRESSION,
 	CASE_NAMESPACE_STORAGE_DEVICE_COMPRESSION_LEVEL,
 	CASE_NAMESPACE_STORAGE_DEVICE_DATA_IN_MEMORY,
+	CASE_NAMESPACE_STORAGE_DEVICE_DAX_MAP,
 	CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_LWM_PCT,
 	CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_QUEUE_MIN,
 	CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_SLEEP,
 	CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_STARTUP_MINIMUM,
+	CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_TARGET_READ_US,
 	CASE_NAMESPACE_STORAGE_DEVICE_DEVICE,
 	CASE_NAMESPACE_STORAGE_DEVICE_DIRECT_FILES,
 	CASE_NAMESPACE_STORAGE_DEVICE_DISABLE_ODSYNC,
 	CASE_NAMESPACE_STORAGE_DEVICE_ENABLE_BENCHMARKS_STORAGE,
+	CASE_NAMESPACE_STORAGE_DEVICE_ENABLE_LATENCY_MAP,
 	CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION,
 	CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION_KEY_FILE,
 	CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION_OLD_KEY_FILE,
 	CASE_NAMESPACE_STORAGE_DEVICE_FILE,
 	CASE_NAMESPACE_STORAGE_DEVICE_FILESIZE,
 	CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MAX_MS,
+	CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MAX_DEFER_MS,
+	CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MIN_FILL_PCT,
+	CASE_NAMESPACE_STORAGE_DEVICE_INDEX_SNAPSHOT_FILE,
+	CASE_NAMESPACE_STORAGE_DEVICE_LARGE_RECORD_STREAM_SIZE,
 	CASE_NAMESPACE_STORAGE_DEVICE_MAX_WRITE_CACHE,
 	CASE_NAMESPACE_STORAGE_DEVICE_MIN_AVAIL_PCT,
+	CASE_NAMESPACE_STORAGE_DEVICE_NUMA_LOCAL_WRITE_BUFFERS,
 	CASE_NAMESPACE_STORAGE_DEVICE_POST_WRITE_QUEUE,
+	CASE_NAMESPACE_STORAGE_DEVICE_READ_CACHE_SIZE,
+	CASE_NAMESPACE_STORAGE_DEVICE_READ_IO_URING,
+	CASE_NAMESPACE_STORAGE_DEVICE_READ_OFFLOAD_US,
 	CASE_NAMESPACE_STORAGE_DEVICE_READ_PAGE_CACHE,
+	CASE_NAMESPACE_STORAGE_DEVICE_RECORD_CHECKSUMS,
+	CASE_NAMESPACE_STORAGE_DEVICE_SCAN_DEVICE_ORDER,
 	CASE_NAMESPACE_STORAGE_DEVICE_SCHEDULER_MODE,
 	CASE_NAMESPACE_STORAGE_DEVICE_SERIALIZE_TOMB_RAIDER,
+	CASE_NAMESPACE_STORAGE_DEVICE_SHADOW_MAX_LAG,
+	CASE_NAMESPACE_STORAGE_DEVICE_SHED_LOW_PRIORITY_PCT,
 	CASE_NAMESPACE_STORAGE_DEVICE_SINDEX_STARTUP_DEVICE_SCAN,
 	CASE_NAMESPACE_STORAGE_DEVICE_TOMB_RAIDER_SLEEP,
+	CASE_NAMESPACE_STORAGE_DEVICE_TTL_WRITE_STREAMS,
 	CASE_NAMESPACE_STORAGE_DEVICE_WRITE_BLOCK_SIZE,
+	CASE_NAMESPACE_STORAGE_DEVICE_WRITE_LIFETIME_HINTS,
 	// Obsoleted:
 	CASE_NAMESPACE_STORAGE_DEVICE_DISABLE_ODIRECT,
 	CASE_NAMESPACE_STORAGE_DEVICE_FSYNC_MAX_SEC,
@@ -594,6 +664,7 @@ typedef enum {
 
 	// Namespace set options:
 	CASE_NAMESPACE_SET_DISABLE_EVICTION,
+	CASE_NAMESPACE_SET_ENABLE_HISTOGRAMS,
 	CASE_NAMESPACE_SET_ENABLE_INDEX,
 	CASE_NAMESPACE_SET_STOP_WRITES_COUNT,
 
@@ -748,10 +819,12 @@ const cfg_opt GLOBAL_OPTS[] = {
 const cfg_opt SERVICE_OPTS[] = {
 		{ "advertise-ipv6",					CASE_SERVICE_ADVERTISE_IPV6 },
 		{ "auto-pin",						CASE_SERVICE_AUTO_PIN },
+		{ "background-dispatch-ratio",		CASE_SERVICE_BACKGROUND_DISPATCH_RATIO },
 		{ "batch-index-threads",			CASE_SERVICE_BATCH_INDEX_THREADS },
 		{ "batch-max-buffers-per-queue",	CASE_SERVICE_BATCH_MAX_BUFFERS_PER_QUEUE },
 		{ "batch-max-requests",				CASE_SERVICE_BATCH_MAX_REQUESTS },
 		{ "batch-max-unused-buffers",		CASE_SERVICE_BATCH_MAX_UNUSED_BUFFERS },
+		{ "busy-poll-us",					CASE_SERVICE_BUSY_POLL_US },
 		{ "cluster-name",					CASE_SERVICE_CLUSTER_NAME },
 		{ "debug-allocations",				CASE_SERVICE_DEBUG_ALLOCATIONS },
 		{ "disable-udf-execution",			CASE_SERVICE_DISABLE_UDF_EXECUTION },
@@ -761,12 +834,17 @@ const cfg_opt SERVICE_OPTS[] = {
 		{ "enforce-best-practices",			CASE_SERVICE_ENFORCE_BEST_PRACTICES },
 		{ "feature-key-file",				CASE_SERVICE_FEATURE_KEY_FILE },
 		{ "group",							CASE_SERVICE_GROUP },
+		{ "histogram-significant-digits",	CASE_SERVICE_HISTOGRAM_SIGNIFICANT_DIGITS },
 		{ "indent-allocations",				CASE_SERVICE_INDENT_ALLOCATIONS },
+		{ "index-tree-gc-max-rate",			CASE_SERVICE_INDEX_TREE_GC_MAX_RATE },
+		{ "index-tree-gc-threads",			CASE_SERVICE_INDEX_TREE_GC_THREADS },
+		{ "info-cache-ms",					CASE_SERVICE_INFO_CACHE_MS },
 		{ "info-threads",					CASE_SERVICE_INFO_THREADS },
 		{ "keep-caps-ssd-health",			CASE_SERVICE_KEEP_CAPS_SSD_HEALTH },
 		{ "log-local-time",					CASE_SERVICE_LOG_LOCAL_TIME },
 		{ "log-millis",						CASE_SERVICE_LOG_MILLIS},
 		{ "microsecond-histograms",			CASE_SERVICE_MICROSECOND_HISTOGRAMS },
+		{ "migrate-compression-level",		CASE_SERVICE_MIGRATE_COMPRESSION_LEVEL },
 		{ "migrate-fill-delay",				CASE_SERVICE_MIGRATE_FILL_DELAY },
 		{ "migrate-max-num-incoming",		CASE_SERVICE_MIGRATE_MAX_NUM_INCOMING },
 		{ "migrate-threads",				CASE_SERVICE_MIGRATE_THREADS },
@@ -775,17 +853,25 @@ const cfg_opt SERVICE_OPTS[] = {
 		{ "node-id-interface",				CASE_SERVICE_NODE_ID_INTERFACE },
 		{ "os-group-perms",					CASE_SERVICE_OS_GROUP_PERMS },
 		{ "pidfile",						CASE_SERVICE_PIDFILE },
+		{ "profile-sample-rate",			CASE_SERVICE_PROFILE_SAMPLE_RATE },
+		{ "proto-capture-redact-values",	CASE_SERVICE_PROTO_CAPTURE_REDACT_VALUES },
+		{ "proto-capture-sample-period",	CASE_SERVICE_PROTO_CAPTURE_SAMPLE_PERIOD },
 		{ "proto-fd-idle-ms",				CASE_SERVICE_PROTO_FD_IDLE_MS },
 		{ "proto-fd-max",					CASE_SERVICE_PROTO_FD_MAX },
 		{ "query-max-done",					CASE_SERVICE_QUERY_MAX_DONE },
+		{ "query-max-rps",					CASE_SERVICE_QUERY_MAX_RPS },
 		{ "query-threads-limit",			CASE_SERVICE_QUERY_THREADS_LIMIT },
 		{ "run-as-daemon",					CASE_SERVICE_RUN_AS_DAEMON },
 		{ "salt-allocations",				CASE_SERVICE_SALT_ALLOCATIONS },
 		{ "service-threads",				CASE_SERVICE_SERVICE_THREADS },
 		{ "sindex-builder-threads",			CASE_SERVICE_SINDEX_BUILDER_THREADS },
+		{ "sindex-gc-max-lock-us",			CASE_SERVICE_SINDEX_GC_MAX_LOCK_US },
 		{ "sindex-gc-period",				CASE_SERVICE_SINDEX_GC_PERIOD },
+		{ "slow-transaction-log-size",		CASE_SERVICE_SLOW_TRANSACTION_LOG_SIZE },
+		{ "stats-snapshot-period",			CASE_SERVICE_STATS_SNAPSHOT_PERIOD },
 		{ "stay-quiesced",					CASE_SERVICE_STAY_QUIESCED },
 		{ "ticker-interval",				CASE_SERVICE_TICKER_INTERVAL },
+		{ "tls-handshake-threads",			CASE_SERVICE_TLS_HANDSHAKE_THREADS },
 		{ "transaction-max-ms",				CASE_SERVICE_TRANSACTION_MAX_MS },
 		{ "transaction-retry-ms",			CASE_SERVICE_TRANSACTION_RETRY_MS },
 		{ "user",							CASE_SERVICE_USER },
@@ -902,12 +988,16 @@ const cfg_opt NETWORK_HEARTBEAT_PROTOCOL_OPTS[] = {
 const cfg_opt NETWORK_FABRIC_OPTS[] = {
 		{ "address",						CASE_NETWORK_FABRIC_ADDRESS },
 		{ "channel-bulk-fds",				CASE_NETWORK_FABRIC_CHANNEL_BULK_FDS },
+		{ "channel-bulk-fds-max",			CASE_NETWORK_FABRIC_CHANNEL_BULK_FDS_MAX },
 		{ "channel-bulk-recv-threads",		CASE_NETWORK_FABRIC_CHANNEL_BULK_RECV_THREADS },
+		{ "channel-bulk-send-max-mb",		CASE_NETWORK_FABRIC_CHANNEL_BULK_SEND_MAX_MB },
 		{ "channel-ctrl-fds",				CASE_NETWORK_FABRIC_CHANNEL_CTRL_FDS },
 		{ "channel-ctrl-recv-threads",		CASE_NETWORK_FABRIC_CHANNEL_CTRL_RECV_THREADS },
 		{ "channel-meta-fds",				CASE_NETWORK_FABRIC_CHANNEL_META_FDS },
 		{ "channel-meta-recv-threads",		CASE_NETWORK_FABRIC_CHANNEL_META_RECV_THREADS },
+		{ "channel-rw-busy-poll-us",		CASE_NETWORK_FABRIC_CHANNEL_RW_BUSY_POLL_US },
 		{ "channel-rw-fds",					CASE_NETWORK_FABRIC_CHANNEL_RW_FDS },
+		{ "channel-rw-fds-max",				CASE_NETWORK_FABRIC_CHANNEL_RW_FDS_MAX },
 		{ "channel-rw-recv-pools",			CASE_NETWORK_FABRIC_CHANNEL_RW_RECV_POOLS },
 		{ "channel-rw-recv-threads",		CASE_NETWORK_FABRIC_CHANNEL_RW_RECV_THREADS },
 		{ "keepalive-enabled",				CASE_NETWORK_FABRIC_KEEPALIVE_ENABLED },
@@ -945,6 +1035,7 @@ const cfg_opt NETWORK_TLS_OPTS[] = {
 const cfg_opt NAMESPACE_OPTS[] = {
 		{ "allow-ttl-without-nsup",			CASE_NAMESPACE_ALLOW_TTL_WITHOUT_NSUP },
 		{ "background-query-max-rps",		CASE_NAMESPACE_BACKGROUND_QUERY_MAX_RPS },
+		{ "batch-index-prefetch",			CASE_NAMESPACE_BATCH_INDEX_PREFETCH },
 		{ "conflict-resolution-policy",		CASE_NAMESPACE_CONFLICT_RESOLUTION_POLICY },
 		{ "conflict-resolve-writes",		CASE_NAMESPACE_CONFLICT_RESOLVE_WRITES },
 		{ "data-in-index",					CASE_NAMESPACE_DATA_IN_INDEX },
@@ -960,26 +1051,44 @@ const cfg_opt NAMESPACE_OPTS[] = {
 		{ "enable-benchmarks-write",		CASE_NAMESPACE_ENABLE_BENCHMARKS_WRITE },
 		{ "enable-hist-proxy",				CASE_NAMESPACE_ENABLE_HIST_PROXY },
 		{ "evict-hist-buckets",				CASE_NAMESPACE_EVICT_HIST_BUCKETS },
+		{ "evict-sample-pct",				CASE_NAMESPACE_EVICT_SAMPLE_PCT },
 		{ "evict-tenths-pct",				CASE_NAMESPACE_EVICT_TENTHS_PCT },
 		{ "high-water-disk-pct",			CASE_NAMESPACE_HIGH_WATER_DISK_PCT },
 		{ "high-water-memory-pct",			CASE_NAMESPACE_HIGH_WATER_MEMORY_PCT },
+		{ "hot-key-sample-period",			CASE_NAMESPACE_HOT_KEY_SAMPLE_PERIOD },
 		{ "ignore-migrate-fill-delay",		CASE_NAMESPACE_IGNORE_MIGRATE_FILL_DELAY },
+		{ "index-compact-entries",			CASE_NAMESPACE_INDEX_COMPACT_ENTRIES },
+		{ "index-stage-huge-pages",			CASE_NAMESPACE_INDEX_STAGE_HUGE_PAGES },
+		{ "index-stage-interleave",			CASE_NAMESPACE_INDEX_STAGE_INTERLEAVE },
 		{ "index-stage-size",				CASE_NAMESPACE_INDEX_STAGE_SIZE },
 		{ "max-record-size",				CASE_NAMESPACE_MAX_RECORD_SIZE },
+		{ "memory-defrag-lwm-pct",			CASE_NAMESPACE_MEMORY_DEFRAG_LWM_PCT },
+		{ "memory-defrag-period",			CASE_NAMESPACE_MEMORY_DEFRAG_PERIOD },
 		{ "memory-size",					CASE_NAMESPACE_MEMORY_SIZE },
+		{ "memory-snapshot-file",			CASE_NAMESPACE_MEMORY_SNAPSHOT_FILE },
 		{ "migrate-order",					CASE_NAMESPACE_MIGRATE_ORDER },
 		{ "migrate-retransmit-ms",			CASE_NAMESPACE_MIGRATE_RETRANSMIT_MS },
 		{ "migrate-sleep",					CASE_NAMESPACE_MIGRATE_SLEEP },
+		{ "nsup-expire-index",				CASE_NAMESPACE_NSUP_EXPIRE_INDEX },
 		{ "nsup-hist-period",				CASE_NAMESPACE_NSUP_HIST_PERIOD },
 		{ "nsup-period",					CASE_NAMESPACE_NSUP_PERIOD },
+		{ "nsup-single-pass",				CASE_NAMESPACE_NSUP_SINGLE_PASS },
 		{ "nsup-threads",					CASE_NAMESPACE_NSUP_THREADS },
+		{ "optimistic-reads",				CASE_NAMESPACE_OPTIMISTIC_READS },
+		{ "partition-tree-bloom-size",		CASE_NAMESPACE_PARTITION_TREE_BLOOM_SIZE },
 		{ "partition-tree-sprigs",			CASE_NAMESPACE_PARTITION_TREE_SPRIGS },
 		{ "prefer-uniform-balance",			CASE_NAMESPACE_PREFER_UNIFORM_BALANCE },
+		{ "query-result-cache-size",		CASE_NAMESPACE_QUERY_RESULT_CACHE_SIZE },
 		{ "rack-id",						CASE_NAMESPACE_RACK_ID },
 		{ "read-consistency-level-override", CASE_NAMESPACE_READ_CONSISTENCY_LEVEL_OVERRIDE },
+		{ "read-steer-device-outliers",		CASE_NAMESPACE_READ_STEER_DEVICE_OUTLIERS },
 		{ "reject-non-xdr-writes",			CASE_NAMESPACE_REJECT_NON_XDR_WRITES },
 		{ "reject-xdr-writes",				CASE_NAMESPACE_REJECT_XDR_WRITES },
 		{ "replication-factor",				CASE_NAMESPACE_REPLICATION_FACTOR },
+		{ "service-thread-cpus",			CASE_NAMESPACE_SERVICE_THREAD_CPUS },
+		{ "service-threads",				CASE_NAMESPACE_SERVICE_THREADS },
+		{ "sindex-flash-dir",				CASE_NAMESPACE_SINDEX_FLASH_DIR },
+		{ "sindex-ordered-strings",			CASE_NAMESPACE_SINDEX_ORDERED_STRINGS },
 		{ "sindex-stage-size",				CASE_NAMESPACE_SINDEX_STAGE_SIZE },
 		{ "single-bin",						CASE_NAMESPACE_SINGLE_BIN },
 		{ "single-query-threads",			CASE_NAMESPACE_SINGLE_QUERY_THREADS },
@@ -989,6 +1098,8 @@ const cfg_opt NAMESPACE_OPTS[] = {
 		{ "tomb-raider-eligible-age",		CASE_NAMESPACE_TOMB_RAIDER_ELIGIBLE_AGE },
 		{ "tomb-raider-period",				CASE_NAMESPACE_TOMB_RAIDER_PERIOD },
 		{ "transaction-pending-limit",		CASE_NAMESPACE_TRANSACTION_PENDING_LIMIT },
+		{ "truncate-latency-ms",			CASE_NAMESPACE_TRUNCATE_LATENCY_MS },
+		{ "truncate-max-rate",				CASE_NAMESPACE_TRUNCATE_MAX_RATE },
 		{ "truncate-threads",				CASE_NAMESPACE_TRUNCATE_THREADS },
 		{ "write-commit-level-override",	CASE_NAMESPACE_WRITE_COMMIT_LEVEL_OVERRIDE },
 		{ "xdr-bin-tombstone-ttl",			CASE_NAMESPACE_XDR_BIN_TOMBSTONE_TTL },
@@ -1074,36 +1185,57 @@ const cfg_opt NAMESPACE_STORAGE_PMEM_OPTS[] = {
 };
 
 const cfg_opt NAMESPACE_STORAGE_DEVICE_OPTS[] = {
+		{ "background-read-depth",			CASE_NAMESPACE_STORAGE_DEVICE_BACKGROUND_READ_DEPTH },
 		{ "cache-replica-writes",			CASE_NAMESPACE_STORAGE_DEVICE_CACHE_REPLICA_WRITES },
+		{ "coalesce-batch-reads",			CASE_NAMESPACE_STORAGE_DEVICE_COALESCE_BATCH_READS },
 		{ "cold-start-empty",				CASE_NAMESPACE_STORAGE_DEVICE_COLD_START_EMPTY },
+		{ "cold-start-threads",				CASE_NAMESPACE_STORAGE_DEVICE_COLD_START_THREADS },
 		{ "commit-to-device",				CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_TO_DEVICE },
 		{ "commit-min-size",				CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_MIN_SIZE },
+		{ "commit-window-us",				CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_WINDOW_US },
 		{ "compression",					CASE_NAMESPACE_STORAGE_DEVICE_COMPRESSION },
 		{ "compression-level",				CASE_NAMESPACE_STORAGE_DEVICE_COMPRESSION_LEVEL },
 		{ "data-in-memory",					CASE_NAMESPACE_STORAGE_DEVICE_DATA_IN_MEMORY },
+		{ "dax-map",						CASE_NAMESPACE_STORAGE_DEVICE_DAX_MAP },
 		{ "defrag-lwm-pct",					CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_LWM_PCT },
 		{ "defrag-queue-min",				CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_QUEUE_MIN },
 		{ "defrag-sleep",					CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_SLEEP },
 		{ "defrag-startup-minimum",			CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_STARTUP_MINIMUM },
+		{ "defrag-target-read-us",			CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_TARGET_READ_US },
 		{ "device",							CASE_NAMESPACE_STORAGE_DEVICE_DEVICE },
 		{ "direct-files",					CASE_NAMESPACE_STORAGE_DEVICE_DIRECT_FILES },
 		{ "disable-odsync",					CASE_NAMESPACE_STORAGE_DEVICE_DISABLE_ODSYNC },
 		{ "enable-benchmarks-storage",		CASE_NAMESPACE_STORAGE_DEVICE_ENABLE_BENCHMARKS_STORAGE },
+		{ "enable-latency-map",				CASE_NAMESPACE_STORAGE_DEVICE_ENABLE_LATENCY_MAP },
 		{ "encryption",						CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION },
 		{ "encryption-key-file",			CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION_KEY_FILE },
 		{ "encryption-old-key-file",		CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION_OLD_KEY_FILE },
 		{ "file",							CASE_NAMESPACE_STORAGE_DEVICE_FILE },
 		{ "filesize",						CASE_NAMESPACE_STORAGE_DEVICE_FILESIZE },
 		{ "flush-max-ms",					CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MAX_MS },
+		{ "flush-max-defer-ms",				CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MAX_DEFER_MS },
+		{ "flush-min-fill-pct",				CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MIN_FILL_PCT },
+		{ "index-snapshot-file",			CASE_NAMESPACE_STORAGE_DEVICE_INDEX_SNAPSHOT_FILE },
+		{ "large-record-stream-size",		CASE_NAMESPACE_STORAGE_DEVICE_LARGE_RECORD_STREAM_SIZE },
 		{ "max-write-cache",				CASE_NAMESPACE_STORAGE_DEVICE_MAX_WRITE_CACHE },
 		{ "min-avail-pct",					CASE_NAMESPACE_STORAGE_DEVICE_MIN_AVAIL_PCT },
+		{ "numa-local-write-buffers",		CASE_NAMESPACE_STORAGE_DEVICE_NUMA_LOCAL_WRITE_BUFFERS },
 		{ "post-write-queue",				CASE_NAMESPACE_STORAGE_DEVICE_POST_WRITE_QUEUE },
+		{ "read-cache-size",				CASE_NAMESPACE_STORAGE_DEVICE_READ_CACHE_SIZE },
+		{ "read-io-uring",				CASE_NAMESPACE_STORAGE_DEVICE_READ_IO_URING },
+		{ "read-offload-us",			CASE_NAMESPACE_STORAGE_DEVICE_READ_OFFLOAD_US },
 		{ "read-page-cache",				CASE_NAMESPACE_STORAGE_DEVICE_READ_PAGE_CACHE },
+		{ "record-checksums",				CASE_NAMESPACE_STORAGE_DEVICE_RECORD_CHECKSUMS },
+		{ "scan-device-order",				CASE_NAMESPACE_STORAGE_DEVICE_SCAN_DEVICE_ORDER },
 		{ "scheduler-mode",					CASE_NAMESPACE_STORAGE_DEVICE_SCHEDULER_MODE },
 		{ "serialize-tomb-raider",			CASE_NAMESPACE_STORAGE_DEVICE_SERIALIZE_TOMB_RAIDER },
+		{ "shadow-max-lag",					CASE_NAMESPACE_STORAGE_DEVICE_SHADOW_MAX_LAG },
+		{ "shed-low-priority-pct",			CASE_NAMESPACE_STORAGE_DEVICE_SHED_LOW_PRIORITY_PCT },
 		{ "sindex-startup-device-scan",		CASE_NAMESPACE_STORAGE_DEVICE_SINDEX_STARTUP_DEVICE_SCAN },
 		{ "tomb-raider-sleep",				CASE_NAMESPACE_STORAGE_DEVICE_TOMB_RAIDER_SLEEP },
+		{ "ttl-write-streams",				CASE_NAMESPACE_STORAGE_DEVICE_TTL_WRITE_STREAMS },
 		{ "write-block-size",				CASE_NAMESPACE_STORAGE_DEVICE_WRITE_BLOCK_SIZE },
+		{ "write-lifetime-hints",			CASE_NAMESPACE_STORAGE_DEVICE_WRITE_LIFETIME_HINTS },
 		// Obsoleted:
 		{ "disable-odirect",				CASE_NAMESPACE_STORAGE_DEVICE_DISABLE_ODIRECT },
 		{ "fsync-max-sec",					CASE_NAMESPACE_STORAGE_DEVICE_FSYNC_MAX_SEC },
@@ -1124,6 +1256,7 @@ const cfg_opt NAMESPACE_STORAGE_ENCRYPTION_OPTS[] = {
 
 const cfg_opt NAMESPACE_SET_OPTS[] = {
 		{ "disable-eviction",				CASE_NAMESPACE_SET_DISABLE_EVICTION },
+		{ "enable-histograms",				CASE_NAMESPACE_SET_ENABLE_HISTOGRAMS },
 		{ "enable-index",					CASE_NAMESPACE_SET_ENABLE_INDEX },
 		{ "stop-writes-count",				CASE_NAMESPACE_SET_STOP_WRITES_COUNT },
 		{ "}",								CASE_CONTEXT_END }
@@ -2167,6 +2300,9 @@ as_config_init(const char* config_file)
 					break;
 				}
 				break;
+			case CASE_SERVICE_BACKGROUND_DISPATCH_RATIO:
+				c->background_dispatch_ratio = cfg_u32_no_checks(&line);
+				break;
 			case CASE_SERVICE_BATCH_INDEX_THREADS:
 				c->n_batch_index_threads = cfg_u32(&line, 1, MAX_BATCH_THREADS);
 				break;
@@ -2179,6 +2315,9 @@ as_config_init(const char* config_file)
 			case CASE_SERVICE_BATCH_MAX_UNUSED_BUFFERS:
 				c->batch_max_unused_buffers = cfg_u32_no_checks(&line);
 				break;
+			case CASE_SERVICE_BUSY_POLL_US:
+				c->busy_poll_us = cfg_u32_no_checks(&line);
+				break;
 			case CASE_SERVICE_CLUSTER_NAME:
 				cfg_set_cluster_name(line.val_tok_1);
 				break;
@@ -2231,9 +2370,21 @@ as_config_init(const char* config_file)
 					endgrent();
 				}
 				break;
+			case CASE_SERVICE_HISTOGRAM_SIGNIFICANT_DIGITS:
+				c->hist_significant_digits = cfg_u32(&line, 1, 2);
+				break;
 			case CASE_SERVICE_INDENT_ALLOCATIONS:
 				c->indent_allocations = cfg_bool(&line);
 				break;
+			case CASE_SERVICE_INDEX_TREE_GC_MAX_RATE:
+				c->index_tree_gc_max_rate = cfg_u32_no_checks(&line);
+				break;
+			case CASE_SERVICE_INDEX_TREE_GC_THREADS:
+				c->n_index_tree_gc_threads = cfg_u32(&line, 1, MAX_INDEX_TREE_GC_THREADS);
+				break;
+			case CASE_SERVICE_INFO_CACHE_MS:
+				c->info_cache_ms = cfg_u32(&line, 0, 60000);
+				break;
 			case CASE_SERVICE_INFO_THREADS:
 				c->n_info_threads = cfg_u32(&line, 1, MAX_INFO_THREADS);
 				break;
@@ -2249,6 +2400,9 @@ as_config_init(const char* config_file)
 			case CASE_SERVICE_MICROSECOND_HISTOGRAMS:
 				c->microsecond_histograms = cfg_bool(&line);
 				break;
+			case CASE_SERVICE_MIGRATE_COMPRESSION_LEVEL:
+				c->migrate_compression_level = cfg_u32(&line, 0, 9);
+				break;
 			case CASE_SERVICE_MIGRATE_FILL_DELAY:
 				cfg_enterprise_only(&line);
 				c->migrate_fill_delay = cfg_seconds_no_checks(&line);
@@ -2274,6 +2428,15 @@ as_config_init(const char* config_file)
 			case CASE_SERVICE_PIDFILE:
 				c->pidfile = cfg_strdup_no_checks(&line);
 				break;
+			case CASE_SERVICE_PROFILE_SAMPLE_RATE:
+				c->profile_sample_rate = cfg_u32(&line, 0, MAX_PROFILE_SAMPLE_RATE);
+				break;
+			case CASE_SERVICE_PROTO_CAPTURE_REDACT_VALUES:
+				c->proto_capture_redact_values = cfg_bool(&line);
+				break;
+			case CASE_SERVICE_PROTO_CAPTURE_SAMPLE_PERIOD:
+				c->proto_capture_sample_period = cfg_u32_no_checks(&line);
+				break;
 			case CASE_SERVICE_PROTO_FD_IDLE_MS:
 				c->proto_fd_idle_ms = cfg_int_no_checks(&line);
 				break;
@@ -2283,6 +2446,9 @@ as_config_init(const char* config_file)
 			case CASE_SERVICE_QUERY_MAX_DONE:
 				c->query_max_done = cfg_u32(&line, 0, 10000);
 				break;
+			case CASE_SERVICE_QUERY_MAX_RPS:
+				c->query_max_rps = cfg_u32_no_checks(&line);
+				break;
 			case CASE_SERVICE_QUERY_THREADS_LIMIT:
 				c->n_query_threads_limit = cfg_u32(&line, 1, 1024);
 				break;
@@ -2298,9 +2464,18 @@ as_config_init(const char* config_file)
 			case CASE_SERVICE_SINDEX_BUILDER_THREADS:
 				c->sindex_builder_threads = cfg_u32(&line, 1, 32);
 				break;
+			case CASE_SERVICE_SINDEX_GC_MAX_LOCK_US:
+				c->sindex_gc_max_lock_us = cfg_u32_no_checks(&line);
+				break;
 			case CASE_SERVICE_SINDEX_GC_PERIOD:
 				c->sindex_gc_period = cfg_u32_no_checks(&line);
 				break;
+			case CASE_SERVICE_SLOW_TRANSACTION_LOG_SIZE:
+				c->slow_transaction_log_size = cfg_u32(&line, 0, MAX_SLOW_LOG_SIZE);
+				break;
+			case CASE_SERVICE_STATS_SNAPSHOT_PERIOD:
+				c->stats_snapshot_period = cfg_u32(&line, 0, 3600);
+				break;
 			case CASE_SERVICE_STAY_QUIESCED:
 				cfg_enterprise_only(&line);
 				c->stay_quiesced = cfg_bool(&line);
@@ -2308,6 +2483,9 @@ as_config_init(const char* config_file)
 			case CASE_SERVICE_TICKER_INTERVAL:
 				c->ticker_interval = cfg_u32_no_checks(&line);
 				break;
+			case CASE_SERVICE_TLS_HANDSHAKE_THREADS:
+				c->n_tls_handshake_threads = cfg_u32(&line, 0, MAX_TLS_HANDSHAKE_THREADS);
+				break;
 			case CASE_SERVICE_TRANSACTION_MAX_MS:
 				c->transaction_max_ns = cfg_u64_no_checks(&line) * 1000000;
 				break;
@@ -2646,9 +2824,15 @@ as_config_init(const char* config_file)
 			case CASE_NETWORK_FABRIC_CHANNEL_BULK_FDS:
 				c->n_fabric_channel_fds[AS_FABRIC_CHANNEL_BULK] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_SOCKETS);
 				break;
+			case CASE_NETWORK_FABRIC_CHANNEL_BULK_FDS_MAX:
+				c->n_fabric_channel_fds_max[AS_FABRIC_CHANNEL_BULK] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_SOCKETS);
+				break;
 			case CASE_NETWORK_FABRIC_CHANNEL_BULK_RECV_THREADS:
 				c->n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_BULK] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_THREADS);
 				break;
+			case CASE_NETWORK_FABRIC_CHANNEL_BULK_SEND_MAX_MB:
+				c->fabric_bulk_send_max_mb = cfg_u32_no_checks(&line);
+				break;
 			case CASE_NETWORK_FABRIC_CHANNEL_CTRL_FDS:
 				c->n_fabric_channel_fds[AS_FABRIC_CHANNEL_CTRL] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_SOCKETS);
 				break;
@@ -2661,9 +2845,15 @@ as_config_init(const char* config_file)
 			case CASE_NETWORK_FABRIC_CHANNEL_META_RECV_THREADS:
 				c->n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_META] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_THREADS);
 				break;
+			case CASE_NETWORK_FABRIC_CHANNEL_RW_BUSY_POLL_US:
+				c->fabric_rw_busy_poll_us = cfg_u32_no_checks(&line);
+				break;
 			case CASE_NETWORK_FABRIC_CHANNEL_RW_FDS:
 				c->n_fabric_channel_fds[AS_FABRIC_CHANNEL_RW] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_SOCKETS);
 				break;
+			case CASE_NETWORK_FABRIC_CHANNEL_RW_FDS_MAX:
+				c->n_fabric_channel_fds_max[AS_FABRIC_CHANNEL_RW] = cfg_u32(&line, 1, MAX_FABRIC_CHANNEL_SOCKETS);
+				break;
 			case CASE_NETWORK_FABRIC_CHANNEL_RW_RECV_POOLS:
 				c->n_fabric_channel_recv_pools[AS_FABRIC_CHANNEL_RW] = cfg_u32(&line, 1, MAX_CHANNEL_POOLS);
 				break;
@@ -2791,6 +2981,9 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_BACKGROUND_QUERY_MAX_RPS:
 				ns->background_query_max_rps = cfg_u32(&line, 1, 1000000);
 				break;
+			case CASE_NAMESPACE_BATCH_INDEX_PREFETCH:
+				ns->batch_index_prefetch = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_CONFLICT_RESOLUTION_POLICY:
 				switch (cfg_find_tok(line.val_tok_1, NAMESPACE_CONFLICT_RESOLUTION_OPTS, NUM_NAMESPACE_CONFLICT_RESOLUTION_OPTS)) {
 				case CASE_NAMESPACE_CONFLICT_RESOLUTION_GENERATION:
@@ -2848,6 +3041,9 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_EVICT_HIST_BUCKETS:
 				ns->evict_hist_buckets = cfg_u32(&line, 100, 10000000);
 				break;
+			case CASE_NAMESPACE_EVICT_SAMPLE_PCT:
+				ns->evict_sample_pct = cfg_u32(&line, 0, 100);
+				break;
 			case CASE_NAMESPACE_EVICT_TENTHS_PCT:
 				ns->evict_tenths_pct = cfg_u32_no_checks(&line);
 				break;
@@ -2857,19 +3053,40 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_HIGH_WATER_MEMORY_PCT:
 				ns->hwm_memory_pct = cfg_u32(&line, 0, 100);
 				break;
+			case CASE_NAMESPACE_HOT_KEY_SAMPLE_PERIOD:
+				ns->hot_key_sample_period = cfg_u32_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_IGNORE_MIGRATE_FILL_DELAY:
 				cfg_enterprise_only(&line);
 				ns->ignore_migrate_fill_delay = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_INDEX_COMPACT_ENTRIES:
+				ns->index_compact_entries = cfg_bool(&line);
+				break;
+			case CASE_NAMESPACE_INDEX_STAGE_HUGE_PAGES:
+				ns->index_mem_cfg.huge_pages = cfg_bool(&line);
+				break;
+			case CASE_NAMESPACE_INDEX_STAGE_INTERLEAVE:
+				ns->index_mem_cfg.numa_interleave = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_INDEX_STAGE_SIZE:
 				ns->index_stage_size = cfg_u64_power_of_2(&line, CF_ARENAX_MIN_STAGE_SIZE, CF_ARENAX_MAX_STAGE_SIZE);
 				break;
 			case CASE_NAMESPACE_MAX_RECORD_SIZE:
 				ns->max_record_size = cfg_u32_no_checks(&line);
 				break;
+			case CASE_NAMESPACE_MEMORY_DEFRAG_LWM_PCT:
+				ns->memory_defrag_lwm_pct = cfg_u32(&line, 1, 99);
+				break;
+			case CASE_NAMESPACE_MEMORY_DEFRAG_PERIOD:
+				ns->memory_defrag_period = cfg_seconds_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_MEMORY_SIZE:
 				ns->memory_size = cfg_u64(&line, 1024 * 1024, UINT64_MAX);
 				break;
+			case CASE_NAMESPACE_MEMORY_SNAPSHOT_FILE:
+				ns->memory_snapshot_file = cfg_strdup_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_MIGRATE_ORDER:
 				ns->migrate_order = cfg_u32(&line, 1, 10);
 				break;
@@ -2879,15 +3096,32 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_MIGRATE_SLEEP:
 				ns->migrate_sleep = cfg_u32_no_checks(&line);
 				break;
+			case CASE_NAMESPACE_NSUP_EXPIRE_INDEX:
+				ns->nsup_expire_index = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_NSUP_HIST_PERIOD:
 				ns->nsup_hist_period = cfg_seconds_no_checks(&line);
 				break;
 			case CASE_NAMESPACE_NSUP_PERIOD:
 				ns->nsup_period = cfg_seconds_no_checks(&line);
 				break;
+			case CASE_NAMESPACE_NSUP_SINGLE_PASS:
+				ns->nsup_single_pass = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_NSUP_THREADS:
 				ns->n_nsup_threads = cfg_u32(&line, 1, 128);
 				break;
+			case CASE_NAMESPACE_OPTIMISTIC_READS:
+				ns->optimistic_reads = cfg_bool(&line);
+				break;
+			case CASE_NAMESPACE_PARTITION_TREE_BLOOM_SIZE:
+				ns->tree_shared.bloom_size = cfg_u32_power_of_2(&line, 0, AS_INDEX_BLOOM_MAX_SIZE);
+
+				if (ns->tree_shared.bloom_size != 0 && ns->tree_shared.bloom_size < AS_INDEX_BLOOM_MIN_SIZE) {
+					cf_crash_nostack(AS_CFG, "{%s} 'partition-tree-bloom-size' must be 0 or at least %u",
+							ns->name, AS_INDEX_BLOOM_MIN_SIZE);
+				}
+				break;
 			case CASE_NAMESPACE_PARTITION_TREE_SPRIGS:
 				ns->tree_shared.n_sprigs = cfg_u32_power_of_2(&line, NUM_LOCK_PAIRS, 1 << NUM_SPRIG_BITS);
 				break;
@@ -2895,6 +3129,9 @@ as_config_init(const char* config_file)
 				cfg_enterprise_only(&line);
 				ns->cfg_prefer_uniform_balance = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_QUERY_RESULT_CACHE_SIZE:
+				ns->query_result_cache_size = cfg_u64_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_RACK_ID:
 				cfg_enterprise_only(&line);
 				ns->rack_id = cfg_u32(&line, 0, MAX_RACK_ID);
@@ -2916,6 +3153,9 @@ as_config_init(const char* config_file)
 					break;
 				}
 				break;
+			case CASE_NAMESPACE_READ_STEER_DEVICE_OUTLIERS:
+				ns->read_steer_device_outliers = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_REJECT_NON_XDR_WRITES:
 				ns->reject_non_xdr_writes = cfg_bool(&line);
 				break;
@@ -2925,6 +3165,26 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_REPLICATION_FACTOR:
 				ns->cfg_replication_factor = cfg_u32(&line, 1, AS_CLUSTER_SZ);
 				break;
+			case CASE_NAMESPACE_SERVICE_THREAD_CPUS:
+				{
+					cpu_set_t cpus;
+
+					if (! cf_topo_parse_os_cpu_list(line.val_tok_1, &cpus)) {
+						cfg_unknown_val_tok_1(&line);
+					}
+
+					ns->service_thread_cpus = cfg_strdup_no_checks(&line);
+				}
+				break;
+			case CASE_NAMESPACE_SERVICE_THREADS:
+				ns->n_service_threads = cfg_u32(&line, 0, MAX_NS_SERVICE_THREADS);
+				break;
+			case CASE_NAMESPACE_SINDEX_FLASH_DIR:
+				ns->sindex_flash_dir = cfg_strdup_no_checks(&line);
+				break;
+			case CASE_NAMESPACE_SINDEX_ORDERED_STRINGS:
+				ns->sindex_ordered_strings = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_SINDEX_STAGE_SIZE:
 				ns->sindex_stage_size = cfg_u64_power_of_2(&line, SI_ARENA_MIN_STAGE_SIZE, SI_ARENA_MAX_STAGE_SIZE);
 				break;
@@ -2956,6 +3216,12 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_TRANSACTION_PENDING_LIMIT:
 				ns->transaction_pending_limit = cfg_u32_no_checks(&line);
 				break;
+			case CASE_NAMESPACE_TRUNCATE_LATENCY_MS:
+				ns->truncate_latency_ms = cfg_u32_no_checks(&line);
+				break;
+			case CASE_NAMESPACE_TRUNCATE_MAX_RATE:
+				ns->truncate_max_rate = cfg_u32_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_TRUNCATE_THREADS:
 				ns->n_truncate_threads = cfg_u32(&line, 1, MAX_TRUNCATE_THREADS);
 				break;
@@ -3061,9 +3327,15 @@ as_config_init(const char* config_file)
 				if (ns->data_in_index && ! (ns->single_bin && ns->storage_data_in_memory && ns->storage_type == AS_STORAGE_ENGINE_SSD)) {
 					cf_crash_nostack(AS_CFG, "{%s} 'data-in-index' can't be true unless 'storage-engine device' and both 'single-bin' and 'data-in-memory' are true", ns->name);
 				}
+				if (ns->index_compact_entries && (ns->storage_data_in_memory || ns->xmem_type != CF_XMEM_TYPE_MEM)) {
+					cf_crash_nostack(AS_CFG, "{%s} 'index-compact-entries' can't be true if 'data-in-memory' is true or 'index-type' is not 'mem'", ns->name);
+				}
 				if (ns->storage_type == AS_STORAGE_ENGINE_PMEM && ns->xmem_type == CF_XMEM_TYPE_FLASH) {
 					cf_crash_nostack(AS_CFG, "{%s} 'storage-engine pmem' can't be used with 'index-type flash'", ns->name);
 				}
+				if (ns->memory_snapshot_file != NULL && ns->storage_type != AS_STORAGE_ENGINE_MEMORY) {
+					cf_crash_nostack(AS_CFG, "{%s} 'memory-snapshot-file' requires 'storage-engine memory'", ns->name);
+				}
 				if (ns->conflict_resolve_writes && ns->single_bin) {
 					cf_crash_nostack(AS_CFG, "{%s} 'conflict-resolve-writes' can't be true if 'single-bin' is true", ns->name);
 				}
@@ -3274,20 +3546,31 @@ as_config_init(const char* config_file)
 		//
 		case NAMESPACE_STORAGE_DEVICE:
 			switch (cfg_find_tok(line.name_tok, NAMESPACE_STORAGE_DEVICE_OPTS, NUM_NAMESPACE_STORAGE_DEVICE_OPTS)) {
+			case CASE_NAMESPACE_STORAGE_DEVICE_BACKGROUND_READ_DEPTH:
+				ns->storage_background_read_depth = cfg_u32(&line, 0, 1024);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_CACHE_REPLICA_WRITES:
 				ns->storage_cache_replica_writes = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_COALESCE_BATCH_READS:
+				ns->storage_coalesce_batch_reads = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_COLD_START_EMPTY:
 				ns->storage_cold_start_empty = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_COLD_START_THREADS:
+				ns->storage_cold_start_threads = cfg_u32(&line, 1, 128);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_TO_DEVICE:
-				cfg_enterprise_only(&line);
 				ns->storage_commit_to_device = cfg_bool(&line);
 				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_MIN_SIZE:
 				cfg_enterprise_only(&line);
 				ns->storage_commit_min_size = cfg_u32_power_of_2(&line, 0, MAX_WRITE_BLOCK_SIZE);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_COMMIT_WINDOW_US:
+				ns->storage_commit_window_us = cfg_u32(&line, 0, 10000);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_COMPRESSION:
 				cfg_enterprise_only(&line);
 				switch (cfg_find_tok(line.val_tok_1, NAMESPACE_STORAGE_COMPRESSION_OPTS, NUM_NAMESPACE_STORAGE_COMPRESSION_OPTS)) {
@@ -3316,6 +3599,9 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_STORAGE_DEVICE_DATA_IN_MEMORY:
 				ns->storage_data_in_memory = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_DAX_MAP:
+				ns->storage_dax_map = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_LWM_PCT:
 				ns->storage_defrag_lwm_pct = cfg_u32_no_checks(&line);
 				break;
@@ -3328,6 +3614,9 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_STARTUP_MINIMUM:
 				ns->storage_defrag_startup_minimum = cfg_u32(&line, 0, 99);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_DEFRAG_TARGET_READ_US:
+				ns->storage_defrag_target_read_us = cfg_u32_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_DEVICE:
 				cfg_add_storage_device(ns, cfg_strdup_no_checks(&line), cfg_strdup_val2_no_checks(&line, false));
 				break;
@@ -3340,6 +3629,9 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_STORAGE_DEVICE_ENABLE_BENCHMARKS_STORAGE:
 				ns->storage_benchmarks_enabled = true;
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_ENABLE_LATENCY_MAP:
+				ns->storage_latency_map_enabled = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_ENCRYPTION:
 				cfg_enterprise_only(&line);
 				switch (cfg_find_tok(line.val_tok_1, NAMESPACE_STORAGE_ENCRYPTION_OPTS, NUM_NAMESPACE_STORAGE_ENCRYPTION_OPTS)) {
@@ -3372,18 +3664,48 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MAX_MS:
 				ns->storage_flush_max_us = cfg_u64_no_checks(&line) * 1000;
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MAX_DEFER_MS:
+				ns->storage_flush_max_defer_us = cfg_u64_no_checks(&line) * 1000;
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_FLUSH_MIN_FILL_PCT:
+				ns->storage_flush_min_fill_pct = cfg_u32(&line, 0, 100);
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_INDEX_SNAPSHOT_FILE:
+				ns->storage_index_snapshot_file = cfg_strdup_no_checks(&line);
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_LARGE_RECORD_STREAM_SIZE:
+				ns->storage_large_record_stream_size = cfg_u32(&line, 0, MAX_WRITE_BLOCK_SIZE);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_MAX_WRITE_CACHE:
 				ns->storage_max_write_cache = cfg_u64(&line, DEFAULT_MAX_WRITE_CACHE, UINT64_MAX);
 				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_MIN_AVAIL_PCT:
 				ns->storage_min_avail_pct = cfg_u32(&line, 0, 100);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_NUMA_LOCAL_WRITE_BUFFERS:
+				ns->storage_numa_local_write_buffers = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_POST_WRITE_QUEUE:
 				ns->storage_post_write_queue = cfg_u32(&line, 0, MAX_POST_WRITE_QUEUE);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_READ_CACHE_SIZE:
+				ns->storage_read_cache_size = cfg_u64_no_checks(&line);
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_READ_IO_URING:
+				ns->storage_read_io_uring = cfg_bool(&line);
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_READ_OFFLOAD_US:
+				ns->storage_read_offload_us = cfg_u32_no_checks(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_READ_PAGE_CACHE:
 				ns->storage_read_page_cache = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_RECORD_CHECKSUMS:
+				ns->storage_record_checksums = cfg_bool(&line);
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_SCAN_DEVICE_ORDER:
+				ns->storage_scan_device_order = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_SCHEDULER_MODE:
 				ns->storage_scheduler_mode = cfg_strdup_one_of(&line, DEVICE_SCHEDULER_MODES, NUM_DEVICE_SCHEDULER_MODES);
 				break;
@@ -3391,6 +3713,12 @@ as_config_init(const char* config_file)
 				cfg_enterprise_only(&line);
 				ns->storage_serialize_tomb_raider = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_SHADOW_MAX_LAG:
+				ns->storage_shadow_max_lag = cfg_u64_no_checks(&line);
+				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_SHED_LOW_PRIORITY_PCT:
+				ns->storage_shed_low_priority_pct = cfg_u32(&line, 0, 100);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_SINDEX_STARTUP_DEVICE_SCAN:
 				ns->storage_sindex_startup_device_scan = cfg_bool(&line);
 				break;
@@ -3398,9 +3726,15 @@ as_config_init(const char* config_file)
 				cfg_enterprise_only(&line);
 				ns->storage_tomb_raider_sleep = cfg_u32_no_checks(&line);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_TTL_WRITE_STREAMS:
+				ns->storage_ttl_write_streams = cfg_u32(&line, 1, MAX_TTL_WRITE_STREAMS);
+				break;
 			case CASE_NAMESPACE_STORAGE_DEVICE_WRITE_BLOCK_SIZE:
 				ns->storage_write_block_size = cfg_u32_power_of_2(&line, MIN_WRITE_BLOCK_SIZE, MAX_WRITE_BLOCK_SIZE);
 				break;
+			case CASE_NAMESPACE_STORAGE_DEVICE_WRITE_LIFETIME_HINTS:
+				ns->storage_write_lifetime_hints = cfg_bool(&line);
+				break;
 			// Obsoleted:
 			case CASE_NAMESPACE_STORAGE_DEVICE_DISABLE_ODIRECT:
 				cfg_obsolete(&line, "please use 'read-page-cache' instead");
@@ -3424,12 +3758,24 @@ as_config_init(const char* config_file)
 				if (ns->storage_sindex_startup_device_scan && ns->storage_data_in_memory) {
 					cf_crash_nostack(AS_CFG, "{%s} can't configure both 'sindex-startup-device-scan' and 'data-in-memory'", ns->name);
 				}
+				if (ns->storage_index_snapshot_file != NULL && ns->storage_data_in_memory) {
+					cf_crash_nostack(AS_CFG, "{%s} can't configure both 'index-snapshot-file' and 'data-in-memory'", ns->name);
+				}
 				if (ns->storage_commit_to_device && ns->storage_disable_odsync) {
 					cf_crash_nostack(AS_CFG, "{%s} can't configure both 'commit-to-device' and 'disable-odsync'", ns->name);
 				}
+				if (ns->storage_commit_window_us != 0 && ! ns->storage_commit_to_device) {
+					cf_crash_nostack(AS_CFG, "{%s} 'commit-window-us' is only relevant for 'commit-to-device'", ns->name);
+				}
+				if (ns->storage_shadow_max_lag != 0 && ns->n_storage_shadows == 0) {
+					cf_crash_nostack(AS_CFG, "{%s} 'shadow-max-lag' is only relevant with shadow devices", ns->name);
+				}
 				if (ns->storage_compression_level != 0 && ns->storage_compression != AS_COMPRESSION_ZSTD) {
 					cf_crash_nostack(AS_CFG, "{%s} 'compression-level' is only relevant for 'compression zstd'", ns->name);
 				}
+				if (ns->storage_dax_map && ns->n_storage_devices != 0) {
+					cf_crash_nostack(AS_CFG, "{%s} 'dax-map' is only relevant for storage files", ns->name);
+				}
 				cfg_end_context(&state);
 				break;
 			case CASE_NOT_FOUND:
@@ -3447,6 +3793,9 @@ as_config_init(const char* config_file)
 			case CASE_NAMESPACE_SET_DISABLE_EVICTION:
 				p_set->eviction_disabled = cfg_bool(&line);
 				break;
+			case CASE_NAMESPACE_SET_ENABLE_HISTOGRAMS:
+				p_set->hist_enabled = cfg_bool(&line);
+				break;
 			case CASE_NAMESPACE_SET_ENABLE_INDEX:
 				p_set->index_enabled = cfg_bool(&line);
 				break;
@@ -4003,6 +4352,7 @@ as_config_post_process(as_config* c, const char* config_file)
 	}
 
 	// Setup performance metrics histograms.
+	histogram_set_significant_digits(c->hist_significant_digits);
 	cfg_create_all_histograms();
 
 	// If node-id was not configured, generate one.
@@ -4249,10 +4599,16 @@ as_config_post_process(as_config* c, const char* config_file)
 			max_alloc_sz = ns->index_stage_size;
 		}
 
-		if (ns->sindex_stage_size > max_alloc_sz) {
+		if (ns->sindex_flash_dir == NULL &&
+				ns->sindex_stage_size > max_alloc_sz) {
 			max_alloc_sz = ns->sindex_stage_size;
 		}
 
+		if (ns->service_thread_cpus != NULL && ns->n_service_threads == 0) {
+			cf_warning(AS_CFG, "{%s} 'service-thread-cpus' ignored without 'service-threads'",
+					ns->name);
+		}
+
 		client_replica_maps_create(ns);
 
 		uint32_t sprigs_offset = sizeof(as_lock_pair) * NUM_LOCK_PAIRS;
@@ -4272,6 +4628,9 @@ as_config_post_process(as_config* c, const char* config_file)
 
 		as_storage_cfg_init(ns);
 
+		ns->hot_keys = as_hot_keys_create();
+		ns->device_heat = as_device_heat_create(ns);
+
 		histogram_scale scale = as_config_histogram_scale();
 		char hist_name[HISTOGRAM_NAME_SIZE];
 
@@ -4314,6 +4673,8 @@ as_config_post_process(as_config* c, const char* config_file)
 		ns->read_dup_res_hist = histogram_create(hist_name, scale);
 		sprintf(hist_name, "{%s}-read-repl-ping", ns->name);
 		ns->read_repl_ping_hist = histogram_create(hist_name, scale);
+		sprintf(hist_name, "{%s}-read-record-lock", ns->name);
+		ns->read_record_lock_hist = histogram_create(hist_name, scale);
 		sprintf(hist_name, "{%s}-read-local", ns->name);
 		ns->read_local_hist = histogram_create(hist_name, scale);
 		sprintf(hist_name, "{%s}-read-response", ns->name);
@@ -4325,6 +4686,8 @@ as_config_post_process(as_config* c, const char* config_file)
 		ns->write_restart_hist = histogram_create(hist_name, scale);
 		sprintf(hist_name, "{%s}-write-dup-res", ns->name);
 		ns->write_dup_res_hist = histogram_create(hist_name, scale);
+		sprintf(hist_name, "{%s}-write-record-lock", ns->name);
+		ns->write_record_lock_hist = histogram_create(hist_name, scale);
 		sprintf(hist_name, "{%s}-write-master", ns->name);
 		ns->write_master_hist = histogram_create(hist_name, scale);
 		sprintf(hist_name, "{%s}-write-repl-write", ns->name);
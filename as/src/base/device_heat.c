@@ -0,0 +1,166 @@
+/*
+ * device_heat.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * Per-device time x latency-bucket heat maps. Slices are recycled lock-free -
+ * the first thread to see a stale period claims the slice and zeroes it, so a
+ * few samples racing the reset may be lost, which is fine for a heat map.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "base/device_heat.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
+
+#include "bits.h"
+#include "dynbuf.h"
+
+#include "base/datamodel.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define SLICE_US ((uint64_t)AS_DEVICE_HEAT_SLICE_SEC * 1000 * 1000)
+
+static const char* TYPE_NAMES[] = {
+		[AS_DEVICE_HEAT_READ] = "read",
+		[AS_DEVICE_HEAT_WRITE] = "write"
+};
+
+
+//==========================================================
+// Globals.
+//
+
+__thread uint32_t g_device_heat_read_counter = 0;
+
+
+//==========================================================
+// Public API.
+//
+
+as_device_heat*
+as_device_heat_create(const as_namespace* ns)
+{
+	uint32_t n_devices = as_namespace_device_count(ns);
+
+	if (n_devices == 0) {
+		return NULL;
+	}
+
+	return cf_calloc(n_devices, sizeof(as_device_heat));
+}
+
+void
+as_device_heat_get(const as_namespace* ns, cf_dyn_buf* db)
+{
+	cf_dyn_buf_append_string(db, "slice-sec=");
+	cf_dyn_buf_append_uint32(db, AS_DEVICE_HEAT_SLICE_SEC);
+	cf_dyn_buf_append_string(db, ":read-sampling=");
+	cf_dyn_buf_append_uint32(db, AS_DEVICE_HEAT_READ_SAMPLING_MASK + 1);
+	cf_dyn_buf_append_char(db, ';');
+
+	if (ns->device_heat == NULL) {
+		cf_dyn_buf_chomp_char(db, ';');
+		return;
+	}
+
+	uint64_t now_period = cf_getus() / SLICE_US;
+	uint32_t n_devices = as_namespace_device_count(ns);
+
+	for (uint32_t d_id = 0; d_id < n_devices; d_id++) {
+		const as_device_heat* heat = &ns->device_heat[d_id];
+
+		for (uint32_t t = 0; t < AS_DEVICE_HEAT_N_TYPES; t++) {
+			// Oldest first.
+			for (uint32_t age = AS_DEVICE_HEAT_N_SLICES; age-- > 0; ) {
+				if (age > now_period) {
+					continue;
+				}
+
+				uint64_t period = now_period - age;
+				const as_device_heat_slice* slice =
+						&heat->slices[t][period % AS_DEVICE_HEAT_N_SLICES];
+
+				if (as_load_uint64(&slice->period) != period) {
+					continue;
+				}
+
+				cf_dyn_buf_append_string(db, "device=");
+				cf_dyn_buf_append_string(db, ns->storage_devices[d_id]);
+				cf_dyn_buf_append_string(db, ":op=");
+				cf_dyn_buf_append_string(db, TYPE_NAMES[t]);
+				cf_dyn_buf_append_string(db, ":seconds-ago=");
+				cf_dyn_buf_append_uint64(db, age * AS_DEVICE_HEAT_SLICE_SEC);
+				cf_dyn_buf_append_string(db, ":counts=");
+
+				for (uint32_t b = 0; b < AS_DEVICE_HEAT_N_BUCKETS; b++) {
+					cf_dyn_buf_append_uint32(db,
+							as_load_uint32(&slice->counts[b]));
+					cf_dyn_buf_append_char(db, ',');
+				}
+
+				cf_dyn_buf_chomp_char(db, ',');
+				cf_dyn_buf_append_char(db, ';');
+			}
+		}
+	}
+
+	cf_dyn_buf_chomp_char(db, ';');
+}
+
+void
+device_heat_add(as_device_heat* heat, as_device_heat_type type,
+		uint64_t start_us)
+{
+	uint64_t now_us = cf_getus();
+	uint64_t delta_us = now_us - start_us;
+	uint64_t period = now_us / SLICE_US;
+	as_device_heat_slice* slice =
+			&heat->slices[type][period % AS_DEVICE_HEAT_N_SLICES];
+	uint64_t old_period = as_load_uint64(&slice->period);
+
+	if (old_period != period &&
+			as_cas_uint64(&slice->period, old_period, period)) {
+		for (uint32_t b = 0; b < AS_DEVICE_HEAT_N_BUCKETS; b++) {
+			as_store_uint32(&slice->counts[b], 0);
+		}
+	}
+
+	uint32_t bucket = delta_us == 0 ? 0 : 63 - cf_msb64(delta_us);
+
+	if (bucket >= AS_DEVICE_HEAT_N_BUCKETS) {
+		bucket = AS_DEVICE_HEAT_N_BUCKETS - 1;
+	}
+
+	as_incr_uint32(&slice->counts[bucket]);
+}
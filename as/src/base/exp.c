@@ -60,6 +60,16 @@
 
 #define EXP_MAX_SIZE (1 * 1024 * 1024) // 1 MiB
 
+// Distinct bins referenced by one expression, each fetched once per eval.
+#define MAX_BIN_SLOTS 64
+#define NO_BIN_SLOT UINT32_MAX
+
+// Per-eval bump arena for runtime temporaries - overflow goes to the heap.
+#define RT_ARENA_SIZE (4 * 1024)
+
+// Records per column pass of batched metadata evaluation.
+#define META_BATCH_SIZE 256
+
 typedef enum {
 	GEO_CELL,
 	GEO_REGION,
@@ -226,6 +236,7 @@ ARRAY_ASSERT(result_type_to_op_code, TYPE_END);
 
 typedef struct op_base_mem_s {
 	uint32_t instr_end_ix;
+	uint32_t instr_end_offset; // bytes from this op to the end of its subtree
 	exp_op_code code;
 } op_base_mem;
 
@@ -240,6 +251,7 @@ typedef struct op_bin_name_s {
 	op_base_mem base;
 	const uint8_t* name;
 	uint32_t name_sz;
+	uint32_t bin_slot;
 } op_bin_type;
 
 typedef struct op_rec_digest_modulo_s {
@@ -256,6 +268,7 @@ typedef struct op_bin_s {
 	op_base_mem base;
 	const uint8_t* name;
 	uint32_t name_sz;
+	uint32_t bin_slot;
 	result_type type;
 } op_bin;
 
@@ -398,6 +411,10 @@ typedef struct runtime_s {
 	const as_exp_ctx* ctx;
 	const uint8_t* instr_ptr;
 	rt_value* vars;
+	as_bin** bins; // indexed by bin slot
+	uint64_t bins_fetched; // bit per bin slot
+	uint8_t* arena; // RT_ARENA_SIZE bytes, freed when eval returns
+	uint32_t arena_used;
 	uint32_t op_ix;
 	bool alloc_ns;
 } runtime;
@@ -416,6 +433,9 @@ typedef struct build_args_s {
 	uint32_t var_idx;
 	uint32_t max_var_idx;
 	var_scope* current;
+
+	const uint8_t* bin_slot_names[MAX_BIN_SLOTS];
+	uint32_t bin_slot_name_szs[MAX_BIN_SLOTS];
 } build_args;
 
 typedef bool (*op_table_build_cb)(build_args* args);
@@ -491,6 +511,7 @@ static bool build_meta_digest_mod(build_args* args);
 static bool build_rec_key(build_args* args);
 static bool build_bin(build_args* args);
 static bool build_bin_type(build_args* args);
+static uint32_t build_note_bin_ref(build_args* args, const uint8_t* name, uint32_t name_sz);
 static bool build_cond(build_args* args);
 static bool build_var(build_args* args);
 static bool build_let(build_args* args);
@@ -507,6 +528,8 @@ static bool build_value_msgpack(build_args* args);
 // Build utilities.
 static bool parse_op_call(op_call* op, build_args* args);
 static bool build_set_expected_particle_type(build_args* args);
+static void build_meta_terms(as_exp* exp);
+static bool build_meta_term(const op_base_mem* ob, as_exp_meta_term* term);
 static as_exp* check_filter_exp(as_exp* exp);
 
 // Runtime.
@@ -567,11 +590,16 @@ static void rt_value_bin_ptr_to_bin(runtime* rt, as_bin* rb, const rt_value* fro
 static void json_to_rt_geo(const uint8_t* json, size_t jsonsz, rt_value* val);
 static void particle_to_rt_geo(const as_particle* p, rt_value* val);
 static bool bin_is_type(const as_bin* b, result_type type);
-static void rt_skip(runtime* rt, uint32_t instr_count);
+static void rt_skip(runtime* rt, const op_base_mem* ob);
 static void rt_value_translate(rt_value* to, const rt_value* from);
 static void rt_value_destroy(rt_value* val);
 static void rt_value_get_geo(rt_value* val, geo_data* result);
 static bool get_live_bin(as_storage_rd* rd, const uint8_t* name, size_t len, as_bin** p_bin);
+static bool rt_get_live_bin(runtime* rt, const uint8_t* name, uint32_t len, uint32_t slot, as_bin** p_bin);
+
+// Runtime batch metadata utilities.
+static void meta_column(const as_exp_meta_term* term, as_record* const* rs, uint32_t n_rs, int64_t* vals);
+static void meta_column_cmp(const as_exp_meta_term* term, const int64_t* vals, uint32_t n_rs, uint8_t* keep);
 
 // Runtime compare utilities.
 static as_exp_trilean cmp_trilean(exp_op_code code, const rt_value* e0, const rt_value* e1);
@@ -582,10 +610,12 @@ static as_exp_trilean cmp_bytes(exp_op_code code, const rt_value* e0, const rt_v
 static as_exp_trilean cmp_msgpack(exp_op_code code, const rt_value* v0, const rt_value* v1);
 
 // Runtime call utilities.
-static void call_cleanup(void** blob, uint32_t blob_ix, as_bin** bin, uint32_t bin_ix);
+static void call_cleanup(runtime* rt, void** blob, uint32_t blob_ix, as_bin** bin, uint32_t bin_ix);
 static void pack_typed_str(as_packer* pk, const uint8_t* buf, uint32_t sz, uint8_t type);
 static bool rt_value_bin_translate(rt_value* to, const rt_value* from);
 static void* rt_alloc_mem(runtime* rt, size_t sz, cf_ll_buf* ll_buf);
+static void* rt_temp_alloc(runtime* rt, size_t sz);
+static void rt_temp_free(runtime* rt, void* p);
 static bool msgpack_to_bin(runtime* rt, as_bin* to, rt_value* from, cf_ll_buf* ll_buf);
 
 // Runtime runtime display.
@@ -798,12 +828,16 @@ as_exp_eval(const as_exp* exp, const as_exp_ctx* ctx, as_bin* rb,
 		cf_ll_buf* particles_llb, bool is_modify)
 {
 	rt_value vars[exp->max_var_count];
+	as_bin* bins[exp->bin_slot_count];
+	uint64_t arena[RT_ARENA_SIZE / sizeof(uint64_t)];
 	rt_value ret_val;
 
 	runtime rt = {
 			.ctx = ctx,
 			.instr_ptr = exp->mem,
 			.vars = vars,
+			.bins = bins,
+			.arena = (uint8_t*)arena,
 			.alloc_ns = is_modify
 	};
 
@@ -931,6 +965,32 @@ as_exp_matches_metadata(const as_exp* predexp, const as_exp_ctx* ctx)
 	return ret;
 }
 
+// Evaluate only the batchable metadata terms, a column at a time. Clears
+// keep[i] if rs[i] can't match - else the full filter must still be applied.
+void
+as_exp_matches_metadata_batch(const as_exp* predexp, as_record* const* rs,
+		uint32_t n_rs, uint8_t* keep)
+{
+	int64_t vals[META_BATCH_SIZE];
+
+	memset(keep, 1, n_rs);
+
+	for (uint32_t start = 0; start < n_rs; start += META_BATCH_SIZE) {
+		uint32_t n = n_rs - start;
+
+		if (n > META_BATCH_SIZE) {
+			n = META_BATCH_SIZE;
+		}
+
+		for (uint32_t t = 0; t < predexp->n_meta_terms; t++) {
+			const as_exp_meta_term* term = &predexp->meta_terms[t];
+
+			meta_column(term, rs + start, n, vals);
+			meta_column_cmp(term, vals, n, keep + start);
+		}
+	}
+}
+
 bool
 as_exp_matches_record(const as_exp* predexp, const as_exp_ctx* ctx)
 {
@@ -941,6 +1001,27 @@ as_exp_matches_record(const as_exp* predexp, const as_exp_ctx* ctx)
 	return ret == AS_EXP_TRUE;
 }
 
+// True if the only record data the expression reads is the named bin - it may
+// then be evaluated against a record holding just that bin.
+bool
+as_exp_refs_only_bin(const as_exp* exp, const char* name)
+{
+	if (exp->refs_other_data || exp->ref_bin_name == NULL) {
+		return false;
+	}
+
+	return exp->ref_bin_name_sz == strlen(name) &&
+			memcmp(exp->ref_bin_name, name, exp->ref_bin_name_sz) == 0;
+}
+
+// True if the expression's value depends only on the named bin - it may then be
+// evaluated against that bin alone, without a record.
+bool
+as_exp_is_bin_function(const as_exp* exp, const char* name)
+{
+	return ! exp->refs_meta && as_exp_refs_only_bin(exp, name);
+}
+
 bool
 as_exp_display(const as_exp* exp, cf_dyn_buf *db)
 {
@@ -1076,6 +1157,8 @@ build_internal(const uint8_t* buf, uint32_t buf_sz, bool cpy_wire)
 		return NULL;
 	}
 
+	build_meta_terms(args.exp);
+
 	if (cf_log_check_level(AS_EXP, CF_DETAIL)) {
 		cf_dyn_buf_define_size(db, 10240);
 		runtime rt = { .instr_ptr = args.exp->mem };
@@ -1140,6 +1223,10 @@ build_next(build_args* args)
 				op_code);
 	}
 
+	if (op_code >= EXP_META_DIGEST_MOD && op_code <= EXP_META_MEMORY_SIZE) {
+		args->exp->refs_meta = true;
+	}
+
 	args->entry = &op_table[op_code];
 	args->ele_count = ele_count;
 	args->instr_ix++;
@@ -1148,6 +1235,7 @@ build_next(build_args* args)
 	bool rv = op_table[op_code].build_cb(args);
 
 	op->instr_end_ix = args->instr_ix;
+	op->instr_end_offset = (uint32_t)(args->mem - (uint8_t*)op);
 
 	debug_exp_check(args->exp);
 
@@ -2007,6 +2095,8 @@ build_rec_key(build_args* args)
 		return false;
 	}
 
+	args->exp->refs_other_data = true;
+
 	int64_t type64;
 
 	if (! msgpack_get_int64(&args->mp, &type64)) {
@@ -2063,6 +2153,8 @@ build_bin(build_args* args)
 		return false;
 	}
 
+	op->bin_slot = build_note_bin_ref(args, op->name, op->name_sz);
+
 	if ((args->entry = build_get_entry(op->type)) == NULL) {
 		cf_warning(AS_EXP, "build_bin - error %u invalid result_type %d (%s)",
 				AS_ERR_PARAMETER, op->type, result_type_to_str(op->type));
@@ -2089,9 +2181,43 @@ build_bin_type(build_args* args)
 		return false;
 	}
 
+	op->bin_slot = build_note_bin_ref(args, op->name, op->name_sz);
+
 	return true;
 }
 
+static uint32_t
+build_note_bin_ref(build_args* args, const uint8_t* name, uint32_t name_sz)
+{
+	as_exp* exp = args->exp;
+
+	if (exp->ref_bin_name == NULL) {
+		exp->ref_bin_name = name;
+		exp->ref_bin_name_sz = name_sz;
+	}
+	else if (exp->ref_bin_name_sz != name_sz ||
+			memcmp(exp->ref_bin_name, name, name_sz) != 0) {
+		exp->refs_other_data = true;
+	}
+
+	// Repeated references to a bin share a slot, so it's fetched only once.
+	for (uint32_t i = 0; i < exp->bin_slot_count; i++) {
+		if (args->bin_slot_name_szs[i] == name_sz &&
+				memcmp(args->bin_slot_names[i], name, name_sz) == 0) {
+			return i;
+		}
+	}
+
+	if (exp->bin_slot_count == MAX_BIN_SLOTS) {
+		return NO_BIN_SLOT;
+	}
+
+	args->bin_slot_names[exp->bin_slot_count] = name;
+	args->bin_slot_name_szs[exp->bin_slot_count] = name_sz;
+
+	return exp->bin_slot_count++;
+}
+
 static bool
 build_cond(build_args* args)
 {
@@ -2156,6 +2282,7 @@ build_cond(build_args* args)
 		}
 
 		op_case->instr_end_ix = args->instr_ix;
+		op_case->instr_end_offset = (uint32_t)(args->mem - (uint8_t*)op_case);
 	}
 
 	if (! build_next(args)) {
@@ -2778,6 +2905,99 @@ build_set_expected_particle_type(build_args* args)
 	return true;
 }
 
+// Collect the terms comparing metadata with a constant that must all be true
+// for the expression to be true.
+static void
+build_meta_terms(as_exp* exp)
+{
+	const op_base_mem* ob = (const op_base_mem*)exp->mem;
+
+	if (ob->code != EXP_AND) {
+		if (build_meta_term(ob, &exp->meta_terms[0])) {
+			exp->n_meta_terms = 1;
+		}
+
+		return;
+	}
+
+	// Any subset of an 'and' will do - other args are checked per record.
+	const uint8_t* end = (const uint8_t*)ob + ob->instr_end_offset;
+	const uint8_t* arg = (const uint8_t*)ob + op_table[EXP_AND].size;
+
+	while (arg < end && exp->n_meta_terms < AS_EXP_MAX_META_TERMS) {
+		const op_base_mem* arg_ob = (const op_base_mem*)arg;
+
+		if (build_meta_term(arg_ob, &exp->meta_terms[exp->n_meta_terms])) {
+			exp->n_meta_terms++;
+		}
+
+		arg += arg_ob->instr_end_offset;
+	}
+}
+
+static bool
+build_meta_term(const op_base_mem* ob, as_exp_meta_term* term)
+{
+	exp_op_code cmp = ob->code;
+
+	if (cmp < EXP_CMP_EQ || cmp > EXP_CMP_LE) {
+		return false;
+	}
+
+	const op_base_mem* meta = (const op_base_mem*)
+			((const uint8_t*)ob + op_table[cmp].size);
+	const op_base_mem* value = (const op_base_mem*)
+			((const uint8_t*)meta + meta->instr_end_offset);
+
+	if (meta->code == VOP_VALUE_INT) {
+		const op_base_mem* temp = meta;
+
+		meta = value;
+		value = temp;
+
+		// Constant on the left - mirror the comparison.
+		switch (cmp) {
+		case EXP_CMP_GT:
+			cmp = EXP_CMP_LT;
+			break;
+		case EXP_CMP_GE:
+			cmp = EXP_CMP_LE;
+			break;
+		case EXP_CMP_LT:
+			cmp = EXP_CMP_GT;
+			break;
+		case EXP_CMP_LE:
+			cmp = EXP_CMP_GE;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (value->code != VOP_VALUE_INT) {
+		return false;
+	}
+
+	switch (meta->code) {
+	case EXP_META_DIGEST_MOD:
+		term->mod = ((const op_meta_digest_modulo*)meta)->mod;
+		break;
+	case EXP_META_LAST_UPDATE:
+	case EXP_META_SINCE_UPDATE:
+	case EXP_META_VOID_TIME:
+		term->mod = 0;
+		break;
+	default:
+		return false;
+	}
+
+	term->field = (uint8_t)meta->code;
+	term->cmp = (uint8_t)cmp;
+	term->value = ((const op_value_int*)value)->value;
+
+	return true;
+}
+
 static as_exp*
 check_filter_exp(as_exp* exp)
 {
@@ -2800,12 +3020,16 @@ static as_exp_trilean
 match_internal(const as_exp* predexp, const as_exp_ctx* ctx)
 {
 	rt_value vars[predexp->max_var_count];
+	as_bin* bins[predexp->bin_slot_count];
+	uint64_t arena[RT_ARENA_SIZE / sizeof(uint64_t)];
 	rt_value ret_val;
 
 	runtime rt = {
 			.ctx = ctx,
 			.instr_ptr = predexp->mem,
-			.vars = vars
+			.vars = vars,
+			.bins = bins,
+			.arena = (uint8_t*)arena
 	};
 
 	rt_eval(&rt, &ret_val);
@@ -2861,7 +3085,7 @@ eval_compare(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 	if (rt_eval(rt, &arg0)) {
 		*ret_val = arg0;
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -2940,10 +3164,14 @@ eval_cmp_regex(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 	}
 
 	op_cmp_regex* op = (op_cmp_regex*)ob;
-	char* tmp = cf_strndup((const char*)str, str_sz); // TODO - maybe improve this
+	char* tmp = rt_temp_alloc(rt, str_sz + 1);
+
+	memcpy(tmp, str, str_sz);
+	tmp[str_sz] = '\0';
+
 	int rv = regexec(&op->regex, tmp, 0, NULL, 0);
 
-	cf_free(tmp);
+	rt_temp_free(rt, tmp);
 
 	rt_value_destroy(ret_val);
 	ret_val->type = RT_TRILEAN;
@@ -2966,7 +3194,7 @@ eval_and(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (ret_val->r_trilean == AS_EXP_FALSE) {
 			ret = AS_EXP_FALSE;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			break;
 		}
 	}
@@ -2990,7 +3218,7 @@ eval_or(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (ret_val->r_trilean == AS_EXP_TRUE) {
 			ret = AS_EXP_TRUE;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			break;
 		}
 	}
@@ -3022,7 +3250,7 @@ eval_exclusive(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 	while (rt->op_ix < ob->instr_end_ix) {
 		if (rt_eval(rt, ret_val)) {
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3031,7 +3259,7 @@ eval_exclusive(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 		if (ret_val->r_trilean == AS_EXP_TRUE) {
 			if (ret == AS_EXP_TRUE) {
 				ret_val->r_trilean = AS_EXP_FALSE;
-				rt_skip(rt, ob->instr_end_ix);
+				rt_skip(rt, ob);
 				return;
 			}
 
@@ -3047,7 +3275,7 @@ static void
 eval_add(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3058,7 +3286,7 @@ eval_add(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3075,7 +3303,7 @@ static void
 eval_sub(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3097,7 +3325,7 @@ eval_sub(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3114,7 +3342,7 @@ static void
 eval_mul(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3125,7 +3353,7 @@ eval_mul(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3142,7 +3370,7 @@ static void
 eval_div(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3159,7 +3387,7 @@ eval_div(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3200,7 +3428,7 @@ static void
 eval_pow(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3218,7 +3446,7 @@ static void
 eval_log(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3236,7 +3464,7 @@ static void
 eval_mod(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3330,7 +3558,7 @@ static void
 eval_int_and(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3339,7 +3567,7 @@ eval_int_and(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3351,7 +3579,7 @@ static void
 eval_int_or(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3360,7 +3588,7 @@ eval_int_or(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3372,7 +3600,7 @@ static void
 eval_int_xor(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3381,7 +3609,7 @@ eval_int_xor(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3405,7 +3633,7 @@ static void
 eval_int_lshift(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3423,7 +3651,7 @@ static void
 eval_int_rshift(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3441,7 +3669,7 @@ static void
 eval_int_arshift(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3471,7 +3699,7 @@ static void
 eval_int_lscan(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3497,7 +3725,7 @@ static void
 eval_int_rscan(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3519,7 +3747,7 @@ void
 eval_min(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3530,7 +3758,7 @@ eval_min(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3551,7 +3779,7 @@ static void
 eval_max(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 {
 	if (rt_eval(rt, ret_val)) {
-		rt_skip(rt, ob->instr_end_ix);
+		rt_skip(rt, ob);
 		return;
 	}
 
@@ -3562,7 +3790,7 @@ eval_max(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 		if (rt_eval(rt, &arg)) {
 			*ret_val = arg;
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3756,7 +3984,7 @@ eval_bin(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 	op_bin* op = (op_bin*)ob;
 	as_bin* bin;
 
-	if (! get_live_bin(rt->ctx->rd, op->name, op->name_sz, &bin)) {
+	if (! rt_get_live_bin(rt, op->name, op->name_sz, op->bin_slot, &bin)) {
 		ret_val->type = RT_TRILEAN;
 		ret_val->r_trilean = AS_EXP_UNK;
 		return;
@@ -3818,7 +4046,7 @@ eval_bin_type(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 	as_bin* b;
 
-	if (! get_live_bin(rt->ctx->rd, op->name, op->name_sz, &b)) {
+	if (! rt_get_live_bin(rt, op->name, op->name_sz, op->bin_slot, &b)) {
 		ret_val->type = RT_TRILEAN;
 		ret_val->r_trilean = AS_EXP_UNK;
 		return;
@@ -3836,7 +4064,7 @@ eval_cond(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 
 	for (uint32_t i = 0; i < op->case_count; i++) {
 		if (rt_eval(rt, ret_val)) {
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
@@ -3848,13 +4076,15 @@ eval_cond(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 		cf_assert(op_case->code == VOP_COND_CASE, AS_EXP, "unexpected");
 
 		if (ret_val->r_trilean == AS_EXP_TRUE) {
-			rt_skip(rt, rt->op_ix + 1);
+			// Step over the case marker only.
+			rt->op_ix++;
+			rt->instr_ptr += op_table[VOP_COND_CASE].size;
 			rt_eval(rt, ret_val);
-			rt_skip(rt, ob->instr_end_ix);
+			rt_skip(rt, ob);
 			return;
 		}
 
-		rt_skip(rt, op_case->instr_end_ix);
+		rt_skip(rt, op_case);
 	}
 
 	rt_eval(rt, ret_val);
@@ -3947,8 +4177,8 @@ eval_call(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 					! rt_value_bin_translate(&to, from)) {
 				ret_val->type = RT_TRILEAN;
 				ret_val->r_trilean = AS_EXP_UNK;
-				rt_skip(rt, ob->instr_end_ix);
-				call_cleanup(blob_cleanup, blob_cleanup_ix, bin_cleanup,
+				rt_skip(rt, ob);
+				call_cleanup(rt, blob_cleanup, blob_cleanup_ix, bin_cleanup,
 						bin_cleanup_ix);
 				return;
 			}
@@ -3982,7 +4212,8 @@ eval_call(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 			case RT_BLOB:
 			case RT_HLL:
 			case RT_GEO_STR: {
-				uint8_t* p = cf_malloc(as_pack_str_size(to.r_bytes.sz + 1));
+				uint8_t* p = rt_temp_alloc(rt,
+						as_pack_str_size(to.r_bytes.sz + 1));
 				as_packer strpk = { .buffer = p, .capacity = UINT32_MAX };
 
 				pack_typed_str(&strpk, to.r_bytes.contents, to.r_bytes.sz,
@@ -4069,7 +4300,7 @@ eval_call(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 		if (! msgpack_to_bin(rt, &bin_arg.r_bin, &temp, NULL)) {
 			ret_val->type = RT_TRILEAN;
 			ret_val->r_trilean = AS_EXP_UNK;
-			call_cleanup(blob_cleanup, blob_cleanup_ix, bin_cleanup,
+			call_cleanup(rt, blob_cleanup, blob_cleanup_ix, bin_cleanup,
 					bin_cleanup_ix);
 			return;
 		}
@@ -4082,7 +4313,7 @@ eval_call(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 	default:
 		ret_val->type = RT_TRILEAN;
 		ret_val->r_trilean = AS_EXP_UNK;
-		call_cleanup(blob_cleanup, blob_cleanup_ix, bin_cleanup,
+		call_cleanup(rt, blob_cleanup, blob_cleanup_ix, bin_cleanup,
 				bin_cleanup_ix);
 		return;
 	}
@@ -4119,7 +4350,7 @@ eval_call(runtime* rt, const op_base_mem* ob, rt_value* ret_val)
 		cf_crash(AS_EXP, "unexpected");
 	}
 
-	call_cleanup(blob_cleanup, blob_cleanup_ix, bin_cleanup, bin_cleanup_ix);
+	call_cleanup(rt, blob_cleanup, blob_cleanup_ix, bin_cleanup, bin_cleanup_ix);
 
 	if (ret != AS_OK) {
 		rt_value_destroy(&bin_arg);
@@ -4378,15 +4609,11 @@ bin_is_type(const as_bin* b, result_type type)
 }
 
 static void
-rt_skip(runtime* rt, uint32_t instr_end_ix)
+rt_skip(runtime* rt, const op_base_mem* ob)
 {
-	while (rt->op_ix < instr_end_ix) {
-		op_base_mem* ob = (op_base_mem*)rt->instr_ptr;
-		const op_table_entry* entry = &op_table[ob->code];
-
-		rt->op_ix++;
-		rt->instr_ptr += entry->size;
-	}
+	// Jump straight past ob's subtree - no need to walk the skipped ops.
+	rt->op_ix = ob->instr_end_ix;
+	rt->instr_ptr = (const uint8_t*)ob + ob->instr_end_offset;
 }
 
 static void
@@ -4507,6 +4734,121 @@ get_live_bin(as_storage_rd* rd, const uint8_t* name, size_t len, as_bin** p_bin)
 	return true;
 }
 
+static bool
+rt_get_live_bin(runtime* rt, const uint8_t* name, uint32_t len, uint32_t slot,
+		as_bin** p_bin)
+{
+	if (slot == NO_BIN_SLOT) {
+		return get_live_bin(rt->ctx->rd, name, len, p_bin);
+	}
+
+	uint64_t mask = 1UL << slot;
+
+	if ((rt->bins_fetched & mask) != 0) {
+		*p_bin = rt->bins[slot];
+		return true;
+	}
+
+	if (! get_live_bin(rt->ctx->rd, name, len, p_bin)) {
+		return false;
+	}
+
+	rt->bins[slot] = *p_bin;
+	rt->bins_fetched |= mask;
+
+	return true;
+}
+
+
+//==========================================================
+// Local helpers - runtime batch metadata utilities.
+//
+
+// Same values as the corresponding eval_meta_*() functions.
+static void
+meta_column(const as_exp_meta_term* term, as_record* const* rs, uint32_t n_rs,
+		int64_t* vals)
+{
+	switch (term->field) {
+	case EXP_META_DIGEST_MOD:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			uint32_t val = *(uint32_t*)&rs[i]->keyd.digest[16];
+
+			vals[i] = (int64_t)val % term->mod;
+		}
+		break;
+	case EXP_META_LAST_UPDATE:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			vals[i] = (int64_t)cf_utc_ns_from_clepoch_ms(
+					rs[i]->last_update_time);
+		}
+		break;
+	case EXP_META_SINCE_UPDATE: {
+		uint64_t now = cf_clepoch_milliseconds();
+
+		for (uint32_t i = 0; i < n_rs; i++) {
+			uint64_t lut = rs[i]->last_update_time;
+
+			vals[i] = (int64_t)(now > lut ? now - lut : 0);
+		}
+		break;
+	}
+	case EXP_META_VOID_TIME:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			uint32_t void_time = rs[i]->void_time;
+
+			vals[i] = void_time == 0 ?
+					-1 : (int64_t)cf_utc_ns_from_clepoch_sec(void_time);
+		}
+		break;
+	default:
+		cf_crash(AS_EXP, "unexpected meta field %u", term->field);
+	}
+}
+
+// Branch-free loops, so the compiler can vectorize them.
+static void
+meta_column_cmp(const as_exp_meta_term* term, const int64_t* vals,
+		uint32_t n_rs, uint8_t* keep)
+{
+	int64_t value = term->value;
+
+	switch (term->cmp) {
+	case EXP_CMP_EQ:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			keep[i] &= (uint8_t)(vals[i] == value);
+		}
+		break;
+	case EXP_CMP_NE:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			keep[i] &= (uint8_t)(vals[i] != value);
+		}
+		break;
+	case EXP_CMP_GT:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			keep[i] &= (uint8_t)(vals[i] > value);
+		}
+		break;
+	case EXP_CMP_GE:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			keep[i] &= (uint8_t)(vals[i] >= value);
+		}
+		break;
+	case EXP_CMP_LT:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			keep[i] &= (uint8_t)(vals[i] < value);
+		}
+		break;
+	case EXP_CMP_LE:
+		for (uint32_t i = 0; i < n_rs; i++) {
+			keep[i] &= (uint8_t)(vals[i] <= value);
+		}
+		break;
+	default:
+		cf_crash(AS_EXP, "unexpected meta cmp %u", term->cmp);
+	}
+}
+
 
 //==========================================================
 // Local helpers - runtime compare utilities.
@@ -4687,10 +5029,11 @@ cmp_msgpack(exp_op_code code, const rt_value* v0, const rt_value* v1)
 //
 
 static void
-call_cleanup(void** blob, uint32_t blob_ix, as_bin** bin, uint32_t bin_ix)
+call_cleanup(runtime* rt, void** blob, uint32_t blob_ix, as_bin** bin,
+		uint32_t bin_ix)
 {
 	for (uint32_t i = 0; i < blob_ix; i++) {
-		cf_free(blob[i]);
+		rt_temp_free(rt, blob[i]);
 	}
 
 	for (uint32_t i = 0; i < bin_ix; i++) {
@@ -4807,6 +5150,36 @@ rt_alloc_mem(runtime* rt, size_t sz, cf_ll_buf* ll_buf)
 	return rt->alloc_ns ? cf_malloc_ns(sz) : cf_malloc(sz);
 }
 
+// Scratch memory that doesn't outlive the eval - never becomes a particle.
+static void*
+rt_temp_alloc(runtime* rt, size_t sz)
+{
+	size_t aligned_sz = (sz + 7) & ~(size_t)7;
+
+	if (rt->arena != NULL && aligned_sz <= RT_ARENA_SIZE - rt->arena_used) {
+		void* p = rt->arena + rt->arena_used;
+
+		rt->arena_used += (uint32_t)aligned_sz;
+
+		return p;
+	}
+
+	return cf_malloc(sz);
+}
+
+static void
+rt_temp_free(runtime* rt, void* p)
+{
+	uint8_t* p8 = (uint8_t*)p;
+
+	if (rt->arena != NULL && p8 >= rt->arena &&
+			p8 < rt->arena + RT_ARENA_SIZE) {
+		return; // released with the arena
+	}
+
+	cf_free(p);
+}
+
 static bool
 msgpack_to_bin(runtime* rt, as_bin* to, rt_value* from, cf_ll_buf* ll_buf)
 {
@@ -141,6 +141,7 @@ static const stat_spec ns_stat_spec[] = {
 //
 
 bool g_health_enabled = false;
+bool g_health_device_outlier[AS_NAMESPACE_SZ] = { false };
 
 __thread uint64_t g_device_read_counter = 0;
 __thread uint64_t g_replica_write_counter = 0;
@@ -304,6 +305,35 @@ as_health_get_stats(cf_dyn_buf* db)
 	cf_dyn_buf_chomp(db);
 }
 
+// Average device read latency over the current and previous detection
+// intervals - recent enough for clients weighting replica reads.
+bool
+as_health_recent_read_latency(uint32_t ns_ix, uint32_t* lat_us)
+{
+	if (! g_health_enabled) {
+		return false;
+	}
+
+	const stat_spec* spec = &local_stat_spec[AS_HEALTH_LOCAL_DEVICE_READ_LAT];
+	uint32_t n_devices = as_namespace_device_count(g_config.namespaces[ns_ix]);
+	uint64_t sample_sum = 0;
+	uint64_t n_samples = 0;
+
+	for (uint32_t d_id = 0; d_id < n_devices; d_id++) {
+		health_stat* hs = &g_local_stats.device_read_lat[ns_ix][d_id];
+		uint32_t cur = hs->cur_bucket;
+		uint32_t prev = (cur + spec->n_buckets - 1) % spec->n_buckets;
+
+		sample_sum += hs->buckets[cur].sample_sum +
+				hs->buckets[prev].sample_sum;
+		n_samples += hs->buckets[cur].n_samples + hs->buckets[prev].n_samples;
+	}
+
+	*lat_us = n_samples == 0 ? 0 : (uint32_t)(sample_sum / n_samples);
+
+	return true;
+}
+
 void
 as_health_start()
 {
@@ -575,9 +605,13 @@ find_outliers_from_local_stats(local_all_mov_avg* lma)
 		mov_avg* dma = lma->device_mov_avg[ns_ix];
 		const stat_spec* spec =
 				&local_stat_spec[AS_HEALTH_LOCAL_DEVICE_READ_LAT];
+		uint32_t n_outliers = cf_vector_size(g_outliers);
 
 		find_outlier_per_stat(dma, n_devices, spec->threshold, spec->stat_str,
 				ns_ix);
+
+		g_health_device_outlier[ns_ix] =
+				cf_vector_size(g_outliers) != n_outliers;
 	}
 }
 
@@ -790,6 +824,8 @@ reset_local_stats()
 			memset(hs->buckets, 0, buckets_sz);
 			hs->cur_bucket = 0;
 		}
+
+		g_health_device_outlier[ns_ix] = false;
 	}
 }
 
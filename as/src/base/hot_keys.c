@@ -0,0 +1,257 @@
+/*
+ * hot_keys.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * Per-namespace Space-Saving top-K of sampled read & write digests, in
+ * tumbling windows. Only sampled transactions take the lock, so a modest
+ * table scanned linearly is cheap enough. Counts are over-estimates bounded by
+ * the reported error, which is inherited from the entry a key displaced.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "base/hot_keys.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
+#include "citrusleaf/cf_digest.h"
+
+#include "cf_mutex.h"
+#include "dynbuf.h"
+
+#include "base/datamodel.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_TRACKED 64
+#define WINDOW_MS (10 * 1000)
+
+typedef struct hot_key_s {
+	cf_digest keyd;
+	uint32_t count; // sampled hits, including error
+	uint32_t error; // max over-estimate - inherited from displaced entry
+	uint32_t n_reads;
+	uint32_t n_writes;
+} hot_key;
+
+typedef struct as_hot_keys_s {
+	cf_mutex lock;
+
+	// Current window.
+	uint64_t start_ms;
+	uint32_t sample_period;
+	uint32_t n_keys;
+	hot_key keys[N_TRACKED];
+
+	// Last complete window - sorted by count, descending.
+	uint64_t last_duration_ms;
+	uint32_t last_sample_period;
+	uint32_t n_last_keys;
+	hot_key last_keys[N_TRACKED];
+} as_hot_keys;
+
+
+//==========================================================
+// Globals.
+//
+
+__thread uint32_t g_hot_key_counter = 0;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void close_window(as_hot_keys* hk, uint64_t now_ms, uint32_t sample_period);
+static int compare_counts(const void* pa, const void* pb);
+static double to_rate(uint64_t n_sampled, uint32_t sample_period, uint64_t duration_ms);
+
+
+//==========================================================
+// Public API.
+//
+
+as_hot_keys*
+as_hot_keys_create(void)
+{
+	as_hot_keys* hk = cf_calloc(1, sizeof(as_hot_keys));
+
+	cf_mutex_init(&hk->lock);
+
+	return hk;
+}
+
+void
+as_hot_keys_get(as_namespace* ns, uint32_t max_keys, cf_dyn_buf* db)
+{
+	as_hot_keys* hk = ns->hot_keys;
+
+	cf_mutex_lock(&hk->lock);
+
+	uint64_t now_ms = cf_getms();
+
+	// Keep a quiet namespace from showing a stale window forever.
+	if (hk->start_ms != 0 && now_ms - hk->start_ms >= WINDOW_MS) {
+		close_window(hk, now_ms, hk->sample_period);
+	}
+
+	uint32_t n_keys = hk->n_last_keys < max_keys ? hk->n_last_keys : max_keys;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		const hot_key* k = &hk->last_keys[i];
+		char digest_str[(sizeof(cf_digest) * 2) + 1];
+
+		for (uint32_t b = 0; b < sizeof(cf_digest); b++) {
+			sprintf(&digest_str[b * 2], "%02x", k->keyd.digest[b]);
+		}
+
+		cf_dyn_buf_append_string(db, "digest=");
+		cf_dyn_buf_append_string(db, digest_str);
+		cf_dyn_buf_append_format(db, ":ops_per_sec=%.1f",
+				to_rate(k->count, hk->last_sample_period, hk->last_duration_ms));
+		cf_dyn_buf_append_format(db, ":reads_per_sec=%.1f",
+				to_rate(k->n_reads, hk->last_sample_period,
+						hk->last_duration_ms));
+		cf_dyn_buf_append_format(db, ":writes_per_sec=%.1f",
+				to_rate(k->n_writes, hk->last_sample_period,
+						hk->last_duration_ms));
+		cf_dyn_buf_append_format(db, ":error_per_sec=%.1f;",
+				to_rate(k->error, hk->last_sample_period,
+						hk->last_duration_ms));
+	}
+
+	cf_mutex_unlock(&hk->lock);
+
+	cf_dyn_buf_chomp_char(db, ';');
+}
+
+void
+hot_keys_add(as_hot_keys* hk, uint32_t sample_period, const cf_digest* keyd,
+		bool is_write)
+{
+	cf_mutex_lock(&hk->lock);
+
+	uint64_t now_ms = cf_getms();
+
+	if (hk->start_ms == 0) {
+		hk->start_ms = now_ms;
+		hk->sample_period = sample_period;
+	}
+	else if (now_ms - hk->start_ms >= WINDOW_MS ||
+			sample_period != hk->sample_period) {
+		close_window(hk, now_ms, sample_period);
+	}
+
+	hot_key* k = NULL;
+	hot_key* min_k = NULL;
+
+	for (uint32_t i = 0; i < hk->n_keys; i++) {
+		hot_key* cur = &hk->keys[i];
+
+		if (memcmp(&cur->keyd, keyd, sizeof(cf_digest)) == 0) {
+			k = cur;
+			break;
+		}
+
+		if (min_k == NULL || cur->count < min_k->count) {
+			min_k = cur;
+		}
+	}
+
+	if (k == NULL) {
+		if (hk->n_keys < N_TRACKED) {
+			k = &hk->keys[hk->n_keys++];
+			k->error = 0;
+			k->count = 0;
+		}
+		else {
+			// Space-Saving - displace the minimum, inheriting its count.
+			k = min_k;
+			k->error = min_k->count;
+		}
+
+		k->keyd = *keyd;
+		k->n_reads = 0;
+		k->n_writes = 0;
+	}
+
+	k->count++;
+
+	if (is_write) {
+		k->n_writes++;
+	}
+	else {
+		k->n_reads++;
+	}
+
+	cf_mutex_unlock(&hk->lock);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+close_window(as_hot_keys* hk, uint64_t now_ms, uint32_t sample_period)
+{
+	memcpy(hk->last_keys, hk->keys, hk->n_keys * sizeof(hot_key));
+	qsort(hk->last_keys, hk->n_keys, sizeof(hot_key), compare_counts);
+
+	hk->last_duration_ms = now_ms - hk->start_ms;
+	hk->last_sample_period = hk->sample_period;
+	hk->n_last_keys = hk->n_keys;
+
+	hk->start_ms = now_ms;
+	hk->sample_period = sample_period;
+	hk->n_keys = 0;
+}
+
+static int
+compare_counts(const void* pa, const void* pb)
+{
+	uint32_t a = ((const hot_key*)pa)->count;
+	uint32_t b = ((const hot_key*)pb)->count;
+
+	return a > b ? -1 : (a < b ? 1 : 0);
+}
+
+static double
+to_rate(uint64_t n_sampled, uint32_t sample_period, uint64_t duration_ms)
+{
+	if (duration_ms == 0) {
+		return 0.0;
+	}
+
+	return (double)(n_sampled * sample_period) * 1000.0 / (double)duration_ms;
+}
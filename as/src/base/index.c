@@ -30,14 +30,17 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 #include <xmmintrin.h>
 
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_digest.h"
 #include "citrusleaf/cf_queue.h"
 
 #include "arenax.h"
+#include "bits.h"
 #include "cf_mutex.h"
 #include "cf_thread.h"
 #include "log.h"
@@ -54,6 +57,37 @@
 // Typedefs & constants.
 //
 
+// Optimistic lookups give up if a sprig seems deeper than any sane tree.
+#define MAX_OPTIMISTIC_DEPTH 64
+
+// Number of lookups advanced in lockstep by as_index_prefetch_multi().
+#define PREFETCH_GROUP_SIZE 16
+
+// Number of collected elements passed to a reduce filter at a time.
+#define FILTER_BATCH_SIZE 256
+
+// How long a sprig split waits for running reduces before backing off.
+#define SPLIT_DRAIN_MS 100
+
+// A Bloom filter block is a cache line - each digest sets one bit per word.
+#define BLOOM_BLOCK_N_WORDS 8
+
+// Small trees aren't worth rebuilding for a handful of deletes.
+#define BLOOM_MIN_REBUILD_DELETES 1024
+
+typedef struct prefetch_lookup_s {
+	const cf_digest* keyd;
+	const cf_arenax* arena;
+	const as_sprig* sprig; // set until root handle is read
+	cf_arenax_handle r_h;
+} prefetch_lookup;
+
+typedef struct cursor_no_rc_info_s {
+	as_index_reduce_fn cb;
+	void* udata;
+	cf_digest last_keyd;
+} cursor_no_rc_info;
+
 typedef struct as_index_ele_s {
 	struct as_index_ele_s* parent;
 	cf_arenax_handle me_h;
@@ -66,6 +100,8 @@ typedef struct as_index_ele_s {
 //
 
 static cf_queue g_gc_queue;
+static uint32_t g_gc_n_active = 0;
+static uint64_t g_gc_n_freed = 0;
 
 
 //==========================================================
@@ -75,33 +111,68 @@ static cf_queue g_gc_queue;
 void* run_index_tree_gc(void* unused);
 void as_index_tree_destroy(as_index_tree* tree);
 
-bool as_index_sprig_reduce(as_index_sprig* isprig, const cf_digest* keyd, as_index_reduce_fn cb, void* udata);
+bool as_index_sprig_reduce(as_index_sprig* isprig, const cf_digest* keyd, as_index_filter_fn filter, as_index_reduce_fn cb, void* udata);
+bool cursor_no_rc_cb(as_index_ref* r_ref, void* udata);
+bool as_index_sprig_reduce_phs(as_index_sprig* isprig, as_index_ph_array* ph_a, as_index_filter_fn filter, as_index_reduce_fn cb, void* udata, cf_digest* last_keyd);
+void filter_phs(const as_index_ph_array* ph_a, uint32_t start, as_index_filter_fn filter, void* udata, uint8_t* keep);
 void as_index_sprig_traverse(as_index_sprig* isprig, const cf_digest* keyd, cf_arenax_handle r_h, as_index_ph_array* ph_a);
-void as_index_sprig_traverse_purge(as_index_sprig* isprig, cf_arenax_handle r_h);
+bool as_index_sprig_traverse_limit(as_index_sprig* isprig, const cf_digest* keyd, cf_arenax_handle r_h, as_index_ph_array* ph_a, uint32_t limit);
+bool as_index_sprig_traverse_blocked(as_index_sprig* isprig, cf_arenax_handle r_h, as_index_reduce_fn cb, void* udata);
+uint64_t as_index_sprig_traverse_purge(as_index_sprig* isprig, cf_arenax_handle r_h);
 
 int as_index_sprig_get_insert_vlock(as_index_sprig* isprig, uint8_t tree_id, const cf_digest* keyd, as_index_ref* index_ref);
 
 int as_index_sprig_search_lockless(as_index_sprig* isprig, const cf_digest* keyd, as_index** ret, cf_arenax_handle* ret_h);
+bool prefetch_lookup_start(prefetch_lookup* lookup, as_index_tree* tree, const cf_digest* keyd);
+bool prefetch_lookup_step(prefetch_lookup* lookup);
 void as_index_sprig_insert_rebalance(as_index_sprig* isprig, as_index* root_parent, as_index_ele* ele);
 void as_index_sprig_delete_rebalance(as_index_sprig* isprig, as_index* root_parent, as_index_ele* ele);
 void as_index_rotate_left(as_index_ele* a, as_index_ele* b);
 void as_index_rotate_right(as_index_ele* a, as_index_ele* b);
 
+static void reduce_enter(as_index_tree* tree);
+static void reduce_exit(as_index_tree* tree);
+static void cursor_remap(as_index_cursor* cursor);
+static bool split_enter(as_index_tree* tree);
+static void split_tree(as_index_tree* tree);
+static void split_sprig(as_index_tree* tree, const as_sprig_layout* from, as_sprig_layout* to, uint32_t sprig_i, as_index_ph_array* hi_a, as_index_ph_array* lo_a);
+static void split_collect(cf_arenax* arena, cf_arenax_handle r_h, uint32_t hi_i, uint32_t shift, as_index_ph_array* hi_a, as_index_ph_array* lo_a);
+static cf_arenax_handle split_build(const as_index_ph* phs, uint32_t n_phs, uint32_t depth, uint32_t red_depth);
+static as_index_bloom* bloom_create(uint32_t size);
+static void bloom_destroy(as_index_bloom* bloom);
+static bool bloom_may_contain(as_index_bloom* bloom, const cf_digest* keyd);
+static void bloom_add(as_index_bloom* bloom, const cf_digest* keyd);
+static void bloom_set(as_index_bloom* bloom, uint32_t half_i, const cf_digest* keyd);
+static void bloom_fill(as_index_sprig* isprig, as_index_bloom* bloom, uint32_t half_i, cf_arenax_handle r_h);
+
 static inline void
-as_index_sprig_from_i(as_index_tree* tree, as_index_sprig* isprig,
-		uint32_t sprig_i)
+as_index_sprig_from_i(as_index_tree* tree, const as_sprig_layout* layout,
+		as_index_sprig* isprig, uint32_t sprig_i)
 {
-	uint32_t lock_i = sprig_i >>
-			(tree->shared->locks_shift - tree->shared->sprigs_shift);
+	uint32_t lock_i = sprig_i >> (tree->shared->locks_shift - layout->shift);
 
+	isprig->tree = tree;
 	isprig->destructor = tree->shared->destructor;
 	isprig->destructor_udata = tree->shared->destructor_udata;
 	isprig->arena = tree->shared->arena;
 	isprig->pair = tree_locks(tree) + lock_i;
-	isprig->sprig = tree_sprigs(tree) + sprig_i;
+	isprig->sprig = layout->sprigs + sprig_i;
 	isprig->puddle = tree_puddle_for_sprig(tree, sprig_i);
 }
 
+static inline void
+ph_array_append(as_index_ph_array* ph_a, as_index* r, cf_arenax_handle r_h)
+{
+	if (ph_a->n_used == ph_a->capacity) {
+		as_index_grow_ph_array(ph_a);
+	}
+
+	as_index_ph* ph = &ph_a->phs[ph_a->n_used++];
+
+	ph->r = r;
+	ph->r_h = r_h;
+}
+
 
 //==========================================================
 // Public API - garbage collection system.
@@ -111,7 +182,10 @@ void
 as_index_tree_gc_init()
 {
 	cf_queue_init(&g_gc_queue, sizeof(as_index_tree*), 4096, true);
-	cf_thread_create_detached(run_index_tree_gc, NULL);
+
+	for (uint32_t i = 0; i < g_config.n_index_tree_gc_threads; i++) {
+		cf_thread_create_detached(run_index_tree_gc, NULL);
+	}
 }
 
 uint32_t
@@ -120,6 +194,18 @@ as_index_tree_gc_queue_size()
 	return cf_queue_sz(&g_gc_queue);
 }
 
+uint32_t
+as_index_tree_gc_n_active()
+{
+	return as_load_uint32(&g_gc_n_active);
+}
+
+uint64_t
+as_index_tree_gc_n_freed()
+{
+	return as_load_uint64(&g_gc_n_freed);
+}
+
 void
 as_index_tree_gc(as_index_tree* tree)
 {
@@ -136,12 +222,14 @@ as_index_tree*
 as_index_tree_create(as_index_tree_shared* shared, uint8_t id,
 		as_index_tree_done_fn cb, void* udata)
 {
-	size_t locks_size = sizeof(cf_mutex) * NUM_LOCK_PAIRS * 2;
-	size_t sprigs_size = sizeof(as_sprig) * shared->n_sprigs;
+	// Sprig count may be raised online - read it once.
+	uint32_t n_sprigs = as_load_uint32(&shared->n_sprigs);
+
+	size_t sprigs_size = sizeof(as_sprig) * n_sprigs;
 	size_t puddles_size = tree_puddles_size(shared);
 
 	size_t tree_size = sizeof(as_index_tree) +
-			locks_size + sprigs_size + puddles_size;
+			shared->sprigs_offset + sprigs_size + puddles_size;
 
 	as_index_tree* tree = cf_rc_alloc(tree_size);
 
@@ -152,6 +240,24 @@ as_index_tree_create(as_index_tree_shared* shared, uint8_t id,
 	tree->shared = shared;
 	tree->n_elements = 0;
 
+	tree->base_layout = (as_sprig_layout){
+			.shift = NUM_SPRIG_BITS - (uint32_t)cf_msb(n_sprigs),
+			.n_sprigs = n_sprigs,
+			.sprigs = (as_sprig*)(tree->data + shared->sprigs_offset),
+			.next_retired = NULL
+	};
+
+	tree->layout = &tree->base_layout;
+	tree->split_layout = NULL;
+	memset(tree->split_groups, 0, sizeof(tree->split_groups));
+	tree->retired_layouts = NULL;
+
+	tree->n_reducers = 0;
+	tree->splitting = 0;
+
+	tree->bloom = shared->bloom_size == 0 ?
+			NULL : bloom_create(shared->bloom_size);
+
 	cf_mutex_init(&tree->set_trees_lock);
 	memset(tree->set_trees, 0, sizeof(tree->set_trees));
 
@@ -229,6 +335,88 @@ as_index_tree_size(as_index_tree* tree)
 	return tree == NULL ? 0 : tree->n_elements;
 }
 
+// Double the tree's sprig count until it matches the namespace's. Only records
+// under the lock pair being split wait, one pair at a time. Returns false if
+// running reduces didn't drain - caller should retry later.
+bool
+as_index_tree_split_sprigs(as_index_tree* tree)
+{
+	// Flash index puddles are laid out per sprig.
+	if (tree->shared->puddles_offset != 0) {
+		return true;
+	}
+
+	while (tree->layout->n_sprigs < as_load_uint32(&tree->shared->n_sprigs)) {
+		if (! split_enter(tree)) {
+			return false;
+		}
+
+		split_tree(tree);
+
+		as_store_uint32(&tree->splitting, 0);
+	}
+
+	return true;
+}
+
+// Rebuild the tree's Bloom filter if it was never built (tree resumed with
+// elements), or if deletes since the last rebuild have left it too many stale
+// bits. Fills the idle half from the tree, then swaps halves. Returns true if
+// rebuilt. Background use only - one caller per tree at a time.
+bool
+as_index_tree_rebuild_bloom(as_index_tree* tree)
+{
+	as_index_bloom* bloom = tree->bloom;
+
+	if (bloom == NULL) {
+		return false;
+	}
+
+	uint64_t n_deletes = as_load_uint64(&bloom->n_deletes);
+
+	if (as_load_uint32(&bloom->valid) != 0 &&
+			(n_deletes < BLOOM_MIN_REBUILD_DELETES ||
+					n_deletes < as_load_uint64(&tree->n_elements))) {
+		return false;
+	}
+
+	uint32_t half_i = (as_load_uint32(&bloom->gen) + 1) & 1;
+
+	// The idle half is only written by rebuilds, and probed only by lookups
+	// which will see the swap below and ignore what they read.
+	memset(bloom->halves[half_i], 0,
+			(size_t)bloom->n_blocks * BLOOM_BLOCK_N_WORDS * sizeof(uint64_t));
+
+	as_store_uint64(&bloom->n_deletes, 0);
+	as_store_uint32(&bloom->building, 1);
+	as_fence_seq();
+
+	// Inserts into a sprig either finish before we take its reduce lock (and
+	// we see the element) or start after (and see building set).
+
+	reduce_enter(tree);
+
+	const as_sprig_layout* layout = tree->layout;
+
+	for (uint32_t i = 0; i < layout->n_sprigs; i++) {
+		as_index_sprig isprig;
+		as_index_sprig_from_i(tree, layout, &isprig, i);
+
+		cf_mutex_lock(&isprig.pair->reduce_lock);
+		bloom_fill(&isprig, bloom, half_i, isprig.sprig->root_h);
+		cf_mutex_unlock(&isprig.pair->reduce_lock);
+	}
+
+	reduce_exit(tree);
+
+	as_incr_uint32(&bloom->gen);
+	as_store_uint32(&bloom->valid, 1);
+	as_fence_rls();
+	as_store_uint32(&bloom->building, 0);
+
+	return true;
+}
+
 
 //==========================================================
 // Public API - reduce a tree.
@@ -245,33 +433,230 @@ as_index_reduce(as_index_tree* tree, as_index_reduce_fn cb, void* udata)
 bool
 as_index_reduce_from(as_index_tree* tree, const cf_digest* keyd,
 		as_index_reduce_fn cb, void* udata)
+{
+	return as_index_reduce_from_filtered(tree, keyd, NULL, cb, udata);
+}
+
+// Like as_index_reduce_from(), but each batch of collected elements is first
+// passed to the filter, and the callback is skipped for elements it rejects.
+bool
+as_index_reduce_from_filtered(as_index_tree* tree, const cf_digest* keyd,
+		as_index_filter_fn filter, as_index_reduce_fn cb, void* udata)
 {
 	if (tree == NULL) {
 		return true;
 	}
 
+	reduce_enter(tree);
+
 	// Reduce sprigs from largest to smallest digests to preserve this order for
 	// the whole tree. (Rapid rebalance requires exact order.)
 
+	const as_sprig_layout* layout = tree->layout;
 	uint32_t start_sprig_i = keyd == NULL ?
-			tree->shared->n_sprigs - 1 : as_index_sprig_i_from_keyd(tree, keyd);
+			layout->n_sprigs - 1 : as_index_sprig_i_from_keyd(tree, keyd);
+	bool do_more = true;
 
-	for (int i = (int)start_sprig_i; i >= 0; i--) {
+	for (int i = (int)start_sprig_i; i >= 0 && do_more; i--) {
 		as_index_sprig isprig;
-		as_index_sprig_from_i(tree, &isprig, (uint32_t)i);
+		as_index_sprig_from_i(tree, layout, &isprig, (uint32_t)i);
 
 		if (tree->shared->puddles_offset == 0) {
-			if (! as_index_sprig_reduce(&isprig, keyd, cb, udata)) {
-				return false;
+			do_more = as_index_sprig_reduce(&isprig, keyd, filter, cb, udata);
+		}
+		else {
+			do_more = as_index_sprig_reduce_no_rc(&isprig, keyd, cb, udata);
+		}
+
+		keyd = NULL; // only need boundary digest for first sprig
+	}
+
+	reduce_exit(tree);
+
+	return do_more;
+}
+
+void
+as_index_cursor_init(as_index_cursor* cursor, as_index_tree* tree,
+		const cf_digest* keyd)
+{
+	cursor->tree = tree;
+
+	if (tree == NULL) {
+		cursor->sprig_i = -1;
+		cursor->has_keyd = false;
+		return;
+	}
+
+	const as_sprig_layout* layout = tree->layout;
+
+	cursor->sprigs_shift = layout->shift;
+	cursor->sprig_i = keyd == NULL ? (int32_t)layout->n_sprigs - 1 :
+			(int32_t)(as_index_sprig_bits(keyd) >> layout->shift);
+	cursor->has_keyd = keyd != NULL;
+
+	if (keyd != NULL) {
+		cursor->keyd = *keyd;
+	}
+}
+
+// Reduce from the cursor's position, collecting at most max_n elements, and
+// advance the cursor past the last element consumed. Only the sprig holding
+// the position is re-descended - earlier sprigs and the rest of the current
+// one are never collected. Returns false if the callback asked to stop.
+bool
+as_index_cursor_next(as_index_cursor* cursor, uint32_t max_n,
+		as_index_reduce_fn cb, void* udata)
+{
+	if (as_index_cursor_done(cursor)) {
+		return true;
+	}
+
+	as_index_tree* tree = cursor->tree;
+	uint32_t n_left = max_n;
+	bool rv = true;
+
+	reduce_enter(tree);
+	cursor_remap(cursor);
+
+	while (cursor->sprig_i >= 0 && n_left != 0) {
+		as_index_sprig isprig;
+		as_index_sprig_from_i(tree, tree->layout, &isprig,
+				(uint32_t)cursor->sprig_i);
+
+		const cf_digest* keyd = cursor->has_keyd ? &cursor->keyd : NULL;
+
+		// Flash index sprigs are only reduced whole - max_n isn't enforced.
+		if (tree->shared->puddles_offset != 0) {
+			cursor_no_rc_info info = { .cb = cb, .udata = udata };
+
+			if (! as_index_sprig_reduce_no_rc(&isprig, keyd, cursor_no_rc_cb,
+					&info)) {
+				cursor->keyd = info.last_keyd;
+				cursor->has_keyd = true;
+				rv = false;
+				break;
 			}
+
+			cursor->sprig_i--;
+			cursor->has_keyd = false;
+			continue;
+		}
+
+		cf_mutex_lock(&isprig.pair->reduce_lock);
+
+		// Common to encounter empty sprigs.
+		if (isprig.sprig->root_h == SENTINEL_H) {
+			cf_mutex_unlock(&isprig.pair->reduce_lock);
+			cursor->sprig_i--;
+			cursor->has_keyd = false;
+			continue;
+		}
+
+		as_index_ph stack_phs[MAX_STACK_PHS];
+		as_index_ph_array ph_a = {
+				.is_stack = true,
+				.capacity = MAX_STACK_PHS,
+				.phs = stack_phs
+		};
+
+		bool more_in_sprig = as_index_sprig_traverse_limit(&isprig, keyd,
+				isprig.sprig->root_h, &ph_a, n_left);
+
+		cf_mutex_unlock(&isprig.pair->reduce_lock);
+
+		n_left -= ph_a.n_used;
+
+		cf_digest last_keyd;
+		bool do_more = as_index_sprig_reduce_phs(&isprig, &ph_a, NULL, cb,
+				udata, &last_keyd);
+
+		if (! do_more || more_in_sprig) {
+			cursor->keyd = last_keyd;
+			cursor->has_keyd = true;
+		}
+		else {
+			cursor->sprig_i--;
+			cursor->has_keyd = false;
+		}
+
+		if (! do_more) {
+			rv = false;
+			break;
+		}
+	}
+
+	reduce_exit(tree);
+
+	return rv;
+}
+
+// Like as_index_reduce(), but only one slice of the tree's sprigs. Slices are
+// independent - callers may reduce them concurrently and in any order.
+bool
+as_index_reduce_slice(as_index_tree* tree, uint32_t slice_i,
+		as_index_reduce_fn cb, void* udata)
+{
+	if (tree == NULL) {
+		return true;
+	}
+
+	reduce_enter(tree);
+
+	const as_sprig_layout* layout = tree->layout;
+	uint32_t n_sprigs = layout->n_sprigs / AS_INDEX_N_REDUCE_SLICES;
+	uint32_t start_sprig_i = (slice_i + 1) * n_sprigs;
+	bool do_more = true;
+
+	for (uint32_t i = start_sprig_i; i > start_sprig_i - n_sprigs && do_more;
+			i--) {
+		as_index_sprig isprig;
+		as_index_sprig_from_i(tree, layout, &isprig, i - 1);
+
+		if (tree->shared->puddles_offset == 0) {
+			do_more = as_index_sprig_reduce(&isprig, NULL, NULL, cb, udata);
 		}
 		else {
-			if (! as_index_sprig_reduce_no_rc(&isprig, keyd, cb, udata)) {
+			do_more = as_index_sprig_reduce_no_rc(&isprig, NULL, cb, udata);
+		}
+	}
+
+	reduce_exit(tree);
+
+	return do_more;
+}
+
+// For a tree already blocked by as_index_tree_block() - e.g. at shutdown. Makes
+// a callback for every element, in-line and without taking any locks. Callback
+// must NOT call as_record_done().
+bool
+as_index_reduce_blocked(as_index_tree* tree, as_index_reduce_fn cb,
+		void* udata)
+{
+	if (tree == NULL) {
+		return true;
+	}
+
+	cf_assert(tree->shared->puddles_offset == 0, AS_INDEX,
+			"blocked reduce of flash index");
+
+	// A split may have been blocked part way - each lock pair knows which
+	// layout its sprigs are in.
+	for (uint32_t lock_i = NUM_LOCK_PAIRS; lock_i > 0; lock_i--) {
+		const as_sprig_layout* layout =
+				as_index_layout_for_lock(tree, lock_i - 1);
+		uint32_t n_lock_sprigs = layout->n_sprigs / NUM_LOCK_PAIRS;
+		uint32_t end_i = lock_i * n_lock_sprigs;
+
+		for (uint32_t i = end_i; i > end_i - n_lock_sprigs; i--) {
+			as_index_sprig isprig;
+			as_index_sprig_from_i(tree, layout, &isprig, i - 1);
+
+			if (! as_index_sprig_traverse_blocked(&isprig,
+					isprig.sprig->root_h, cb, udata)) {
 				return false;
 			}
 		}
-
-		keyd = NULL; // only need boundary digest for first sprig
 	}
 
 	return true;
@@ -296,12 +681,81 @@ as_index_get_vlock(as_index_tree* tree, const cf_digest* keyd,
 		return -1;
 	}
 
+	if (tree->bloom != NULL && ! bloom_may_contain(tree->bloom, keyd)) {
+		return -1;
+	}
+
 	as_index_sprig isprig;
 	as_index_sprig_from_keyd(tree, &isprig, keyd);
 
 	return as_index_sprig_get_vlock(&isprig, keyd, index_ref);
 }
 
+// If there's an element with specified digest in the tree, copy it to snapshot,
+// without taking the record lock. The result only stands if no one held the
+// sprig's lock meanwhile - otherwise caller must use the locked path.
+//
+// Returns:
+//		 0 - found (copy returned in snapshot)
+//		-1 - not found
+//		-2 - raced with lock holder (snapshot untouched)
+int
+as_index_get_optimistic(as_index_tree* tree, const cf_digest* keyd,
+		as_index* snapshot)
+{
+	if (tree == NULL) {
+		return -1;
+	}
+
+	if (tree->bloom != NULL && ! bloom_may_contain(tree->bloom, keyd)) {
+		return -1;
+	}
+
+	// Flash index elements aren't in memory - keep the locked path.
+	if (tree->shared->puddles_offset != 0) {
+		return -2;
+	}
+
+	as_index_sprig isprig;
+	as_index_sprig_from_keyd(tree, &isprig, keyd);
+
+	uint32_t seq = as_load_uint32(&isprig.pair->seq);
+
+	if ((seq & 1) != 0) {
+		return -2;
+	}
+
+	as_fence_acq();
+
+	int rv = -1;
+	cf_arenax_handle r_h = isprig.sprig->root_h;
+
+	for (uint32_t depth = 0; r_h != SENTINEL_H; depth++) {
+		// Handles may be mid-change - never resolve one outside the arena.
+		if (depth == MAX_OPTIMISTIC_DEPTH ||
+				! cf_arenax_handle_in_range(isprig.arena, r_h)) {
+			return -2;
+		}
+
+		const as_index* r = cf_arenax_resolve(isprig.arena, r_h);
+		int cmp = cf_digest_compare(keyd, &r->keyd);
+
+		if (cmp == 0) {
+			// Element may be compact - dim stays zeroed in the snapshot.
+			memset(snapshot, 0, sizeof(as_index));
+			memcpy(snapshot, r, isprig.arena->element_size);
+			rv = 0;
+			break;
+		}
+
+		r_h = cmp > 0 ? r->left_h : r->right_h;
+	}
+
+	as_fence_acq();
+
+	return as_load_uint32(&isprig.pair->seq) == seq ? rv : -2;
+}
+
 // If there's an element with specified digest in the tree, return a locked
 // reference to it in index_ref. If not, create an element with this digest,
 // insert it into the tree, and return a locked reference to it in index_ref.
@@ -324,6 +778,11 @@ as_index_get_insert_vlock(as_index_tree* tree, const cf_digest* keyd,
 
 	if (result == 1) {
 		as_incr_uint64(&tree->n_elements);
+
+		// Still under the record lock - set before anyone can read the record.
+		if (tree->bloom != NULL) {
+			bloom_add(tree->bloom, keyd);
+		}
 	}
 
 	return result;
@@ -345,10 +804,49 @@ as_index_delete(as_index_tree* tree, const cf_digest* keyd)
 
 	if (as_index_sprig_delete(&isprig, keyd) == 0) {
 		as_decr_uint64(&tree->n_elements);
+
+		if (tree->bloom != NULL) {
+			as_incr_uint64(&tree->bloom->n_deletes);
+		}
+	}
+}
+
+// Warm the cache for a set of upcoming lookups - descend many sprigs in
+// lockstep, prefetching each next level so that the misses overlap. Holds no
+// locks - elements may change underfoot, so results are only a cache hint.
+void
+as_index_prefetch_multi(as_index_tree* const* trees, const cf_digest* keyds,
+		uint32_t n_keys)
+{
+	prefetch_lookup group[PREFETCH_GROUP_SIZE];
+	uint32_t n_active = 0;
+	uint32_t next_i = 0;
+
+	while (true) {
+		while (n_active < PREFETCH_GROUP_SIZE && next_i < n_keys) {
+			if (prefetch_lookup_start(&group[n_active], trees[next_i],
+					&keyds[next_i])) {
+				n_active++;
+			}
+
+			next_i++;
+		}
+
+		if (n_active == 0) {
+			break;
+		}
+
+		for (uint32_t i = 0; i < n_active; i++) {
+			// Drop finished lookups - next pass will refill the group.
+			while (i < n_active && ! prefetch_lookup_step(&group[i])) {
+				group[i] = group[--n_active];
+			}
+		}
 	}
 }
 
 
+
 //==========================================================
 // Local helpers - garbage collection, generic.
 //
@@ -359,20 +857,57 @@ run_index_tree_gc(void* unused)
 	as_index_tree* tree;
 
 	while (cf_queue_pop(&g_gc_queue, &tree, CF_QUEUE_FOREVER) == CF_QUEUE_OK) {
+		as_incr_uint32(&g_gc_n_active);
 		as_index_tree_destroy(tree);
+		as_decr_uint32(&g_gc_n_active);
 	}
 
 	return NULL;
 }
 
+// Sleep as needed to keep this worker's share of index-tree-gc-max-rate.
+static void
+gc_throttle(uint64_t start_us, uint64_t n_freed)
+{
+	uint32_t max_rate = as_load_uint32(&g_config.index_tree_gc_max_rate);
+
+	if (max_rate == 0) {
+		return;
+	}
+
+	uint64_t thread_rate = max_rate / g_config.n_index_tree_gc_threads;
+
+	if (thread_rate == 0) {
+		thread_rate = 1;
+	}
+
+	uint64_t target_us = (n_freed * 1000000) / thread_rate;
+	uint64_t elapsed_us = cf_getus() - start_us;
+
+	if (target_us > elapsed_us) {
+		usleep((useconds_t)(target_us - elapsed_us));
+	}
+}
+
 void
 as_index_tree_destroy(as_index_tree* tree)
 {
-	for (uint32_t i = 0; i < tree->shared->n_sprigs; i++) {
+	uint64_t start_us = cf_getus();
+	uint64_t n_freed = 0;
+
+	// Purge a sprig at a time, so the rate limit can pace us in between.
+	for (uint32_t i = 0; i < tree->layout->n_sprigs; i++) {
 		as_index_sprig isprig;
-		as_index_sprig_from_i(tree, &isprig, i);
+		as_index_sprig_from_i(tree, tree->layout, &isprig, i);
 
-		as_index_sprig_traverse_purge(&isprig, isprig.sprig->root_h);
+		uint64_t n_sprig_freed = as_index_sprig_traverse_purge(&isprig,
+				isprig.sprig->root_h);
+
+		if (n_sprig_freed != 0) {
+			as_add_uint64(&g_gc_n_freed, (int64_t)n_sprig_freed);
+			n_freed += n_sprig_freed;
+			gc_throttle(start_us, n_freed);
+		}
 	}
 
 	cf_arenax_reclaim(tree->shared->arena, tree_puddles(tree),
@@ -387,6 +922,26 @@ as_index_tree_destroy(as_index_tree* tree)
 		pair++;
 	}
 
+	if (tree->layout != &tree->base_layout) {
+		cf_free(tree->layout);
+	}
+
+	as_sprig_layout* retired = tree->retired_layouts;
+
+	while (retired != NULL) {
+		as_sprig_layout* next = retired->next_retired;
+
+		if (retired != &tree->base_layout) {
+			cf_free(retired);
+		}
+
+		retired = next;
+	}
+
+	if (tree->bloom != NULL) {
+		bloom_destroy(tree->bloom);
+	}
+
 	tree->done_cb(tree->id, tree->udata);
 
 	cf_rc_free(tree);
@@ -397,11 +952,22 @@ as_index_tree_destroy(as_index_tree* tree)
 // Local helpers - reduce a sprig.
 //
 
+// Remember each element handed over, so a stop can be resumed after it.
+bool
+cursor_no_rc_cb(as_index_ref* r_ref, void* udata)
+{
+	cursor_no_rc_info* info = (cursor_no_rc_info*)udata;
+
+	info->last_keyd = r_ref->r->keyd;
+
+	return info->cb(r_ref, info->udata);
+}
+
 // Make a callback for a specified number of elements in the tree, from outside
 // the tree lock.
 bool
 as_index_sprig_reduce(as_index_sprig* isprig, const cf_digest* keyd,
-		as_index_reduce_fn cb, void* udata)
+		as_index_filter_fn filter, as_index_reduce_fn cb, void* udata)
 {
 	cf_mutex_lock(&isprig->pair->reduce_lock);
 
@@ -423,17 +989,36 @@ as_index_sprig_reduce(as_index_sprig* isprig, const cf_digest* keyd,
 
 	cf_mutex_unlock(&isprig->pair->reduce_lock);
 
+	return as_index_sprig_reduce_phs(isprig, &ph_a, filter, cb, udata, NULL);
+}
+
+// Make callbacks for collected elements, then free a heap array. Reports the
+// digest of the last element consumed before the callback asked to stop.
+bool
+as_index_sprig_reduce_phs(as_index_sprig* isprig, as_index_ph_array* ph_a,
+		as_index_filter_fn filter, as_index_reduce_fn cb, void* udata,
+		cf_digest* last_keyd)
+{
 	bool do_more = true;
+	uint8_t keep[FILTER_BATCH_SIZE];
+
+	for (uint32_t i = 0; i < ph_a->n_used; i++) {
+		if (filter != NULL && i % FILTER_BATCH_SIZE == 0 && do_more) {
+			filter_phs(ph_a, i, filter, udata, keep);
+		}
 
-	for (uint32_t i = 0; i < ph_a.n_used; i++) {
-		as_index_ph* ph = &ph_a.phs[i];
+		as_index_ph* ph = &ph_a->phs[i];
 		as_index_ref r_ref = {
 				.r = ph->r,
 				.r_h = ph->r_h,
 				.olock = &isprig->pair->lock
 		};
 
-		cf_mutex_lock(r_ref.olock);
+		as_index_olock_lock(r_ref.olock);
+
+		if (do_more && last_keyd != NULL) {
+			*last_keyd = r_ref.r->keyd;
+		}
 
 		uint16_t rc = as_index_release(r_ref.r);
 
@@ -452,26 +1037,46 @@ as_index_sprig_reduce(as_index_sprig* isprig, const cf_digest* keyd,
 				as_sindex_gc_record(ns, &r_ref);
 			}
 
-			cf_mutex_unlock(r_ref.olock);
+			as_index_olock_unlock(r_ref.olock);
 			continue;
 		}
 
-		if (do_more) {
+		if (do_more && (filter == NULL || keep[i % FILTER_BATCH_SIZE] != 0)) {
 			// Callback MUST call as_record_done() to unlock record.
 			do_more = cb(&r_ref, udata);
 		}
 		else {
-			cf_mutex_unlock(r_ref.olock);
+			as_index_olock_unlock(r_ref.olock);
 		}
 	}
 
-	if (! ph_a.is_stack) {
-		cf_free(ph_a.phs);
+	if (! ph_a->is_stack) {
+		cf_free(ph_a->phs);
 	}
 
 	return do_more;
 }
 
+// Filter the next batch of collected elements. They're reserved but not
+// locked, so the filter may only use them as a hint - the callback rechecks.
+void
+filter_phs(const as_index_ph_array* ph_a, uint32_t start,
+		as_index_filter_fn filter, void* udata, uint8_t* keep)
+{
+	as_index* rs[FILTER_BATCH_SIZE];
+	uint32_t n_rs = ph_a->n_used - start;
+
+	if (n_rs > FILTER_BATCH_SIZE) {
+		n_rs = FILTER_BATCH_SIZE;
+	}
+
+	for (uint32_t i = 0; i < n_rs; i++) {
+		rs[i] = ph_a->phs[start + i].r;
+	}
+
+	filter(rs, n_rs, keep, udata);
+}
+
 void
 as_index_sprig_traverse(as_index_sprig* isprig, const cf_digest* keyd,
 		cf_arenax_handle r_h, as_index_ph_array* ph_a)
@@ -507,6 +1112,76 @@ as_index_sprig_traverse(as_index_sprig* isprig, const cf_digest* keyd,
 	as_index_sprig_traverse(isprig, keyd, r->right_h, ph_a);
 }
 
+// In-order callbacks without collecting - only safe if the sprig is blocked.
+bool
+as_index_sprig_traverse_blocked(as_index_sprig* isprig, cf_arenax_handle r_h,
+		as_index_reduce_fn cb, void* udata)
+{
+	if (r_h == SENTINEL_H) {
+		return true;
+	}
+
+	as_index* r = RESOLVE(r_h);
+
+	if (! as_index_sprig_traverse_blocked(isprig, r->left_h, cb, udata)) {
+		return false;
+	}
+
+	as_index_ref r_ref = {
+			.r = r,
+			.r_h = r_h,
+			.olock = NULL
+	};
+
+	if (! cb(&r_ref, udata)) {
+		return false;
+	}
+
+	return as_index_sprig_traverse_blocked(isprig, r->right_h, cb, udata);
+}
+
+// Like as_index_sprig_traverse(), but stops when the array holds limit
+// elements. Returns true if it stopped early.
+bool
+as_index_sprig_traverse_limit(as_index_sprig* isprig, const cf_digest* keyd,
+		cf_arenax_handle r_h, as_index_ph_array* ph_a, uint32_t limit)
+{
+	if (r_h == SENTINEL_H) {
+		return false;
+	}
+
+	as_index* r = RESOLVE(r_h);
+	int cmp = 0; // initialized to satisfy compiler
+
+	if (keyd == NULL || (cmp = cf_digest_compare(&r->keyd, keyd)) < 0) {
+		if (as_index_sprig_traverse_limit(isprig, keyd, r->left_h, ph_a,
+				limit)) {
+			return true;
+		}
+	}
+
+	if (keyd == NULL || cmp < 0) {
+		if (ph_a->n_used == limit) {
+			return true;
+		}
+
+		if (ph_a->n_used == ph_a->capacity) {
+			as_index_grow_ph_array(ph_a);
+		}
+
+		as_index_reserve(r);
+
+		as_index_ph* ph = &ph_a->phs[ph_a->n_used++];
+
+		ph->r = r;
+		ph->r_h = r_h;
+
+		keyd = NULL;
+	}
+
+	return as_index_sprig_traverse_limit(isprig, keyd, r->right_h, ph_a, limit);
+}
+
 void
 as_index_grow_ph_array(as_index_ph_array* ph_a)
 {
@@ -527,17 +1202,17 @@ as_index_grow_ph_array(as_index_ph_array* ph_a)
 	ph_a->capacity = new_capacity;
 }
 
-void
+uint64_t
 as_index_sprig_traverse_purge(as_index_sprig* isprig, cf_arenax_handle r_h)
 {
 	if (r_h == SENTINEL_H) {
-		return;
+		return 0;
 	}
 
 	as_index* r = RESOLVE(r_h);
 
-	as_index_sprig_traverse_purge(isprig, r->left_h);
-	as_index_sprig_traverse_purge(isprig, r->right_h);
+	uint64_t n_freed = as_index_sprig_traverse_purge(isprig, r->left_h) +
+			as_index_sprig_traverse_purge(isprig, r->right_h);
 
 	// There should be no references during a tree purge (reduce should have
 	// reserved the tree).
@@ -549,6 +1224,8 @@ as_index_sprig_traverse_purge(as_index_sprig* isprig, cf_arenax_handle r_h)
 	}
 
 	cf_arenax_free(isprig->arena, r_h, isprig->puddle);
+
+	return n_freed + 1;
 }
 
 
@@ -560,13 +1237,14 @@ int
 as_index_sprig_get_vlock(as_index_sprig* isprig, const cf_digest* keyd,
 		as_index_ref* index_ref)
 {
-	cf_mutex_lock(&isprig->pair->lock);
+	as_index_olock_lock(&isprig->pair->lock);
+	as_index_sprig_locate(isprig, keyd);
 
 	int rv = as_index_sprig_search_lockless(isprig, keyd, &index_ref->r,
 			&index_ref->r_h);
 
 	if (rv != 0) {
-		cf_mutex_unlock(&isprig->pair->lock);
+		as_index_olock_unlock(&isprig->pair->lock);
 		return rv;
 	}
 
@@ -592,7 +1270,8 @@ as_index_sprig_get_insert_vlock(as_index_sprig* isprig, uint8_t tree_id,
 	while (true) {
 		ele = eles;
 
-		cf_mutex_lock(&isprig->pair->lock);
+		as_index_olock_lock(&isprig->pair->lock);
+		as_index_sprig_locate(isprig, keyd);
 
 		// Search for the specified element, or a parent to insert it under.
 
@@ -638,7 +1317,7 @@ as_index_sprig_get_insert_vlock(as_index_sprig* isprig, uint8_t tree_id,
 
 		// The tree is being reduced - could take long, unlock so reads and
 		// overwrites aren't blocked.
-		cf_mutex_unlock(&isprig->pair->lock);
+		as_index_olock_unlock(&isprig->pair->lock);
 
 		// Wait until the tree reduce is done...
 		cf_mutex_lock(&isprig->pair->reduce_lock);
@@ -658,19 +1337,20 @@ as_index_sprig_get_insert_vlock(as_index_sprig* isprig, uint8_t tree_id,
 	if (n_h == 0) {
 		cf_ticker_warning(AS_INDEX, "arenax alloc failed");
 		cf_mutex_unlock(&isprig->pair->reduce_lock);
-		cf_mutex_unlock(&isprig->pair->lock);
+		as_index_olock_unlock(&isprig->pair->lock);
 		return -1;
 	}
 
 	as_index* n = RESOLVE(n_h);
 
-	*n = (as_index){
-		.tree_id = tree_id,
-		.keyd = *keyd,
-		.left_h = SENTINEL_H,
-		.right_h = SENTINEL_H,
-		.color = RED
-	};
+	// Element may be compact - don't write past its end.
+	memset(n, 0, isprig->arena->element_size);
+
+	n->tree_id = tree_id;
+	n->keyd = *keyd;
+	n->left_h = SENTINEL_H;
+	n->right_h = SENTINEL_H;
+	n->color = RED;
 
 	// Insert the new element n under parent ele.
 	if (ele->me == &root_parent || 0 < cmp) {
@@ -870,6 +1550,61 @@ as_index_sprig_search_lockless(as_index_sprig* isprig, const cf_digest* keyd,
 	return -1; // not found
 }
 
+bool
+prefetch_lookup_start(prefetch_lookup* lookup, as_index_tree* tree,
+		const cf_digest* keyd)
+{
+	// Flash index elements aren't in memory - don't fault them in here.
+	if (tree == NULL || tree->shared->puddles_offset != 0) {
+		return false;
+	}
+
+	// Nothing to warm for keys the filter rules out.
+	if (tree->bloom != NULL && ! bloom_may_contain(tree->bloom, keyd)) {
+		return false;
+	}
+
+	as_index_sprig isprig;
+	as_index_sprig_from_keyd(tree, &isprig, keyd);
+
+	lookup->keyd = keyd;
+	lookup->arena = isprig.arena;
+	lookup->sprig = isprig.sprig;
+
+	_mm_prefetch(isprig.sprig, _MM_HINT_T0);
+
+	return true;
+}
+
+// Returns false when the lookup is done - found, not found, or lost its way.
+bool
+prefetch_lookup_step(prefetch_lookup* lookup)
+{
+	if (lookup->sprig != NULL) {
+		lookup->r_h = lookup->sprig->root_h;
+		lookup->sprig = NULL;
+	}
+	else {
+		const as_index* r = cf_arenax_resolve(lookup->arena, lookup->r_h);
+		int cmp = cf_digest_compare(lookup->keyd, &r->keyd);
+
+		if (cmp == 0) {
+			return false;
+		}
+
+		lookup->r_h = cmp > 0 ? r->left_h : r->right_h;
+	}
+
+	if (lookup->r_h == SENTINEL_H ||
+			! cf_arenax_handle_in_range(lookup->arena, lookup->r_h)) {
+		return false;
+	}
+
+	_mm_prefetch(cf_arenax_resolve(lookup->arena, lookup->r_h), _MM_HINT_T0);
+
+	return true;
+}
+
 void
 as_index_sprig_insert_rebalance(as_index_sprig* isprig, as_index* root_parent,
 		as_index_ele* ele)
@@ -1174,3 +1909,362 @@ as_index_rotate_right(as_index_ele* a, as_index_ele* b)
 	b->me->right_h = a->me_h;
 	a->parent = b;
 }
+
+
+//==========================================================
+// Local helpers - keep reduces and sprig splits apart.
+//
+
+// Reduces walk sprigs by index, so hold the tree's layout still while they run.
+static void
+reduce_enter(as_index_tree* tree)
+{
+	while (true) {
+		as_incr_uint32(&tree->n_reducers);
+
+		if (as_load_uint32(&tree->splitting) == 0) {
+			return;
+		}
+
+		as_decr_uint32(&tree->n_reducers);
+
+		while (as_load_uint32(&tree->splitting) != 0) {
+			usleep(100);
+		}
+	}
+}
+
+static void
+reduce_exit(as_index_tree* tree)
+{
+	as_decr_uint32(&tree->n_reducers);
+}
+
+// Cursors outlive reduce_enter() - if the tree split meanwhile, move to the
+// equivalent position in the new layout.
+static void
+cursor_remap(as_index_cursor* cursor)
+{
+	uint32_t shift = cursor->tree->layout->shift;
+
+	if (cursor->sprigs_shift == shift) {
+		return;
+	}
+
+	if (cursor->has_keyd) {
+		cursor->sprig_i = (int32_t)(as_index_sprig_bits(&cursor->keyd) >> shift);
+	}
+	else {
+		// Sprigs go from largest to smallest digests - start at the top half.
+		cursor->sprig_i = ((cursor->sprig_i + 1) <<
+				(cursor->sprigs_shift - shift)) - 1;
+	}
+
+	cursor->sprigs_shift = shift;
+}
+
+// Backs off rather than wait indefinitely - a reduce callback may itself be
+// waiting to reduce this tree.
+static bool
+split_enter(as_index_tree* tree)
+{
+	as_store_uint32(&tree->splitting, 1);
+	as_fence_seq();
+
+	for (uint32_t i = 0; i < SPLIT_DRAIN_MS; i++) {
+		if (as_load_uint32(&tree->n_reducers) == 0) {
+			return true;
+		}
+
+		usleep(1000);
+	}
+
+	as_store_uint32(&tree->splitting, 0);
+
+	return false;
+}
+
+
+//==========================================================
+// Local helpers - split sprigs.
+//
+
+static void
+split_tree(as_index_tree* tree)
+{
+	as_sprig_layout* from = tree->layout;
+	uint32_t n_sprigs = from->n_sprigs * 2;
+	as_sprig_layout* to = cf_malloc(sizeof(as_sprig_layout) +
+			sizeof(as_sprig) * n_sprigs);
+
+	to->shift = from->shift - 1;
+	to->n_sprigs = n_sprigs;
+	to->sprigs = (as_sprig*)(to + 1);
+	to->next_retired = NULL;
+
+	memset(to->sprigs, 0, sizeof(as_sprig) * n_sprigs);
+
+	as_fence_rls();
+	tree->split_layout = to;
+
+	as_index_ph_array hi_a = {
+			.capacity = 1024,
+			.phs = cf_malloc(sizeof(as_index_ph) * 1024)
+	};
+
+	as_index_ph_array lo_a = {
+			.capacity = 1024,
+			.phs = cf_malloc(sizeof(as_index_ph) * 1024)
+	};
+
+	as_lock_pair* pairs = tree_locks(tree);
+	uint32_t n_lock_sprigs = from->n_sprigs / NUM_LOCK_PAIRS;
+
+	// Lookups under a pair find its sprigs via its bit in split_groups.
+	for (uint32_t lock_i = 0; lock_i < NUM_LOCK_PAIRS; lock_i++) {
+		as_lock_pair* pair = &pairs[lock_i];
+
+		as_index_olock_lock(&pair->lock);
+		cf_mutex_lock(&pair->reduce_lock);
+
+		uint32_t start_i = lock_i * n_lock_sprigs;
+
+		for (uint32_t i = start_i; i < start_i + n_lock_sprigs; i++) {
+			split_sprig(tree, from, to, i, &hi_a, &lo_a);
+		}
+
+		uint64_t* group = &tree->split_groups[lock_i / 64];
+
+		as_store_uint64(group, *group | (1UL << (lock_i % 64)));
+
+		cf_mutex_unlock(&pair->reduce_lock);
+		as_index_olock_unlock(&pair->lock);
+	}
+
+	cf_free(hi_a.phs);
+	cf_free(lo_a.phs);
+
+	// All pairs are split - switch the tree over. Old layouts are kept, since
+	// lockless lookups may still be reading them.
+	for (uint32_t lock_i = 0; lock_i < NUM_LOCK_PAIRS; lock_i++) {
+		as_index_olock_lock(&pairs[lock_i].lock);
+		cf_mutex_lock(&pairs[lock_i].reduce_lock);
+	}
+
+	from->next_retired = tree->retired_layouts;
+	tree->retired_layouts = from;
+	tree->layout = to;
+
+	for (uint32_t i = 0; i < NUM_LOCK_PAIRS / 64; i++) {
+		as_store_uint64(&tree->split_groups[i], 0);
+	}
+
+	tree->split_layout = NULL;
+
+	for (uint32_t lock_i = NUM_LOCK_PAIRS; lock_i > 0; lock_i--) {
+		cf_mutex_unlock(&pairs[lock_i - 1].reduce_lock);
+		as_index_olock_unlock(&pairs[lock_i - 1].lock);
+	}
+}
+
+// Rehome a sprig's elements into its two halves by the next digest bit. The
+// elements are rebuilt as balanced trees in place - no allocation, and handles
+// (hence record references) are unchanged.
+static void
+split_sprig(as_index_tree* tree, const as_sprig_layout* from,
+		as_sprig_layout* to, uint32_t sprig_i, as_index_ph_array* hi_a,
+		as_index_ph_array* lo_a)
+{
+	cf_arenax_handle root_h = from->sprigs[sprig_i].root_h;
+
+	if (root_h == SENTINEL_H) {
+		return;
+	}
+
+	uint32_t hi_i = (sprig_i * 2) + 1;
+
+	hi_a->n_used = 0;
+	lo_a->n_used = 0;
+
+	// Collect everything before relinking anything.
+	split_collect(tree->shared->arena, root_h, hi_i, to->shift, hi_a, lo_a);
+
+	to->sprigs[hi_i].root_h = hi_a->n_used == 0 ? SENTINEL_H :
+			split_build(hi_a->phs, hi_a->n_used, 0,
+					(uint32_t)cf_msb(hi_a->n_used));
+	to->sprigs[hi_i - 1].root_h = lo_a->n_used == 0 ? SENTINEL_H :
+			split_build(lo_a->phs, lo_a->n_used, 0,
+					(uint32_t)cf_msb(lo_a->n_used));
+}
+
+// In-order, so each half comes out sorted.
+static void
+split_collect(cf_arenax* arena, cf_arenax_handle r_h, uint32_t hi_i,
+		uint32_t shift, as_index_ph_array* hi_a, as_index_ph_array* lo_a)
+{
+	if (r_h == SENTINEL_H) {
+		return;
+	}
+
+	as_index* r = (as_index*)cf_arenax_resolve(arena, r_h);
+
+	split_collect(arena, r->left_h, hi_i, shift, hi_a, lo_a);
+
+	ph_array_append((as_index_sprig_bits(&r->keyd) >> shift) == hi_i ?
+			hi_a : lo_a, r, r_h);
+
+	split_collect(arena, r->right_h, hi_i, shift, hi_a, lo_a);
+}
+
+// Midpoint build - leaves are all on the last two levels, so coloring only the
+// deepest level red satisfies the red-black rules.
+static cf_arenax_handle
+split_build(const as_index_ph* phs, uint32_t n_phs, uint32_t depth,
+		uint32_t red_depth)
+{
+	if (n_phs == 0) {
+		return SENTINEL_H;
+	}
+
+	uint32_t mid = n_phs / 2;
+	as_index* r = phs[mid].r;
+
+	r->left_h = split_build(phs, mid, depth + 1, red_depth);
+	r->right_h = split_build(phs + mid + 1, n_phs - mid - 1, depth + 1,
+			red_depth);
+	r->color = depth != 0 && depth == red_depth ? RED : BLACK;
+
+	return phs[mid].r_h;
+}
+
+
+//==========================================================
+// Local helpers - Bloom filter.
+//
+
+// Block index and per-word bits come from digest bytes that don't select the
+// partition, so they're uniform within a tree.
+
+static inline uint64_t*
+bloom_block(const as_index_bloom* bloom, uint32_t half_i,
+		const cf_digest* keyd)
+{
+	uint64_t block_bits;
+
+	memcpy(&block_bits, &keyd->digest[4], sizeof(block_bits));
+
+	return bloom->halves[half_i] +
+			(block_bits & (bloom->n_blocks - 1)) * BLOOM_BLOCK_N_WORDS;
+}
+
+static inline uint64_t
+bloom_word_bit(const cf_digest* keyd, uint32_t word_i)
+{
+	uint64_t bit_bits;
+
+	memcpy(&bit_bits, &keyd->digest[12], sizeof(bit_bits));
+
+	return 1UL << ((bit_bits >> (word_i * 6)) & 63);
+}
+
+static as_index_bloom*
+bloom_create(uint32_t size)
+{
+	as_index_bloom* bloom = cf_malloc(sizeof(as_index_bloom));
+	size_t half_size = size;
+	uint8_t* halves = cf_valloc(half_size * 2);
+
+	memset(halves, 0, half_size * 2);
+
+	// A new tree is empty, so its (empty) filter is already right.
+	*bloom = (as_index_bloom){
+			.gen = 0,
+			.valid = 1,
+			.building = 0,
+			.n_blocks = size / (BLOOM_BLOCK_N_WORDS * sizeof(uint64_t)),
+			.n_deletes = 0,
+			.halves = { (uint64_t*)halves, (uint64_t*)(halves + half_size) }
+	};
+
+	return bloom;
+}
+
+static void
+bloom_destroy(as_index_bloom* bloom)
+{
+	cf_free(bloom->halves[0]);
+	cf_free(bloom);
+}
+
+// No locks - a result read across a swap is discarded, so a half being
+// refilled is never trusted.
+static bool
+bloom_may_contain(as_index_bloom* bloom, const cf_digest* keyd)
+{
+	if (as_load_uint32(&bloom->valid) == 0) {
+		return true;
+	}
+
+	uint32_t gen = as_load_uint32(&bloom->gen);
+
+	as_fence_acq();
+
+	const uint64_t* block = bloom_block(bloom, gen & 1, keyd);
+	bool all_set = true;
+
+	for (uint32_t i = 0; i < BLOOM_BLOCK_N_WORDS; i++) {
+		if ((as_load_uint64(&block[i]) & bloom_word_bit(keyd, i)) == 0) {
+			all_set = false;
+			break;
+		}
+	}
+
+	as_fence_acq();
+
+	return all_set || as_load_uint32(&bloom->gen) != gen;
+}
+
+static void
+bloom_add(as_index_bloom* bloom, const cf_digest* keyd)
+{
+	if (as_load_uint32(&bloom->building) != 0) {
+		bloom_set(bloom, 0, keyd);
+		bloom_set(bloom, 1, keyd);
+		return;
+	}
+
+	as_fence_acq();
+
+	bloom_set(bloom, as_load_uint32(&bloom->gen) & 1, keyd);
+}
+
+// Other sprigs' inserts may share the block - bits are set atomically.
+static void
+bloom_set(as_index_bloom* bloom, uint32_t half_i, const cf_digest* keyd)
+{
+	uint64_t* block = bloom_block(bloom, half_i, keyd);
+
+	for (uint32_t i = 0; i < BLOOM_BLOCK_N_WORDS; i++) {
+		uint64_t bit = bloom_word_bit(keyd, i);
+
+		if ((as_load_uint64(&block[i]) & bit) == 0) {
+			__atomic_fetch_or(&block[i], bit, __ATOMIC_SEQ_CST);
+		}
+	}
+}
+
+// Caller holds the sprig's reduce lock, so the sprig can't change underfoot.
+static void
+bloom_fill(as_index_sprig* isprig, as_index_bloom* bloom, uint32_t half_i,
+		cf_arenax_handle r_h)
+{
+	if (r_h == SENTINEL_H) {
+		return;
+	}
+
+	as_index* r = RESOLVE(r_h);
+
+	bloom_fill(isprig, bloom, half_i, r->left_h);
+	bloom_set(bloom, half_i, &r->keyd);
+	bloom_fill(isprig, bloom, half_i, r->right_h);
+}
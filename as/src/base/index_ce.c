@@ -28,6 +28,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "citrusleaf/cf_digest.h"
 
@@ -36,6 +37,14 @@
 #include "base/datamodel.h"
 
 
+//==========================================================
+// Typedefs & constants.
+//
+
+// Index snapshot sprig roots are copied straight into trees.
+COMPILER_ASSERT(sizeof(as_sprigx) == sizeof(as_sprig));
+
+
 //==========================================================
 // Public API.
 //
@@ -44,8 +53,27 @@ as_index_tree*
 as_index_tree_resume(as_index_tree_shared* shared, as_treex* xmem_trees,
 		uint32_t pid, as_index_tree_done_fn cb, void* udata)
 {
-	cf_crash(AS_INDEX, "CE code called as_index_tree_resume()");
-	return NULL;
+	// CE resumes only from an index snapshot, loaded by namespace setup.
+	int block_ix = xmem_trees->block_ix[pid];
+
+	if (block_ix < 0) {
+		return NULL;
+	}
+
+	// Tree-id and element count are restored when storage resumes.
+	as_index_tree* tree = as_index_tree_create(shared, 0, cb, udata);
+
+	memcpy(tree_sprigs(tree),
+			&xmem_trees->sprigxs[(size_t)block_ix * shared->n_sprigs],
+			sizeof(as_sprig) * shared->n_sprigs);
+
+	// Elements came without their Bloom bits - lookups bypass the filter until
+	// nsup rebuilds it.
+	if (tree->bloom != NULL) {
+		tree->bloom->valid = 0;
+	}
+
+	return tree;
 }
 
 bool
@@ -61,6 +89,13 @@ as_index_reduce_from_live(as_index_tree* tree, const cf_digest* keyd,
 	return as_index_reduce_from(tree, keyd, cb, udata);
 }
 
+bool
+as_index_reduce_from_live_filtered(as_index_tree* tree, const cf_digest* keyd,
+		as_index_filter_fn filter, as_index_reduce_fn cb, void* udata)
+{
+	return as_index_reduce_from_filtered(tree, keyd, filter, cb, udata);
+}
+
 
 //==========================================================
 // Private API - for enterprise separation only.
@@ -228,6 +228,9 @@ as_mon_populate_jobstat(as_mon_jobstat * job_stat, cf_dyn_buf *db)
 	cf_dyn_buf_append_string(db, ":recs-filtered-bins=");
 	cf_dyn_buf_append_uint64(db, job_stat->recs_filtered_bins);
 
+	cf_dyn_buf_append_string(db, ":recs-filtered-and=");
+	cf_dyn_buf_append_uint64(db, job_stat->recs_filtered_and);
+
 	cf_dyn_buf_append_string(db, ":recs-succeeded=");
 	cf_dyn_buf_append_uint64(db, job_stat->recs_succeeded);
 
@@ -28,10 +28,15 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_atomic.h"
+#include "citrusleaf/cf_clock.h"
 
+#include "bits.h"
+#include "cf_thread.h"
 #include "dynbuf.h"
 #include "hist.h"
 #include "linear_hist.h"
@@ -43,6 +48,7 @@
 #include "base/datamodel.h"
 #include "base/index.h"
 #include "base/proto.h"
+#include "base/set_hist.h"
 #include "fabric/partition.h"
 #include "sindex/sindex.h"
 #include "storage/storage.h"
@@ -53,6 +59,7 @@
 //
 
 static void append_set_props(as_set *p_set, cf_dyn_buf *db);
+static void *run_split_sprigs(void *udata);
 
 
 //==========================================================
@@ -104,6 +111,7 @@ as_namespace_create(char *name)
 	ns->evict_hist_buckets = 10000; // for 30 day TTL, bucket width is 4 minutes 20 seconds
 	ns->evict_tenths_pct = 5; // default eviction amount is 0.5%
 	ns->index_stage_size = 1024L * 1024L * 1024L; // 1G
+	ns->memory_defrag_lwm_pct = 50;
 	ns->migrate_order = 5;
 	ns->migrate_retransmit_ms = 1000 * 5; // 5 seconds
 	ns->migrate_sleep = 1;
@@ -130,6 +138,7 @@ as_namespace_create(char *name)
 	// Note - default true is consistent with AS_STORAGE_ENGINE_MEMORY, but
 	// cfg.c will set default false for AS_STORAGE_ENGINE_SSD.
 
+	ns->storage_cold_start_threads = 1; // record parser threads per device at cold start
 	ns->storage_scheduler_mode = NULL; // null indicates default is to not change scheduler mode
 	ns->storage_write_block_size = 1024 * 1024;
 	ns->storage_defrag_lwm_pct = 50; // defrag if occupancy of block is < 50%
@@ -140,6 +149,7 @@ as_namespace_create(char *name)
 	ns->storage_min_avail_pct = 5; // stop writes when < 5% disk is writable
 	ns->storage_post_write_queue = DEFAULT_POST_WRITE_QUEUE; // number of wblocks per device used as post-write cache
 	ns->storage_tomb_raider_sleep = 1000; // sleep this many microseconds between each device read
+	ns->storage_ttl_write_streams = 1; // no TTL segregation
 
 	ns->geo2dsphere_within_strict = true;
 	ns->geo2dsphere_within_min_level = 1;
@@ -196,6 +206,10 @@ as_namespace_configure_sets(as_namespace *ns)
 			p_set->stop_writes_count = ns->sets_cfg_array[i].stop_writes_count;
 			p_set->eviction_disabled = ns->sets_cfg_array[i].eviction_disabled;
 			p_set->index_enabled = ns->sets_cfg_array[i].index_enabled;
+
+			if (ns->sets_cfg_array[i].hist_enabled) {
+				as_set_hist_enable(ns, p_set);
+			}
 		}
 		else {
 			// Maybe exceeded max sets allowed, but try failing gracefully.
@@ -529,6 +543,26 @@ as_namespace_adjust_set_device_bytes(as_namespace *ns, uint16_t set_id,
 }
 
 
+// Count an object already in the index - used when resuming an index.
+void
+as_namespace_reserve_set_id(as_namespace *ns, uint16_t set_id)
+{
+	if (set_id == INVALID_SET_ID) {
+		return;
+	}
+
+	as_set *p_set;
+
+	if (cf_vmapx_get_by_index(ns->p_sets_vmap, set_id - 1, (void**)&p_set) !=
+			CF_VMAPX_OK) {
+		cf_warning(AS_NAMESPACE, "set-id %u - failed vmap get", set_id);
+		return;
+	}
+
+	cf_atomic64_incr(&p_set->n_objects);
+}
+
+
 void
 as_namespace_release_set_id(as_namespace *ns, uint16_t set_id)
 {
@@ -645,6 +679,40 @@ as_namespace_get_hist_info(as_namespace *ns, char *set_name, char *hist_name,
 	}
 }
 
+// Raise partition-tree-sprigs at runtime. New trees get the new count straight
+// away, existing trees are split in the background.
+bool
+as_namespace_split_sprigs(as_namespace *ns, uint32_t n_sprigs)
+{
+	if (n_sprigs > (1 << NUM_SPRIG_BITS) || (n_sprigs & (n_sprigs - 1)) != 0 ||
+			n_sprigs <= ns->tree_shared.n_sprigs) {
+		cf_warning(AS_NAMESPACE, "{%s} partition-tree-sprigs %u must be a power of 2 above %u and at most %u",
+				ns->name, n_sprigs, ns->tree_shared.n_sprigs,
+				1 << NUM_SPRIG_BITS);
+		return false;
+	}
+
+	if (ns->xmem_type != CF_XMEM_TYPE_MEM ||
+			ns->tree_shared.puddles_offset != 0) {
+		cf_warning(AS_NAMESPACE, "{%s} can't change partition-tree-sprigs unless index-type is mem",
+				ns->name);
+		return false;
+	}
+
+	if (! as_cas_uint32(&ns->sprigs_splitting, 0, 1)) {
+		cf_warning(AS_NAMESPACE, "{%s} partition-tree-sprigs change already in progress",
+				ns->name);
+		return false;
+	}
+
+	ns->tree_shared.sprigs_shift = NUM_SPRIG_BITS - (uint32_t)cf_msb(n_sprigs);
+	as_store_uint32(&ns->tree_shared.n_sprigs, n_sprigs);
+
+	cf_thread_create_detached(run_split_sprigs, (void *)ns);
+
+	return true;
+}
+
 
 //==========================================================
 // Local helpers.
@@ -683,12 +751,18 @@ append_set_props(as_set *p_set, cf_dyn_buf *db)
 	cf_dyn_buf_append_bool(db, p_set->index_populating);
 	cf_dyn_buf_append_char(db, ':');
 
+	as_set_hist_append_stats(p_set, db);
+
 	// Configuration:
 
 	cf_dyn_buf_append_string(db, "disable-eviction=");
 	cf_dyn_buf_append_bool(db, p_set->eviction_disabled);
 	cf_dyn_buf_append_char(db, ':');
 
+	cf_dyn_buf_append_string(db, "enable-histograms=");
+	cf_dyn_buf_append_bool(db, p_set->hist_enabled);
+	cf_dyn_buf_append_char(db, ':');
+
 	cf_dyn_buf_append_string(db, "enable-index=");
 	cf_dyn_buf_append_bool(db, p_set->index_enabled);
 	cf_dyn_buf_append_char(db, ':');
@@ -697,3 +771,32 @@ append_set_props(as_set *p_set, cf_dyn_buf *db)
 	cf_dyn_buf_append_uint64(db, cf_atomic64_get(p_set->stop_writes_count));
 	cf_dyn_buf_append_char(db, ';');
 }
+
+static void *
+run_split_sprigs(void *udata)
+{
+	as_namespace *ns = (as_namespace *)udata;
+	uint64_t start_ms = cf_getms();
+
+	cf_info(AS_NAMESPACE, "{%s} splitting partition trees to %u sprigs",
+			ns->name, ns->tree_shared.n_sprigs);
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		as_partition_reservation rsv;
+		as_partition_reserve(ns, pid, &rsv);
+
+		// Back off while long reduces (e.g. scans) hold the tree.
+		while (rsv.tree != NULL && ! as_index_tree_split_sprigs(rsv.tree)) {
+			usleep(100 * 1000);
+		}
+
+		as_partition_release(&rsv);
+	}
+
+	cf_info(AS_NAMESPACE, "{%s} split partition trees to %u sprigs in %lu ms",
+			ns->name, ns->tree_shared.n_sprigs, cf_getms() - start_ms);
+
+	as_store_uint32(&ns->sprigs_splitting, 0);
+
+	return NULL;
+}
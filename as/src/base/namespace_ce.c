@@ -24,12 +24,20 @@
 // Includes.
 //
 
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "citrusleaf/alloc.h"
 
 #include "arenax.h"
+#include "bits.h"
 #include "log.h"
 #include "vmapx.h"
 
@@ -37,13 +45,52 @@
 #include "base/datamodel.h"
 #include "base/index.h"
 #include "sindex/sindex_arena.h"
+#include "storage/drv_common.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Index snapshot - written on clean shutdown, so a restart can skip the device
+// scan. The CE substitute for keeping the index in shared memory.
+#define SNAPSHOT_MAGIC 0x50414e5358444e49UL // "INDXSNAP"
+#define SNAPSHOT_VERSION 1
+
+typedef struct snapshot_header_s {
+	uint64_t			magic;
+	uint32_t			version;
+	char				ns_name[AS_ID_NAMESPACE_SZ];
+	uint32_t			n_devices;
+	uint64_t			random; // device set signature at clean shutdown
+	uint32_t			n_sprigs;
+	uint32_t			element_size;
+	uint64_t			stage_size;
+	cf_arenax_handle	free_h;
+	uint32_t			at_stage_id;
+	uint32_t			at_element_id;
+	uint32_t			n_sets;
+	uint32_t			n_trees;
+} snapshot_header;
+
+// Layout following header:
+// - n_sets set names, each AS_SET_NAME_MAX_SIZE bytes, in set-id order
+// - n_trees partition-ids, each uint32_t
+// - n_trees arrays of n_sprigs sprig roots
+// - at_stage_id full arena stages, then at_element_id elements of last stage
 
 
 //==========================================================
 // Forward declarations.
 //
 
-static void setup_namespace(as_namespace* ns);
+static void setup_namespace(as_namespace* ns, bool cold_start_cmd);
+
+static bool snapshot_check_devices(const as_namespace* ns, uint64_t* p_random);
+static void snapshot_save(as_namespace* ns);
+static bool snapshot_load(as_namespace* ns);
+static bool snapshot_read(as_namespace* ns, int fd);
+static void snapshot_reset_arena(cf_arenax* arena);
 
 
 //==========================================================
@@ -54,14 +101,18 @@ void
 as_namespaces_setup(bool cold_start_cmd, uint32_t instance)
 {
 	for (uint32_t i = 0; i < g_config.n_namespaces; i++) {
-		setup_namespace(g_config.namespaces[i]);
+		setup_namespace(g_config.namespaces[i], cold_start_cmd);
 	}
 }
 
 bool
 as_namespace_xmem_shutdown(as_namespace *ns, uint32_t instance)
 {
-	// For enterprise version only.
+	if (ns->storage_index_snapshot_file != NULL) {
+		// A failed snapshot only means the next start is a cold start.
+		snapshot_save(ns);
+	}
+
 	return true;
 }
 
@@ -73,7 +124,11 @@ as_namespace_xmem_shutdown(as_namespace *ns, uint32_t instance)
 void
 as_namespace_finish_setup(as_namespace *ns, uint32_t instance)
 {
-	// For enterprise version only.
+	// Partition trees have been resumed from the snapshot's sprig roots.
+	if (ns->xmem_trees != NULL) {
+		cf_free(ns->xmem_trees);
+		ns->xmem_trees = NULL;
+	}
 }
 
 
@@ -82,12 +137,10 @@ as_namespace_finish_setup(as_namespace *ns, uint32_t instance)
 //
 
 static void
-setup_namespace(as_namespace* ns)
+setup_namespace(as_namespace* ns, bool cold_start_cmd)
 {
 	ns->cold_start = true;
 
-	cf_info(AS_NAMESPACE, "{%s} beginning cold start", ns->name);
-
 	//--------------------------------------------
 	// Set up the set name vmap.
 	//
@@ -96,11 +149,6 @@ setup_namespace(as_namespace* ns)
 
 	cf_vmapx_init(ns->p_sets_vmap, sizeof(as_set), AS_SET_MAX_COUNT, 1024, AS_SET_NAME_MAX_SIZE);
 
-	// Transfer configuration file information about sets.
-	if (! as_namespace_configure_sets(ns)) {
-		cf_crash(AS_NAMESPACE, "{%s} can't configure sets", ns->name);
-	}
-
 	//--------------------------------------------
 	// Set up the bin name vmap.
 	//
@@ -118,10 +166,384 @@ setup_namespace(as_namespace* ns)
 	ns->arena = (cf_arenax*)cf_malloc(sizeof(cf_arenax));
 	ns->tree_shared.arena = ns->arena;
 
-	cf_arenax_init(ns->arena, ns->xmem_type, ns->xmem_type_cfg, 0, (uint32_t)sizeof(as_index), 1, ns->index_stage_size);
+	uint32_t element_size = ns->index_compact_entries ?
+			AS_INDEX_COMPACT_SIZE : (uint32_t)sizeof(as_index);
+
+	cf_arenax_init(ns->arena, ns->xmem_type, &ns->index_mem_cfg, 0, element_size, 1, ns->index_stage_size);
 
 	ns->si_arena = cf_calloc(1, sizeof(as_sindex_arena));
 
 	as_sindex_arena_init(ns->si_arena, 0, SI_ARENA_ELE_SZ,
-			ns->sindex_stage_size);
+			ns->sindex_stage_size, ns->sindex_flash_dir);
+
+	//--------------------------------------------
+	// Resume the index from a snapshot, if possible.
+	//
+
+	if (ns->storage_index_snapshot_file != NULL) {
+		if (cold_start_cmd) {
+			// Snapshot is good for one restart only.
+			unlink(ns->storage_index_snapshot_file);
+		}
+		else if (snapshot_load(ns)) {
+			ns->cold_start = false;
+		}
+	}
+
+	cf_info(AS_NAMESPACE, "{%s} beginning %s", ns->name,
+			ns->cold_start ? "cold start" : "warm restart from index snapshot");
+
+	// Transfer configuration file information about sets. (After restoring
+	// snapshot set names, so resumed records' set-ids stay valid.)
+	if (! as_namespace_configure_sets(ns)) {
+		cf_crash(AS_NAMESPACE, "{%s} can't configure sets", ns->name);
+	}
+}
+
+
+//==========================================================
+// Local helpers - index snapshot.
+//
+
+// Snapshot is valid only for the same device set, in the same order, with
+// nothing written since it was trusted at clean shutdown. The device header
+// random is changed on every startup.
+static bool
+snapshot_check_devices(const as_namespace* ns, uint64_t* p_random)
+{
+	uint32_t n_devices = as_namespace_device_count(ns);
+	uint64_t random = 0;
+
+	for (uint32_t i = 0; i < n_devices; i++) {
+		const char* name = ns->storage_devices[i];
+		int fd = open(name, O_RDONLY);
+
+		if (fd == -1) {
+			cf_warning(AS_NAMESPACE, "{%s} index snapshot can't open %s: errno %d (%s)",
+					ns->name, name, errno, cf_strerror(errno));
+			return false;
+		}
+
+		drv_prefix prefix;
+		drv_unique unique;
+
+		bool ok = pread_all(fd, &prefix, sizeof(prefix), 0) &&
+				pread_all(fd, &unique, sizeof(unique),
+						(off_t)DRV_OFFSET_UNIQUE);
+
+		close(fd);
+
+		if (! ok || prefix.magic != DRV_HEADER_MAGIC ||
+				(prefix.flags & DRV_HEADER_FLAG_TRUSTED) == 0 ||
+				prefix.n_devices != n_devices || unique.device_id != i ||
+				(i != 0 && prefix.random != random)) {
+			cf_info(AS_NAMESPACE, "{%s} index snapshot doesn't match device %s",
+					ns->name, name);
+			return false;
+		}
+
+		random = prefix.random;
+	}
+
+	*p_random = random;
+
+	return true;
+}
+
+static void
+snapshot_save(as_namespace* ns)
+{
+	uint64_t random;
+
+	// Devices were just marked trusted by storage shutdown.
+	if (! snapshot_check_devices(ns, &random)) {
+		cf_warning(AS_NAMESPACE, "{%s} not writing index snapshot", ns->name);
+		return;
+	}
+
+	cf_arenax* arena = ns->arena;
+	uint32_t n_sprigs = ns->tree_shared.n_sprigs;
+
+	snapshot_header header = {
+			.magic = SNAPSHOT_MAGIC,
+			.version = SNAPSHOT_VERSION,
+			.n_devices = as_namespace_device_count(ns),
+			.random = random,
+			.n_sprigs = n_sprigs,
+			.element_size = arena->element_size,
+			.stage_size = arena->stage_size,
+			.free_h = arena->free_h,
+			.at_stage_id = arena->at_stage_id,
+			.at_element_id = arena->at_element_id,
+			.n_sets = cf_vmapx_count(ns->p_sets_vmap)
+	};
+
+	strcpy(header.ns_name, ns->name);
+
+	uint32_t pids[AS_PARTITIONS];
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		as_index_tree* tree = ns->partitions[pid].tree;
+
+		if (tree == NULL) {
+			continue;
+		}
+
+		// A partition-tree-sprigs raise didn't finish before shutdown.
+		if (tree->layout->n_sprigs != n_sprigs || tree->split_layout != NULL) {
+			cf_warning(AS_NAMESPACE, "{%s} not writing index snapshot - sprig split in progress",
+					ns->name);
+			return;
+		}
+
+		pids[header.n_trees++] = pid;
+	}
+
+	char tmp_path[PATH_MAX];
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp",
+			ns->storage_index_snapshot_file);
+
+	int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+
+	if (fd == -1) {
+		cf_warning(AS_NAMESPACE, "{%s} can't create index snapshot %s: errno %d (%s)",
+				ns->name, tmp_path, errno, cf_strerror(errno));
+		return;
+	}
+
+	cf_info(AS_NAMESPACE, "{%s} writing index snapshot - %u trees, %u stages",
+			ns->name, header.n_trees, header.at_stage_id + 1);
+
+	off_t offset = 0;
+	bool ok = pwrite_all(fd, &header, sizeof(header), offset);
+
+	offset += (off_t)sizeof(header);
+
+	for (uint32_t i = 0; ok && i < header.n_sets; i++) {
+		as_set* p_set;
+		char name[AS_SET_NAME_MAX_SIZE] = { 0 };
+
+		if (cf_vmapx_get_by_index(ns->p_sets_vmap, i, (void**)&p_set) ==
+				CF_VMAPX_OK) {
+			strcpy(name, p_set->name);
+		}
+
+		ok = pwrite_all(fd, name, sizeof(name), offset);
+		offset += (off_t)sizeof(name);
+	}
+
+	if (ok) {
+		ok = pwrite_all(fd, pids, header.n_trees * sizeof(uint32_t), offset);
+		offset += (off_t)(header.n_trees * sizeof(uint32_t));
+	}
+
+	size_t sprigs_size = sizeof(as_sprig) * n_sprigs;
+
+	for (uint32_t i = 0; ok && i < header.n_trees; i++) {
+		as_index_tree* tree = ns->partitions[pids[i]].tree;
+
+		ok = pwrite_all(fd, tree_sprigs(tree), sprigs_size, offset);
+		offset += (off_t)sprigs_size;
+	}
+
+	for (uint32_t stage_id = 0; ok && stage_id <= header.at_stage_id;
+			stage_id++) {
+		size_t size = stage_id < header.at_stage_id ?
+				header.stage_size :
+				(size_t)header.at_element_id * header.element_size;
+
+		ok = pwrite_all(fd, arena->stages[stage_id], size, offset);
+		offset += (off_t)size;
+	}
+
+	if (ok) {
+		ok = fsync(fd) == 0;
+	}
+
+	close(fd);
+
+	if (! ok || rename(tmp_path, ns->storage_index_snapshot_file) != 0) {
+		cf_warning(AS_NAMESPACE, "{%s} failed writing index snapshot %s: errno %d (%s)",
+				ns->name, tmp_path, errno, cf_strerror(errno));
+		unlink(tmp_path);
+		return;
+	}
+
+	cf_info(AS_NAMESPACE, "{%s} wrote index snapshot %s (%lu bytes)", ns->name,
+			ns->storage_index_snapshot_file, (uint64_t)offset);
+}
+
+static bool
+snapshot_load(as_namespace* ns)
+{
+	const char* path = ns->storage_index_snapshot_file;
+	int fd = open(path, O_RDONLY);
+
+	if (fd == -1) {
+		if (errno != ENOENT) {
+			cf_warning(AS_NAMESPACE, "{%s} can't open index snapshot %s: errno %d (%s)",
+					ns->name, path, errno, cf_strerror(errno));
+		}
+
+		return false;
+	}
+
+	bool ok = snapshot_read(ns, fd);
+
+	close(fd);
+
+	// Snapshot is good for one restart only.
+	unlink(path);
+
+	return ok;
+}
+
+static bool
+snapshot_read(as_namespace* ns, int fd)
+{
+	cf_arenax* arena = ns->arena;
+	snapshot_header header;
+
+	if (! pread_all(fd, &header, sizeof(header), 0) ||
+			header.magic != SNAPSHOT_MAGIC ||
+			header.version != SNAPSHOT_VERSION ||
+			strcmp(header.ns_name, ns->name) != 0) {
+		cf_warning(AS_NAMESPACE, "{%s} ignoring bad index snapshot", ns->name);
+		return false;
+	}
+
+	// Trees may have been split to more sprigs than configured - keep them.
+	if (header.n_sprigs < ns->tree_shared.n_sprigs ||
+			header.n_sprigs > (1 << NUM_SPRIG_BITS) ||
+			(header.n_sprigs & (header.n_sprigs - 1)) != 0 ||
+			header.element_size != arena->element_size ||
+			header.stage_size != arena->stage_size ||
+			header.at_stage_id >= CF_ARENAX_MAX_STAGES ||
+			header.n_sets > AS_SET_MAX_COUNT ||
+			header.n_trees > AS_PARTITIONS) {
+		cf_warning(AS_NAMESPACE, "{%s} ignoring index snapshot - config changed",
+				ns->name);
+		return false;
+	}
+
+	uint64_t random;
+
+	if (! snapshot_check_devices(ns, &random) || random != header.random) {
+		cf_warning(AS_NAMESPACE, "{%s} ignoring stale index snapshot", ns->name);
+		return false;
+	}
+
+	size_t names_size = (size_t)header.n_sets * AS_SET_NAME_MAX_SIZE;
+	size_t pids_size = header.n_trees * sizeof(uint32_t);
+	size_t sprigxs_size = (size_t)header.n_trees * header.n_sprigs *
+			sizeof(as_sprigx);
+
+	off_t offset = (off_t)sizeof(header);
+
+	char* names = cf_malloc(names_size + 1); // + 1 for no sets
+	uint32_t* pids = cf_malloc(pids_size + 1);
+	as_treex* treex = cf_malloc(sizeof(as_treex) + sprigxs_size);
+
+	bool ok = pread_all(fd, names, names_size, offset) &&
+			pread_all(fd, pids, pids_size, offset + (off_t)names_size) &&
+			pread_all(fd, treex->sprigxs, sprigxs_size,
+					offset + (off_t)(names_size + pids_size));
+
+	offset += (off_t)(names_size + pids_size + sprigxs_size);
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		treex->block_ix[pid] = -1;
+	}
+
+	for (uint32_t i = 0; ok && i < header.n_trees; i++) {
+		if (pids[i] >= AS_PARTITIONS) {
+			ok = false;
+			break;
+		}
+
+		treex->block_ix[pids[i]] = (int)i;
+	}
+
+	// Stage 0 was added by arena init.
+	for (uint32_t stage_id = 0; ok && stage_id <= header.at_stage_id;
+			stage_id++) {
+		if (stage_id != 0 && cf_arenax_add_stage(arena) != CF_ARENAX_OK) {
+			ok = false;
+			break;
+		}
+
+		size_t size = stage_id < header.at_stage_id ?
+				header.stage_size :
+				(size_t)header.at_element_id * header.element_size;
+
+		ok = pread_all(fd, arena->stages[stage_id], size, offset);
+		offset += (off_t)size;
+	}
+
+	if (! ok) {
+		cf_warning(AS_NAMESPACE, "{%s} failed reading index snapshot: errno %d (%s)",
+				ns->name, errno, cf_strerror(errno));
+
+		snapshot_reset_arena(arena);
+		cf_free(names);
+		cf_free(pids);
+		cf_free(treex);
+
+		return false;
+	}
+
+	arena->free_h = header.free_h;
+	arena->at_stage_id = header.at_stage_id;
+	arena->at_element_id = header.at_element_id;
+
+	// Restore set names in set-id order, so record set-ids stay valid.
+	for (uint32_t i = 0; i < header.n_sets; i++) {
+		char* name = &names[(size_t)i * AS_SET_NAME_MAX_SIZE];
+		uint32_t idx;
+
+		name[AS_SET_NAME_MAX_SIZE - 1] = '\0';
+
+		if (cf_vmapx_put_unique(ns->p_sets_vmap, name, &idx) != CF_VMAPX_OK ||
+				idx != i) {
+			// Arena is already restored - no going back to cold start now.
+			cf_crash(AS_NAMESPACE, "{%s} can't restore set %s from index snapshot",
+					ns->name, name);
+		}
+	}
+
+	cf_free(names);
+	cf_free(pids);
+
+	ns->xmem_trees = treex;
+
+	if (header.n_sprigs != ns->tree_shared.n_sprigs) {
+		cf_info(AS_NAMESPACE, "{%s} index snapshot raises partition-tree-sprigs from %u to %u",
+				ns->name, ns->tree_shared.n_sprigs, header.n_sprigs);
+
+		ns->tree_shared.n_sprigs = header.n_sprigs;
+		ns->tree_shared.sprigs_shift =
+				NUM_SPRIG_BITS - (uint32_t)cf_msb(header.n_sprigs);
+	}
+
+	cf_info(AS_NAMESPACE, "{%s} loaded index snapshot - %u trees, %u stages",
+			ns->name, header.n_trees, header.at_stage_id + 1);
+
+	return true;
+}
+
+// Undo a partial snapshot load, leaving the arena as after init.
+static void
+snapshot_reset_arena(cf_arenax* arena)
+{
+	while (arena->stage_count > 1) {
+		cf_arenax_remove_last_stage(arena);
+	}
+
+	arena->free_h = 0;
+	arena->at_stage_id = 0;
+	arena->at_element_id = arena->chunk_count;
+
+	memset(cf_arenax_resolve(arena, 0), 0,
+			arena->element_size * arena->chunk_count);
 }
@@ -26,6 +26,7 @@
 
 #include "base/nsup.h"
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -35,7 +36,10 @@
 
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/cf_clock.h"
+#include "citrusleaf/cf_random.h"
 
+#include "arenax.h"
+#include "cf_mutex.h"
 #include "cf_thread.h"
 #include "dynbuf.h"
 #include "hardware.h"
@@ -48,6 +52,7 @@
 #include "base/cfg.h"
 #include "base/datamodel.h"
 #include "base/index.h"
+#include "base/probes.h"
 #include "base/set_index.h"
 #include "base/smd.h"
 #include "fabric/partition.h"
@@ -66,8 +71,16 @@
 
 typedef struct expire_overall_info_s {
 	as_namespace* ns;
-	uint32_t pid;
+	uint32_t item; // next tree slice (or partition, if using index) to reduce
 	uint32_t now;
+	bool populate_index;
+	uint32_t first_bucket; // for expiring via index only
+	uint32_t n_buckets; // for expiring via index only
+	bool collect_hists; // for single pass only
+	const bool* sets_not_evicting; // for single pass only - fill evict hist
+	uint32_t evict_ttl_range; // for single pass only
+	uint32_t evict_n_buckets; // for single pass only
+	cf_mutex evict_hist_lock; // for single pass only
 	uint64_t n_0_void_time;
 	uint64_t n_expired;
 } expire_overall_info;
@@ -76,13 +89,41 @@ typedef struct expire_per_thread_info_s {
 	as_namespace* ns;
 	as_partition_reservation* rsv;
 	uint32_t now;
+	bool populate_index;
+	bool collect_hists;
+	const bool* sets_not_evicting;
+	linear_hist* evict_hist; // NULL unless single pass with hwm breached
 	uint64_t n_0_void_time;
 	uint64_t n_expired;
 } expire_per_thread_info;
 
+// Expiration index - per partition, a wheel of buckets of index handles, each
+// bucket covering EXPIRE_BUCKET_SEC of void-time. Void-times beyond the wheel's
+// span wrap around, and are put back when visited early.
+
+#define EXPIRE_N_BUCKETS 256
+#define EXPIRE_BUCKET_SEC 64 // wheel spans ~4.5 hours
+
+typedef struct expire_bucket_s {
+	uint32_t n_handles;
+	uint32_t capacity;
+	cf_arenax_handle* handles; // may hold stale or duplicate handles
+} expire_bucket;
+
+typedef struct expire_wheel_s {
+	cf_mutex lock;
+	expire_bucket buckets[EXPIRE_N_BUCKETS];
+} expire_wheel;
+
+typedef struct as_nsup_expire_index_s {
+	bool ready; // records loaded at startup are added by the first full sweep
+	uint32_t last_now; // void-time clock as of the previous expire cycle
+	expire_wheel wheels[AS_PARTITIONS];
+} as_nsup_expire_index;
+
 typedef struct evict_overall_info_s {
 	as_namespace* ns;
-	uint32_t pid;
+	uint32_t item; // next tree slice to reduce
 	uint32_t i_cpu; // for cold start eviction only
 	uint32_t now;
 	uint32_t evict_void_time;
@@ -105,8 +146,8 @@ typedef struct evict_per_thread_info_s {
 
 typedef struct prep_evict_per_thread_info_s {
 	as_namespace* ns;
-	uint32_t* p_pid;
-	uint32_t i_cpu; // for cold start eviction only
+	uint32_t* p_pid; // or next tree slice, if sampling
+	uint32_t sample_pct;
 	const bool* sets_not_evicting;
 	linear_hist* evict_hist;
 } prep_evict_per_thread_info;
@@ -119,7 +160,19 @@ typedef struct prep_evict_per_thread_info_s {
 #define EVAL_STOP_WRITES_PERIOD 10 // seconds
 
 #define EVAL_WRITE_STATE_FREQUENCY 1024
-#define COLD_START_HIST_MIN_BUCKETS 100000 // histogram memory is transient
+#define COLD_START_HIST_MIN_BUCKETS (1024 * 1024) // memory is transient
+
+#define EVICT_SAMPLE_MIN_RECORDS 10000 // below this, build full histogram
+#define EVICT_SAMPLE_Z 2.0 // standard errors to shade sampled target down by
+
+
+//==========================================================
+// Globals.
+//
+
+// Serializes ttl & object size histogram collection between the histogram
+// thread and a single pass expire sweep. Zeroed is unlocked.
+static cf_mutex g_hist_locks[AS_NAMESPACE_SZ];
 
 
 //==========================================================
@@ -130,10 +183,19 @@ static bool nsup_smd_conflict_cb(const as_smd_item* existing_item, const as_smd_
 static void nsup_smd_accept_cb(const cf_vector* items, as_smd_accept_type accept_type);
 
 static void* run_expire_or_evict(void* udata);
+static void single_pass(as_namespace* ns, uint64_t* p_last_hist_time);
+static void submit_evict_void_time(as_namespace* ns, uint32_t evict_void_time);
 
 static void expire(as_namespace* ns);
 static void* run_expire(void* udata);
 static bool expire_reduce_cb(as_index_ref* r_ref, void* udata);
+static void fill_hists_from_record(expire_per_thread_info* per_thread, as_index* r);
+
+static void expire_from_index(as_namespace* ns);
+static void* run_expire_from_index(void* udata);
+static void expire_index_drain(expire_per_thread_info* per_thread, uint32_t bucket_ix);
+static void expire_index_visit(expire_per_thread_info* per_thread, uint32_t bucket_ix, cf_arenax_handle r_h);
+static int expire_index_handle_compare(const void* pa, const void* pb);
 
 static bool evict(as_namespace* ns);
 static void* run_evict(void* udata);
@@ -141,20 +203,31 @@ static bool evict_reduce_cb(as_index_ref* r_ref, void* udata);
 
 static bool eval_hwm_breached(as_namespace* ns);
 static uint32_t find_evict_void_time(as_namespace* ns, uint32_t now);
+static uint32_t evict_void_time_from_hist(as_namespace* ns, uint32_t now, uint32_t sample_pct, uint64_t target);
+static void fill_evict_hist(as_namespace* ns, uint32_t now, const bool* sets_not_evicting, uint32_t sample_pct);
+static bool get_sampled_evict_target(as_namespace* ns, uint64_t* target);
 static void* run_prep_evict(void* udata);
 static bool prep_evict_reduce_cb(as_index_ref* r_ref, void* udata);
 
 static void update_stats(as_namespace* ns, uint64_t n_0_void_time, uint64_t n_expired_objects, uint64_t n_evicted_objects, uint64_t start_ms);
 
+static void* run_memory_defrag(void* udata);
+static void memory_defrag(as_namespace* ns);
+static bool memory_defrag_reduce_cb(as_index_ref* r_ref, void* udata);
+
+static void* run_rebuild_blooms(void* udata);
+
 static void* run_stop_writes(void* udata);
 static bool eval_stop_writes(as_namespace* ns);
 
 static void* run_nsup_histograms(void* udata);
 static void collect_nsup_histograms(as_namespace* ns);
+static uint32_t prep_nsup_histograms(as_namespace* ns, uint32_t now);
+static void save_nsup_histograms(as_namespace* ns, uint32_t num_sets);
 static bool nsup_histograms_reduce_cb(as_index_ref* r_ref, void* udata);
+static void insert_nsup_histograms(as_namespace* ns, as_index* r, bool concurrent);
 
 static bool cold_start_evict(as_namespace* ns);
-static void* run_prep_cold_start_evict(void* udata);
 static uint64_t set_cold_start_threshold(as_namespace* ns, linear_hist* hist);
 static void* run_cold_start_evict(void* udata);
 static bool cold_start_evict_reduce_cb(as_index_ref* r_ref, void* udata);
@@ -174,6 +247,12 @@ evict_void_time_from_smd(const as_smd_item* item)
 	return (uint32_t)strtoul(item->value, NULL, 10); // TODO - sanity check?
 }
 
+static inline uint32_t
+expire_bucket_ix(uint32_t void_time)
+{
+	return (void_time / EXPIRE_BUCKET_SEC) % EXPIRE_N_BUCKETS;
+}
+
 
 //==========================================================
 // Public API.
@@ -184,6 +263,14 @@ as_nsup_init(void)
 {
 	as_smd_module_load(AS_SMD_MODULE_EVICT, nsup_smd_accept_cb,
 			nsup_smd_conflict_cb, NULL);
+
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		as_namespace* ns = g_config.namespaces[ns_ix];
+
+		if (ns->nsup_expire_index) {
+			ns->expire_index = cf_calloc(1, sizeof(as_nsup_expire_index));
+		}
+	}
 }
 
 void
@@ -196,11 +283,44 @@ as_nsup_start(void)
 
 		cf_thread_create_detached(run_expire_or_evict, ns);
 		cf_thread_create_detached(run_nsup_histograms, ns);
+
+		if (ns->storage_data_in_memory) {
+			cf_thread_create_detached(run_memory_defrag, ns);
+		}
+
+		if (ns->tree_shared.bloom_size != 0) {
+			cf_thread_create_detached(run_rebuild_blooms, ns);
+		}
 	}
 
 	cf_thread_create_detached(run_stop_writes, NULL);
 }
 
+// Called under the record lock, whenever a record gets a new void-time.
+void
+as_nsup_expire_index_add(as_namespace* ns, uint32_t pid, cf_arenax_handle r_h,
+		uint32_t void_time)
+{
+	if (ns->expire_index == NULL || void_time == 0) {
+		return;
+	}
+
+	expire_wheel* wheel = &ns->expire_index->wheels[pid];
+	expire_bucket* bucket = &wheel->buckets[expire_bucket_ix(void_time)];
+
+	cf_mutex_lock(&wheel->lock);
+
+	if (bucket->n_handles == bucket->capacity) {
+		bucket->capacity = bucket->capacity == 0 ? 16 : bucket->capacity * 2;
+		bucket->handles = cf_realloc(bucket->handles,
+				bucket->capacity * sizeof(cf_arenax_handle));
+	}
+
+	bucket->handles[bucket->n_handles++] = r_h;
+
+	cf_mutex_unlock(&wheel->lock);
+}
+
 bool
 as_nsup_handle_clock_skew(as_namespace* ns, uint64_t skew_ms)
 {
@@ -266,6 +386,47 @@ as_nsup_eviction_reset_cmd(const char* ns_name, const char* ttl_str,
 	cf_dyn_buf_append_string(db, "ok");
 }
 
+// The histogram spans all void-times allowed at startup, since the range of
+// void-times loaded isn't known until loading is done.
+void
+as_cold_start_evict_init(as_namespace* ns, uint32_t now)
+{
+	cf_mutex_init(&ns->cold_start_evict_lock);
+	ns->cold_start_now = now;
+
+	if (ns->cold_start_eviction_disabled) {
+		return;
+	}
+
+	uint32_t n_buckets = ns->evict_hist_buckets > COLD_START_HIST_MIN_BUCKETS ?
+			ns->evict_hist_buckets : COLD_START_HIST_MIN_BUCKETS;
+
+	ns->cold_start_evict_hist = linear_hist_create("cold-start-evict-hist",
+			LINEAR_HIST_SECONDS, now, ns->startup_max_void_time - now,
+			n_buckets);
+}
+
+// Called by loading threads as evictable records are kept or dropped - a
+// void-time of 0 means no record (or a record that can't be evicted).
+void
+as_cold_start_evict_hist_update(as_namespace* ns, uint32_t old_void_time,
+		uint32_t new_void_time)
+{
+	linear_hist* hist = ns->cold_start_evict_hist;
+
+	if (hist == NULL || old_void_time == new_void_time) {
+		return;
+	}
+
+	if (old_void_time != 0) {
+		linear_hist_remove_data_point_safe(hist, old_void_time);
+	}
+
+	if (new_void_time != 0) {
+		linear_hist_insert_data_point_safe(hist, new_void_time);
+	}
+}
+
 bool
 as_cold_start_evict_if_needed(as_namespace* ns)
 {
@@ -278,6 +439,17 @@ as_cold_start_evict_if_needed(as_namespace* ns)
 	return result;
 }
 
+void
+as_cold_start_evict_done(as_namespace* ns)
+{
+	cf_mutex_destroy(&ns->cold_start_evict_lock);
+
+	if (ns->cold_start_evict_hist != NULL) {
+		linear_hist_destroy(ns->cold_start_evict_hist);
+		ns->cold_start_evict_hist = NULL;
+	}
+}
+
 
 //==========================================================
 // Local helpers - SMD callbacks.
@@ -334,6 +506,7 @@ run_expire_or_evict(void* udata)
 	as_namespace* ns = (as_namespace*)udata;
 
 	uint64_t last_time = cf_get_seconds();
+	uint64_t last_hist_time = 0; // single pass collects histograms right away
 
 	while (true) {
 		sleep(1); // wake up every second to check
@@ -356,33 +529,18 @@ run_expire_or_evict(void* udata)
 
 		last_time = curr_time;
 
+		// Index mode visits only due records, so can't be fused.
+		if (ns->nsup_single_pass && ns->expire_index == NULL) {
+			single_pass(ns, &last_hist_time);
+			continue;
+		}
+
 		if (eval_hwm_breached(ns)) {
 			uint32_t now = as_record_void_time_get();
 			uint32_t evict_void_time = find_evict_void_time(ns, now);
 
 			if (evict_void_time > now) {
-				if (evict_void_time < ns->evict_void_time) {
-					// Unusual, maybe lots of new records with short TTLs ...
-					cf_info(AS_NSUP, "{%s} evict-void-time %u < previous",
-							ns->name, evict_void_time);
-
-					if (! as_smd_delete_blocking(AS_SMD_MODULE_EVICT, ns->name,
-							EVICT_SMD_TIMEOUT)) {
-						cf_warning(AS_NSUP, "{%s} timeout deleting evict-void-time",
-								ns->name);
-					}
-				}
-
-				char value[10 + 1];
-
-				sprintf(value, "%u", evict_void_time);
-
-				if (! as_smd_set_blocking(AS_SMD_MODULE_EVICT, ns->name, value,
-						EVICT_SMD_TIMEOUT)) {
-					cf_warning(AS_NSUP, "{%s} timeout setting evict-void-time %u",
-							ns->name, evict_void_time);
-				}
-
+				submit_evict_void_time(ns, evict_void_time);
 				continue;
 			}
 			// else - evict_void_time is now or 0.
@@ -399,6 +557,107 @@ run_expire_or_evict(void* udata)
 	return NULL;
 }
 
+// Expires, fills the eviction histogram if an hwm is breached, and collects
+// ttl & object size histograms if due, all in one sweep of the index.
+static void
+single_pass(as_namespace* ns, uint64_t* p_last_hist_time)
+{
+	uint64_t hist_period = ns->nsup_hist_period;
+	uint64_t curr_time = cf_get_seconds();
+	bool collect_hists = hist_period != 0 && ns->n_objects != 0 &&
+			(*p_last_hist_time == 0 ||
+					curr_time - *p_last_hist_time >= hist_period);
+
+	bool hwm_breached = eval_hwm_breached(ns);
+	uint32_t now = as_record_void_time_get();
+
+	uint64_t start_ms = cf_getms();
+	uint32_t n_threads = as_load_uint32(&ns->n_nsup_threads);
+
+	cf_info(AS_NSUP, "{%s} nsup-start: expire-threads %u single-pass%s%s",
+			ns->name, n_threads, hwm_breached ? " evict-hist" : "",
+			collect_hists ? " ttl-size-hists" : "");
+
+	cf_tid tids[n_threads];
+	bool sets_not_evicting[AS_SET_MAX_COUNT + 1] = { false };
+	uint32_t num_sets = 0;
+
+	expire_overall_info overall = {
+			.ns = ns,
+			.now = now,
+			.collect_hists = collect_hists
+	};
+
+	if (hwm_breached) {
+		init_sets_not_evicting(ns, sets_not_evicting);
+
+		overall.sets_not_evicting = sets_not_evicting;
+		overall.evict_ttl_range = get_ttl_range(ns, now);
+		overall.evict_n_buckets = ns->evict_hist_buckets;
+
+		linear_hist_reset(ns->evict_hist, now, overall.evict_ttl_range,
+				overall.evict_n_buckets);
+	}
+
+	if (collect_hists) {
+		*p_last_hist_time = curr_time;
+
+		cf_mutex_lock(&g_hist_locks[ns->ix]);
+		num_sets = prep_nsup_histograms(ns, now);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		tids[i] = cf_thread_create_joinable(run_expire, (void*)&overall);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		cf_thread_join(tids[i]);
+	}
+
+	if (collect_hists) {
+		save_nsup_histograms(ns, num_sets);
+		cf_mutex_unlock(&g_hist_locks[ns->ix]);
+	}
+
+	update_stats(ns, overall.n_0_void_time, overall.n_expired, 0, start_ms);
+
+	if (hwm_breached) {
+		// Expired records were left out, so no need to expire again if
+		// evict-void-time is now.
+		uint32_t evict_void_time = evict_void_time_from_hist(ns, now, 0, 0);
+
+		if (evict_void_time > now) {
+			submit_evict_void_time(ns, evict_void_time);
+		}
+	}
+}
+
+static void
+submit_evict_void_time(as_namespace* ns, uint32_t evict_void_time)
+{
+	if (evict_void_time < ns->evict_void_time) {
+		// Unusual, maybe lots of new records with short TTLs ...
+		cf_info(AS_NSUP, "{%s} evict-void-time %u < previous", ns->name,
+				evict_void_time);
+
+		if (! as_smd_delete_blocking(AS_SMD_MODULE_EVICT, ns->name,
+				EVICT_SMD_TIMEOUT)) {
+			cf_warning(AS_NSUP, "{%s} timeout deleting evict-void-time",
+					ns->name);
+		}
+	}
+
+	char value[10 + 1];
+
+	sprintf(value, "%u", evict_void_time);
+
+	if (! as_smd_set_blocking(AS_SMD_MODULE_EVICT, ns->name, value,
+			EVICT_SMD_TIMEOUT)) {
+		cf_warning(AS_NSUP, "{%s} timeout setting evict-void-time %u",
+				ns->name, evict_void_time);
+	}
+}
+
 
 //==========================================================
 // Local helpers - expire.
@@ -407,6 +666,13 @@ run_expire_or_evict(void* udata)
 static void
 expire(as_namespace* ns)
 {
+	as_nsup_expire_index* index = ns->expire_index;
+
+	if (index != NULL && index->ready) {
+		expire_from_index(ns);
+		return;
+	}
+
 	uint64_t start_ms = cf_getms();
 	uint32_t n_threads = as_load_uint32(&ns->n_nsup_threads);
 
@@ -416,7 +682,8 @@ expire(as_namespace* ns)
 
 	expire_overall_info overall = {
 			.ns = ns,
-			.now = as_record_void_time_get()
+			.now = as_record_void_time_get(),
+			.populate_index = index != NULL
 	};
 
 	for (uint32_t i = 0; i < n_threads; i++) {
@@ -427,6 +694,11 @@ expire(as_namespace* ns)
 		cf_thread_join(tids[i]);
 	}
 
+	if (index != NULL) {
+		index->last_now = overall.now;
+		index->ready = true;
+	}
+
 	update_stats(ns, overall.n_0_void_time, overall.n_expired, 0, start_ms);
 }
 
@@ -438,21 +710,40 @@ run_expire(void* udata)
 
 	expire_per_thread_info per_thread = {
 			.ns = ns,
-			.now = overall->now
+			.now = overall->now,
+			.populate_index = overall->populate_index,
+			.collect_hists = overall->collect_hists,
+			.sets_not_evicting = overall->sets_not_evicting
 	};
 
-	uint32_t pid;
+	if (overall->sets_not_evicting != NULL) {
+		per_thread.evict_hist = linear_hist_create("per-thread-hist",
+				LINEAR_HIST_SECONDS, overall->now, overall->evict_ttl_range,
+				overall->evict_n_buckets);
+	}
 
-	while ((pid = as_faa_uint32(&overall->pid, 1)) < AS_PARTITIONS) {
+	uint32_t item;
+
+	// Work items are tree slices, so big partitions don't leave threads idle.
+	while ((item = as_faa_uint32(&overall->item, 1)) < AS_INDEX_N_REDUCE_ITEMS) {
 		as_partition_reservation rsv;
-		as_partition_reserve(ns, pid, &rsv);
+		as_partition_reserve(ns, item / AS_INDEX_N_REDUCE_SLICES, &rsv);
 
 		per_thread.rsv = &rsv;
 
-		as_index_reduce_live(rsv.tree, expire_reduce_cb, (void*)&per_thread);
+		as_index_reduce_slice(rsv.tree, item % AS_INDEX_N_REDUCE_SLICES,
+				expire_reduce_cb, (void*)&per_thread);
 		as_partition_release(&rsv);
 	}
 
+	if (per_thread.evict_hist != NULL) {
+		cf_mutex_lock(&overall->evict_hist_lock);
+		linear_hist_merge(ns->evict_hist, per_thread.evict_hist);
+		cf_mutex_unlock(&overall->evict_hist_lock);
+
+		linear_hist_destroy(per_thread.evict_hist);
+	}
+
 	as_add_uint64(&overall->n_0_void_time, (int64_t)per_thread.n_0_void_time);
 	as_add_uint64(&overall->n_expired, (int64_t)per_thread.n_expired);
 
@@ -477,128 +768,321 @@ expire_reduce_cb(as_index_ref* r_ref, void* udata)
 
 		return true; // drop_local() calls as_record_done()
 	}
+	else if (per_thread->populate_index) {
+		as_nsup_expire_index_add(ns, per_thread->rsv->p->id, r_ref->r_h,
+				void_time);
+	}
+
+	if (per_thread->collect_hists || per_thread->evict_hist != NULL) {
+		fill_hists_from_record(per_thread, r_ref->r);
+	}
 
 	as_record_done(r_ref, ns);
 
 	return true;
 }
 
+static void
+fill_hists_from_record(expire_per_thread_info* per_thread, as_index* r)
+{
+	// Note - slice reduce doesn't skip non-live records.
+	if (! as_record_is_live(r)) {
+		return;
+	}
 
-//==========================================================
-// Local helpers - evict.
-//
+	if (per_thread->collect_hists) {
+		insert_nsup_histograms(per_thread->ns, r, true);
+	}
 
-static bool
-evict(as_namespace* ns)
-{
-	uint32_t evict_void_time = as_load_uint32(&ns->evict_void_time);
-	uint32_t smd_evict_void_time = as_load_uint32(&ns->smd_evict_void_time);
+	uint32_t void_time = r->void_time;
 
-	if (evict_void_time >= smd_evict_void_time) {
-		return false;
+	if (per_thread->evict_hist != NULL && void_time != 0 &&
+			! per_thread->sets_not_evicting[as_index_get_set_id(r)]) {
+		linear_hist_insert_data_point(per_thread->evict_hist, void_time);
 	}
+}
 
+// Visits only buckets that have come due since the previous cycle. Doesn't
+// count non-expirable records - that stat keeps its last full sweep value.
+static void
+expire_from_index(as_namespace* ns)
+{
+	as_nsup_expire_index* index = ns->expire_index;
 	uint64_t start_ms = cf_getms();
-	uint32_t now = as_record_void_time_get();
 	uint32_t n_threads = as_load_uint32(&ns->n_nsup_threads);
+	uint32_t now = as_record_void_time_get();
 
-	// For stats, show eviction depth WRT local time. Note - unlikely to be
-	// negative, but theoretically possible - cutoff could have come from
-	// another node, and/or taken very long to calculate/transmit.
-	ns->evict_ttl = (int32_t)(smd_evict_void_time - now);
-
-	cf_info(AS_NSUP, "{%s} nsup-start: evict-threads %u evict-ttl %d evict-void-time (%u,%u)",
-			ns->name, n_threads, ns->evict_ttl, evict_void_time,
-			smd_evict_void_time);
-
-	evict_void_time = smd_evict_void_time;
-
-	if (now > evict_void_time) {
-		evict_void_time = now;
+	uint32_t first_bucket = index->last_now / EXPIRE_BUCKET_SEC;
+	uint32_t n_buckets = now / EXPIRE_BUCKET_SEC - first_bucket + 1;
 
-		cf_info(AS_NSUP, "{%s} now (%u) > evict-void-time - using now",
-				ns->name, now);
+	if (n_buckets > EXPIRE_N_BUCKETS) { // also covers clock going backwards
+		n_buckets = EXPIRE_N_BUCKETS;
 	}
 
-	bool sets_not_evicting[AS_SET_MAX_COUNT + 1] = { false };
-	init_sets_not_evicting(ns, sets_not_evicting);
+	cf_info(AS_NSUP, "{%s} nsup-start: expire-threads %u index-buckets %u",
+			ns->name, n_threads, n_buckets);
 
 	cf_tid tids[n_threads];
 
-	evict_overall_info overall = {
+	expire_overall_info overall = {
 			.ns = ns,
 			.now = now,
-			.evict_void_time = evict_void_time,
-			.sets_not_evicting = (const bool*)sets_not_evicting
+			.first_bucket = first_bucket % EXPIRE_N_BUCKETS,
+			.n_buckets = n_buckets
 	};
 
 	for (uint32_t i = 0; i < n_threads; i++) {
-		tids[i] = cf_thread_create_joinable(run_evict, (void*)&overall);
+		tids[i] = cf_thread_create_joinable(run_expire_from_index,
+				(void*)&overall);
 	}
 
 	for (uint32_t i = 0; i < n_threads; i++) {
 		cf_thread_join(tids[i]);
 	}
 
-	update_stats(ns, overall.n_0_void_time, overall.n_expired,
-			overall.n_evicted, start_ms);
-
-	ns->evict_void_time = evict_void_time;
+	index->last_now = now;
 
-	return true;
+	update_stats(ns, ns->non_expirable_objects, overall.n_expired, 0,
+			start_ms);
 }
 
 static void*
-run_evict(void* udata)
+run_expire_from_index(void* udata)
 {
-	evict_overall_info* overall = (evict_overall_info*)udata;
+	expire_overall_info* overall = (expire_overall_info*)udata;
 	as_namespace* ns = overall->ns;
 
-	evict_per_thread_info per_thread = {
+	expire_per_thread_info per_thread = {
 			.ns = ns,
-			.now = overall->now,
-			.evict_void_time = overall->evict_void_time,
-			.sets_not_evicting = overall->sets_not_evicting
+			.now = overall->now
 	};
 
 	uint32_t pid;
 
-	while ((pid = as_faa_uint32(&overall->pid, 1)) < AS_PARTITIONS) {
+	while ((pid = as_faa_uint32(&overall->item, 1)) < AS_PARTITIONS) {
 		as_partition_reservation rsv;
 		as_partition_reserve(ns, pid, &rsv);
 
 		per_thread.rsv = &rsv;
 
-		as_index_reduce_live(rsv.tree, evict_reduce_cb, (void*)&per_thread);
+		for (uint32_t i = 0; i < overall->n_buckets; i++) {
+			expire_index_drain(&per_thread,
+					(overall->first_bucket + i) % EXPIRE_N_BUCKETS);
+		}
+
 		as_partition_release(&rsv);
 	}
 
-	as_add_uint64(&overall->n_0_void_time, (int64_t)per_thread.n_0_void_time);
 	as_add_uint64(&overall->n_expired, (int64_t)per_thread.n_expired);
-	as_add_uint64(&overall->n_evicted, (int64_t)per_thread.n_evicted);
 
 	return NULL;
 }
 
-static bool
-evict_reduce_cb(as_index_ref* r_ref, void* udata)
+static void
+expire_index_drain(expire_per_thread_info* per_thread, uint32_t bucket_ix)
+{
+	as_partition_reservation* rsv = per_thread->rsv;
+	expire_wheel* wheel = &per_thread->ns->expire_index->wheels[rsv->p->id];
+	expire_bucket* bucket = &wheel->buckets[bucket_ix];
+
+	// Take the bucket's contents - writes meanwhile start a new array.
+	cf_mutex_lock(&wheel->lock);
+
+	expire_bucket drained = *bucket;
+
+	bucket->n_handles = 0;
+	bucket->capacity = 0;
+	bucket->handles = NULL;
+
+	cf_mutex_unlock(&wheel->lock);
+
+	if (drained.n_handles == 0) {
+		cf_free(drained.handles);
+		return;
+	}
+
+	if (rsv->tree != NULL) {
+		// Rewrites add duplicates - sort so each record is visited once.
+		qsort(drained.handles, drained.n_handles, sizeof(cf_arenax_handle),
+				expire_index_handle_compare);
+
+		for (uint32_t i = 0; i < drained.n_handles; i++) {
+			if (i != 0 && drained.handles[i] == drained.handles[i - 1]) {
+				continue;
+			}
+
+			expire_index_visit(per_thread, bucket_ix, drained.handles[i]);
+		}
+	}
+	// else - partition not held here, handles are all stale.
+
+	cf_free(drained.handles);
+}
+
+static void
+expire_index_visit(expire_per_thread_info* per_thread, uint32_t bucket_ix,
+		cf_arenax_handle r_h)
 {
-	as_index* r = r_ref->r;
-	evict_per_thread_info* per_thread = (evict_per_thread_info*)udata;
 	as_namespace* ns = per_thread->ns;
-	uint32_t void_time = r->void_time;
 
-	if (void_time == 0) {
-		per_thread->n_0_void_time++;
+	// Unlocked read - element may since have been freed or reused. The locked
+	// lookup below decides, so a stale digest just misses or is skipped.
+	cf_digest keyd = ((as_index*)cf_arenax_resolve(ns->arena, r_h))->keyd;
+	as_index_ref r_ref;
+
+	if (as_record_get(per_thread->rsv->tree, &keyd, &r_ref) != 0) {
+		return;
 	}
-	else if (per_thread->sets_not_evicting[as_index_get_set_id(r)]) {
+
+	uint32_t void_time = r_ref.r->void_time;
+
+	if (r_ref.r_h == r_h && void_time != 0) {
 		if (per_thread->now > void_time) {
-			if (drop_local(ns, per_thread->rsv, r_ref)) {
+			if (drop_local(ns, per_thread->rsv, &r_ref)) {
 				as_sindex_gc_record_throttle(ns);
 				per_thread->n_expired++;
 			}
 
-			return true; // drop_local() calls as_record_done()
+			return; // drop_local() calls as_record_done()
+		}
+
+		// If in another bucket, the record was rewritten and is there too.
+		if (expire_bucket_ix(void_time) == bucket_ix) {
+			as_nsup_expire_index_add(ns, per_thread->rsv->p->id, r_h,
+					void_time); // wheel wrapped - not due yet
+		}
+	}
+
+	as_record_done(&r_ref, ns);
+}
+
+static int
+expire_index_handle_compare(const void* pa, const void* pb)
+{
+	cf_arenax_handle a = *(const cf_arenax_handle*)pa;
+	cf_arenax_handle b = *(const cf_arenax_handle*)pb;
+
+	return a > b ? 1 : (a < b ? -1 : 0);
+}
+
+
+//==========================================================
+// Local helpers - evict.
+//
+
+static bool
+evict(as_namespace* ns)
+{
+	uint32_t evict_void_time = as_load_uint32(&ns->evict_void_time);
+	uint32_t smd_evict_void_time = as_load_uint32(&ns->smd_evict_void_time);
+
+	if (evict_void_time >= smd_evict_void_time) {
+		return false;
+	}
+
+	uint64_t start_ms = cf_getms();
+	uint32_t now = as_record_void_time_get();
+	uint32_t n_threads = as_load_uint32(&ns->n_nsup_threads);
+
+	// For stats, show eviction depth WRT local time. Note - unlikely to be
+	// negative, but theoretically possible - cutoff could have come from
+	// another node, and/or taken very long to calculate/transmit.
+	ns->evict_ttl = (int32_t)(smd_evict_void_time - now);
+
+	cf_info(AS_NSUP, "{%s} nsup-start: evict-threads %u evict-ttl %d evict-void-time (%u,%u)",
+			ns->name, n_threads, ns->evict_ttl, evict_void_time,
+			smd_evict_void_time);
+
+	evict_void_time = smd_evict_void_time;
+
+	if (now > evict_void_time) {
+		evict_void_time = now;
+
+		cf_info(AS_NSUP, "{%s} now (%u) > evict-void-time - using now",
+				ns->name, now);
+	}
+
+	bool sets_not_evicting[AS_SET_MAX_COUNT + 1] = { false };
+	init_sets_not_evicting(ns, sets_not_evicting);
+
+	cf_tid tids[n_threads];
+
+	evict_overall_info overall = {
+			.ns = ns,
+			.now = now,
+			.evict_void_time = evict_void_time,
+			.sets_not_evicting = (const bool*)sets_not_evicting
+	};
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		tids[i] = cf_thread_create_joinable(run_evict, (void*)&overall);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		cf_thread_join(tids[i]);
+	}
+
+	update_stats(ns, overall.n_0_void_time, overall.n_expired,
+			overall.n_evicted, start_ms);
+
+	ns->evict_void_time = evict_void_time;
+
+	return true;
+}
+
+static void*
+run_evict(void* udata)
+{
+	evict_overall_info* overall = (evict_overall_info*)udata;
+	as_namespace* ns = overall->ns;
+
+	evict_per_thread_info per_thread = {
+			.ns = ns,
+			.now = overall->now,
+			.evict_void_time = overall->evict_void_time,
+			.sets_not_evicting = overall->sets_not_evicting
+	};
+
+	uint32_t item;
+
+	// Work items are tree slices, so big partitions don't leave threads idle.
+	while ((item = as_faa_uint32(&overall->item, 1)) < AS_INDEX_N_REDUCE_ITEMS) {
+		as_partition_reservation rsv;
+		as_partition_reserve(ns, item / AS_INDEX_N_REDUCE_SLICES, &rsv);
+
+		per_thread.rsv = &rsv;
+
+		as_index_reduce_slice(rsv.tree, item % AS_INDEX_N_REDUCE_SLICES,
+				evict_reduce_cb, (void*)&per_thread);
+		as_partition_release(&rsv);
+	}
+
+	as_add_uint64(&overall->n_0_void_time, (int64_t)per_thread.n_0_void_time);
+	as_add_uint64(&overall->n_expired, (int64_t)per_thread.n_expired);
+	as_add_uint64(&overall->n_evicted, (int64_t)per_thread.n_evicted);
+
+	return NULL;
+}
+
+static bool
+evict_reduce_cb(as_index_ref* r_ref, void* udata)
+{
+	as_index* r = r_ref->r;
+	evict_per_thread_info* per_thread = (evict_per_thread_info*)udata;
+	as_namespace* ns = per_thread->ns;
+	uint32_t void_time = r->void_time;
+
+	if (void_time == 0) {
+		per_thread->n_0_void_time++;
+	}
+	else if (per_thread->sets_not_evicting[as_index_get_set_id(r)]) {
+		if (per_thread->now > void_time) {
+			if (drop_local(ns, per_thread->rsv, r_ref)) {
+				as_sindex_gc_record_throttle(ns);
+				per_thread->n_expired++;
+			}
+
+			return true; // drop_local() calls as_record_done()
 		}
 	}
 	else if (per_thread->evict_void_time > void_time) {
@@ -623,7 +1107,7 @@ evict_reduce_cb(as_index_ref* r_ref, void* udata)
 static bool
 eval_hwm_breached(as_namespace* ns)
 {
-	uint64_t index_sz = (ns->n_tombstones + ns->n_objects) * sizeof(as_index);
+	uint64_t index_sz = (ns->n_tombstones + ns->n_objects) * ns->arena->element_size;
 
 	uint64_t index_mem_sz = 0;
 	uint64_t index_dev_sz = 0;
@@ -702,38 +1186,31 @@ find_evict_void_time(as_namespace* ns, uint32_t now)
 	bool sets_not_evicting[AS_SET_MAX_COUNT + 1] = { false };
 	init_sets_not_evicting(ns, sets_not_evicting);
 
-	uint32_t ttl_range = get_ttl_range(ns, now);
-	uint32_t n_buckets = ns->evict_hist_buckets;
-	linear_hist_reset(ns->evict_hist, now, ttl_range, n_buckets);
-
-	uint32_t n_threads = as_load_uint32(&ns->n_nsup_threads);
-	cf_tid tids[n_threads];
-
-	prep_evict_per_thread_info per_threads[n_threads];
-	uint32_t pid = 0;
-
-	for (uint32_t i = 0; i < n_threads; i++) {
-		prep_evict_per_thread_info* per_thread = &per_threads[i];
+	uint32_t sample_pct = as_load_uint32(&ns->evict_sample_pct);
+	uint64_t target = 0;
 
-		per_thread->ns = ns;
-		per_thread->p_pid = &pid;
-		per_thread->sets_not_evicting = (const bool*)sets_not_evicting;
-		per_thread->evict_hist = linear_hist_create("per-thread-hist",
-				LINEAR_HIST_SECONDS, now, ttl_range, n_buckets);
+	fill_evict_hist(ns, now, sets_not_evicting, sample_pct);
 
-		tids[i] = cf_thread_create_joinable(run_prep_evict, (void*)per_thread);
+	if (sample_pct != 0 && ! get_sampled_evict_target(ns, &target)) {
+		sample_pct = 0;
+		fill_evict_hist(ns, now, sets_not_evicting, 0);
 	}
 
-	for (uint32_t i = 0; i < n_threads; i++) {
-		cf_thread_join(tids[i]);
-
-		linear_hist_merge(ns->evict_hist, per_threads[i].evict_hist);
-		linear_hist_destroy(per_threads[i].evict_hist);
-	}
+	return evict_void_time_from_hist(ns, now, sample_pct, target);
+}
 
+// If sample_pct is non-zero, target is the subtotal to evict from the sampled
+// histogram, otherwise the histogram is complete and evict-tenths-pct is used.
+static uint32_t
+evict_void_time_from_hist(as_namespace* ns, uint32_t now, uint32_t sample_pct,
+		uint64_t target)
+{
 	linear_hist_threshold threshold;
-	uint64_t subtotal = linear_hist_get_threshold_for_fraction(ns->evict_hist,
-			ns->evict_tenths_pct, &threshold);
+	uint64_t subtotal = sample_pct == 0 ?
+			linear_hist_get_threshold_for_fraction(ns->evict_hist,
+					ns->evict_tenths_pct, &threshold) :
+			linear_hist_get_threshold_for_subtotal(ns->evict_hist, target,
+					&threshold);
 	uint32_t evict_void_time = threshold.value;
 
 	if (evict_void_time == 0xFFFFffff) { // looped past all buckets
@@ -761,16 +1238,110 @@ find_evict_void_time(as_namespace* ns, uint32_t now)
 		return evict_void_time == now ? now : 0;
 	}
 
+	if (sample_pct != 0) {
+		// Scale to an estimate for the whole namespace.
+		subtotal = subtotal * 100 / sample_pct;
+	}
+
 	cf_info(AS_NSUP, "{%s} found %lu records eligible for eviction at evict-ttl %u - submitting evict-void-time %u",
 			ns->name, subtotal, evict_void_time - now, evict_void_time);
 
 	return evict_void_time;
 }
 
+// If sample_pct is non-zero, reduce only a random sample of tree slices. Since
+// digests are uniformly distributed, slices are a sample of digest space.
+static void
+fill_evict_hist(as_namespace* ns, uint32_t now, const bool* sets_not_evicting,
+		uint32_t sample_pct)
+{
+	uint32_t ttl_range = get_ttl_range(ns, now);
+	uint32_t n_buckets = ns->evict_hist_buckets;
+	linear_hist_reset(ns->evict_hist, now, ttl_range, n_buckets);
+
+	uint32_t n_threads = as_load_uint32(&ns->n_nsup_threads);
+	cf_tid tids[n_threads];
+
+	prep_evict_per_thread_info per_threads[n_threads];
+	uint32_t pid = 0;
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		prep_evict_per_thread_info* per_thread = &per_threads[i];
+
+		per_thread->ns = ns;
+		per_thread->p_pid = &pid;
+		per_thread->sample_pct = sample_pct;
+		per_thread->sets_not_evicting = sets_not_evicting;
+		per_thread->evict_hist = linear_hist_create("per-thread-hist",
+				LINEAR_HIST_SECONDS, now, ttl_range, n_buckets);
+
+		tids[i] = cf_thread_create_joinable(run_prep_evict, (void*)per_thread);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		cf_thread_join(tids[i]);
+
+		linear_hist_merge(ns->evict_hist, per_threads[i].evict_hist);
+		linear_hist_destroy(per_threads[i].evict_hist);
+	}
+}
+
+// The quantile of a sample has standard error sqrt(f * (1 - f) / n). Shade
+// the target down so we're unlikely to evict more than evict-tenths-pct.
+static bool
+get_sampled_evict_target(as_namespace* ns, uint64_t* target)
+{
+	uint64_t n_sampled = linear_hist_get_total(ns->evict_hist);
+	double f = (double)ns->evict_tenths_pct / 1000.0;
+
+	if (n_sampled < EVICT_SAMPLE_MIN_RECORDS || f >= 1.0) {
+		cf_info(AS_NSUP, "{%s} sampled %lu records - building full histogram",
+				ns->name, n_sampled);
+		return false;
+	}
+
+	double lower = f - EVICT_SAMPLE_Z * sqrt(f * (1.0 - f) / (double)n_sampled);
+
+	if (lower <= 0.0) {
+		cf_info(AS_NSUP, "{%s} sampled %lu records - too few for evict-tenths-pct %u - building full histogram",
+				ns->name, n_sampled, ns->evict_tenths_pct);
+		return false;
+	}
+
+	*target = (uint64_t)(lower * (double)n_sampled);
+
+	cf_info(AS_NSUP, "{%s} sampled %lu records - target %lu (%.3f pct)",
+			ns->name, n_sampled, *target, lower * 100.0);
+
+	return true;
+}
+
 static void*
 run_prep_evict(void* udata)
 {
 	prep_evict_per_thread_info* per_thread = (prep_evict_per_thread_info*)udata;
+
+	if (per_thread->sample_pct != 0) {
+		uint32_t item;
+
+		while ((item = as_faa_uint32(per_thread->p_pid, 1)) <
+				AS_INDEX_N_REDUCE_ITEMS) {
+			if (cf_get_rand32() % 100 >= per_thread->sample_pct) {
+				continue;
+			}
+
+			as_partition_reservation rsv;
+			as_partition_reserve(per_thread->ns,
+					item / AS_INDEX_N_REDUCE_SLICES, &rsv);
+
+			as_index_reduce_slice(rsv.tree, item % AS_INDEX_N_REDUCE_SLICES,
+					prep_evict_reduce_cb, (void*)per_thread);
+			as_partition_release(&rsv);
+		}
+
+		return NULL;
+	}
+
 	uint32_t pid;
 
 	while ((pid = as_faa_uint32(per_thread->p_pid, 1)) < AS_PARTITIONS) {
@@ -791,7 +1362,8 @@ prep_evict_reduce_cb(as_index_ref* r_ref, void* udata)
 	prep_evict_per_thread_info* per_thread = (prep_evict_per_thread_info*)udata;
 	uint32_t void_time = r->void_time;
 
-	if (void_time != 0 &&
+	// Note - slice reduce (when sampling) doesn't skip non-live records.
+	if (void_time != 0 && as_record_is_live(r) &&
 			! per_thread->sets_not_evicting[as_index_get_set_id(r)]) {
 		linear_hist_insert_data_point(per_thread->evict_hist, void_time);
 	}
@@ -820,6 +1392,9 @@ update_stats(as_namespace* ns, uint64_t n_0_void_time,
 
 	ns->nsup_cycle_duration = (uint32_t)(total_duration_ms / 1000);
 
+	ASD_PROBE4(nsup__cycle_done, ns->ix, n_expired_objects, n_evicted_objects,
+			total_duration_ms);
+
 	cf_info(AS_NSUP, "{%s} nsup-done: non-expirable %lu expired (%lu,%lu) evicted (%lu,%lu) evict-ttl %d total-ms %lu",
 			ns->name,
 			n_0_void_time,
@@ -830,6 +1405,135 @@ update_stats(as_namespace* ns, uint64_t n_0_void_time,
 }
 
 
+//==========================================================
+// Local helpers - data-in-memory defrag.
+//
+
+typedef struct memory_defrag_info_s {
+	as_namespace* ns;
+	cf_alloc_bin_util util;
+	uint32_t lwm_pct;
+	uint64_t n_moved;
+} memory_defrag_info;
+
+static void*
+run_memory_defrag(void* udata)
+{
+	as_namespace* ns = (as_namespace*)udata;
+
+	uint64_t last_time = cf_get_seconds();
+
+	while (true) {
+		sleep(1); // wake up every second to check
+
+		uint64_t period = ns->memory_defrag_period;
+		uint64_t curr_time = cf_get_seconds();
+
+		if (period == 0 || curr_time - last_time < period) {
+			continue;
+		}
+
+		last_time = curr_time;
+
+		memory_defrag(ns);
+	}
+
+	return NULL;
+}
+
+static void
+memory_defrag(as_namespace* ns)
+{
+	memory_defrag_info info = {
+			.ns = ns,
+			.lwm_pct = ns->memory_defrag_lwm_pct
+	};
+
+	cf_alloc_arena_bin_util(ns->jem_arena, &info.util);
+
+	bool any_sparse = false;
+
+	for (uint32_t i = 0; i < info.util.n_bins; i++) {
+		if (info.util.util_pct[i] < info.lwm_pct) {
+			any_sparse = true;
+			break;
+		}
+	}
+
+	if (! any_sparse) {
+		return;
+	}
+
+	uint64_t start_ms = cf_getms();
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		as_partition_reservation rsv;
+		as_partition_reserve(ns, pid, &rsv);
+
+		as_index_reduce_live(rsv.tree, memory_defrag_reduce_cb, (void*)&info);
+		as_partition_release(&rsv);
+	}
+
+	cf_alloc_arena_purge(ns->jem_arena);
+
+	as_add_uint64(&ns->n_memory_defrag_moved, (int64_t)info.n_moved);
+
+	cf_info(AS_NSUP, "{%s} memory defrag relocated %lu allocations in %lu ms",
+			ns->name, info.n_moved, cf_getms() - start_ms);
+}
+
+static bool
+memory_defrag_reduce_cb(as_index_ref* r_ref, void* udata)
+{
+	memory_defrag_info* info = (memory_defrag_info*)udata;
+	as_namespace* ns = info->ns;
+
+	info->n_moved += as_bin_relocate_stored(ns, r_ref->r, &info->util,
+			info->lwm_pct);
+	as_record_done(r_ref, ns);
+
+	return true;
+}
+
+
+//==========================================================
+// Local helpers - partition tree Bloom filters.
+//
+
+// Trees decide for themselves whether they need a rebuild - checking is cheap,
+// so just visit every partition each second.
+static void*
+run_rebuild_blooms(void* udata)
+{
+	as_namespace* ns = (as_namespace*)udata;
+
+	while (true) {
+		sleep(1);
+
+		uint64_t start_ms = cf_getms();
+		uint32_t n_rebuilt = 0;
+
+		for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+			as_partition_reservation rsv;
+			as_partition_reserve(ns, pid, &rsv);
+
+			if (rsv.tree != NULL && as_index_tree_rebuild_bloom(rsv.tree)) {
+				n_rebuilt++;
+			}
+
+			as_partition_release(&rsv);
+		}
+
+		if (n_rebuilt != 0) {
+			cf_detail(AS_NSUP, "{%s} rebuilt %u partition tree bloom filters in %lu ms",
+					ns->name, n_rebuilt, cf_getms() - start_ms);
+		}
+	}
+
+	return NULL;
+}
+
+
 //==========================================================
 // Local helpers - stop writes.
 //
@@ -861,7 +1565,7 @@ eval_stop_writes(as_namespace* ns)
 
 	// Note that persisted index is not counted against stop-writes.
 	uint64_t index_mem_sz = as_namespace_index_persisted(ns) ?
-			0 : (ns->n_tombstones + ns->n_objects) * sizeof(as_index);
+			0 : (ns->n_tombstones + ns->n_objects) * ns->arena->element_size;
 	uint64_t set_index_sz = as_set_index_used_bytes(ns);
 	uint64_t sindex_sz = as_sindex_used_bytes(ns);
 	uint64_t dim_sz = ns->n_bytes_memory;
@@ -927,10 +1631,18 @@ run_nsup_histograms(void* udata)
 			continue;
 		}
 
+		// Collected by the expire sweep instead - see single_pass().
+		if (ns->nsup_single_pass && ns->expire_index == NULL &&
+				as_load_uint32(&ns->nsup_period) != 0) {
+			continue;
+		}
+
 		wait = true;
 		last_time = curr_time;
 
+		cf_mutex_lock(&g_hist_locks[ns->ix]);
 		collect_nsup_histograms(ns);
+		cf_mutex_unlock(&g_hist_locks[ns->ix]);
 	}
 
 	return NULL;
@@ -943,9 +1655,25 @@ collect_nsup_histograms(as_namespace* ns)
 		return;
 	}
 
+	uint32_t num_sets = prep_nsup_histograms(ns, as_record_void_time_get());
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		as_partition_reservation rsv;
+		as_partition_reserve(ns, pid, &rsv);
+
+		as_index_reduce_live(rsv.tree, nsup_histograms_reduce_cb, (void*)ns);
+		as_partition_release(&rsv);
+	}
+
+	save_nsup_histograms(ns, num_sets);
+}
+
+// Returns the number of sets with histograms ready to fill.
+static uint32_t
+prep_nsup_histograms(as_namespace* ns, uint32_t now)
+{
 	cf_info(AS_NSUP, "{%s} collecting ttl & object size info ...", ns->name);
 
-	uint32_t now = as_record_void_time_get();
 	uint32_t ttl_range = get_ttl_range(ns, now);
 
 	linear_hist_clear(ns->ttl_hist, now, ttl_range);
@@ -994,14 +1722,12 @@ collect_nsup_histograms(as_namespace* ns)
 		}
 	}
 
-	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
-		as_partition_reservation rsv;
-		as_partition_reserve(ns, pid, &rsv);
-
-		as_index_reduce_live(rsv.tree, nsup_histograms_reduce_cb, (void*)ns);
-		as_partition_release(&rsv);
-	}
+	return num_sets;
+}
 
+static void
+save_nsup_histograms(as_namespace* ns, uint32_t num_sets)
+{
 	linear_hist_dump(ns->ttl_hist);
 	linear_hist_save_info(ns->ttl_hist);
 
@@ -1025,36 +1751,47 @@ collect_nsup_histograms(as_namespace* ns)
 static bool
 nsup_histograms_reduce_cb(as_index_ref* r_ref, void* udata)
 {
-	as_index* r = r_ref->r;
 	as_namespace* ns = (as_namespace*)udata;
+
+	insert_nsup_histograms(ns, r_ref->r, false);
+	as_record_done(r_ref, ns);
+
+	return true;
+}
+
+// If concurrent, other threads may be inserting into the same histograms.
+static void
+insert_nsup_histograms(as_namespace* ns, as_index* r, bool concurrent)
+{
+	void (*lin_insert)(linear_hist*, uint32_t) = concurrent ?
+			linear_hist_insert_data_point_safe : linear_hist_insert_data_point;
+	void (*log_insert)(histogram*, uint64_t) = concurrent ?
+			histogram_insert_raw : histogram_insert_raw_unsafe;
+
 	uint32_t set_id = as_index_get_set_id(r);
 	linear_hist* set_ttl_hist = ns->set_ttl_hists[set_id];
 	uint32_t void_time = r->void_time;
 
-	linear_hist_insert_data_point(ns->ttl_hist, void_time);
+	lin_insert(ns->ttl_hist, void_time);
 
 	if (set_ttl_hist != NULL) {
-		linear_hist_insert_data_point(set_ttl_hist, void_time);
+		lin_insert(set_ttl_hist, void_time);
 	}
 
 	uint32_t size = ns->storage_type == AS_STORAGE_ENGINE_MEMORY ?
 			as_storage_record_mem_size(ns, r) :
 			as_storage_record_device_size(ns, r);
 
-	histogram_insert_raw_unsafe(ns->obj_size_log_hist, size);
-	linear_hist_insert_data_point(ns->obj_size_lin_hist, size);
+	log_insert(ns->obj_size_log_hist, size);
+	lin_insert(ns->obj_size_lin_hist, size);
 
 	histogram* set_obj_size_log_hist = ns->set_obj_size_log_hists[set_id];
 	linear_hist* set_obj_size_lin_hist = ns->set_obj_size_lin_hists[set_id];
 
 	if (set_obj_size_log_hist != NULL) {
-		histogram_insert_raw_unsafe(set_obj_size_log_hist, size);
-		linear_hist_insert_data_point(set_obj_size_lin_hist, size);
+		log_insert(set_obj_size_log_hist, size);
+		lin_insert(set_obj_size_lin_hist, size);
 	}
-
-	as_record_done(r_ref, ns);
-
-	return true;
 }
 
 
@@ -1089,50 +1826,9 @@ cold_start_evict(as_namespace* ns)
 		return true;
 	}
 
-	cf_info(AS_NSUP, "{%s} cold start building evict histogram ...", ns->name);
-
-	uint32_t ttl_range = get_ttl_range(ns, now);
-	uint32_t n_buckets = ns->evict_hist_buckets > COLD_START_HIST_MIN_BUCKETS ?
-			ns->evict_hist_buckets : COLD_START_HIST_MIN_BUCKETS;
-
-	bool sets_not_evicting[AS_SET_MAX_COUNT + 1] = { false };
-	init_sets_not_evicting(ns, sets_not_evicting);
-
-	uint32_t n_cpus = cf_topo_count_cpus();
-	cf_tid tids[n_cpus];
-
-	prep_evict_per_thread_info per_threads[n_cpus];
-	uint32_t pid = 0;
-
-	for (uint32_t n = 0; n < n_cpus; n++) {
-		prep_evict_per_thread_info* per_thread = &per_threads[n];
-
-		per_thread->ns = ns;
-		per_thread->p_pid = &pid;
-		per_thread->i_cpu = n;
-		per_thread->sets_not_evicting = sets_not_evicting;
-		per_thread->evict_hist = linear_hist_create("per-thread-hist",
-				LINEAR_HIST_SECONDS, now, ttl_range, n_buckets);
-
-		tids[n] = cf_thread_create_joinable(run_prep_cold_start_evict,
-				(void*)per_thread);
-	}
-
-	for (uint32_t n = 0; n < n_cpus; n++) {
-		cf_thread_join(tids[n]);
-
-		if (n == 0) {
-			continue;
-		}
-
-		linear_hist_merge(per_threads[0].evict_hist, per_threads[n].evict_hist);
-		linear_hist_destroy(per_threads[n].evict_hist);
-	}
-
-	uint64_t n_evictable =
-			set_cold_start_threshold(ns, per_threads[0].evict_hist);
-
-	linear_hist_destroy(per_threads[0].evict_hist);
+	// The histogram was built as records loaded - no need for an index pass.
+	uint64_t n_evictable = set_cold_start_threshold(ns,
+			ns->cold_start_evict_hist);
 
 	if (n_evictable == 0) {
 		cf_warning(AS_NSUP, "{%s} hwm breached but nothing to evict", ns->name);
@@ -1142,6 +1838,12 @@ cold_start_evict(as_namespace* ns)
 	cf_info(AS_NSUP, "{%s} cold start found %lu records eligible for eviction at evict-ttl %u",
 			ns->name, n_evictable, ns->evict_void_time - now);
 
+	bool sets_not_evicting[AS_SET_MAX_COUNT + 1] = { false };
+	init_sets_not_evicting(ns, sets_not_evicting);
+
+	uint32_t n_cpus = cf_topo_count_cpus();
+	cf_tid tids[n_cpus];
+
 	evict_overall_info overall = {
 			.ns = ns,
 			.sets_not_evicting = sets_not_evicting
@@ -1163,25 +1865,6 @@ cold_start_evict(as_namespace* ns)
 	return true;
 }
 
-static void*
-run_prep_cold_start_evict(void* udata)
-{
-	prep_evict_per_thread_info* per_thread = (prep_evict_per_thread_info*)udata;
-
-	cf_topo_pin_to_cpu((cf_topo_cpu_index)per_thread->i_cpu);
-
-	uint32_t pid;
-
-	while ((pid = as_faa_uint32(per_thread->p_pid, 1)) < AS_PARTITIONS) {
-		// Don't bother with partition reservations - it's startup. Otherwise,
-		// use the same reduce callback as at runtime.
-		as_index_reduce_live(per_thread->ns->partitions[pid].tree,
-				prep_evict_reduce_cb, (void*)per_thread);
-	}
-
-	return NULL;
-}
-
 static uint64_t
 set_cold_start_threshold(as_namespace* ns, linear_hist* hist)
 {
@@ -1231,14 +1914,17 @@ run_cold_start_evict(void* udata)
 			.sets_not_evicting = overall->sets_not_evicting
 	};
 
-	uint32_t pid;
+	uint32_t item;
+
+	while ((item = as_faa_uint32(&overall->item, 1)) < AS_INDEX_N_REDUCE_ITEMS) {
+		uint32_t pid = item / AS_INDEX_N_REDUCE_SLICES;
 
-	while ((pid = as_faa_uint32(&overall->pid, 1)) < AS_PARTITIONS) {
 		// Don't bother with real partition reservations - it's startup.
 		as_partition_reservation rsv = { .tree = ns->partitions[pid].tree };
 		per_thread.rsv = &rsv;
 
-		as_index_reduce_live(rsv.tree, cold_start_evict_reduce_cb, &per_thread);
+		as_index_reduce_slice(rsv.tree, item % AS_INDEX_N_REDUCE_SLICES,
+				cold_start_evict_reduce_cb, &per_thread);
 	}
 
 	as_add_uint64(&overall->n_0_void_time, (int64_t)per_thread.n_0_void_time);
@@ -1267,6 +1953,7 @@ cold_start_evict_reduce_cb(as_index_ref* r_ref, void* udata)
 		// Note - can't be a tombstone.
 		as_set_index_delete(ns, tree, as_index_get_set_id(r), r_ref->r_h);
 		as_index_delete(tree, &r->keyd);
+		as_cold_start_evict_hist_update(ns, void_time, 0);
 		per_thread->n_evicted++;
 	}
 
@@ -224,6 +224,7 @@ static uint64_t load_int(const bits_op* op, const uint8_t* from, uint32_t n_byte
 static bool handle_signed_overflow(uint32_t n_bits, bool is_saturate, uint64_t load, uint64_t value, uint64_t* result);
 static void store_int(const bits_op* op, uint8_t* to, uint64_t value, uint32_t n_bytes);
 static void restore_ends(const bits_op* op, uint8_t* to, const uint8_t* from, uint32_t n_bytes);
+static uint64_t count_words(const uint8_t* buf, uint32_t n_words);
 
 
 //==========================================================
@@ -287,6 +288,13 @@ blob_bytes_type_to_particle_type(as_bytes_type type)
 	uint32_t l64 = 64 - r8; \
 	\
 	if (r8 == 0) { \
+		while (end - buf >= 8) { \
+			*(uint64_t*)to = *(uint64_t*)buf _bop *(uint64_t*)from; \
+			to += 8; \
+			buf += 8; \
+			from += 8; \
+		} \
+		\
 		while (buf < end) { \
 			*to++ = *buf++ _bop *from++; \
 		} \
@@ -762,6 +770,17 @@ blob_to_flat(const as_particle* p, uint8_t* flat)
 // as_bin particle functions specific to BLOB.
 //
 
+uint32_t
+as_bin_particle_blob_ptr(const as_bin* b, const uint8_t** p_value)
+{
+	// Caller must ensure this is called only for BLOB particles.
+	const blob_mem* p_blob_mem = (const blob_mem*)b->particle;
+
+	*p_value = p_blob_mem->data;
+
+	return p_blob_mem->sz;
+}
+
 int
 as_bin_bits_modify_tr(as_bin* b, const as_msg_op* msg_op,
 		cf_ll_buf* particles_llb)
@@ -1889,6 +1908,12 @@ bits_modify_op_not(const bits_op* op, uint8_t* to, const uint8_t* from,
 	const uint8_t* cur = &from[0];
 	const uint8_t* end = &from[n_bytes];
 
+	while (end - cur >= 8) {
+		*(uint64_t*)to = ~*(const uint64_t*)cur;
+		to += 8;
+		cur += 8;
+	}
+
 	while (cur < end) {
 		*to++ = (uint8_t)~*cur++;
 	}
@@ -2065,16 +2090,10 @@ bits_read_op_count(const bits_op* op, const uint8_t* from, as_bin* rb,
 	else {
 		answer = cf_bit_count64((uint64_t)(*cur++ & ~head_m));
 
-		while (cur < end && (cur - from < 8 || (uint64_t)cur % 8 != 0)) {
-			answer += cf_bit_count64(*cur++);
-		}
+		uint32_t n_words = (uint32_t)(end - cur) / 8;
 
-		while (end - cur >= 64) {
-			for (uint32_t i = 0; i < 8; i++) {
-				answer += cf_bit_count64(*(uint64_t*)cur);
-				cur += 8;
-			}
-		}
+		answer += count_words(cur, n_words);
+		cur += n_words * 8;
 
 		while (cur < end) {
 			answer += cf_bit_count64((uint64_t)*cur++);
@@ -2100,8 +2119,14 @@ bits_read_op_lscan(const bits_op* op, const uint8_t* from, as_bin* rb,
 	uint8_t skip = (uint8_t)(op->value == 1 ? 0x00 : 0xFF);
 
 	if (last == 0 && n_bytes != 1) {
+		uint64_t skip64 = op->value == 1 ? 0 : 0xFFFFffffFFFFffff;
+
 		cur++;
 
+		while (end - cur >= 8 && *(const uint64_t*)cur == skip64) {
+			cur += 8;
+		}
+
 		while (*cur == skip && cur < end) {
 			cur++;
 		}
@@ -2112,12 +2137,7 @@ bits_read_op_lscan(const bits_op* op, const uint8_t* from, as_bin* rb,
 	int64_t answer;
 
 	if (last != 0) {
-		uint32_t bit_ix = 0;
-		uint8_t m = (uint8_t)0x80;
-
-		while ((last & (m >> bit_ix)) == 0) {
-			bit_ix++;
-		}
+		uint32_t bit_ix = cf_msb64((uint64_t)last) - 56;
 
 		answer = ((cur - from) * 8 + bit_ix) - op->offset;
 
@@ -2146,8 +2166,14 @@ bits_read_op_rscan(const bits_op* op, const uint8_t* from, as_bin* rb,
 	uint8_t skip = (uint8_t)(op->value == 1 ? 0x00 : 0xFF);
 
 	if (last == 0 && n_bytes != 1) {
+		uint64_t skip64 = op->value == 1 ? 0 : 0xFFFFffffFFFFffff;
+
 		cur--;
 
+		while (cur - from >= 8 && *(const uint64_t*)(cur - 7) == skip64) {
+			cur -= 8;
+		}
+
 		while (*cur == skip && cur > from) {
 			cur--;
 		}
@@ -2158,12 +2184,7 @@ bits_read_op_rscan(const bits_op* op, const uint8_t* from, as_bin* rb,
 	int64_t answer;
 
 	if (last != 0) {
-		uint32_t bit_ix = 7;
-		uint8_t m = (uint8_t)0x80;
-
-		while ((last & (m >> bit_ix)) == 0) {
-			bit_ix--;
-		}
+		uint32_t bit_ix = 7 - cf_lsb64((uint64_t)last);
 
 		answer = ((cur - from) * 8 + bit_ix) - op->offset;
 
@@ -2469,3 +2490,41 @@ restore_ends(const bits_op* op, uint8_t* to, const uint8_t* from,
 		*to = (uint8_t)((*to & ~from_tail_m) | (from_tail & from_tail_m));
 	}
 }
+
+#if defined(__x86_64__)
+
+// Built for popcnt regardless of -march - only called if the CPU has it.
+__attribute__((target("popcnt")))
+static uint64_t
+count_words_hw(const uint8_t* buf, uint32_t n_words)
+{
+	uint64_t n_bits = 0;
+
+	for (uint32_t i = 0; i < n_words; i++) {
+		n_bits += (uint64_t)__builtin_popcountll(*(const uint64_t*)buf);
+		buf += 8;
+	}
+
+	return n_bits;
+}
+
+#endif
+
+static uint64_t
+count_words(const uint8_t* buf, uint32_t n_words)
+{
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("popcnt")) {
+		return count_words_hw(buf, n_words);
+	}
+#endif
+
+	uint64_t n_bits = 0;
+
+	for (uint32_t i = 0; i < n_words; i++) {
+		n_bits += cf_bit_count64(*(const uint64_t*)buf);
+		buf += 8;
+	}
+
+	return n_bits;
+}
@@ -383,6 +383,20 @@ as_bin_particle_geojson_cellids(const as_bin *b, uint64_t **ppcells)
 	return (size_t)gp->ncells;
 }
 
+// Returns 0 if the particle is a region.
+uint64_t
+as_particle_geojson_point_cellid(const as_particle *particle)
+{
+	const geojson_mem *p_geojson_mem = (const geojson_mem *)particle;
+
+	if ((p_geojson_mem->flags & GEOJSON_ISREGION) != 0 ||
+			p_geojson_mem->ncells == 0) {
+		return 0;
+	}
+
+	return ((const uint64_t *)p_geojson_mem->data)[0];
+}
+
 bool
 as_particle_geojson_match(as_particle *particle, uint64_t query_cellid,
 		geo_region_t query_region, bool is_strict)
@@ -30,6 +30,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "aerospike/as_bytes.h"
 #include "aerospike/as_val.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_byte_order.h"
@@ -45,6 +46,7 @@
 #include "base/particle.h"
 #include "base/particle_blob.h"
 #include "base/proto.h"
+#include "fabric/exchange.h"
 
 //#include "warnings.h" // generates warnings we're living with for now
 
@@ -62,6 +64,11 @@ static int hll_append_from_wire(as_particle_type wire_type, const uint8_t *wire_
 static int hll_prepend_from_wire(as_particle_type wire_type, const uint8_t *wire_value, uint32_t value_size, as_particle **pp);
 static int hll_incr_from_wire(as_particle_type wire_type, const uint8_t *wire_value, uint32_t value_size, as_particle **pp);
 static int hll_from_wire(as_particle_type wire_type, const uint8_t* wire_value, uint32_t value_size, as_particle** pp);
+static uint32_t hll_wire_size(const as_particle* p);
+static uint32_t hll_to_wire(const as_particle* p, uint8_t* wire);
+
+// Handle as_val translation.
+static as_val* hll_to_asval(const as_particle* p);
 
 //==========================================================
 // HLL particle interface - vtable.
@@ -78,12 +85,12 @@ const as_particle_vtable hll_vtable = {
 		blob_size_from_wire,
 		hll_from_wire,
 		blob_compare_from_wire,
-		blob_wire_size,
-		blob_to_wire,
+		hll_wire_size,
+		hll_to_wire,
 
 		blob_size_from_asval,
 		blob_from_asval,
-		blob_to_asval,
+		hll_to_asval,
 		blob_asval_wire_size,
 		blob_asval_to_wire,
 
@@ -125,9 +132,25 @@ typedef struct hll_s {
 #define MAX_MINHASH_BITS (64 - HLL_BITS - 7)
 #define MAX_INDEX_AND_MINHASH_BITS 64
 
+// Plain HLL registers pack 4 to every 3 bytes - handled a group at a time.
+#define HLL_GROUP_N_REGISTERS 4
+#define HLL_GROUP_SZ 3
+
+// Low-cardinality plain HLLs may be stored sparse - a big-endian entry count
+// followed by 3-byte (register << 6 | value) entries sorted by register. Only
+// particles are ever sparse - the wire format is always dense.
+#define HLL_FLAG_SPARSE 0x01
+#define SPARSE_COUNT_SZ 2
+#define SPARSE_ENTRY_SZ 3
+
+// Nodes that don't understand sparse particles may still receive them via
+// replication or migration - wait until the whole cluster can read them.
+#define SPARSE_MIN_COMPATIBILITY_ID 12
+
 typedef struct element_buf_s {
 	uint32_t sz;
 	const uint8_t* buf;
+	uint8_t* dense; // buf is this copy, if the element came in sparse
 } element_buf;
 
 typedef struct hll_op_s {
@@ -199,8 +222,9 @@ static int32_t hll_modify_prepare_fold_op(hll_op* op, const as_particle* old_p);
 static int32_t hll_read_prepare_noop(hll_op* op, const as_particle* old_p);
 static int32_t hll_read_prepare_intersect(hll_op* op, const as_particle* old_p);
 
-static void hll_modify_execute_op(const hll_state* state, const hll_op* op, const as_particle* old_p, as_particle* new_p, uint32_t new_size, as_bin* rb);
-static void hll_read_execute_op(const hll_state* state, const hll_op* op, const as_particle* p, as_bin* rb);
+static hll_t* hll_alloc_particle(as_bin* b, uint32_t sz, cf_ll_buf* particles_llb, bool alloc_ns);
+static void hll_modify_execute_op(const hll_state* state, const hll_op* op, const hll_t* old_hll, hll_t* new_hll, uint32_t new_size, as_bin* rb);
+static void hll_read_execute_op(const hll_state* state, const hll_op* op, const hll_t* hll, as_bin* rb);
 
 static void hll_modify_op_init(const hll_op* op, hll_t* to, const hll_t* from, as_bin* rb);
 static void hll_modify_op_add(const hll_op* op, hll_t* to, const hll_t* from, as_bin* rb);
@@ -220,6 +244,7 @@ static bool validate_n_combined_bits(uint64_t n_index_bits, uint64_t n_minhash_b
 static bool validate_n_index_bits(uint64_t n_index_bits);
 static bool validate_n_minhash_bits(uint64_t n_minhash_bits);
 
+static bool verify_hll(const hll_t* hll, uint32_t sz);
 static bool verify_hll_sz(const hll_t* hmh, uint32_t expected_sz);
 static uint32_t hmh_required_sz(uint8_t n_index_bits, uint8_t n_minhash_bits);
 static void hmh_init(hll_t* hmh, uint8_t n_index_bits, uint8_t n_minhash_bits);
@@ -238,6 +263,8 @@ static void hmh_hash(const hll_t* hmh, const uint8_t* element, size_t value_sz,
 static uint64_t get_register(const hll_t* hmh, uint32_t r);
 static void set_register(hll_t* hmh, uint32_t r, uint64_t value);
 static uint8_t unpack_register_hll_val(const hll_t* hmh, uint64_t value);
+static void unpack_hll_group(const uint8_t* group, uint8_t* vals);
+static void pack_hll_group(uint8_t* group, const uint8_t* vals);
 static double hmh_tau(double val);
 static double hmh_sigma(double val);
 static double hmh_alpha(const hll_t* hmh);
@@ -249,6 +276,18 @@ static uint32_t hmh_n_used_registers(const hll_t* hmh);
 static double hmh_jaccard_estimate_collisions(const hll_t* template, uint64_t card0, uint64_t card1);
 static double hll_estimate_similarity(uint32_t n_hmhs, const hll_t** hmhs);
 
+static bool hll_is_sparse(const hll_t* hll);
+static bool hll_sparse_allowed(uint8_t n_minhash_bits);
+static bool verify_sparse(const hll_t* hll, uint32_t sz);
+static uint32_t sparse_n_entries(const hll_t* hll);
+static uint32_t sparse_sz(uint32_t n_entries);
+static const hll_t* hll_dense_view(const hll_t* hll, hll_t** dense_r);
+static void sparse_to_dense(const hll_t* sparse, hll_t* dense);
+static uint32_t dense_sparse_sz(const hll_t* dense);
+static void dense_to_sparse(const hll_t* dense, hll_t* sparse);
+static void unpack_sparse_entry(const uint8_t* entry, uint32_t* r, uint8_t* val);
+static void pack_sparse_entry(uint8_t* entry, uint32_t r, uint8_t val);
+
 
 //==========================================================
 // Inlines & macros.
@@ -418,6 +457,47 @@ hll_from_wire(as_particle_type wire_type, const uint8_t* wire_value,
 	return AS_OK;
 }
 
+static uint32_t
+hll_wire_size(const as_particle* p)
+{
+	const hll_mem* p_hll_mem = (const hll_mem*)p;
+	const hll_t* hll = (const hll_t*)p_hll_mem->data;
+
+	return hll_is_sparse(hll) ?
+			hmh_required_sz(hll->n_index_bits, 0) : p_hll_mem->sz;
+}
+
+static uint32_t
+hll_to_wire(const as_particle* p, uint8_t* wire)
+{
+	const hll_mem* p_hll_mem = (const hll_mem*)p;
+	const hll_t* hll = (const hll_t*)p_hll_mem->data;
+
+	if (hll_is_sparse(hll)) {
+		sparse_to_dense(hll, (hll_t*)wire);
+		return hmh_required_sz(hll->n_index_bits, 0);
+	}
+
+	memcpy(wire, p_hll_mem->data, p_hll_mem->sz);
+
+	return p_hll_mem->sz;
+}
+
+//------------------------------------------------
+// Handle as_val translation.
+//
+
+static as_val*
+hll_to_asval(const as_particle* p)
+{
+	uint32_t sz = hll_wire_size(p);
+	uint8_t* value = cf_malloc(sz);
+
+	hll_to_wire(p, value);
+
+	return (as_val*)as_bytes_new_wrap(value, sz, true);
+}
+
 
 //==========================================================
 // as_bin particle functions specific to HLL.
@@ -505,6 +585,12 @@ void
 hll_op_destroy(hll_op* op)
 {
 	if (op->elements != NULL) {
+		for (uint32_t i = 0; i < op->n_elements; i++) {
+			if (op->elements[i].dense != NULL) {
+				cf_free(op->elements[i].dense);
+			}
+		}
+
 		cf_free(op->elements);
 	}
 }
@@ -632,18 +718,40 @@ hll_modify(hll_state* state, as_bin* b, cf_ll_buf* particles_llb, as_bin* rb,
 		return prepare_result;
 	}
 
+	hll_t* old_dense = NULL;
+	const hll_t* old_hll = old_p == NULL ? NULL :
+			hll_dense_view((const hll_t*)((hll_mem*)old_p)->data, &old_dense);
 	uint32_t new_size = hmh_required_sz(op.n_index_bits, op.n_minhash_bits);
-	size_t alloc_size = sizeof(hll_mem) + new_size;
 
-	if (particles_llb == NULL) {
-		b->particle = alloc_ns ?
-				cf_malloc_ns(alloc_size) : cf_malloc(alloc_size);
+	if (hll_sparse_allowed(op.n_minhash_bits)) {
+		// Build the result dense, then store it sparse if it's small enough.
+		hll_t* dense = cf_malloc(new_size);
+
+		hll_modify_execute_op(state, &op, old_hll, dense, new_size, rb);
+
+		uint32_t sparse_size = dense_sparse_sz(dense);
+
+		if (sparse_size != 0) {
+			dense_to_sparse(dense, hll_alloc_particle(b, sparse_size,
+					particles_llb, alloc_ns));
+		}
+		else {
+			memcpy(hll_alloc_particle(b, new_size, particles_llb, alloc_ns),
+					dense, new_size);
+		}
+
+		cf_free(dense);
 	}
 	else {
-		cf_ll_buf_reserve(particles_llb, alloc_size, (uint8_t**)&b->particle);
+		hll_modify_execute_op(state, &op, old_hll,
+				hll_alloc_particle(b, new_size, particles_llb, alloc_ns),
+				new_size, rb);
+	}
+
+	if (old_dense != NULL) {
+		cf_free(old_dense);
 	}
 
-	hll_modify_execute_op(state, &op, old_p, b->particle, new_size, rb);
 	hll_op_destroy(&op);
 
 	if (old_p == NULL) {
@@ -679,7 +787,21 @@ hll_read(hll_state* state, const as_bin* b, as_bin* rb, bool alloc_ns)
 		return prepare_result;
 	}
 
-	hll_read_execute_op(state, &op, b->particle, rb);
+	const hll_t* hll = (const hll_t*)((const hll_mem*)b->particle)->data;
+	hll_t* dense = NULL;
+
+	// Count and describe work directly on sparse HLLs.
+	if (state->op_type != AS_HLL_OP_COUNT &&
+			state->op_type != AS_HLL_OP_DESCRIBE) {
+		hll = hll_dense_view(hll, &dense);
+	}
+
+	hll_read_execute_op(state, &op, hll, rb);
+
+	if (dense != NULL) {
+		cf_free(dense);
+	}
+
 	hll_op_destroy(&op);
 
 	return AS_OK;
@@ -702,8 +824,7 @@ hll_verify_bin(const as_bin* b)
 		return -AS_ERR_INCOMPATIBLE_TYPE;
 	}
 
-	if (! (hll->flags == 0 && validate_n_combined_bits(hll->n_index_bits,
-			hll->n_minhash_bits) && verify_hll_sz(hll, bmem->sz))) {
+	if (! verify_hll(hll, bmem->sz)) {
 		cf_warning(AS_PARTICLE, "hll_verify_bin - error %u found invalid hll flags %x n_index_bits %u n_minhash_bits %u sz %u",
 				AS_ERR_UNKNOWN, hll->flags, hll->n_index_bits,
 				hll->n_minhash_bits, bmem->sz);
@@ -833,7 +954,7 @@ hll_parse_elements(hll_state* state, hll_op* op)
 		return false;
 	}
 
-	op->elements = cf_malloc(sizeof(element_buf) * op->n_elements);
+	op->elements = cf_calloc(op->n_elements, sizeof(element_buf));
 
 	for (uint32_t i = 0; i < op->n_elements; i++) {
 		element_buf* e = &op->elements[i]; // TODO - make array of 2 vectors for vectorized input
@@ -885,7 +1006,7 @@ hll_parse_hlls(hll_state* state, hll_op* op)
 		op->n_elements = 1; // if no list then expect one HLL
 	}
 
-	op->elements = cf_malloc(sizeof(element_buf) * op->n_elements);
+	op->elements = cf_calloc(op->n_elements, sizeof(element_buf));
 
 	for (uint32_t i = 0; i < op->n_elements; i++) {
 		element_buf* e = &op->elements[i];
@@ -905,6 +1026,21 @@ hll_parse_hlls(hll_state* state, hll_op* op)
 
 		hll_t* hll = (hll_t*)e->buf;
 
+		// Expressions may pass along a sparse HLL read from a bin.
+		if (hll->flags == HLL_FLAG_SPARSE) {
+			if (! verify_sparse(hll, e->sz)) {
+				cf_warning(AS_PARTICLE, "hll_parse_hlls - error %u op %s (%u) hll (%u) is a bad sparse hll",
+						AS_ERR_PARAMETER, state->def->name, state->op_type, i);
+				return false;
+			}
+
+			e->sz = hmh_required_sz(hll->n_index_bits, 0);
+			e->dense = cf_malloc(e->sz);
+			sparse_to_dense(hll, (hll_t*)e->dense);
+			e->buf = e->dense;
+			hll = (hll_t*)e->buf;
+		}
+
 		if (hll->flags != 0) {
 			cf_warning(AS_PARTICLE, "hll_parse_hlls - error %u op %s (%u) hll (%u) contains unknown flags (%x)",
 					AS_ERR_PARAMETER, state->def->name, state->op_type, i,
@@ -1184,18 +1320,33 @@ hll_read_prepare_intersect(hll_op* op, const as_particle* old_p)
 // Local helpers - execute ops.
 //
 
-static void
-hll_modify_execute_op(const hll_state* state, const hll_op* op,
-		const as_particle* old_p, as_particle* new_p, uint32_t new_size,
-		as_bin* rb)
+static hll_t*
+hll_alloc_particle(as_bin* b, uint32_t sz, cf_ll_buf* particles_llb,
+		bool alloc_ns)
 {
-	hll_t* new_hll = (hll_t*)((hll_mem*)new_p)->data;
+	size_t alloc_size = sizeof(hll_mem) + sz;
 
-	state->def->fn.modify(op, new_hll,
-			old_p == NULL ? NULL : (hll_t*)((hll_mem*)old_p)->data, rb);
+	if (particles_llb == NULL) {
+		b->particle = alloc_ns ?
+				cf_malloc_ns(alloc_size) : cf_malloc(alloc_size);
+	}
+	else {
+		cf_ll_buf_reserve(particles_llb, alloc_size, (uint8_t**)&b->particle);
+	}
+
+	hll_mem* p_hll_mem = (hll_mem*)b->particle;
+
+	p_hll_mem->sz = sz;
+	p_hll_mem->type = AS_PARTICLE_TYPE_HLL;
+
+	return (hll_t*)p_hll_mem->data;
+}
 
-	((hll_mem*)new_p)->sz = new_size;
-	((hll_mem*)new_p)->type = AS_PARTICLE_TYPE_HLL;
+static void
+hll_modify_execute_op(const hll_state* state, const hll_op* op,
+		const hll_t* old_hll, hll_t* new_hll, uint32_t new_size, as_bin* rb)
+{
+	state->def->fn.modify(op, new_hll, old_hll, rb);
 
 	cf_assert(verify_hll_sz(new_hll, new_size), AS_PARTICLE, "result corrupt - op-type %u desc (%u,%u) expected-desc (%u,%u) sz %u expected-sz %u",
 			state->op_type,
@@ -1207,9 +1358,9 @@ hll_modify_execute_op(const hll_state* state, const hll_op* op,
 
 static void
 hll_read_execute_op(const hll_state* state, const hll_op* op,
-		const as_particle* p, as_bin* rb)
+		const hll_t* hll, as_bin* rb)
 {
-	state->def->fn.read(op, (const hll_t*)((const hll_mem*)p)->data, rb);
+	state->def->fn.read(op, hll, rb);
 }
 
 
@@ -1475,6 +1626,17 @@ validate_n_minhash_bits(uint64_t n_minhash_bits)
 // Local helpers - hmh lib.
 //
 
+static bool
+verify_hll(const hll_t* hll, uint32_t sz)
+{
+	if (hll_is_sparse(hll)) {
+		return verify_sparse(hll, sz);
+	}
+
+	return hll->flags == 0 && validate_n_combined_bits(hll->n_index_bits,
+			hll->n_minhash_bits) && verify_hll_sz(hll, sz);
+}
+
 static bool
 verify_hll_sz(const hll_t* hmh, uint32_t expected_sz)
 {
@@ -1554,8 +1716,39 @@ hmh_estimate_cardinality(const hll_t* hmh)
 	uint32_t n_registers = (uint32_t)1 << hmh->n_index_bits;
 	uint32_t c[HLL_MAX_VALUE + 1] = {0}; // q_bits + 1
 
-	for (uint32_t r = 0; r < n_registers; r++) {
-		c[unpack_register_hll_val(hmh, get_register(hmh, r))]++;
+	if (hll_is_sparse(hmh)) {
+		uint32_t n_entries = sparse_n_entries(hmh);
+		const uint8_t* entry = hmh->registers + SPARSE_COUNT_SZ;
+
+		c[0] = n_registers - n_entries;
+
+		for (uint32_t i = 0; i < n_entries; i++) {
+			uint32_t r;
+			uint8_t val;
+
+			unpack_sparse_entry(entry, &r, &val);
+			c[val]++;
+			entry += SPARSE_ENTRY_SZ;
+		}
+	}
+	else if (hmh->n_minhash_bits == 0) {
+		uint32_t n_groups = n_registers / HLL_GROUP_N_REGISTERS;
+
+		for (uint32_t g = 0; g < n_groups; g++) {
+			uint8_t vals[HLL_GROUP_N_REGISTERS];
+
+			unpack_hll_group(hmh->registers + g * HLL_GROUP_SZ, vals);
+
+			c[vals[0]]++;
+			c[vals[1]]++;
+			c[vals[2]]++;
+			c[vals[3]]++;
+		}
+	}
+	else {
+		for (uint32_t r = 0; r < n_registers; r++) {
+			c[unpack_register_hll_val(hmh, get_register(hmh, r))]++;
+		}
 	}
 
 	// TODO - evaluate if allowing q_bits to be 64 was a good choice.
@@ -1841,6 +2034,24 @@ unpack_register_hll_val(const hll_t* hmh, uint64_t value)
 	return (uint8_t)(value >> hmh->n_minhash_bits);
 }
 
+// Register r is bits [6r, 6r + 6), most significant bit first.
+static void
+unpack_hll_group(const uint8_t* group, uint8_t* vals)
+{
+	vals[0] = group[0] >> 2;
+	vals[1] = (uint8_t)(((group[0] & 0x03) << 4) | (group[1] >> 4));
+	vals[2] = (uint8_t)(((group[1] & 0x0f) << 2) | (group[2] >> 6));
+	vals[3] = group[2] & 0x3f;
+}
+
+static void
+pack_hll_group(uint8_t* group, const uint8_t* vals)
+{
+	group[0] = (uint8_t)((vals[0] << 2) | (vals[1] >> 4));
+	group[1] = (uint8_t)((vals[1] << 4) | (vals[2] >> 2));
+	group[2] = (uint8_t)((vals[2] << 6) | vals[3]);
+}
+
 static double
 hmh_tau(double val)
 {
@@ -1907,6 +2118,29 @@ hll_union(hll_t* hllunion, const hll_t* hmh)
 	uint32_t max_registers = (uint32_t)1 << hmh->n_index_bits;
 	uint32_t register_mask = n_registers - 1;
 
+	if (hmh->n_minhash_bits == 0) {
+		// Register counts are multiples of 4, so folding keeps groups whole.
+		uint32_t max_groups = max_registers / HLL_GROUP_N_REGISTERS;
+		uint32_t group_mask = n_registers / HLL_GROUP_N_REGISTERS - 1;
+
+		for (uint32_t g = 0; g < max_groups; g++) {
+			uint8_t* to = hllunion->registers + (g & group_mask) * HLL_GROUP_SZ;
+			uint8_t v0[HLL_GROUP_N_REGISTERS];
+			uint8_t v1[HLL_GROUP_N_REGISTERS];
+
+			unpack_hll_group(to, v0);
+			unpack_hll_group(hmh->registers + g * HLL_GROUP_SZ, v1);
+
+			for (uint32_t i = 0; i < HLL_GROUP_N_REGISTERS; i++) {
+				v0[i] = v0[i] < v1[i] ? v1[i] : v0[i];
+			}
+
+			pack_hll_group(to, v0);
+		}
+
+		return;
+	}
+
 	for (uint32_t r = 0; r < max_registers; r++ ) {
 		uint32_t union_r = r & register_mask;
 		uint8_t v0 = unpack_register_hll_val(hllunion, get_register(hllunion,
@@ -2040,3 +2274,188 @@ hll_estimate_similarity(uint32_t n_hmhs, const hll_t** hmhs)
 
 	return (double)intersect_est / (double)union_est;
 }
+
+
+//==========================================================
+// Local helpers - sparse hll.
+//
+
+static bool
+hll_is_sparse(const hll_t* hll)
+{
+	return hll->flags == HLL_FLAG_SPARSE;
+}
+
+static bool
+hll_sparse_allowed(uint8_t n_minhash_bits)
+{
+	return n_minhash_bits == 0 &&
+			as_exchange_min_compatibility_id() >= SPARSE_MIN_COMPATIBILITY_ID;
+}
+
+static bool
+verify_sparse(const hll_t* hll, uint32_t sz)
+{
+	if (hll->n_minhash_bits != 0 ||
+			! validate_n_index_bits(hll->n_index_bits) ||
+			sz < sparse_sz(0) || sz != sparse_sz(sparse_n_entries(hll))) {
+		cf_warning(AS_PARTICLE, "verify_sparse - bad sparse hll particle - description (%u,%u) sz %u",
+				hll->n_index_bits, hll->n_minhash_bits, sz);
+		return false;
+	}
+
+	uint32_t n_registers = (uint32_t)1 << hll->n_index_bits;
+	uint32_t n_entries = sparse_n_entries(hll);
+	const uint8_t* entry = hll->registers + SPARSE_COUNT_SZ;
+	uint32_t next_r = 0;
+
+	for (uint32_t i = 0; i < n_entries; i++) {
+		uint32_t r;
+		uint8_t val;
+
+		unpack_sparse_entry(entry, &r, &val);
+
+		if (r < next_r || r >= n_registers || val == 0) {
+			cf_warning(AS_PARTICLE, "verify_sparse - bad sparse hll particle - entry %u register %u value %u",
+					i, r, val);
+			return false;
+		}
+
+		next_r = r + 1;
+		entry += SPARSE_ENTRY_SZ;
+	}
+
+	return true;
+}
+
+static uint32_t
+sparse_n_entries(const hll_t* hll)
+{
+	return ((uint32_t)hll->registers[0] << 8) | hll->registers[1];
+}
+
+static uint32_t
+sparse_sz(uint32_t n_entries)
+{
+	return (uint32_t)sizeof(hll_t) + SPARSE_COUNT_SZ +
+			(n_entries * SPARSE_ENTRY_SZ);
+}
+
+// Returns hll itself if dense, else a dense copy the caller must free.
+static const hll_t*
+hll_dense_view(const hll_t* hll, hll_t** dense_r)
+{
+	if (! hll_is_sparse(hll)) {
+		*dense_r = NULL;
+		return hll;
+	}
+
+	hll_t* dense = cf_malloc(hmh_required_sz(hll->n_index_bits, 0));
+
+	sparse_to_dense(hll, dense);
+	*dense_r = dense;
+
+	return dense;
+}
+
+static void
+sparse_to_dense(const hll_t* sparse, hll_t* dense)
+{
+	uint32_t n_entries = sparse_n_entries(sparse);
+	const uint8_t* entry = sparse->registers + SPARSE_COUNT_SZ;
+
+	hmh_init(dense, sparse->n_index_bits, 0);
+	dense->cache = sparse->cache;
+
+	for (uint32_t i = 0; i < n_entries; i++) {
+		uint32_t r;
+		uint8_t val;
+
+		unpack_sparse_entry(entry, &r, &val);
+		set_register(dense, r, val);
+		entry += SPARSE_ENTRY_SZ;
+	}
+}
+
+// Returns 0 if dense should stay dense. Sparse is kept to at most half the
+// dense size - past that, dense ops are cheaper and the savings are small.
+static uint32_t
+dense_sparse_sz(const hll_t* dense)
+{
+	if (dense->n_minhash_bits != 0) {
+		return 0;
+	}
+
+	uint32_t max_entries = registers_sz(dense->n_index_bits, 0) / 2 /
+			SPARSE_ENTRY_SZ;
+	uint32_t n_groups = ((uint32_t)1 << dense->n_index_bits) /
+			HLL_GROUP_N_REGISTERS;
+	uint32_t n_entries = 0;
+
+	for (uint32_t g = 0; g < n_groups; g++) {
+		uint8_t vals[HLL_GROUP_N_REGISTERS];
+
+		unpack_hll_group(dense->registers + g * HLL_GROUP_SZ, vals);
+
+		n_entries += (uint32_t)(vals[0] != 0) + (vals[1] != 0) +
+				(vals[2] != 0) + (vals[3] != 0);
+
+		if (n_entries > max_entries) {
+			return 0;
+		}
+	}
+
+	return sparse_sz(n_entries);
+}
+
+static void
+dense_to_sparse(const hll_t* dense, hll_t* sparse)
+{
+	uint32_t n_groups = ((uint32_t)1 << dense->n_index_bits) /
+			HLL_GROUP_N_REGISTERS;
+	uint8_t* entry = sparse->registers + SPARSE_COUNT_SZ;
+	uint32_t n_entries = 0;
+
+	sparse->flags = HLL_FLAG_SPARSE;
+	sparse->n_index_bits = dense->n_index_bits;
+	sparse->n_minhash_bits = 0;
+	sparse->cache = dense->cache;
+
+	for (uint32_t g = 0; g < n_groups; g++) {
+		uint8_t vals[HLL_GROUP_N_REGISTERS];
+
+		unpack_hll_group(dense->registers + g * HLL_GROUP_SZ, vals);
+
+		for (uint32_t i = 0; i < HLL_GROUP_N_REGISTERS; i++) {
+			if (vals[i] != 0) {
+				pack_sparse_entry(entry, g * HLL_GROUP_N_REGISTERS + i,
+						vals[i]);
+				entry += SPARSE_ENTRY_SZ;
+				n_entries++;
+			}
+		}
+	}
+
+	sparse->registers[0] = (uint8_t)(n_entries >> 8);
+	sparse->registers[1] = (uint8_t)n_entries;
+}
+
+static void
+unpack_sparse_entry(const uint8_t* entry, uint32_t* r, uint8_t* val)
+{
+	uint32_t packed = ((uint32_t)entry[0] << 16) |
+			((uint32_t)entry[1] << 8) | entry[2];
+
+	*r = packed >> HLL_BITS;
+	*val = (uint8_t)(packed & (HLL_MAX_VALUE - 1));
+}
+
+static void
+pack_sparse_entry(uint8_t* entry, uint32_t r, uint8_t val)
+{
+	uint32_t packed = (r << HLL_BITS) | val;
+
+	entry[0] = (uint8_t)(packed >> 16);
+	entry[1] = (uint8_t)(packed >> 8);
+	entry[2] = (uint8_t)packed;
+}
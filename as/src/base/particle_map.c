@@ -32,6 +32,7 @@
 #include "aerospike/as_val.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_byte_order.h"
+#include "citrusleaf/cf_hash_math.h"
 
 #include "bits.h"
 #include "log.h"
@@ -125,6 +126,12 @@ const as_particle_vtable map_vtable = {
 
 #define LINEAR_FIND_RANK_MAX_COUNT		16 // switch to linear search when the count drops to this number
 
+// Per-thread cache of value order indexes built for maps that don't persist
+// one, so repeated rank/value ops on a large unchanged map skip the sort.
+#define ORDIDX_CACHE_MIN_COUNT			1000
+#define ORDIDX_CACHE_MAX_SZ				(128 * 1024)
+#define ORDIDX_CACHE_N_WAYS				2
+
 #define AS_PACKED_MAP_FLAG_RESERVED_0	0x04 // placeholder for multimap
 #define AS_PACKED_MAP_FLAG_OFF_IDX		0x10 // has list offset index
 #define AS_PACKED_MAP_FLAG_ORD_IDX		0x20 // has value order index
@@ -134,6 +141,13 @@ const as_particle_vtable map_vtable = {
 
 struct packed_map_s;
 
+typedef struct ordidx_cache_ele_s {
+	uint64_t hash; // of map contents
+	uint32_t content_sz;
+	uint32_t sz;
+	uint8_t *ptr;
+} ordidx_cache_ele;
+
 typedef void (*packed_map_get_by_idx_func)(const struct packed_map_s *userdata, cdt_payload *contents, uint32_t index);
 
 typedef struct packed_map_s {
@@ -304,6 +318,14 @@ typedef struct {
 		map_packer_init(&__name, __ele_count, __flags, __content_sz)
 
 
+//==========================================================
+// Globals.
+//
+
+static __thread ordidx_cache_ele g_ordidx_cache[ORDIDX_CACHE_N_WAYS];
+static __thread uint32_t g_ordidx_cache_next = 0;
+
+
 //==========================================================
 // Forward declarations.
 //
@@ -380,6 +402,8 @@ static bool packed_map_unpack_hdridx(packed_map *map, bool fill_idxs);
 static void packed_map_init_indexes(const packed_map *map, as_packer *pk, offset_index *offidx, order_index *ordidx);
 
 static void packed_map_ensure_ordidx_filled(const packed_map *map);
+static bool ordidx_cache_get(const packed_map *map, uint64_t hash, order_index *ordidx);
+static void ordidx_cache_put(const packed_map *map, uint64_t hash, const order_index *ordidx);
 static bool packed_map_check_and_fill_offidx(const packed_map *map);
 
 static uint32_t packed_map_find_index_by_idx_unordered(const packed_map *map, uint32_t idx);
@@ -2969,10 +2993,66 @@ packed_map_ensure_ordidx_filled(const packed_map *map)
 	cf_assert(offset_index_is_full(&map->offidx), AS_PARTICLE, "offidx not full");
 	order_index *ordidx = (order_index *)&map->ordidx;
 
-	if (! order_index_is_filled(ordidx)) {
+	if (order_index_is_filled(ordidx)) {
+		return;
+	}
+
+	uint32_t sz = order_index_size(ordidx);
+
+	if (map->ele_count < ORDIDX_CACHE_MIN_COUNT || sz > ORDIDX_CACHE_MAX_SZ) {
 		order_index_set_sorted(ordidx, &map->offidx, map->contents,
 				map->content_sz, SORT_BY_VALUE);
+		return;
+	}
+
+	// Hashing the contents is much cheaper than sorting them by value.
+	uint64_t hash = cf_wyhash64(map->contents, map->content_sz);
+
+	if (ordidx_cache_get(map, hash, ordidx)) {
+		return;
+	}
+
+	order_index_set_sorted(ordidx, &map->offidx, map->contents,
+			map->content_sz, SORT_BY_VALUE);
+	ordidx_cache_put(map, hash, ordidx);
+}
+
+static bool
+ordidx_cache_get(const packed_map *map, uint64_t hash, order_index *ordidx)
+{
+	uint32_t sz = order_index_size(ordidx);
+
+	for (uint32_t i = 0; i < ORDIDX_CACHE_N_WAYS; i++) {
+		ordidx_cache_ele *ele = &g_ordidx_cache[i];
+
+		if (ele->ptr != NULL && ele->hash == hash &&
+				ele->content_sz == map->content_sz && ele->sz == sz) {
+			memcpy(ordidx->_.ptr, ele->ptr, sz);
+			return true;
+		}
 	}
+
+	return false;
+}
+
+static void
+ordidx_cache_put(const packed_map *map, uint64_t hash,
+		const order_index *ordidx)
+{
+	ordidx_cache_ele *ele = &g_ordidx_cache[g_ordidx_cache_next];
+	uint32_t sz = order_index_size(ordidx);
+
+	g_ordidx_cache_next = (g_ordidx_cache_next + 1) % ORDIDX_CACHE_N_WAYS;
+
+	if (ele->sz != sz) {
+		cf_free(ele->ptr);
+		ele->ptr = cf_malloc(sz);
+	}
+
+	memcpy(ele->ptr, ordidx->_.ptr, sz);
+	ele->hash = hash;
+	ele->content_sz = map->content_sz;
+	ele->sz = sz;
 }
 
 static bool
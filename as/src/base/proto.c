@@ -143,7 +143,7 @@ as_msg_create_internal(const char *ns_name, uint8_t info1, uint8_t info2,
 	m->info1 = info1;
 	m->info2 = info2;
 	m->info3 = info3;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = 0;
 	m->generation = 0;
 	m->record_ttl = record_ttl;
@@ -229,7 +229,7 @@ as_msg_make_response_msg(uint32_t result_code, uint32_t generation,
 	m->info1 = 0;
 	m->info2 = 0;
 	m->info3 = 0;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = result_code;
 	m->generation = generation == 0 ? 0 : plain_generation(generation, ns);
 	m->record_ttl = void_time;
@@ -382,7 +382,7 @@ as_msg_make_response_bufbuilder(cf_buf_builder **bb_r, as_storage_rd *rd,
 	m->info1 = no_bin_data ? AS_MSG_INFO1_GET_NO_BINS : 0;
 	m->info2 = 0;
 	m->info3 = 0;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = AS_OK;
 	m->generation = plain_generation(r->generation, ns);
 	m->record_ttl = r->void_time;
@@ -498,6 +498,86 @@ as_msg_make_response_bufbuilder(cf_buf_builder **bb_r, as_storage_rd *rd,
 	return (int32_t)msg_sz;
 }
 
+// Set name, key and metadata are all in the pickle - only namespace and digest
+// (and maybe bval) go in fields.
+void
+as_msg_make_raw_flat_response_bufbuilder(cf_buf_builder **bb_r,
+		const as_storage_rd *rd, bool send_bval, int64_t bval)
+{
+	as_namespace *ns = rd->ns;
+	as_record *r = rd->r;
+
+	size_t ns_len = strlen(ns->name);
+	size_t format_len = sizeof(AS_MSG_RAW_FLAT_FORMAT) - 1;
+
+	uint16_t n_fields = 2;
+	size_t msg_sz = sizeof(as_msg) +
+			sizeof(as_msg_field) + ns_len +
+			sizeof(as_msg_field) + sizeof(cf_digest) +
+			sizeof(as_msg_op) + format_len + rd->pickle_sz;
+
+	if (send_bval) {
+		n_fields++;
+		msg_sz += sizeof(as_msg_field) + sizeof(bval);
+	}
+
+	uint8_t *buf;
+
+	cf_buf_builder_reserve(bb_r, (int)msg_sz, &buf);
+
+	as_msg *m = (as_msg *)buf;
+
+	*m = (as_msg){
+			.header_sz = sizeof(as_msg),
+			.result_code = AS_OK,
+			.generation = plain_generation(r->generation, ns),
+			.record_ttl = r->void_time,
+			.n_fields = n_fields,
+			.n_ops = 1
+	};
+
+	as_msg_swap_header(m);
+
+	buf = m->data;
+
+	as_msg_field *mf = (as_msg_field *)buf;
+
+	mf->field_sz = ns_len + 1;
+	mf->type = AS_MSG_FIELD_TYPE_NAMESPACE;
+	memcpy(mf->data, ns->name, ns_len);
+	as_msg_swap_field(mf);
+	buf += sizeof(as_msg_field) + ns_len;
+
+	mf = (as_msg_field *)buf;
+	mf->field_sz = sizeof(cf_digest) + 1;
+	mf->type = AS_MSG_FIELD_TYPE_DIGEST_RIPE;
+	memcpy(mf->data, &r->keyd, sizeof(cf_digest));
+	as_msg_swap_field(mf);
+	buf += sizeof(as_msg_field) + sizeof(cf_digest);
+
+	if (send_bval) {
+		mf = (as_msg_field *)buf;
+		mf->field_sz = sizeof(bval) + 1;
+		mf->type = AS_MSG_FIELD_TYPE_BVAL_ARRAY;
+		*(uint64_t*)mf->data = cf_swap_to_le64((uint64_t)bval);
+		as_msg_swap_field(mf);
+		buf += sizeof(as_msg_field) + sizeof(bval);
+	}
+
+	as_msg_op *op = (as_msg_op *)buf;
+
+	op->op = AS_MSG_OP_READ;
+	op->particle_type = AS_PARTICLE_TYPE_BLOB;
+	op->has_lut = 0;
+	op->unused_flags = 0;
+	op->name_sz = (uint8_t)format_len;
+	memcpy(op->name, AS_MSG_RAW_FLAT_FORMAT, format_len);
+	memcpy(op->name + format_len, rd->pickle, rd->pickle_sz);
+	op->op_sz = OP_FIXED_SZ + format_len + rd->pickle_sz;
+
+	as_msg_swap_op(op);
+}
+
 void
 as_msg_pid_done_bufbuilder(cf_buf_builder **bb_r, uint32_t pid, int result)
 {
@@ -562,7 +642,7 @@ as_msg_make_no_val_response(uint32_t result_code, uint32_t generation,
 	m->info1 = 0;
 	m->info2 = 0;
 	m->info3 = 0;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = result_code;
 	m->generation = generation;
 	m->record_ttl = void_time;
@@ -632,7 +712,7 @@ as_msg_make_val_response(bool success, const as_val *val, uint32_t result_code,
 	m->info1 = 0;
 	m->info2 = 0;
 	m->info3 = 0;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = result_code;
 	m->generation = generation;
 	m->record_ttl = void_time;
@@ -702,7 +782,7 @@ as_msg_make_val_response_bufbuilder(const as_val *val, cf_buf_builder **bb_r,
 	m->info1 = 0;
 	m->info2 = 0;
 	m->info3 = 0;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = AS_OK;
 	m->generation = 0;
 	m->record_ttl = 0;
@@ -792,7 +872,7 @@ as_msg_send_fin_timeout(cf_socket *sock, uint32_t result_code, int32_t timeout)
 	m->info1 = 0;
 	m->info2 = 0;
 	m->info3 = AS_MSG_INFO3_LAST;
-	m->unused = 0;
+	m->info4 = 0;
 	m->result_code = result_code;
 	m->generation = 0;
 	m->record_ttl = 0;
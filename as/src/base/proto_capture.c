@@ -0,0 +1,346 @@
+/*
+ * proto_capture.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * Samples client protos on service threads and appends them, with arrival
+ * times, to a capture file for replay. Service threads only copy (and maybe
+ * redact) the proto and queue it - a single writer thread does all file I/O,
+ * and protos are dropped rather than queued without bound.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "base/proto_capture.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_atomic.h"
+#include "citrusleaf/cf_byte_order.h"
+#include "citrusleaf/cf_clock.h"
+#include "citrusleaf/cf_queue.h"
+
+#include "cf_thread.h"
+#include "log.h"
+
+#include "base/cfg.h"
+#include "base/datamodel.h"
+#include "base/proto.h"
+#include "base/stats.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define FILE_NAME "proto.capture"
+
+#define MAX_QUEUED (16 * 1024)
+#define MAX_FILE_SZ (4UL * 1024 * 1024 * 1024)
+
+#define WRITER_POP_MS 1000
+
+typedef struct capture_entry_s {
+	uint64_t start_ns;
+	uint32_t conn_id;
+	uint32_t sz;
+	uint8_t proto[];
+} capture_entry;
+
+
+//==========================================================
+// Globals.
+//
+
+__thread uint32_t g_proto_capture_counter = 0;
+
+static cf_queue g_capture_q;
+
+// Only touched by the writer thread.
+static FILE* g_file = NULL;
+static uint64_t g_file_start_ns;
+static uint64_t g_file_sz;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static bool redact_msg(cl_msg* msgp);
+static void redact_value(uint8_t particle_type, uint8_t* value, uint32_t sz);
+static void* run_writer(void* udata);
+static void open_file(uint64_t first_start_ns, bool redacted);
+static void close_file(void);
+static void write_entry(const capture_entry* e);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_proto_capture_init(void)
+{
+	cf_queue_init(&g_capture_q, sizeof(capture_entry*), 1024, true);
+
+	cf_thread_create_detached(run_writer, NULL);
+}
+
+void
+proto_capture_add(const as_proto* proto, uint64_t start_ns, const void* conn)
+{
+	// Never info or security protos - the latter carry credentials.
+	if (proto->type != PROTO_TYPE_AS_MSG &&
+			proto->type != PROTO_TYPE_AS_MSG_COMPRESSED) {
+		return;
+	}
+
+	bool redact = g_config.proto_capture_redact_values;
+
+	// Can't redact without uncompressing, and not worth it here.
+	if ((redact && proto->type == PROTO_TYPE_AS_MSG_COMPRESSED) ||
+			cf_queue_sz(&g_capture_q) >= MAX_QUEUED) {
+		cf_atomic64_incr(&g_stats.proto_capture_dropped);
+		return;
+	}
+
+	uint32_t sz = (uint32_t)(sizeof(as_proto) + proto->sz);
+	capture_entry* e = cf_malloc(sizeof(capture_entry) + sz);
+
+	e->start_ns = start_ns;
+	e->conn_id = (uint32_t)((uintptr_t)conn >> 4);
+	e->sz = sz;
+	memcpy(e->proto, proto, sz);
+
+	if (redact && ! redact_msg((cl_msg*)e->proto)) {
+		cf_free(e);
+		cf_atomic64_incr(&g_stats.proto_capture_dropped);
+		return;
+	}
+
+	as_proto_swap((as_proto*)e->proto);
+
+	cf_queue_push(&g_capture_q, &e);
+}
+
+
+//==========================================================
+// Local helpers - redaction.
+//
+
+// Body is still in network byte order. Zeroes the stored key and string and
+// blob op values in place, keeping sizes (and so the op mix and key digests)
+// intact. Batch is skipped - its sub-transactions are nested in a field.
+static bool
+redact_msg(cl_msg* msgp)
+{
+	as_msg* m = &msgp->msg;
+
+	if (msgp->proto.sz < sizeof(as_msg) || (m->info1 & AS_MSG_INFO1_BATCH) != 0) {
+		return false;
+	}
+
+	uint8_t* at = m->data;
+	const uint8_t* end = msgp->proto.body + msgp->proto.sz;
+	uint16_t n_fields = cf_swap_from_be16(m->n_fields);
+	uint16_t n_ops = cf_swap_from_be16(m->n_ops);
+
+	for (uint16_t i = 0; i < n_fields; i++) {
+		if (at + sizeof(as_msg_field) > end) {
+			return false;
+		}
+
+		as_msg_field* f = (as_msg_field*)at;
+		uint32_t field_sz = cf_swap_from_be32(f->field_sz); // includes type
+
+		if (field_sz == 0 || field_sz > (uint32_t)(end - f->data) + 1) {
+			return false;
+		}
+
+		// Key field value is a particle type byte, then the key.
+		if (f->type == AS_MSG_FIELD_TYPE_KEY && field_sz > 2) {
+			redact_value(f->data[0], f->data + 1, field_sz - 2);
+		}
+
+		at += sizeof(f->field_sz) + field_sz;
+	}
+
+	for (uint16_t i = 0; i < n_ops; i++) {
+		if (at + sizeof(as_msg_op) > end) {
+			return false;
+		}
+
+		as_msg_op* op = (as_msg_op*)at;
+		uint32_t op_sz = cf_swap_from_be32(op->op_sz);
+		uint32_t value_offset = OP_FIXED_SZ + op->name_sz +
+				as_msg_op_meta_sz(op);
+
+		if (op_sz < value_offset ||
+				op_sz > (uint32_t)(end - at) - sizeof(op->op_sz)) {
+			return false;
+		}
+
+		redact_value(op->particle_type, &op->op + value_offset,
+				op_sz - value_offset);
+
+		at += sizeof(op->op_sz) + op_sz;
+	}
+
+	return true;
+}
+
+// Other types are numbers or structure (CDT, HLL, expressions) that replay
+// needs intact.
+static void
+redact_value(uint8_t particle_type, uint8_t* value, uint32_t sz)
+{
+	if (particle_type == AS_PARTICLE_TYPE_STRING ||
+			particle_type == AS_PARTICLE_TYPE_BLOB) {
+		memset(value, 0, sz);
+	}
+}
+
+
+//==========================================================
+// Local helpers - writer thread.
+//
+
+static void*
+run_writer(void* udata)
+{
+	(void)udata;
+
+	while (true) {
+		capture_entry* e;
+
+		if (cf_queue_pop(&g_capture_q, &e, WRITER_POP_MS) != CF_QUEUE_OK) {
+			// Quiet - a good time to notice capture was switched off.
+			if (g_file != NULL && g_config.proto_capture_sample_period == 0) {
+				close_file();
+			}
+
+			continue;
+		}
+
+		if (g_file == NULL) {
+			open_file(e->start_ns, g_config.proto_capture_redact_values);
+		}
+
+		if (g_file == NULL || g_file_sz + sizeof(as_proto_capture_rec) +
+				e->sz > MAX_FILE_SZ) {
+			cf_atomic64_incr(&g_stats.proto_capture_dropped);
+		}
+		else {
+			write_entry(e);
+		}
+
+		cf_free(e);
+	}
+
+	return NULL;
+}
+
+// Each capture session starts a new file. Redaction is per record, but the
+// flag records the setting at the start.
+static void
+open_file(uint64_t first_start_ns, bool redacted)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", g_config.work_directory, FILE_NAME);
+
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL) {
+		cf_warning(AS_SERVICE, "failed to create proto capture file %s: %s",
+				path, cf_strerror(errno));
+		return;
+	}
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	as_proto_capture_hdr hdr = {
+			.magic = AS_PROTO_CAPTURE_MAGIC,
+			.version = AS_PROTO_CAPTURE_VERSION,
+			.flags = redacted ? AS_PROTO_CAPTURE_FLAG_REDACTED : 0,
+			.start_epoch_ns = ((uint64_t)ts.tv_sec * 1000000000) +
+					(uint64_t)ts.tv_nsec - (cf_getns() - first_start_ns)
+	};
+
+	if (fwrite(&hdr, sizeof(hdr), 1, file) != 1) {
+		cf_warning(AS_SERVICE, "failed to write proto capture file %s: %s",
+				path, cf_strerror(errno));
+		fclose(file);
+		return;
+	}
+
+	g_file = file;
+	g_file_start_ns = first_start_ns;
+	g_file_sz = sizeof(hdr);
+
+	cf_info(AS_SERVICE, "started proto capture to %s%s", path,
+			redacted ? " (redacted)" : "");
+}
+
+static void
+close_file(void)
+{
+	fclose(g_file);
+	g_file = NULL;
+
+	cf_info(AS_SERVICE, "stopped proto capture - %lu bytes", g_file_sz);
+}
+
+static void
+write_entry(const capture_entry* e)
+{
+	// Service threads race to the queue - keep offsets monotonic-ish.
+	as_proto_capture_rec rec = {
+			.offset_ns = e->start_ns > g_file_start_ns ?
+					e->start_ns - g_file_start_ns : 0,
+			.conn_id = e->conn_id,
+			.sz = e->sz
+	};
+
+	if (fwrite(&rec, sizeof(rec), 1, g_file) != 1 ||
+			fwrite(e->proto, e->sz, 1, g_file) != 1) {
+		cf_warning(AS_SERVICE, "failed proto capture write: %s - stopping",
+				cf_strerror(errno));
+		close_file();
+		g_config.proto_capture_sample_period = 0;
+		return;
+	}
+
+	g_file_sz += sizeof(rec) + e->sz;
+	cf_atomic64_incr(&g_stats.proto_capture_records);
+}
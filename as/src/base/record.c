@@ -39,6 +39,7 @@
 #include "base/cfg.h"
 #include "base/datamodel.h"
 #include "base/index.h"
+#include "base/nsup.h"
 #include "base/proto.h"
 #include "base/truncate.h"
 #include "base/xdr.h"
@@ -127,7 +128,7 @@ as_record_done(as_index_ref *r_ref, as_namespace *ns)
 		}
 	}
 
-	cf_mutex_unlock(r_ref->olock);
+	as_index_olock_unlock(r_ref->olock);
 }
 
 
@@ -150,7 +151,7 @@ as_record_rescue(as_index_ref *r_ref, as_namespace *ns)
 {
 	remove_from_sindex(ns, r_ref);
 	as_record_destroy(r_ref->r, ns);
-	as_index_clear_record_info(r_ref->r);
+	as_index_clear_record_info(r_ref->r, ns->storage_data_in_memory);
 	cf_atomic64_incr(&ns->n_objects);
 }
 
@@ -173,9 +174,11 @@ as_record_destroy(as_record *r, as_namespace *ns)
 
 		as_storage_record_drop_from_mem_stats(&rd);
 
-		as_bin_destroy_all(rd.bins, rd.n_bins);
-
-		if (! ns->single_bin) {
+		if (ns->single_bin) {
+			as_bin_destroy_all(rd.bins, rd.n_bins);
+		}
+		else {
+			as_bin_destroy_all_stored(r, rd.bins, rd.n_bins);
 			as_record_free_bin_space(r);
 
 			if (r->dim) {
@@ -393,6 +396,7 @@ as_record_replace_if_better(as_remote_record *rr)
 	}
 
 	record_replaced(r, rr);
+	as_nsup_expire_index_add(ns, rr->rsv->p->id, r_ref.r_h, r->void_time);
 
 	// Save for XDR submit outside record lock.
 	as_xdr_submit_info submit_info;
@@ -587,7 +591,7 @@ record_apply_dim(as_remote_record *rr, as_index_ref *r_ref, as_storage_rd *rd)
 	}
 
 	// Cleanup - destroy original bins, can't unwind after.
-	as_bin_destroy_all(rd->bins, rd->n_bins);
+	as_bin_destroy_all_stored(r, rd->bins, rd->n_bins);
 
 	rd->n_bins = n_new_bins;
 	rd->bins = new_bins;
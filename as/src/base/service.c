@@ -55,7 +55,9 @@
 #include "base/batch.h"
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/probes.h"
 #include "base/proto.h"
+#include "base/proto_capture.h"
 #include "base/security.h"
 #include "base/stats.h"
 #include "base/thr_info.h"
@@ -72,17 +74,51 @@
 
 #define N_EVENTS 1024
 
+// Accept threads share the listening sockets - EPOLLEXCLUSIVE wakes just one
+// of them per incoming connection, so reconnect storms are spread out.
+#define N_ACCEPT_THREADS 4
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1U << 28)
+#endif
+
 #define XDR_WRITE_BUFFER_SIZE (5 * 1024 * 1024)
 #define XDR_READ_BUFFER_SIZE (15 * 1024 * 1024)
 
+// Threads running device-bound transactions handed off by service threads.
+#define N_OFFLOAD_THREADS 8
+
+#define SID_NONE UINT32_MAX
+
+// Reaper moves a connection off the busiest service thread only if that thread
+// runs at least this many requests per second ...
+#define REBALANCE_MIN_RATE 1000
+// ... at least this percentage of the idlest thread's rate ...
+#define REBALANCE_MIN_RATIO_PCT 150
+// ... for this many consecutive reaper ticks (seconds).
+#define REBALANCE_N_TICKS 3
+
 typedef struct thread_ctx_s {
 	uint32_t sid;
 	cf_topo_cpu_index i_cpu;
 	cf_mutex* lock;
 	cf_poll poll;
 	cf_epoll_queue trans_q;
+	cf_epoll_queue bg_q; // background lane - gets only spare capacity
+	uint32_t n_bg_deferrals;
+	as_namespace* group_ns; // NULL for the shared service threads
 } thread_ctx;
 
+// A namespace's own service threads - fixed at startup.
+typedef struct service_group_s {
+	uint32_t n_threads;
+	uint32_t rr;
+	thread_ctx** ctxs;
+	cf_mutex* locks;
+	bool pinned;
+	cpu_set_t cpus;
+} service_group;
+
 
 //==========================================================
 // Globals.
@@ -108,6 +144,17 @@ static uint32_t g_n_slots;
 static as_file_handle** g_file_handles;
 static cf_queue g_free_slots;
 
+static cf_queue g_offload_q;
+
+// TLS client connections wait here until their handshakes complete.
+static cf_poll g_handshake_polls[MAX_TLS_HANDSHAKE_THREADS];
+
+// Per service thread request counters - written only by the owning thread.
+static uint64_t g_thread_n_reqs[MAX_SERVICE_THREADS];
+
+// Indexed by namespace ix - n_threads 0 if the namespace shares threads.
+static service_group g_groups[AS_NAMESPACE_SZ];
+
 
 //==========================================================
 // Forward declarations.
@@ -115,11 +162,18 @@ static cf_queue g_free_slots;
 
 // Setup.
 static void create_service_thread(uint32_t sid);
+static void create_service_groups(void);
+static void create_group_thread(as_namespace* ns, uint32_t i);
 static void add_localhost(cf_serv_cfg* serv_cfg, cf_sock_owner owner);
 
 // Accept client connections.
 static void* run_accept(void* udata);
 
+// Complete TLS handshakes off the service threads.
+static void start_tls_handshake(void);
+static void* run_tls_handshake(void* udata);
+static void handshake_socket(as_file_handle* fd_h);
+
 // Assign connections to threads.
 static void assign_socket(as_file_handle* fd_h);
 static uint32_t select_sid(void);
@@ -127,21 +181,33 @@ static uint32_t select_sid_pinned(cf_topo_cpu_index i_cpu);
 static uint32_t select_sid_adq(cf_topo_napi_id id);
 static uint32_t select_sid_specified(const cf_digest* d, uint32_t max_threads, bool use_pid);
 static void schedule_redistribution(void);
+static thread_ctx* select_group_ctx(const as_namespace* ns);
 
 // Demarshal requests.
 static void* run_service(void* udata);
 static void stop_service(thread_ctx* ctx);
 static void service_release_file_handle(as_file_handle* fd_h);
 static bool process_readable(as_file_handle* fd_h);
-static void start_transaction(as_file_handle* fd_h);
+static void start_transaction(thread_ctx* ctx, as_file_handle* fd_h);
+static as_namespace* transaction_ns(const as_transaction* tr);
+static bool route_transaction(const thread_ctx* ctx, as_transaction* tr, as_namespace* ns);
 static void config_xdr_socket(cf_socket* sock);
 
 // Reap idle and bad connections.
 static void start_reaper(void);
 static void* run_reaper(void* udata);
+static void rebalance_connections(void);
 
 // Transaction queue.
 static bool start_internal_transaction(thread_ctx* ctx);
+static bool should_start_background(thread_ctx* ctx, int32_t n_events);
+static void start_background_transaction(thread_ctx* ctx);
+static void requeue_background(thread_ctx* ctx);
+
+// Offload device-bound transactions.
+static void start_offload(void);
+static void* run_offload(void* udata);
+static bool should_offload(const as_transaction* tr, const as_namespace* ns);
 
 
 //==========================================================
@@ -175,6 +241,10 @@ as_service_init(void)
 	for (uint32_t i = 0; i < g_config.n_service_threads; i++) {
 		create_service_thread(i);
 	}
+
+	create_service_groups();
+	start_offload();
+	as_proto_capture_init();
 }
 
 void
@@ -195,11 +265,15 @@ as_service_start(void)
 
 	cf_socket_show_server(AS_SERVICE, "client", &g_sockets);
 
-	// Create accept thread.
+	start_tls_handshake();
 
-	cf_info(AS_SERVICE, "starting accept thread");
+	// Create accept threads.
 
-	cf_thread_create_detached(run_accept, NULL);
+	cf_info(AS_SERVICE, "starting %u accept threads", N_ACCEPT_THREADS);
+
+	for (uint32_t i = 0; i < N_ACCEPT_THREADS; i++) {
+		cf_thread_create_detached(run_accept, NULL);
+	}
 }
 
 void
@@ -315,6 +389,33 @@ as_service_enqueue_internal_raw(as_transaction* tr, const cf_digest* d,
 	}
 }
 
+// All go to the same service thread's background lane, under one lock
+// acquisition.
+void
+as_service_enqueue_background_batch(as_transaction* trs, uint32_t n_trs)
+{
+	while (true) {
+		uint32_t sid = ! as_config_is_cpu_pinned() ?
+				select_sid_specified(NULL, 0, false) :
+				select_sid_pinned(cf_topo_current_cpu());
+
+		cf_mutex_lock(&g_thread_locks[sid]);
+
+		thread_ctx* ctx = g_thread_ctxs[sid];
+
+		if (ctx != NULL) {
+			for (uint32_t i = 0; i < n_trs; i++) {
+				cf_epoll_queue_push(&ctx->bg_q, &trs[i]);
+			}
+
+			cf_mutex_unlock(&g_thread_locks[sid]);
+			break;
+		}
+
+		cf_mutex_unlock(&g_thread_locks[sid]);
+	}
+}
+
 
 //==========================================================
 // Local helpers - setup.
@@ -336,6 +437,9 @@ create_service_thread(uint32_t sid)
 	ctx->lock = &g_thread_locks[sid];
 	cf_poll_create(&ctx->poll);
 	cf_epoll_queue_init(&ctx->trans_q, AS_TRANSACTION_HEAD_SIZE, 64);
+	cf_epoll_queue_init(&ctx->bg_q, AS_TRANSACTION_HEAD_SIZE, 64);
+	ctx->n_bg_deferrals = 0;
+	ctx->group_ns = NULL;
 
 	cf_thread_create_transient(run_service, ctx);
 
@@ -346,6 +450,65 @@ create_service_thread(uint32_t sid)
 	cf_mutex_unlock(&g_thread_locks[sid]);
 }
 
+// Namespaces with their own service-threads get client transactions served
+// apart from everyone else's, so a neighbor's load can't queue behind them.
+static void
+create_service_groups(void)
+{
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		as_namespace* ns = g_config.namespaces[ns_ix];
+		service_group* group = &g_groups[ns->ix];
+
+		if (ns->n_service_threads == 0) {
+			continue;
+		}
+
+		cf_info(AS_SERVICE, "{%s} starting %u service threads%s%s", ns->name,
+				ns->n_service_threads,
+				ns->service_thread_cpus != NULL ? " on cpus " : "",
+				ns->service_thread_cpus != NULL ? ns->service_thread_cpus : "");
+
+		if (ns->service_thread_cpus != NULL) {
+			// Validated at config parse.
+			cf_topo_parse_os_cpu_list(ns->service_thread_cpus, &group->cpus);
+			group->pinned = true;
+		}
+
+		group->ctxs = cf_malloc(sizeof(thread_ctx*) * ns->n_service_threads);
+		group->locks = cf_malloc(sizeof(cf_mutex) * ns->n_service_threads);
+
+		for (uint32_t i = 0; i < ns->n_service_threads; i++) {
+			create_group_thread(ns, i);
+		}
+
+		// Set last - others see a group only once it's complete.
+		as_store_uint32(&group->n_threads, ns->n_service_threads);
+	}
+}
+
+static void
+create_group_thread(as_namespace* ns, uint32_t i)
+{
+	service_group* group = &g_groups[ns->ix];
+	thread_ctx* ctx = cf_malloc(sizeof(thread_ctx));
+
+	cf_detail(AS_SERVICE, "{%s} starting group thread %u ctx %p", ns->name, i,
+			ctx);
+
+	ctx->sid = SID_NONE;
+	ctx->lock = &group->locks[i];
+	cf_mutex_init(ctx->lock);
+	cf_poll_create(&ctx->poll);
+	cf_epoll_queue_init(&ctx->trans_q, AS_TRANSACTION_HEAD_SIZE, 64);
+	cf_epoll_queue_init(&ctx->bg_q, AS_TRANSACTION_HEAD_SIZE, 64);
+	ctx->n_bg_deferrals = 0;
+	ctx->group_ns = ns;
+
+	group->ctxs[i] = ctx;
+
+	cf_thread_create_detached(run_service, ctx);
+}
+
 static void
 add_localhost(cf_serv_cfg* serv_cfg, cf_sock_owner owner)
 {
@@ -395,7 +558,7 @@ run_accept(void* udata)
 	cf_poll poll;
 	cf_poll_create(&poll);
 
-	cf_poll_add_sockets(poll, &g_sockets, EPOLLIN);
+	cf_poll_add_sockets(poll, &g_sockets, EPOLLIN | EPOLLEXCLUSIVE);
 
 	while (true) {
 		cf_poll_event events[N_EVENTS];
@@ -409,6 +572,10 @@ run_accept(void* udata)
 			cf_sock_addr caddr;
 
 			if (cf_socket_accept(ssock, &csock, &caddr) < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					continue; // another accept thread got it
+				}
+
 				if (errno == EMFILE || errno == ENFILE) {
 					cf_ticker_warning(AS_SERVICE, "out of file descriptors");
 					continue;
@@ -437,6 +604,10 @@ run_accept(void* udata)
 
 			cf_socket_keep_alive(&csock, 60, 60, 2);
 
+			if (g_config.busy_poll_us != 0) {
+				cf_socket_set_busy_poll(&csock, (int32_t)g_config.busy_poll_us);
+			}
+
 			if (cfg->owner == CF_SOCK_OWNER_SERVICE_TLS) {
 				tls_socket_prepare_server(g_service_tls, &csock);
 			}
@@ -455,6 +626,10 @@ run_accept(void* udata)
 			fd_h->move_me = false;
 			fd_h->reap_me = false;
 			fd_h->is_xdr = false;
+			fd_h->move_sid = SID_NONE;
+			fd_h->group_ns = NULL;
+			fd_h->n_reqs = 0;
+			fd_h->n_reqs_seen = 0;
 			fd_h->proto = NULL;
 			fd_h->proto_unread = sizeof(as_proto);
 			fd_h->security_filter = as_security_filter_create();
@@ -474,7 +649,13 @@ run_accept(void* udata)
 
 			cf_mutex_unlock(&g_reaper_lock);
 
-			assign_socket(fd_h); // arms (EPOLLIN)
+			if (tls_socket_needs_handshake(&fd_h->sock) &&
+					g_config.n_tls_handshake_threads != 0) {
+				handshake_socket(fd_h); // arms (EPOLLIN)
+			}
+			else {
+				assign_socket(fd_h); // arms (EPOLLIN)
+			}
 
 			cf_atomic64_incr(&g_stats.proto_connections_opened);
 		}
@@ -484,6 +665,86 @@ run_accept(void* udata)
 }
 
 
+//==========================================================
+// Local helpers - complete TLS handshakes.
+//
+
+// A reconnect storm is many CPU-heavy handshakes at once - doing them here
+// keeps them from stalling transactions on the service threads. Connections
+// join a service thread only once established.
+static void
+start_tls_handshake(void)
+{
+	if (g_service_tls == NULL || g_config.n_tls_handshake_threads == 0) {
+		g_config.n_tls_handshake_threads = 0; // handshake on service threads
+		return;
+	}
+
+	cf_info(AS_SERVICE, "starting %u tls handshake threads",
+			g_config.n_tls_handshake_threads);
+
+	for (uint32_t i = 0; i < g_config.n_tls_handshake_threads; i++) {
+		cf_poll_create(&g_handshake_polls[i]);
+		cf_thread_create_detached(run_tls_handshake,
+				(void*)(uint64_t)i);
+	}
+}
+
+static void*
+run_tls_handshake(void* udata)
+{
+	cf_poll poll = g_handshake_polls[(uint32_t)(uint64_t)udata];
+
+	while (true) {
+		cf_poll_event events[N_EVENTS];
+		int32_t n_events = cf_poll_wait(poll, events, N_EVENTS, -1);
+
+		cf_assert(n_events >= 0, AS_SERVICE, "unexpected EINTR");
+
+		for (uint32_t i = 0; i < (uint32_t)n_events; i++) {
+			as_file_handle* fd_h = events[i].data;
+
+			if ((events[i].events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) != 0) {
+				service_release_file_handle(fd_h);
+				continue;
+			}
+
+			int32_t tls_ev = tls_socket_accept(&fd_h->sock);
+
+			if (tls_ev == EPOLLERR) {
+				service_release_file_handle(fd_h);
+				continue;
+			}
+
+			if (tls_ev != 0) {
+				rearm(fd_h, (uint32_t)tls_ev);
+				continue;
+			}
+
+			tls_socket_must_not_have_data(&fd_h->sock, "handshake thread");
+
+			fd_h->last_used = cf_getns();
+
+			cf_poll_delete_socket(poll, &fd_h->sock);
+			assign_socket(fd_h); // arms (EPOLLIN)
+		}
+	}
+
+	return NULL;
+}
+
+static void
+handshake_socket(as_file_handle* fd_h)
+{
+	static uint32_t rr = 0;
+
+	fd_h->poll = g_handshake_polls[rr++ % g_config.n_tls_handshake_threads];
+
+	cf_poll_add_socket(fd_h->poll, &fd_h->sock,
+			EPOLLIN | EPOLLONESHOT | EPOLLRDHUP, fd_h);
+}
+
+
 //==========================================================
 // Local helpers - assign client connections to threads.
 //
@@ -491,12 +752,28 @@ run_accept(void* udata)
 static void
 assign_socket(as_file_handle* fd_h)
 {
+	uint32_t move_sid = fd_h->move_sid;
+
+	fd_h->move_sid = SID_NONE;
+
+	// Group threads never stop - no need to retry.
+	if (fd_h->group_ns != NULL) {
+		fd_h->poll = select_group_ctx(fd_h->group_ns)->poll;
+
+		cf_poll_add_socket(fd_h->poll, &fd_h->sock,
+				EPOLLIN | EPOLLONESHOT | EPOLLRDHUP, fd_h);
+		return;
+	}
+
 	while (true) {
 		uint32_t sid;
 
 		switch (g_config.auto_pin) {
 		case CF_TOPO_AUTO_PIN_NONE:
-			sid = select_sid();
+			// Reaper may have chosen a less loaded thread.
+			sid = move_sid < g_config.n_service_threads ?
+					move_sid : select_sid();
+			move_sid = SID_NONE; // if thread is gone, retry the usual way
 			break;
 		case CF_TOPO_AUTO_PIN_CPU:
 		case CF_TOPO_AUTO_PIN_NUMA:
@@ -594,6 +871,14 @@ schedule_redistribution(void)
 	cf_mutex_unlock(&g_reaper_lock);
 }
 
+static thread_ctx*
+select_group_ctx(const as_namespace* ns)
+{
+	service_group* group = &g_groups[ns->ix];
+
+	return group->ctxs[as_faa_uint32(&group->rr, 1) % group->n_threads];
+}
+
 
 //==========================================================
 // Local helpers - demarshal client requests.
@@ -606,15 +891,31 @@ run_service(void* udata)
 
 	cf_detail(AS_SERVICE, "running ctx %p", ctx);
 
-	if (as_config_is_cpu_pinned()) {
+	if (ctx->group_ns != NULL) {
+		service_group* group = &g_groups[ctx->group_ns->ix];
+
+		if (group->pinned) {
+			cf_topo_pin_to_os_cpus(&group->cpus);
+		}
+	}
+	else if (as_config_is_cpu_pinned()) {
 		cf_topo_pin_to_cpu(ctx->i_cpu);
 	}
 
+	// Account this thread's heap usage to transactions. Pooled thread, so
+	// restore its arena on the way out.
+	int32_t old_arena = cf_alloc_set_thread_sys(CF_ALLOC_SYS_TRANSACTION);
+
 	cf_poll poll = ctx->poll;
 	cf_epoll_queue* trans_q = &ctx->trans_q;
 
 	cf_poll_add_fd(poll, trans_q->event_fd, EPOLLIN, trans_q);
-	as_xdr_init_poll(poll);
+	cf_poll_add_fd(poll, ctx->bg_q.event_fd, EPOLLIN, &ctx->bg_q);
+
+	// XDR only uses the shared threads.
+	if (ctx->group_ns == NULL) {
+		as_xdr_init_poll(poll);
+	}
 
 	while (true) {
 		cf_poll_event events[N_EVENTS];
@@ -631,11 +932,22 @@ run_service(void* udata)
 				cf_assert(mask == EPOLLIN, AS_SERVICE,
 						"unexpected event: 0x%0x", mask);
 
+				// Level-triggered - a deferred background event comes back on
+				// the next wait.
+				if (data == &ctx->bg_q) {
+					if (should_start_background(ctx, n_events)) {
+						start_background_transaction(ctx);
+					}
+
+					continue;
+				}
+
 				if (start_internal_transaction(ctx)) {
 					continue;
 				}
 
 				stop_service(ctx);
+				cf_alloc_set_thread_arena(old_arena);
 
 				return NULL;
 			}
@@ -694,9 +1006,16 @@ run_service(void* udata)
 				continue;
 			}
 
+			// For the reaper's load rebalancing.
+			fd_h->n_reqs++;
+
+			if (ctx->group_ns == NULL) {
+				g_thread_n_reqs[ctx->sid]++;
+			}
+
 			// Note that epoll cannot trigger again for this file handle during
 			// the transaction. We'll rearm at the end of the transaction.
-			start_transaction(fd_h);
+			start_transaction(ctx, fd_h);
 		}
 	}
 
@@ -756,8 +1075,11 @@ stop_service(thread_ctx* ctx)
 		sleep(1);
 	}
 
+	requeue_background(ctx);
+
 	cf_poll_destroy(ctx->poll);
 	cf_epoll_queue_destroy(&ctx->trans_q);
+	cf_epoll_queue_destroy(&ctx->bg_q);
 
 	cf_free(ctx);
 
@@ -848,7 +1170,7 @@ process_readable(as_file_handle* fd_h)
 }
 
 static void
-start_transaction(as_file_handle* fd_h)
+start_transaction(thread_ctx* ctx, as_file_handle* fd_h)
 {
 	// as_end_of_transaction() rearms then decrements, so this may be > 1.
 	as_incr_uint32(&fd_h->in_transaction);
@@ -856,6 +1178,10 @@ start_transaction(as_file_handle* fd_h)
 	uint64_t start_ns = fd_h->last_used;
 	as_proto* proto = fd_h->proto;
 
+	ASD_PROBE3(trans__receive, (uint64_t)fd_h, proto->type, proto->sz);
+
+	as_proto_capture_sample(proto, start_ns, fd_h);
+
 	fd_h->proto = NULL;
 	fd_h->proto_unread = sizeof(as_proto);
 
@@ -909,9 +1235,68 @@ start_transaction(as_file_handle* fd_h)
 		return;
 	}
 
+	as_namespace* ns = transaction_ns(&tr);
+
+	if (route_transaction(ctx, &tr, ns)) {
+		return;
+	}
+
+	// Don't let a slow device read stall the other connections on this
+	// thread's epoll set - the fd isn't rearmed until the transaction ends.
+	if (should_offload(&tr, ns)) {
+		cf_queue_push(&g_offload_q, &tr);
+		return;
+	}
+
 	as_tsvc_process_transaction(&tr);
 }
 
+static as_namespace*
+transaction_ns(const as_transaction* tr)
+{
+	as_msg_field* nf = as_msg_field_get(&tr->msgp->msg,
+			AS_MSG_FIELD_TYPE_NAMESPACE);
+
+	// If NULL, let the transaction service report it.
+	return nf == NULL ? NULL : as_namespace_get_bymsgfield(nf);
+}
+
+// Hands the transaction to its namespace's service thread group (or back to
+// the shared threads), and moves the connection along with it when it's next
+// rearmed, so its next request is read there.
+static bool
+route_transaction(const thread_ctx* ctx, as_transaction* tr, as_namespace* ns)
+{
+	if (ns == NULL) {
+		return false;
+	}
+
+	as_namespace* group_ns =
+			as_load_uint32(&g_groups[ns->ix].n_threads) != 0 ? ns : NULL;
+
+	if (group_ns == ctx->group_ns) {
+		return false;
+	}
+
+	as_file_handle* fd_h = tr->from.proto_fd_h;
+
+	fd_h->group_ns = group_ns;
+	fd_h->move_me = true;
+
+	if (group_ns == NULL) {
+		as_service_enqueue_internal(tr);
+		return true;
+	}
+
+	thread_ctx* to_ctx = select_group_ctx(group_ns);
+
+	cf_mutex_lock(to_ctx->lock);
+	cf_epoll_queue_push(&to_ctx->trans_q, tr);
+	cf_mutex_unlock(to_ctx->lock);
+
+	return true;
+}
+
 static void
 config_xdr_socket(cf_socket* sock)
 {
@@ -996,12 +1381,119 @@ run_reaper(void* udata)
 			}
 		}
 
+		rebalance_connections();
+
 		cf_mutex_unlock(&g_reaper_lock);
 	}
 
 	return NULL;
 }
 
+// Called with g_reaper_lock held, once per reaper tick.
+static void
+rebalance_connections(void)
+{
+	static uint64_t prev_n_reqs[MAX_SERVICE_THREADS] = { 0 };
+	static uint32_t n_imbalanced_ticks = 0;
+
+	uint32_t n_threads = as_load_uint32(&g_config.n_service_threads);
+	uint32_t hot_sid = 0;
+	uint32_t cold_sid = 0;
+	uint64_t hot_rate = 0;
+	uint64_t cold_rate = UINT64_MAX;
+
+	for (uint32_t sid = 0; sid < n_threads; sid++) {
+		uint64_t n_reqs = as_load_uint64(&g_thread_n_reqs[sid]);
+		uint64_t rate = n_reqs - prev_n_reqs[sid];
+
+		prev_n_reqs[sid] = n_reqs;
+
+		if (rate > hot_rate) {
+			hot_sid = sid;
+			hot_rate = rate;
+		}
+
+		if (rate < cold_rate) {
+			cold_sid = sid;
+			cold_rate = rate;
+		}
+	}
+
+	// Pinned modes place connections deliberately - leave them alone.
+	bool imbalanced = g_config.auto_pin == CF_TOPO_AUTO_PIN_NONE &&
+			n_threads > 1 && hot_rate >= REBALANCE_MIN_RATE &&
+			hot_rate * 100 > cold_rate * REBALANCE_MIN_RATIO_PCT;
+
+	n_imbalanced_ticks = imbalanced ? n_imbalanced_ticks + 1 : 0;
+
+	bool move = n_imbalanced_ticks >= REBALANCE_N_TICKS;
+	cf_poll hot_poll = INVALID_POLL;
+
+	if (move) {
+		cf_mutex_lock(&g_thread_locks[hot_sid]);
+
+		thread_ctx* ctx = g_thread_ctxs[hot_sid];
+
+		if (ctx != NULL) {
+			hot_poll = ctx->poll;
+		}
+		else {
+			move = false;
+		}
+
+		cf_mutex_unlock(&g_thread_locks[hot_sid]);
+	}
+
+	// Don't move more than would even out the two threads, else the imbalance
+	// just flips around.
+	uint64_t max_rate = (hot_rate - cold_rate) / 2;
+	as_file_handle* best_fd_h = NULL;
+	uint32_t best_rate = 0;
+
+	uint32_t n_remaining = g_n_slots - cf_queue_sz(&g_free_slots);
+
+	for (uint32_t i = 0; n_remaining != 0; i++) {
+		as_file_handle* fd_h = g_file_handles[i];
+
+		if (fd_h == NULL) {
+			continue;
+		}
+
+		n_remaining--;
+
+		// Snapshot every tick, so rates cover just the last tick.
+		uint32_t n_reqs = as_load_uint32(&fd_h->n_reqs);
+		uint32_t rate = n_reqs - fd_h->n_reqs_seen;
+
+		fd_h->n_reqs_seen = n_reqs;
+
+		if (! move || fd_h->move_me || fd_h->reap_me ||
+				! cf_poll_equal(fd_h->poll, hot_poll)) {
+			continue;
+		}
+
+		if (rate > best_rate && rate <= max_rate) {
+			best_fd_h = fd_h;
+			best_rate = rate;
+		}
+	}
+
+	if (best_fd_h == NULL) {
+		return;
+	}
+
+	cf_detail(AS_SERVICE, "moving %s (%u/s) from sid %u (%lu/s) to sid %u (%lu/s)",
+			best_fd_h->client, best_rate, hot_sid, hot_rate, cold_sid,
+			cold_rate);
+
+	// Takes effect when the connection is next rearmed.
+	best_fd_h->move_sid = cold_sid;
+	best_fd_h->move_me = true;
+
+	n_imbalanced_ticks = 0;
+	g_stats.rebalance_count++;
+}
+
 
 //==========================================================
 // Local helpers - transaction queue.
@@ -1028,3 +1520,115 @@ start_internal_transaction(thread_ctx* ctx)
 
 	return true;
 }
+
+// Background work (e.g. background query sub-transactions) only gets spare
+// capacity - if anything else is ready on this thread, it goes once per
+// background-dispatch-ratio passes.
+static bool
+should_start_background(thread_ctx* ctx, int32_t n_events)
+{
+	uint32_t ratio = g_config.background_dispatch_ratio;
+
+	if (ratio == 0 || n_events == 1) {
+		ctx->n_bg_deferrals = 0;
+		return true;
+	}
+
+	if (++ctx->n_bg_deferrals < ratio) {
+		return false;
+	}
+
+	ctx->n_bg_deferrals = 0;
+
+	return true;
+}
+
+static void
+start_background_transaction(thread_ctx* ctx)
+{
+	as_transaction tr;
+
+	cf_mutex_lock(ctx->lock);
+
+	bool popped = cf_epoll_queue_pop(&ctx->bg_q, &tr);
+
+	cf_mutex_unlock(ctx->lock);
+
+	if (popped) {
+		as_tsvc_process_transaction(&tr);
+	}
+}
+
+// A stopping thread is no longer enqueue-able - hand its background backlog to
+// the remaining threads.
+static void
+requeue_background(thread_ctx* ctx)
+{
+	as_transaction tr;
+
+	while (true) {
+		cf_mutex_lock(ctx->lock);
+
+		bool popped = cf_epoll_queue_pop(&ctx->bg_q, &tr);
+
+		cf_mutex_unlock(ctx->lock);
+
+		if (! popped) {
+			break;
+		}
+
+		as_service_enqueue_background_batch(&tr, 1);
+	}
+}
+
+
+//==========================================================
+// Local helpers - offload device-bound transactions.
+//
+
+static void
+start_offload(void)
+{
+	cf_queue_init(&g_offload_q, AS_TRANSACTION_HEAD_SIZE, 1024, true);
+
+	for (uint32_t i = 0; i < N_OFFLOAD_THREADS; i++) {
+		cf_thread_create_detached(run_offload, NULL);
+	}
+}
+
+static void*
+run_offload(void* udata)
+{
+	(void)udata;
+
+	while (true) {
+		as_transaction tr;
+
+		if (cf_queue_pop(&g_offload_q, &tr, CF_QUEUE_FOREVER) != CF_QUEUE_OK) {
+			cf_crash(AS_SERVICE, "unable to pop from offload queue");
+		}
+
+		as_tsvc_process_transaction(&tr);
+	}
+
+	return NULL;
+}
+
+static bool
+should_offload(const as_transaction* tr, const as_namespace* ns)
+{
+	const as_msg* m = &tr->msgp->msg;
+
+	if (ns == NULL || ns->storage_read_offload_us == 0 ||
+			as_namespace_like_data_in_memory(ns)) {
+		return false;
+	}
+
+	// Metadata-only reads are served from the index.
+	if ((m->info1 & AS_MSG_INFO1_GET_NO_BINS) != 0 &&
+			(m->info2 & AS_MSG_INFO2_WRITE) == 0) {
+		return false;
+	}
+
+	return ns->storage_read_latency_us > ns->storage_read_offload_us;
+}
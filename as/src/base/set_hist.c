@@ -0,0 +1,249 @@
+/*
+ * set_hist.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "base/set_hist.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/alloc.h"
+
+#include "cf_mutex.h"
+#include "dynbuf.h"
+#include "hist.h"
+#include "log.h"
+#include "vmapx.h"
+
+#include "base/cfg.h"
+#include "base/datamodel.h"
+#include "base/proto.h"
+#include "base/transaction.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+static const char* TYPE_NAMES[] = {
+		[AS_SET_HIST_READ] = "read",
+		[AS_SET_HIST_WRITE] = "write",
+		[AS_SET_HIST_UDF] = "udf",
+		[AS_SET_HIST_BATCH_SUB] = "batch-sub"
+};
+
+static const char* STAT_PREFIXES[] = {
+		[AS_SET_HIST_READ] = "read",
+		[AS_SET_HIST_WRITE] = "write",
+		[AS_SET_HIST_UDF] = "udf",
+		[AS_SET_HIST_BATCH_SUB] = "batch_sub"
+};
+
+COMPILER_ASSERT(sizeof(TYPE_NAMES) / sizeof(const char*) ==
+		AS_SET_HIST_N_TYPES);
+COMPILER_ASSERT(sizeof(as_set_hist_counts) == 64);
+
+
+//==========================================================
+// Globals.
+//
+
+static cf_mutex g_enable_lock = CF_MUTEX_INIT;
+
+static uint32_t g_next_shard = 0;
+static __thread uint32_t g_shard = AS_SET_HIST_N_SHARDS; // not yet assigned
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static as_set_hist* create_set_hist(const as_namespace* ns, const as_set* p_set);
+static uint32_t thread_shard(void);
+
+
+//==========================================================
+// Public API.
+//
+
+// Startup config and info set-config may both enable - serialize here.
+void
+as_set_hist_enable(as_namespace* ns, as_set* p_set)
+{
+	cf_mutex_lock(&g_enable_lock);
+
+	if (p_set->hist == NULL) {
+		as_set_hist* sh = create_set_hist(ns, p_set);
+
+		// Publish fully initialized struct before anyone can see it.
+		as_fence_rls();
+		p_set->hist = sh;
+	}
+
+	as_fence_rls();
+	p_set->hist_enabled = true;
+	ns->set_hist_active = true;
+
+	cf_mutex_unlock(&g_enable_lock);
+}
+
+// Keep the struct - transactions may still be inserting into it.
+void
+as_set_hist_disable(as_set* p_set)
+{
+	p_set->hist_enabled = false;
+}
+
+void
+as_set_hist_append_stats(const as_set* p_set, cf_dyn_buf* db)
+{
+	const as_set_hist* sh = p_set->hist;
+
+	if (sh == NULL) {
+		return;
+	}
+
+	for (uint32_t t = 0; t < AS_SET_HIST_N_TYPES; t++) {
+		uint64_t n_ops = 0;
+		uint64_t n_errors = 0;
+
+		for (uint32_t s = 0; s < AS_SET_HIST_N_SHARDS; s++) {
+			n_ops += as_load_uint64(&sh->counts[s].n_ops[t]);
+			n_errors += as_load_uint64(&sh->counts[s].n_errors[t]);
+		}
+
+		cf_dyn_buf_append_string(db, STAT_PREFIXES[t]);
+		cf_dyn_buf_append_string(db, "_ops=");
+		cf_dyn_buf_append_uint64(db, n_ops);
+		cf_dyn_buf_append_char(db, ':');
+
+		cf_dyn_buf_append_string(db, STAT_PREFIXES[t]);
+		cf_dyn_buf_append_string(db, "_errors=");
+		cf_dyn_buf_append_uint64(db, n_errors);
+		cf_dyn_buf_append_char(db, ':');
+	}
+}
+
+void
+as_set_hist_get_latencies(as_namespace* ns, bool percentiles, cf_dyn_buf* db)
+{
+	for (uint32_t idx = 0; idx < cf_vmapx_count(ns->p_sets_vmap); idx++) {
+		as_set* p_set;
+
+		if (cf_vmapx_get_by_index(ns->p_sets_vmap, idx, (void**)&p_set) !=
+				CF_VMAPX_OK || ! p_set->hist_enabled) {
+			continue;
+		}
+
+		for (uint32_t t = 0; t < AS_SET_HIST_N_TYPES; t++) {
+			histogram_get_latencies(p_set->hist->hists[t], percentiles, db);
+		}
+	}
+}
+
+// Called by the ticker.
+void
+as_set_hist_dump(as_namespace* ns)
+{
+	if (! ns->set_hist_active) {
+		return;
+	}
+
+	for (uint32_t idx = 0; idx < cf_vmapx_count(ns->p_sets_vmap); idx++) {
+		as_set* p_set;
+
+		if (cf_vmapx_get_by_index(ns->p_sets_vmap, idx, (void**)&p_set) !=
+				CF_VMAPX_OK || ! p_set->hist_enabled) {
+			continue;
+		}
+
+		for (uint32_t t = 0; t < AS_SET_HIST_N_TYPES; t++) {
+			histogram_dump(p_set->hist->hists[t]);
+		}
+	}
+}
+
+void
+set_hist_insert(const as_transaction* tr, as_set_hist_type type)
+{
+	as_set* p_set = as_namespace_get_set_by_id(tr->rsv.ns, tr->set_id);
+
+	if (p_set == NULL || ! p_set->hist_enabled) {
+		return;
+	}
+
+	as_set_hist* sh = p_set->hist;
+
+	histogram_insert_data_point(sh->hists[type], tr->start_time);
+
+	as_set_hist_counts* counts = &sh->counts[thread_shard()];
+
+	as_incr_uint64(&counts->n_ops[type]);
+
+	switch (tr->result_code) {
+	case AS_OK:
+	case AS_ERR_NOT_FOUND:
+	case AS_ERR_FILTERED_OUT:
+		break;
+	default:
+		as_incr_uint64(&counts->n_errors[type]);
+		break;
+	}
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static as_set_hist*
+create_set_hist(const as_namespace* ns, const as_set* p_set)
+{
+	as_set_hist* sh = cf_calloc(1, sizeof(as_set_hist));
+	histogram_scale scale = as_config_histogram_scale();
+	char hist_name[HISTOGRAM_NAME_SIZE];
+
+	for (uint32_t t = 0; t < AS_SET_HIST_N_TYPES; t++) {
+		sprintf(hist_name, "{%s}-set-%s-%s", ns->name, p_set->name,
+				TYPE_NAMES[t]);
+		sh->hists[t] = histogram_create(hist_name, scale);
+	}
+
+	return sh;
+}
+
+// Spread threads round-robin over shards - threads sharing a shard still
+// increment atomically, but contention is divided by the shard count.
+static uint32_t
+thread_shard(void)
+{
+	if (g_shard == AS_SET_HIST_N_SHARDS) {
+		g_shard = as_faa_uint32(&g_next_shard, 1) & (AS_SET_HIST_N_SHARDS - 1);
+	}
+
+	return g_shard;
+}
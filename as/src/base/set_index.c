@@ -944,11 +944,11 @@ ssprig_reduce(ssprig_reduce_info* ssri, as_index_reduce_fn cb, void* udata)
 {
 	ssprig_info* ssi = (ssprig_info*)ssri;
 
-	cf_mutex_lock(ssri->olock);
+	as_index_olock_lock(ssri->olock);
 
 	// Very common to encounter empty sprigs - check again under lock.
 	if (*ssi->root == SENTINEL_H) {
-		cf_mutex_unlock(ssri->olock);
+		as_index_olock_unlock(ssri->olock);
 		return true;
 	}
 
@@ -962,7 +962,7 @@ ssprig_reduce(ssprig_reduce_info* ssri, as_index_reduce_fn cb, void* udata)
 	// Traverse just fills array, then we make callbacks afterwards.
 	ssprig_traverse(ssri, *ssi->root, &ph_a);
 
-	cf_mutex_unlock(ssri->olock);
+	as_index_olock_unlock(ssri->olock);
 
 	bool do_more = true;
 
@@ -974,7 +974,7 @@ ssprig_reduce(ssprig_reduce_info* ssri, as_index_reduce_fn cb, void* udata)
 				.olock = ssri->olock
 		};
 
-		cf_mutex_lock(r_ref.olock);
+		as_index_olock_lock(r_ref.olock);
 
 		uint16_t rc = as_index_release(r_ref.r);
 
@@ -993,7 +993,7 @@ ssprig_reduce(ssprig_reduce_info* ssri, as_index_reduce_fn cb, void* udata)
 				as_sindex_gc_record(ns, &r_ref);
 			}
 
-			cf_mutex_unlock(r_ref.olock);
+			as_index_olock_unlock(r_ref.olock);
 			continue;
 		}
 
@@ -1002,7 +1002,7 @@ ssprig_reduce(ssprig_reduce_info* ssri, as_index_reduce_fn cb, void* udata)
 			do_more = cb(&r_ref, udata);
 		}
 		else {
-			cf_mutex_unlock(r_ref.olock);
+			as_index_olock_unlock(r_ref.olock);
 		}
 	}
 
@@ -93,6 +93,7 @@ reraise_signal(int sig_num)
 {
 	if (getpid() == 1) {
 		cf_warning(AS_AS, "pid 1 received signal %d - exiting", sig_num);
+		cf_log_stop_async();
 		_exit(1);
 	}
 
@@ -167,6 +168,7 @@ as_sig_handle_int(int sig_num, siginfo_t *info, void *ctx)
 
 	if (! g_startup_complete) {
 		cf_warning(AS_AS, "startup was not complete, exiting immediately");
+		cf_log_stop_async();
 		_exit(1);
 	}
 
@@ -204,6 +206,7 @@ as_sig_handle_term(int sig_num, siginfo_t *info, void *ctx)
 
 	if (! g_startup_complete) {
 		cf_warning(AS_AS, "startup was not complete, exiting immediately");
+		cf_log_stop_async();
 		_exit(0);
 	}
 
@@ -240,6 +243,7 @@ as_signal_setup()
 	set_action(SIGTERM, as_sig_handle_term);
 	set_action(SIGUSR1, as_sig_handle_usr1);
 	set_action(SIGUSR2, cf_thread_traces_action);
+	set_action(SIGPROF, cf_thread_profile_action);
 
 	// Block SIGPIPE signal when there is some error while writing to pipe. The
 	// write() call will return with a normal error which we can handle.
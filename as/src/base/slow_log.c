@@ -0,0 +1,380 @@
+/*
+ * slow_log.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * Keeps the slowest N transactions of each tumbling window in a min-heap, so
+ * a new entry costs O(log N) and only transactions slower than the current
+ * minimum of a full heap take the lock. The last complete window is kept
+ * sorted, slowest first, for info.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "base/slow_log.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/cf_clock.h"
+#include "citrusleaf/cf_digest.h"
+
+#include "cf_mutex.h"
+#include "dynbuf.h"
+
+#include "base/cfg.h"
+#include "base/datamodel.h"
+#include "base/proto.h"
+#include "base/transaction.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define WINDOW_NS (10UL * 1000 * 1000 * 1000)
+
+typedef struct slow_txn_s {
+	as_namespace* ns;
+	cf_digest keyd;
+	uint64_t total_ns;
+	uint64_t queue_ns; // start to last dispatch - includes restarts
+	uint64_t local_ns; // dispatch to master done - includes dup-res
+	uint64_t repl_ns; // master done to response
+	uint32_t size;
+	uint32_t op_mask; // bit per AS_MSG_OP_* seen
+	uint16_t set_id;
+	uint16_t n_ops;
+	uint8_t type;
+	uint8_t result_code;
+} slow_txn;
+
+static const char* TYPE_NAMES[] = {
+		[AS_SLOW_LOG_READ] = "read",
+		[AS_SLOW_LOG_WRITE] = "write",
+		[AS_SLOW_LOG_UDF] = "udf",
+		[AS_SLOW_LOG_BATCH_SUB] = "batch-sub"
+};
+
+COMPILER_ASSERT(sizeof(TYPE_NAMES) / sizeof(const char*) ==
+		AS_SLOW_LOG_N_TYPES);
+
+static const char* OP_NAMES[] = {
+		[AS_MSG_OP_READ] = "read",
+		[AS_MSG_OP_WRITE] = "write",
+		[AS_MSG_OP_CDT_READ] = "cdt-read",
+		[AS_MSG_OP_CDT_MODIFY] = "cdt-modify",
+		[AS_MSG_OP_INCR] = "incr",
+		[AS_MSG_OP_EXP_READ] = "exp-read",
+		[AS_MSG_OP_EXP_MODIFY] = "exp-modify",
+		[AS_MSG_OP_APPEND] = "append",
+		[AS_MSG_OP_PREPEND] = "prepend",
+		[AS_MSG_OP_TOUCH] = "touch",
+		[AS_MSG_OP_BITS_READ] = "bits-read",
+		[AS_MSG_OP_BITS_MODIFY] = "bits-modify",
+		[AS_MSG_OP_DELETE_ALL] = "delete-all",
+		[AS_MSG_OP_HLL_READ] = "hll-read",
+		[AS_MSG_OP_HLL_MODIFY] = "hll-modify"
+};
+
+#define N_OP_NAMES (sizeof(OP_NAMES) / sizeof(const char*))
+
+
+//==========================================================
+// Globals.
+//
+
+static cf_mutex g_lock = CF_MUTEX_INIT;
+
+// Current window - a min-heap on total_ns.
+static uint64_t g_start_ns = 0;
+static uint32_t g_size = 0;
+static uint32_t g_n_txns = 0;
+static slow_txn g_txns[MAX_SLOW_LOG_SIZE];
+
+// Lock-free pre-check - minimum of a full heap, else 0. Only valid until the
+// window ends, so a fast new window isn't shut out by the last one's minimum.
+static uint64_t g_min_ns = 0;
+static uint64_t g_end_ns = 0;
+
+// Last complete window - sorted by total_ns, descending.
+static uint64_t g_last_duration_ns = 0;
+static uint32_t g_n_last_txns = 0;
+static slow_txn g_last_txns[MAX_SLOW_LOG_SIZE];
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void close_window(uint64_t now_ns, uint32_t size);
+static void fill_txn(slow_txn* txn, const as_transaction* tr, as_slow_log_type type, uint64_t now_ns);
+static void sift_down(uint32_t i);
+static void sift_up(uint32_t i);
+static int compare_totals(const void* pa, const void* pb);
+static void append_txn(const slow_txn* txn, cf_dyn_buf* db);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_slow_log_get(cf_dyn_buf* db)
+{
+	cf_mutex_lock(&g_lock);
+
+	uint64_t now_ns = cf_getns();
+
+	// Keep a quiet node from showing a stale window forever.
+	if (g_start_ns != 0 && now_ns - g_start_ns >= WINDOW_NS) {
+		close_window(now_ns, g_size);
+	}
+
+	cf_dyn_buf_append_string(db, "window-ms=");
+	cf_dyn_buf_append_uint64(db, g_last_duration_ns / 1000000);
+	cf_dyn_buf_append_char(db, ';');
+
+	for (uint32_t i = 0; i < g_n_last_txns; i++) {
+		append_txn(&g_last_txns[i], db);
+	}
+
+	cf_mutex_unlock(&g_lock);
+
+	cf_dyn_buf_chomp_char(db, ';');
+}
+
+void
+slow_log_insert(const as_transaction* tr, as_slow_log_type type)
+{
+	uint64_t now_ns = cf_getns();
+	uint64_t total_ns = now_ns - tr->start_time;
+
+	if (total_ns <= as_load_uint64(&g_min_ns) &&
+			now_ns < as_load_uint64(&g_end_ns)) {
+		return;
+	}
+
+	uint32_t size = as_load_uint32(&g_config.slow_transaction_log_size);
+
+	if (size == 0) {
+		return;
+	}
+
+	cf_mutex_lock(&g_lock);
+
+	if (g_start_ns == 0) {
+		g_start_ns = now_ns;
+		g_size = size;
+		as_store_uint64(&g_end_ns, now_ns + WINDOW_NS);
+	}
+	else if (now_ns - g_start_ns >= WINDOW_NS || size != g_size) {
+		close_window(now_ns, size);
+	}
+
+	if (g_n_txns < g_size) {
+		fill_txn(&g_txns[g_n_txns], tr, type, now_ns);
+		sift_up(g_n_txns++);
+	}
+	else if (total_ns > g_txns[0].total_ns) {
+		fill_txn(&g_txns[0], tr, type, now_ns);
+		sift_down(0);
+	}
+
+	as_store_uint64(&g_min_ns, g_n_txns == g_size ? g_txns[0].total_ns : 0);
+
+	cf_mutex_unlock(&g_lock);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+close_window(uint64_t now_ns, uint32_t size)
+{
+	memcpy(g_last_txns, g_txns, g_n_txns * sizeof(slow_txn));
+	qsort(g_last_txns, g_n_txns, sizeof(slow_txn), compare_totals);
+
+	g_last_duration_ns = now_ns - g_start_ns;
+	g_n_last_txns = g_n_txns;
+
+	g_start_ns = now_ns;
+	g_size = size;
+	g_n_txns = 0;
+
+	as_store_uint64(&g_min_ns, 0);
+	as_store_uint64(&g_end_ns, now_ns + WINDOW_NS);
+}
+
+static void
+fill_txn(slow_txn* txn, const as_transaction* tr, as_slow_log_type type,
+		uint64_t now_ns)
+{
+	const as_msg* m = &tr->msgp->msg;
+
+	txn->ns = tr->rsv.ns;
+	txn->keyd = tr->keyd;
+	txn->total_ns = now_ns - tr->start_time;
+
+	if (tr->dispatch_time != 0) {
+		uint64_t master_done = tr->master_done_time != 0 ?
+				tr->master_done_time : now_ns;
+
+		txn->queue_ns = tr->dispatch_time - tr->start_time;
+		txn->local_ns = master_done - tr->dispatch_time;
+		txn->repl_ns = now_ns - master_done;
+	}
+	else {
+		txn->queue_ns = 0;
+		txn->local_ns = 0;
+		txn->repl_ns = 0;
+	}
+
+	txn->size = (uint32_t)tr->msgp->proto.sz;
+	txn->op_mask = 0;
+	txn->set_id = tr->set_id;
+	txn->n_ops = m->n_ops;
+	txn->type = (uint8_t)type;
+	txn->result_code = tr->result_code;
+
+	as_msg_op* op = NULL;
+	uint16_t i;
+
+	while ((op = as_msg_op_iterate(m, op, &i)) != NULL) {
+		if (op->op < 32) {
+			txn->op_mask |= 1U << op->op;
+		}
+	}
+}
+
+static void
+sift_down(uint32_t i)
+{
+	while (true) {
+		uint32_t min = i;
+		uint32_t l = (2 * i) + 1;
+		uint32_t r = l + 1;
+
+		if (l < g_n_txns && g_txns[l].total_ns < g_txns[min].total_ns) {
+			min = l;
+		}
+
+		if (r < g_n_txns && g_txns[r].total_ns < g_txns[min].total_ns) {
+			min = r;
+		}
+
+		if (min == i) {
+			return;
+		}
+
+		slow_txn tmp = g_txns[i];
+
+		g_txns[i] = g_txns[min];
+		g_txns[min] = tmp;
+		i = min;
+	}
+}
+
+static void
+sift_up(uint32_t i)
+{
+	while (i != 0) {
+		uint32_t parent = (i - 1) / 2;
+
+		if (g_txns[parent].total_ns <= g_txns[i].total_ns) {
+			return;
+		}
+
+		slow_txn tmp = g_txns[i];
+
+		g_txns[i] = g_txns[parent];
+		g_txns[parent] = tmp;
+		i = parent;
+	}
+}
+
+static int
+compare_totals(const void* pa, const void* pb)
+{
+	uint64_t a = ((const slow_txn*)pa)->total_ns;
+	uint64_t b = ((const slow_txn*)pb)->total_ns;
+
+	return a > b ? -1 : (a < b ? 1 : 0);
+}
+
+static void
+append_txn(const slow_txn* txn, cf_dyn_buf* db)
+{
+	char digest_str[(sizeof(cf_digest) * 2) + 1];
+
+	for (uint32_t b = 0; b < sizeof(cf_digest); b++) {
+		sprintf(&digest_str[b * 2], "%02x", txn->keyd.digest[b]);
+	}
+
+	as_set* p_set = as_namespace_get_set_by_id(txn->ns, txn->set_id);
+
+	cf_dyn_buf_append_string(db, "ns=");
+	cf_dyn_buf_append_string(db, txn->ns->name);
+	cf_dyn_buf_append_string(db, ":set=");
+	cf_dyn_buf_append_string(db, p_set != NULL ? p_set->name : "");
+	cf_dyn_buf_append_string(db, ":digest=");
+	cf_dyn_buf_append_string(db, digest_str);
+	cf_dyn_buf_append_string(db, ":type=");
+	cf_dyn_buf_append_string(db, TYPE_NAMES[txn->type]);
+	cf_dyn_buf_append_string(db, ":ops=");
+
+	bool first = true;
+
+	for (uint32_t op = 0; op < N_OP_NAMES; op++) {
+		if ((txn->op_mask & (1U << op)) != 0 && OP_NAMES[op] != NULL) {
+			if (! first) {
+				cf_dyn_buf_append_char(db, ',');
+			}
+
+			cf_dyn_buf_append_string(db, OP_NAMES[op]);
+			first = false;
+		}
+	}
+
+	cf_dyn_buf_append_string(db, ":n_ops=");
+	cf_dyn_buf_append_uint32(db, txn->n_ops);
+	cf_dyn_buf_append_string(db, ":size=");
+	cf_dyn_buf_append_uint32(db, txn->size);
+	cf_dyn_buf_append_string(db, ":result=");
+	cf_dyn_buf_append_uint32(db, txn->result_code);
+	cf_dyn_buf_append_string(db, ":total_us=");
+	cf_dyn_buf_append_uint64(db, txn->total_ns / 1000);
+	cf_dyn_buf_append_string(db, ":queue_us=");
+	cf_dyn_buf_append_uint64(db, txn->queue_ns / 1000);
+	cf_dyn_buf_append_string(db, ":local_us=");
+	cf_dyn_buf_append_uint64(db, txn->local_ns / 1000);
+	cf_dyn_buf_append_string(db, ":repl_us=");
+	cf_dyn_buf_append_uint64(db, txn->repl_ns / 1000);
+	cf_dyn_buf_append_char(db, ';');
+}
@@ -89,6 +89,8 @@ typedef enum {
 	SMD_MSG_SINGLE_TIMESTAMP,
 
 	SMD_MSG_COMMITTED_CL_KEY,
+	SMD_MSG_DELTA_OK,
+	SMD_MSG_BASE_TID,
 
 	NUM_SMD_FIELDS
 } smd_msg_fields;
@@ -119,7 +121,9 @@ static const msg_template smd_mt[] = {
 		{ SMD_MSG_SINGLE_GENERATION, M_FT_UINT32 },
 		{ SMD_MSG_SINGLE_TIMESTAMP, M_FT_UINT64 },
 
-		{ SMD_MSG_COMMITTED_CL_KEY, M_FT_UINT64 }
+		{ SMD_MSG_COMMITTED_CL_KEY, M_FT_UINT64 },
+		{ SMD_MSG_DELTA_OK, M_FT_UINT32 },
+		{ SMD_MSG_BASE_TID, M_FT_UINT64 }
 };
 
 COMPILER_ASSERT(sizeof(smd_mt) / sizeof(msg_template) == NUM_SMD_FIELDS);
@@ -142,6 +146,8 @@ typedef enum {
 	SMD_OP_SET_ACK,
 	SMD_OP_SET_NACK,
 
+	SMD_OP_DELTA_FROM_PR,
+
 	// Must be last - these are internal ops and don't go on the wire.
 	SMD_OP_CLUSTER_CHANGED,
 	SMD_OP_START_SET,
@@ -164,6 +170,8 @@ static const char* const op_type_str[] = {
 		[SMD_OP_SET_ACK] = "set-ack",
 		[SMD_OP_SET_NACK] = "set-nack",
 
+		[SMD_OP_DELTA_FROM_PR] = "delta-from-pr",
+
 		[SMD_OP_CLUSTER_CHANGED] = "cluster-changed",
 		[SMD_OP_START_SET] = "start-set"
 };
@@ -229,6 +237,7 @@ typedef struct smd_module_s {
 
 	smd_hash db_h; // key is (char*), value is uint32_t
 	cf_vector db;
+	cf_vector db_tids; // parallel to db - cv_tid at which item last changed
 
 	bool in_use; // EE modules may not be in use
 
@@ -238,6 +247,7 @@ typedef struct smd_module_s {
 	msg* retry_msgs[AS_CLUSTER_SZ];
 
 	uint64_t merge_tids[AS_CLUSTER_SZ];
+	bool merge_delta_ok[AS_CLUSTER_SZ];
 	smd_hash merge_h;
 	cf_vector merge;
 
@@ -250,6 +260,8 @@ typedef struct smd_module_s {
 
 	uint64_t next_save_time_sec;
 	uint32_t save_throttle_sec;
+
+	uint64_t commit_due_ms; // 0 means nothing pending
 } smd_module;
 
 typedef struct smd_op_s {
@@ -264,6 +276,7 @@ typedef struct smd_op_s {
 	uint64_t committed_key;
 
 	uint64_t tid;
+	uint64_t base_tid; // for delta from principal
 
 	cf_vector items;
 
@@ -271,9 +284,10 @@ typedef struct smd_op_s {
 	uint32_t node_count;
 	cf_node* succession;
 
-	// For report all versions events.
+	// For report version events.
 	uint32_t version_count;
 	uint64_t* version_list;
+	bool delta_ok;
 
 	// For originator of set operations.
 	as_smd_set_fn set_cb;
@@ -312,6 +326,7 @@ static const char smd_empty_value[] = "";
 
 #define REPORT_VER_DELAY_US 50000 // 50 milliseconds
 #define SMD_RETRY_MS 3000 // 3 seconds
+#define COMMIT_DELAY_MS 100 // coalesce bursts of changes into one file write
 
 #define DEFAULT_SET_TIMEOUT_MS 2000 // 2 seconds
 #define SET_RETRY_MS 100
@@ -356,6 +371,7 @@ static bool smd_msg_parse_items(msg* m, smd_op* op);
 // Event loop.
 static void* run_smd(void* udata);
 static int pr_try_retransmit(void);
+static int commit_try_flush(void);
 static int set_orig_try_retransmit_or_expire(void);
 static int set_orig_reduce_cb(const void* key, void* value, void* udata);
 static void smd_event(smd_op* op);
@@ -374,6 +390,7 @@ static void op_set_from_pr(smd_op* op);
 static void op_req_ver_from_pr(smd_op* op);
 static void op_full_from_pr(smd_op* op);
 static void op_req_full_from_pr(smd_op* op);
+static void op_delta_from_pr(smd_op* op);
 static void op_finish_set(smd_op* op, bool success);
 
 // Pending set queue.
@@ -384,7 +401,7 @@ static int pending_set_q_reduce_cb(void* ptr, void* udata);
 static void send_set_from_pr(smd_module* module, const as_smd_item* item);
 static void send_full_from_pr(smd_module* module);
 static void send_report_all_ver_to_pr(void);
-static void send_report_ver_to_pr(smd_module* module);
+static void send_report_ver_to_pr(smd_module* module, bool delta_ok);
 static void send_ack_to_pr(smd_op* op);
 static void send_set_reply(smd_module* module, bool success);
 static void send_set_from_orig(uint32_t set_tid, smd_set_entry* entry);
@@ -394,6 +411,7 @@ static void pr_send_msgs(smd_module* module);
 static void pr_set_retry_msg(smd_module* module, msg* m);
 static bool pr_mark_reply(smd_op* op, smd_state state);
 static void pr_clear_retry_msgs(smd_module* module);
+static void pr_send_full_to_npr(smd_module* module, uint32_t node_index);
 
 // Call module accept_cb.
 static void module_accept_item(smd_module* module, const as_smd_item* item);
@@ -403,12 +421,17 @@ static void module_accept_startup(smd_module* module);
 // Module.
 static void module_regen_key2index(smd_module* module);
 static void module_append_item(smd_module* module, as_smd_item* item);
+static void module_set_item_tid(smd_module* module, uint32_t ix);
+static void module_reset_item_tids(smd_module* module);
 static void module_fill_msg(smd_module* module, msg* m);
+static void module_fill_msg_items(smd_module* module, msg* m, const uint32_t* ixs, uint32_t count);
+static msg* module_create_delta_msg(smd_module* module, uint64_t base_tid);
 static void module_merge_list(smd_module* module, cf_vector* list);
 static void module_set_npr(smd_module* module, as_smd_item* item);
 static const as_smd_item* module_set_pr(smd_module* module, char* key, char* value);
 static void module_restore_from_disk(smd_module* module);
 static void module_commit_to_disk(smd_module* module);
+static void module_write_to_disk(smd_module* module);
 static void module_set_default_items(smd_module* module, const cf_vector* default_items);
 
 // Hash.
@@ -610,6 +633,8 @@ as_smd_module_load(as_smd_id id, as_smd_accept_fn accept_cb,
 	smd_hash_init(&module->db_h);
 	smd_hash_init(&module->merge_h);
 
+	cf_vector_init(&module->db_tids, sizeof(uint64_t), 16, 0);
+
 	module->id = id;
 	module->in_use = true;
 
@@ -647,6 +672,14 @@ as_smd_shutdown(void)
 {
 	smd_lock();
 
+	for (uint32_t i = 0; i < AS_SMD_NUM_MODULES; i++) {
+		smd_module* module = smd_get_module((as_smd_id)i);
+
+		if (module->in_use && module->commit_due_ms != 0) {
+			module_write_to_disk(module);
+		}
+	}
+
 	cf_info(AS_SMD, "SMD module shut down");
 }
 
@@ -831,6 +864,12 @@ smd_msg_parse(msg* m, smd_op* op)
 		return false;
 	}
 
+	uint32_t delta_ok = 0;
+
+	// Note - older nodes don't send this, and can't take deltas.
+	msg_get_uint32(m, SMD_MSG_DELTA_OK, &delta_ok);
+	op->delta_ok = delta_ok != 0;
+
 	if (op->type == SMD_OP_REPORT_ALL_VERS_TO_PR) {
 		uint32_t count = (AS_SMD_NUM_MODULES + NUM_FUTURE_MODULES) * 3;
 		uint64_t versions[count];
@@ -931,6 +970,22 @@ smd_msg_parse(msg* m, smd_op* op)
 		}
 		return true;
 
+	case SMD_OP_DELTA_FROM_PR:
+		if (msg_get_uint64(m, SMD_MSG_COMMITTED_CL_KEY,
+				&op->committed_key) != 0) {
+			cf_warning(AS_SMD, "msg missing committed cluster key");
+			return false;
+		}
+		if (msg_get_uint64(m, SMD_MSG_TID, &op->tid) != 0) {
+			cf_warning(AS_SMD, "msg missing tid");
+			return false;
+		}
+		if (msg_get_uint64(m, SMD_MSG_BASE_TID, &op->base_tid) != 0) {
+			cf_warning(AS_SMD, "msg missing base tid");
+			return false;
+		}
+		return smd_msg_parse_items(m, op);
+
 	default:
 		cf_warning(AS_SMD, "invalid type %d", op->type);
 		break;
@@ -1050,6 +1105,12 @@ run_smd(void* udata)
 			}
 		}
 
+		int commit_wait_ms = commit_try_flush();
+
+		if (commit_wait_ms < wait_ms) {
+			wait_ms = commit_wait_ms;
+		}
+
 		if (op == NULL) {
 			cf_queue_pop(&g_smd.event_q, &op,
 					wait_ms == INT_MAX ? CF_QUEUE_FOREVER : wait_ms);
@@ -1092,6 +1153,36 @@ pr_try_retransmit(void)
 	return next_ms == UINT64_MAX ? INT_MAX : (int)(next_ms - now_ms);
 }
 
+static int
+commit_try_flush(void)
+{
+	uint64_t next_ms = UINT64_MAX;
+	uint64_t now_ms = cf_getms();
+
+	smd_lock(); // serialize with shutdown's final flush
+
+	for (uint32_t i = 0; i < AS_SMD_NUM_MODULES; i++) {
+		smd_module* module = smd_get_module((as_smd_id)i);
+
+		if (! module->in_use || module->commit_due_ms == 0) {
+			continue;
+		}
+
+		if (module->commit_due_ms <= now_ms) {
+			module_write_to_disk(module);
+			continue;
+		}
+
+		if (module->commit_due_ms < next_ms) {
+			next_ms = module->commit_due_ms;
+		}
+	}
+
+	smd_unlock();
+
+	return next_ms == UINT64_MAX ? INT_MAX : (int)(next_ms - now_ms);
+}
+
 static int
 set_orig_try_retransmit_or_expire(void)
 {
@@ -1213,6 +1304,10 @@ smd_event(smd_op* op)
 		op_finish_set(op, false);
 		break;
 
+	case SMD_OP_DELTA_FROM_PR:
+		op_delta_from_pr(op);
+		break;
+
 	default:
 		cf_ticker_warning(AS_SMD, "invalid op %d", op->type);
 		break;
@@ -1418,7 +1513,8 @@ op_report_all_vers_to_pr(smd_op* op)
 				.node_index = op->node_index,
 				.module = module,
 				.committed_key = cv_key,
-				.tid = cv_tid
+				.tid = cv_tid,
+				.delta_ok = op->delta_ok
 		};
 
 		op_report_ver_to_pr(&module_op);
@@ -1430,6 +1526,15 @@ op_report_ver_to_pr(smd_op* op)
 {
 	smd_module* module = op->module;
 
+	if (module->state == STATE_CLEAN && ! op->delta_ok &&
+			module->merge_delta_ok[op->node_index]) {
+		OP_DETAIL("node %u rejected delta - sending full", op->node_index);
+
+		module->merge_delta_ok[op->node_index] = false;
+		pr_send_full_to_npr(module, op->node_index);
+		return;
+	}
+
 	if (! pr_mark_reply(op, STATE_MERGING)) {
 		return;
 	}
@@ -1440,6 +1545,7 @@ op_report_ver_to_pr(smd_op* op)
 			(op->committed_key == 0 && op->tid == 0)) {
 		// Note - committed_key is zero on older nodes.
 		module->merge_tids[op->node_index] = op->tid;
+		module->merge_delta_ok[op->node_index] = op->delta_ok;
 	}
 	else {
 		pr_clear_retry_msgs(module);
@@ -1501,26 +1607,61 @@ op_report_ver_to_pr(smd_op* op)
 
 	module->state = STATE_CLEAN;
 
-	msg* full = as_fabric_msg_get(M_TYPE_SMD);
-
-	msg_set_uint32(full, SMD_MSG_OP, SMD_OP_FULL_FROM_PR);
-	module_fill_msg(module, full);
+	// Nodes that are only behind on tids get just the items changed since
+	// their tid. Nodes typically share a tid, so reuse the last delta built.
+	msg* full = NULL;
+	msg* delta = NULL;
+	uint64_t delta_base_tid = UINT64_MAX;
 
 	module->retry_msg_count = 0;
 	module->retry_msgs[0] = NULL;
 
 	for (uint32_t i = 1; i < g_smd.node_count; i++) {
+		module->retry_msgs[i] = NULL;
+
 		if (! npr_is_dirty[i]) {
-			module->retry_msgs[i] = NULL;
+			continue;
 		}
-		else {
-			msg_incr_ref(full);
-			module->retry_msgs[i] = full;
-			module->retry_msg_count++;
+
+		msg* m = NULL;
+
+		if (module->merge_delta_ok[i]) {
+			if (module->merge_tids[i] != delta_base_tid) {
+				if (delta != NULL) {
+					as_fabric_msg_put(delta);
+				}
+
+				delta_base_tid = module->merge_tids[i];
+				delta = module_create_delta_msg(module, delta_base_tid);
+			}
+
+			m = delta; // NULL if delta would be no smaller than full
+		}
+
+		if (m == NULL) {
+			if (full == NULL) {
+				full = as_fabric_msg_get(M_TYPE_SMD);
+
+				msg_set_uint32(full, SMD_MSG_OP, SMD_OP_FULL_FROM_PR);
+				module_fill_msg(module, full);
+			}
+
+			module->merge_delta_ok[i] = false;
+			m = full;
 		}
+
+		msg_incr_ref(m);
+		module->retry_msgs[i] = m;
+		module->retry_msg_count++;
 	}
 
-	as_fabric_msg_put(full);
+	if (full != NULL) {
+		as_fabric_msg_put(full);
+	}
+
+	if (delta != NULL) {
+		as_fabric_msg_put(delta);
+	}
 
 	pr_send_msgs(module);
 }
@@ -1562,6 +1703,7 @@ op_full_to_pr(smd_op* op)
 	module->cv_tid = 1;
 	module->cv_key = g_smd.cl_key;
 
+	module_reset_item_tids(module);
 	module_commit_to_disk(module);
 	send_full_from_pr(module);
 
@@ -1642,7 +1784,7 @@ op_req_ver_from_pr(smd_op* op)
 		return;
 	}
 
-	send_report_ver_to_pr(module);
+	send_report_ver_to_pr(module, true);
 }
 
 static void
@@ -1697,6 +1839,7 @@ op_full_from_pr(smd_op* op)
 	item_vec_handoff(&module->db, &op->items);
 
 	module_regen_key2index(module);
+	module_reset_item_tids(module);
 
 	module_commit_to_disk(module);
 }
@@ -1723,6 +1866,75 @@ op_req_full_from_pr(smd_op* op)
 	}
 }
 
+static void
+op_delta_from_pr(smd_op* op)
+{
+	smd_module* module = op->module;
+
+	if (module->state != STATE_NPR) {
+		return;
+	}
+
+	if (op->node_index != 0) {
+		cf_warning(AS_SMD, "set delta not from principal - src %lx", op->src);
+		return;
+	}
+
+	if (op->committed_key == module->cv_key && op->tid == module->cv_tid) {
+		send_ack_to_pr(op);
+		return; // normal on retransmits
+	}
+
+	if (op->committed_key != module->cv_key ||
+			op->base_tid != module->cv_tid) {
+		OP_DETAIL("base %lx-%lu mismatch - requesting full",
+				op->committed_key, op->base_tid);
+		send_report_ver_to_pr(module, false);
+		return;
+	}
+
+	module->cv_tid = op->tid;
+
+	OP_DETAIL("applying %u items", cf_vector_size(&op->items));
+
+	cf_vector accept_list;
+	item_vec_init(&accept_list, cf_vector_size(&op->items));
+
+	for (uint32_t i = 0; i < cf_vector_size(&op->items); i++) {
+		as_smd_item* new_item = item_vec_get(&op->items, i);
+		uint32_t ix;
+
+		if (! smd_hash_get(&module->db_h, new_item->key, &ix)) { // new key
+			module_append_item(module, new_item);
+		}
+		else {
+			const as_smd_item* item = item_vec_get_const(&module->db, ix);
+
+			if (new_item->generation == item->generation &&
+					new_item->timestamp == item->timestamp) {
+				continue;
+			}
+
+			item_vec_replace(&module->db, ix, new_item);
+			module_set_item_tid(module, ix);
+		}
+
+		item_vec_set(&op->items, i, NULL);
+		item_vec_append(&accept_list, new_item);
+	}
+
+	if (cf_vector_size(&accept_list) != 0) {
+		module_accept_list(module, &accept_list);
+	}
+
+	item_vec_disown_items(&accept_list);
+	item_vec_destroy(&accept_list);
+
+	module_commit_to_disk(module);
+
+	send_ack_to_pr(op); // last, so items are accepted before principal moves on
+}
+
 static void
 op_finish_set(smd_op* op, bool success)
 {
@@ -1795,6 +2007,12 @@ send_set_from_pr(smd_module* module, const as_smd_item* item)
 	module->cv_key = g_smd.cl_key;
 	module->cv_tid++;
 
+	uint32_t ix;
+
+	if (smd_hash_get(&module->db_h, item->key, &ix)) {
+		module_set_item_tid(module, ix);
+	}
+
 	msg* m = as_fabric_msg_get(M_TYPE_SMD);
 
 	msg_set_uint32(m, SMD_MSG_OP, SMD_OP_SET_FROM_PR);
@@ -1850,6 +2068,7 @@ send_report_all_ver_to_pr(void)
 	}
 
 	msg_msgpack_list_set_uint64(m, SMD_MSG_VERSION_LIST, versions, count);
+	msg_set_uint32(m, SMD_MSG_DELTA_OK, 1);
 
 	if (as_fabric_send(g_smd.succession[0], m, AS_FABRIC_CHANNEL_META) !=
 			AS_FABRIC_SUCCESS) {
@@ -1858,7 +2077,7 @@ send_report_all_ver_to_pr(void)
 }
 
 static void
-send_report_ver_to_pr(smd_module* module)
+send_report_ver_to_pr(smd_module* module, bool delta_ok)
 {
 	msg* m = as_fabric_msg_get(M_TYPE_SMD);
 
@@ -1870,6 +2089,9 @@ send_report_ver_to_pr(smd_module* module)
 	msg_set_uint64(m, SMD_MSG_COMMITTED_CL_KEY, module->cv_key);
 	msg_set_uint64(m, SMD_MSG_TID, module->cv_tid);
 
+	// False means a delta didn't apply - principal will send everything.
+	msg_set_uint32(m, SMD_MSG_DELTA_OK, delta_ok ? 1 : 0);
+
 	if (as_fabric_send(g_smd.succession[0], m, AS_FABRIC_CHANNEL_META) !=
 			AS_FABRIC_SUCCESS) {
 		as_fabric_msg_put(m);
@@ -2054,6 +2276,29 @@ pr_clear_retry_msgs(smd_module* module)
 	module->retry_next_ms = 0;
 }
 
+static void
+pr_send_full_to_npr(smd_module* module, uint32_t node_index)
+{
+	if (module->retry_msgs[node_index] == NULL) {
+		return; // already acked - stale report
+	}
+
+	msg* m = as_fabric_msg_get(M_TYPE_SMD);
+
+	msg_set_uint32(m, SMD_MSG_OP, SMD_OP_FULL_FROM_PR);
+	module_fill_msg(module, m);
+
+	as_fabric_msg_put(module->retry_msgs[node_index]);
+	module->retry_msgs[node_index] = m;
+
+	msg_incr_ref(m);
+
+	if (as_fabric_send(g_smd.succession[node_index], m,
+			AS_FABRIC_CHANNEL_META) != AS_FABRIC_SUCCESS) {
+		as_fabric_msg_put(m);
+	}
+}
+
 
 //==========================================================
 // Local helpers - call module accept_cb.
@@ -2117,10 +2362,37 @@ module_append_item(smd_module* module, as_smd_item* item)
 {
 	smd_hash_put(&module->db_h, item->key, cf_vector_size(&module->db));
 	item_vec_append(&module->db, item);
+	cf_vector_append(&module->db_tids, &module->cv_tid);
+}
+
+static void
+module_set_item_tid(smd_module* module, uint32_t ix)
+{
+	cf_vector_set(&module->db_tids, ix, &module->cv_tid);
+}
+
+// Used when we can't know which items changed when - treat all as changed
+// now, so deltas built from here on include them.
+static void
+module_reset_item_tids(smd_module* module)
+{
+	cf_vector_clear(&module->db_tids);
+
+	for (uint32_t i = 0; i < cf_vector_size(&module->db); i++) {
+		cf_vector_append(&module->db_tids, &module->cv_tid);
+	}
 }
 
 static void
 module_fill_msg(smd_module* module, msg* m)
+{
+	module_fill_msg_items(module, m, NULL, cf_vector_size(&module->db));
+}
+
+// If ixs is NULL, fill the first count items, i.e. all of them.
+static void
+module_fill_msg_items(smd_module* module, msg* m, const uint32_t* ixs,
+		uint32_t count)
 {
 	msg_set_uint64(m, SMD_MSG_CLUSTER_KEY, g_smd.cl_key);
 
@@ -2129,8 +2401,6 @@ module_fill_msg(smd_module* module, msg* m)
 	msg_set_uint64(m, SMD_MSG_COMMITTED_CL_KEY, module->cv_key);
 	msg_set_uint64(m, SMD_MSG_TID, module->cv_tid);
 
-	uint32_t count = cf_vector_size(&module->db);
-
 	cf_vector_define(key_vec, sizeof(msg_buf_ele), count, 0);
 	cf_vector_define(val_vec, sizeof(msg_buf_ele), count, 0);
 	uint32_t gen_list[count];
@@ -2138,7 +2408,8 @@ module_fill_msg(smd_module* module, msg* m)
 	msg_set_uint64_array_size(m, SMD_MSG_TS_ARRAY, count);
 
 	for (uint32_t i = 0; i < count; i++) {
-		const as_smd_item* item = item_vec_get_const(&module->db, i);
+		const as_smd_item* item = item_vec_get_const(&module->db,
+				ixs == NULL ? i : ixs[i]);
 
 		msg_buf_ele key_e = {
 				.sz = (uint32_t)strlen(item->key),
@@ -2163,6 +2434,36 @@ module_fill_msg(smd_module* module, msg* m)
 	msg_msgpack_list_set_uint32(m, SMD_MSG_GEN_LIST, gen_list, count);
 }
 
+// Returns NULL if the delta would be no smaller than half the full set.
+static msg*
+module_create_delta_msg(smd_module* module, uint64_t base_tid)
+{
+	uint32_t n_items = cf_vector_size(&module->db);
+	uint32_t ixs[n_items + 1];
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < n_items; i++) {
+		if (*(uint64_t*)cf_vector_getp(&module->db_tids, i) > base_tid) {
+			ixs[count++] = i;
+		}
+	}
+
+	if (count * 2 > n_items) {
+		return NULL;
+	}
+
+	cf_detail(AS_SMD, "{%s} delta from tid %lu - %u of %u items",
+			MODULE_AS_STRING(module), base_tid, count, n_items);
+
+	msg* m = as_fabric_msg_get(M_TYPE_SMD);
+
+	msg_set_uint32(m, SMD_MSG_OP, SMD_OP_DELTA_FROM_PR);
+	msg_set_uint64(m, SMD_MSG_BASE_TID, base_tid);
+	module_fill_msg_items(module, m, ixs, count);
+
+	return m;
+}
+
 static void
 module_merge_list(smd_module* module, cf_vector* list)
 {
@@ -2229,6 +2530,7 @@ module_set_npr(smd_module* module, as_smd_item* item)
 		OP_TYPE_DETAIL(SMD_OP_SET_FROM_PR, "key %s", item->key);
 
 		item_vec_replace(&module->db, ix, item);
+		module_set_item_tid(module, ix);
 
 		module_commit_to_disk(module);
 		module_accept_item(module, item);
@@ -2407,11 +2709,23 @@ module_restore_from_disk(smd_module* module)
 
 	json_decref(j_file);
 	module_regen_key2index(module);
+	module_reset_item_tids(module);
 }
 
+// Coalesce bursts of changes - the event loop writes the file when due.
 static void
 module_commit_to_disk(smd_module* module)
 {
+	if (module->commit_due_ms == 0) {
+		module->commit_due_ms = cf_getms() + COMMIT_DELAY_MS;
+	}
+}
+
+static void
+module_write_to_disk(smd_module* module)
+{
+	module->commit_due_ms = 0;
+
 	if (module->save_throttle_sec != 0) {
 		cf_clock now = cf_get_seconds();
 
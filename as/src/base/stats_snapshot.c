@@ -0,0 +1,416 @@
+/*
+ * stats_snapshot.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "base/stats_snapshot.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/cf_clock.h"
+
+#include "dynbuf.h"
+#include "log.h"
+
+#include "base/cfg.h"
+#include "base/datamodel.h"
+#include "base/thr_info.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define FILE_NAME "stats.snapshot"
+#define FILE_SZ (AS_STATS_SNAPSHOT_HDR_SZ + (2 * AS_STATS_SNAPSHOT_SLOT_SZ))
+
+#define MAX_READ_TRIES 8
+
+COMPILER_ASSERT(sizeof(as_stats_snapshot_hdr) <= AS_STATS_SNAPSHOT_HDR_SZ);
+COMPILER_ASSERT(sizeof(as_stats_snapshot_slot) % 8 == 0);
+
+
+//==========================================================
+// Globals.
+//
+
+static as_stats_snapshot_hdr* g_hdr = NULL;
+static uint64_t g_last_publish_ns = 0;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static as_stats_snapshot_slot* slot_at(uint64_t seq);
+static void fill_slot(as_stats_snapshot_slot* slot);
+static void add_section(as_stats_snapshot_slot* slot, char* line);
+static void add_entry(as_stats_snapshot_slot* slot, const char* section, const char* key, const char* value);
+static bool parse_value(const char* value, as_stats_snapshot_entry* e);
+static bool append_slot(const as_stats_snapshot_slot* slot, cf_dyn_buf* db);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_stats_snapshot_init(void)
+{
+	if (g_config.stats_snapshot_period == 0) {
+		return;
+	}
+
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s", g_config.work_directory, FILE_NAME);
+
+	// Don't truncate in place - readers still mapping a previous incarnation's
+	// file would fault.
+	if (unlink(path) != 0 && errno != ENOENT) {
+		cf_crash_nostack(AS_INFO, "failed to remove old %s: %s", path,
+				cf_strerror(errno));
+	}
+
+	int fd = open(path, O_RDWR | O_CREAT | O_EXCL,
+			S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+	if (fd == -1) {
+		cf_crash_nostack(AS_INFO, "failed to create %s: %s", path,
+				cf_strerror(errno));
+	}
+
+	if (ftruncate(fd, FILE_SZ) != 0) {
+		cf_crash_nostack(AS_INFO, "failed to size %s: %s", path,
+				cf_strerror(errno));
+	}
+
+	void* mem = mmap(NULL, FILE_SZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (mem == MAP_FAILED) {
+		cf_crash_nostack(AS_INFO, "failed to map %s: %s", path,
+				cf_strerror(errno));
+	}
+
+	close(fd);
+
+	g_hdr = (as_stats_snapshot_hdr*)mem;
+
+	g_hdr->slot_offset = AS_STATS_SNAPSHOT_HDR_SZ;
+	g_hdr->slot_sz = AS_STATS_SNAPSHOT_SLOT_SZ;
+	g_hdr->version = AS_STATS_SNAPSHOT_VERSION;
+	g_hdr->seq = 0;
+
+	as_fence_rls();
+	as_store_uint32(&g_hdr->magic, AS_STATS_SNAPSHOT_MAGIC);
+
+	cf_info(AS_INFO, "publishing stats snapshot every %u seconds to %s",
+			g_config.stats_snapshot_period, path);
+}
+
+// Called by the ticker thread (the only writer) every second.
+void
+as_stats_snapshot_update(uint64_t now_ns)
+{
+	if (g_hdr == NULL || (g_last_publish_ns != 0 &&
+			now_ns - g_last_publish_ns <
+					(uint64_t)g_config.stats_snapshot_period * 1000000000)) {
+		return;
+	}
+
+	g_last_publish_ns = now_ns;
+
+	uint64_t seq = g_hdr->seq + 1;
+	as_stats_snapshot_slot* slot = slot_at(seq);
+
+	fill_slot(slot);
+	slot->seq = seq;
+
+	as_fence_rls();
+	as_store_uint64(&g_hdr->seq, seq);
+}
+
+void
+as_stats_snapshot_get(cf_dyn_buf* db)
+{
+	if (g_hdr == NULL) {
+		cf_dyn_buf_append_string(db, "ERROR::stats-snapshot-disabled");
+		return;
+	}
+
+	size_t start_sz = db->used_sz;
+
+	for (uint32_t i = 0; i < MAX_READ_TRIES; i++) {
+		uint64_t seq = as_load_uint64(&g_hdr->seq);
+
+		as_fence_acq();
+
+		if (seq == 0) {
+			info_append_uint64(db, "seq", 0);
+			cf_dyn_buf_chomp_char(db, ';');
+			return;
+		}
+
+		bool ok = append_slot(slot_at(seq), db);
+
+		as_fence_acq();
+
+		if (ok && as_load_uint64(&g_hdr->seq) == seq) {
+			cf_dyn_buf_chomp_char(db, ';');
+			return;
+		}
+
+		db->used_sz = start_sz; // writer lapped us - retry
+	}
+
+	cf_dyn_buf_append_string(db, "ERROR::stats-snapshot-busy");
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static as_stats_snapshot_slot*
+slot_at(uint64_t seq)
+{
+	return (as_stats_snapshot_slot*)((uint8_t*)g_hdr + g_hdr->slot_offset +
+			((seq & 1) * g_hdr->slot_sz));
+}
+
+static void
+fill_slot(as_stats_snapshot_slot* slot)
+{
+	cf_dyn_buf_define(req);
+
+	cf_dyn_buf_append_string(&req, "statistics\n");
+
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		cf_dyn_buf_append_string(&req, "namespace/");
+		cf_dyn_buf_append_string(&req, g_config.namespaces[ns_ix]->name);
+		cf_dyn_buf_append_char(&req, '\n');
+	}
+
+	cf_dyn_buf_define_size(rsp, 128 * 1024);
+
+	as_info_buffer(req.buf, req.used_sz, &rsp);
+	cf_dyn_buf_append_char(&rsp, '\0');
+
+	slot->clepoch_ms = cf_clepoch_milliseconds();
+	slot->n_entries = 0;
+	slot->used_sz = (uint32_t)sizeof(as_stats_snapshot_slot);
+	slot->flags = 0;
+	slot->unused = 0;
+
+	char* line = (char*)rsp.buf;
+	char* eol;
+
+	while ((eol = strchr(line, '\n')) != NULL) {
+		*eol = '\0';
+		add_section(slot, line);
+		line = eol + 1;
+	}
+
+	cf_dyn_buf_free(&req);
+	cf_dyn_buf_free(&rsp);
+}
+
+static void
+add_section(as_stats_snapshot_slot* slot, char* line)
+{
+	char* value = strchr(line, '\t');
+
+	if (value == NULL) {
+		return;
+	}
+
+	*value++ = '\0';
+
+	char* save_ptr = NULL;
+	char* pair;
+
+	while ((pair = strtok_r(value, ";", &save_ptr)) != NULL) {
+		value = NULL;
+
+		char* eq = strchr(pair, '=');
+
+		if (eq == NULL) {
+			continue;
+		}
+
+		*eq = '\0';
+		add_entry(slot, line, pair, eq + 1);
+	}
+}
+
+static void
+add_entry(as_stats_snapshot_slot* slot, const char* section, const char* key,
+		const char* value)
+{
+	size_t section_len = strlen(section);
+	size_t name_len = section_len + 1 + strlen(key);
+
+	if (name_len > UINT8_MAX) {
+		return;
+	}
+
+	as_stats_snapshot_entry e;
+
+	if (! parse_value(value, &e)) {
+		return; // not numeric - skip
+	}
+
+	uint32_t entry_sz = (uint32_t)(offsetof(as_stats_snapshot_entry, name) +
+			name_len + 1 + 7) & ~7U;
+
+	if (slot->used_sz + entry_sz > AS_STATS_SNAPSHOT_SLOT_SZ) {
+		slot->flags |= AS_STATS_SNAPSHOT_TRUNCATED;
+		return;
+	}
+
+	as_stats_snapshot_entry* dst =
+			(as_stats_snapshot_entry*)((uint8_t*)slot + slot->used_sz);
+
+	dst->value = e.value;
+	dst->type = e.type;
+	dst->name_len = (uint8_t)name_len;
+	dst->entry_sz = (uint16_t)entry_sz;
+
+	memcpy(dst->name, section, section_len);
+	dst->name[section_len] = '/';
+	strcpy(dst->name + section_len + 1, key);
+
+	slot->used_sz += entry_sz;
+	slot->n_entries++;
+}
+
+static bool
+parse_value(const char* value, as_stats_snapshot_entry* e)
+{
+	if (strcmp(value, "true") == 0 || strcmp(value, "false") == 0) {
+		e->type = AS_STATS_SNAPSHOT_BOOL;
+		e->value.u64 = value[0] == 't' ? 1 : 0;
+		return true;
+	}
+
+	bool negative = value[0] == '-';
+
+	if (! isdigit((unsigned char)value[negative ? 1 : 0])) {
+		return false;
+	}
+
+	char* end;
+
+	errno = 0;
+
+	if (negative) {
+		e->value.i64 = strtoll(value, &end, 10);
+		e->type = AS_STATS_SNAPSHOT_INT64;
+	}
+	else {
+		e->value.u64 = strtoull(value, &end, 10);
+		e->type = AS_STATS_SNAPSHOT_UINT64;
+	}
+
+	if (*end == '\0' && errno == 0) {
+		return true;
+	}
+
+	errno = 0;
+	e->value.d = strtod(value, &end);
+	e->type = AS_STATS_SNAPSHOT_DOUBLE;
+
+	return *end == '\0' && errno == 0 && isfinite(e->value.d);
+}
+
+// Reads a slot the writer may be lapping - bounds-check everything so a torn
+// read only costs a retry.
+static bool
+append_slot(const as_stats_snapshot_slot* slot, cf_dyn_buf* db)
+{
+	uint32_t used_sz = as_load_uint32(&slot->used_sz);
+
+	if (used_sz < sizeof(as_stats_snapshot_slot) ||
+			used_sz > AS_STATS_SNAPSHOT_SLOT_SZ) {
+		return false;
+	}
+
+	info_append_uint64(db, "seq", slot->seq);
+	info_append_uint64(db, "clepoch-ms", slot->clepoch_ms);
+	info_append_bool(db, "truncated",
+			(slot->flags & AS_STATS_SNAPSHOT_TRUNCATED) != 0);
+
+	uint32_t offset = (uint32_t)sizeof(as_stats_snapshot_slot);
+
+	while (offset < used_sz) {
+		const as_stats_snapshot_entry* e =
+				(const as_stats_snapshot_entry*)((const uint8_t*)slot + offset);
+		uint32_t entry_sz = e->entry_sz;
+
+		if (entry_sz <= offsetof(as_stats_snapshot_entry, name) + e->name_len ||
+				offset + entry_sz > used_sz) {
+			return false;
+		}
+
+		char name[UINT8_MAX + 1];
+
+		memcpy(name, e->name, e->name_len);
+		name[e->name_len] = '\0';
+
+		switch (e->type) {
+		case AS_STATS_SNAPSHOT_UINT64:
+			info_append_uint64(db, name, e->value.u64);
+			break;
+		case AS_STATS_SNAPSHOT_INT64:
+			info_append_format(db, name, "%ld", e->value.i64);
+			break;
+		case AS_STATS_SNAPSHOT_DOUBLE:
+			info_append_format(db, name, "%.3f", e->value.d);
+			break;
+		case AS_STATS_SNAPSHOT_BOOL:
+			info_append_bool(db, name, e->value.u64 != 0);
+			break;
+		default:
+			return false;
+		}
+
+		offset += entry_sz;
+	}
+
+	return true;
+}
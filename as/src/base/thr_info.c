@@ -39,6 +39,7 @@
 
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_queue.h"
 
 #include "cf_mutex.h"
@@ -47,6 +48,7 @@
 #include "dns.h"
 #include "dynbuf.h"
 #include "fetch.h"
+#include "hardware.h"
 #include "log.h"
 #include "msgpack_in.h"
 #include "os.h"
@@ -59,16 +61,22 @@
 #include "base/batch.h"
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/device_heat.h"
+#include "base/exp.h"
 #include "base/features.h"
 #include "base/health.h"
+#include "base/hot_keys.h"
 #include "base/index.h"
 #include "base/monitor.h"
 #include "base/nsup.h"
 #include "base/security.h"
 #include "base/service.h"
+#include "base/set_hist.h"
 #include "base/set_index.h"
+#include "base/slow_log.h"
 #include "base/smd.h"
 #include "base/stats.h"
+#include "base/stats_snapshot.h"
 #include "base/thr_info_port.h"
 #include "base/thr_tsvc.h"
 #include "base/transaction.h"
@@ -87,6 +95,7 @@
 #include "fabric/skew_monitor.h"
 #include "query/query.h"
 #include "sindex/sindex.h"
+#include "sindex/sindex_tree.h"
 #include "storage/storage.h"
 #include "transaction/proxy.h"
 #include "transaction/rw_request_hash.h"
@@ -120,11 +129,30 @@ typedef struct info_static_s {
 } info_static;
 
 
+// Snapshot of an expensive value, shared by requests within info-cache-ms.
+typedef struct info_snapshot_s {
+	struct info_snapshot_s *next;
+	char *branch; // NULL for dynamic values
+	uint64_t expire_ms;
+	uint8_t *value;
+	size_t value_sz;
+} info_snapshot;
+
+typedef struct info_snapshots_s {
+	bool cacheable;
+	cf_mutex lock;
+	uint32_t n_snapshots;
+	info_snapshot *head;
+} info_snapshots;
+
+#define MAX_SNAPSHOTS 64 // per name - tree branches come from requests
+
 typedef struct info_dynamic_s {
 	struct info_dynamic_s *next;
 	bool 	def;  // default, but that's a reserved word
 	char *name;
 	as_info_get_value_fn	value_fn;
+	info_snapshots snapshots;
 } info_dynamic;
 
 typedef struct info_command_s {
@@ -138,8 +166,19 @@ typedef struct info_tree_s {
 	struct info_tree_s *next;
 	char *name;
 	as_info_get_tree_fn	tree_fn;
+	info_snapshots snapshots;
 } info_tree;
 
+// Stat values that are expensive to generate and polled by monitoring.
+static const char* CACHEABLE_NAMES[] = {
+		"bins", "namespace", "sets", "sindex", "statistics"
+};
+
+#define N_CACHEABLE_NAMES (sizeof(CACHEABLE_NAMES) / sizeof(const char*))
+
+#define PARTITION_GENERATION_WAIT_DEFAULT_MS 1000
+#define PARTITION_GENERATION_WAIT_MAX_MS (10 * 1000)
+
 
 #define EOL		'\n' // incoming commands are separated by EOL
 #define SEP		'\t'
@@ -403,6 +442,8 @@ info_get_stats(char *name, cf_dyn_buf *db)
 	info_append_uint32(db, "cluster_max_compatibility_id", as_exchange_max_compatibility_id()); // not in ticker
 	info_append_bool(db, "cluster_integrity", as_clustering_has_integrity()); // not in ticker
 	info_append_bool(db, "cluster_is_member", ! as_clustering_is_orphan()); // not in ticker
+	as_clustering_info_phase_times(db); // not in ticker
+	as_exchange_info_phase_times(db); // not in ticker
 	as_hb_info_duplicates_get(db); // not in ticker
 	info_append_uint32(db, "cluster_clock_skew_stop_writes_sec", clock_skew_stop_writes_sec()); // not in ticker
 	info_append_uint64(db, "cluster_clock_skew_ms", as_skew_monitor_skew());
@@ -450,12 +491,26 @@ info_get_stats(char *name, cf_dyn_buf *db)
 	info_append_int(db, "heap_efficiency_pct", (int)(efficiency_pct + 0.5));
 	info_append_uint32(db, "heap_site_count", site_count);
 
+	size_t sys_kbytes[CF_ALLOC_N_SYS];
+
+	cf_alloc_sys_stats(sys_kbytes);
+
+	for (uint32_t sys = 0; sys < CF_ALLOC_N_SYS; sys++) {
+		char name[64];
+
+		sprintf(name, "heap_%s_kbytes", cf_alloc_sys_name((cf_alloc_sys)sys));
+		info_append_uint64(db, name, sys_kbytes[sys]);
+	}
+
 	info_get_aggregated_namespace_stats(db);
 
+	info_append_uint64(db, "log_lines_dropped", cf_log_n_dropped());
 	info_append_uint32(db, "info_queue", as_info_queue_get_size());
 	info_append_uint32(db, "rw_in_progress", rw_request_hash_count());
 	info_append_uint32(db, "proxy_in_progress", as_proxy_hash_count());
 	info_append_uint32(db, "tree_gc_queue", as_index_tree_gc_queue_size());
+	info_append_uint32(db, "tree_gc_active", as_index_tree_gc_n_active());
+	info_append_uint64(db, "tree_gc_elements_freed", as_index_tree_gc_n_freed());
 
 	// Read closed before opened.
 	uint64_t n_proto_fds_closed = g_stats.proto_connections_closed;
@@ -484,9 +539,13 @@ info_get_stats(char *name, cf_dyn_buf *db)
 	info_append_uint64(db, "heartbeat_received_foreign", g_stats.heartbeat_received_foreign);
 
 	info_append_uint64(db, "reaped_fds", g_stats.reaper_count); // not in ticker
+	info_append_uint64(db, "rebalanced_fds", g_stats.rebalance_count); // not in ticker
 
 	info_append_uint64(db, "info_complete", g_stats.info_complete); // not in ticker
 
+	info_append_uint64(db, "proto_capture_records", g_stats.proto_capture_records); // not in ticker
+	info_append_uint64(db, "proto_capture_dropped", g_stats.proto_capture_dropped); // not in ticker
+
 	info_append_uint64(db, "demarshal_error", g_stats.n_demarshal_error);
 	info_append_uint64(db, "early_tsvc_client_error", g_stats.n_tsvc_client_error);
 	info_append_uint64(db, "early_tsvc_from_proxy_error", g_stats.n_tsvc_from_proxy_error);
@@ -800,6 +859,52 @@ info_command_replicas(char *name, char *params, cf_dyn_buf *db)
 	return 0;
 }
 
+// Long-poll for a partition map change - e.g. after a stale map hint, send
+// "partition-generation-wait:generation=<g>;timeout=<ms>\nreplicas\n" to get
+// the new map as soon as it's published, in one round trip.
+int
+info_command_partition_generation_wait(char *name, char *params, cf_dyn_buf *db)
+{
+	char gen_str[11] = { 0 };
+	int len = (int)sizeof(gen_str);
+	uint32_t gen;
+
+	if (as_info_parameter_get(params, "generation", gen_str, &len) != 0 ||
+			cf_str_atoi_u32(gen_str, &gen) != 0) {
+		cf_warning(AS_INFO, "bad or missing generation parameter");
+		cf_dyn_buf_append_string(db, "ERROR::bad-generation");
+		return 0;
+	}
+
+	char timeout_str[11] = { 0 };
+	uint32_t timeout_ms = PARTITION_GENERATION_WAIT_DEFAULT_MS;
+
+	len = (int)sizeof(timeout_str);
+
+	int rv = as_info_parameter_get(params, "timeout", timeout_str, &len);
+
+	if (rv == -2 || (rv == 0 &&
+			(cf_str_atoi_u32(timeout_str, &timeout_ms) != 0 ||
+					timeout_ms > PARTITION_GENERATION_WAIT_MAX_MS))) {
+		cf_warning(AS_INFO, "bad timeout parameter");
+		cf_dyn_buf_append_string(db, "ERROR::bad-timeout");
+		return 0;
+	}
+
+	uint64_t end_ms = cf_getms() + timeout_ms;
+
+	// Ties up an info thread while waiting - hence the timeout cap.
+	while (as_load_uint32((uint32_t*)&g_partition_generation) == gen &&
+			cf_getms() < end_ms) {
+		usleep(1000);
+	}
+
+	cf_dyn_buf_append_uint32(db,
+			as_load_uint32((uint32_t*)&g_partition_generation));
+
+	return 0;
+}
+
 int
 info_command_cluster_stable(char *name, char *params, cf_dyn_buf *db)
 {
@@ -1736,10 +1841,12 @@ info_service_config_get(cf_dyn_buf *db)
 
 	info_append_bool(db, "advertise-ipv6", cf_socket_advertises_ipv6());
 	info_append_string(db, "auto-pin", auto_pin_string());
+	info_append_uint32(db, "background-dispatch-ratio", g_config.background_dispatch_ratio);
 	info_append_uint32(db, "batch-index-threads", g_config.n_batch_index_threads);
 	info_append_uint32(db, "batch-max-buffers-per-queue", g_config.batch_max_buffers_per_queue);
 	info_append_uint32(db, "batch-max-requests", g_config.batch_max_requests);
 	info_append_uint32(db, "batch-max-unused-buffers", g_config.batch_max_unused_buffers);
+	info_append_uint32(db, "busy-poll-us", g_config.busy_poll_us);
 
 	char cluster_name[AS_CLUSTER_NAME_SZ];
 	info_get_printable_cluster_name(cluster_name);
@@ -1757,12 +1864,17 @@ info_service_config_get(cf_dyn_buf *db)
 		info_append_indexed_string(db, "feature-key-file", i, NULL, g_config.feature_key_files[i]);
 	}
 
+	info_append_uint32(db, "histogram-significant-digits", g_config.hist_significant_digits);
 	info_append_bool(db, "indent-allocations", g_config.indent_allocations);
+	info_append_uint32(db, "index-tree-gc-max-rate", g_config.index_tree_gc_max_rate);
+	info_append_uint32(db, "index-tree-gc-threads", g_config.n_index_tree_gc_threads);
+	info_append_uint32(db, "info-cache-ms", g_config.info_cache_ms);
 	info_append_uint32(db, "info-threads", g_config.n_info_threads);
 	info_append_bool(db, "keep-caps-ssd-health", g_config.keep_caps_ssd_health);
 	info_append_bool(db, "log-local-time", cf_log_is_using_local_time());
 	info_append_bool(db, "log-millis", cf_log_is_using_millis());
 	info_append_bool(db, "microsecond-histograms", g_config.microsecond_histograms);
+	info_append_uint32(db, "migrate-compression-level", g_config.migrate_compression_level);
 	info_append_uint32(db, "migrate-fill-delay", g_config.migrate_fill_delay);
 	info_append_uint32(db, "migrate-max-num-incoming", g_config.migrate_max_num_incoming);
 	info_append_uint32(db, "migrate-threads", g_config.n_migrate_threads);
@@ -1771,17 +1883,25 @@ info_service_config_get(cf_dyn_buf *db)
 	info_append_string_safe(db, "node-id-interface", g_config.node_id_interface);
 	info_append_bool(db, "os-group-perms", cf_os_is_using_group_perms());
 	info_append_string_safe(db, "pidfile", g_config.pidfile);
+	info_append_uint32(db, "profile-sample-rate", g_config.profile_sample_rate);
+	info_append_bool(db, "proto-capture-redact-values", g_config.proto_capture_redact_values);
+	info_append_uint32(db, "proto-capture-sample-period", g_config.proto_capture_sample_period);
 	info_append_int(db, "proto-fd-idle-ms", g_config.proto_fd_idle_ms);
 	info_append_uint32(db, "proto-fd-max", g_config.n_proto_fd_max);
 	info_append_uint32(db, "query-max-done", g_config.query_max_done);
+	info_append_uint32(db, "query-max-rps", g_config.query_max_rps);
 	info_append_uint32(db, "query-threads-limit", g_config.n_query_threads_limit);
 	info_append_bool(db, "run-as-daemon", g_config.run_as_daemon);
 	info_append_bool(db, "salt-allocations", g_config.salt_allocations);
 	info_append_uint32(db, "service-threads", g_config.n_service_threads);
 	info_append_uint32(db, "sindex-builder-threads", g_config.sindex_builder_threads);
+	info_append_uint32(db, "sindex-gc-max-lock-us", g_config.sindex_gc_max_lock_us);
 	info_append_uint32(db, "sindex-gc-period", g_config.sindex_gc_period);
+	info_append_uint32(db, "slow-transaction-log-size", g_config.slow_transaction_log_size);
+	info_append_uint32(db, "stats-snapshot-period", g_config.stats_snapshot_period);
 	info_append_bool(db, "stay-quiesced", g_config.stay_quiesced);
 	info_append_uint32(db, "ticker-interval", g_config.ticker_interval);
+	info_append_uint32(db, "tls-handshake-threads", g_config.n_tls_handshake_threads);
 	info_append_int(db, "transaction-max-ms", (int)(g_config.transaction_max_ns / 1000000));
 	info_append_uint32(db, "transaction-retry-ms", g_config.transaction_retry_ms);
 	info_append_string_safe(db, "vault-ca", g_vault_cfg.ca);
@@ -1837,12 +1957,16 @@ info_network_config_get(cf_dyn_buf *db)
 	info_append_int(db, "fabric.tls-port", g_config.tls_fabric.bind_port);
 	info_append_string_safe(db, "fabric.tls-name", g_config.tls_fabric.tls_our_name);
 	info_append_uint32(db, "fabric.channel-bulk-fds", g_config.n_fabric_channel_fds[AS_FABRIC_CHANNEL_BULK]);
+	info_append_uint32(db, "fabric.channel-bulk-fds-max", g_config.n_fabric_channel_fds_max[AS_FABRIC_CHANNEL_BULK]);
 	info_append_uint32(db, "fabric.channel-bulk-recv-threads", g_config.n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_BULK]);
+	info_append_uint32(db, "fabric.channel-bulk-send-max-mb", g_config.fabric_bulk_send_max_mb);
 	info_append_uint32(db, "fabric.channel-ctrl-fds", g_config.n_fabric_channel_fds[AS_FABRIC_CHANNEL_CTRL]);
 	info_append_uint32(db, "fabric.channel-ctrl-recv-threads", g_config.n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_CTRL]);
 	info_append_uint32(db, "fabric.channel-meta-fds", g_config.n_fabric_channel_fds[AS_FABRIC_CHANNEL_META]);
 	info_append_uint32(db, "fabric.channel-meta-recv-threads", g_config.n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_META]);
+	info_append_uint32(db, "fabric.channel-rw-busy-poll-us", g_config.fabric_rw_busy_poll_us);
 	info_append_uint32(db, "fabric.channel-rw-fds", g_config.n_fabric_channel_fds[AS_FABRIC_CHANNEL_RW]);
+	info_append_uint32(db, "fabric.channel-rw-fds-max", g_config.n_fabric_channel_fds_max[AS_FABRIC_CHANNEL_RW]);
 	info_append_uint32(db, "fabric.channel-rw-recv-pools", g_config.n_fabric_channel_recv_pools[AS_FABRIC_CHANNEL_RW]);
 	info_append_uint32(db, "fabric.channel-rw-recv-threads", g_config.n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_RW]);
 	info_append_bool(db, "fabric.keepalive-enabled", g_config.fabric_keepalive_enabled);
@@ -1907,6 +2031,7 @@ info_namespace_config_get(char* context, cf_dyn_buf *db)
 
 	info_append_bool(db, "allow-ttl-without-nsup", ns->allow_ttl_without_nsup);
 	info_append_uint32(db, "background-query-max-rps", ns->background_query_max_rps);
+	info_append_bool(db, "batch-index-prefetch", ns->batch_index_prefetch);
 
 	if (ns->conflict_resolution_policy == AS_NAMESPACE_CONFLICT_RESOLUTION_POLICY_GENERATION) {
 		info_append_string(db, "conflict-resolution-policy", "generation");
@@ -1932,10 +2057,15 @@ info_namespace_config_get(char* context, cf_dyn_buf *db)
 	info_append_bool(db, "enable-benchmarks-write", ns->write_benchmarks_enabled);
 	info_append_bool(db, "enable-hist-proxy", ns->proxy_hist_enabled);
 	info_append_uint32(db, "evict-hist-buckets", ns->evict_hist_buckets);
+	info_append_uint32(db, "evict-sample-pct", ns->evict_sample_pct);
 	info_append_uint32(db, "evict-tenths-pct", ns->evict_tenths_pct);
 	info_append_uint32(db, "high-water-disk-pct", ns->hwm_disk_pct);
 	info_append_uint32(db, "high-water-memory-pct", ns->hwm_memory_pct);
+	info_append_uint32(db, "hot-key-sample-period", ns->hot_key_sample_period);
 	info_append_bool(db, "ignore-migrate-fill-delay", ns->ignore_migrate_fill_delay);
+	info_append_bool(db, "index-compact-entries", ns->index_compact_entries);
+	info_append_bool(db, "index-stage-huge-pages", ns->index_mem_cfg.huge_pages);
+	info_append_bool(db, "index-stage-interleave", ns->index_mem_cfg.numa_interleave);
 	info_append_uint64(db, "index-stage-size", ns->index_stage_size);
 
 	info_append_string(db, "index-type",
@@ -1946,20 +2076,33 @@ info_namespace_config_get(char* context, cf_dyn_buf *db)
 											"illegal"))));
 
 	info_append_uint32(db, "max-record-size", ns->max_record_size);
+	info_append_uint32(db, "memory-defrag-lwm-pct", ns->memory_defrag_lwm_pct);
+	info_append_uint32(db, "memory-defrag-period", ns->memory_defrag_period);
 	info_append_uint64(db, "memory-size", ns->memory_size);
+	info_append_string_safe(db, "memory-snapshot-file", ns->memory_snapshot_file);
 	info_append_uint32(db, "migrate-order", ns->migrate_order);
 	info_append_uint32(db, "migrate-retransmit-ms", ns->migrate_retransmit_ms);
 	info_append_uint32(db, "migrate-sleep", ns->migrate_sleep);
+	info_append_bool(db, "nsup-expire-index", ns->nsup_expire_index);
 	info_append_uint32(db, "nsup-hist-period", ns->nsup_hist_period);
 	info_append_uint32(db, "nsup-period", ns->nsup_period);
+	info_append_bool(db, "nsup-single-pass", ns->nsup_single_pass);
 	info_append_uint32(db, "nsup-threads", ns->n_nsup_threads);
+	info_append_bool(db, "optimistic-reads", ns->optimistic_reads);
+	info_append_uint32(db, "partition-tree-bloom-size", ns->tree_shared.bloom_size);
 	info_append_uint32(db, "partition-tree-sprigs", ns->tree_shared.n_sprigs);
 	info_append_bool(db, "prefer-uniform-balance", ns->cfg_prefer_uniform_balance);
+	info_append_uint64(db, "query-result-cache-size", ns->query_result_cache_size);
 	info_append_uint32(db, "rack-id", ns->rack_id);
 	info_append_string(db, "read-consistency-level-override", NS_READ_CONSISTENCY_LEVEL_NAME());
+	info_append_bool(db, "read-steer-device-outliers", ns->read_steer_device_outliers);
 	info_append_bool(db, "reject-non-xdr-writes", ns->reject_non_xdr_writes);
 	info_append_bool(db, "reject-xdr-writes", ns->reject_xdr_writes);
 	info_append_uint32(db, "replication-factor", ns->cfg_replication_factor);
+	info_append_string_safe(db, "service-thread-cpus", ns->service_thread_cpus);
+	info_append_uint32(db, "service-threads", ns->n_service_threads);
+	info_append_string_safe(db, "sindex-flash-dir", ns->sindex_flash_dir);
+	info_append_bool(db, "sindex-ordered-strings", ns->sindex_ordered_strings);
 	info_append_uint64(db, "sindex-stage-size", ns->sindex_stage_size);
 	info_append_bool(db, "single-bin", ns->single_bin);
 	info_append_uint32(db, "single-query-threads", ns->n_single_query_threads);
@@ -1969,6 +2112,8 @@ info_namespace_config_get(char* context, cf_dyn_buf *db)
 	info_append_uint32(db, "tomb-raider-eligible-age", ns->tomb_raider_eligible_age);
 	info_append_uint32(db, "tomb-raider-period", ns->tomb_raider_period);
 	info_append_uint32(db, "transaction-pending-limit", ns->transaction_pending_limit);
+	info_append_uint32(db, "truncate-latency-ms", ns->truncate_latency_ms);
+	info_append_uint32(db, "truncate-max-rate", ns->truncate_max_rate);
 	info_append_uint32(db, "truncate-threads", ns->n_truncate_threads);
 	info_append_string(db, "write-commit-level-override", NS_WRITE_COMMIT_LEVEL_NAME());
 	info_append_uint64(db, "xdr-bin-tombstone-ttl", ns->xdr_bin_tombstone_ttl_ms / 1000);
@@ -2040,20 +2185,27 @@ info_namespace_config_get(char* context, cf_dyn_buf *db)
 			}
 		}
 
+		info_append_uint32(db, "storage-engine.background-read-depth", ns->storage_background_read_depth);
 		info_append_bool(db, "storage-engine.cache-replica-writes", ns->storage_cache_replica_writes);
+		info_append_bool(db, "storage-engine.coalesce-batch-reads", ns->storage_coalesce_batch_reads);
 		info_append_bool(db, "storage-engine.cold-start-empty", ns->storage_cold_start_empty);
+		info_append_uint32(db, "storage-engine.cold-start-threads", ns->storage_cold_start_threads);
 		info_append_bool(db, "storage-engine.commit-to-device", ns->storage_commit_to_device);
 		info_append_uint32(db, "storage-engine.commit-min-size", ns->storage_commit_min_size);
+		info_append_uint32(db, "storage-engine.commit-window-us", ns->storage_commit_window_us);
 		info_append_string(db, "storage-engine.compression", NS_COMPRESSION());
 		info_append_uint32(db, "storage-engine.compression-level", NS_COMPRESSION_LEVEL());
 		info_append_bool(db, "storage-engine.data-in-memory", ns->storage_data_in_memory);
+		info_append_bool(db, "storage-engine.dax-map", ns->storage_dax_map);
 		info_append_uint32(db, "storage-engine.defrag-lwm-pct", ns->storage_defrag_lwm_pct);
 		info_append_uint32(db, "storage-engine.defrag-queue-min", ns->storage_defrag_queue_min);
 		info_append_uint32(db, "storage-engine.defrag-sleep", ns->storage_defrag_sleep);
 		info_append_uint32(db, "storage-engine.defrag-startup-minimum", ns->storage_defrag_startup_minimum);
+		info_append_uint32(db, "storage-engine.defrag-target-read-us", ns->storage_defrag_target_read_us);
 		info_append_bool(db, "storage-engine.direct-files", ns->storage_direct_files);
 		info_append_bool(db, "storage-engine.disable-odsync", ns->storage_disable_odsync);
 		info_append_bool(db, "storage-engine.enable-benchmarks-storage", ns->storage_benchmarks_enabled);
+		info_append_bool(db, "storage-engine.enable-latency-map", ns->storage_latency_map_enabled);
 
 		if (ns->storage_encryption_key_file != NULL) {
 			info_append_string(db, "storage-engine.encryption",
@@ -2066,15 +2218,29 @@ info_namespace_config_get(char* context, cf_dyn_buf *db)
 		info_append_string_safe(db, "storage-engine.encryption-old-key-file", ns->storage_encryption_old_key_file);
 		info_append_uint64(db, "storage-engine.filesize", ns->storage_filesize);
 		info_append_uint64(db, "storage-engine.flush-max-ms", ns->storage_flush_max_us / 1000);
+		info_append_uint64(db, "storage-engine.flush-max-defer-ms", ns->storage_flush_max_defer_us / 1000);
+		info_append_uint32(db, "storage-engine.flush-min-fill-pct", ns->storage_flush_min_fill_pct);
+		info_append_string_safe(db, "storage-engine.index-snapshot-file", ns->storage_index_snapshot_file);
+		info_append_uint32(db, "storage-engine.large-record-stream-size", ns->storage_large_record_stream_size);
 		info_append_uint64(db, "storage-engine.max-write-cache", ns->storage_max_write_cache);
 		info_append_uint32(db, "storage-engine.min-avail-pct", ns->storage_min_avail_pct);
+		info_append_bool(db, "storage-engine.numa-local-write-buffers", ns->storage_numa_local_write_buffers);
 		info_append_uint32(db, "storage-engine.post-write-queue", ns->storage_post_write_queue);
+		info_append_uint64(db, "storage-engine.read-cache-size", ns->storage_read_cache_size);
+		info_append_bool(db, "storage-engine.read-io-uring", ns->storage_read_io_uring);
+		info_append_uint32(db, "storage-engine.read-offload-us", ns->storage_read_offload_us);
 		info_append_bool(db, "storage-engine.read-page-cache", ns->storage_read_page_cache);
+		info_append_bool(db, "storage-engine.record-checksums", ns->storage_record_checksums);
+		info_append_bool(db, "storage-engine.scan-device-order", ns->storage_scan_device_order);
 		info_append_string_safe(db, "storage-engine.scheduler-mode", ns->storage_scheduler_mode);
 		info_append_bool(db, "storage-engine.serialize-tomb-raider", ns->storage_serialize_tomb_raider);
+		info_append_uint64(db, "storage-engine.shadow-max-lag", ns->storage_shadow_max_lag);
+		info_append_uint32(db, "storage-engine.shed-low-priority-pct", ns->storage_shed_low_priority_pct);
 		info_append_bool(db, "storage-engine.sindex-startup-device-scan", ns->storage_sindex_startup_device_scan);
 		info_append_uint32(db, "storage-engine.tomb-raider-sleep", ns->storage_tomb_raider_sleep);
+		info_append_uint32(db, "storage-engine.ttl-write-streams", ns->storage_ttl_write_streams);
 		info_append_uint32(db, "storage-engine.write-block-size", ns->storage_write_block_size);
+		info_append_bool(db, "storage-engine.write-lifetime-hints", ns->storage_write_lifetime_hints);
 	}
 
 	info_append_bool(db, "geo2dsphere-within.strict", ns->geo2dsphere_within_strict);
@@ -2208,6 +2374,7 @@ read_benchmarks_histogram_clear_all(as_namespace* ns)
 	histogram_rescale(ns->read_restart_hist, scale);
 	histogram_rescale(ns->read_dup_res_hist, scale);
 	histogram_rescale(ns->read_repl_ping_hist, scale);
+	histogram_rescale(ns->read_record_lock_hist, scale);
 	histogram_rescale(ns->read_local_hist, scale);
 	histogram_rescale(ns->read_response_hist, scale);
 }
@@ -2220,6 +2387,7 @@ write_benchmarks_histogram_clear_all(as_namespace* ns)
 	histogram_rescale(ns->write_start_hist, scale);
 	histogram_rescale(ns->write_restart_hist, scale);
 	histogram_rescale(ns->write_dup_res_hist, scale);
+	histogram_rescale(ns->write_record_lock_hist, scale);
 	histogram_rescale(ns->write_master_hist, scale);
 	histogram_rescale(ns->write_repl_write_hist, scale);
 	histogram_rescale(ns->write_response_hist, scale);
@@ -2377,6 +2545,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			g_config.query_max_done = val;
 			as_query_limit_finished_jobs();
 		}
+		else if (0 == as_info_parameter_get(params, "query-max-rps", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of query-max-rps from %u to %d ", g_config.query_max_rps, val);
+			g_config.query_max_rps = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "query-threads-limit", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val) || val < 1 || val > 1024) {
 				goto Error;
@@ -2402,6 +2577,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of batch-max-buffers-per-queue from %d to %d ", g_config.batch_max_buffers_per_queue, val);
 			g_config.batch_max_buffers_per_queue = val;
 		}
+		else if (0 == as_info_parameter_get(params, "background-dispatch-ratio", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of background-dispatch-ratio from %u to %d", g_config.background_dispatch_ratio, val);
+			g_config.background_dispatch_ratio = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "batch-max-unused-buffers", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val))
 				goto Error;
@@ -2425,12 +2607,54 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of proto-fd-idle-ms from %d to %d ", g_config.proto_fd_idle_ms, val);
 			g_config.proto_fd_idle_ms = val;
 		}
+		else if (0 == as_info_parameter_get(params, "profile-sample-rate", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > MAX_PROFILE_SAMPLE_RATE) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of profile-sample-rate from %u to %d", g_config.profile_sample_rate, val);
+			g_config.profile_sample_rate = (uint32_t)val;
+			cf_thread_profile_set_rate(g_config.profile_sample_rate);
+		}
+		else if (0 == as_info_parameter_get(params, "proto-capture-sample-period", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of proto-capture-sample-period from %u to %d", g_config.proto_capture_sample_period, val);
+			g_config.proto_capture_sample_period = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "proto-capture-redact-values", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of proto-capture-redact-values to %s", context);
+				g_config.proto_capture_redact_values = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of proto-capture-redact-values to %s", context);
+				g_config.proto_capture_redact_values = false;
+			}
+			else {
+				goto Error;
+			}
+		}
 		else if (0 == as_info_parameter_get( params, "cluster-name", context, &context_len)){
 			if (!as_config_cluster_name_set(context)) {
 				goto Error;
 			}
 			cf_info(AS_INFO, "Changing value of cluster-name to '%s'", context);
 		}
+		else if (0 == as_info_parameter_get(params, "index-tree-gc-max-rate", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of index-tree-gc-max-rate from %u to %d ", g_config.index_tree_gc_max_rate, val);
+			g_config.index_tree_gc_max_rate = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "info-cache-ms", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > 60000) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of info-cache-ms from %u to %d ", g_config.info_cache_ms, val);
+			g_config.info_cache_ms = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "info-threads", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val)) {
 				goto Error;
@@ -2454,6 +2678,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of migrate-fill-delay from %u to %u ", g_config.migrate_fill_delay, val);
 			g_config.migrate_fill_delay = val;
 		}
+		else if (0 == as_info_parameter_get(params, "migrate-compression-level", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > 9) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of migrate-compression-level from %u to %d ", g_config.migrate_compression_level, val);
+			g_config.migrate_compression_level = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "migrate-max-num-incoming", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val)) {
 				goto Error;
@@ -2489,12 +2720,27 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of sindex-builder-threads from %u to %d", g_config.sindex_builder_threads, val);
 			g_config.sindex_builder_threads = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "sindex-gc-max-lock-us", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of sindex-gc-max-lock-us from %u to %d", g_config.sindex_gc_max_lock_us, val);
+			g_config.sindex_gc_max_lock_us = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "sindex-gc-period", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val))
 				goto Error;
 			cf_info(AS_INFO, "Changing value of sindex-gc-period from %d to %d ", g_config.sindex_gc_period, val);
 			g_config.sindex_gc_period = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "slow-transaction-log-size", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > MAX_SLOW_LOG_SIZE) {
+				cf_warning(AS_INFO, "slow-transaction-log-size: value must be between 0 and %d, not %s", MAX_SLOW_LOG_SIZE, context);
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of slow-transaction-log-size from %u to %d", g_config.slow_transaction_log_size, val);
+			g_config.slow_transaction_log_size = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "microsecond-histograms", context, &context_len)) {
 			if (any_benchmarks_enabled()) {
 				cf_warning(AS_INFO, "microsecond-histograms can only be changed if all microbenchmark histograms are disabled");
@@ -2665,6 +2911,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_FABRIC, "changing fabric.channel-rw-recv-threads from %u to %d", g_config.n_fabric_channel_recv_threads[AS_FABRIC_CHANNEL_RW], val);
 			as_fabric_set_recv_threads(AS_FABRIC_CHANNEL_RW, val);
 		}
+		else if (0 == as_info_parameter_get(params, "fabric.channel-bulk-send-max-mb", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_FABRIC, "changing fabric.channel-bulk-send-max-mb from %u to %d", g_config.fabric_bulk_send_max_mb, val);
+			g_config.fabric_bulk_send_max_mb = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "fabric.recv-rearm-threshold", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val)) {
 				goto Error;
@@ -2727,6 +2980,19 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 					goto Error;
 				}
 			}
+			else if (0 == as_info_parameter_get(params, "enable-histograms", context, &context_len)) {
+				if ((strncmp(context, "true", 4) == 0) || (strncmp(context, "yes", 3) == 0)) {
+					cf_info(AS_INFO, "Changing value of enable-histograms of ns %s set %s to %s", ns->name, p_set->name, context);
+					as_set_hist_enable(ns, p_set);
+				}
+				else if ((strncmp(context, "false", 5) == 0) || (strncmp(context, "no", 2) == 0)) {
+					cf_info(AS_INFO, "Changing value of enable-histograms of ns %s set %s to %s", ns->name, p_set->name, context);
+					as_set_hist_disable(p_set);
+				}
+				else {
+					goto Error;
+				}
+			}
 			else if (0 == as_info_parameter_get(params, "enable-index", context, &context_len)) {
 				if ((strncmp(context, "true", 4) == 0) || (strncmp(context, "yes", 3) == 0)) {
 					cf_info(AS_INFO, "Changing value of enable-index of ns %s set %s to %s", ns->name, p_set->name, context);
@@ -2778,6 +3044,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of high-water-memory-pct memory of ns %s from %u to %d ", ns->name, ns->hwm_memory_pct, val);
 			ns->hwm_memory_pct = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "hot-key-sample-period", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of hot-key-sample-period of ns %s from %u to %d ", ns->name, ns->hot_key_sample_period, val);
+			ns->hot_key_sample_period = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "evict-tenths-pct", context, &context_len)) {
 			cf_info(AS_INFO, "Changing value of evict-tenths-pct memory of ns %s from %d to %d ", ns->name, ns->evict_tenths_pct, atoi(context));
 			ns->evict_tenths_pct = atoi(context);
@@ -2789,6 +3062,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of evict-hist-buckets of ns %s from %u to %d ", ns->name, ns->evict_hist_buckets, val);
 			ns->evict_hist_buckets = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "evict-sample-pct", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > 100) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of evict-sample-pct of ns %s from %u to %d ", ns->name, ns->evict_sample_pct, val);
+			ns->evict_sample_pct = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "background-query-max-rps", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val) || val < 1 || val > 1000000) {
 				goto Error;
@@ -2848,6 +3128,21 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of max-record-size of ns %s from %u to %d", ns->name, ns->max_record_size, val);
 			ns->max_record_size = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "memory-defrag-lwm-pct", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 1 || val > 99) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of memory-defrag-lwm-pct of ns %s from %u to %d", ns->name, ns->memory_defrag_lwm_pct, val);
+			ns->memory_defrag_lwm_pct = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "memory-defrag-period", context, &context_len)) {
+			uint32_t val;
+			if (cf_str_atoi_seconds(context, &val) != 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of memory-defrag-period of ns %s from %u to %u", ns->name, ns->memory_defrag_period, val);
+			ns->memory_defrag_period = val;
+		}
 		else if (0 == as_info_parameter_get(params, "migrate-order", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val) || val < 1 || val > 10) {
 				goto Error;
@@ -2892,6 +3187,16 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of nsup-threads of ns %s from %u to %d", ns->name, ns->n_nsup_threads, val);
 			ns->n_nsup_threads = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "partition-tree-sprigs", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 1) {
+				goto Error;
+			}
+			uint32_t old_n_sprigs = ns->tree_shared.n_sprigs;
+			if (! as_namespace_split_sprigs(ns, (uint32_t)val)) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of partition-tree-sprigs of ns %s from %u to %d", ns->name, old_n_sprigs, val);
+		}
 		else if (0 == as_info_parameter_get(params, "replication-factor", context, &context_len)) {
 			if (ns->cp) {
 				cf_warning(AS_INFO, "{%s} 'replication-factor' is not yet dynamic with 'strong-consistency'", ns->name);
@@ -3009,6 +3314,20 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of transaction-pending-limit of ns %s from %d to %d ", ns->name, ns->transaction_pending_limit, val);
 			ns->transaction_pending_limit = val;
 		}
+		else if (0 == as_info_parameter_get(params, "truncate-latency-ms", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of truncate-latency-ms of ns %s from %u to %d ", ns->name, ns->truncate_latency_ms, val);
+			ns->truncate_latency_ms = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "truncate-max-rate", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of truncate-max-rate of ns %s from %u to %d ", ns->name, ns->truncate_max_rate, val);
+			ns->truncate_max_rate = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "truncate-threads", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val)) {
 				goto Error;
@@ -3124,6 +3443,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of compression-level of ns %s from %u to %d", ns->name, ns->storage_compression_level, val);
 			ns->storage_compression_level = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "background-read-depth", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > 1024) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of background-read-depth of ns %s from %u to %d", ns->name, ns->storage_background_read_depth, val);
+			ns->storage_background_read_depth = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "cache-replica-writes", context, &context_len)) {
 			if (ns->storage_data_in_memory) {
 				cf_warning(AS_INFO, "ns %s, can't set cache-replica-writes if data-in-memory", ns->name);
@@ -3170,6 +3496,13 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of defrag-sleep of ns %s from %u to %d", ns->name, ns->storage_defrag_sleep, val);
 			ns->storage_defrag_sleep = (uint32_t)val;
 		}
+		else if (0 == as_info_parameter_get(params, "defrag-target-read-us", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of defrag-target-read-us of ns %s from %u to %d", ns->name, ns->storage_defrag_target_read_us, val);
+			ns->storage_defrag_target_read_us = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "flush-max-ms", context, &context_len)) {
 			if (0 != cf_str_atoi(context, &val)) {
 				goto Error;
@@ -3177,6 +3510,88 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 			cf_info(AS_INFO, "Changing value of flush-max-ms of ns %s from %lu to %d", ns->name, ns->storage_flush_max_us / 1000, val);
 			ns->storage_flush_max_us = (uint64_t)val * 1000;
 		}
+		else if (0 == as_info_parameter_get(params, "record-checksums", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of record-checksums of ns %s from %s to %s", ns->name, bool_val[ns->storage_record_checksums], context);
+				ns->storage_record_checksums = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of record-checksums of ns %s from %s to %s", ns->name, bool_val[ns->storage_record_checksums], context);
+				ns->storage_record_checksums = false;
+			}
+			else {
+				goto Error;
+			}
+		}
+		else if (0 == as_info_parameter_get(params, "scan-device-order", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of scan-device-order of ns %s from %s to %s", ns->name, bool_val[ns->storage_scan_device_order], context);
+				ns->storage_scan_device_order = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of scan-device-order of ns %s from %s to %s", ns->name, bool_val[ns->storage_scan_device_order], context);
+				ns->storage_scan_device_order = false;
+			}
+			else {
+				goto Error;
+			}
+		}
+		else if (0 == as_info_parameter_get(params, "shadow-max-lag", context, &context_len)) {
+			uint64_t val_u64;
+
+			if (ns->n_storage_shadows == 0) {
+				cf_warning(AS_INFO, "ns %s, can't set shadow-max-lag without shadow devices", ns->name);
+				goto Error;
+			}
+			if (0 != cf_str_atoi_u64(context, &val_u64)) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of shadow-max-lag of ns %s from %lu to %lu", ns->name, ns->storage_shadow_max_lag, val_u64);
+			ns->storage_shadow_max_lag = val_u64;
+			ns->storage_shadow_max_lag_q = (uint32_t)((as_namespace_device_count(ns) *
+					val_u64 + ns->storage_write_block_size - 1) / ns->storage_write_block_size);
+		}
+		else if (0 == as_info_parameter_get(params, "shed-low-priority-pct", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > 100) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of shed-low-priority-pct of ns %s from %u to %d", ns->name, ns->storage_shed_low_priority_pct, val);
+			ns->storage_shed_low_priority_pct = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "flush-max-defer-ms", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of flush-max-defer-ms of ns %s from %lu to %d", ns->name, ns->storage_flush_max_defer_us / 1000, val);
+			ns->storage_flush_max_defer_us = (uint64_t)val * 1000;
+		}
+		else if (0 == as_info_parameter_get(params, "flush-min-fill-pct", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > 100) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of flush-min-fill-pct of ns %s from %u to %d", ns->name, ns->storage_flush_min_fill_pct, val);
+			ns->storage_flush_min_fill_pct = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "large-record-stream-size", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0 || val > MAX_WRITE_BLOCK_SIZE) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of large-record-stream-size of ns %s from %u to %d", ns->name, ns->storage_large_record_stream_size, val);
+			ns->storage_large_record_stream_size = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "read-steer-device-outliers", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of read-steer-device-outliers of ns %s from %s to %s", ns->name, bool_val[ns->read_steer_device_outliers], context);
+				ns->read_steer_device_outliers = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of read-steer-device-outliers of ns %s from %s to %s", ns->name, bool_val[ns->read_steer_device_outliers], context);
+				ns->read_steer_device_outliers = false;
+			}
+			else {
+				goto Error;
+			}
+		}
 		else if (0 == as_info_parameter_get(params, "reject-non-xdr-writes", context, &context_len)) {
 			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
 				cf_info(AS_INFO, "Changing value of reject-non-xdr-writes of ns %s from %s to %s", ns->name, bool_val[ns->reject_non_xdr_writes], context);
@@ -3203,6 +3618,32 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 				goto Error;
 			}
 		}
+		else if (0 == as_info_parameter_get(params, "batch-index-prefetch", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of batch-index-prefetch of ns %s from %s to %s", ns->name, bool_val[ns->batch_index_prefetch], context);
+				ns->batch_index_prefetch = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of batch-index-prefetch of ns %s from %s to %s", ns->name, bool_val[ns->batch_index_prefetch], context);
+				ns->batch_index_prefetch = false;
+			}
+			else {
+				goto Error;
+			}
+		}
+		else if (0 == as_info_parameter_get(params, "optimistic-reads", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of optimistic-reads of ns %s from %s to %s", ns->name, bool_val[ns->optimistic_reads], context);
+				ns->optimistic_reads = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of optimistic-reads of ns %s from %s to %s", ns->name, bool_val[ns->optimistic_reads], context);
+				ns->optimistic_reads = false;
+			}
+			else {
+				goto Error;
+			}
+		}
 		else if (0 == as_info_parameter_get(params, "allow-ttl-without-nsup", context, &context_len)) {
 			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
 				cf_info(AS_INFO, "Changing value of allow-ttl-without-nsup of ns %s from %s to %s", ns->name, bool_val[ns->allow_ttl_without_nsup], context);
@@ -3331,6 +3772,19 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 				goto Error;
 			}
 		}
+		else if (0 == as_info_parameter_get(params, "enable-latency-map", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of enable-latency-map of ns %s from %s to %s", ns->name, bool_val[ns->storage_latency_map_enabled], context);
+				ns->storage_latency_map_enabled = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of enable-latency-map of ns %s from %s to %s", ns->name, bool_val[ns->storage_latency_map_enabled], context);
+				ns->storage_latency_map_enabled = false;
+			}
+			else {
+				goto Error;
+			}
+		}
 		else if (0 == as_info_parameter_get(params, "enable-benchmarks-storage", context, &context_len)) {
 			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
 				cf_info(AS_INFO, "Changing value of enable-benchmarks-storage of ns %s from %s to %s", ns->name, bool_val[ns->storage_benchmarks_enabled], context);
@@ -3416,6 +3870,59 @@ info_command_config_set_threadsafe(char *name, char *params, cf_dyn_buf *db)
 				goto Error;
 			}
 		}
+		else if (0 == as_info_parameter_get(params, "coalesce-batch-reads", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of coalesce-batch-reads of ns %s from %s to %s", ns->name, bool_val[ns->storage_coalesce_batch_reads], context);
+				ns->storage_coalesce_batch_reads = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of coalesce-batch-reads of ns %s from %s to %s", ns->name, bool_val[ns->storage_coalesce_batch_reads], context);
+				ns->storage_coalesce_batch_reads = false;
+			}
+			else {
+				goto Error;
+			}
+		}
+		else if (0 == as_info_parameter_get(params, "ttl-write-streams", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 1 || val > MAX_TTL_WRITE_STREAMS) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of ttl-write-streams of ns %s from %u to %d", ns->name, ns->storage_ttl_write_streams, val);
+			ns->storage_ttl_write_streams = (uint32_t)val;
+		}
+		else if (0 == as_info_parameter_get(params, "write-lifetime-hints", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of write-lifetime-hints of ns %s from %s to %s", ns->name, bool_val[ns->storage_write_lifetime_hints], context);
+				ns->storage_write_lifetime_hints = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of write-lifetime-hints of ns %s from %s to %s", ns->name, bool_val[ns->storage_write_lifetime_hints], context);
+				ns->storage_write_lifetime_hints = false;
+			}
+			else {
+				goto Error;
+			}
+		}
+		else if (0 == as_info_parameter_get(params, "read-io-uring", context, &context_len)) {
+			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
+				cf_info(AS_INFO, "Changing value of read-io-uring of ns %s from %s to %s", ns->name, bool_val[ns->storage_read_io_uring], context);
+				ns->storage_read_io_uring = true;
+			}
+			else if (strncmp(context, "false", 5) == 0 || strncmp(context, "no", 2) == 0) {
+				cf_info(AS_INFO, "Changing value of read-io-uring of ns %s from %s to %s", ns->name, bool_val[ns->storage_read_io_uring], context);
+				ns->storage_read_io_uring = false;
+			}
+			else {
+				goto Error;
+			}
+		}
+		else if (0 == as_info_parameter_get(params, "read-offload-us", context, &context_len)) {
+			if (0 != cf_str_atoi(context, &val) || val < 0) {
+				goto Error;
+			}
+			cf_info(AS_INFO, "Changing value of read-offload-us of ns %s from %u to %d", ns->name, ns->storage_read_offload_us, val);
+			ns->storage_read_offload_us = (uint32_t)val;
+		}
 		else if (0 == as_info_parameter_get(params, "read-page-cache", context, &context_len)) {
 			if (strncmp(context, "true", 4) == 0 || strncmp(context, "yes", 3) == 0) {
 				cf_info(AS_INFO, "Changing value of read-page-cache of ns %s from %s to %s", ns->name, bool_val[ns->storage_read_page_cache], context);
@@ -3679,7 +4186,7 @@ info_command_log_set(char *name, char *params, cf_dyn_buf *db)
 }
 
 
-// latencies:[hist=<name>]
+// latencies:[hist=<name>][;percentiles=true]
 //
 // If no hist param, command applies to ?
 //
@@ -3692,55 +4199,81 @@ info_command_log_set(char *name, char *params, cf_dyn_buf *db)
 // <name>,units,TPS, ...
 // Values following the TPS are percentages exceeding logarithmic thresholds.
 //
+// e.g.:
+// latencies:hist={test}-reads;percentiles=true
+// output:
+// {test}-reads:msec,30618.2,p50=0.214,p90=0.431,p99=1.023,p99.9=3.807,p99.99=9.215
+//
+// explanation:
+// Values following the TPS are latencies at percentiles, to the precision set
+// by histogram-significant-digits.
+//
 int
 info_command_latencies(char* name, char* params, cf_dyn_buf* db)
 {
 	cf_debug(AS_INFO, "%s command received: params %s", name, params);
 
+	char pct_str[6];
+	int pct_str_len = sizeof(pct_str);
+	bool percentiles = false;
+
+	if (as_info_parameter_get(params, "percentiles", pct_str,
+			&pct_str_len) == 0) {
+		if (strcmp(pct_str, "true") == 0) {
+			percentiles = true;
+		}
+		else if (strcmp(pct_str, "false") != 0) {
+			cf_info(AS_INFO, "%s command: bad percentiles value: %s", name,
+					pct_str);
+			cf_dyn_buf_append_string(db, "error-bad-percentiles");
+			return 0;
+		}
+	}
+
 	char value_str[100];
 	int  value_str_len = sizeof(value_str);
 
 	if (as_info_parameter_get(params, "hist", value_str, &value_str_len) != 0) {
 		// Canonical histograms.
 
-		histogram_get_latencies(g_stats.batch_index_hist, db);
+		histogram_get_latencies(g_stats.batch_index_hist, percentiles, db);
 
 		for (uint32_t i = 0; i < g_config.n_namespaces; i++) {
 			as_namespace* ns = g_config.namespaces[i];
 
-			histogram_get_latencies(ns->read_hist, db);
-			histogram_get_latencies(ns->write_hist, db);
-			histogram_get_latencies(ns->udf_hist, db);
-			histogram_get_latencies(ns->pi_query_hist, db);
-			histogram_get_latencies(ns->si_query_hist, db);
+			histogram_get_latencies(ns->read_hist, percentiles, db);
+			histogram_get_latencies(ns->write_hist, percentiles, db);
+			histogram_get_latencies(ns->udf_hist, percentiles, db);
+			histogram_get_latencies(ns->pi_query_hist, percentiles, db);
+			histogram_get_latencies(ns->si_query_hist, percentiles, db);
 		}
 	}
 	else {
 		// Named histograms.
 
 		if (strcmp(value_str, "batch-index") == 0) {
-			histogram_get_latencies(g_stats.batch_index_hist, db);
+			histogram_get_latencies(g_stats.batch_index_hist, percentiles, db);
 		}
 		else if (strcmp(value_str, "info") == 0) {
-			histogram_get_latencies(g_stats.info_hist, db);
+			histogram_get_latencies(g_stats.info_hist, percentiles, db);
 		}
 		else if (strcmp(value_str, "benchmarks-fabric") == 0) {
-			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_BULK], db);
-			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_BULK], db);
-			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_BULK], db);
-			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_BULK], db);
-			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_CTRL], db);
-			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_CTRL], db);
-			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_CTRL], db);
-			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_CTRL], db);
-			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_META], db);
-			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_META], db);
-			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_META], db);
-			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_META], db);
-			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_RW], db);
-			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_RW], db);
-			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_RW], db);
-			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_RW], db);
+			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_BULK], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_BULK], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_BULK], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_BULK], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_CTRL], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_CTRL], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_CTRL], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_CTRL], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_META], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_META], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_META], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_META], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_init_hists[AS_FABRIC_CHANNEL_RW], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_send_fragment_hists[AS_FABRIC_CHANNEL_RW], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_fragment_hists[AS_FABRIC_CHANNEL_RW], percentiles, db);
+			histogram_get_latencies(g_stats.fabric_recv_cb_hists[AS_FABRIC_CHANNEL_RW], percentiles, db);
 		}
 		else if (*value_str == '{') {
 			// Named namespace-scoped histogram - parse '{namespace}-' prefix.
@@ -3764,77 +4297,82 @@ info_command_latencies(char* name, char* params, cf_dyn_buf* db)
 			}
 
 			if (strcmp(hist_name, "read") == 0) {
-				histogram_get_latencies(ns->read_hist, db);
+				histogram_get_latencies(ns->read_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "write") == 0) {
-				histogram_get_latencies(ns->write_hist, db);
+				histogram_get_latencies(ns->write_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "udf") == 0) {
-				histogram_get_latencies(ns->udf_hist, db);
+				histogram_get_latencies(ns->udf_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "pi-query") == 0) {
-				histogram_get_latencies(ns->pi_query_hist, db);
+				histogram_get_latencies(ns->pi_query_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "si-query") == 0) {
-				histogram_get_latencies(ns->si_query_hist, db);
+				histogram_get_latencies(ns->si_query_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "re-repl") == 0) {
-				histogram_get_latencies(ns->re_repl_hist, db);
+				histogram_get_latencies(ns->re_repl_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "proxy") == 0) {
-				histogram_get_latencies(ns->proxy_hist, db);
+				histogram_get_latencies(ns->proxy_hist, percentiles, db);
+			}
+			else if (strcmp(hist_name, "sets") == 0) {
+				as_set_hist_get_latencies(ns, percentiles, db);
 			}
 			else if (strcmp(hist_name, "benchmarks-read") == 0) {
-				histogram_get_latencies(ns->read_start_hist, db);
-				histogram_get_latencies(ns->read_restart_hist, db);
-				histogram_get_latencies(ns->read_dup_res_hist, db);
-				histogram_get_latencies(ns->read_repl_ping_hist, db);
-				histogram_get_latencies(ns->read_local_hist, db);
-				histogram_get_latencies(ns->read_response_hist, db);
+				histogram_get_latencies(ns->read_start_hist, percentiles, db);
+				histogram_get_latencies(ns->read_restart_hist, percentiles, db);
+				histogram_get_latencies(ns->read_dup_res_hist, percentiles, db);
+				histogram_get_latencies(ns->read_repl_ping_hist, percentiles, db);
+				histogram_get_latencies(ns->read_record_lock_hist, percentiles, db);
+				histogram_get_latencies(ns->read_local_hist, percentiles, db);
+				histogram_get_latencies(ns->read_response_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "benchmarks-write") == 0) {
-				histogram_get_latencies(ns->write_start_hist, db);
-				histogram_get_latencies(ns->write_restart_hist, db);
-				histogram_get_latencies(ns->write_dup_res_hist, db);
-				histogram_get_latencies(ns->write_master_hist, db);
-				histogram_get_latencies(ns->write_repl_write_hist, db);
-				histogram_get_latencies(ns->write_response_hist, db);
+				histogram_get_latencies(ns->write_start_hist, percentiles, db);
+				histogram_get_latencies(ns->write_restart_hist, percentiles, db);
+				histogram_get_latencies(ns->write_dup_res_hist, percentiles, db);
+				histogram_get_latencies(ns->write_record_lock_hist, percentiles, db);
+				histogram_get_latencies(ns->write_master_hist, percentiles, db);
+				histogram_get_latencies(ns->write_repl_write_hist, percentiles, db);
+				histogram_get_latencies(ns->write_response_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "benchmarks-udf") == 0) {
-				histogram_get_latencies(ns->udf_start_hist, db);
-				histogram_get_latencies(ns->udf_restart_hist, db);
-				histogram_get_latencies(ns->udf_dup_res_hist, db);
-				histogram_get_latencies(ns->udf_master_hist, db);
-				histogram_get_latencies(ns->udf_repl_write_hist, db);
-				histogram_get_latencies(ns->udf_response_hist, db);
+				histogram_get_latencies(ns->udf_start_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_restart_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_dup_res_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_master_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_repl_write_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_response_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "benchmarks-batch-sub") == 0) {
-				histogram_get_latencies(ns->batch_sub_prestart_hist, db);
-				histogram_get_latencies(ns->batch_sub_start_hist, db);
-				histogram_get_latencies(ns->batch_sub_restart_hist, db);
-				histogram_get_latencies(ns->batch_sub_dup_res_hist, db);
-				histogram_get_latencies(ns->batch_sub_repl_ping_hist, db);
-				histogram_get_latencies(ns->batch_sub_read_local_hist, db);
-				histogram_get_latencies(ns->batch_sub_write_master_hist, db);
-				histogram_get_latencies(ns->batch_sub_udf_master_hist, db);
-				histogram_get_latencies(ns->batch_sub_repl_write_hist, db);
-				histogram_get_latencies(ns->batch_sub_response_hist, db);
+				histogram_get_latencies(ns->batch_sub_prestart_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_start_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_restart_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_dup_res_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_repl_ping_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_read_local_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_write_master_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_udf_master_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_repl_write_hist, percentiles, db);
+				histogram_get_latencies(ns->batch_sub_response_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "benchmarks-udf-sub") == 0) {
-				histogram_get_latencies(ns->udf_sub_start_hist, db);
-				histogram_get_latencies(ns->udf_sub_restart_hist, db);
-				histogram_get_latencies(ns->udf_sub_dup_res_hist, db);
-				histogram_get_latencies(ns->udf_sub_master_hist, db);
-				histogram_get_latencies(ns->udf_sub_repl_write_hist, db);
-				histogram_get_latencies(ns->udf_sub_response_hist, db);
+				histogram_get_latencies(ns->udf_sub_start_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_sub_restart_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_sub_dup_res_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_sub_master_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_sub_repl_write_hist, percentiles, db);
+				histogram_get_latencies(ns->udf_sub_response_hist, percentiles, db);
 			}
 			else if (strcmp(hist_name, "benchmarks-ops-sub") == 0) {
-				histogram_get_latencies(ns->ops_sub_start_hist, db);
-				histogram_get_latencies(ns->ops_sub_restart_hist, db);
-				histogram_get_latencies(ns->ops_sub_dup_res_hist, db);
-				histogram_get_latencies(ns->ops_sub_master_hist, db);
-				histogram_get_latencies(ns->ops_sub_repl_write_hist, db);
-				histogram_get_latencies(ns->ops_sub_response_hist, db);
+				histogram_get_latencies(ns->ops_sub_start_hist, percentiles, db);
+				histogram_get_latencies(ns->ops_sub_restart_hist, percentiles, db);
+				histogram_get_latencies(ns->ops_sub_dup_res_hist, percentiles, db);
+				histogram_get_latencies(ns->ops_sub_master_hist, percentiles, db);
+				histogram_get_latencies(ns->ops_sub_repl_write_hist, percentiles, db);
+				histogram_get_latencies(ns->ops_sub_response_hist, percentiles, db);
 			}
 			else {
 				cf_info(AS_INFO, "%s command: unrecognized histogram: %s", name, value_str);
@@ -4303,29 +4841,75 @@ info_command_eviction_reset(char *name, char *params, cf_dyn_buf *db)
 	return 0;
 }
 
+// Format is:
 //
-// Log a message to the server.
-// Limited to 2048 characters.
-//
-// Format:
-//	log-message:message=<MESSAGE>[;who=<WHO>]
+//	index-compact:namespace=<ns-name>
 //
-// Example:
-// 	log-message:message=Example Log Message;who=Aerospike User
+//	... returns trailing free index arena memory to the OS, e.g. after a big
+//	truncate. Holds the arena lock (and this info thread) while it runs.
 //
 int
-info_command_log_message(char *name, char *params, cf_dyn_buf *db)
+info_command_index_compact(char *name, char *params, cf_dyn_buf *db)
 {
-	char who[128];
-	int who_len = sizeof(who);
-	if (0 != as_info_parameter_get(params, "who", who, &who_len)) {
-		strcpy(who, "unknown");
-	}
+	char ns_name[AS_ID_NAMESPACE_SZ];
+	int ns_name_len = (int)sizeof(ns_name);
+	int ns_rv = as_info_parameter_get(params, "namespace", ns_name, &ns_name_len);
 
-	char message[2048];
-	int message_len = sizeof(message);
-	if (0 == as_info_parameter_get(params, "message", message, &message_len)) {
-		cf_info(AS_INFO, "%s: %s", who, message);
+	if (ns_rv != 0 || ns_name_len == 0) {
+		cf_warning(AS_INFO, "index-compact command: missing or invalid namespace name in command");
+		cf_dyn_buf_append_string(db, "ERROR::namespace-name");
+		return 0;
+	}
+
+	as_namespace *ns = as_namespace_get_byname(ns_name);
+
+	if (ns == NULL) {
+		cf_warning(AS_INFO, "index-compact command: unknown namespace %s", ns_name);
+		cf_dyn_buf_append_string(db, "ERROR::unknown-namespace");
+		return 0;
+	}
+
+	uint64_t start_ms = cf_getms();
+	uint64_t n_free;
+	uint64_t released_sz;
+
+	if (! cf_arenax_compact(ns->arena, &n_free, &released_sz)) {
+		cf_warning(AS_INFO, "index-compact command: {%s} index arena can't be compacted", ns_name);
+		cf_dyn_buf_append_string(db, "ERROR::not-supported");
+		return 0;
+	}
+
+	cf_info(AS_INFO, "{%s} index-compact: released %lu bytes, %lu free elements remain, took %lu ms",
+			ns_name, released_sz, n_free, cf_getms() - start_ms);
+
+	cf_dyn_buf_append_string(db, "ok");
+
+	return 0;
+}
+
+//
+// Log a message to the server.
+// Limited to 2048 characters.
+//
+// Format:
+//	log-message:message=<MESSAGE>[;who=<WHO>]
+//
+// Example:
+// 	log-message:message=Example Log Message;who=Aerospike User
+//
+int
+info_command_log_message(char *name, char *params, cf_dyn_buf *db)
+{
+	char who[128];
+	int who_len = sizeof(who);
+	if (0 != as_info_parameter_get(params, "who", who, &who_len)) {
+		strcpy(who, "unknown");
+	}
+
+	char message[2048];
+	int message_len = sizeof(message);
+	if (0 == as_info_parameter_get(params, "message", message, &message_len)) {
+		cf_info(AS_INFO, "%s: %s", who, message);
 	}
 
 	return 0;
@@ -4374,6 +4958,101 @@ info_static		*static_head = 0;
 info_dynamic	*dynamic_head = 0;
 info_tree		*tree_head = 0;
 info_command	*command_head = 0;
+static void
+init_snapshots(info_snapshots *ss, const char *name)
+{
+	ss->cacheable = false;
+
+	for (uint32_t i = 0; i < N_CACHEABLE_NAMES; i++) {
+		if (strcmp(name, CACHEABLE_NAMES[i]) == 0) {
+			ss->cacheable = true;
+			break;
+		}
+	}
+
+	cf_mutex_init(&ss->lock);
+	ss->n_snapshots = 0;
+	ss->head = NULL;
+}
+
+static void
+generate_value(char *name, char *branch, as_info_get_value_fn value_fn,
+		as_info_get_tree_fn tree_fn, cf_dyn_buf *db)
+{
+	if (value_fn != NULL) {
+		value_fn(name, db);
+	}
+	else {
+		tree_fn(name, branch, db);
+	}
+}
+
+//
+// Append a dynamic or tree value. Cacheable values are served from a snapshot
+// if it's younger than info-cache-ms. Otherwise the value is generated with the
+// snapshot locked, so concurrent scrapes wait for one generation rather than
+// all doing the work.
+//
+static void
+append_value(info_snapshots *ss, char *name, char *branch,
+		as_info_get_value_fn value_fn, as_info_get_tree_fn tree_fn,
+		cf_dyn_buf *db)
+{
+	uint32_t cache_ms = as_load_uint32(&g_config.info_cache_ms);
+
+	if (! ss->cacheable || cache_ms == 0) {
+		generate_value(name, branch, value_fn, tree_fn, db);
+		return;
+	}
+
+	cf_mutex_lock(&ss->lock);
+
+	info_snapshot *snap = ss->head;
+
+	while (snap != NULL) {
+		if (branch == NULL ?
+				snap->branch == NULL :
+				snap->branch != NULL && strcmp(snap->branch, branch) == 0) {
+			break;
+		}
+
+		snap = snap->next;
+	}
+
+	uint64_t now_ms = cf_getms();
+
+	if (snap != NULL && now_ms < snap->expire_ms) {
+		cf_dyn_buf_append_buf(db, snap->value, snap->value_sz);
+		cf_mutex_unlock(&ss->lock);
+		return;
+	}
+
+	size_t start = db->used_sz;
+
+	generate_value(name, branch, value_fn, tree_fn, db);
+
+	if (snap == NULL) {
+		if (ss->n_snapshots == MAX_SNAPSHOTS) {
+			cf_mutex_unlock(&ss->lock);
+			return;
+		}
+
+		snap = cf_malloc(sizeof(info_snapshot));
+		snap->branch = branch != NULL ? cf_strdup(branch) : NULL;
+		snap->value = NULL;
+		snap->next = ss->head;
+		ss->head = snap;
+		ss->n_snapshots++;
+	}
+
+	snap->value_sz = db->used_sz - start;
+	snap->value = cf_realloc(snap->value, snap->value_sz + 1);
+	memcpy(snap->value, db->buf + start, snap->value_sz);
+	snap->expire_ms = now_ms + cache_ms;
+
+	cf_mutex_unlock(&ss->lock);
+}
+
 //
 // Pull up all elements in both list into the buffers
 // (efficient enough if you're looking for lots of things)
@@ -4408,7 +5087,7 @@ info_all(const as_file_handle* fd_h, cf_dyn_buf *db)
 		if (d->def == true) {
 			cf_dyn_buf_append_string( db, d->name);
 			cf_dyn_buf_append_char(db, SEP );
-			d->value_fn(d->name, db);
+			append_value(&d->snapshots, d->name, NULL, d->value_fn, NULL, db);
 			cf_dyn_buf_append_char(db, EOL);
 		}
 		d = d->next;
@@ -4469,7 +5148,8 @@ info_some(char *buf, char *buf_lim, const as_file_handle* fd_h, cf_dyn_buf *db)
 						// return exact command string received from client
 						cf_dyn_buf_append_string( db, d->name);
 						cf_dyn_buf_append_char(db, SEP );
-						d->value_fn(d->name, db);
+						append_value(&d->snapshots, d->name, NULL, d->value_fn,
+								NULL, db);
 						cf_dyn_buf_append_char(db, EOL);
 						handled = true;
 						break;
@@ -4495,7 +5175,8 @@ info_some(char *buf, char *buf_lim, const as_file_handle* fd_h, cf_dyn_buf *db)
 							cf_dyn_buf_append_char( db, TREE_SEP);
 							cf_dyn_buf_append_string( db, branch);
 							cf_dyn_buf_append_char(db, SEP );
-							t->tree_fn(t->name, branch, db);
+							append_value(&t->snapshots, t->name, branch, NULL,
+									t->tree_fn, db);
 							cf_dyn_buf_append_char(db, EOL);
 							break;
 						}
@@ -4721,6 +5402,7 @@ as_info_set_dynamic(const char *name, as_info_get_value_fn gv_fn, bool def)
 		e->def = def;
 		e->name = cf_strdup(name);
 		e->value_fn = gv_fn;
+		init_snapshots(&e->snapshots, name);
 		e->next = dynamic_head;
 		dynamic_head = e;
 	}
@@ -4756,6 +5438,7 @@ as_info_set_tree(char *name, as_info_get_tree_fn gv_fn)
 		e = cf_malloc(sizeof(info_tree));
 		e->name = cf_strdup(name);
 		e->tree_fn = gv_fn;
+		init_snapshots(&e->snapshots, name);
 		e->next = tree_head;
 		tree_head = e;
 	}
@@ -4966,6 +5649,36 @@ info_get_health_stats(char *name, cf_dyn_buf *db)
 	return(0);
 }
 
+// Per namespace, this node's recent device read latency (if health checks are
+// enabled) and CPU load, for clients weighting replica choice - e.g.
+// "test:read-latency-us=180:device-outlier=false:load-pct=35;..."
+int
+info_get_read_hints(char *name, cf_dyn_buf *db)
+{
+	uint32_t load_pct = g_process_cpu_pct / cf_topo_count_cpus();
+
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		uint32_t lat_us;
+
+		cf_dyn_buf_append_string(db, g_config.namespaces[ns_ix]->name);
+		cf_dyn_buf_append_char(db, ':');
+
+		if (as_health_recent_read_latency(ns_ix, &lat_us)) {
+			cf_dyn_buf_append_format(db, "read-latency-us=%u:device-outlier=%s:",
+					lat_us, as_health_has_device_outlier(ns_ix) ?
+							"true" : "false");
+		}
+
+		cf_dyn_buf_append_format(db, "load-pct=%u;", load_pct);
+	}
+
+	if (g_config.n_namespaces > 0) {
+		cf_dyn_buf_chomp(db);
+	}
+
+	return(0);
+}
+
 int
 info_get_index_pressure(char *name, cf_dyn_buf *db)
 {
@@ -5023,6 +5736,43 @@ info_get_smd_info(char *name, cf_dyn_buf *db)
 	return (0);
 }
 
+int
+info_get_slow_transactions(char *name, cf_dyn_buf *db)
+{
+	as_slow_log_get(db);
+
+	return (0);
+}
+
+int
+info_get_stats_snapshot(char *name, cf_dyn_buf *db)
+{
+	as_stats_snapshot_get(db);
+
+	return (0);
+}
+
+// Per thread role, as of the last ticker sample - e.g.
+// "role=run_service:threads=4:cpu-pct=212:wait-pct=31:vcsw-per-sec=5120:ivcsw-per-sec=340;..."
+int
+info_get_thread_stats(char *name, cf_dyn_buf *db)
+{
+	cf_thread_role_stats stats[CF_THREAD_MAX_ROLES];
+	uint32_t n_stats = cf_thread_get_role_stats(stats, CF_THREAD_MAX_ROLES);
+
+	for (uint32_t i = 0; i < n_stats; i++) {
+		const cf_thread_role_stats *rs = &stats[i];
+
+		cf_dyn_buf_append_format(db, "role=%s:threads=%u:cpu-pct=%u:wait-pct=%u:vcsw-per-sec=%lu:ivcsw-per-sec=%lu;",
+				rs->name, rs->n_threads, rs->cpu_pct, rs->wait_pct,
+				rs->vcsw_per_sec, rs->ivcsw_per_sec);
+	}
+
+	cf_dyn_buf_chomp_char(db, ';');
+
+	return (0);
+}
+
 int
 info_get_bins(char *name, cf_dyn_buf *db)
 {
@@ -5090,6 +5840,11 @@ add_data_device_stats(as_namespace *ns, cf_dyn_buf *db)
 		info_append_indexed_uint32(db, tag, i, "defrag_q", stats.defrag_q_sz);
 		info_append_indexed_uint64(db, tag, i, "defrag_reads", stats.n_defrag_reads);
 		info_append_indexed_uint64(db, tag, i, "defrag_writes", stats.n_defrag_writes);
+		info_append_indexed_uint64(db, tag, i, "defrag_bytes_moved", stats.n_defrag_bytes_moved);
+		info_append_indexed_uint64(db, tag, i, "defrag_bytes_reclaimed", stats.n_defrag_bytes_reclaimed);
+
+		info_append_indexed_uint64(db, tag, i, "partial_flushes", stats.n_partial_flushes);
+		info_append_indexed_uint64(db, tag, i, "partial_flush_bytes", stats.n_partial_flush_bytes);
 
 		info_append_indexed_uint32(db, tag, i, "shadow_write_q", stats.shadow_write_q_sz);
 
@@ -5145,6 +5900,7 @@ info_get_namespace_info(as_namespace *ns, cf_dyn_buf *db)
 	info_append_uint32(db, "evict_void_time", ns->evict_void_time);
 	info_append_uint32(db, "smd_evict_void_time", ns->smd_evict_void_time);
 	info_append_uint32(db, "nsup_cycle_duration", ns->nsup_cycle_duration);
+	info_append_uint64(db, "memory_defrag_moved", ns->n_memory_defrag_moved);
 
 	// Truncate stats.
 
@@ -5157,7 +5913,7 @@ info_get_namespace_info(as_namespace *ns, cf_dyn_buf *db)
 
 	// Memory usage stats.
 
-	uint64_t index_used = (ns->n_tombstones + ns->n_objects) * sizeof(as_index);
+	uint64_t index_used = (ns->n_tombstones + ns->n_objects) * ns->arena->element_size;
 
 	uint64_t data_memory = ns->n_bytes_memory;
 	uint64_t index_memory = as_namespace_index_persisted(ns) ? 0 : index_used;
@@ -5171,11 +5927,23 @@ info_get_namespace_info(as_namespace *ns, cf_dyn_buf *db)
 	info_append_uint64(db, "memory_used_set_index_bytes", set_index_memory);
 	info_append_uint64(db, "memory_used_sindex_bytes", sindex_memory);
 
+	if (ns->storage_data_in_memory) {
+		info_append_uint64(db, "heap_data_kbytes",
+				cf_alloc_arena_kbytes(ns->jem_arena));
+	}
+
 	uint64_t free_pct = ns->memory_size > used_memory ?
 			((ns->memory_size - used_memory) * 100L) / ns->memory_size : 0;
 
 	info_append_uint64(db, "memory_free_pct", free_pct);
 
+	// Index arena stages - TLB reach depends on how many got huge pages.
+	if (ns->xmem_type == CF_XMEM_TYPE_MEM) {
+		info_append_uint32(db, "index_stages", ns->arena->stage_count);
+		info_append_uint32(db, "index_huge_page_stages",
+				ns->arena->huge_stage_count);
+	}
+
 	// Persistent memory block keys' namespace ID (enterprise only).
 	info_append_uint32(db, "xmem_id", ns->xmem_id);
 
@@ -5267,6 +6035,22 @@ info_get_namespace_info(as_namespace *ns, cf_dyn_buf *db)
 			info_append_int(db, "cache_read_pct", (int)(ns->cache_read_pct + 0.5));
 		}
 
+		if (ns->n_storage_shadows != 0) {
+			info_append_uint32(db, "shadow_lag_wblocks", cf_atomic32_get(ns->n_shadow_wblocks_lagging));
+			info_append_uint64(db, "shadow_lag_throttles", cf_atomic64_get(ns->n_shadow_lag_throttles));
+		}
+
+		uint64_t read_cache_bytes;
+		uint64_t read_cache_hits;
+		uint64_t read_cache_misses;
+
+		if (as_storage_read_cache_stats_ssd(ns, &read_cache_bytes,
+				&read_cache_hits, &read_cache_misses)) {
+			info_append_uint64(db, "read_cache_used_bytes", read_cache_bytes);
+			info_append_uint64(db, "read_cache_hits", read_cache_hits);
+			info_append_uint64(db, "read_cache_misses", read_cache_misses);
+		}
+
 		add_data_device_stats(ns, db);
 	}
 
@@ -5579,11 +6363,18 @@ info_get_namespace_info(as_namespace *ns, cf_dyn_buf *db)
 	info_append_uint64(db, "si_query_ops_bg_error", ns->n_si_query_ops_bg_error);
 	info_append_uint64(db, "si_query_ops_bg_abort", ns->n_si_query_ops_bg_abort);
 
+	info_append_uint64(db, "si_query_index_only_records", ns->n_si_query_index_only_records);
+
+	info_append_uint64(db, "si_query_cache_hits", ns->n_si_query_cache_hits);
+	info_append_uint64(db, "si_query_cache_misses", ns->n_si_query_cache_misses);
+	info_append_uint64(db, "si_query_cache_bytes", ns->si_query_cache_bytes);
+
 	// Geospatial query stats:
 	info_append_uint64(db, "geo_region_query_reqs", ns->geo_region_query_count);
 	info_append_uint64(db, "geo_region_query_cells", ns->geo_region_query_cells);
 	info_append_uint64(db, "geo_region_query_points", ns->geo_region_query_points);
 	info_append_uint64(db, "geo_region_query_falsepos", ns->geo_region_query_falsepos);
+	info_append_uint64(db, "geo_region_query_cache_hits", ns->geo_region_query_cache_hits);
 
 	// Re-replication stats - relevant only for enterprise edition.
 
@@ -5603,6 +6394,7 @@ info_get_namespace_info(as_namespace *ns, cf_dyn_buf *db)
 	// Special non-error counters:
 
 	info_append_uint64(db, "deleted_last_bin", ns->n_deleted_last_bin);
+	info_append_uint64(db, "reads_steered", ns->n_reads_steered);
 }
 
 //
@@ -5702,6 +6494,67 @@ info_get_tree_bins(char *name, char *subtree, cf_dyn_buf *db)
 	return 0;
 }
 
+int
+info_command_device_latency_map(char *name, char *params, cf_dyn_buf *db)
+{
+	char ns_name[AS_ID_NAMESPACE_SZ];
+	int ns_name_len = (int)sizeof(ns_name);
+
+	if (as_info_parameter_get(params, "namespace", ns_name, &ns_name_len) != 0) {
+		cf_info(AS_INFO, "%s command: no namespace specified", name);
+		cf_dyn_buf_append_string(db, "ERROR::no-namespace");
+		return 0;
+	}
+
+	as_namespace *ns = as_namespace_get_byname(ns_name);
+
+	if (ns == NULL) {
+		cf_info(AS_INFO, "%s command: unknown namespace: %s", name, ns_name);
+		cf_dyn_buf_append_string(db, "ERROR::unknown-namespace");
+		return 0;
+	}
+
+	as_device_heat_get(ns, db);
+
+	return 0;
+}
+
+int
+info_command_hot_keys(char *name, char *params, cf_dyn_buf *db)
+{
+	char ns_name[AS_ID_NAMESPACE_SZ];
+	int ns_name_len = (int)sizeof(ns_name);
+
+	if (as_info_parameter_get(params, "namespace", ns_name, &ns_name_len) != 0) {
+		cf_info(AS_INFO, "%s command: no namespace specified", name);
+		cf_dyn_buf_append_string(db, "ERROR::no-namespace");
+		return 0;
+	}
+
+	as_namespace *ns = as_namespace_get_byname(ns_name);
+
+	if (ns == NULL) {
+		cf_info(AS_INFO, "%s command: unknown namespace: %s", name, ns_name);
+		cf_dyn_buf_append_string(db, "ERROR::unknown-namespace");
+		return 0;
+	}
+
+	char max_str[12];
+	int max_str_len = (int)sizeof(max_str);
+	int max_keys = 10;
+
+	if (as_info_parameter_get(params, "max", max_str, &max_str_len) == 0 &&
+			(cf_str_atoi(max_str, &max_keys) != 0 || max_keys <= 0)) {
+		cf_info(AS_INFO, "%s command: bad max: %s", name, max_str);
+		cf_dyn_buf_append_string(db, "ERROR::bad-max");
+		return 0;
+	}
+
+	as_hot_keys_get(ns, (uint32_t)max_keys, db);
+
+	return 0;
+}
+
 int
 info_command_histogram(char *name, char *params, cf_dyn_buf *db)
 {
@@ -5998,6 +6851,7 @@ info_command_sindex_create(char *name, char *params, cf_dyn_buf *db)
 	// sindex-create:ns=usermap;set=demo;indexname=um_age;indextype=list;indexdata=age,numeric
 	// sindex-create:ns=usermap;set=demo;indexname=um_state;indexdata=state,string
 	// sindex-create:ns=usermap;set=demo;indexname=um_highscore;context=<base64-cdt-ctx>;indexdata=scores,numeric
+	// sindex-create:ns=usermap;set=demo;indexname=um_bmi;exp=<base64-exp>;indexdata=body,numeric
 
 	char index_name_str[INAME_MAX_SZ];
 	int index_name_len = sizeof(index_name_str);
@@ -6100,6 +6954,29 @@ info_command_sindex_create(char *name, char *params, cf_dyn_buf *db)
 		return 0;
 	}
 
+	// Validated once the bin name is known.
+	char exp_b64[EXP_B64_MAX_SZ];
+	int exp_b64_len = sizeof(exp_b64);
+	const char* p_exp = NULL;
+
+	rv = as_info_parameter_get(params, "exp", exp_b64, &exp_b64_len);
+
+	if (rv == 0) {
+		if (p_cdt_ctx != NULL) {
+			cf_warning(AS_INFO, "sindex-create %s: 'context' and 'exp' are exclusive",
+					index_name_str);
+			INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "'context' and 'exp' are exclusive");
+			return 0;
+		}
+
+		p_exp = exp_b64;
+	}
+	else if (rv == -2) {
+		cf_warning(AS_INFO, "sindex-create %s: 'exp' too long", index_name_str);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "'exp' too long");
+		return 0;
+	}
+
 	char indextype_str[INDEXTYPE_MAX_SZ];
 	int indtype_len = sizeof(indextype_str);
 	as_sindex_type itype;
@@ -6184,13 +7061,42 @@ info_command_sindex_create(char *name, char *params, cf_dyn_buf *db)
 		return 0;
 	}
 
+	if (p_exp != NULL) {
+		uint8_t* buf;
+		as_exp* exp;
+		int32_t buf_sz = as_sindex_exp_b64_decode(exp_b64,
+				(uint32_t)exp_b64_len, bin_name, &buf, &exp);
+
+		switch (buf_sz) {
+		case -1:
+			cf_warning(AS_INFO, "sindex-create %s: 'exp' invalid base64",
+					index_name_str);
+			INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "'exp' invalid base64");
+			return 0;
+		case -2:
+			cf_warning(AS_INFO, "sindex-create %s: 'exp' invalid expression",
+					index_name_str);
+			INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "'exp' invalid expression");
+			return 0;
+		case -3:
+			cf_warning(AS_INFO, "sindex-create %s: 'exp' must read only bin '%s'",
+					index_name_str, bin_name);
+			INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "'exp' must read only the 'indexdata' bin");
+			return 0;
+		default:
+			as_exp_destroy(exp);
+			cf_free(buf);
+			break;
+		}
+	}
+
 	cf_info(AS_INFO, "sindex-create: request received for %s:%s via info",
 			ns_str, index_name_str);
 
 	char smd_key[SINDEX_SMD_KEY_MAX_SZ];
 
-	as_sindex_build_smd_key(ns_str, p_set_str, bin_name, p_cdt_ctx, itype,
-			ktype, smd_key);
+	as_sindex_build_smd_key(ns_str, p_set_str, bin_name, p_cdt_ctx, p_exp,
+			itype, ktype, smd_key);
 
 	find_sindex_key_udata fsk = {
 			.ns_name = ns_str,
@@ -6556,6 +7462,199 @@ int info_command_sindex_stat(char *name, char *params, cf_dyn_buf *db) {
 	return(0);
 }
 
+int
+info_command_sindex_estimate(char *name, char *params, cf_dyn_buf *db)
+{
+	// Command format:
+	// sindex-estimate:ns=usermap;indexname=um_age;begin=20;end=30
+
+	as_namespace* ns = NULL;
+	char* iname = NULL;
+
+	if (as_info_parse_ns_iname(params, &ns, &iname, db, "sindex-estimate")) {
+		return 0;
+	}
+
+	char begin_str[24];
+	int begin_len = sizeof(begin_str);
+	char end_str[24];
+	int end_len = sizeof(end_str);
+	int64_t begin;
+	int64_t end;
+
+	if (as_info_parameter_get(params, "begin", begin_str, &begin_len) != 0 ||
+			cf_str_atoi_64(begin_str, &begin) != 0 ||
+			as_info_parameter_get(params, "end", end_str, &end_len) != 0 ||
+			cf_str_atoi_64(end_str, &end) != 0) {
+		cf_warning(AS_INFO, "sindex-estimate %s: bad or missing 'begin' or 'end'",
+				iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER,
+				"bad or missing 'begin' or 'end'");
+		cf_free(iname);
+		return 0;
+	}
+
+	if (! as_sindex_estimate_str(ns, iname, begin, end, db)) {
+		INFO_FAIL_RESPONSE(db, AS_ERR_SINDEX_NOT_FOUND, "NO INDEX");
+	}
+
+	cf_free(iname);
+
+	return 0;
+}
+
+int
+info_command_sindex_aggregate(char *name, char *params, cf_dyn_buf *db)
+{
+	// Command format:
+	// sindex-aggregate:ns=usermap;indexname=um_age[;scope=master|all]
+
+	as_namespace* ns = NULL;
+	char* iname = NULL;
+
+	if (as_info_parse_ns_iname(params, &ns, &iname, db, "sindex-aggregate")) {
+		return 0;
+	}
+
+	// Default is this node's master partitions, so results sum across nodes.
+	char scope_str[8];
+	int scope_len = sizeof(scope_str);
+	bool master_only = true;
+	int rv = as_info_parameter_get(params, "scope", scope_str, &scope_len);
+
+	if (rv == 0) {
+		if (strcmp(scope_str, "all") == 0) {
+			master_only = false;
+		}
+		else if (strcmp(scope_str, "master") != 0) {
+			rv = -2;
+		}
+	}
+
+	if (rv == -2) {
+		cf_warning(AS_INFO, "sindex-aggregate %s: bad 'scope'", iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER,
+				"bad 'scope' - must be 'master' or 'all'");
+		cf_free(iname);
+		return 0;
+	}
+
+	if (! as_sindex_aggregate_str(ns, iname, master_only, db)) {
+		INFO_FAIL_RESPONSE(db, AS_ERR_SINDEX_NOT_FOUND, "NO INDEX");
+	}
+
+	cf_free(iname);
+
+	return 0;
+}
+
+int
+info_command_sindex_count(char *name, char *params, cf_dyn_buf *db)
+{
+	// Command format:
+	// sindex-count:ns=usermap;indexname=um_age;begin=20;end=30[;set=users]
+	//		[;min-void-time=<sec>][;max-void-time=<sec>][;scope=master|all]
+
+	as_namespace* ns = NULL;
+	char* iname = NULL;
+
+	if (as_info_parse_ns_iname(params, &ns, &iname, db, "sindex-count")) {
+		return 0;
+	}
+
+	char begin_str[24];
+	int begin_len = sizeof(begin_str);
+	char end_str[24];
+	int end_len = sizeof(end_str);
+	int64_t begin;
+	int64_t end;
+
+	if (as_info_parameter_get(params, "begin", begin_str, &begin_len) != 0 ||
+			cf_str_atoi_64(begin_str, &begin) != 0 ||
+			as_info_parameter_get(params, "end", end_str, &end_len) != 0 ||
+			cf_str_atoi_64(end_str, &end) != 0) {
+		cf_warning(AS_INFO, "sindex-count %s: bad or missing 'begin' or 'end'",
+				iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER,
+				"bad or missing 'begin' or 'end'");
+		cf_free(iname);
+		return 0;
+	}
+
+	as_sindex_count_filter filter = { 0 };
+
+	char set_str[AS_SET_NAME_MAX_SIZE];
+	int set_len = sizeof(set_str);
+	int rv = as_info_parameter_get(params, "set", set_str, &set_len);
+
+	if (rv == -2) {
+		cf_warning(AS_INFO, "sindex-count %s: bad 'set'", iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "bad 'set'");
+		cf_free(iname);
+		return 0;
+	}
+
+	if (rv == 0) {
+		// Unknown set - nothing will match.
+		filter.has_set = true;
+		filter.set_id = as_namespace_get_set_id(ns, set_str);
+	}
+
+	char vt_str[24];
+	int vt_len = sizeof(vt_str);
+
+	if (as_info_parameter_get(params, "min-void-time", vt_str, &vt_len) == 0 &&
+			cf_str_atoi_u32(vt_str, &filter.min_void_time) != 0) {
+		cf_warning(AS_INFO, "sindex-count %s: bad 'min-void-time'", iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "bad 'min-void-time'");
+		cf_free(iname);
+		return 0;
+	}
+
+	vt_len = sizeof(vt_str);
+
+	if (as_info_parameter_get(params, "max-void-time", vt_str, &vt_len) == 0 &&
+			cf_str_atoi_u32(vt_str, &filter.max_void_time) != 0) {
+		cf_warning(AS_INFO, "sindex-count %s: bad 'max-void-time'", iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER, "bad 'max-void-time'");
+		cf_free(iname);
+		return 0;
+	}
+
+	// Default is this node's master partitions, so results sum across nodes.
+	char scope_str[8];
+	int scope_len = sizeof(scope_str);
+	bool master_only = true;
+
+	rv = as_info_parameter_get(params, "scope", scope_str, &scope_len);
+
+	if (rv == 0) {
+		if (strcmp(scope_str, "all") == 0) {
+			master_only = false;
+		}
+		else if (strcmp(scope_str, "master") != 0) {
+			rv = -2;
+		}
+	}
+
+	if (rv == -2) {
+		cf_warning(AS_INFO, "sindex-count %s: bad 'scope'", iname);
+		INFO_FAIL_RESPONSE(db, AS_ERR_PARAMETER,
+				"bad 'scope' - must be 'master' or 'all'");
+		cf_free(iname);
+		return 0;
+	}
+
+	if (! as_sindex_count_str(ns, iname, begin, end, master_only, &filter,
+			db)) {
+		INFO_FAIL_RESPONSE(db, AS_ERR_SINDEX_NOT_FOUND, "NO INDEX");
+	}
+
+	cf_free(iname);
+
+	return 0;
+}
+
 int
 info_command_sindex_list(char *name, char *params, cf_dyn_buf *db)
 {
@@ -6724,6 +7823,7 @@ as_info_init()
 	as_info_set_dynamic("peers-tls-std", as_service_list_dynamic, false);             // Supersedes "services" for TLS, standard addresses.
 	as_info_set_dynamic("rack-ids", info_get_rack_ids, false);                        // Effective rack-ids for all namespaces on this node.
 	as_info_set_dynamic("rebalance-generation", info_get_rebalance_generation, false); // How many rebalances we've done.
+	as_info_set_dynamic("read-hints", info_get_read_hints, false);                    // Returns this node's recent read latency and load per namespace, for weighting replica reads.
 	as_info_set_dynamic("replicas", info_get_replicas, false);                        // Same as replicas-all, but includes regime.
 	as_info_set_dynamic("replicas-all", info_get_replicas_all, false);                // Base 64 encoded binary representation of partitions this node is replica for.
 	as_info_set_dynamic("replicas-master", info_get_replicas_master, false);          // Base 64 encoded binary representation of partitions this node is master (replica) for.
@@ -6741,9 +7841,13 @@ as_info_init()
 	as_info_set_dynamic("services-alumni", as_service_list_dynamic, true);            // All neighbor addresses (services) this server has ever know about.
 	as_info_set_dynamic("services-alumni-reset", as_service_list_dynamic, false);     // Reset the services alumni to equal services.
 	as_info_set_dynamic("sets", info_get_sets, false);                                // Returns set statistics for all or a particular set.
+	as_info_set_dynamic("slow-transactions", info_get_slow_transactions, false);      // Returns the slowest transactions of the last window, with stage timings.
 	as_info_set_dynamic("smd-info", info_get_smd_info, false);                        // Returns SMD state information.
 	as_info_set_dynamic("statistics", info_get_stats, true);                          // Returns system health and usage stats for this server.
+	as_info_set_dynamic("stats-snapshot", info_get_stats_snapshot, false);            // Returns the last stats snapshot published by the ticker.
+	as_info_set_dynamic("thread-stats", info_get_thread_stats, false);                // Returns per-role thread CPU, run-queue wait and context switch rates.
 	as_info_set_dynamic("thread-traces", cf_thread_traces, false);                    // Returns backtraces for all threads.
+	as_info_set_dynamic("profile", cf_thread_profile, false);                         // Returns sampled stacks since last asked, folded for flame graphs.
 
 	// Tree-based names
 	as_info_set_tree("bins", info_get_tree_bins);           // Returns bin usage information and used bin names for all or a particular namespace.
@@ -6755,6 +7859,7 @@ as_info_init()
 	as_info_set_command("cluster-stable", info_command_cluster_stable, PERM_NONE);            // Returns cluster key if cluster is stable.
 	as_info_set_command("config-get", info_command_config_get, PERM_NONE);                    // Returns running config for specified context.
 	as_info_set_command("config-set", info_command_config_set, PERM_SET_CONFIG);              // Set a configuration parameter at run time, configuration parameter must be dynamic.
+	as_info_set_command("device-latency-map", info_command_device_latency_map, PERM_NONE);    // Returns per-device read & write latency heat maps of a namespace.
 	as_info_set_command("dump-cluster", info_command_dump_cluster, PERM_LOGGING_CTRL);        // Print debug information about clustering and exchange to the log file.
 	as_info_set_command("dump-fabric", info_command_dump_fabric, PERM_LOGGING_CTRL);          // Print debug information about fabric to the log file.
 	as_info_set_command("dump-hb", info_command_dump_hb, PERM_LOGGING_CTRL);                  // Print debug information about heartbeat state to the log file.
@@ -6768,6 +7873,8 @@ as_info_init()
 	as_info_set_command("get-sl", info_command_get_sl, PERM_NONE);                            // Get the Paxos succession list.
 	as_info_set_command("get-stats", info_command_get_stats, PERM_NONE);                      // Returns statistics for a particular context.
 	as_info_set_command("histogram", info_command_histogram, PERM_NONE);                      // Returns a histogram snapshot for a particular histogram.
+	as_info_set_command("hot-keys", info_command_hot_keys, PERM_NONE);                        // Returns the hottest sampled keys of a namespace, with rates.
+	as_info_set_command("index-compact", info_command_index_compact, PERM_SERVICE_CTRL);      // Return trailing free index arena memory to the OS.
 	as_info_set_command("jem-stats", info_command_jem_stats, PERM_LOGGING_CTRL);              // Print JEMalloc statistics to the log file.
 	as_info_set_command("latencies", info_command_latencies, PERM_NONE);                      // Returns latency and throughput information.
 	as_info_set_command("log-message", info_command_log_message, PERM_LOGGING_CTRL);          // Log a message.
@@ -6781,6 +7888,7 @@ as_info_init()
 	as_info_set_command("quiesce-undo", info_command_quiesce_undo, PERM_SERVICE_CTRL);        // Un-quiesce this node.
 	as_info_set_command("racks", info_command_racks, PERM_NONE);                              // Rack-aware information.
 	as_info_set_command("recluster", info_command_recluster, PERM_SERVICE_CTRL);              // Force cluster to re-form.
+	as_info_set_command("partition-generation-wait", info_command_partition_generation_wait, PERM_NONE); // Returns partition generation once it differs from the given one, or at timeout.
 	as_info_set_command("replicas", info_command_replicas, PERM_NONE);                        // Same as 'dynamic' replicas, but with 'max' param.
 	as_info_set_command("revive", info_command_revive, PERM_SERVICE_CTRL);                    // Mark "untrusted" partitions as "revived".
 	as_info_set_command("roster", info_command_roster, PERM_NONE);                            // Roster information.
@@ -6825,6 +7933,9 @@ as_info_init()
 	as_info_set_command("query-abort-all", info_command_abort_all_queries, PERM_QUERY_ADMIN); // Abort all queries.
 
 	as_info_set_command("sindex-stat", info_command_sindex_stat, PERM_NONE);
+	as_info_set_command("sindex-estimate", info_command_sindex_estimate, PERM_NONE); // Estimate entries in a sindex range.
+	as_info_set_command("sindex-aggregate", info_command_sindex_aggregate, PERM_NONE); // Count, sum, min and max of sindex entries.
+	as_info_set_command("sindex-count", info_command_sindex_count, PERM_NONE); // Count live records in a sindex range.
 	as_info_set_command("sindex-list", info_command_sindex_list, PERM_NONE);
 
 	// XDR
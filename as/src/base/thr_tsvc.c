@@ -40,8 +40,11 @@
 
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/health.h"
+#include "base/probes.h"
 #include "base/proto.h"
 #include "base/security.h"
+#include "base/slow_log.h"
 #include "base/stats.h"
 #include "base/transaction.h"
 #include "base/transaction_policy.h"
@@ -69,6 +72,15 @@ should_security_check_data_op(const as_transaction *tr)
 	return tr->origin == FROM_CLIENT || tr->origin == FROM_BATCH;
 }
 
+// Proxied reads are never steered, so they can't bounce between nodes.
+static inline bool
+should_steer_read(const as_transaction *tr, const as_namespace *ns)
+{
+	return ns->read_steer_device_outliers && ! ns->cp &&
+			(tr->origin == FROM_CLIENT || tr->origin == FROM_BATCH) &&
+			as_health_has_device_outlier(ns->ix);
+}
+
 static inline as_sec_perm
 query_perm(const as_transaction *tr)
 {
@@ -117,6 +129,7 @@ as_tsvc_process_transaction(as_transaction *tr)
 	as_msg *m = &msgp->msg;
 
 	as_transaction_init_body(tr);
+	as_slow_log_mark_dispatch(tr);
 
 	// Check that the socket is authenticated.
 	if (tr->origin == FROM_CLIENT) {
@@ -244,6 +257,10 @@ as_tsvc_process_transaction(as_transaction *tr)
 		}
 
 		rv = as_partition_reserve_write(ns, pid, &tr->rsv, &dest);
+
+		if (rv == -1) {
+			cf_atomic32_incr(&ns->partitions[pid].n_unmigrated_hits);
+		}
 	}
 	else if (is_read) {
 		if (should_security_check_data_op(tr) &&
@@ -253,6 +270,22 @@ as_tsvc_process_transaction(as_transaction *tr)
 		}
 
 		rv = as_partition_reserve_read_tr(ns, pid, tr, &dest);
+
+		if (rv == -1) {
+			cf_atomic32_incr(&ns->partitions[pid].n_unmigrated_hits);
+		}
+
+		if (rv == 0 && should_steer_read(tr, ns)) {
+			cf_node steer_dest = as_partition_steer_read_node(ns, pid);
+
+			if (steer_dest != (cf_node)0) {
+				// Divert below as if reservation had failed.
+				as_partition_release(&tr->rsv);
+				cf_atomic64_incr(&ns->n_reads_steered);
+				dest = steer_dest;
+				rv = -1;
+			}
+		}
 	}
 	else {
 		cf_warning(AS_TSVC, "transaction is neither read nor write - unexpected");
@@ -260,6 +293,8 @@ as_tsvc_process_transaction(as_transaction *tr)
 		goto Cleanup;
 	}
 
+	ASD_PROBE3(trans__reserve, as_probe_keyd(&tr->keyd), pid, rv);
+
 	if (rv == -2) {
 		// Partition is unavailable.
 		as_transaction_error(tr, ns, AS_ERR_UNAVAILABLE);
@@ -43,12 +43,15 @@
 #include "dynbuf.h"
 #include "hist.h"
 #include "log.h"
+#include "slab.h"
 
 #include "base/cfg.h"
 #include "base/datamodel.h"
 #include "base/index.h"
+#include "base/set_hist.h"
 #include "base/set_index.h"
 #include "base/stats.h"
+#include "base/stats_snapshot.h"
 #include "base/thr_info.h"
 #include "base/thr_tsvc.h"
 #include "fabric/clustering.h"
@@ -76,6 +79,9 @@ void log_ticker_frame(uint64_t delta_time);
 void log_line_clock();
 void log_line_system();
 void log_line_process();
+void log_line_threads();
+void log_line_heap_by_sys();
+void log_line_slabs();
 void log_line_in_progress();
 void log_line_fds();
 void log_line_heartbeat();
@@ -117,6 +123,8 @@ void dump_namespace_histograms(as_namespace* ns);
 void
 as_ticker_start()
 {
+	as_stats_snapshot_init();
+
 	cf_thread_create_detached(run_ticker, NULL);
 }
 
@@ -138,6 +146,9 @@ run_ticker(void* arg)
 		sleep(1); // wake up every second to check
 
 		uint64_t curr_time = cf_getns();
+
+		as_stats_snapshot_update(curr_time);
+
 		uint64_t delta_time = curr_time - last_time;
 
 		if (delta_time < (uint64_t)g_config.ticker_interval * 1000000000) {
@@ -167,6 +178,9 @@ log_ticker_frame(uint64_t delta_time)
 	log_line_clock();
 	log_line_system();
 	log_line_process();
+	log_line_threads();
+	log_line_heap_by_sys();
+	log_line_slabs();
 	log_line_in_progress();
 	log_line_fds();
 	log_line_heartbeat();
@@ -181,7 +195,7 @@ log_ticker_frame(uint64_t delta_time)
 
 		uint64_t n_objects = ns->n_objects;
 		uint64_t n_tombstones = ns->n_tombstones;
-		uint64_t index_used_sz = (n_objects + n_tombstones) * sizeof(as_index);
+		uint64_t index_used_sz = (n_objects + n_tombstones) * ns->arena->element_size;
 
 		repl_stats mp;
 		as_partition_get_replica_stats(ns, &mp);
@@ -281,14 +295,69 @@ log_line_process()
 			efficiency_pct);
 }
 
+void
+log_line_threads()
+{
+	cf_thread_sample_stats();
+
+	cf_thread_role_stats stats[CF_THREAD_MAX_ROLES];
+	uint32_t n_stats = cf_thread_get_role_stats(stats, CF_THREAD_MAX_ROLES);
+
+	for (uint32_t i = 0; i < n_stats; i++) {
+		const cf_thread_role_stats* rs = &stats[i];
+
+		// Skip idle roles - there are many.
+		if (rs->cpu_pct == 0 && rs->wait_pct == 0) {
+			continue;
+		}
+
+		cf_info(AS_INFO, "   threads: %s (%u) cpu-pct %u wait-pct %u csw-per-sec (%lu,%lu)",
+				rs->name, rs->n_threads, rs->cpu_pct, rs->wait_pct,
+				rs->vcsw_per_sec, rs->ivcsw_per_sec);
+	}
+}
+
+void
+log_line_heap_by_sys()
+{
+	size_t sys_kbytes[CF_ALLOC_N_SYS];
+
+	cf_alloc_sys_stats(sys_kbytes);
+
+	cf_info(AS_INFO, "   heap-kbytes: transaction %lu fabric %lu query %lu",
+			sys_kbytes[CF_ALLOC_SYS_TRANSACTION],
+			sys_kbytes[CF_ALLOC_SYS_FABRIC],
+			sys_kbytes[CF_ALLOC_SYS_QUERY]);
+}
+
+void
+log_line_slabs()
+{
+	cf_slab_stats stats[CF_SLAB_MAX];
+	uint32_t n_slabs = cf_slab_get_stats(stats, CF_SLAB_MAX);
+
+	for (uint32_t i = 0; i < n_slabs; i++) {
+		cf_slab_stats* s = &stats[i];
+
+		if (s->n_objects == 0) {
+			continue;
+		}
+
+		cf_info(AS_INFO, "   slab %s: objects %lu kbytes %lu depot-objects %lu",
+				s->name, s->n_objects, (s->n_objects * s->obj_sz) / 1024,
+				s->n_depot_objects);
+	}
+}
+
 void
 log_line_in_progress()
 {
-	cf_info(AS_INFO, "   in-progress: info-q %u rw-hash %u proxy-hash %u tree-gc-q %u long-queries %u",
+	cf_info(AS_INFO, "   in-progress: info-q %u rw-hash %u proxy-hash %u tree-gc-q %u tree-gc-active %u long-queries %u",
 			as_info_queue_get_size(),
 			rw_request_hash_count(),
 			as_proxy_hash_count(),
 			as_index_tree_gc_queue_size(),
+			as_index_tree_gc_n_active(),
 			as_query_get_active_job_count());
 }
 
@@ -1072,6 +1141,7 @@ dump_namespace_histograms(as_namespace* ns)
 		histogram_dump(ns->read_restart_hist);
 		histogram_dump(ns->read_dup_res_hist);
 		histogram_dump(ns->read_repl_ping_hist);
+		histogram_dump(ns->read_record_lock_hist);
 		histogram_dump(ns->read_local_hist);
 		histogram_dump(ns->read_response_hist);
 	}
@@ -1084,6 +1154,7 @@ dump_namespace_histograms(as_namespace* ns)
 		histogram_dump(ns->write_start_hist);
 		histogram_dump(ns->write_restart_hist);
 		histogram_dump(ns->write_dup_res_hist);
+		histogram_dump(ns->write_record_lock_hist);
 		histogram_dump(ns->write_master_hist);
 		histogram_dump(ns->write_repl_write_hist);
 		histogram_dump(ns->write_response_hist);
@@ -1157,6 +1228,8 @@ dump_namespace_histograms(as_namespace* ns)
 		histogram_dump(ns->re_repl_hist);
 	}
 
+	as_set_hist_dump(ns);
+
 	if (ns->storage_benchmarks_enabled) {
 		as_storage_ticker_stats(ns);
 	}
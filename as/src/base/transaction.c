@@ -84,6 +84,9 @@ as_transaction_init_body(as_transaction *tr)
 	tr->generation			= 0;
 	tr->void_time			= 0;
 	tr->last_update_time	= 0;
+	tr->set_id				= INVALID_SET_ID;
+	tr->dispatch_time		= 0;
+	tr->master_done_time	= 0;
 }
 
 void
@@ -119,6 +122,9 @@ as_transaction_init_from_rw(as_transaction *tr, rw_request *rw)
 	tr->generation = rw->generation;
 	tr->void_time = rw->void_time;
 	tr->last_update_time = rw->last_update_time;
+	tr->set_id = rw->set_id;
+	tr->dispatch_time = rw->dispatch_time;
+	tr->master_done_time = rw->master_done_time;
 }
 
 void
@@ -178,6 +184,12 @@ as_transaction_set_msg_field_flag(as_transaction *tr, uint8_t type)
 	case AS_MSG_FIELD_TYPE_BVAL_ARRAY:
 		tr->msg_fields |= AS_MSG_FIELD_BIT_BVAL_ARRAY;
 		break;
+	case AS_MSG_FIELD_TYPE_TOP_K:
+		tr->msg_fields |= AS_MSG_FIELD_BIT_TOP_K;
+		break;
+	case AS_MSG_FIELD_TYPE_RAW_FLAT:
+		tr->msg_fields |= AS_MSG_FIELD_BIT_RAW_FLAT;
+		break;
 	case AS_MSG_FIELD_TYPE_INDEX_RANGE:
 		tr->msg_fields |= AS_MSG_FIELD_BIT_INDEX_RANGE;
 		break;
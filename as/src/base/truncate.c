@@ -41,6 +41,7 @@
 #include "cf_mutex.h"
 #include "cf_thread.h"
 #include "dynbuf.h"
+#include "hist.h"
 #include "log.h"
 #include "vmapx.h"
 
@@ -62,6 +63,21 @@ typedef struct truncate_reduce_cb_info_s {
 	int64_t n_deleted;
 } truncate_reduce_cb_info;
 
+// Per-thread pacing for truncate-max-rate and truncate-latency-ms.
+typedef struct truncate_pace_s {
+	uint32_t rate; // records per second - 0 means not yet started
+	uint64_t base_us;
+	uint64_t n_deleted; // since base_us
+	uint64_t eval_us;
+	uint64_t n_total; // foreground latency counts as of eval_us
+	uint64_t n_over;
+} truncate_pace;
+
+#define PACE_EVAL_US (1000UL * 1000) // re-evaluate rate every second
+#define PACE_OVER_PCT 1 // back off if more foreground transactions are slow
+#define PACE_MIN_DIV 64 // don't back off below 1/64 of max rate
+#define PACE_SLEEP_CAP_US (1000UL * 1000)
+
 // Includes 1 for delimiter and 1 for null-terminator.
 #define TRUNCATE_KEY_SIZE (AS_ID_NAMESPACE_SZ + AS_SET_NAME_MAX_SIZE)
 
@@ -81,6 +97,9 @@ static void truncate_action_undo(as_namespace* ns, const char* set_name);
 static void truncate_all(as_namespace* ns);
 static void* run_truncate(void* arg);
 static void truncate_finish(as_namespace* ns);
+static void truncate_throttle(as_namespace* ns, truncate_pace* pace, uint64_t n_deleted);
+static uint32_t adjust_pace_rate(as_namespace* ns, truncate_pace* pace, uint32_t max_rate, uint64_t now_us);
+static void get_foreground_counts(as_namespace* ns, uint32_t latency_ms, uint64_t* n_total, uint64_t* n_over);
 static bool truncate_reduce_cb(as_index_ref* r_ref, void* udata);
 
 
@@ -341,6 +360,13 @@ truncate_action_do(as_namespace* ns, const char* set_name, uint64_t lut)
 		ns->truncate.lut = lut;
 	}
 
+	// Cached si-query responses may hold truncated records.
+	if (ns->query_result_cache_size != 0) {
+		for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+			as_incr_uint64(&ns->si_query_cache_writes[pid]);
+		}
+	}
+
 	// Truncate to new last-update-time.
 
 	cf_mutex_lock(&ns->truncate.state_lock);
@@ -404,7 +430,7 @@ truncate_all(as_namespace* ns)
 
 	ns->truncate.state = TRUNCATE_RUNNING;
 	as_store_uint32(&ns->truncate.n_threads_running, n_threads);
-	as_store_uint32(&ns->truncate.pid, 0);
+	as_store_uint32(&ns->truncate.item, 0);
 
 	as_store_uint64(&ns->truncate.n_records_this_run, 0);
 
@@ -417,18 +443,25 @@ static void*
 run_truncate(void* arg)
 {
 	as_namespace* ns = (as_namespace*)arg;
-	uint32_t pid;
+	truncate_pace pace = { 0 };
+	uint32_t item;
 
-	while ((pid = as_faa_uint32(&ns->truncate.pid, 1)) < AS_PARTITIONS) {
+	// Work items are tree slices - idle threads take the next one, so big
+	// partitions don't hold up the run.
+	while ((item = as_faa_uint32(&ns->truncate.item, 1)) <
+			AS_INDEX_N_REDUCE_ITEMS) {
 		as_partition_reservation rsv;
-		as_partition_reserve(ns, pid, &rsv);
+		as_partition_reserve(ns, item / AS_INDEX_N_REDUCE_SLICES, &rsv);
 
 		truncate_reduce_cb_info cb_info = { .ns = ns, .tree = rsv.tree };
 
-		as_index_reduce(rsv.tree, truncate_reduce_cb, (void*)&cb_info);
+		as_index_reduce_slice(rsv.tree, item % AS_INDEX_N_REDUCE_SLICES,
+				truncate_reduce_cb, (void*)&cb_info);
 		as_partition_release(&rsv);
 
 		as_add_uint64(&ns->truncate.n_records_this_run, cb_info.n_deleted);
+
+		truncate_throttle(ns, &pace, (uint64_t)cb_info.n_deleted);
 	}
 
 	truncate_finish(ns);
@@ -465,6 +498,128 @@ truncate_finish(as_namespace* ns)
 	}
 }
 
+// Sleep as needed to keep this thread's share of truncate-max-rate, backing
+// off (multiplicatively) while foreground latency is over truncate-latency-ms.
+static void
+truncate_throttle(as_namespace* ns, truncate_pace* pace, uint64_t n_deleted)
+{
+	uint32_t max_rate = as_load_uint32(&ns->truncate_max_rate);
+
+	if (max_rate == 0) {
+		pace->rate = 0;
+		return;
+	}
+
+	uint32_t n_threads = as_load_uint32(&ns->n_truncate_threads);
+
+	max_rate /= n_threads;
+
+	if (max_rate == 0) {
+		max_rate = 1;
+	}
+
+	uint64_t now_us = cf_getus();
+
+	if (pace->rate == 0) {
+		pace->rate = max_rate;
+		pace->base_us = now_us;
+		pace->n_deleted = 0;
+		pace->eval_us = now_us;
+
+		get_foreground_counts(ns, as_load_uint32(&ns->truncate_latency_ms),
+				&pace->n_total, &pace->n_over);
+	}
+
+	pace->n_deleted += n_deleted;
+
+	if (now_us - pace->eval_us >= PACE_EVAL_US) {
+		uint32_t rate = adjust_pace_rate(ns, pace, max_rate, now_us);
+
+		if (rate != pace->rate) {
+			// Restart rate tracking from here at the new rate.
+			pace->rate = rate;
+			pace->base_us = now_us;
+			pace->n_deleted = 0;
+			return;
+		}
+	}
+
+	uint64_t target_us = (pace->n_deleted * 1000000) / pace->rate;
+	uint64_t elapsed_us = now_us - pace->base_us;
+
+	if (target_us > elapsed_us) {
+		uint64_t sleep_us = target_us - elapsed_us;
+
+		usleep((useconds_t)(sleep_us > PACE_SLEEP_CAP_US ?
+				PACE_SLEEP_CAP_US : sleep_us));
+	}
+}
+
+static uint32_t
+adjust_pace_rate(as_namespace* ns, truncate_pace* pace, uint32_t max_rate,
+		uint64_t now_us)
+{
+	uint32_t latency_ms = as_load_uint32(&ns->truncate_latency_ms);
+	uint64_t n_total;
+	uint64_t n_over;
+
+	get_foreground_counts(ns, latency_ms, &n_total, &n_over);
+
+	// Note - histograms may have been cleared (rescaled) since last time.
+	bool reset = n_total < pace->n_total || n_over < pace->n_over;
+
+	uint64_t d_total = n_total - pace->n_total;
+	uint64_t d_over = n_over - pace->n_over;
+
+	pace->eval_us = now_us;
+	pace->n_total = n_total;
+	pace->n_over = n_over;
+
+	if (latency_ms == 0 || reset) {
+		return max_rate;
+	}
+
+	uint32_t rate = pace->rate > max_rate ? max_rate : pace->rate;
+
+	if (d_over * 100 > d_total * PACE_OVER_PCT) {
+		uint32_t min_rate = max_rate / PACE_MIN_DIV;
+
+		rate /= 2;
+
+		if (rate < min_rate || rate == 0) {
+			rate = min_rate == 0 ? 1 : min_rate;
+		}
+
+		cf_debug(AS_TRUNCATE, "{%s} %lu of %lu transactions over %u ms - truncate thread rate %u", ns->name,
+				d_over, d_total, latency_ms, rate);
+
+		return rate;
+	}
+
+	// Additive increase back up to max rate.
+	uint32_t step = max_rate / 8;
+
+	rate += step == 0 ? 1 : step;
+
+	return rate > max_rate ? max_rate : rate;
+}
+
+static void
+get_foreground_counts(as_namespace* ns, uint32_t latency_ms, uint64_t* n_total,
+		uint64_t* n_over)
+{
+	uint64_t latency_us = (uint64_t)latency_ms * 1000;
+	uint64_t n_read_total;
+	uint64_t n_read_over;
+
+	histogram_get_counts_over_us(ns->read_hist, latency_us, &n_read_total,
+			&n_read_over);
+	histogram_get_counts_over_us(ns->write_hist, latency_us, n_total, n_over);
+
+	*n_total += n_read_total;
+	*n_over += n_read_over;
+}
+
 static bool
 truncate_reduce_cb(as_index_ref* r_ref, void* udata)
 {
@@ -32,6 +32,9 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "aerospike/as_bytes.h"
+#include "aerospike/as_double.h"
+#include "aerospike/as_integer.h"
 #include "aerospike/as_rec.h"
 #include "aerospike/as_val.h"
 #include "citrusleaf/alloc.h"
@@ -75,7 +78,10 @@ static uint16_t udf_record_numbins(const as_rec* rec);
 static int udf_record_bin_names(const as_rec* rec, as_rec_bin_names_callback cb, void* udata);
 
 static bool param_check_w_bin(const as_rec* rec, const char* name);
+static udf_record_bin* udf_record_cache_find(udf_record* urecord, const char* name);
 static as_val* udf_record_cache_get(udf_record* urecord, const char* name);
+static int scalar_lookup(const as_rec* rec, const char* name, as_val** p_cached, const as_bin** p_bin);
+static udf_record_bin* scalar_reusable(const as_rec* rec, const char* name, as_val_t type);
 static as_val* as_val_from_flat_key(const uint8_t* flat_key, uint32_t size);
 
 
@@ -322,6 +328,138 @@ udf_record_load(udf_record* urecord)
 	return 0;
 }
 
+// The scalar accessors return 0 if the bin exists with the requested type,
+// otherwise -1. Pending writes are seen, as with rec["bin-x"].
+
+int
+udf_record_get_integer(const as_rec* rec, const char* name, int64_t* value)
+{
+	as_val* cached;
+	const as_bin* b;
+
+	if (scalar_lookup(rec, name, &cached, &b) != 0) {
+		return -1;
+	}
+
+	if (cached != NULL) {
+		if (as_val_type(cached) != AS_INTEGER) {
+			return -1;
+		}
+
+		*value = as_integer_get((as_integer*)cached);
+		return 0;
+	}
+
+	if (b == NULL || as_bin_get_particle_type(b) != AS_PARTICLE_TYPE_INTEGER) {
+		return -1;
+	}
+
+	*value = as_bin_particle_integer_value(b);
+
+	return 0;
+}
+
+int
+udf_record_get_float(const as_rec* rec, const char* name, double* value)
+{
+	as_val* cached;
+	const as_bin* b;
+
+	if (scalar_lookup(rec, name, &cached, &b) != 0) {
+		return -1;
+	}
+
+	if (cached != NULL) {
+		if (as_val_type(cached) != AS_DOUBLE) {
+			return -1;
+		}
+
+		*value = as_double_get((as_double*)cached);
+		return 0;
+	}
+
+	if (b == NULL || as_bin_get_particle_type(b) != AS_PARTICLE_TYPE_FLOAT) {
+		return -1;
+	}
+
+	*value = as_bin_particle_float_value(b);
+
+	return 0;
+}
+
+// The buffer is only valid until the bin is next written, or the UDF returns.
+int
+udf_record_get_bytes(const as_rec* rec, const char* name, const uint8_t** buf,
+		uint32_t* sz)
+{
+	as_val* cached;
+	const as_bin* b;
+
+	if (scalar_lookup(rec, name, &cached, &b) != 0) {
+		return -1;
+	}
+
+	if (cached != NULL) {
+		if (as_val_type(cached) != AS_BYTES) {
+			return -1;
+		}
+
+		*buf = as_bytes_get((as_bytes*)cached);
+		*sz = as_bytes_size((as_bytes*)cached);
+		return 0;
+	}
+
+	if (b == NULL || as_bin_get_particle_type(b) != AS_PARTICLE_TYPE_BLOB) {
+		return -1;
+	}
+
+	*sz = as_bin_particle_blob_ptr(b, buf);
+
+	return 0;
+}
+
+int
+udf_record_set_integer(const as_rec* rec, const char* name, int64_t value)
+{
+	if (! param_check_w_bin(rec, name)) {
+		return -1;
+	}
+
+	udf_record_bin* bin = scalar_reusable(rec, name, AS_INTEGER);
+
+	if (bin != NULL) {
+		((as_integer*)bin->value)->value = value;
+		bin->dirty = true;
+		return 0;
+	}
+
+	udf_record_cache_set((udf_record*)as_rec_source(rec), name,
+			(as_val*)as_integer_new(value), true);
+
+	return 0;
+}
+
+int
+udf_record_set_float(const as_rec* rec, const char* name, double value)
+{
+	if (! param_check_w_bin(rec, name)) {
+		return -1;
+	}
+
+	udf_record_bin* bin = scalar_reusable(rec, name, AS_DOUBLE);
+
+	if (bin != NULL) {
+		((as_double*)bin->value)->value = value;
+		bin->dirty = true;
+		return 0;
+	}
+
+	udf_record_cache_set((udf_record*)as_rec_source(rec), name,
+			(as_val*)as_double_new(value), true);
+
+	return 0;
+}
+
 
 //==========================================================
 // Public API - implementation of rec hooks.
@@ -702,24 +840,77 @@ param_check_w_bin(const as_rec* rec, const char* name)
 	return true;
 }
 
-static as_val*
-udf_record_cache_get(udf_record* urecord, const char* name)
+static udf_record_bin*
+udf_record_cache_find(udf_record* urecord, const char* name)
 {
-	if (urecord->n_updates == 0) {
-		return NULL;
-	}
-
 	for (uint32_t i = 0; i < urecord->n_updates; i++) {
 		udf_record_bin* bin = &urecord->updates[i];
 
 		if (strcmp(name, bin->name) == 0) {
-			return bin->value; // NULL or as_nil are ok
+			return bin;
 		}
 	}
 
 	return NULL;
 }
 
+static as_val*
+udf_record_cache_get(udf_record* urecord, const char* name)
+{
+	udf_record_bin* bin = udf_record_cache_find(urecord, name);
+
+	return bin == NULL ? NULL : bin->value; // NULL or as_nil are ok
+}
+
+// Finds a bin in the update cache, else in the stored record - unlike
+// udf_record_get(), doesn't convert and cache stored values.
+static int
+scalar_lookup(const as_rec* rec, const char* name, as_val** p_cached,
+		const as_bin** p_bin)
+{
+	if (! param_check_w_bin(rec, name)) {
+		return -1;
+	}
+
+	udf_record* urecord = (udf_record*)as_rec_source(rec);
+
+	*p_cached = udf_record_cache_get(urecord, name);
+	*p_bin = NULL;
+
+	if (*p_cached != NULL) {
+		return 0;
+	}
+
+	if (! urecord->is_open) {
+		return 0; // e.g. record doesn't exist yet - not an error
+	}
+
+	if (udf_record_load(urecord) != 0) {
+		cf_warning(AS_UDF, "record failed load");
+		return -1;
+	}
+
+	*p_bin = as_bin_get_live(urecord->rd, name);
+
+	return 0;
+}
+
+// A cached value of the given type that only the cache references can be
+// overwritten in place - saves allocating a new as_val per write.
+static udf_record_bin*
+scalar_reusable(const as_rec* rec, const char* name, as_val_t type)
+{
+	udf_record* urecord = (udf_record*)as_rec_source(rec);
+	udf_record_bin* bin = udf_record_cache_find(urecord, name);
+
+	if (bin == NULL || bin->value == NULL || as_val_type(bin->value) != type ||
+			bin->value->count != 1) {
+		return NULL;
+	}
+
+	return bin;
+}
+
 static as_val*
 as_val_from_flat_key(const uint8_t* flat_key, uint32_t size)
 {
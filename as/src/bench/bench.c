@@ -0,0 +1,251 @@
+/*
+ * bench.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * Microbenchmark driver for hot-path primitives - built by "make bench" and
+ * linked against the server objects (minus main.c). Prints one JSON object per
+ * benchmark to stdout, e.g.:
+ *
+ *   {"name":"index-get","ops":1000000,"rounds":5,"min-ns-per-op":41.2,"median-ns-per-op":42.0}
+ *
+ * Usage: asd-bench [-r rounds] [-s msg-sizes] [-c channel-counts] [name-prefix ...]
+ *
+ * Sizes and channel counts are comma-separated lists, swept by the fabric load
+ * benchmarks.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "bench/bench.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "citrusleaf/cf_clock.h"
+
+#include "cf_thread.h"
+#include "enhanced_alloc.h"
+#include "log.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define DEFAULT_N_ROUNDS 5
+#define MAX_N_ROUNDS 100
+
+#define MAX_LIST_SZ 16
+#define MAX_MSG_SIZE (8 * 1024 * 1024)
+#define MAX_N_CHANNELS 64
+
+
+//==========================================================
+// Globals.
+//
+
+static uint32_t g_n_rounds = DEFAULT_N_ROUNDS;
+static char* const* g_prefixes = NULL;
+static uint32_t g_n_prefixes = 0;
+
+static uint32_t g_msg_sizes[MAX_LIST_SZ] = { 256, 4096, 65536 };
+static uint32_t g_n_msg_sizes = 3;
+static uint32_t g_channel_counts[MAX_LIST_SZ] = { 1, 4 };
+static uint32_t g_n_channel_counts = 2;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static bool parse_list(const char* str, uint32_t max, uint32_t* list, uint32_t* n);
+static int compare_u64(const void* pa, const void* pb);
+
+
+//==========================================================
+// Public API.
+//
+
+int
+main(int argc, char** argv)
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:s:c:")) != -1) {
+		switch (opt) {
+		case 'r':
+			g_n_rounds = (uint32_t)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			if (! parse_list(optarg, MAX_MSG_SIZE, g_msg_sizes,
+					&g_n_msg_sizes)) {
+				fprintf(stderr, "sizes must be 1 to %u\n", MAX_MSG_SIZE);
+				return 1;
+			}
+			break;
+		case 'c':
+			if (! parse_list(optarg, MAX_N_CHANNELS, g_channel_counts,
+					&g_n_channel_counts)) {
+				fprintf(stderr, "channel counts must be 1 to %u\n",
+						MAX_N_CHANNELS);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-r rounds] [-s msg-sizes] [-c channel-counts] [name-prefix ...]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+
+	if (g_n_rounds == 0 || g_n_rounds > MAX_N_ROUNDS) {
+		fprintf(stderr, "rounds must be 1 to %u\n", MAX_N_ROUNDS);
+		return 1;
+	}
+
+	g_prefixes = &argv[optind];
+	g_n_prefixes = (uint32_t)(argc - optind);
+
+	cf_log_init(false);
+	cf_alloc_init();
+	cf_thread_init();
+
+	as_bench_index();
+	as_bench_msgpack();
+	as_bench_exp();
+	as_bench_cdt();
+	as_bench_hll();
+	as_bench_flat();
+	as_bench_msg();
+	as_bench_hash();
+	as_bench_fabric();
+
+	return 0;
+}
+
+bool
+as_bench_selected(const char* name)
+{
+	if (g_n_prefixes == 0) {
+		return true;
+	}
+
+	for (uint32_t i = 0; i < g_n_prefixes; i++) {
+		if (strncmp(name, g_prefixes[i], strlen(g_prefixes[i])) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint32_t
+as_bench_msg_sizes(const uint32_t** sizes)
+{
+	*sizes = g_msg_sizes;
+
+	return g_n_msg_sizes;
+}
+
+uint32_t
+as_bench_channel_counts(const uint32_t** counts)
+{
+	*counts = g_channel_counts;
+
+	return g_n_channel_counts;
+}
+
+void
+as_bench_run(const char* name, as_bench_fn fn, void* udata, uint32_t n_ops)
+{
+	if (! as_bench_selected(name)) {
+		return;
+	}
+
+	fn(udata, n_ops); // warm up caches and allocator
+
+	uint64_t elapsed[g_n_rounds];
+
+	for (uint32_t i = 0; i < g_n_rounds; i++) {
+		uint64_t start_ns = cf_getns();
+
+		fn(udata, n_ops);
+		elapsed[i] = cf_getns() - start_ns;
+	}
+
+	qsort(elapsed, g_n_rounds, sizeof(uint64_t), compare_u64);
+
+	printf("{\"name\":\"%s\",\"ops\":%u,\"rounds\":%u,\"min-ns-per-op\":%.1f,\"median-ns-per-op\":%.1f}\n",
+			name, n_ops, g_n_rounds, (double)elapsed[0] / n_ops,
+			(double)elapsed[g_n_rounds / 2] / n_ops);
+	fflush(stdout);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static bool
+parse_list(const char* str, uint32_t max, uint32_t* list, uint32_t* n)
+{
+	uint32_t n_parsed = 0;
+
+	while (n_parsed < MAX_LIST_SZ) {
+		char* end;
+		unsigned long val = strtoul(str, &end, 0);
+
+		if (end == str || val == 0 || val > max) {
+			return false;
+		}
+
+		list[n_parsed++] = (uint32_t)val;
+
+		if (*end == '\0') {
+			*n = n_parsed;
+			return true;
+		}
+
+		if (*end != ',') {
+			return false;
+		}
+
+		str = end + 1;
+	}
+
+	return false;
+}
+
+static int
+compare_u64(const void* pa, const void* pb)
+{
+	uint64_t a = *(const uint64_t*)pa;
+	uint64_t b = *(const uint64_t*)pb;
+
+	return a > b ? 1 : (a < b ? -1 : 0);
+}
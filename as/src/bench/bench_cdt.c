@@ -0,0 +1,272 @@
+/*
+ * bench_cdt.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "aerospike/as_msgpack.h"
+
+#include "log.h"
+#include "msgpack_in.h"
+
+#include "base/datamodel.h"
+#include "base/proto.h"
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_ELES 1000
+#define OP_BUF_SZ 64
+
+typedef struct cdt_op_buf_s {
+	uint8_t buf[OP_BUF_SZ];
+	uint32_t sz;
+} cdt_op_buf;
+
+typedef struct cdt_bench_s {
+	as_bin list_bin;
+	as_bin map_bin;
+	cdt_op_buf list_appends[N_ELES];
+	cdt_op_buf list_gets[N_ELES];
+	cdt_op_buf map_puts[N_ELES];
+	cdt_op_buf map_gets[N_ELES];
+} cdt_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void build_ops(cdt_bench* cb);
+static void build_bin(as_bin* b, const cdt_op_buf* puts);
+static void bench_list_append(void* udata, uint32_t n_ops);
+static void bench_list_get(void* udata, uint32_t n_ops);
+static void bench_map_put(void* udata, uint32_t n_ops);
+static void bench_map_get_by_key(void* udata, uint32_t n_ops);
+static void cdt_modify(as_bin* b, const cdt_op_buf* op);
+static void cdt_read(const as_bin* b, const cdt_op_buf* op);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_cdt(void)
+{
+	static cdt_bench cb;
+
+	build_ops(&cb);
+	build_bin(&cb.list_bin, cb.list_appends);
+	build_bin(&cb.map_bin, cb.map_puts);
+
+	as_bench_run("cdt-list-append", bench_list_append, &cb, N_ELES);
+	as_bench_run("cdt-list-get", bench_list_get, &cb, N_ELES);
+	as_bench_run("cdt-map-put", bench_map_put, &cb, N_ELES);
+	as_bench_run("cdt-map-get-by-key", bench_map_get_by_key, &cb, N_ELES);
+
+	as_bin_particle_destroy(&cb.list_bin);
+	as_bin_particle_destroy(&cb.map_bin);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+build_ops(cdt_bench* cb)
+{
+	for (uint32_t i = 0; i < N_ELES; i++) {
+		char key[16];
+		uint32_t key_len = (uint32_t)sprintf(key, "key-%u", i);
+
+		as_packer pk = {
+				.buffer = cb->list_appends[i].buf,
+				.capacity = OP_BUF_SZ
+		};
+
+		as_pack_list_header(&pk, 2);
+		as_pack_uint64(&pk, AS_CDT_OP_LIST_APPEND);
+		as_pack_int64(&pk, (int64_t)i * 7919);
+		cb->list_appends[i].sz = pk.offset;
+
+		pk = (as_packer){
+				.buffer = cb->list_gets[i].buf,
+				.capacity = OP_BUF_SZ
+		};
+
+		as_pack_list_header(&pk, 2);
+		as_pack_uint64(&pk, AS_CDT_OP_LIST_GET);
+		as_pack_int64(&pk, (int64_t)((i * 7919) % N_ELES));
+		cb->list_gets[i].sz = pk.offset;
+
+		pk = (as_packer){
+				.buffer = cb->map_puts[i].buf,
+				.capacity = OP_BUF_SZ
+		};
+
+		as_pack_list_header(&pk, 3);
+		as_pack_uint64(&pk, AS_CDT_OP_MAP_PUT);
+		as_pack_str(&pk, (const uint8_t*)key, key_len);
+		as_pack_int64(&pk, (int64_t)i);
+		cb->map_puts[i].sz = pk.offset;
+
+		pk = (as_packer){
+				.buffer = cb->map_gets[i].buf,
+				.capacity = OP_BUF_SZ
+		};
+
+		as_pack_list_header(&pk, 3);
+		as_pack_uint64(&pk, AS_CDT_OP_MAP_GET_BY_KEY);
+		as_pack_uint64(&pk, RESULT_TYPE_VALUE);
+		as_pack_str(&pk, (const uint8_t*)key, key_len);
+		cb->map_gets[i].sz = pk.offset;
+	}
+}
+
+static void
+build_bin(as_bin* b, const cdt_op_buf* puts)
+{
+	as_bin_set_empty(b);
+	b->particle = NULL;
+
+	for (uint32_t i = 0; i < N_ELES; i++) {
+		cdt_modify(b, &puts[i]);
+	}
+}
+
+// Grows a list from empty - each append copies the whole particle.
+static void
+bench_list_append(void* udata, uint32_t n_ops)
+{
+	cdt_bench* cb = (cdt_bench*)udata;
+	as_bin b;
+
+	as_bin_set_empty(&b);
+	b.particle = NULL;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		cdt_modify(&b, &cb->list_appends[i]);
+	}
+
+	as_bin_particle_destroy(&b);
+}
+
+static void
+bench_list_get(void* udata, uint32_t n_ops)
+{
+	cdt_bench* cb = (cdt_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		cdt_read(&cb->list_bin, &cb->list_gets[i]);
+	}
+}
+
+static void
+bench_map_put(void* udata, uint32_t n_ops)
+{
+	cdt_bench* cb = (cdt_bench*)udata;
+	as_bin b;
+
+	as_bin_set_empty(&b);
+	b.particle = NULL;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		cdt_modify(&b, &cb->map_puts[i]);
+	}
+
+	as_bin_particle_destroy(&b);
+}
+
+static void
+bench_map_get_by_key(void* udata, uint32_t n_ops)
+{
+	cdt_bench* cb = (cdt_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		cdt_read(&cb->map_bin, &cb->map_gets[(i * 7919) % N_ELES]);
+	}
+}
+
+// Like a write transaction, frees the replaced particle.
+static void
+cdt_modify(as_bin* b, const cdt_op_buf* op)
+{
+	msgpack_vec vecs[1] = {
+			{ .buf = op->buf, .buf_sz = op->sz }
+	};
+
+	msgpack_in_vec mv = {
+			.n_vecs = 1,
+			.vecs = vecs
+	};
+
+	as_bin old_b = *b;
+	as_bin result;
+
+	as_bin_set_empty(&result);
+	result.particle = NULL;
+
+	int rv = as_bin_cdt_modify_exp(b, &mv, &result, false);
+
+	cf_assert(rv == AS_OK, AS_PARTICLE, "bench cdt modify failed %d", rv);
+
+	if (as_bin_is_used(&old_b) && old_b.particle != b->particle) {
+		as_bin_particle_destroy(&old_b);
+	}
+
+	as_bin_particle_destroy(&result);
+}
+
+static void
+cdt_read(const as_bin* b, const cdt_op_buf* op)
+{
+	msgpack_vec vecs[1] = {
+			{ .buf = op->buf, .buf_sz = op->sz }
+	};
+
+	msgpack_in_vec mv = {
+			.n_vecs = 1,
+			.vecs = vecs
+	};
+
+	as_bin result;
+
+	as_bin_set_empty(&result);
+	result.particle = NULL;
+
+	int rv = as_bin_cdt_read_exp(b, &mv, &result, false);
+
+	cf_assert(rv == AS_OK, AS_PARTICLE, "bench cdt read failed %d", rv);
+
+	as_bin_particle_destroy(&result);
+}
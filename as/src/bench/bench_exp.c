@@ -0,0 +1,175 @@
+/*
+ * bench_exp.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+#include <string.h>
+
+#include "aerospike/as_msgpack.h"
+#include "citrusleaf/cf_clock.h"
+
+#include "log.h"
+
+#include "base/datamodel.h"
+#include "base/exp.h"
+#include "base/index.h"
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_RECORDS 1024
+
+// Wire op codes - see exp.c.
+#define EXP_CMP_EQ 1
+#define EXP_CMP_GE 4
+#define EXP_CMP_LT 5
+#define EXP_AND 16
+#define EXP_META_DIGEST_MOD 64
+#define EXP_META_LAST_UPDATE 66
+#define EXP_META_VOID_TIME 68
+
+typedef struct exp_bench_s {
+	as_exp* exp;
+	as_record records[N_RECORDS];
+	uint64_t n_true;
+} exp_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void bench_build(void* udata, uint32_t n_ops);
+static void bench_eval_metadata(void* udata, uint32_t n_ops);
+static uint32_t pack_filter(uint8_t* buf, uint32_t buf_sz);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_exp(void)
+{
+	static exp_bench eb;
+
+	uint8_t buf[256];
+	uint32_t buf_sz = pack_filter(buf, sizeof(buf));
+
+	eb.exp = as_exp_build_buf(buf, buf_sz, true);
+
+	cf_assert(eb.exp != NULL, AS_EXP, "bench filter failed to build");
+
+	uint64_t now_ms = cf_clepoch_milliseconds();
+
+	for (uint32_t i = 0; i < N_RECORDS; i++) {
+		as_record* r = &eb.records[i];
+
+		memset(r, 0, sizeof(as_record));
+		r->keyd.digest[16] = (uint8_t)i;
+		r->generation = 1;
+		r->last_update_time = now_ms - i * 1000;
+		r->void_time = i % 4 == 0 ? 0 : (uint32_t)(now_ms / 1000) + i;
+	}
+
+	as_bench_run("exp-build", bench_build, NULL, 100000);
+	as_bench_run("exp-eval-metadata", bench_eval_metadata, &eb, 1000000);
+
+	as_exp_destroy(eb.exp);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+bench_build(void* udata, uint32_t n_ops)
+{
+	(void)udata;
+
+	uint8_t buf[256];
+	uint32_t buf_sz = pack_filter(buf, sizeof(buf));
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		as_exp_destroy(as_exp_build_buf(buf, buf_sz, true));
+	}
+}
+
+static void
+bench_eval_metadata(void* udata, uint32_t n_ops)
+{
+	exp_bench* eb = (exp_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		as_exp_ctx ctx = { .r = &eb->records[i % N_RECORDS] };
+
+		if (as_exp_matches_metadata(eb->exp, &ctx) == AS_EXP_TRUE) {
+			eb->n_true++;
+		}
+	}
+}
+
+// and(last_update() >= 1h ago, digest_modulo(3) == 1, void_time() < 0) - the
+// last term is "never expires".
+static uint32_t
+pack_filter(uint8_t* buf, uint32_t buf_sz)
+{
+	as_packer pk = {
+			.buffer = buf,
+			.capacity = buf_sz
+	};
+
+	int64_t hour_ago_ns =
+			(int64_t)cf_utc_ns_from_clepoch_ms(cf_clepoch_milliseconds()) -
+			3600L * 1000 * 1000 * 1000;
+
+	as_pack_list_header(&pk, 4);
+	as_pack_uint64(&pk, EXP_AND);
+
+	as_pack_list_header(&pk, 3);
+	as_pack_uint64(&pk, EXP_CMP_GE);
+	as_pack_list_header(&pk, 1);
+	as_pack_uint64(&pk, EXP_META_LAST_UPDATE);
+	as_pack_int64(&pk, hour_ago_ns);
+
+	as_pack_list_header(&pk, 3);
+	as_pack_uint64(&pk, EXP_CMP_EQ);
+	as_pack_list_header(&pk, 2);
+	as_pack_uint64(&pk, EXP_META_DIGEST_MOD);
+	as_pack_int64(&pk, 3);
+	as_pack_int64(&pk, 1);
+
+	as_pack_list_header(&pk, 3);
+	as_pack_uint64(&pk, EXP_CMP_LT);
+	as_pack_list_header(&pk, 1);
+	as_pack_uint64(&pk, EXP_META_VOID_TIME);
+	as_pack_int64(&pk, 0);
+
+	return (uint32_t)pk.offset;
+}
@@ -0,0 +1,547 @@
+/*
+ * bench_fabric.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/*
+ * Fabric load generation - replica-write and migrate-insert shaped msgs, acked
+ * like the real thing, over loopback TCP channels. Each channel is a sending
+ * node and a receiving node, with a window of unacked msgs. Prints one JSON
+ * object per (shape, msg size, channel count), e.g.:
+ *
+ *   {"name":"fabric-rw-4096-c4","msgs":65536,"msgs-per-sec":412000,
+ *    "mb-per-sec":1610.2,"p50-us":38.1,"p99-us":121.7,"p999-us":402.3,
+ *    "cpu-ns-per-msg":5120.4}
+ *
+ * Latency is send to ack. CPU is the whole process's, over both ends.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
+
+#include "cf_thread.h"
+#include "log.h"
+#include "msg.h"
+
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// A bench-only template on a spare type - bench_msg.c has M_TYPE_UNUSED_13.
+#define BENCH_M_TYPE M_TYPE_UNUSED_14
+
+typedef enum {
+	FB_FIELD_OP,
+	FB_FIELD_TID,
+	FB_FIELD_SEND_NS,
+	FB_FIELD_NS_IX,
+	FB_FIELD_DIGEST,
+	FB_FIELD_GENERATION,
+	FB_FIELD_LAST_UPDATE_TIME,
+	FB_FIELD_VOID_TIME,
+	FB_FIELD_RECORD,
+	FB_FIELD_META, // migrate insert's record metadata
+
+	NUM_FB_FIELDS
+} fb_msg_field;
+
+static const msg_template fb_mt[] = {
+		{ FB_FIELD_OP, M_FT_UINT32 },
+		{ FB_FIELD_TID, M_FT_UINT32 },
+		{ FB_FIELD_SEND_NS, M_FT_UINT64 },
+		{ FB_FIELD_NS_IX, M_FT_UINT32 },
+		{ FB_FIELD_DIGEST, M_FT_BUF },
+		{ FB_FIELD_GENERATION, M_FT_UINT32 },
+		{ FB_FIELD_LAST_UPDATE_TIME, M_FT_UINT64 },
+		{ FB_FIELD_VOID_TIME, M_FT_UINT32 },
+		{ FB_FIELD_RECORD, M_FT_BUF },
+		{ FB_FIELD_META, M_FT_BUF }
+};
+
+#define FB_MSG_SCRATCH_SIZE 192
+
+#define FB_OP_RW 1
+#define FB_OP_MIGRATE 2
+#define FB_OP_ACK 3
+
+#define META_SZ 48
+
+// Per (shape, size, channel count) - enough msgs to reach steady state without
+// small sizes taking forever.
+#define TARGET_BYTES (256UL * 1024 * 1024)
+#define MIN_N_MSGS 1024
+#define MAX_N_MSGS (256 * 1024)
+
+#define READ_SLACK (64 * 1024)
+
+typedef struct fb_shape_s {
+	const char* name;
+	uint32_t op;
+	uint32_t window; // unacked msgs per channel
+} fb_shape;
+
+static const fb_shape SHAPES[] = {
+		// Replica writes - one ack each, few in flight per node pair.
+		{ "fabric-rw", FB_OP_RW, 64 },
+		// Migrate inserts - emigration streams with a wide window.
+		{ "fabric-migrate", FB_OP_MIGRATE, 1024 }
+};
+
+#define N_SHAPES (sizeof(SHAPES) / sizeof(fb_shape))
+
+typedef struct fb_reader_s {
+	int fd;
+	uint8_t* buf;
+	size_t capacity;
+	size_t start;
+	size_t end;
+} fb_reader;
+
+typedef struct fb_channel_s {
+	const fb_shape* shape;
+	uint32_t msg_sz;
+	uint32_t n_msgs;
+	int send_fd;
+	int recv_fd;
+	uint64_t* lats; // send to ack ns, indexed by tid
+} fb_channel;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void run_config(const fb_shape* shape, uint32_t msg_sz, uint32_t n_channels);
+static void connect_channels(fb_channel* chs, uint32_t n_channels);
+static void* run_sender(void* udata);
+static void* run_receiver(void* udata);
+static msg* create_data_msg(const fb_channel* ch, const uint8_t* record, uint32_t tid);
+static void send_msg(int fd, msg* m, uint8_t* buf);
+static void send_all(int fd, const uint8_t* buf, size_t sz);
+static msg* read_msg(fb_reader* r);
+static uint64_t process_cpu_ns(void);
+static int compare_u64(const void* pa, const void* pb);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_fabric(void)
+{
+	msg_type_register(BENCH_M_TYPE, fb_mt, sizeof(fb_mt), FB_MSG_SCRATCH_SIZE);
+
+	const uint32_t* sizes;
+	uint32_t n_sizes = as_bench_msg_sizes(&sizes);
+	const uint32_t* counts;
+	uint32_t n_counts = as_bench_channel_counts(&counts);
+
+	for (uint32_t s = 0; s < N_SHAPES; s++) {
+		for (uint32_t i = 0; i < n_sizes; i++) {
+			for (uint32_t j = 0; j < n_counts; j++) {
+				run_config(&SHAPES[s], sizes[i], counts[j]);
+			}
+		}
+	}
+}
+
+
+//==========================================================
+// Local helpers - run a configuration.
+//
+
+static void
+run_config(const fb_shape* shape, uint32_t msg_sz, uint32_t n_channels)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "%s-%u-c%u", shape->name, msg_sz, n_channels);
+
+	if (! as_bench_selected(name)) {
+		return;
+	}
+
+	uint64_t n_msgs = TARGET_BYTES / msg_sz / n_channels;
+
+	if (n_msgs < MIN_N_MSGS) {
+		n_msgs = MIN_N_MSGS;
+	}
+	else if (n_msgs > MAX_N_MSGS) {
+		n_msgs = MAX_N_MSGS;
+	}
+
+	fb_channel chs[n_channels];
+	uint64_t* lats = cf_malloc(sizeof(uint64_t) * n_msgs * n_channels);
+
+	for (uint32_t i = 0; i < n_channels; i++) {
+		chs[i] = (fb_channel){
+				.shape = shape,
+				.msg_sz = msg_sz,
+				.n_msgs = (uint32_t)n_msgs,
+				.lats = &lats[i * n_msgs]
+		};
+	}
+
+	connect_channels(chs, n_channels);
+
+	cf_tid tids[n_channels * 2];
+	uint64_t start_cpu_ns = process_cpu_ns();
+	uint64_t start_ns = cf_getns();
+
+	for (uint32_t i = 0; i < n_channels; i++) {
+		tids[i * 2] = cf_thread_create_joinable(run_receiver, &chs[i]);
+		tids[(i * 2) + 1] = cf_thread_create_joinable(run_sender, &chs[i]);
+	}
+
+	for (uint32_t i = 0; i < n_channels * 2; i++) {
+		cf_thread_join(tids[i]);
+	}
+
+	uint64_t elapsed_ns = cf_getns() - start_ns;
+	uint64_t cpu_ns = process_cpu_ns() - start_cpu_ns;
+	uint64_t n_total = n_msgs * n_channels;
+
+	qsort(lats, n_total, sizeof(uint64_t), compare_u64);
+
+	printf("{\"name\":\"%s\",\"msgs\":%lu,\"msgs-per-sec\":%.0f,\"mb-per-sec\":%.1f,\"p50-us\":%.1f,\"p99-us\":%.1f,\"p999-us\":%.1f,\"cpu-ns-per-msg\":%.1f}\n",
+			name, n_total, (double)n_total * 1e9 / (double)elapsed_ns,
+			(double)n_total * msg_sz * 1e9 / (double)elapsed_ns /
+					(1024 * 1024),
+			(double)lats[n_total / 2] / 1000,
+			(double)lats[n_total * 99 / 100] / 1000,
+			(double)lats[n_total * 999 / 1000] / 1000,
+			(double)cpu_ns / (double)n_total);
+	fflush(stdout);
+
+	for (uint32_t i = 0; i < n_channels; i++) {
+		close(chs[i].send_fd);
+		close(chs[i].recv_fd);
+	}
+
+	cf_free(lats);
+}
+
+// A loopback connection per channel, configured like fabric's.
+static void
+connect_channels(fb_channel* chs, uint32_t n_channels)
+{
+	struct sockaddr_in addr = {
+			.sin_family = AF_INET,
+			.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+			.sin_port = 0
+	};
+
+	socklen_t addr_len = sizeof(addr);
+	int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (listen_fd < 0 ||
+			bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+			listen(listen_fd, (int)n_channels) < 0 ||
+			getsockname(listen_fd, (struct sockaddr*)&addr, &addr_len) < 0) {
+		cf_crash(AS_FABRIC, "bench listen failed: %d (%s)", errno,
+				cf_strerror(errno));
+	}
+
+	int one = 1;
+
+	for (uint32_t i = 0; i < n_channels; i++) {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+		if (fd < 0 ||
+				connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+			cf_crash(AS_FABRIC, "bench connect failed: %d (%s)", errno,
+					cf_strerror(errno));
+		}
+
+		int afd = accept(listen_fd, NULL, NULL);
+
+		if (afd < 0) {
+			cf_crash(AS_FABRIC, "bench accept failed: %d (%s)", errno,
+					cf_strerror(errno));
+		}
+
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		setsockopt(afd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		chs[i].send_fd = fd;
+		chs[i].recv_fd = afd;
+	}
+
+	close(listen_fd);
+}
+
+
+//==========================================================
+// Local helpers - channel ends.
+//
+
+// Sends while the window allows, else waits for acks. Acks are small, so the
+// receiver never blocks sending them - no deadlock on full socket buffers.
+static void*
+run_sender(void* udata)
+{
+	fb_channel* ch = (fb_channel*)udata;
+	uint8_t* record = cf_malloc(ch->msg_sz);
+
+	memset(record, 0xa5, ch->msg_sz);
+
+	msg* m = create_data_msg(ch, record, 0);
+	uint8_t* wbuf = cf_malloc(msg_get_wire_size(m));
+
+	msg_destroy(m);
+
+	fb_reader r = {
+			.fd = ch->send_fd,
+			.capacity = READ_SLACK,
+			.buf = cf_malloc(READ_SLACK)
+	};
+
+	uint32_t n_sent = 0;
+	uint32_t n_acked = 0;
+
+	while (n_acked < ch->n_msgs) {
+		if (n_sent < ch->n_msgs && n_sent - n_acked < ch->shape->window) {
+			send_msg(ch->send_fd, create_data_msg(ch, record, n_sent), wbuf);
+			n_sent++;
+			continue;
+		}
+
+		msg* ack = read_msg(&r);
+		uint32_t tid = 0;
+		uint64_t send_ns = 0;
+
+		msg_get_uint32(ack, FB_FIELD_TID, &tid);
+		msg_get_uint64(ack, FB_FIELD_SEND_NS, &send_ns);
+		msg_destroy(ack);
+
+		cf_assert(tid < ch->n_msgs, AS_FABRIC, "bad bench ack tid %u", tid);
+
+		ch->lats[tid] = cf_getns() - send_ns;
+		n_acked++;
+	}
+
+	cf_free(r.buf);
+	cf_free(wbuf);
+	cf_free(record);
+
+	return NULL;
+}
+
+// Parses each msg and reads its fields, like a replica or immigration handler,
+// then acks it.
+static void*
+run_receiver(void* udata)
+{
+	fb_channel* ch = (fb_channel*)udata;
+
+	fb_reader r = {
+			.fd = ch->recv_fd,
+			.capacity = ch->msg_sz + META_SZ + READ_SLACK,
+			.buf = cf_malloc(ch->msg_sz + META_SZ + READ_SLACK)
+	};
+
+	uint8_t wbuf[256];
+
+	for (uint32_t i = 0; i < ch->n_msgs; i++) {
+		msg* m = read_msg(&r);
+		uint32_t tid = 0;
+		uint64_t send_ns = 0;
+		uint8_t* record = NULL;
+		size_t record_sz = 0;
+
+		msg_get_uint32(m, FB_FIELD_TID, &tid);
+		msg_get_uint64(m, FB_FIELD_SEND_NS, &send_ns);
+
+		if (msg_get_buf(m, FB_FIELD_RECORD, &record, &record_sz,
+				MSG_GET_DIRECT) != 0 || record_sz != ch->msg_sz) {
+			cf_crash(AS_FABRIC, "bad bench msg record");
+		}
+
+		msg_destroy(m);
+
+		msg* ack = msg_create(BENCH_M_TYPE);
+
+		msg_set_uint32(ack, FB_FIELD_OP, FB_OP_ACK);
+		msg_set_uint32(ack, FB_FIELD_TID, tid);
+		msg_set_uint64(ack, FB_FIELD_SEND_NS, send_ns);
+
+		send_msg(ch->recv_fd, ack, wbuf);
+	}
+
+	cf_free(r.buf);
+
+	return NULL;
+}
+
+
+//==========================================================
+// Local helpers - msgs on the wire.
+//
+
+static msg*
+create_data_msg(const fb_channel* ch, const uint8_t* record, uint32_t tid)
+{
+	static const uint8_t digest[20] = { 0x5a };
+	static const uint8_t meta[META_SZ] = { 0x3c };
+
+	msg* m = msg_create(BENCH_M_TYPE);
+
+	msg_set_uint32(m, FB_FIELD_OP, ch->shape->op);
+	msg_set_uint32(m, FB_FIELD_TID, tid);
+	msg_set_uint64(m, FB_FIELD_SEND_NS, cf_getns());
+	msg_set_uint32(m, FB_FIELD_NS_IX, 0);
+	msg_set_buf(m, FB_FIELD_DIGEST, digest, sizeof(digest), MSG_SET_COPY);
+	msg_set_uint32(m, FB_FIELD_GENERATION, 7);
+	msg_set_uint64(m, FB_FIELD_LAST_UPDATE_TIME, 123456789);
+	msg_set_uint32(m, FB_FIELD_VOID_TIME, 0);
+	msg_set_buf(m, FB_FIELD_RECORD, record, ch->msg_sz, MSG_SET_COPY);
+
+	if (ch->shape->op == FB_OP_MIGRATE) {
+		msg_set_buf(m, FB_FIELD_META, meta, sizeof(meta), MSG_SET_COPY);
+	}
+
+	return m;
+}
+
+// Destroys the msg.
+static void
+send_msg(int fd, msg* m, uint8_t* buf)
+{
+	size_t sz = msg_to_wire(m, buf);
+
+	msg_destroy(m);
+	send_all(fd, buf, sz);
+}
+
+static void
+send_all(int fd, const uint8_t* buf, size_t sz)
+{
+	while (sz != 0) {
+		ssize_t sent = send(fd, buf, sz, MSG_NOSIGNAL);
+
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			cf_crash(AS_FABRIC, "bench send failed: %d (%s)", errno,
+					cf_strerror(errno));
+		}
+
+		buf += sent;
+		sz -= (size_t)sent;
+	}
+}
+
+// Returned msg's fields may point into the reader's buffer - destroy it before
+// the next read.
+static msg*
+read_msg(fb_reader* r)
+{
+	while (true) {
+		size_t avail = r->end - r->start;
+		uint32_t body_sz;
+		msg_type type;
+
+		if (msg_parse_hdr(&body_sz, &type, r->buf + r->start, avail)) {
+			size_t total_sz = sizeof(msg_hdr) + body_sz;
+
+			cf_assert(type == BENCH_M_TYPE && total_sz <= r->capacity,
+					AS_FABRIC, "bad bench msg type %d size %zu", type,
+					total_sz);
+
+			if (avail >= total_sz) {
+				msg* m = msg_create(BENCH_M_TYPE);
+
+				if (! msg_parse_fields(m, r->buf + r->start + sizeof(msg_hdr),
+						body_sz)) {
+					cf_crash(AS_FABRIC, "bench msg parse failed");
+				}
+
+				r->start += total_sz;
+
+				return m;
+			}
+		}
+
+		memmove(r->buf, r->buf + r->start, avail);
+		r->start = 0;
+		r->end = avail;
+
+		ssize_t got = recv(r->fd, r->buf + r->end, r->capacity - r->end, 0);
+
+		if (got <= 0) {
+			if (got < 0 && errno == EINTR) {
+				continue;
+			}
+
+			cf_crash(AS_FABRIC, "bench recv failed: %d (%s)", errno,
+					cf_strerror(errno));
+		}
+
+		r->end += (size_t)got;
+	}
+}
+
+
+//==========================================================
+// Local helpers - generic.
+//
+
+static uint64_t
+process_cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+static int
+compare_u64(const void* pa, const void* pb)
+{
+	uint64_t a = *(const uint64_t*)pa;
+	uint64_t b = *(const uint64_t*)pb;
+
+	return a > b ? 1 : (a < b ? -1 : 0);
+}
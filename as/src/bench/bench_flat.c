@@ -0,0 +1,174 @@
+/*
+ * bench_flat.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "citrusleaf/alloc.h"
+
+#include "log.h"
+#include "vmapx.h"
+
+#include "base/datamodel.h"
+#include "base/index.h"
+#include "bench/bench.h"
+#include "storage/flat.h"
+#include "storage/storage.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_BINS 10
+
+static const char SET_NAME[] = "bench-set";
+static const uint8_t KEY[] = { 3, 'u', 's', 'e', 'r', '-', '4', '2' };
+
+typedef struct flat_bench_s {
+	as_namespace* ns;
+	as_record r;
+	as_bin bins[N_BINS];
+	as_storage_rd rd;
+	uint32_t flat_sz;
+	as_flat_record* flat;
+	uint64_t sum; // defeats dead-code elimination
+} flat_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void bench_pack(void* udata, uint32_t n_ops);
+static void bench_unpack(void* udata, uint32_t n_ops);
+
+
+//==========================================================
+// Public API.
+//
+
+// A multi-bin device record of integer bins, with set name and stored key.
+void
+as_bench_flat(void)
+{
+	static flat_bench fb;
+
+	// Only what flat.c looks at - bin names, and not data-in-memory.
+	as_namespace* ns = cf_calloc(1, sizeof(as_namespace));
+
+	strcpy(ns->name, "bench");
+	ns->p_bin_name_vmap = cf_malloc(cf_vmapx_sizeof(AS_BIN_NAME_MAX_SZ,
+			MAX_BIN_NAMES));
+
+	cf_vmapx_init(ns->p_bin_name_vmap, AS_BIN_NAME_MAX_SZ, MAX_BIN_NAMES,
+			64 * 1024, AS_BIN_NAME_MAX_SZ);
+
+	fb.ns = ns;
+	fb.r.generation = 1;
+	fb.r.last_update_time = 1000;
+	memset(&fb.r.keyd, 0x5a, sizeof(cf_digest));
+
+	for (uint32_t i = 0; i < N_BINS; i++) {
+		as_bin* b = &fb.bins[i];
+		char name[AS_BIN_NAME_MAX_SZ];
+		uint32_t len = (uint32_t)sprintf(name, "bin-%u", i);
+
+		if (! as_bin_set_id_from_name_w_len(ns, b, (const uint8_t*)name,
+				len)) {
+			cf_crash(AS_BIN, "bench bin name failed");
+		}
+
+		as_bin_particle_integer_set(b, (int64_t)i << (i * 5));
+		as_bin_state_set_from_type(b, AS_PARTICLE_TYPE_INTEGER);
+	}
+
+	fb.rd = (as_storage_rd){
+			.r = &fb.r,
+			.ns = ns,
+			.bins = fb.bins,
+			.n_bins = N_BINS,
+			.set_name_len = sizeof(SET_NAME) - 1,
+			.set_name = SET_NAME,
+			.key_size = sizeof(KEY),
+			.key = KEY
+	};
+
+	fb.flat_sz = SIZE_UP_TO_RBLOCK_SIZE(as_flat_record_size(&fb.rd));
+	fb.flat = cf_calloc(1, fb.flat_sz);
+
+	bench_pack(&fb, 1); // so unpack has something to read if filtered out
+
+	as_bench_run("flat-pack-record", bench_pack, &fb, 1000000);
+	as_bench_run("flat-unpack-record", bench_unpack, &fb, 1000000);
+
+	cf_free(fb.flat);
+	// Namespace and its vmap live until the process exits.
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+// Sizes then packs - as the write path does.
+static void
+bench_pack(void* udata, uint32_t n_ops)
+{
+	flat_bench* fb = (flat_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		uint32_t sz = as_flat_record_size(&fb->rd);
+
+		as_flat_pack_record(&fb->rd, SIZE_TO_N_RBLOCKS(sz), false, fb->flat);
+		fb->sum += sz;
+	}
+}
+
+static void
+bench_unpack(void* udata, uint32_t n_ops)
+{
+	flat_bench* fb = (flat_bench*)udata;
+	const uint8_t* end = (const uint8_t*)fb->flat + fb->flat_sz;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		as_flat_opt_meta opt_meta = { { 0 } };
+		const uint8_t* at = as_flat_unpack_record_meta(fb->flat, end,
+				&opt_meta, false);
+
+		cf_assert(at != NULL, AS_FLAT, "bench unpack meta failed");
+
+		as_bin bins[N_BINS];
+
+		if (as_flat_unpack_bins(fb->ns, at, end, (uint16_t)opt_meta.n_bins,
+				bins) != 0) {
+			cf_crash(AS_FLAT, "bench unpack bins failed");
+		}
+
+		fb->sum += opt_meta.n_bins;
+	}
+}
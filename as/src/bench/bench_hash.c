@@ -0,0 +1,154 @@
+/*
+ * bench_hash.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "citrusleaf/alloc.h"
+
+#include "rchash.h"
+#include "shash.h"
+
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_KEYS (64 * 1024)
+#define N_BUCKETS (16 * 1024) // a few elements per bucket, as in practice
+
+typedef struct hash_bench_s {
+	cf_shash* shash;
+	cf_rchash* rchash;
+	uint64_t sum; // defeats dead-code elimination
+} hash_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void bench_shash_put(void* udata, uint32_t n_ops);
+static void bench_shash_get(void* udata, uint32_t n_ops);
+static void bench_rchash_put(void* udata, uint32_t n_ops);
+static void bench_rchash_get(void* udata, uint32_t n_ops);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_hash(void)
+{
+	static hash_bench hb;
+
+	hb.shash = cf_shash_create(cf_shash_fn_u32, sizeof(uint32_t),
+			sizeof(uint64_t), N_BUCKETS, true);
+	hb.rchash = cf_rchash_create(cf_rchash_fn_u32, NULL, sizeof(uint32_t),
+			N_BUCKETS);
+
+	// Populate in case puts are filtered out.
+	bench_shash_put(&hb, N_KEYS);
+	bench_rchash_put(&hb, N_KEYS);
+
+	as_bench_run("shash-put", bench_shash_put, &hb, N_KEYS);
+	as_bench_run("shash-get", bench_shash_get, &hb, N_KEYS);
+	as_bench_run("rchash-put", bench_rchash_put, &hb, N_KEYS);
+	as_bench_run("rchash-get", bench_rchash_get, &hb, N_KEYS);
+
+	cf_shash_destroy(hb.shash);
+	cf_rchash_destroy(hb.rchash);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+// Overwrites after the first round.
+static void
+bench_shash_put(void* udata, uint32_t n_ops)
+{
+	hash_bench* hb = (hash_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		uint64_t value = i;
+
+		cf_shash_put(hb->shash, &i, &value);
+	}
+}
+
+static void
+bench_shash_get(void* udata, uint32_t n_ops)
+{
+	hash_bench* hb = (hash_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		uint32_t key = (i * 7919) % N_KEYS;
+		uint64_t value;
+
+		if (cf_shash_get(hb->shash, &key, &value) == CF_SHASH_OK) {
+			hb->sum += value;
+		}
+	}
+}
+
+// Replaces (and so releases) the previous round's objects.
+static void
+bench_rchash_put(void* udata, uint32_t n_ops)
+{
+	hash_bench* hb = (hash_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		uint64_t* object = cf_rc_alloc(sizeof(uint64_t));
+
+		*object = i;
+		cf_rchash_put(hb->rchash, &i, object); // hash takes our reference
+	}
+}
+
+static void
+bench_rchash_get(void* udata, uint32_t n_ops)
+{
+	hash_bench* hb = (hash_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		uint32_t key = (i * 7919) % N_KEYS;
+		uint64_t* object;
+
+		if (cf_rchash_get(hb->rchash, &key, (void**)&object) ==
+				CF_RCHASH_OK) {
+			hb->sum += *object;
+
+			if (cf_rc_release(object) == 0) {
+				cf_rc_free(object);
+			}
+		}
+	}
+}
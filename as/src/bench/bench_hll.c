@@ -0,0 +1,220 @@
+/*
+ * bench_hll.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "aerospike/as_msgpack.h"
+
+#include "log.h"
+#include "msgpack_in.h"
+
+#include "base/datamodel.h"
+#include "base/proto.h"
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_INDEX_BITS 14
+#define N_MINHASH_BITS 0
+#define N_ELES_PER_ADD 16
+#define N_ADDS 256
+#define OP_BUF_SZ (32 * N_ELES_PER_ADD)
+
+typedef struct hll_op_buf_s {
+	uint8_t buf[OP_BUF_SZ];
+	uint32_t sz;
+} hll_op_buf;
+
+typedef struct hll_bench_s {
+	as_bin bin;
+	hll_op_buf adds[N_ADDS];
+	hll_op_buf count;
+} hll_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void build_ops(hll_bench* hb);
+static void bench_add(void* udata, uint32_t n_ops);
+static void bench_count(void* udata, uint32_t n_ops);
+static void hll_modify(as_bin* b, const hll_op_buf* op);
+static void hll_read(const as_bin* b, const hll_op_buf* op);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_hll(void)
+{
+	static hll_bench hb;
+
+	build_ops(&hb);
+
+	as_bin_set_empty(&hb.bin);
+	hb.bin.particle = NULL;
+
+	for (uint32_t i = 0; i < N_ADDS; i++) {
+		hll_modify(&hb.bin, &hb.adds[i]);
+	}
+
+	as_bench_run("hll-add", bench_add, &hb, N_ADDS);
+	as_bench_run("hll-count", bench_count, &hb, 100000);
+
+	as_bin_particle_destroy(&hb.bin);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+build_ops(hll_bench* hb)
+{
+	for (uint32_t i = 0; i < N_ADDS; i++) {
+		as_packer pk = {
+				.buffer = hb->adds[i].buf,
+				.capacity = OP_BUF_SZ
+		};
+
+		as_pack_list_header(&pk, 4);
+		as_pack_uint64(&pk, AS_HLL_OP_ADD);
+		as_pack_list_header(&pk, N_ELES_PER_ADD);
+
+		for (uint32_t e = 0; e < N_ELES_PER_ADD; e++) {
+			char str[24];
+			uint32_t len = (uint32_t)sprintf(str, "user-%u",
+					i * N_ELES_PER_ADD + e);
+
+			as_pack_str(&pk, (const uint8_t*)str, len);
+		}
+
+		as_pack_int64(&pk, N_INDEX_BITS);
+		as_pack_int64(&pk, N_MINHASH_BITS);
+
+		cf_assert(pk.offset <= OP_BUF_SZ, AS_PARTICLE, "bench buffer overflow");
+
+		hb->adds[i].sz = pk.offset;
+	}
+
+	as_packer pk = {
+			.buffer = hb->count.buf,
+			.capacity = OP_BUF_SZ
+	};
+
+	as_pack_list_header(&pk, 1);
+	as_pack_uint64(&pk, AS_HLL_OP_COUNT);
+	hb->count.sz = pk.offset;
+}
+
+// Creates the HLL, then adds N_ELES_PER_ADD elements per op.
+static void
+bench_add(void* udata, uint32_t n_ops)
+{
+	hll_bench* hb = (hll_bench*)udata;
+	as_bin b;
+
+	as_bin_set_empty(&b);
+	b.particle = NULL;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		hll_modify(&b, &hb->adds[i]);
+	}
+
+	as_bin_particle_destroy(&b);
+}
+
+static void
+bench_count(void* udata, uint32_t n_ops)
+{
+	hll_bench* hb = (hll_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		hll_read(&hb->bin, &hb->count);
+	}
+}
+
+// Like a write transaction, frees the replaced particle.
+static void
+hll_modify(as_bin* b, const hll_op_buf* op)
+{
+	msgpack_vec vecs[1] = {
+			{ .buf = op->buf, .buf_sz = op->sz }
+	};
+
+	msgpack_in_vec mv = {
+			.n_vecs = 1,
+			.vecs = vecs
+	};
+
+	as_bin old_b = *b;
+	as_bin result;
+
+	as_bin_set_empty(&result);
+	result.particle = NULL;
+
+	int rv = as_bin_hll_modify_exp(b, &mv, &result, false);
+
+	cf_assert(rv == AS_OK, AS_PARTICLE, "bench hll modify failed %d", rv);
+
+	if (as_bin_is_used(&old_b) && old_b.particle != b->particle) {
+		as_bin_particle_destroy(&old_b);
+	}
+
+	as_bin_particle_destroy(&result);
+}
+
+static void
+hll_read(const as_bin* b, const hll_op_buf* op)
+{
+	msgpack_vec vecs[1] = {
+			{ .buf = op->buf, .buf_sz = op->sz }
+	};
+
+	msgpack_in_vec mv = {
+			.n_vecs = 1,
+			.vecs = vecs
+	};
+
+	as_bin result;
+
+	as_bin_set_empty(&result);
+	result.particle = NULL;
+
+	int rv = as_bin_hll_read_exp(b, &mv, &result, false);
+
+	cf_assert(rv == AS_OK, AS_PARTICLE, "bench hll read failed %d", rv);
+
+	as_bin_particle_destroy(&result);
+}
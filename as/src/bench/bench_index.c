@@ -0,0 +1,189 @@
+/*
+ * bench_index.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_digest.h"
+
+#include "arenax.h"
+#include "bits.h"
+#include "log.h"
+
+#include "base/datamodel.h"
+#include "base/index.h"
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_KEYS (1024 * 1024)
+#define STAGE_SIZE CF_ARENAX_MIN_STAGE_SIZE
+
+typedef struct index_bench_s {
+	as_index_tree* tree;
+	cf_digest* keyds;
+	uint64_t n_visited;
+} index_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void make_keyd(uint64_t i, cf_digest* keyd);
+static void bench_insert(void* udata, uint32_t n_ops);
+static void bench_get(void* udata, uint32_t n_ops);
+static void bench_reduce(void* udata, uint32_t n_ops);
+static bool reduce_cb(as_index_ref* r_ref, void* udata);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_index(void)
+{
+	static cf_arenax arena;
+	static as_index_tree_shared shared;
+
+	cf_arenax_init(&arena, CF_XMEM_TYPE_MEM, NULL, 0,
+			(uint32_t)sizeof(as_index), 1, STAGE_SIZE);
+
+	// Like a CE in-memory namespace with the minimum number of sprigs. Nothing
+	// is destroyed, so no destructor.
+	shared.arena = &arena;
+	shared.n_sprigs = NUM_LOCK_PAIRS;
+	shared.locks_shift = NUM_SPRIG_BITS - cf_msb(NUM_LOCK_PAIRS);
+	shared.sprigs_shift = NUM_SPRIG_BITS - cf_msb(shared.n_sprigs);
+	shared.sprigs_offset = sizeof(as_lock_pair) * NUM_LOCK_PAIRS;
+	shared.puddles_offset = 0;
+
+	index_bench ib = {
+			.tree = as_index_tree_create(&shared, 0, NULL, NULL),
+			.keyds = cf_malloc(sizeof(cf_digest) * N_KEYS)
+	};
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		make_keyd(i, &ib.keyds[i]);
+	}
+
+	// First call (warm-up) inserts, rounds then find existing elements.
+	as_bench_run("index-get-insert", bench_insert, &ib, N_KEYS);
+	bench_insert(&ib, N_KEYS); // in case filtered out above
+
+	as_bench_run("index-get", bench_get, &ib, N_KEYS);
+	as_bench_run("index-reduce", bench_reduce, &ib, N_KEYS);
+
+	// Tree and arena live until the process exits.
+	cf_free(ib.keyds);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+// Spread like real RIPEMD-160 digests - sprig and lock bits come from here.
+static void
+make_keyd(uint64_t i, cf_digest* keyd)
+{
+	uint64_t x = i;
+
+	for (uint32_t off = 0; off < CF_DIGEST_KEY_SZ; off += sizeof(uint64_t)) {
+		// splitmix64
+		x += 0x9e3779b97f4a7c15;
+
+		uint64_t z = x;
+
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		z ^= z >> 31;
+
+		uint32_t sz = CF_DIGEST_KEY_SZ - off < sizeof(uint64_t) ?
+				CF_DIGEST_KEY_SZ - off : sizeof(uint64_t);
+
+		memcpy(&keyd->digest[off], &z, sz);
+	}
+}
+
+static void
+bench_insert(void* udata, uint32_t n_ops)
+{
+	index_bench* ib = (index_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		as_index_ref r_ref;
+
+		if (as_index_get_insert_vlock(ib->tree, &ib->keyds[i], &r_ref) < 0) {
+			cf_crash(AS_INDEX, "bench arena full");
+		}
+
+		r_ref.r->generation = 1; // valid, so reduce doesn't skip it
+		as_index_olock_unlock(r_ref.olock);
+	}
+}
+
+static void
+bench_get(void* udata, uint32_t n_ops)
+{
+	index_bench* ib = (index_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		as_index_ref r_ref;
+
+		if (as_index_get_vlock(ib->tree, &ib->keyds[i], &r_ref) == 0) {
+			as_index_olock_unlock(r_ref.olock);
+		}
+	}
+}
+
+static void
+bench_reduce(void* udata, uint32_t n_ops)
+{
+	(void)n_ops;
+
+	index_bench* ib = (index_bench*)udata;
+
+	ib->n_visited = 0;
+	as_index_reduce(ib->tree, reduce_cb, ib);
+}
+
+static bool
+reduce_cb(as_index_ref* r_ref, void* udata)
+{
+	index_bench* ib = (index_bench*)udata;
+
+	ib->n_visited++;
+	as_index_olock_unlock(r_ref->olock);
+
+	return true;
+}
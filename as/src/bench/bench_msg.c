@@ -0,0 +1,179 @@
+/*
+ * bench_msg.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "citrusleaf/alloc.h"
+
+#include "log.h"
+#include "msg.h"
+
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Shaped like a replica write - a bench-only template on a spare type.
+#define BENCH_M_TYPE M_TYPE_UNUSED_13
+
+typedef enum {
+	BENCH_FIELD_OP,
+	BENCH_FIELD_NS_IX,
+	BENCH_FIELD_DIGEST,
+	BENCH_FIELD_TID,
+	BENCH_FIELD_GENERATION,
+	BENCH_FIELD_LAST_UPDATE_TIME,
+	BENCH_FIELD_RECORD,
+
+	NUM_BENCH_FIELDS
+} bench_msg_field;
+
+static const msg_template bench_mt[] = {
+		{ BENCH_FIELD_OP, M_FT_UINT32 },
+		{ BENCH_FIELD_NS_IX, M_FT_UINT32 },
+		{ BENCH_FIELD_DIGEST, M_FT_BUF },
+		{ BENCH_FIELD_TID, M_FT_UINT32 },
+		{ BENCH_FIELD_GENERATION, M_FT_UINT32 },
+		{ BENCH_FIELD_LAST_UPDATE_TIME, M_FT_UINT64 },
+		{ BENCH_FIELD_RECORD, M_FT_BUF }
+};
+
+#define BENCH_MSG_SCRATCH_SIZE 192
+#define RECORD_SZ 1024
+
+typedef struct msg_bench_s {
+	uint8_t digest[20];
+	uint8_t record[RECORD_SZ];
+	uint8_t* wire;
+	size_t wire_sz;
+	uint64_t sum; // defeats dead-code elimination
+} msg_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static msg* fill_msg(const msg_bench* mb, uint32_t tid);
+static void bench_to_wire(void* udata, uint32_t n_ops);
+static void bench_parse(void* udata, uint32_t n_ops);
+
+
+//==========================================================
+// Public API.
+//
+
+void
+as_bench_msg(void)
+{
+	static msg_bench mb;
+
+	msg_type_register(BENCH_M_TYPE, bench_mt, sizeof(bench_mt),
+			BENCH_MSG_SCRATCH_SIZE);
+
+	memset(mb.digest, 0x5a, sizeof(mb.digest));
+	memset(mb.record, 0xa5, sizeof(mb.record));
+
+	msg* m = fill_msg(&mb, 1);
+
+	mb.wire_sz = msg_get_wire_size(m);
+	mb.wire = cf_malloc(mb.wire_sz);
+	msg_to_wire(m, mb.wire);
+	msg_destroy(m);
+
+	as_bench_run("msg-to-wire", bench_to_wire, &mb, 1000000);
+	as_bench_run("msg-parse", bench_parse, &mb, 1000000);
+
+	cf_free(mb.wire);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static msg*
+fill_msg(const msg_bench* mb, uint32_t tid)
+{
+	msg* m = msg_create(BENCH_M_TYPE);
+
+	msg_set_uint32(m, BENCH_FIELD_OP, 1);
+	msg_set_uint32(m, BENCH_FIELD_NS_IX, 0);
+	msg_set_buf(m, BENCH_FIELD_DIGEST, mb->digest, sizeof(mb->digest),
+			MSG_SET_COPY);
+	msg_set_uint32(m, BENCH_FIELD_TID, tid);
+	msg_set_uint32(m, BENCH_FIELD_GENERATION, 7);
+	msg_set_uint64(m, BENCH_FIELD_LAST_UPDATE_TIME, 123456789);
+	msg_set_buf(m, BENCH_FIELD_RECORD, mb->record, sizeof(mb->record),
+			MSG_SET_COPY);
+
+	return m;
+}
+
+// Create, fill and serialize - the fabric send path.
+static void
+bench_to_wire(void* udata, uint32_t n_ops)
+{
+	msg_bench* mb = (msg_bench*)udata;
+	uint8_t buf[mb->wire_sz];
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		msg* m = fill_msg(mb, i);
+
+		mb->sum += msg_to_wire(m, buf);
+		msg_destroy(m);
+	}
+}
+
+// Create, parse and read fields - the fabric receive path.
+static void
+bench_parse(void* udata, uint32_t n_ops)
+{
+	msg_bench* mb = (msg_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		msg* m = msg_create(BENCH_M_TYPE);
+
+		if (! msg_parse(m, mb->wire, mb->wire_sz)) {
+			cf_crash(CF_MSG, "bench msg parse failed");
+		}
+
+		uint32_t tid = 0;
+		uint8_t* record = NULL;
+		size_t record_sz = 0;
+
+		msg_get_uint32(m, BENCH_FIELD_TID, &tid);
+		msg_get_buf(m, BENCH_FIELD_RECORD, &record, &record_sz,
+				MSG_GET_DIRECT);
+
+		mb->sum += tid + record_sz;
+		msg_destroy(m);
+	}
+}
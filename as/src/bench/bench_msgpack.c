@@ -0,0 +1,170 @@
+/*
+ * bench_msgpack.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "aerospike/as_msgpack.h"
+
+#include "log.h"
+#include "msgpack_in.h"
+
+#include "bench/bench.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_ELES 1000
+#define BUF_SZ (64 * 1024)
+
+typedef struct msgpack_bench_s {
+	uint8_t buf[BUF_SZ];
+	uint32_t buf_sz;
+	uint64_t sum; // defeats dead-code elimination
+} msgpack_bench;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void bench_sz(void* udata, uint32_t n_ops);
+static void bench_parse(void* udata, uint32_t n_ops);
+static void bench_cmp(void* udata, uint32_t n_ops);
+
+
+//==========================================================
+// Public API.
+//
+
+// A list of N_ELES [int, str, {str: int}] triples - a typical CDT payload.
+void
+as_bench_msgpack(void)
+{
+	static msgpack_bench mb;
+
+	as_packer pk = {
+			.buffer = mb.buf,
+			.capacity = BUF_SZ
+	};
+
+	as_pack_list_header(&pk, N_ELES);
+
+	for (uint32_t i = 0; i < N_ELES; i++) {
+		char str[16];
+		uint32_t len = (uint32_t)sprintf(str, "value-%u", i);
+
+		as_pack_list_header(&pk, 3);
+		as_pack_int64(&pk, (int64_t)i * 7919);
+		as_pack_str(&pk, (const uint8_t*)str, len);
+		as_pack_map_header(&pk, 1);
+		as_pack_str(&pk, (const uint8_t*)str, len);
+		as_pack_uint64(&pk, i);
+	}
+
+	cf_assert(pk.offset <= BUF_SZ, AS_PARTICLE, "bench buffer overflow");
+
+	mb.buf_sz = pk.offset;
+
+	as_bench_run("msgpack-sz", bench_sz, &mb, 10000);
+	as_bench_run("msgpack-parse", bench_parse, &mb, 10000);
+	as_bench_run("msgpack-cmp", bench_cmp, &mb, 10000);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+// Skips the whole list - what most CDT ops do to find element boundaries.
+static void
+bench_sz(void* udata, uint32_t n_ops)
+{
+	msgpack_bench* mb = (msgpack_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		msgpack_in mp = {
+				.buf = mb->buf,
+				.buf_sz = mb->buf_sz
+		};
+
+		mb->sum += msgpack_sz(&mp);
+	}
+}
+
+// Decodes every scalar.
+static void
+bench_parse(void* udata, uint32_t n_ops)
+{
+	msgpack_bench* mb = (msgpack_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		msgpack_in mp = {
+				.buf = mb->buf,
+				.buf_sz = mb->buf_sz
+		};
+
+		uint32_t n_eles = 0;
+
+		msgpack_get_list_ele_count(&mp, &n_eles);
+
+		for (uint32_t e = 0; e < n_eles; e++) {
+			uint32_t count;
+			int64_t i64 = 0;
+			uint64_t u64 = 0;
+			uint32_t sz = 0;
+
+			msgpack_get_list_ele_count(&mp, &count);
+			msgpack_get_int64(&mp, &i64);
+			msgpack_get_bin(&mp, &sz);
+			msgpack_get_map_ele_count(&mp, &count);
+			msgpack_get_bin(&mp, &sz);
+			msgpack_get_uint64(&mp, &u64);
+
+			mb->sum += (uint64_t)i64 + u64 + sz;
+		}
+	}
+}
+
+// Full-depth compare of two equal lists - the worst case for ordering.
+static void
+bench_cmp(void* udata, uint32_t n_ops)
+{
+	msgpack_bench* mb = (msgpack_bench*)udata;
+
+	for (uint32_t i = 0; i < n_ops; i++) {
+		msgpack_in mp0 = {
+				.buf = mb->buf,
+				.buf_sz = mb->buf_sz
+		};
+
+		msgpack_in mp1 = mp0;
+
+		mb->sum += msgpack_cmp(&mp0, &mp1);
+	}
+}
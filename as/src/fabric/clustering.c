@@ -33,6 +33,7 @@
 #include "citrusleaf/cf_random.h"
 
 #include "cf_thread.h"
+#include "dynbuf.h"
 #include "log.h"
 #include "msg.h"
 #include "node.h"
@@ -856,8 +857,70 @@ typedef struct as_clustering_quantum_interval_generator_s
 	 * Indicates if current quantum interval should be postponed.
 	 */
 	bool is_interval_postponed;
+
+	/**
+	 * Monotonic time the heartbeat subsystem detected the earliest adjacency
+	 * fault in the current quantum. Zero if there has been no such fault.
+	 */
+	cf_clock fault_detect_ts;
+
+	/**
+	 * Indicates if a majority of the cluster has confirmed the node departures
+	 * seen in the current quantum, in which case there is no need to wait
+	 * out the usual departure settling time.
+	 */
+	bool is_departure_confirmed;
 } as_clustering_quantum_interval_generator;
 
+/**
+ * Monotonic timestamps of the phases of a cluster change. A timestamp is zero
+ * if this node did not take part in the phase, e.g. paxos phases on nodes
+ * other than the proposer.
+ */
+typedef struct as_clustering_phase_times_s
+{
+	/**
+	 * Estimated time of the earliest fault that led to the change.
+	 */
+	cf_clock fault_ts;
+
+	/**
+	 * Time the earliest fault was detected.
+	 */
+	cf_clock detect_ts;
+
+	/**
+	 * Time the quantum interval that acted on the faults started.
+	 */
+	cf_clock quantum_start_ts;
+
+	/**
+	 * Time the paxos prepare was first sent.
+	 */
+	cf_clock prepare_ts;
+
+	/**
+	 * Time a majority promised and the paxos accept was first sent.
+	 */
+	cf_clock accept_ts;
+
+	/**
+	 * Time a majority accepted and the paxos learn was first sent.
+	 */
+	cf_clock learn_ts;
+
+	/**
+	 * Time the new cluster was applied to the register.
+	 */
+	cf_clock commit_ts;
+
+	/**
+	 * Indicates if the quantum interval was started early because a majority
+	 * confirmed the node departures.
+	 */
+	bool is_fast_path;
+} as_clustering_phase_times;
+
 /**
  * State of the clustering register.
  */
@@ -1123,6 +1186,8 @@ static bool
 clustering_is_principal();
 static bool
 clustering_is_cluster_member(cf_node nodeid);
+static bool
+clustering_departure_is_confirmed();
 
 /*
  * ----------------------------------------------------------------------------
@@ -1712,6 +1777,16 @@ static as_clustering g_clustering = { 0 };
  */
 static as_paxos_proposer g_proposer;
 
+/**
+ * Phase timestamps of the cluster change in progress.
+ */
+static as_clustering_phase_times g_phase_times;
+
+/**
+ * Phase timestamps of the last cluster change applied to the register.
+ */
+static as_clustering_phase_times g_last_phase_times;
+
 /**
  * Singleton paxos acceptor.
  */
@@ -2469,6 +2544,12 @@ quantum_interval_node_arrived_wait_time(as_clustering_quantum_fault* fault)
 static uint32_t
 quantum_interval_node_departed_wait_time(as_clustering_quantum_fault* fault)
 {
+	if (g_quantum_interval_generator.is_departure_confirmed) {
+		// A majority no longer sees the departed nodes - there are no more
+		// adjacency changes to wait for.
+		return 0;
+	}
+
 	return MIN(quantum_interval(),
 			as_hb_node_timeout_get()
 					+ 2 * quantum_interval_hb_fault_comm_delay()
@@ -2628,9 +2709,10 @@ quantum_interval_earliest_start_time()
 	if (fault_event_time) {
 		// Ensure we have at least 1/2 quantum interval of separation between
 		// quantum intervals to give chance to multiple fault events that  are
-		// resonably close in time.
-		start_time = MAX(
-				g_quantum_interval_generator.last_quantum_start_time
+		// resonably close in time. Confirmed departures need no such grace.
+		start_time = g_quantum_interval_generator.is_departure_confirmed ?
+				fault_event_time :
+				MAX(g_quantum_interval_generator.last_quantum_start_time
 						+ quantum_interval() / 2, fault_event_time);
 	}
 	CLUSTERING_UNLOCK();
@@ -2695,12 +2777,47 @@ quantum_interval_generator_reset(cf_clock last_quantum_start_time)
 		for (int i = 0; i < QUANTUM_FAULT_TYPE_SENTINEL; i++) {
 			quantum_interval_fault_reset(i);
 		}
+
+		g_quantum_interval_generator.fault_detect_ts = 0;
+		g_quantum_interval_generator.is_departure_confirmed = false;
 	}
 	g_quantum_interval_generator.is_interval_postponed = false;
 
 	CLUSTERING_UNLOCK();
 }
 
+/**
+ * Start recording phase times for a cluster change, if the quantum interval
+ * starting now has faults to act upon.
+ */
+static void
+quantum_interval_phase_times_start(cf_clock now)
+{
+	CLUSTERING_LOCK();
+	cf_clock fault_ts = 0;
+	for (int i = 0; i < QUANTUM_FAULT_TYPE_SENTINEL; i++) {
+		cf_clock event_ts = g_quantum_interval_generator.fault[i].event_ts;
+
+		// A timestamp of 1 marks an ignored fault - see merge candidates.
+		if (event_ts > 1 && (fault_ts == 0 || event_ts < fault_ts)) {
+			fault_ts = event_ts;
+		}
+	}
+
+	if (fault_ts != 0) {
+		memset(&g_phase_times, 0, sizeof(g_phase_times));
+		g_phase_times.fault_ts = fault_ts;
+		g_phase_times.detect_ts =
+				g_quantum_interval_generator.fault_detect_ts ?
+						g_quantum_interval_generator.fault_detect_ts :
+						fault_ts;
+		g_phase_times.quantum_start_ts = now;
+		g_phase_times.is_fast_path =
+				g_quantum_interval_generator.is_departure_confirmed;
+	}
+	CLUSTERING_UNLOCK();
+}
+
 /**
  * Handle timer event and generate a quantum internal event if required.
  */
@@ -2711,6 +2828,13 @@ quantum_interval_generator_timer_event_handle(
 	CLUSTERING_LOCK();
 	cf_clock now = cf_getms();
 
+	if (g_quantum_interval_generator.fault[QUANTUM_FAULT_NODE_DEPARTED].event_ts
+			&& !g_quantum_interval_generator.is_departure_confirmed
+			&& clustering_departure_is_confirmed()) {
+		INFO("node departure confirmed by majority - starting quantum interval early");
+		g_quantum_interval_generator.is_departure_confirmed = true;
+	}
+
 	cf_clock earliest_quantum_start_time =
 			quantum_interval_earliest_start_time();
 
@@ -2735,6 +2859,10 @@ quantum_interval_generator_timer_event_handle(
 			+ quantum_wait_buffer > now;
 	bool fire_quantum_event = earliest_quantum_start_time <= now
 			|| !is_skippable;
+
+	if (fire_quantum_event) {
+		quantum_interval_phase_times_start(now);
+	}
 	CLUSTERING_UNLOCK();
 
 	if (fire_quantum_event) {
@@ -2808,6 +2936,14 @@ quantum_interval_generator_hb_event_handle(
 			min_event_node[events[i].evt] = events[i].nodeid;
 		}
 
+		if (events[i].evt != AS_HB_NODE_ADJACENCY_CHANGED
+				&& (g_quantum_interval_generator.fault_detect_ts == 0
+						|| g_quantum_interval_generator.fault_detect_ts
+								> events[i].event_detected_time)) {
+			g_quantum_interval_generator.fault_detect_ts =
+					events[i].event_detected_time;
+		}
+
 		if (events[i].evt == AS_HB_NODE_DEPART
 				&& clustering_is_our_principal(events[i].nodeid)) {
 			quantum_interval_fault_update(QUANTUM_FAULT_PRINCIPAL_DEPARTED,
@@ -3198,6 +3334,76 @@ clustering_dead_nodes_find(cf_vector* dead_nodes)
 	CLUSTERING_UNLOCK();
 }
 
+/**
+ * Udata to count the cluster members that confirm a set of node departures.
+ */
+typedef struct clustering_departure_confirm_udata_s
+{
+	cf_vector* departed_nodes;
+	uint32_t confirmed_count;
+} clustering_departure_confirm_udata;
+
+/**
+ * Count a cluster member as confirming the departures if its heartbeat
+ * adjacency list holds none of the departed nodes.
+ */
+static void
+clustering_departure_confirm_count(cf_node nodeid, void* plugin_data,
+		size_t plugin_data_size, cf_clock recv_monotonic_ts,
+		as_hlc_msg_timestamp* msg_hlc_ts, void* udata)
+{
+	if (plugin_data == NULL) {
+		// Not adjacent - either departed itself or not yet heard from.
+		return;
+	}
+
+	clustering_departure_confirm_udata* confirm =
+			(clustering_departure_confirm_udata*)udata;
+	cf_node* adjacency_list = (cf_node*)plugin_data;
+	size_t adjacency_length = plugin_data_size / sizeof(cf_node);
+
+	for (size_t i = 0; i < adjacency_length; i++) {
+		if (vector_find(confirm->departed_nodes, &adjacency_list[i]) >= 0) {
+			return;
+		}
+	}
+
+	confirm->confirmed_count++;
+}
+
+/**
+ * Indicates if a majority of the current succession list, counting self, no
+ * longer sees the cluster members that have departed from self's adjacency.
+ */
+static bool
+clustering_departure_is_confirmed()
+{
+	CLUSTERING_LOCK();
+
+	bool is_confirmed = false;
+	cf_vector* departed_nodes = vector_stack_lockless_create(cf_node);
+	clustering_dead_nodes_find(departed_nodes);
+
+	if (cf_vector_size(departed_nodes) != 0) {
+		// Self has already seen the departures.
+		clustering_departure_confirm_udata confirm = {
+			.departed_nodes = departed_nodes,
+			.confirmed_count = 1
+		};
+
+		as_hb_plugin_data_iterate(&g_register.succession_list,
+				AS_HB_PLUGIN_HB, clustering_departure_confirm_count, &confirm);
+
+		is_confirmed = confirm.confirmed_count
+				>= 1 + (cf_vector_size(&g_register.succession_list) / 2);
+	}
+
+	cf_vector_destroy(departed_nodes);
+	CLUSTERING_UNLOCK();
+
+	return is_confirmed;
+}
+
 /**
  * Indicates if a node is faulty. A node in the succecssion list deemed faulty
  * - if the node is alive and it reports to be an orphan or is part of some
@@ -4210,6 +4416,10 @@ paxos_proposer_promise_handle(as_clustering_internal_event* event)
 		// We have quorum number of promises. go ahead to the accept phase.
 		g_proposer.state = AS_PAXOS_PROPOSER_STATE_ACCEPT_SENT;
 		paxos_proposer_accept_send();
+
+		if (g_phase_times.accept_ts == 0) {
+			g_phase_times.accept_ts = g_proposer.accept_send_time;
+		}
 	}
 
 Exit:
@@ -4280,6 +4490,10 @@ paxos_proposer_success()
 	g_proposer.learn_retransmit_needed = true;
 	paxos_proposer_learn_send();
 
+	if (g_phase_times.learn_ts == 0) {
+		g_phase_times.learn_ts = g_proposer.learn_send_time;
+	}
+
 	// Retain the sequence_number, cluster key and succession list for
 	// retransmits of the learn message.
 	as_clustering_internal_event paxos_success_event;
@@ -4683,6 +4897,10 @@ paxos_proposer_proposal_start(cf_vector* new_succession_list,
 
 	g_proposer.paxos_round_start_time = cf_getms();
 
+	if (g_phase_times.prepare_ts == 0) {
+		g_phase_times.prepare_ts = g_proposer.paxos_round_start_time;
+	}
+
 	// Populate the proposed value struct with new succession list and a new
 	// cluster key.
 	vector_clear(&g_proposer.proposed_value.succession_list);
@@ -5750,6 +5968,49 @@ register_timer_event_handle()
 	CLUSTERING_UNLOCK();
 }
 
+/**
+ * Milliseconds between two phase timestamps, zero if either phase was not
+ * observed.
+ */
+static uint64_t
+phase_times_ms(cf_clock from, cf_clock to)
+{
+	return from != 0 && to >= from ? to - from : 0;
+}
+
+/**
+ * Close out phase times for the cluster change just applied to the register.
+ */
+static void
+register_phase_times_commit()
+{
+	CLUSTERING_LOCK();
+
+	g_phase_times.commit_ts = cf_getms();
+
+	// Nodes that did not run the quantum interval for this change only see
+	// the commit.
+	cf_clock start_ts = g_phase_times.quantum_start_ts ?
+			g_phase_times.quantum_start_ts : g_phase_times.commit_ts;
+
+	INFO("cluster change phases (ms): detection %"PRIu64" quantum-wait %"PRIu64" paxos-prepare %"PRIu64" paxos-accept %"PRIu64" paxos-commit %"PRIu64" total %"PRIu64"%s",
+			phase_times_ms(g_phase_times.fault_ts, g_phase_times.detect_ts),
+			phase_times_ms(g_phase_times.detect_ts,
+					g_phase_times.quantum_start_ts),
+			phase_times_ms(g_phase_times.prepare_ts, g_phase_times.accept_ts),
+			phase_times_ms(g_phase_times.accept_ts, g_phase_times.learn_ts),
+			phase_times_ms(g_phase_times.learn_ts, g_phase_times.commit_ts),
+			phase_times_ms(g_phase_times.fault_ts ?
+					g_phase_times.fault_ts : start_ts,
+					g_phase_times.commit_ts),
+			g_phase_times.is_fast_path ? " (fast path)" : "");
+
+	g_last_phase_times = g_phase_times;
+	memset(&g_phase_times, 0, sizeof(g_phase_times));
+
+	CLUSTERING_UNLOCK();
+}
+
 /**
  * Handle paxos round succeeding.
  */
@@ -5798,6 +6059,8 @@ register_paxos_acceptor_success_handle(
 	INFO("applied cluster size %d",
 			cf_vector_size(&g_register.succession_list));
 
+	register_phase_times_commit();
+
 	as_clustering_internal_event cluster_changed;
 	memset(&cluster_changed, 0, sizeof(cluster_changed));
 	cluster_changed.type =
@@ -8018,6 +8281,29 @@ as_clustering_has_integrity()
 	return g_clustering.has_integrity;
 }
 
+/**
+ * Append phase durations of the last cluster change to an info buffer.
+ */
+void
+as_clustering_info_phase_times(cf_dyn_buf* db)
+{
+	CLUSTERING_LOCK();
+	as_clustering_phase_times times = g_last_phase_times;
+	CLUSTERING_UNLOCK();
+
+	info_append_uint64(db, "cluster_change_detection_ms",
+			phase_times_ms(times.fault_ts, times.detect_ts));
+	info_append_uint64(db, "cluster_change_quantum_wait_ms",
+			phase_times_ms(times.detect_ts, times.quantum_start_ts));
+	info_append_uint64(db, "cluster_change_paxos_prepare_ms",
+			phase_times_ms(times.prepare_ts, times.accept_ts));
+	info_append_uint64(db, "cluster_change_paxos_accept_ms",
+			phase_times_ms(times.accept_ts, times.learn_ts));
+	info_append_uint64(db, "cluster_change_paxos_commit_ms",
+			phase_times_ms(times.learn_ts, times.commit_ts));
+	info_append_bool(db, "cluster_change_fast_path", times.is_fast_path);
+}
+
 /**
  * Indicates if self node is orphaned.
  */
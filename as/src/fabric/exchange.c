@@ -130,6 +130,11 @@
  */
 #define AS_EXTERNAL_EVENT_LISTENER_MAX 7
 
+/**
+ * Lowest compatibility id of nodes that understand partition version deltas.
+ */
+#define AS_EXCHANGE_DELTA_MIN_COMPATIBILITY_ID 13
+
 /*
  * ----------------------------------------------------------------------------
  * Exchange data format for namespaces payload
@@ -289,7 +294,7 @@ typedef enum
 	AS_EXCHANGE_MSG_TYPE_DATA_ACK,
 
 	/**
-	 * Not used.
+	 * Request for full exchange data after failing to apply deltas.
 	 */
 	AS_EXCHANGE_MSG_TYPE_DATA_NACK,
 
@@ -405,6 +410,12 @@ typedef struct as_exchange_node_state_s
 	 */
 	bool is_ready_to_commit;
 
+	/**
+	 * Indicates if this peer node could not apply self node's partition
+	 * version deltas and must be sent full partition versions this round.
+	 */
+	bool needs_full_data;
+
 	/**
 	 * Exchange data received from this peer node. Member variables may be heap
 	 * allocated and hence should be freed carefully while discarding this
@@ -514,6 +525,28 @@ typedef struct as_exchange_s
 	 */
 	bool orphan_state_are_transactions_blocked;
 
+	/**
+	 * Time the current exchange round started.
+	 */
+	cf_clock exchange_start_ts;
+
+	/**
+	 * Duration of the last committed exchange round, up to the commit.
+	 */
+	uint64_t last_exchange_ms;
+
+	/**
+	 * Duration of the partition balance for the last committed exchange.
+	 */
+	uint64_t last_balance_ms;
+
+	/**
+	 * Cluster key of the exchange round whose partition versions are held in
+	 * the namespaces' cluster versions. Zero if they are not from a complete
+	 * round. Partition version deltas are relative to these versions.
+	 */
+	as_cluster_key versions_cluster_key;
+
 	/**
 	 * Will have an as_exchange_node_state entry for every node in the
 	 * succession list.
@@ -525,10 +558,22 @@ typedef struct as_exchange_s
 	 */
 	cf_dyn_buf self_data_dyn_buf[AS_NAMESPACE_SZ];
 
+	/**
+	 * Self node's partition versions changed since the last committed round.
+	 */
+	cf_dyn_buf self_delta_dyn_buf[AS_NAMESPACE_SZ];
+
 	/**
 	 * This node's exchange data fabric message to send for current round.
 	 */
 	msg* data_msg;
+
+	/**
+	 * This node's exchange data fabric message carrying only partition version
+	 * deltas, for nodes in the last committed cluster. NULL if deltas can't be
+	 * used this round.
+	 */
+	msg* data_delta_msg;
 } as_exchange;
 
 /**
@@ -647,6 +692,7 @@ typedef enum
 	AS_EXCHANGE_MSG_NS_REBALANCE_FLAGS,
 	AS_EXCHANGE_MSG_COMPATIBILITY_ID,
 	AS_EXCHANGE_MSG_NS_REPLICATION_FACTORS,
+	AS_EXCHANGE_MSG_BASE_CLUSTER_KEY,
 
 	NUM_EXCHANGE_MSG_FIELDS
 } as_exchange_msg_fields;
@@ -668,7 +714,8 @@ static const msg_template exchange_msg_template[] = {
 		{ AS_EXCHANGE_MSG_NS_REBALANCE_REGIMES, M_FT_MSGPACK },
 		{ AS_EXCHANGE_MSG_NS_REBALANCE_FLAGS, M_FT_MSGPACK },
 		{ AS_EXCHANGE_MSG_COMPATIBILITY_ID, M_FT_UINT32 },
-		{ AS_EXCHANGE_MSG_NS_REPLICATION_FACTORS, M_FT_MSGPACK }
+		{ AS_EXCHANGE_MSG_NS_REPLICATION_FACTORS, M_FT_MSGPACK },
+		{ AS_EXCHANGE_MSG_BASE_CLUSTER_KEY, M_FT_UINT64 }
 };
 
 COMPILER_ASSERT(sizeof(exchange_msg_template) / sizeof(msg_template) ==
@@ -1224,6 +1271,7 @@ exchange_node_state_reset(as_exchange_node_state* node_state)
 	node_state->send_acked = false;
 	node_state->received = false;
 	node_state->is_ready_to_commit = false;
+	node_state->needs_full_data = false;
 
 	node_state->data->num_namespaces = 0;
 	for (int i = 0; i < AS_NAMESPACE_SZ; i++) {
@@ -1493,9 +1541,15 @@ exchange_msg_cluster_key_get(msg* msg, as_cluster_key* cluster_key)
 
 /**
  * Set data payload for a message.
+ *
+ * @param msg the message.
+ * @param pv_bufs per-namespace partition version payloads.
+ * @param base_cluster_key if not zero, the payloads are deltas relative to the
+ * partition versions committed in the round with this cluster key.
  */
 static void
-exchange_msg_data_payload_set(msg* msg)
+exchange_msg_data_payload_set(msg* msg, cf_dyn_buf* pv_bufs,
+		as_cluster_key base_cluster_key)
 {
 	uint32_t ns_count = g_config.n_namespaces;
 
@@ -1524,6 +1578,11 @@ exchange_msg_data_payload_set(msg* msg)
 	msg_set_uint32(msg, AS_EXCHANGE_MSG_COMPATIBILITY_ID,
 			AS_EXCHANGE_COMPATIBILITY_ID);
 
+	if (base_cluster_key != 0) {
+		msg_set_uint64(msg, AS_EXCHANGE_MSG_BASE_CLUSTER_KEY,
+				base_cluster_key);
+	}
+
 	for (uint32_t ns_ix = 0; ns_ix < ns_count; ns_ix++) {
 		as_namespace* ns = g_config.namespaces[ns_ix];
 
@@ -1533,8 +1592,8 @@ exchange_msg_data_payload_set(msg* msg)
 		};
 
 		msg_buf_ele pv_ele = {
-			.sz = (uint32_t)g_exchange.self_data_dyn_buf[ns_ix].used_sz,
-			.ptr = g_exchange.self_data_dyn_buf[ns_ix].buf
+			.sz = (uint32_t)pv_bufs[ns_ix].used_sz,
+			.ptr = pv_bufs[ns_ix].buf
 		};
 
 		msg_buf_ele rn_ele = {
@@ -1758,6 +1817,68 @@ exchange_ready_to_commit_msg_send()
 			"error sending ready to commit message");
 }
 
+/**
+ * Indicates if a node should be sent partition version deltas rather than full
+ * partition versions.
+ */
+static bool
+exchange_node_takes_delta(cf_node nodeid)
+{
+	if (g_exchange.data_delta_msg == NULL
+			|| vector_find(&g_exchange.committed_succession_list, &nodeid) < 0) {
+		return false;
+	}
+
+	as_exchange_node_state node_state;
+	exchange_node_state_get_safe(nodeid, &node_state);
+
+	return !node_state.needs_full_data;
+}
+
+/**
+ * Send exchange data to a list of nodes. Nodes that committed the last round
+ * with self get only the partition version deltas.
+ */
+static void
+exchange_data_msg_send_list(cf_node* nodes, int num_nodes)
+{
+	cf_node full_nodes[num_nodes];
+	int num_full_nodes = 0;
+	cf_node delta_nodes[num_nodes];
+	int num_delta_nodes = 0;
+
+	for (int i = 0; i < num_nodes; i++) {
+		if (exchange_node_takes_delta(nodes[i])) {
+			delta_nodes[num_delta_nodes++] = nodes[i];
+		}
+		else {
+			full_nodes[num_full_nodes++] = nodes[i];
+		}
+	}
+
+	if (num_full_nodes != 0) {
+		as_clustering_log_cf_node_array(CF_DEBUG, AS_EXCHANGE,
+				"sending exchange data to nodes:", full_nodes,
+				num_full_nodes);
+
+		msg_incr_ref(g_exchange.data_msg);
+
+		exchange_msg_send_list(g_exchange.data_msg, full_nodes,
+				num_full_nodes, "error sending exchange data");
+	}
+
+	if (num_delta_nodes != 0) {
+		as_clustering_log_cf_node_array(CF_DEBUG, AS_EXCHANGE,
+				"sending exchange data deltas to nodes:", delta_nodes,
+				num_delta_nodes);
+
+		msg_incr_ref(g_exchange.data_delta_msg);
+
+		exchange_msg_send_list(g_exchange.data_delta_msg, delta_nodes,
+				num_delta_nodes, "error sending exchange data deltas");
+	}
+}
+
 /**
  * Send exchange data to all nodes that have not acked the send.
  */
@@ -1784,14 +1905,7 @@ exchange_data_msg_send_pending_ack()
 	// FIXME - temporary assert, until we're sure.
 	cf_assert(g_exchange.data_msg != NULL, AS_EXCHANGE, "payload not built");
 
-	as_clustering_log_cf_node_array(CF_DEBUG, AS_EXCHANGE,
-			"sending exchange data to nodes:", unacked_nodes,
-			num_unacked_nodes);
-
-	msg_incr_ref(g_exchange.data_msg);
-
-	exchange_msg_send_list(g_exchange.data_msg, unacked_nodes,
-			num_unacked_nodes, "error sending exchange data");
+	exchange_data_msg_send_list(unacked_nodes, num_unacked_nodes);
 Exit:
 	EXCHANGE_UNLOCK();
 }
@@ -1808,6 +1922,19 @@ exchange_data_ack_msg_send(cf_node dest)
 	exchange_msg_send(ack_msg, dest, "error sending data ack message");
 }
 
+/**
+ * Send a data nack message, asking for full partition versions, to a
+ * destination node.
+ * @param dest the destination node.
+ */
+static void
+exchange_data_nack_msg_send(cf_node dest)
+{
+	msg* nack_msg = exchange_msg_get(AS_EXCHANGE_MSG_TYPE_DATA_NACK);
+	DEBUG("sending data nack message to node %"PRIx64, dest);
+	exchange_msg_send(nack_msg, dest, "error sending data nack message");
+}
+
 /*
  * ----------------------------------------------------------------------------
  * Data payload related
@@ -1818,14 +1945,9 @@ exchange_data_ack_msg_send(cf_node dest)
  * Add a pid to the namespace hash for the input vinfo.
  */
 static void
-exchange_namespace_hash_pid_add(cf_shash* ns_hash, as_partition_version* vinfo,
-		uint16_t pid)
+exchange_namespace_hash_pid_add(cf_shash* ns_hash,
+		const as_partition_version* vinfo, uint16_t pid)
 {
-	if (as_partition_version_is_null(vinfo)) {
-		// Ignore NULL vinfos.
-		return;
-	}
-
 	cf_vector* pid_vector;
 
 	// Append the hash.
@@ -1877,6 +1999,37 @@ exchange_namespace_hash_serialize_reduce(const void* key, void* data,
 	return CF_SHASH_OK;
 }
 
+/**
+ * Create a hash from each unique vinfo to a vector of partition ids having the
+ * vinfo.
+ */
+static cf_shash*
+exchange_namespace_hash_create()
+{
+	return cf_shash_create(exchange_vinfo_shash, sizeof(as_partition_version),
+			sizeof(cf_vector*), AS_EXCHANGE_UNIQUE_VINFO_MAX_SIZE_SOFT, false);
+}
+
+/**
+ * Serialize a namespace hash, in as_exchange_namespace_payload format, to the
+ * dynamic buffer and destroy the hash.
+ */
+static void
+exchange_namespace_hash_payload_add(cf_shash* ns_hash, cf_dyn_buf* dyn_buf)
+{
+	// Append the vinfo count.
+	uint32_t num_vinfos = cf_shash_get_size(ns_hash);
+	cf_dyn_buf_append_buf(dyn_buf, (uint8_t*)&num_vinfos, sizeof(num_vinfos));
+
+	// Append vinfos and partitions.
+	cf_shash_reduce(ns_hash, exchange_namespace_hash_serialize_reduce, dyn_buf);
+
+	// Destroy the intermediate hash and the pid vectors.
+	cf_shash_reduce(ns_hash, exchange_namespace_hash_destroy_reduce, NULL);
+
+	cf_shash_destroy(ns_hash);
+}
+
 /**
  * Append namespace payload, in as_exchange_namespace_payload format, for a
  * namespace to the dynamic buffer.
@@ -1887,35 +2040,146 @@ exchange_namespace_hash_serialize_reduce(const void* key, void* data,
 static void
 exchange_data_namespace_payload_add(as_namespace* ns, cf_dyn_buf* dyn_buf)
 {
-	// A hash from each unique non null vinfo to a vector of partition ids
-	// having the vinfo.
-	cf_shash* ns_hash = cf_shash_create(exchange_vinfo_shash,
-			sizeof(as_partition_version), sizeof(cf_vector*),
-			AS_EXCHANGE_UNIQUE_VINFO_MAX_SIZE_SOFT, false);
+	cf_shash* ns_hash = exchange_namespace_hash_create();
 
 	as_partition* partitions = ns->partitions;
 
-	// Populate the hash with one entry for each vinfo
+	// Populate the hash with one entry for each non null vinfo.
 	for (int i = 0; i < AS_PARTITIONS; i++) {
 		as_partition_version* current_vinfo = &partitions[i].version;
-		exchange_namespace_hash_pid_add(ns_hash, current_vinfo, i);
+
+		if (!as_partition_version_is_null(current_vinfo)) {
+			exchange_namespace_hash_pid_add(ns_hash, current_vinfo, i);
+		}
 	}
 
 	// We are ready to populate the dyn buffer with this ns's data.
 	DEBUG("namespace %s has %d unique vinfos", ns->name,
 			cf_shash_get_size(ns_hash));
 
-	// Append the vinfo count.
-	uint32_t num_vinfos = cf_shash_get_size(ns_hash);
-	cf_dyn_buf_append_buf(dyn_buf, (uint8_t*)&num_vinfos, sizeof(num_vinfos));
+	exchange_namespace_hash_payload_add(ns_hash, dyn_buf);
+}
 
-	// Append vinfos and partitions.
-	cf_shash_reduce(ns_hash, exchange_namespace_hash_serialize_reduce, dyn_buf);
+/**
+ * Append namespace payload, in as_exchange_namespace_payload format, holding
+ * only the partitions whose vinfos differ from the base vinfos. Unlike the full
+ * payload, partitions whose vinfos became null are included.
+ *
+ * @param ns the namespace.
+ * @param base the vinfos self node sent in the last committed round.
+ * @param dyn_buf the dynamic buffer.
+ */
+static void
+exchange_data_namespace_delta_payload_add(as_namespace* ns,
+		const as_partition_version* base, cf_dyn_buf* dyn_buf)
+{
+	cf_shash* ns_hash = exchange_namespace_hash_create();
 
-	// Destroy the intermediate hash and the pid vectors.
-	cf_shash_reduce(ns_hash, exchange_namespace_hash_destroy_reduce, NULL);
+	as_partition* partitions = ns->partitions;
+	uint32_t num_changed = 0;
 
-	cf_shash_destroy(ns_hash);
+	for (int i = 0; i < AS_PARTITIONS; i++) {
+		as_partition_version* current_vinfo = &partitions[i].version;
+
+		if (!as_partition_version_same(current_vinfo, &base[i])) {
+			exchange_namespace_hash_pid_add(ns_hash, current_vinfo, i);
+			num_changed++;
+		}
+	}
+
+	DEBUG("namespace %s has %u changed partitions", ns->name, num_changed);
+
+	exchange_namespace_hash_payload_add(ns_hash, dyn_buf);
+}
+
+/**
+ * Append payload, in as_exchange_namespace_payload format, for an array of
+ * AS_PARTITIONS vinfos to the dynamic buffer.
+ */
+static void
+exchange_versions_payload_add(const as_partition_version* versions,
+		cf_dyn_buf* dyn_buf)
+{
+	cf_shash* ns_hash = exchange_namespace_hash_create();
+
+	for (int i = 0; i < AS_PARTITIONS; i++) {
+		if (!as_partition_version_is_null(&versions[i])) {
+			exchange_namespace_hash_pid_add(ns_hash, &versions[i], i);
+		}
+	}
+
+	exchange_namespace_hash_payload_add(ns_hash, dyn_buf);
+}
+
+/**
+ * Find a node's index in a namespace's last committed succession.
+ * @return the index, or -1 if the node was not in the succession.
+ */
+static int
+exchange_namespace_succession_ix(as_namespace* ns, cf_node nodeid)
+{
+	for (uint32_t i = 0; i < ns->cluster_size; i++) {
+		if (ns->succession[i] == nodeid) {
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Rebuild a node's full partition versions for a namespace by applying
+ * received deltas to the versions the node sent in the last committed round.
+ *
+ * @param ns the local namespace.
+ * @param source the sending node.
+ * @param delta the validated delta payload.
+ * @param partition_versions (output) reallocated to the full payload.
+ * @return true on success, false if there are no base versions for the node.
+ */
+static bool
+exchange_namespace_delta_apply(as_namespace* ns, cf_node source,
+		const as_exchange_ns_vinfos_payload* delta,
+		as_exchange_ns_vinfos_payload** partition_versions)
+{
+	int sl_ix = exchange_namespace_succession_ix(ns, source);
+
+	if (sl_ix < 0) {
+		return false;
+	}
+
+	as_partition_version* versions = cf_malloc(sizeof(ns->cluster_versions[0]));
+
+	memcpy(versions, ns->cluster_versions[sl_ix],
+			sizeof(ns->cluster_versions[0]));
+
+	const uint8_t* read_ptr = (const uint8_t*)delta->vinfos;
+
+	for (uint32_t i = 0; i < delta->num_vinfos; i++) {
+		const as_exchange_vinfo_payload* vinfo_payload =
+				(const as_exchange_vinfo_payload*)read_ptr;
+
+		for (uint32_t j = 0; j < vinfo_payload->num_pids; j++) {
+			memcpy(&versions[vinfo_payload->pids[j]], &vinfo_payload->vinfo,
+					sizeof(vinfo_payload->vinfo));
+		}
+
+		read_ptr += sizeof(as_exchange_vinfo_payload)
+				+ vinfo_payload->num_pids * sizeof(uint16_t);
+	}
+
+	cf_dyn_buf dyn_buf;
+
+	cf_dyn_buf_init_heap(&dyn_buf, AS_EXCHANGE_SELF_DYN_BUF_SIZE());
+	exchange_versions_payload_add(versions, &dyn_buf);
+
+	*partition_versions = cf_realloc(*partition_versions, dyn_buf.used_sz);
+	memcpy(*partition_versions, dyn_buf.buf, dyn_buf.used_sz);
+
+	cf_dyn_buf_free(&dyn_buf);
+	cf_free(versions);
+
+	return true;
 }
 
 /**
@@ -1933,6 +2197,17 @@ exchange_data_payload_prepare()
 	// Ensure ns->smd_roster is synchronized exchanged partition versions.
 	pthread_mutex_lock(&g_exchanged_info_lock);
 
+	// Deltas are relative to what self sent in the last committed round, so
+	// the cluster versions must still be from that round.
+	bool use_deltas = g_exchange.versions_cluster_key != 0
+			&& g_exchange.versions_cluster_key
+					== g_exchange.committed_cluster_key
+			&& g_exchange.min_compatibility_id
+					>= AS_EXCHANGE_DELTA_MIN_COMPATIBILITY_ID;
+
+	size_t full_sz = 0;
+	size_t delta_sz = 0;
+
 	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
 		as_namespace* ns = g_config.namespaces[ns_ix];
 
@@ -1946,10 +2221,45 @@ exchange_data_payload_prepare()
 
 		exchange_data_namespace_payload_add(ns,
 				&g_exchange.self_data_dyn_buf[ns_ix]);
+
+		full_sz += g_exchange.self_data_dyn_buf[ns_ix].used_sz;
+
+		g_exchange.self_delta_dyn_buf[ns_ix].used_sz = 0;
+
+		if (! use_deltas) {
+			continue;
+		}
+
+		int self_ix = exchange_namespace_succession_ix(ns, g_config.self_node);
+
+		if (self_ix < 0) {
+			use_deltas = false;
+			continue;
+		}
+
+		exchange_data_namespace_delta_payload_add(ns,
+				ns->cluster_versions[self_ix],
+				&g_exchange.self_delta_dyn_buf[ns_ix]);
+
+		delta_sz += g_exchange.self_delta_dyn_buf[ns_ix].used_sz;
 	}
 
 	g_exchange.data_msg = exchange_msg_get(AS_EXCHANGE_MSG_TYPE_DATA);
-	exchange_msg_data_payload_set(g_exchange.data_msg);
+	exchange_msg_data_payload_set(g_exchange.data_msg,
+			g_exchange.self_data_dyn_buf, 0);
+
+	if (use_deltas) {
+		g_exchange.data_delta_msg = exchange_msg_get(AS_EXCHANGE_MSG_TYPE_DATA);
+		exchange_msg_data_payload_set(g_exchange.data_delta_msg,
+				g_exchange.self_delta_dyn_buf,
+				g_exchange.committed_cluster_key);
+
+		INFO("partition versions payload %zu bytes, delta from cluster key %"PRIx64" %zu bytes",
+				full_sz, g_exchange.committed_cluster_key, delta_sz);
+	}
+	else {
+		DEBUG("partition versions payload %zu bytes, no delta", full_sz);
+	}
 
 	pthread_mutex_unlock(&g_exchanged_info_lock);
 
@@ -2272,6 +2582,11 @@ exchange_reset_for_new_round(cf_vector* new_succession_list,
 		g_exchange.data_msg = NULL;
 	}
 
+	if (g_exchange.data_delta_msg) {
+		as_fabric_msg_put(g_exchange.data_delta_msg);
+		g_exchange.data_delta_msg = NULL;
+	}
+
 	EXCHANGE_UNLOCK();
 }
 
@@ -2283,6 +2598,7 @@ exchange_orphan_commit()
 {
 	EXCHANGE_LOCK();
 	exchange_commited_cluster_update(0, NULL);
+	g_exchange.versions_cluster_key = 0;
 	WARNING("blocking client transactions in orphan state!");
 	as_partition_balance_revert_to_orphan();
 	g_exchange.orphan_state_are_transactions_blocked = true;
@@ -2342,6 +2658,7 @@ exchange_cluster_change_handle(as_clustering_event* clustering_event)
 			clustering_event->cluster_key);
 
 	g_exchange.state = AS_EXCHANGE_STATE_EXCHANGING;
+	g_exchange.exchange_start_ts = cf_getms();
 
 	INFO("data exchange started with cluster key %"PRIx64,
 			g_exchange.cluster_key);
@@ -2666,6 +2983,9 @@ exchange_exchanging_pre_commit()
 	memset(g_exchange.compatibility_ids, 0,
 			sizeof(g_exchange.compatibility_ids));
 
+	// Cluster versions are about to be overwritten - no longer a delta base.
+	g_exchange.versions_cluster_key = 0;
+
 	uint32_t min_compatibility_id = UINT32_MAX;
 	uint32_t max_compatibility_id = 0;
 
@@ -2734,6 +3054,8 @@ exchange_exchanging_pre_commit()
 	g_exchange.min_compatibility_id = min_compatibility_id;
 	g_exchange.max_compatibility_id = max_compatibility_id;
 
+	g_exchange.versions_cluster_key = g_exchange.cluster_key;
+
 	for (int i = 0; i < g_config.n_namespaces; i++) {
 		as_namespace* ns = g_config.namespaces[i];
 
@@ -2954,6 +3276,23 @@ exchange_exchanging_data_msg_handle(as_exchange_event* msg_event)
 			goto Exit;
 		}
 
+		// Deltas need the same committed round on both ends - if not, ask the
+		// source for full partition versions.
+		as_cluster_key base_cluster_key = 0;
+
+		msg_get_uint64(msg_event->msg, AS_EXCHANGE_MSG_BASE_CLUSTER_KEY,
+				&base_cluster_key);
+
+		if (base_cluster_key != 0
+				&& (base_cluster_key != g_exchange.versions_cluster_key
+						|| base_cluster_key
+								!= g_exchange.committed_cluster_key)) {
+			INFO("can't apply exchange data deltas from node %"PRIx64" based on cluster key %"PRIx64" - requesting full data",
+					msg_event->msg_source, base_cluster_key);
+			exchange_data_nack_msg_send(msg_event->msg_source);
+			goto Exit;
+		}
+
 		node_state.data->num_namespaces = 0;
 
 		for (uint32_t i = 0; i < num_namespaces_sent; i++) {
@@ -2993,13 +3332,26 @@ exchange_exchanging_data_msg_handle(as_exchange_event* msg_event)
 				goto Exit;
 			}
 
-			namespace_data->partition_versions = cf_realloc(
-					namespace_data->partition_versions,
-					partition_versions_element->sz);
+			if (base_cluster_key != 0) {
+				if (!exchange_namespace_delta_apply(matching_namespace,
+						msg_event->msg_source,
+						(as_exchange_ns_vinfos_payload*)partition_versions_element->ptr,
+						&namespace_data->partition_versions)) {
+					INFO("no base partition versions for namespace %s from node %"PRIx64" - requesting full data",
+							matching_namespace->name, msg_event->msg_source);
+					exchange_data_nack_msg_send(msg_event->msg_source);
+					goto Exit;
+				}
+			}
+			else {
+				namespace_data->partition_versions = cf_realloc(
+						namespace_data->partition_versions,
+						partition_versions_element->sz);
 
-			memcpy(namespace_data->partition_versions,
-					partition_versions_element->ptr,
-					partition_versions_element->sz);
+				memcpy(namespace_data->partition_versions,
+						partition_versions_element->ptr,
+						partition_versions_element->sz);
+			}
 
 			// Copy rosters.
 			// TODO - make this piece a utility function?
@@ -3078,6 +3430,35 @@ Exit:
 	EXCHANGE_UNLOCK();
 }
 
+/**
+ * Handle incoming data nack message - the source could not apply self node's
+ * partition version deltas, so send it full partition versions.
+ *
+ * Assumes the message has been checked for sanity.
+ */
+static void
+exchange_exchanging_data_nack_msg_handle(as_exchange_event* msg_event)
+{
+	EXCHANGE_LOCK();
+
+	as_exchange_node_state node_state;
+	exchange_node_state_get_safe(msg_event->msg_source, &node_state);
+
+	if (!node_state.send_acked && !node_state.needs_full_data) {
+		INFO("node %"PRIx64" requested full exchange data",
+				msg_event->msg_source);
+
+		node_state.needs_full_data = true;
+		exchange_node_state_update(msg_event->msg_source, &node_state);
+
+		msg_incr_ref(g_exchange.data_msg);
+		exchange_msg_send(g_exchange.data_msg, msg_event->msg_source,
+				"error sending exchange data");
+	}
+
+	EXCHANGE_UNLOCK();
+}
+
 /**
  * Handle incoming data ack message.
  *
@@ -3133,6 +3514,9 @@ exchange_exchanging_msg_event_handle(as_exchange_event* msg_event)
 	case AS_EXCHANGE_MSG_TYPE_DATA_ACK:
 		exchange_exchanging_data_ack_msg_handle(msg_event);
 		break;
+	case AS_EXCHANGE_MSG_TYPE_DATA_NACK:
+		exchange_exchanging_data_nack_msg_handle(msg_event);
+		break;
 	default:
 		DEBUG(
 				"exchanging state received unexpected mesage of type %d from node %"PRIx64,
@@ -3269,11 +3653,22 @@ exchange_data_commit()
 	// for skew.
 	as_skew_monitor_update();
 
+	uint64_t balance_start_ms = cf_getms();
+
+	g_exchange.last_exchange_ms = balance_start_ms
+			- g_exchange.exchange_start_ts;
+
 	// Must cover partition balance since it may manipulate ns->cluster_size.
 	pthread_mutex_lock(&g_exchanged_info_lock);
 	as_partition_balance();
 	pthread_mutex_unlock(&g_exchanged_info_lock);
 
+	g_exchange.last_balance_ms = cf_getms() - balance_start_ms;
+
+	INFO("data exchange for cluster key %"PRIx64" took %"PRIu64" ms, partition balance took %"PRIu64" ms",
+			g_exchange.cluster_key, g_exchange.last_exchange_ms,
+			g_exchange.last_balance_ms);
+
 	EXCHANGE_UNLOCK();
 }
 
@@ -3555,6 +3950,8 @@ exchange_init()
 	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
 		cf_dyn_buf_init_heap(&g_exchange.self_data_dyn_buf[ns_ix],
 			AS_EXCHANGE_SELF_DYN_BUF_SIZE());
+		cf_dyn_buf_init_heap(&g_exchange.self_delta_dyn_buf[ns_ix],
+			AS_EXCHANGE_SELF_DYN_BUF_SIZE());
 	}
 
 	// Initialize external event publishing.
@@ -3785,6 +4182,19 @@ void as_exchange_cluster_info(cf_dyn_buf* db) {
 	EXCHANGE_COMMITTED_CLUSTER_UNLOCK();
 }
 
+/**
+ * Exchange and partition balance durations of the last cluster change.
+ */
+void
+as_exchange_info_phase_times(cf_dyn_buf* db)
+{
+	// No lock - the exchange lock is held through partition balance.
+	info_append_uint64(db, "cluster_change_exchange_ms",
+			g_exchange.last_exchange_ms);
+	info_append_uint64(db, "cluster_change_balance_ms",
+			g_exchange.last_balance_ms);
+}
+
 /**
  * Lock before setting or getting exchanged info from non-exchange thread.
  */
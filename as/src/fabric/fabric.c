@@ -80,6 +80,7 @@
 
 #include "base/cfg.h"
 #include "base/health.h"
+#include "base/probes.h"
 #include "base/stats.h"
 #include "fabric/endpoint.h"
 #include "fabric/hb.h"
@@ -90,13 +91,23 @@
 //
 
 #define FABRIC_SEND_MEM_SZ			(1024) // bytes
+#define FABRIC_SEND_BATCH_MAX		16 // msgs riding along with the head msg
+#define FABRIC_SEND_BATCH_MEM_SZ	(8 * 1024) // bytes
+#define FABRIC_SEND_BATCH_MAX_IOV	256
 #define FABRIC_BUFFER_MEM_SZ		(1024 * 1024) // bytes
 #define FABRIC_BUFFER_MAX_SZ		(128 * 1024 * 1024) // used simply for validation
 #define FABRIC_EPOLL_SEND_EVENTS	16
+#define FABRIC_BULK_DEFER_MS		1 // poll interval while bulk sends are deferred
 #define FABRIC_EPOLL_RECV_EVENTS	1
 
 #define FABRIC_MESSAGE_OVERLOAD_COUNT	16
 
+// Connection autoscaling - a send queue this deep adds a connection, and this
+// many idle periods in a row drop one.
+#define FABRIC_AUTOSCALE_PERIOD_US		(1000 * 1000)
+#define FABRIC_AUTOSCALE_UP_DEPTH		64
+#define FABRIC_AUTOSCALE_DOWN_PERIODS	30
+
 typedef enum {
 	// These values go on the wire, so mind backward compatibility if changing.
 	FS_FIELD_NODE,
@@ -157,6 +168,8 @@ typedef struct fabric_node_s {
 	cf_node 	node_id; // remote node
 	bool		live; // set to false on shutdown
 	uint32_t	connect_count[AS_FABRIC_N_CHANNELS];
+	uint32_t	connect_target[AS_FABRIC_N_CHANNELS];
+	uint32_t	idle_periods[AS_FABRIC_N_CHANNELS];
 	bool		connect_full;
 
 	cf_mutex	connect_lock;
@@ -195,6 +208,14 @@ typedef struct fabric_connection_s {
 	msg				*s_msg_in_progress;
 	size_t			s_count;
 
+	// Msgs already popped from the node's send queue, to follow (or ride along
+	// in the same sendmsg() as) s_msg_in_progress.
+	msg				*s_pending[FABRIC_SEND_BATCH_MAX];
+	uint32_t		s_n_pending;
+	uint32_t		s_n_riders;
+	uint8_t			s_batch_buf[FABRIC_SEND_BATCH_MEM_SZ];
+	struct iovec	s_batch_iov[FABRIC_SEND_BATCH_MAX_IOV];
+
 	uint8_t			*r_bigbuf;
 	uint8_t			r_buf[FABRIC_BUFFER_MEM_SZ + sizeof(msg_hdr)];
 	msg_type		r_type;
@@ -209,6 +230,9 @@ typedef struct fabric_connection_s {
 	send_entry *send_ptr;
 	fabric_recv_thread_pool *pool;
 
+	// Bulk connections held back by their send thread's rate limit.
+	struct fabric_connection_s *s_deferred_next;
+
 	uint64_t s_bytes;
 	uint64_t s_bytes_last;
 	uint64_t r_bytes;
@@ -256,9 +280,16 @@ static bool g_published_endpoint_list_ipv4_only;
 // Max connections formed via connect. Others are formed via accept.
 static uint32_t g_fabric_connect_limit[AS_FABRIC_N_CHANNELS];
 
+// Autoscaling ceiling for connections formed via connect - same as the limit
+// if the channel doesn't scale.
+static uint32_t g_fabric_connect_max[AS_FABRIC_N_CHANNELS];
+
 // Receive thread connects per channel.
 static cf_atomic32 g_n_channel_connects[AS_FABRIC_N_CHANNELS];
 
+// Bytes this send thread has sent - fc may be gone once handed back.
+static __thread uint64_t g_tl_send_bytes = 0;
+
 
 //==========================================================
 // Forward declarations.
@@ -295,6 +326,8 @@ inline static void fabric_node_release(fabric_node *node);
 static bool fabric_node_add_connection(fabric_node *node, fabric_connection *fc);
 static uint8_t fabric_node_find_min_send_count(const fabric_node *node);
 static bool fabric_node_is_connect_full(const fabric_node *node);
+static void fabric_node_autoscale(fabric_node *node, uint32_t ch);
+static void fabric_node_drop_connection(fabric_node *node, uint32_t ch);
 
 static int fabric_get_node_list_fn(const void *key, void *data, void *udata);
 static uint32_t fabric_get_node_list(node_list *nl);
@@ -317,8 +350,11 @@ inline static void fabric_connection_recv_rearm(fabric_connection *fc);
 inline static void fabric_connection_send_rearm(fabric_connection *fc);
 static void fabric_connection_disconnect(fabric_connection *fc);
 static void fabric_connection_set_keepalive_options(fabric_connection *fc);
+static void fabric_connection_set_busy_poll(fabric_connection *fc, uint32_t ch);
 
 static void fabric_connection_reroute_msg(fabric_connection *fc);
+static void fabric_connection_add_riders(fabric_connection *fc);
+static void fabric_connection_put_riders(fabric_connection *fc);
 static bool fabric_connection_send_progress(fabric_connection *fc);
 static bool fabric_connection_process_writable(fabric_connection *fc);
 
@@ -340,7 +376,9 @@ static bool fabric_connect_endpoint_filter(const as_endpoint *endpoint, void *ud
 // Thread functions.
 static void *run_fabric_recv(void *arg);
 static void *run_fabric_send(void *arg);
+static void fabric_send_event(fabric_connection *fc, uint32_t events);
 static void *run_fabric_accept(void *arg);
+static void *run_fabric_autoscale(void *arg);
 
 // Ticker helpers.
 static int fabric_rate_node_reduce_fn(const void *key, void *data, void *udata);
@@ -365,6 +403,17 @@ as_fabric_init()
 {
 	for (uint32_t i = 0; i < AS_FABRIC_N_CHANNELS; i++) {
 		g_fabric_connect_limit[i] = g_config.n_fabric_channel_fds[i];
+		g_fabric_connect_max[i] = g_config.n_fabric_channel_fds[i];
+
+		if (g_config.n_fabric_channel_fds_max[i] > g_fabric_connect_max[i]) {
+			g_fabric_connect_max[i] = g_config.n_fabric_channel_fds_max[i];
+		}
+		else if (g_config.n_fabric_channel_fds_max[i] != 0 &&
+				g_config.n_fabric_channel_fds_max[i] < g_fabric_connect_max[i]) {
+			cf_warning(AS_FABRIC, "channel-%s-fds-max %u less than channel-%s-fds %u - not autoscaling",
+					CHANNEL_NAMES[i], g_config.n_fabric_channel_fds_max[i],
+					CHANNEL_NAMES[i], g_fabric_connect_limit[i]);
+		}
 
 		uint32_t n_recv_pools = g_config.n_fabric_channel_recv_pools[i];
 		uint32_t n_recv_threads_per_pool =
@@ -443,6 +492,14 @@ as_fabric_start()
 	cf_info(AS_FABRIC, "starting fabric accept thread");
 
 	cf_thread_create_detached(run_fabric_accept, NULL);
+
+	for (uint32_t i = 0; i < AS_FABRIC_N_CHANNELS; i++) {
+		if (g_fabric_connect_max[i] > g_fabric_connect_limit[i]) {
+			cf_info(AS_FABRIC, "starting fabric autoscale thread");
+			cf_thread_create_detached(run_fabric_autoscale, NULL);
+			break;
+		}
+	}
 }
 
 void
@@ -464,6 +521,8 @@ as_fabric_send(cf_node node_id, msg *m, as_fabric_channel channel)
 {
 	m->benchmark_time = g_config.fabric_benchmarks_enabled ? cf_getns() : 0;
 
+	ASD_PROBE3(fabric__send, node_id, m->type, channel);
+
 	if (g_config.self_node == node_id) {
 		cf_assert(g_fabric.msg_cb[m->type], AS_FABRIC, "m->type %d not registered", m->type);
 		(g_fabric.msg_cb[m->type])(node_id, m, g_fabric.msg_udata[m->type]);
@@ -874,11 +933,13 @@ fabric_node_create(cf_node node_id)
 		cf_mutex_init(&node->send_queue_lock[i]);
 
 		cf_pool_ptr_init(&node->send_idle_fc_pool[i],
-				g_fabric_connect_limit[i] * 2);
+				g_fabric_connect_limit[i] + g_fabric_connect_max[i]);
 		cf_queue_init(&node->send_queue[i], sizeof(msg *), CF_QUEUE_ALLOCSZ,
 				false);
 		cf_queue_init(&node->incoming_overflow[i], sizeof(fabric_connection *),
 				CF_QUEUE_ALLOCSZ, false);
+
+		node->connect_target[i] = g_fabric_connect_limit[i];
 	}
 
 	cf_mutex_init(&node->connect_lock);
@@ -1012,7 +1073,7 @@ fabric_node_connect(fabric_node *node, uint32_t ch)
 
 	uint32_t fds = node->connect_count[ch] + 1;
 
-	if (fds > g_fabric_connect_limit[ch]) {
+	if (fds > node->connect_target[ch]) {
 		cf_mutex_unlock(&node->connect_lock);
 		return NULL;
 	}
@@ -1170,7 +1231,11 @@ fabric_node_connect_all(fabric_node *node)
 static void
 fabric_node_connect_all_channel(fabric_node *node, uint32_t ch)
 {
-	uint32_t n = g_fabric_connect_limit[ch] - node->connect_count[ch];
+	uint32_t target = node->connect_target[ch];
+	uint32_t count = node->connect_count[ch];
+
+	// Count can exceed target briefly after a scale down.
+	uint32_t n = count < target ? target - count : 0;
 
 	for (uint32_t i = 0; i < n; i++) {
 		fabric_connection *fc = fabric_node_connect(node, ch);
@@ -1179,6 +1244,8 @@ fabric_node_connect_all_channel(fabric_node *node, uint32_t ch)
 			break;
 		}
 
+		fabric_connection_set_busy_poll(fc, ch);
+
 		// TLS connections are one-way. Outgoing connections are for
 		// outgoing data.
 		if (fc->sock.state == CF_SOCKET_STATE_NON_TLS) {
@@ -1294,7 +1361,7 @@ static bool
 fabric_node_is_connect_full(const fabric_node *node)
 {
 	for (int ch = 0; ch < AS_FABRIC_N_CHANNELS; ch++) {
-		if (node->connect_count[ch] < g_fabric_connect_limit[ch]) {
+		if (node->connect_count[ch] < node->connect_target[ch]) {
 			return false;
 		}
 	}
@@ -1302,6 +1369,106 @@ fabric_node_is_connect_full(const fabric_node *node)
 	return true;
 }
 
+// Grow a channel's connections while its send queue backs up, and shrink it
+// back toward the configured count while connections sit idle.
+static void
+fabric_node_autoscale(fabric_node *node, uint32_t ch)
+{
+	uint32_t depth = cf_queue_sz(&node->send_queue[ch]);
+
+	if (depth >= FABRIC_AUTOSCALE_UP_DEPTH) {
+		node->idle_periods[ch] = 0;
+
+		cf_mutex_lock(&node->connect_lock);
+
+		bool grow = node->connect_target[ch] < g_fabric_connect_max[ch];
+
+		if (grow) {
+			node->connect_target[ch]++;
+			node->connect_full = false;
+		}
+
+		cf_mutex_unlock(&node->connect_lock);
+
+		if (grow) {
+			cf_info(AS_FABRIC, "node %lx %s channel: queue %u - scaling up to %u fds",
+					node->node_id, CHANNEL_NAMES[ch], depth,
+					node->connect_target[ch]);
+			fabric_node_connect_all_channel(node, ch);
+		}
+
+		return;
+	}
+
+	// More than one idle connection means the channel has more than it needs.
+	if (depth != 0 ||
+			node->connect_target[ch] <= g_fabric_connect_limit[ch] ||
+			cf_pool_ptr_count(&node->send_idle_fc_pool[ch]) < 2) {
+		node->idle_periods[ch] = 0;
+		return;
+	}
+
+	if (++node->idle_periods[ch] < FABRIC_AUTOSCALE_DOWN_PERIODS) {
+		return;
+	}
+
+	node->idle_periods[ch] = 0;
+
+	cf_mutex_lock(&node->connect_lock);
+	node->connect_target[ch]--;
+	cf_mutex_unlock(&node->connect_lock);
+
+	cf_info(AS_FABRIC, "node %lx %s channel: idle - scaling down to %u fds",
+			node->node_id, CHANNEL_NAMES[ch], node->connect_target[ch]);
+
+	fabric_node_drop_connection(node, ch);
+}
+
+// Close one idle connection that we formed via connect. Popping it from the
+// idle pool means no send can pick it up meanwhile.
+static void
+fabric_node_drop_connection(fabric_node *node, uint32_t ch)
+{
+	cf_pool_ptr *pool = &node->send_idle_fc_pool[ch];
+	fabric_connection *drop_fc = NULL;
+
+	cf_mutex_lock(&node->send_queue_lock[ch]);
+
+	uint32_t n_idle = cf_pool_ptr_count(pool);
+	fabric_connection *keep[n_idle];
+	uint32_t n_keep = 0;
+
+	for (uint32_t i = 0; i < n_idle; i++) {
+		fabric_connection *fc = fc_pool_pop(pool);
+
+		if (fc == NULL) {
+			break;
+		}
+
+		if (fc->started_via_connect && ! fc->failed) {
+			drop_fc = fc;
+			break;
+		}
+
+		keep[n_keep++] = fc;
+	}
+
+	// Put the others back before a sender can find the pool empty.
+	for (uint32_t i = 0; i < n_keep; i++) {
+		fc_pool_push(pool, keep[i]);
+	}
+
+	cf_mutex_unlock(&node->send_queue_lock[ch]);
+
+	if (drop_fc == NULL) {
+		return;
+	}
+
+	fabric_connection_disconnect(drop_fc);
+	fabric_connection_send_unassign(drop_fc);
+	fabric_connection_release(drop_fc); // send_idle_fc_queue
+}
+
 
 static int
 fabric_get_node_list_fn(const void *key, void *data, void *udata)
@@ -1646,6 +1813,17 @@ fabric_connection_set_keepalive_options(fabric_connection *fc)
 	}
 }
 
+// Replica writes and their acks are latency-bound - spin on the NIC queue
+// briefly rather than sleep until the interrupt.
+static void
+fabric_connection_set_busy_poll(fabric_connection *fc, uint32_t ch)
+{
+	if (ch == AS_FABRIC_CHANNEL_RW && g_config.fabric_rw_busy_poll_us != 0) {
+		cf_socket_set_busy_poll(&fc->sock,
+				(int32_t)g_config.fabric_rw_busy_poll_us);
+	}
+}
+
 static void
 fabric_connection_reroute_msg(fabric_connection *fc)
 {
@@ -1661,6 +1839,16 @@ fabric_connection_reroute_msg(fabric_connection *fc)
 	}
 
 	fc->s_msg_in_progress = NULL;
+
+	for (uint32_t i = 0; i < fc->s_n_pending; i++) {
+		if (fabric_node_send(fc->node, fc->s_pending[i],
+				fc->pool->pool_id) != AS_FABRIC_SUCCESS) {
+			as_fabric_msg_put(fc->s_pending[i]);
+		}
+	}
+
+	fc->s_n_pending = 0;
+	fc->s_n_riders = 0;
 }
 
 static void
@@ -1681,6 +1869,64 @@ fabric_connection_incr_iov(fabric_connection *fc, uint32_t sz)
 	}
 }
 
+// Serialize pending msgs into the same iovec array as the new head msg, as
+// many as fit.
+static void
+fabric_connection_add_riders(fabric_connection *fc)
+{
+	size_t n_iov = fc->s_iov_count;
+
+	if (n_iov > FABRIC_SEND_BATCH_MAX_IOV) {
+		return;
+	}
+
+	memcpy(fc->s_batch_iov, fc->s_iov, n_iov * sizeof(struct iovec));
+
+	uint8_t *buf = fc->s_batch_buf;
+	const uint8_t *end = buf + sizeof(fc->s_batch_buf);
+	uint32_t n_riders = 0;
+
+	while (n_riders < fc->s_n_pending) {
+		msg *m = fc->s_pending[n_riders];
+		size_t max_iov;
+		size_t buf_sz = msg_get_iov_buf_sz(m, &max_iov);
+
+		if (buf_sz > (size_t)(end - buf) ||
+				n_iov + max_iov > FABRIC_SEND_BATCH_MAX_IOV) {
+			break;
+		}
+
+		uint32_t msg_sz;
+		size_t m_iov = msg_to_iov_buf(m, buf, buf_sz, &msg_sz);
+
+		memcpy(fc->s_batch_iov + n_iov, buf, m_iov * sizeof(struct iovec));
+		n_iov += m_iov;
+		buf += buf_sz;
+		fc->s_msg_sz += msg_sz;
+		n_riders++;
+	}
+
+	if (n_riders != 0) {
+		fc->s_iov = fc->s_batch_iov;
+		fc->s_iov_count = n_iov;
+		fc->s_n_riders = n_riders;
+	}
+}
+
+static void
+fabric_connection_put_riders(fabric_connection *fc)
+{
+	for (uint32_t i = 0; i < fc->s_n_riders; i++) {
+		as_fabric_msg_put(fc->s_pending[i]);
+	}
+
+	fc->s_count += fc->s_n_riders;
+	fc->s_n_pending -= fc->s_n_riders;
+	memmove(fc->s_pending, fc->s_pending + fc->s_n_riders,
+			fc->s_n_pending * sizeof(msg *));
+	fc->s_n_riders = 0;
+}
+
 static bool
 fabric_connection_send_progress(fabric_connection *fc)
 {
@@ -1692,6 +1938,10 @@ fabric_connection_send_progress(fabric_connection *fc)
 				&fc->s_msg_sz);
 		fc->s_sz = 0;
 
+		if (fc->s_n_pending != 0) {
+			fabric_connection_add_riders(fc);
+		}
+
 		if (m->benchmark_time != 0) {
 			m->benchmark_time = histogram_insert_data_point(
 					g_stats.fabric_send_init_hists[fc->pool->pool_id],
@@ -1722,12 +1972,17 @@ fabric_connection_send_progress(fabric_connection *fc)
 
 	fc->s_sz += send_sz;
 	fc->s_bytes += send_sz;
+	g_tl_send_bytes += (uint64_t)send_sz;
 
 	if (fc->s_sz == fc->s_msg_sz) { // complete send
 		as_fabric_msg_put(fc->s_msg_in_progress);
 		fc->s_msg_in_progress = NULL;
 		fc->s_msg_sz = 0;
 		fc->s_count++;
+
+		if (fc->s_n_riders != 0) {
+			fabric_connection_put_riders(fc);
+		}
 	}
 	else { // partial send
 		fabric_connection_incr_iov(fc, (uint32_t)send_sz);
@@ -1762,6 +2017,14 @@ fabric_connection_process_writable(fabric_connection *fc)
 			}
 		}
 
+		if (fc->s_n_pending != 0) {
+			fc->s_msg_in_progress = fc->s_pending[0];
+			fc->s_n_pending--;
+			memmove(fc->s_pending, fc->s_pending + 1,
+					fc->s_n_pending * sizeof(msg *));
+			continue;
+		}
+
 		cf_mutex_lock(&node->send_queue_lock[pool]);
 
 		if (! fc->node->live || fc->failed) {
@@ -1785,6 +2048,14 @@ fabric_connection_process_writable(fabric_connection *fc)
 			}
 		}
 
+		// Take what else is queued, so it can go out in the same sendmsg().
+		while (fc->s_n_pending < FABRIC_SEND_BATCH_MAX &&
+				cf_queue_pop(&node->send_queue[pool],
+						&fc->s_pending[fc->s_n_pending],
+						CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			fc->s_n_pending++;
+		}
+
 		cf_mutex_unlock(&node->send_queue_lock[pool]);
 	}
 
@@ -1832,6 +2103,8 @@ fabric_connection_process_fabric_msg(fabric_connection *fc, const msg *m)
 	// fc->pool needs to be set before placing into send_idle_fc_queue.
 	fabric_recv_thread_pool_add_fc(&g_fabric.recv_pool[ch][ix], fc);
 
+	fabric_connection_set_busy_poll(fc, ch);
+
 	// TLS connections are one-way. Incoming connections are for
 	// incoming data.
 	if (fc->sock.state == CF_SOCKET_STATE_NON_TLS) {
@@ -2014,6 +2287,8 @@ fabric_connection_process_msg(fabric_connection *fc, bool do_rearm)
 			msg *m = as_fabric_msg_get(type);
 
 			if (msg_parse_fields(m, buf_ptr, msg_sz)) {
+				ASD_PROBE3(fabric__recv, node, type, msg_sz);
+
 				(g_fabric.msg_cb[m->type])(node, m,
 						g_fabric.msg_udata[m->type]);
 
@@ -2270,6 +2545,8 @@ run_fabric_recv(void *arg)
 
 	cf_detail(AS_FABRIC, "run_fabric_recv() created index %lu", worker_id);
 
+	cf_alloc_set_thread_sys(CF_ALLOC_SYS_FABRIC);
+
 	while (true) {
 		cf_thread_test_cancel();
 
@@ -2323,62 +2600,131 @@ run_fabric_send(void *arg)
 
 	cf_detail(AS_FABRIC, "run_fabric_send() fd %d id %u", poll.fd, se->id);
 
+	cf_alloc_set_thread_sys(CF_ALLOC_SYS_FABRIC);
+
+	// Bulk channel rate limit - this thread's share, as a byte budget refilled
+	// over time. Other channels are never limited.
+	int64_t bulk_budget = 0;
+	uint64_t refill_ns = cf_getns();
+	fabric_connection *deferred = NULL;
+
 	while (true) {
 		cf_poll_event events[FABRIC_EPOLL_SEND_EVENTS];
-		int32_t n = cf_poll_wait(poll, events, FABRIC_EPOLL_SEND_EVENTS, -1);
+		int32_t n = cf_poll_wait(poll, events, FABRIC_EPOLL_SEND_EVENTS,
+				deferred != NULL ? FABRIC_BULK_DEFER_MS : -1);
+
+		uint64_t max_mb = as_load_uint32(&g_config.fabric_bulk_send_max_mb);
+		uint64_t now_ns = cf_getns();
+
+		if (max_mb != 0) {
+			uint64_t rate = (max_mb * 1024 * 1024) /
+					g_config.n_fabric_send_threads; // bytes per second
+			int64_t max_budget = (int64_t)(rate / 10); // allow 100ms burst
+
+			bulk_budget += (int64_t)((now_ns - refill_ns) * rate / 1000000000);
+
+			if (bulk_budget > max_budget) {
+				bulk_budget = max_budget;
+			}
+		}
+
+		refill_ns = now_ns;
 
+		// Serve the latency-sensitive channels first. Bulk connections wait
+		// for the next pass, and for budget.
 		for (int32_t i = 0; i < n; i++) {
 			fabric_connection *fc = events[i].data;
 
-			if (fc->node && ! fc->node->live) {
-				fabric_connection_disconnect(fc);
-				fabric_connection_send_unassign(fc);
-				fabric_connection_release(fc);
-				continue;
+			if (fc->s_channel != AS_FABRIC_CHANNEL_BULK ||
+					events[i].events != EPOLLOUT) {
+				fabric_send_event(fc, events[i].events);
 			}
+		}
 
-			// Handle remote close, socket errors. Also triggered by call to
-			// cf_socket_shutdown(fb->sock), but only first call. Not triggered
-			// by cf_socket_close(fb->sock), which automatically EPOLL_CTL_DEL.
-			if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
-				cf_detail(AS_FABRIC, "epoll : error, will close: fc %p fd %d errno %d signal {err:%d, hup:%d, rdhup:%d}",
-						fc, CSFD(&fc->sock), errno,
-						((events[i].events & EPOLLERR) ? 1 : 0),
-						((events[i].events & EPOLLHUP) ? 1 : 0),
-						((events[i].events & EPOLLRDHUP) ? 1 : 0));
-				fabric_connection_disconnect(fc);
-				fabric_connection_send_unassign(fc);
-				fabric_connection_reroute_msg(fc);
-				fabric_connection_release(fc);
-				continue;
-			}
+		for (int32_t i = 0; i < n; i++) {
+			fabric_connection *fc = events[i].data;
 
-			if (tls_socket_needs_handshake(&fc->sock)) {
-				if (! fabric_connection_connect_tls(fc)) {
-					fabric_connection_disconnect(fc);
-					fabric_connection_send_unassign(fc);
-					fabric_connection_reroute_msg(fc);
-					fabric_connection_release(fc);
+			if (fc->s_channel == AS_FABRIC_CHANNEL_BULK &&
+					events[i].events == EPOLLOUT) {
+				// Append, to keep deferred connections in order.
+				fabric_connection **tail = &deferred;
+
+				while (*tail != NULL) {
+					tail = &(*tail)->s_deferred_next;
 				}
 
-				continue;
+				fc->s_deferred_next = NULL;
+				*tail = fc;
 			}
+		}
 
-			cf_assert(events[i].events == EPOLLOUT, AS_FABRIC, "epoll not setup correctly for %p", fc);
+		while (deferred != NULL && (max_mb == 0 || bulk_budget > 0)) {
+			fabric_connection *fc = deferred;
 
-			if (! fabric_connection_process_writable(fc)) {
-				fabric_connection_disconnect(fc);
-				fabric_connection_send_unassign(fc);
-				fabric_connection_reroute_msg(fc);
-				fabric_connection_release(fc);
-				continue;
-			}
+			deferred = fc->s_deferred_next;
+			fc->s_deferred_next = NULL;
+
+			uint64_t send_bytes = g_tl_send_bytes;
+
+			fabric_send_event(fc, EPOLLOUT);
+			bulk_budget -= (int64_t)(g_tl_send_bytes - send_bytes);
+		}
+
+		if (max_mb == 0) {
+			bulk_budget = 0;
 		}
 	}
 
 	return 0;
 }
 
+static void
+fabric_send_event(fabric_connection *fc, uint32_t events)
+{
+	if (fc->node && ! fc->node->live) {
+		fabric_connection_disconnect(fc);
+		fabric_connection_send_unassign(fc);
+		fabric_connection_release(fc);
+		return;
+	}
+
+	// Handle remote close, socket errors. Also triggered by call to
+	// cf_socket_shutdown(fb->sock), but only first call. Not triggered
+	// by cf_socket_close(fb->sock), which automatically EPOLL_CTL_DEL.
+	if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+		cf_detail(AS_FABRIC, "epoll : error, will close: fc %p fd %d errno %d signal {err:%d, hup:%d, rdhup:%d}",
+				fc, CSFD(&fc->sock), errno,
+				((events & EPOLLERR) ? 1 : 0),
+				((events & EPOLLHUP) ? 1 : 0),
+				((events & EPOLLRDHUP) ? 1 : 0));
+		fabric_connection_disconnect(fc);
+		fabric_connection_send_unassign(fc);
+		fabric_connection_reroute_msg(fc);
+		fabric_connection_release(fc);
+		return;
+	}
+
+	if (tls_socket_needs_handshake(&fc->sock)) {
+		if (! fabric_connection_connect_tls(fc)) {
+			fabric_connection_disconnect(fc);
+			fabric_connection_send_unassign(fc);
+			fabric_connection_reroute_msg(fc);
+			fabric_connection_release(fc);
+		}
+
+		return;
+	}
+
+	cf_assert(events == EPOLLOUT, AS_FABRIC, "epoll not setup correctly for %p", fc);
+
+	if (! fabric_connection_process_writable(fc)) {
+		fabric_connection_disconnect(fc);
+		fabric_connection_send_unassign(fc);
+		fabric_connection_reroute_msg(fc);
+		fabric_connection_release(fc);
+	}
+}
+
 static void *
 run_fabric_accept(void *arg)
 {
@@ -2455,6 +2801,41 @@ run_fabric_accept(void *arg)
 	return 0;
 }
 
+static void *
+run_fabric_autoscale(void *arg)
+{
+	(void)arg;
+
+	while (true) {
+		usleep(FABRIC_AUTOSCALE_PERIOD_US);
+
+		node_list nl;
+
+		fabric_get_node_list(&nl);
+
+		// Index 0 is self.
+		for (uint32_t i = 1; i < nl.count; i++) {
+			fabric_node *node = fabric_node_get(nl.nodes[i]);
+
+			if (! node) {
+				continue;
+			}
+
+			if (node->live) {
+				for (uint32_t ch = 0; ch < AS_FABRIC_N_CHANNELS; ch++) {
+					if (g_fabric_connect_max[ch] > g_fabric_connect_limit[ch]) {
+						fabric_node_autoscale(node, ch);
+					}
+				}
+			}
+
+			fabric_node_release(node); // from fabric_node_get
+		}
+	}
+
+	return NULL;
+}
+
 static int
 fabric_rate_node_reduce_fn(const void *key, void *data, void *udata)
 {
@@ -337,6 +337,12 @@
  */
 #define HB_PLUGIN_DATA_BLOCK_SIZE 128
 
+/**
+ * Pulses that may carry only adjacency deltas before the full adjacency list
+ * is sent again. Keeps nodes that don't understand deltas from going stale.
+ */
+#define HB_ADJ_FULL_INTERVAL 16
+
 /**
  * Message scratch size for v3 HB messages. To accommodate 64 node cluster.
  */
@@ -1204,6 +1210,12 @@ typedef struct as_hb_adjacent_node_s
 	 * inserted at the LSB.
 	 */
 	uint64_t endpoint_change_tracker;
+
+	/**
+	 * Indicates the node's last pulse carried an adjacency digest, i.e. the
+	 * node can be sent adjacency deltas.
+	 */
+	bool adj_deltas_ok;
 } as_hb_adjacent_node;
 
 /**
@@ -1291,6 +1303,37 @@ typedef struct as_hb_s
 	 * Thread id for the thread expiring nodes from the adjacency list.
 	 */
 	pthread_t adjacency_tender_tid;
+
+	/**
+	 * Adjacency list sent in the last pulse, sorted. Base for the next pulse's
+	 * adjacency delta.
+	 */
+	cf_node adj_sent[AS_CLUSTER_SZ];
+
+	/**
+	 * Length of the adjacency list sent in the last pulse.
+	 */
+	size_t adj_sent_count;
+
+	/**
+	 * Pulses sent since the full adjacency list was last sent.
+	 */
+	uint32_t adj_pulses_since_full;
+
+	/**
+	 * Indicates the next pulse should carry the full adjacency list.
+	 */
+	bool adj_full_needed;
+
+	/**
+	 * Nodes to ask for their full adjacency lists in the next pulse.
+	 */
+	cf_node adj_full_requests[AS_CLUSTER_SZ];
+
+	/**
+	 * Number of nodes to ask for their full adjacency lists.
+	 */
+	size_t adj_n_full_requests;
 } as_hb;
 
 /**
@@ -1585,7 +1628,15 @@ static msg_template g_hb_msg_template[] = {
 
 { AS_HB_MSG_PAXOS_DATA, M_FT_BUF },
 
-{ AS_HB_MSG_SKEW_MONITOR_DATA, M_FT_UINT64 } };
+{ AS_HB_MSG_SKEW_MONITOR_DATA, M_FT_UINT64 },
+
+{ AS_HB_MSG_ADJ_DIGEST, M_FT_UINT64 },
+
+{ AS_HB_MSG_ADJ_ADDED, M_FT_BUF },
+
+{ AS_HB_MSG_ADJ_REMOVED, M_FT_BUF },
+
+{ AS_HB_MSG_ADJ_FULL_REQUEST, M_FT_BUF } };
 
 /*
  * ----------------------------------------------------------------------------
@@ -1760,6 +1811,12 @@ static void hb_clear();
 static int hb_adjacency_iterate_reduce(const void* key, void* data, void* udata);
 static void hb_plugin_set_fn(msg* msg);
 static void hb_plugin_parse_data_fn(msg* msg, cf_node source, as_hb_plugin_node_data* prev_plugin_data, as_hb_plugin_node_data* plugin_data);
+static uint64_t hb_adjacency_digest(const cf_node* adj_list, size_t adj_length);
+static int hb_adjacency_deltas_ok_reduce(const void* key, void* data, void* udata);
+static void hb_adjacency_msg_fill(msg* msg, cf_node* adj_list, size_t adj_length);
+static size_t hb_adjacency_delta_apply(msg* msg, const cf_node* prev_list, size_t prev_length, cf_node* dest_list);
+static void hb_adjacency_full_request(cf_node source);
+static void hb_plugin_data_reserve(as_hb_plugin_node_data* plugin_data, size_t data_size);
 static msg* hb_msg_get();
 static void hb_msg_return(msg* msg);
 static void hb_plugin_msg_fill(msg* msg);
@@ -6526,10 +6583,19 @@ mesh_channel_on_pulse(msg* msg)
 	// Channel has validated the source. Don't bother checking here.
 	msg_nodeid_get(msg, &source);
 	if (msg_adjacency_get(msg, &adj_list, &adj_length) != 0) {
-		// Adjacency list absent.
-		WARNING("received message from %" PRIx64" without adjacency list",
-				source);
-		return;
+		if (msg_is_set(msg, AS_HB_MSG_ADJ_DIGEST)) {
+			// Adjacency delta - only added nodes can be new to us.
+			if (msg_node_list_get(msg, AS_HB_MSG_ADJ_ADDED, &adj_list,
+					&adj_length) != 0) {
+				return;
+			}
+		}
+		else {
+			// Adjacency list absent.
+			WARNING("received message from %" PRIx64" without adjacency list",
+					source);
+			return;
+		}
 	}
 
 	cf_node to_discover[adj_length];
@@ -7529,6 +7595,12 @@ hb_clear()
 	hb_adjacent_node_destroy(&g_hb.self_node);
 	memset(&g_hb.self_node, 0, sizeof(g_hb.self_node));
 
+	// Peers need a full adjacency list after a restart.
+	g_hb.adj_sent_count = 0;
+	g_hb.adj_pulses_since_full = 0;
+	g_hb.adj_full_needed = true;
+	g_hb.adj_n_full_requests = 0;
+
 	HB_UNLOCK();
 
 	// Publish node departed events for the removed nodes.
@@ -7576,10 +7648,10 @@ hb_plugin_set_fn(msg* msg)
 	cf_shash_reduce(g_hb.adjacency, hb_adjacency_iterate_reduce,
 			&adjacency_reduce_udata);
 
-	HB_UNLOCK();
+	// Populate adjacency list, or delta since the previous pulse.
+	hb_adjacency_msg_fill(msg, adj_list, adjacency_reduce_udata.adj_count);
 
-	// Populate adjacency list.
-	msg_adjacency_set(msg, adj_list, adjacency_reduce_udata.adj_count);
+	HB_UNLOCK();
 
 	// Set cluster name.
 	char cluster_name[AS_CLUSTER_NAME_SZ];
@@ -7598,10 +7670,55 @@ hb_plugin_parse_data_fn(msg* msg, cf_node source,
 		as_hb_plugin_node_data* prev_plugin_data,
 		as_hb_plugin_node_data* plugin_data)
 {
+	cf_node* full_list;
+	size_t full_length;
+
+	// Check if the source wants our full adjacency list.
+	if (msg_node_list_get(msg, AS_HB_MSG_ADJ_FULL_REQUEST, &full_list,
+			&full_length) == 0) {
+		cf_node self_nodeid = config_self_nodeid_get();
+
+		for (size_t i = 0; i < full_length; i++) {
+			if (full_list[i] == self_nodeid) {
+				g_hb.adj_full_needed = true;
+				break;
+			}
+		}
+	}
+
 	size_t adj_length = 0;
 	cf_node* adj_list = NULL;
+	uint64_t digest;
 
 	if (msg_adjacency_get(msg, &adj_list, &adj_length) != 0) {
+		if (msg_get_uint64(msg, AS_HB_MSG_ADJ_DIGEST, &digest) == 0) {
+			// Delta since the previous pulse - apply it to the previous list.
+			size_t prev_length = prev_plugin_data->data_size / sizeof(cf_node);
+			size_t added_length = 0;
+			cf_node* added_list;
+
+			msg_node_list_get(msg, AS_HB_MSG_ADJ_ADDED, &added_list,
+					&added_length);
+
+			hb_plugin_data_reserve(plugin_data,
+					(prev_length + added_length) * sizeof(cf_node));
+
+			size_t final_list_length = hb_adjacency_delta_apply(msg,
+					(const cf_node*)prev_plugin_data->data, prev_length,
+					(cf_node*)plugin_data->data);
+
+			plugin_data->data_size = (final_list_length * sizeof(cf_node));
+
+			if (hb_adjacency_digest((const cf_node*)plugin_data->data,
+					final_list_length) != digest) {
+				// Missed a pulse, or just connected - ask for the full list.
+				DEBUG("adjacency digest mismatch for node %" PRIx64, source);
+				hb_adjacency_full_request(source);
+			}
+
+			return;
+		}
+
 		// Store a zero length adjacency list. Should not have happened.
 		WARNING("received heartbeat without adjacency list %" PRIx64, source);
 		adj_length = 0;
@@ -7609,20 +7726,7 @@ hb_plugin_parse_data_fn(msg* msg, cf_node source,
 
 	// The guess can be larger for older protocols which also include self node
 	// in the adjacency list.
-	int guessed_data_size = (adj_length * sizeof(cf_node));
-
-	if (guessed_data_size > plugin_data->data_capacity) {
-		// Round up to nearest multiple of block size to prevent very frequent
-		// reallocation.
-		size_t data_capacity = ((guessed_data_size + HB_PLUGIN_DATA_BLOCK_SIZE
-				- 1) /
-		HB_PLUGIN_DATA_BLOCK_SIZE) *
-		HB_PLUGIN_DATA_BLOCK_SIZE;
-
-		// Reallocate since we have outgrown existing capacity.
-		plugin_data->data = cf_realloc(plugin_data->data, data_capacity);
-		plugin_data->data_capacity = data_capacity;
-	}
+	hb_plugin_data_reserve(plugin_data, adj_length * sizeof(cf_node));
 
 	cf_node* dest_list = (cf_node*)(plugin_data->data);
 
@@ -7638,6 +7742,199 @@ hb_plugin_parse_data_fn(msg* msg, cf_node source,
 	plugin_data->data_size = (final_list_length * sizeof(cf_node));
 }
 
+/**
+ * Order independent digest of an adjacency list.
+ */
+static uint64_t
+hb_adjacency_digest(const cf_node* adj_list, size_t adj_length)
+{
+	uint64_t digest = 0;
+
+	for (size_t i = 0; i < adj_length; i++) {
+		digest += cf_hash_fnv64((const uint8_t*)&adj_list[i], sizeof(cf_node));
+	}
+
+	return digest;
+}
+
+/**
+ * Reduce function to check whether all adjacent nodes understand adjacency
+ * deltas.
+ */
+static int
+hb_adjacency_deltas_ok_reduce(const void* key, void* data, void* udata)
+{
+	as_hb_adjacent_node* adjacent_node = (as_hb_adjacent_node*)data;
+	bool* deltas_ok = (bool*)udata;
+
+	if (!adjacent_node->adj_deltas_ok) {
+		*deltas_ok = false;
+		return CF_SHASH_ERR; // stop the reduce
+	}
+
+	return CF_SHASH_OK;
+}
+
+/**
+ * Set the full adjacency list, or only the changes since the previous pulse,
+ * into a pulse message. Either way the message carries the list's digest.
+ *
+ * Should be called under HB_LOCK, only from the transmitter.
+ */
+static void
+hb_adjacency_msg_fill(msg* msg, cf_node* adj_list, size_t adj_length)
+{
+	// Sort so consecutive lists can be diffed, and receivers see a stable order.
+	qsort(adj_list, adj_length, sizeof(cf_node), cf_node_compare_desc);
+
+	msg_set_uint64(msg, AS_HB_MSG_ADJ_DIGEST,
+			hb_adjacency_digest(adj_list, adj_length));
+
+	if (g_hb.adj_n_full_requests != 0) {
+		msg_node_list_set(msg, AS_HB_MSG_ADJ_FULL_REQUEST,
+				g_hb.adj_full_requests, g_hb.adj_n_full_requests);
+		g_hb.adj_n_full_requests = 0;
+	}
+
+	bool deltas_ok = !g_hb.adj_full_needed
+			&& g_hb.adj_pulses_since_full < HB_ADJ_FULL_INTERVAL;
+
+	if (deltas_ok) {
+		cf_shash_reduce(g_hb.adjacency, hb_adjacency_deltas_ok_reduce,
+				&deltas_ok);
+	}
+
+	if (!deltas_ok) {
+		msg_adjacency_set(msg, adj_list, adj_length);
+
+		g_hb.adj_full_needed = false;
+		g_hb.adj_pulses_since_full = 0;
+	}
+	else {
+		cf_node added[adj_length];
+		size_t n_added = 0;
+		cf_node removed[g_hb.adj_sent_count];
+		size_t n_removed = 0;
+		size_t i = 0;
+		size_t j = 0;
+
+		// Merge the two descending lists.
+		while (i < adj_length || j < g_hb.adj_sent_count) {
+			if (j == g_hb.adj_sent_count
+					|| (i < adj_length && adj_list[i] > g_hb.adj_sent[j])) {
+				added[n_added++] = adj_list[i++];
+			}
+			else if (i == adj_length || adj_list[i] < g_hb.adj_sent[j]) {
+				removed[n_removed++] = g_hb.adj_sent[j++];
+			}
+			else {
+				i++;
+				j++;
+			}
+		}
+
+		if (n_added != 0) {
+			msg_node_list_set(msg, AS_HB_MSG_ADJ_ADDED, added, n_added);
+		}
+
+		if (n_removed != 0) {
+			msg_node_list_set(msg, AS_HB_MSG_ADJ_REMOVED, removed, n_removed);
+		}
+
+		g_hb.adj_pulses_since_full++;
+	}
+
+	memcpy(g_hb.adj_sent, adj_list, adj_length * sizeof(cf_node));
+	g_hb.adj_sent_count = adj_length;
+}
+
+/**
+ * Apply the adjacency delta in a pulse message to the source's previous
+ * adjacency list.
+ *
+ * @param dest_list output, large enough for previous and added nodes.
+ * @return the length of the resulting list.
+ */
+static size_t
+hb_adjacency_delta_apply(msg* msg, const cf_node* prev_list,
+		size_t prev_length, cf_node* dest_list)
+{
+	cf_node* removed_list;
+	size_t removed_length = 0;
+
+	msg_node_list_get(msg, AS_HB_MSG_ADJ_REMOVED, &removed_list,
+			&removed_length);
+
+	size_t final_list_length = 0;
+
+	for (size_t i = 0; i < prev_length; i++) {
+		bool is_removed = false;
+
+		for (size_t j = 0; j < removed_length; j++) {
+			if (prev_list[i] == removed_list[j]) {
+				is_removed = true;
+				break;
+			}
+		}
+
+		if (!is_removed) {
+			dest_list[final_list_length++] = prev_list[i];
+		}
+	}
+
+	cf_node* added_list;
+	size_t added_length = 0;
+
+	msg_node_list_get(msg, AS_HB_MSG_ADJ_ADDED, &added_list, &added_length);
+
+	for (size_t i = 0; i < added_length; i++) {
+		dest_list[final_list_length++] = added_list[i];
+	}
+
+	qsort(dest_list, final_list_length, sizeof(cf_node), cf_node_compare_desc);
+
+	return final_list_length;
+}
+
+/**
+ * Ask a node for its full adjacency list in the next pulse.
+ *
+ * Should be called under HB_LOCK.
+ */
+static void
+hb_adjacency_full_request(cf_node source)
+{
+	for (size_t i = 0; i < g_hb.adj_n_full_requests; i++) {
+		if (g_hb.adj_full_requests[i] == source) {
+			return;
+		}
+	}
+
+	if (g_hb.adj_n_full_requests < AS_CLUSTER_SZ) {
+		g_hb.adj_full_requests[g_hb.adj_n_full_requests++] = source;
+	}
+}
+
+/**
+ * Ensure plugin data has room for at least data_size bytes.
+ */
+static void
+hb_plugin_data_reserve(as_hb_plugin_node_data* plugin_data, size_t data_size)
+{
+	if (data_size > plugin_data->data_capacity) {
+		// Round up to nearest multiple of block size to prevent very frequent
+		// reallocation.
+		size_t data_capacity = ((data_size + HB_PLUGIN_DATA_BLOCK_SIZE
+				- 1) /
+		HB_PLUGIN_DATA_BLOCK_SIZE) *
+		HB_PLUGIN_DATA_BLOCK_SIZE;
+
+		// Reallocate since we have outgrown existing capacity.
+		plugin_data->data = cf_realloc(plugin_data->data, data_capacity);
+		plugin_data->data_capacity = data_capacity;
+	}
+}
+
 /**
  * Get the msg buffer from a pool based on the protocol under use.
  * @return the msg buff
@@ -8413,6 +8710,9 @@ hb_adjacent_node_update(as_hb_channel_event* msg_event,
 	// Reset the cluster-name mismatch counter to zero.
 	adjacent_node->cluster_name_mismatch_count = 0;
 
+	// Newer nodes advertise they can handle adjacency deltas.
+	adjacent_node->adj_deltas_ok = msg_is_set(msg, AS_HB_MSG_ADJ_DIGEST);
+
 	// Check if fabric endpoints have changed.
 	as_hb_plugin_node_data* curr_data =
 			&adjacent_node->plugin_data[AS_HB_PLUGIN_FABRIC][adjacent_node->plugin_data_cycler
@@ -8571,6 +8871,9 @@ hb_channel_on_pulse(as_hb_channel_event* msg_event)
 			&source);
 
 	if (is_new) {
+		// The new node can't have a base for our adjacency deltas.
+		g_hb.adj_full_needed = true;
+
 		// Publish event if this is a new node.
 		INFO("node arrived %" PRIx64, source);
 		hb_event_queue(AS_HB_INTERNAL_NODE_ARRIVE, &source, 1);
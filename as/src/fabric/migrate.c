@@ -33,13 +33,16 @@
 #include <string.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_atomic.h"
 #include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_digest.h"
 #include "citrusleaf/cf_queue.h"
 
+#include "bits.h"
 #include "cf_mutex.h"
 #include "cf_thread.h"
 #include "log.h"
@@ -51,6 +54,7 @@
 #include "base/cfg.h"
 #include "base/datamodel.h"
 #include "base/index.h"
+#include "base/probes.h"
 #include "base/proto.h"
 #include "fabric/exchange.h"
 #include "fabric/fabric.h"
@@ -95,7 +99,10 @@ const msg_template migrate_mt[] = {
 		{ MIG_FIELD_UNUSED_26, M_FT_BUF },
 		{ MIG_FIELD_UNUSED_27, M_FT_BUF },
 		{ MIG_FIELD_UNUSED_28, M_FT_UINT32 },
-		{ MIG_FIELD_EMIG_INSERT_ID, M_FT_UINT64 }
+		{ MIG_FIELD_EMIG_INSERT_ID, M_FT_UINT64 },
+		{ MIG_FIELD_RECORD_ORIG_SZ, M_FT_UINT32 },
+		{ MIG_FIELD_RECORD_COUNT, M_FT_UINT32 },
+		{ MIG_FIELD_RANGE_SUMMARY, M_FT_BUF }
 };
 
 COMPILER_ASSERT(sizeof(migrate_mt) / sizeof(msg_template) == NUM_MIG_FIELDS);
@@ -107,6 +114,26 @@ COMPILER_ASSERT(sizeof(migrate_mt) / sizeof(msg_template) == NUM_MIG_FIELDS);
 #define MIGRATE_RETRANSMIT_SIGNAL_MS 1000 // for now, not configurable
 #define MAX_BYTES_EMIGRATING (32 * 1024 * 1024)
 
+// Emigration window - grows by about MIG_WINDOW_INCR per window's worth of
+// prompt acks, halves on overload signals, retransmits, or ack latency spikes.
+#define MIG_WINDOW_MIN (256 * 1024)
+#define MIG_WINDOW_INIT (4 * 1024 * 1024)
+#define MIG_WINDOW_INCR (256 * 1024)
+#define MIG_WINDOW_BACKOFF_MS 100 // at most one shrink per interval
+#define MIG_ACK_LATENCY_FACTOR 4 // shrink if ack takes this many times best ...
+#define MIG_ACK_LATENCY_MIN_US 2000 // ... and longer than this
+
+#define MIG_COMPRESS_MIN_SZ 256 // smaller records aren't worth compressing
+#define MIG_COMPRESS_MAX_ORIG_SZ (128 * 1024 * 1024) // used simply for validation
+
+// Records packed into one insert msg, if the destination takes batches.
+#define MIG_BATCH_MAX_SZ (128 * 1024)
+#define MIG_BATCH_MAX_RECS 256
+
+// Delta migration - ranges are keyed by a digest byte independent of pid.
+#define MIG_RANGE_DIGEST_BYTE 2
+#define MIG_RANGE_SUMMARY_SZ (MIG_N_RANGES * sizeof(uint64_t))
+
 #define IMMIGRATION_DEBOUNCE_MS (60 * 1000) // 1 minute
 
 typedef enum {
@@ -126,19 +153,44 @@ typedef struct emigration_pop_info_s {
 	uint32_t order;
 	uint64_t dest_score;
 	uint32_t type;
+	uint32_t heat;
 	uint64_t n_elements;
 
 	uint64_t avoid_dest;
 } emigration_pop_info;
 
+typedef struct emigration_batch_rec_s {
+	cf_digest keyd;
+	uint64_t lut;
+} emigration_batch_rec;
+
 typedef struct emigration_reinsert_ctrl_s {
 	uint64_t xmit_ms; // time of last xmit - 0 when done
+	uint64_t xmit_us; // time of first xmit - 0 once retransmitted
 	emigration *emig;
 	msg *m;
 	cf_digest keyd;
 	uint64_t lut;
+	uint32_t n_recs; // if > 1, records are in recs instead of keyd & lut
+	emigration_batch_rec *recs;
 } emigration_reinsert_ctrl;
 
+// Batch record entry on wire: info (uint32_t), pickle size (uint32_t), pickle.
+// Like the pickles themselves, sizes are in host byte order.
+typedef struct emigration_batch_s {
+	uint8_t buf[MIG_BATCH_MAX_SZ];
+	uint32_t sz;
+	uint32_t n_recs;
+	emigration_batch_rec recs[MIG_BATCH_MAX_RECS];
+} emigration_batch;
+
+#define MIG_BATCH_REC_HDR_SZ (2 * sizeof(uint32_t))
+
+typedef struct range_summary_info_s {
+	as_namespace *ns;
+	uint64_t *sums;
+} range_summary_info;
+
 
 //==========================================================
 // Globals.
@@ -179,6 +231,19 @@ void *run_emigration_reinserter(void *arg);
 bool emigrate_tree_reduce_fn(as_index_ref *r_ref, void *udata);
 int emigration_reinsert_reduce_fn(const void *key, void *data, void *udata);
 void emigrate_record(emigration *emig, msg *m, cf_digest* keyd, uint64_t lut);
+void emigrate_insert(emigration *emig, emigration_reinsert_ctrl *ri_ctrl);
+void emigration_set_record(const emigration *emig, msg *m, uint8_t *pickle, uint32_t pickle_sz);
+bool emigration_batch_add(emigration *emig, const uint8_t *pickle, uint32_t pickle_sz, uint32_t info, const cf_digest *keyd, uint64_t lut);
+void emigration_batch_flush(emigration *emig);
+bool emigration_reinsert_satisfied(const emigration_reinsert_ctrl *ri_ctrl, const cf_digest *keyd, uint64_t lut);
+uint32_t emigration_match_ranges(emigration *emig);
+void emigration_window_grow(emigration *emig, uint32_t acked_sz, uint64_t ack_us);
+void emigration_window_shrink(emigration *emig, const char *why);
+void emigrate_tree_filter_fn(as_index* const* rs, uint32_t n_rs, uint8_t* keep, void* udata);
+
+// Delta migration.
+uint64_t *range_summary_create(as_namespace *ns, as_index_tree *tree);
+bool range_summary_reduce_fn(as_index_ref *r_ref, void *udata);
 
 // Immigration.
 uint32_t immigration_hashfn(const void *key);
@@ -190,9 +255,13 @@ int migrate_receive_msg_cb(cf_node src, msg *m, void *udata);
 void immigration_handle_start_request(cf_node src, msg *m);
 void immigration_ack_start_request(cf_node src, msg *m, uint32_t op);
 void immigration_handle_insert_request(cf_node src, msg *m);
+uint8_t *immigration_uncompress_record(const uint8_t *buf, uint32_t sz, uint32_t orig_sz);
+bool immigration_insert_record(immigration *immig, cf_node src, uint8_t *pickle, size_t pickle_sz, uint32_t info);
+bool immigration_insert_batch(immigration *immig, cf_node src, uint8_t *buf, size_t buf_sz, uint32_t n_recs);
 void immigration_handle_done_request(cf_node src, msg *m);
 void immigration_handle_all_done_request(cf_node src, msg *m);
 void emigration_handle_insert_ack(cf_node src, msg *m);
+void emigration_handle_insert_overloaded(cf_node src, msg *m);
 void emigration_handle_ctrl_ack(cf_node src, msg *m, uint32_t op);
 
 // Info API helpers.
@@ -248,8 +317,15 @@ as_migrate_emigrate(const pb_task *task)
 
 	// Create these later only when we need them - we'll get lots at once.
 	emig->bytes_emigrating = 0;
+	emig->window = MIG_WINDOW_INIT;
+	emig->min_ack_us = 0;
+	emig->backoff_until_ms = 0;
 	emig->reinsert_hash = NULL;
 	emig->insert_id = 0;
+	emig->dest_features = 0;
+	emig->batch = NULL;
+	emig->dest_range_sums = NULL;
+	memset(emig->skip_ranges, 0, sizeof(emig->skip_ranges));
 	emig->ctrl_q = NULL;
 	emig->meta_q = NULL;
 
@@ -361,6 +437,9 @@ emigration_destroy(void *parm)
 		meta_in_q_destroy(emig->meta_q);
 	}
 
+	cf_free(emig->batch);
+	cf_free(emig->dest_range_sums);
+
 	as_partition_release(&emig->rsv);
 
 	cf_atomic_int_decr(&emig->rsv.ns->migrate_tx_instance_count);
@@ -373,6 +452,7 @@ emigration_reinsert_destroy_reduce_fn(const void *key, void *data, void *udata)
 	emigration_reinsert_ctrl *ri_ctrl = (emigration_reinsert_ctrl *)data;
 
 	as_fabric_msg_put(ri_ctrl->m);
+	cf_free(ri_ctrl->recs);
 
 	return CF_SHASH_REDUCE_DELETE;
 }
@@ -402,6 +482,8 @@ immigration_destroy(void *parm)
 		meta_out_q_destroy(immig->meta_q);
 	}
 
+	cf_free(immig->range_sums);
+
 	cf_atomic_int_decr(&immig->ns->migrate_rx_instance_count);
 }
 
@@ -423,6 +505,8 @@ immigration_release(immigration *immig)
 void *
 run_emigration(void *arg)
 {
+	as_storage_set_thread_io_class(AS_STORAGE_IO_BACKGROUND);
+
 	while (true) {
 		emigration *emig;
 
@@ -503,6 +587,7 @@ emigration_pop(emigration **emigp)
 	best.order = 0xFFFFffff;
 	best.dest_score = 0;
 	best.type = 0;
+	best.heat = 0;
 	best.n_elements = 0xFFFFffffFFFFffff;
 
 	best.avoid_dest = 0;
@@ -545,6 +630,9 @@ emigration_pop_reduce_fn(void *buf, void *udata)
 	uint64_t dest_score = (uint64_t)emig->dest - best->avoid_dest;
 	uint32_t type = (emig->tx_flags & TX_FLAGS_LEAD) != 0 ?
 			2 : ((emig->tx_flags & TX_FLAGS_CONTINGENT) != 0 ? 1 : 0);
+	uint32_t hits = cf_atomic32_get(emig->rsv.p->n_unmigrated_hits);
+	// Log2 classes - among similarly hot partitions, smaller ones go first.
+	uint32_t heat = (uint32_t)(cf_msb(hits) + 1);
 	uint64_t n_elements = as_index_tree_size(emig->rsv.tree);
 
 	if (order < best->order ||
@@ -553,10 +641,13 @@ emigration_pop_reduce_fn(void *buf, void *udata)
 					(dest_score == best->dest_score &&
 						(type > best->type ||
 							(type == best->type &&
-								n_elements < best->n_elements)))))) {
+								(heat > best->heat ||
+									(heat == best->heat &&
+										n_elements < best->n_elements)))))))) {
 		best->order = order;
 		best->dest_score = dest_score;
 		best->type = type;
+		best->heat = heat;
 		best->n_elements = n_elements;
 
 		g_avoid_dest = (uint64_t)emig->dest;
@@ -617,6 +708,9 @@ emigrate_transfer(emigration *emig)
 	// Send whole tree - may block a while.
 	//
 
+	ASD_PROBE3(migrate__emigrate_start, emig->rsv.ns->ix, emig->rsv.p->id,
+			emig->dest);
+
 	if (! emigrate_tree(emig)) {
 		return false; // did not requeue
 	}
@@ -626,6 +720,9 @@ emigrate_transfer(emigration *emig)
 	//
 
 	if (emigration_send_done(emig)) {
+		ASD_PROBE3(migrate__emigrate_done, emig->rsv.ns->ix, emig->rsv.p->id,
+				emig->dest);
+
 		as_partition_emigrate_done(emig->rsv.ns, emig->rsv.p->id,
 				emig->cluster_key, emig->dest, emig->tx_flags);
 	}
@@ -763,10 +860,28 @@ emigrate_tree(emigration *emig)
 
 	cf_atomic32_set(&emig->state, EMIG_STATE_ACTIVE);
 
+	if ((emig->dest_features & MIG_FEATURE_BATCH) != 0) {
+		emig->batch = cf_malloc(sizeof(emigration_batch));
+		emig->batch->sz = 0;
+		emig->batch->n_recs = 0;
+	}
+
+	as_index_filter_fn filter = NULL;
+
+	if (emig->dest_range_sums != NULL &&
+			emigration_match_ranges(emig) != 0) {
+		filter = emigrate_tree_filter_fn;
+	}
+
 	cf_tid tid = cf_thread_create_joinable(run_emigration_reinserter,
 			(void*)emig);
 
-	if (as_index_reduce(emig->rsv.tree, emigrate_tree_reduce_fn, emig)) {
+	if (as_index_reduce_from_filtered(emig->rsv.tree, NULL, filter,
+			emigrate_tree_reduce_fn, emig)) {
+		if (emig->batch != NULL) {
+			emigration_batch_flush(emig);
+		}
+
 		// Sets EMIG_STATE_FINISHED only if not already EMIG_STATE_ABORTED.
 		cf_atomic32_setmax(&emig->state, EMIG_STATE_FINISHED);
 	}
@@ -867,33 +982,27 @@ emigrate_tree_reduce_fn(as_index_ref *r_ref, void *udata)
 	as_namespace *ns = emig->rsv.ns;
 	as_record *r = r_ref->r;
 
-	if (! should_emigrate_record(emig, r_ref)) {
+	// Filter may have been bypassed - e.g. trees without ref-counts.
+	uint32_t range = r->keyd.digest[MIG_RANGE_DIGEST_BYTE];
+
+	if ((emig->skip_ranges[range >> 6] & (1UL << (range & 63))) != 0) {
+		cf_atomic_int_incr(&ns->migrate_records_skipped);
 		as_record_done(r_ref, ns);
 		return emig->cluster_key == as_exchange_cluster_key();
 	}
 
-	msg *m = as_fabric_msg_get(M_TYPE_MIGRATE);
-
-	msg_set_uint32(m, MIG_FIELD_OP, OPERATION_INSERT);
-	msg_set_uint32(m, MIG_FIELD_EMIG_ID, emig->id);
+	if (! should_emigrate_record(emig, r_ref)) {
+		as_record_done(r_ref, ns);
+		return emig->cluster_key == as_exchange_cluster_key();
+	}
 
 	uint32_t info = emigration_pack_info(emig, r);
 
-	if (info != 0) {
-		msg_set_uint32(m, MIG_FIELD_INFO, info);
-	}
-
 	as_storage_rd rd;
 
 	as_storage_record_open(ns, r, &rd);
 
-	if (as_storage_rd_load_pickle(&rd)) {
-		msg_set_buf(m, MIG_FIELD_RECORD, rd.pickle, rd.pickle_sz,
-				MSG_SET_HANDOFF_MALLOC);
-	}
-	else {
-		cf_warning(AS_MIGRATE, "unreadable digest %pD", &r->keyd);
-	}
+	bool loaded = as_storage_rd_load_pickle(&rd);
 
 	as_storage_record_close(&rd);
 
@@ -902,8 +1011,32 @@ emigrate_tree_reduce_fn(as_index_ref *r_ref, void *udata)
 
 	as_record_done(r_ref, ns);
 
-	// This might block if the queues are backed up.
-	emigrate_record(emig, m, &keyd, lut);
+	if (! loaded) {
+		cf_warning(AS_MIGRATE, "unreadable digest %pD", &keyd);
+	}
+
+	if (loaded && emig->batch != NULL &&
+			emigration_batch_add(emig, rd.pickle, rd.pickle_sz, info, &keyd,
+					lut)) {
+		cf_free(rd.pickle);
+	}
+	else {
+		msg *m = as_fabric_msg_get(M_TYPE_MIGRATE);
+
+		msg_set_uint32(m, MIG_FIELD_OP, OPERATION_INSERT);
+		msg_set_uint32(m, MIG_FIELD_EMIG_ID, emig->id);
+
+		if (info != 0) {
+			msg_set_uint32(m, MIG_FIELD_INFO, info);
+		}
+
+		if (loaded) {
+			emigration_set_record(emig, m, rd.pickle, rd.pickle_sz);
+		}
+
+		// This might block if the queues are backed up.
+		emigrate_record(emig, m, &keyd, lut);
+	}
 
 	cf_atomic_int_incr(&ns->migrate_records_transmitted);
 
@@ -913,7 +1046,8 @@ emigrate_tree_reduce_fn(as_index_ref *r_ref, void *udata)
 
 	uint32_t waits = 0;
 
-	while (cf_atomic32_get(emig->bytes_emigrating) > MAX_BYTES_EMIGRATING &&
+	while (cf_atomic32_get(emig->bytes_emigrating) >
+			cf_atomic32_get(emig->window) &&
 			emig->cluster_key == as_exchange_cluster_key()) {
 		usleep(1000);
 
@@ -935,19 +1069,18 @@ emigration_reinsert_reduce_fn(const void *key, void *data, void *udata)
 	uint64_t now = (uint64_t)udata;
 
 	if (ri_ctrl->xmit_ms + ns->migrate_retransmit_ms < now) {
-		bool satisfied = false;
-		as_index_ref r_ref;
-
-		if (as_record_get(ri_ctrl->emig->rsv.tree, &ri_ctrl->keyd,
-				&r_ref) == 0) {
-			if (r_ref.r->last_update_time != ri_ctrl->lut) {
-				satisfied = true; // replication satisfied by recent update
-			}
+		bool satisfied = true;
 
-			as_record_done(&r_ref, ns);
+		if (ri_ctrl->recs == NULL) {
+			satisfied = emigration_reinsert_satisfied(ri_ctrl, &ri_ctrl->keyd,
+					ri_ctrl->lut);
 		}
 		else {
-			satisfied = true; // replication satisfied by recent drop
+			// Whole batch is retransmitted unless every record is satisfied.
+			for (uint32_t i = 0; i < ri_ctrl->n_recs && satisfied; i++) {
+				satisfied = emigration_reinsert_satisfied(ri_ctrl,
+						&ri_ctrl->recs[i].keyd, ri_ctrl->recs[i].lut);
+			}
 		}
 
 		if (satisfied) {
@@ -957,6 +1090,7 @@ emigration_reinsert_reduce_fn(const void *key, void *data, void *udata)
 			}
 
 			as_fabric_msg_put(ri_ctrl->m);
+			cf_free(ri_ctrl->recs);
 
 			return CF_SHASH_REDUCE_DELETE;
 		}
@@ -974,30 +1108,62 @@ emigration_reinsert_reduce_fn(const void *key, void *data, void *udata)
 		}
 
 		ri_ctrl->xmit_ms = now;
+		ri_ctrl->xmit_us = 0; // ambiguous which xmit an ack would be for
 		cf_atomic_int_incr(&ns->migrate_record_retransmits);
+
+		emigration_window_shrink(ri_ctrl->emig, "retransmit");
 	}
 
 	return CF_SHASH_OK;
 }
 
 
-void
-emigrate_record(emigration *emig, msg *m, cf_digest* keyd, uint64_t lut)
+bool
+emigration_reinsert_satisfied(const emigration_reinsert_ctrl *ri_ctrl,
+		const cf_digest *keyd, uint64_t lut)
 {
-	uint64_t insert_id = emig->insert_id++;
+	as_index_ref r_ref;
 
-	msg_set_uint64(m, MIG_FIELD_EMIG_INSERT_ID, insert_id);
+	if (as_record_get(ri_ctrl->emig->rsv.tree, keyd, &r_ref) != 0) {
+		return true; // replication satisfied by recent drop
+	}
+
+	bool satisfied = r_ref.r->last_update_time != lut; // by recent update
+
+	as_record_done(&r_ref, ri_ctrl->emig->rsv.ns);
+
+	return satisfied;
+}
 
+
+void
+emigrate_record(emigration *emig, msg *m, cf_digest* keyd, uint64_t lut)
+{
 	emigration_reinsert_ctrl ri_ctrl = {
-			.xmit_ms = cf_getms(),
 			.emig = emig,
 			.m = m,
 			.keyd = *keyd,
 			.lut = lut,
+			.n_recs = 1
 	};
 
+	emigrate_insert(emig, &ri_ctrl);
+}
+
+
+void
+emigrate_insert(emigration *emig, emigration_reinsert_ctrl *ri_ctrl)
+{
+	msg *m = ri_ctrl->m;
+	uint64_t insert_id = emig->insert_id++;
+
+	msg_set_uint64(m, MIG_FIELD_EMIG_INSERT_ID, insert_id);
+
+	ri_ctrl->xmit_ms = cf_getms();
+	ri_ctrl->xmit_us = cf_getus();
+
 	msg_incr_ref(m); // the reference in the hash
-	cf_shash_put(emig->reinsert_hash, &insert_id, &ri_ctrl);
+	cf_shash_put(emig->reinsert_hash, &insert_id, ri_ctrl);
 
 	cf_atomic32_add(&emig->bytes_emigrating, (int32_t)msg_get_wire_size(m));
 
@@ -1008,6 +1174,218 @@ emigrate_record(emigration *emig, msg *m, cf_digest* keyd, uint64_t lut)
 }
 
 
+// Takes ownership of pickle.
+void
+emigration_set_record(const emigration *emig, msg *m, uint8_t *pickle,
+		uint32_t pickle_sz)
+{
+	int level = (int)g_config.migrate_compression_level;
+
+	if (level == 0 || (emig->dest_features & MIG_FEATURE_COMPRESS) == 0 ||
+			pickle_sz < MIG_COMPRESS_MIN_SZ) {
+		msg_set_buf(m, MIG_FIELD_RECORD, pickle, pickle_sz,
+				MSG_SET_HANDOFF_MALLOC);
+		return;
+	}
+
+	uLongf comp_sz = compressBound(pickle_sz);
+	uint8_t *comp = cf_malloc(comp_sz);
+
+	// Send as is if compression fails or doesn't help.
+	if (compress2(comp, &comp_sz, pickle, pickle_sz, level) != Z_OK ||
+			comp_sz >= pickle_sz) {
+		cf_free(comp);
+		msg_set_buf(m, MIG_FIELD_RECORD, pickle, pickle_sz,
+				MSG_SET_HANDOFF_MALLOC);
+		return;
+	}
+
+	cf_free(pickle);
+
+	msg_set_buf(m, MIG_FIELD_RECORD, comp, comp_sz, MSG_SET_HANDOFF_MALLOC);
+	msg_set_uint32(m, MIG_FIELD_RECORD_ORIG_SZ, pickle_sz);
+}
+
+
+// Returns false if the record must go on its own - pickle is not consumed.
+bool
+emigration_batch_add(emigration *emig, const uint8_t *pickle,
+		uint32_t pickle_sz, uint32_t info, const cf_digest *keyd, uint64_t lut)
+{
+	emigration_batch *batch = emig->batch;
+	uint32_t rec_sz = MIG_BATCH_REC_HDR_SZ + pickle_sz;
+
+	if (rec_sz > MIG_BATCH_MAX_SZ / 2) {
+		return false; // big records gain nothing from batching
+	}
+
+	if (batch->sz + rec_sz > MIG_BATCH_MAX_SZ) {
+		emigration_batch_flush(emig);
+	}
+
+	uint8_t *at = batch->buf + batch->sz;
+
+	*(uint32_t *)at = info;
+	at += sizeof(uint32_t);
+	*(uint32_t *)at = pickle_sz;
+	at += sizeof(uint32_t);
+	memcpy(at, pickle, pickle_sz);
+
+	batch->sz += rec_sz;
+	batch->recs[batch->n_recs].keyd = *keyd;
+	batch->recs[batch->n_recs].lut = lut;
+	batch->n_recs++;
+
+	if (batch->n_recs == MIG_BATCH_MAX_RECS) {
+		emigration_batch_flush(emig);
+	}
+
+	return true;
+}
+
+
+void
+emigration_batch_flush(emigration *emig)
+{
+	emigration_batch *batch = emig->batch;
+
+	if (batch->n_recs == 0) {
+		return;
+	}
+
+	msg *m = as_fabric_msg_get(M_TYPE_MIGRATE);
+
+	msg_set_uint32(m, MIG_FIELD_OP, OPERATION_INSERT);
+	msg_set_uint32(m, MIG_FIELD_EMIG_ID, emig->id);
+	msg_set_uint32(m, MIG_FIELD_RECORD_COUNT, batch->n_recs);
+
+	uint8_t *buf = cf_malloc(batch->sz);
+
+	memcpy(buf, batch->buf, batch->sz);
+	emigration_set_record(emig, m, buf, batch->sz);
+
+	// The reinsert entry keeps every record's digest & lut.
+	size_t recs_sz = batch->n_recs * sizeof(emigration_batch_rec);
+	emigration_batch_rec *recs = cf_malloc(recs_sz);
+
+	memcpy(recs, batch->recs, recs_sz);
+
+	emigration_reinsert_ctrl ri_ctrl = {
+			.emig = emig,
+			.m = m,
+			.n_recs = batch->n_recs,
+			.recs = recs
+	};
+
+	batch->sz = 0;
+	batch->n_recs = 0;
+
+	// This might block if the queues are backed up.
+	emigrate_insert(emig, &ri_ctrl);
+}
+
+
+// Marks ranges whose records match the destination's, returns how many.
+uint32_t
+emigration_match_ranges(emigration *emig)
+{
+	uint64_t *sums = range_summary_create(emig->rsv.ns, emig->rsv.tree);
+	uint32_t n_matched = 0;
+
+	for (uint32_t i = 0; i < MIG_N_RANGES; i++) {
+		// Empty ranges match trivially and contain nothing to skip anyway.
+		if (sums[i] != 0 && sums[i] == emig->dest_range_sums[i]) {
+			emig->skip_ranges[i >> 6] |= 1UL << (i & 63);
+			n_matched++;
+		}
+	}
+
+	cf_free(sums);
+
+	cf_detail(AS_MIGRATE, "{%s:%u} delta to %lx - %u/%u ranges match",
+			emig->rsv.ns->name, emig->rsv.p->id, emig->dest, n_matched,
+			MIG_N_RANGES);
+
+	return n_matched;
+}
+
+
+// Keys are immutable, so checking ranges without the record lock is safe.
+void
+emigrate_tree_filter_fn(as_index* const* rs, uint32_t n_rs, uint8_t* keep,
+		void* udata)
+{
+	emigration *emig = (emigration *)udata;
+	uint32_t n_skipped = 0;
+
+	for (uint32_t i = 0; i < n_rs; i++) {
+		uint32_t range = rs[i]->keyd.digest[MIG_RANGE_DIGEST_BYTE];
+
+		if ((emig->skip_ranges[range >> 6] & (1UL << (range & 63))) != 0) {
+			keep[i] = 0;
+			n_skipped++;
+		}
+	}
+
+	if (n_skipped != 0) {
+		cf_atomic_int_add(&emig->rsv.ns->migrate_records_skipped, n_skipped);
+	}
+}
+
+
+// Called from fabric threads - races between them only blur the adaptation.
+void
+emigration_window_grow(emigration *emig, uint32_t acked_sz, uint64_t ack_us)
+{
+	if (emig->min_ack_us == 0 || ack_us < emig->min_ack_us) {
+		emig->min_ack_us = ack_us;
+	}
+
+	// A queue building up at the destination shows as ack latency.
+	if (ack_us > MIG_ACK_LATENCY_MIN_US &&
+			ack_us > emig->min_ack_us * MIG_ACK_LATENCY_FACTOR) {
+		emigration_window_shrink(emig, "ack latency");
+		return;
+	}
+
+	uint32_t window = cf_atomic32_get(emig->window);
+
+	if (window >= MAX_BYTES_EMIGRATING) {
+		return;
+	}
+
+	uint64_t incr = (uint64_t)MIG_WINDOW_INCR * acked_sz / window;
+	uint64_t new_window = window + (incr == 0 ? 1 : incr);
+
+	cf_atomic32_set(&emig->window, new_window > MAX_BYTES_EMIGRATING ?
+			MAX_BYTES_EMIGRATING : (uint32_t)new_window);
+}
+
+
+void
+emigration_window_shrink(emigration *emig, const char *why)
+{
+	uint64_t now = cf_getms();
+
+	if (now < emig->backoff_until_ms) {
+		return;
+	}
+
+	emig->backoff_until_ms = now + MIG_WINDOW_BACKOFF_MS;
+
+	uint32_t window = cf_atomic32_get(emig->window) / 2;
+
+	if (window < MIG_WINDOW_MIN) {
+		window = MIG_WINDOW_MIN;
+	}
+
+	cf_atomic32_set(&emig->window, window);
+
+	cf_detail(AS_MIGRATE, "{%s:%u} %s - window to node %lx now %u",
+			emig->rsv.ns->name, emig->rsv.p->id, why, emig->dest, window);
+}
+
+
 //==========================================================
 // Local helpers - immigration.
 //
@@ -1109,6 +1487,9 @@ migrate_receive_msg_cb(cf_node src, msg *m, void *udata)
 	case OPERATION_INSERT_ACK:
 		emigration_handle_insert_ack(src, m);
 		break;
+	case OPERATION_INSERT_OVERLOADED:
+		emigration_handle_insert_overloaded(src, m);
+		break;
 	case OPERATION_START_ACK_OK:
 	case OPERATION_START_ACK_EAGAIN:
 	case OPERATION_START_ACK_FAIL:
@@ -1206,6 +1587,7 @@ immigration_handle_start_request(cf_node src, msg *m)
 	immig->emig_id = emig_id;
 	immig->meta_q = meta_out_q_create();
 	immig->features = MY_MIG_FEATURES;
+	immig->range_sums = NULL;
 	immig->ns = ns;
 	immig->rsv.p = NULL;
 
@@ -1278,11 +1660,26 @@ immigration_handle_start_request(cf_node src, msg *m)
 			immig->features &= ~MIG_FEATURE_MERGE;
 		}
 
+		if ((emig_features & MIG_FEATURE_OVERLOAD_SIGNAL) == 0) {
+			immig->features &= ~MIG_FEATURE_OVERLOAD_SIGNAL;
+		}
+
+		// Only worth summarizing if we have records the emigrator might too.
+		if ((emig_features & MIG_FEATURE_DELTA) != 0 && emig_n_recs != 0 &&
+				as_index_tree_size(immig->rsv.tree) != 0) {
+			immig->range_sums = range_summary_create(ns, immig->rsv.tree);
+		}
+
 		immig->start_recv_ms = cf_getms(); // permits reaping
 	}
 
 	msg_set_uint32(m, MIG_FIELD_FEATURES, immig->features);
 
+	if (immig->range_sums != NULL) {
+		msg_set_buf(m, MIG_FIELD_RANGE_SUMMARY, (uint8_t *)immig->range_sums,
+				MIG_RANGE_SUMMARY_SZ, MSG_SET_COPY);
+	}
+
 	immigration_release(immig);
 	immigration_ack_start_request(src, m, OPERATION_START_ACK_OK);
 }
@@ -1343,44 +1740,74 @@ immigration_handle_insert_request(cf_node src, msg *m)
 	}
 
 	if (as_storage_overloaded(immig->rsv.ns, 64, "immigrate")) {
+		// Don't ack - record will be retransmitted. But if emigrator can back
+		// off, tell it now rather than let it wait for the retransmit.
+		if ((immig->features & MIG_FEATURE_OVERLOAD_SIGNAL) != 0) {
+			immigration_release(immig);
+
+			msg_preserve_fields(m, 1, MIG_FIELD_EMIG_ID);
+
+			msg_set_uint32(m, MIG_FIELD_OP, OPERATION_INSERT_OVERLOADED);
+
+			if (as_fabric_send(src, m, AS_FABRIC_CHANNEL_BULK) !=
+					AS_FABRIC_SUCCESS) {
+				as_fabric_msg_put(m);
+			}
+
+			return;
+		}
+
 		immigration_release(immig);
 		as_fabric_msg_put(m);
 		return;
 	}
 
-	as_remote_record rr = {
-			.via = VIA_MIGRATION,
-			.src = src,
-			.rsv = &immig->rsv
-	};
+	uint8_t *buf;
+	size_t buf_sz;
 
-	if (msg_get_buf(m, MIG_FIELD_RECORD, &rr.pickle, &rr.pickle_sz,
-			MSG_GET_DIRECT) != 0) {
+	if (msg_get_buf(m, MIG_FIELD_RECORD, &buf, &buf_sz, MSG_GET_DIRECT) != 0) {
 		cf_warning(AS_MIGRATE, "handle insert: got no record");
 		immigration_release(immig);
 		as_fabric_msg_put(m);
 		return;
 	}
 
-	if (! as_flat_unpack_remote_record_meta(rr.rsv->ns, &rr)) {
-		cf_warning(AS_MIGRATE, "handle insert: got bad record");
-		immigration_release(immig);
-		as_fabric_msg_put(m);
-		return;
+	uint8_t *orig_buf = NULL;
+	uint32_t orig_sz;
+
+	if (msg_get_uint32(m, MIG_FIELD_RECORD_ORIG_SZ, &orig_sz) == 0) {
+		orig_buf = immigration_uncompress_record(buf, (uint32_t)buf_sz,
+				orig_sz);
+
+		if (orig_buf == NULL) {
+			cf_warning(AS_MIGRATE, "handle insert: got bad compressed record");
+			immigration_release(immig);
+			as_fabric_msg_put(m);
+			return;
+		}
+
+		buf = orig_buf;
+		buf_sz = orig_sz;
 	}
 
-	uint32_t info = 0;
+	uint32_t n_recs;
+	bool ok;
 
-	msg_get_uint32(m, MIG_FIELD_INFO, &info);
+	if (msg_get_uint32(m, MIG_FIELD_RECORD_COUNT, &n_recs) == 0) {
+		ok = immigration_insert_batch(immig, src, buf, buf_sz, n_recs);
+	}
+	else {
+		uint32_t info = 0;
 
-	immigration_init_repl_state(&rr, info);
+		msg_get_uint32(m, MIG_FIELD_INFO, &info);
 
-	int rv = as_record_replace_if_better(&rr);
+		ok = immigration_insert_record(immig, src, buf, buf_sz, info);
+	}
 
-	// If replace failed, don't ack - it will be retransmitted.
-	if (! (rv == AS_OK ||
-			// Migrations just treat these errors as successful no-ops:
-			rv == AS_ERR_RECORD_EXISTS || rv == AS_ERR_GENERATION)) {
+	cf_free(orig_buf);
+
+	// If any record failed, don't ack - it will all be retransmitted.
+	if (! ok) {
 		immigration_release(immig);
 		as_fabric_msg_put(m);
 		return;
@@ -1398,6 +1825,98 @@ immigration_handle_insert_request(cf_node src, msg *m)
 }
 
 
+// Returns NULL if buf doesn't uncompress to exactly orig_sz bytes.
+uint8_t *
+immigration_uncompress_record(const uint8_t *buf, uint32_t sz,
+		uint32_t orig_sz)
+{
+	if (orig_sz == 0 || orig_sz > MIG_COMPRESS_MAX_ORIG_SZ) {
+		return NULL;
+	}
+
+	uint8_t *orig = cf_malloc(orig_sz);
+	uLongf out_sz = orig_sz;
+
+	if (uncompress(orig, &out_sz, buf, sz) != Z_OK || out_sz != orig_sz) {
+		cf_free(orig);
+		return NULL;
+	}
+
+	return orig;
+}
+
+
+bool
+immigration_insert_record(immigration *immig, cf_node src, uint8_t *pickle,
+		size_t pickle_sz, uint32_t info)
+{
+	as_remote_record rr = {
+			.via = VIA_MIGRATION,
+			.src = src,
+			.rsv = &immig->rsv,
+			.pickle = pickle,
+			.pickle_sz = pickle_sz
+	};
+
+	if (! as_flat_unpack_remote_record_meta(rr.rsv->ns, &rr)) {
+		cf_warning(AS_MIGRATE, "handle insert: got bad record");
+		return false;
+	}
+
+	immigration_init_repl_state(&rr, info);
+
+	int rv = as_record_replace_if_better(&rr);
+
+	return rv == AS_OK ||
+			// Migrations just treat these errors as successful no-ops:
+			rv == AS_ERR_RECORD_EXISTS || rv == AS_ERR_GENERATION;
+}
+
+
+// Records already applied from a retransmitted batch are harmless no-ops.
+bool
+immigration_insert_batch(immigration *immig, cf_node src, uint8_t *buf,
+		size_t buf_sz, uint32_t n_recs)
+{
+	if (n_recs == 0) {
+		cf_warning(AS_MIGRATE, "handle insert: empty batch");
+		return false;
+	}
+
+	const uint8_t *end = buf + buf_sz;
+	uint8_t *at = buf;
+
+	// Count received records, the first was counted with the msg.
+	cf_atomic_int_add(&immig->rsv.ns->migrate_record_receives,
+			(int64_t)n_recs - 1);
+
+	for (uint32_t i = 0; i < n_recs; i++) {
+		if (at + MIG_BATCH_REC_HDR_SZ > end) {
+			cf_warning(AS_MIGRATE, "handle insert: batch too short");
+			return false;
+		}
+
+		uint32_t info = *(uint32_t *)at;
+		at += sizeof(uint32_t);
+		uint32_t pickle_sz = *(uint32_t *)at;
+		at += sizeof(uint32_t);
+
+		if (pickle_sz > (size_t)(end - at)) {
+			cf_warning(AS_MIGRATE, "handle insert: batch record too big");
+			return false;
+		}
+
+		if (! immigration_insert_record(immig, src, at, pickle_sz, info)) {
+			return false;
+		}
+
+		at += pickle_sz;
+	}
+
+	return true;
+}
+
+
 void
 immigration_handle_done_request(cf_node src, msg *m)
 {
@@ -1441,6 +1960,9 @@ immigration_handle_done_request(cf_node src, msg *m)
 				cf_atomic_int_incr(&ns->migrate_rx_partitions_active);
 			}
 
+			ASD_PROBE3(migrate__immigrate_done, ns->ix, immig->rsv.p->id,
+					immig->src);
+
 			as_partition_immigrate_done(ns, immig->rsv.p->id,
 					immig->cluster_key, immig->src);
 		}
@@ -1558,15 +2080,22 @@ emigration_handle_insert_ack(cf_node src, msg *m)
 	emigration_reinsert_ctrl *ri_ctrl = NULL;
 	cf_mutex *vlock;
 
+	uint32_t acked_sz = 0;
+	uint64_t xmit_us = 0;
+
 	if (cf_shash_get_vlock(emig->reinsert_hash, &insert_id, (void **)&ri_ctrl,
 			&vlock) == CF_SHASH_OK) {
 		if (src == emig->dest) {
+			acked_sz = msg_get_wire_size(ri_ctrl->m);
+			xmit_us = ri_ctrl->xmit_us;
+
 			if (cf_atomic32_sub(&emig->bytes_emigrating,
-					(int32_t)msg_get_wire_size(ri_ctrl->m)) < 0) {
+					(int32_t)acked_sz) < 0) {
 				cf_warning(AS_MIGRATE, "bytes_emigrating less than zero");
 			}
 
 			as_fabric_msg_put(ri_ctrl->m);
+			cf_free(ri_ctrl->recs);
 			// At this point, the rt is *GONE*.
 			cf_shash_delete_lockfree(emig->reinsert_hash, &insert_id);
 		}
@@ -1577,11 +2106,47 @@ emigration_handle_insert_ack(cf_node src, msg *m)
 		cf_mutex_unlock(vlock);
 	}
 
+	if (xmit_us != 0) {
+		emigration_window_grow(emig, acked_sz, cf_getus() - xmit_us);
+	}
+
 	emigration_release(emig);
 	as_fabric_msg_put(m);
 }
 
 
+void
+emigration_handle_insert_overloaded(cf_node src, msg *m)
+{
+	uint32_t emig_id;
+
+	if (msg_get_uint32(m, MIG_FIELD_EMIG_ID, &emig_id) != 0) {
+		cf_warning(AS_MIGRATE, "insert overloaded: msg get for emig id failed");
+		as_fabric_msg_put(m);
+		return;
+	}
+
+	as_fabric_msg_put(m);
+
+	emigration *emig;
+
+	if (cf_rchash_get(g_emigration_hash, (void *)&emig_id, (void **)&emig) !=
+			CF_RCHASH_OK) {
+		return; // probably from a migration prior to the latest rebalance
+	}
+
+	if (src == emig->dest) {
+		emigration_window_shrink(emig, "destination overloaded");
+	}
+	else {
+		cf_warning(AS_MIGRATE, "insert overloaded: unexpected source %lx",
+				src);
+	}
+
+	emigration_release(emig);
+}
+
+
 void
 emigration_handle_ctrl_ack(cf_node src, msg *m, uint32_t op)
 {
@@ -1597,6 +2162,20 @@ emigration_handle_ctrl_ack(cf_node src, msg *m, uint32_t op)
 
 	msg_get_uint32(m, MIG_FIELD_FEATURES, &immig_features);
 
+	uint8_t *range_sums = NULL;
+	size_t range_sums_sz = 0;
+
+	if (op == OPERATION_START_ACK_OK &&
+			(immig_features & MIG_FEATURE_DELTA) != 0 &&
+			msg_get_buf(m, MIG_FIELD_RANGE_SUMMARY, &range_sums,
+					&range_sums_sz, MSG_GET_COPY_MALLOC) == 0 &&
+			range_sums_sz != MIG_RANGE_SUMMARY_SZ) {
+		cf_warning(AS_MIGRATE, "ctrl ack: bad range summary size %zu",
+				range_sums_sz);
+		cf_free(range_sums);
+		range_sums = NULL;
+	}
+
 	as_fabric_msg_put(m);
 
 	emigration *emig;
@@ -1604,6 +2183,17 @@ emigration_handle_ctrl_ack(cf_node src, msg *m, uint32_t op)
 	if (cf_rchash_get(g_emigration_hash, (void *)&emig_id, (void **)&emig) ==
 			CF_RCHASH_OK) {
 		if (emig->dest == src) {
+			if (op == OPERATION_START_ACK_OK) {
+				// Older nodes don't advertise - they get plain records.
+				emig->dest_features = immig_features;
+
+				// Keep the first summary - start may have been retransmitted.
+				if (range_sums != NULL &&
+						as_cas_ptr(&emig->dest_range_sums, NULL, range_sums)) {
+					range_sums = NULL;
+				}
+			}
+
 			if ((immig_features & MIG_FEATURE_MERGE) == 0) {
 				// TODO - rethink where this should go after further refactor.
 				if (op == OPERATION_START_ACK_OK && emig->meta_q) {
@@ -1624,6 +2214,55 @@ emigration_handle_ctrl_ack(cf_node src, msg *m, uint32_t op)
 		cf_detail(AS_MIGRATE, "ctrl ack (%d): can't find emig id %u", op,
 				emig_id);
 	}
+
+	cf_free(range_sums);
+}
+
+
+//==========================================================
+// Local helpers - delta migration.
+//
+
+// Each range's value is an order-independent sum of record fingerprints, so
+// equal sums mean (with high probability) the same digests, generations and
+// last-update-times on both nodes. Computed on demand - a walk of one
+// partition's index, no storage reads.
+uint64_t *
+range_summary_create(as_namespace *ns, as_index_tree *tree)
+{
+	range_summary_info rsi = {
+			.ns = ns,
+			.sums = cf_calloc(MIG_N_RANGES, sizeof(uint64_t))
+	};
+
+	as_index_reduce(tree, range_summary_reduce_fn, &rsi);
+
+	return rsi.sums;
+}
+
+
+bool
+range_summary_reduce_fn(as_index_ref *r_ref, void *udata)
+{
+	range_summary_info *rsi = (range_summary_info *)udata;
+	as_record *r = r_ref->r;
+
+	uint64_t fp;
+
+	memcpy(&fp, &r->keyd.digest[CF_DIGEST_KEY_SZ - sizeof(fp)], sizeof(fp));
+
+	fp ^= ((uint64_t)r->last_update_time << 16) | r->generation;
+
+	// Finalizer from splitmix64 - so sums don't cancel on simple patterns.
+	fp = (fp ^ (fp >> 30)) * 0xbf58476d1ce4e5b9UL;
+	fp = (fp ^ (fp >> 27)) * 0x94d049bb133111ebUL;
+	fp ^= fp >> 31;
+
+	rsi->sums[r->keyd.digest[MIG_RANGE_DIGEST_BYTE]] += fp;
+
+	as_record_done(r_ref, rsi->ns);
+
+	return true;
 }
 
 
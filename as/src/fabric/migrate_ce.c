@@ -45,7 +45,8 @@
 // Typedefs & constants.
 //
 
-const uint32_t MY_MIG_FEATURES = 0;
+const uint32_t MY_MIG_FEATURES = MIG_FEATURE_COMPRESS | MIG_FEATURE_BATCH |
+		MIG_FEATURE_DELTA | MIG_FEATURE_OVERLOAD_SIGNAL;
 
 
 //==========================================================
@@ -26,11 +26,13 @@
 
 #include "fabric/partition.h"
 
+#include <sched.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_atomic.h"
 #include "citrusleaf/cf_b64.h"
@@ -48,6 +50,36 @@
 #include "fabric/partition_balance.h"
 
 
+//==========================================================
+// Typedefs & constants.
+//
+
+// Lock-free reservations count themselves in a per-thread stripe, by epoch
+// parity, while they look at partition state - a writer dropping a tree waits
+// for these counts to drain before releasing it.
+#define N_READER_STRIPES 64
+
+typedef struct reader_stripe_s {
+	uint32_t n_readers[2];
+	uint8_t pad[56];
+} reader_stripe;
+
+COMPILER_ASSERT(sizeof(reader_stripe) == 64);
+
+
+//==========================================================
+// Globals.
+//
+
+static reader_stripe g_reader_stripes[N_READER_STRIPES]
+		__attribute__((aligned(64)));
+static uint32_t g_reader_epoch = 0;
+static uint32_t g_next_reader_stripe = 0;
+static cf_mutex g_wait_lock = CF_MUTEX_INIT;
+
+static __thread reader_stripe* t_reader_stripe = NULL;
+
+
 //==========================================================
 // Forward declarations.
 //
@@ -59,6 +91,12 @@ char partition_descriptor(const as_partition* p);
 int partition_get_replica_self_lockfree(const as_namespace* ns, uint32_t pid);
 bool should_working_master_own(const as_namespace* ns, uint32_t pid, uint32_t repl_ix);
 
+static uint32_t* reader_enter(void);
+static void reader_exit(uint32_t* n_readers);
+static uint32_t reader_sum(uint32_t parity);
+static int reserve_write_lockfree(as_partition* p, as_namespace* ns, as_partition_reservation* rsv, cf_node* node);
+static int reserve_read_lockfree(as_partition* p, as_namespace* ns, as_transaction* tr, cf_node* node);
+
 
 //==========================================================
 // Public API.
@@ -105,15 +143,16 @@ as_partition_shutdown(as_namespace* ns, uint32_t pid)
 		// partition lock under the record (sprig) lock.
 		as_index_tree_block(tree);
 
-		// If lucky, this remains locked and we complete shutdown.
-		cf_mutex_lock(&p->lock);
+		// If lucky, this remains locked and we complete shutdown. Lock as a
+		// writer so lock-free reservations also block.
+		as_partition_lock(p);
 
 		if (tree == p->tree) {
 			break; // lucky - same tree we blocked
 		}
 
 		// Bad luck - blocked a tree that just got switched, block the new one.
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 	}
 }
 
@@ -153,6 +192,7 @@ as_partition_freeze(as_partition* p)
 	p->n_nodes = 0;
 	p->n_replicas = 0;
 	p->n_dupl = 0;
+	p->n_unmigrated_hits = 0;
 
 	p->pending_emigrations = 0;
 	p->pending_lead_emigrations = 0;
@@ -225,6 +265,30 @@ as_partition_proxyee_redirect(as_namespace* ns, uint32_t pid)
 	return node;
 }
 
+// If this node is the settled final master, return a prole that may serve
+// reads in its place, else return 0. The prole proxies back if it turns out not
+// to have everything, and proxied reads are never steered again.
+cf_node
+as_partition_steer_read_node(as_namespace* ns, uint32_t pid)
+{
+	as_partition* p = &ns->partitions[pid];
+
+	cf_mutex_lock(&p->lock);
+
+	cf_node node = (cf_node)0;
+
+	if (g_config.self_node == p->replicas[0] &&
+			g_config.self_node == p->working_master &&
+			p->n_replicas > 1 && p->n_dupl == 0 &&
+			p->pending_emigrations == 0) {
+		node = p->replicas[1];
+	}
+
+	cf_mutex_unlock(&p->lock);
+
+	return node;
+}
+
 void
 as_partition_get_replicas_master_str(cf_dyn_buf* db)
 {
@@ -320,6 +384,27 @@ as_partition_get_replica_stats(as_namespace* ns, repl_stats* p_stats)
 	}
 }
 
+// Returns once every lock-free reservation that may have seen partition state
+// from before the call has finished. Call after unpublishing a tree, before
+// releasing the partition's reference to it.
+void
+as_partition_wait_for_readers(void)
+{
+	cf_mutex_lock(&g_wait_lock);
+
+	// Flip twice - a reader that sampled the epoch just before a flip may count
+	// itself under the old parity after we've checked it.
+	for (uint32_t i = 0; i < 2; i++) {
+		uint32_t parity = as_faa_uint32(&g_reader_epoch, 1) & 1;
+
+		while (reader_sum(parity) != 0) {
+			sched_yield();
+		}
+	}
+
+	cf_mutex_unlock(&g_wait_lock);
+}
+
 // TODO - what if partition is unavailable?
 void
 as_partition_reserve(as_namespace* ns, uint32_t pid,
@@ -364,35 +449,36 @@ as_partition_reserve_write(as_namespace* ns, uint32_t pid,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	// Normally no lock - only if a writer is (or was just) busy.
+	uint32_t* n_readers = reader_enter();
+	uint32_t seq = cf_atomic32_get(p->seq);
 
-	// If this partition is frozen, return.
-	if (p->n_replicas == 0) {
-		if (node) {
-			*node = (cf_node)0;
-		}
+	if ((seq & 1) == 0) {
+		as_fence_acq();
 
-		cf_mutex_unlock(&p->lock);
-		return -2;
-	}
+		int result = reserve_write_lockfree(p, ns, rsv, node);
 
-	cf_node best_node = find_best_node(p, false);
+		as_fence_acq();
 
-	if (node) {
-		*node = best_node;
-	}
+		if (cf_atomic32_get(p->seq) == seq) {
+			reader_exit(n_readers);
+			return result;
+		}
 
-	// If this node is not the appropriate one, return.
-	if (best_node != g_config.self_node) {
-		cf_mutex_unlock(&p->lock);
-		return -1;
+		if (result == 0) {
+			as_index_tree_release(ns, rsv->tree);
+		}
 	}
 
-	partition_reserve_lockfree(p, ns, rsv);
+	reader_exit(n_readers);
+
+	cf_mutex_lock(&p->lock);
+
+	int result = reserve_write_lockfree(p, ns, rsv, node);
 
 	cf_mutex_unlock(&p->lock);
 
-	return 0;
+	return result;
 }
 
 // Returns:
@@ -405,38 +491,36 @@ as_partition_reserve_read_tr(as_namespace* ns, uint32_t pid, as_transaction* tr,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	// Normally no lock - see as_partition_reserve_write().
+	uint32_t* n_readers = reader_enter();
+	uint32_t seq = cf_atomic32_get(p->seq);
 
-	// Handle unavailable partition.
-	if (p->n_replicas == 0) {
-		int result = partition_reserve_unavailable(ns, p, tr, node);
+	if ((seq & 1) == 0) {
+		as_fence_acq();
 
-		if (result == 0) {
-			partition_reserve_lockfree(p, ns, &tr->rsv);
-		}
+		int result = reserve_read_lockfree(p, ns, tr, node);
 
-		cf_mutex_unlock(&p->lock);
-		return result;
-	}
+		as_fence_acq();
 
-	cf_node best_node = find_best_node(p,
-			! partition_reserve_promote(ns, p, tr));
+		if (cf_atomic32_get(p->seq) == seq) {
+			reader_exit(n_readers);
+			return result;
+		}
 
-	if (node) {
-		*node = best_node;
+		if (result == 0) {
+			as_index_tree_release(ns, tr->rsv.tree);
+		}
 	}
 
-	// If this node is not the appropriate one, return.
-	if (best_node != g_config.self_node) {
-		cf_mutex_unlock(&p->lock);
-		return -1;
-	}
+	reader_exit(n_readers);
 
-	partition_reserve_lockfree(p, ns, &tr->rsv);
+	cf_mutex_lock(&p->lock);
+
+	int result = reserve_read_lockfree(p, ns, tr, node);
 
 	cf_mutex_unlock(&p->lock);
 
-	return 0;
+	return result;
 }
 
 int
@@ -752,11 +836,14 @@ void
 partition_reserve_lockfree(as_partition* p, as_namespace* ns,
 		as_partition_reservation* rsv)
 {
-	as_index_tree_reserve(p->tree);
+	// Read once - may be called without lock, see reserve_write_lockfree().
+	as_index_tree* tree = p->tree;
+
+	as_index_tree_reserve(tree);
 
 	rsv->ns = ns;
 	rsv->p = p;
-	rsv->tree = p->tree;
+	rsv->tree = tree;
 	rsv->regime = p->regime;
 	rsv->n_dupl = p->n_dupl;
 
@@ -808,3 +895,108 @@ should_working_master_own(const as_namespace* ns, uint32_t pid,
 
 	return find_self_in_replicas(p) == (int)repl_ix || p->immigrators[repl_ix];
 }
+
+
+//==========================================================
+// Local helpers - lock-free reservations.
+//
+
+static uint32_t*
+reader_enter(void)
+{
+	if (t_reader_stripe == NULL) {
+		t_reader_stripe = &g_reader_stripes[
+				as_faa_uint32(&g_next_reader_stripe, 1) % N_READER_STRIPES];
+	}
+
+	uint32_t* n_readers = &t_reader_stripe->n_readers[
+			as_load_uint32(&g_reader_epoch) & 1];
+
+	as_incr_uint32(n_readers); // full barrier - state reads come after
+
+	return n_readers;
+}
+
+static void
+reader_exit(uint32_t* n_readers)
+{
+	as_decr_uint32(n_readers); // full barrier - state reads came before
+}
+
+static uint32_t
+reader_sum(uint32_t parity)
+{
+	uint32_t sum = 0;
+
+	for (uint32_t i = 0; i < N_READER_STRIPES; i++) {
+		sum += as_load_uint32(&g_reader_stripes[i].n_readers[parity]);
+	}
+
+	return sum;
+}
+
+// Called either with partition lock, or lock-free inside a reader section - in
+// which case partition state may be torn, and caller validates p->seq before
+// trusting the result. Trees are safe to reserve either way - dropped trees
+// outlive reader sections.
+static int
+reserve_write_lockfree(as_partition* p, as_namespace* ns,
+		as_partition_reservation* rsv, cf_node* node)
+{
+	// If this partition is frozen, return.
+	if (p->n_replicas == 0) {
+		if (node) {
+			*node = (cf_node)0;
+		}
+
+		return -2;
+	}
+
+	cf_node best_node = find_best_node(p, false);
+
+	if (node) {
+		*node = best_node;
+	}
+
+	// If this node is not the appropriate one, return.
+	if (best_node != g_config.self_node) {
+		return -1;
+	}
+
+	partition_reserve_lockfree(p, ns, rsv);
+
+	return 0;
+}
+
+// See reserve_write_lockfree().
+static int
+reserve_read_lockfree(as_partition* p, as_namespace* ns, as_transaction* tr,
+		cf_node* node)
+{
+	// Handle unavailable partition.
+	if (p->n_replicas == 0) {
+		int result = partition_reserve_unavailable(ns, p, tr, node);
+
+		if (result == 0) {
+			partition_reserve_lockfree(p, ns, &tr->rsv);
+		}
+
+		return result;
+	}
+
+	cf_node best_node = find_best_node(p,
+			! partition_reserve_promote(ns, p, tr));
+
+	if (node) {
+		*node = best_node;
+	}
+
+	// If this node is not the appropriate one, return.
+	if (best_node != g_config.self_node) {
+		return -1;
+	}
+
+	partition_reserve_lockfree(p, ns, &tr->rsv);
+
+	return 0;
+}
@@ -32,12 +32,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_atomic.h"
+#include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_hash_math.h"
 #include "citrusleaf/cf_queue.h"
 
 #include "cf_mutex.h"
+#include "cf_thread.h"
 #include "log.h"
 #include "node.h"
 
@@ -58,6 +61,17 @@
 
 const as_partition_version ZERO_VERSION = { 0 };
 
+#define MAX_BALANCE_THREADS 8
+#define PIDS_PER_TABLE_JOB 256
+
+// Work shared by balance threads - units are pid ranges or namespaces.
+typedef struct balance_job_s {
+	uint32_t next_unit;
+	uint32_t n_units;
+	const uint64_t* hashed_nodes;
+	cf_queue* mqs; // per namespace, so workers needn't share one
+} balance_job;
+
 
 //==========================================================
 // Globals.
@@ -96,9 +110,13 @@ extern cf_node* as_exchange_succession_unsafe();
 // Helpers - generic.
 void create_trees(as_namespace* ns, as_partition* p);
 void drop_trees(as_namespace* ns, as_partition* p);
+void run_balance_workers(cf_thread_run_fn run, balance_job* job);
 
 // Helpers - balance partitions.
 void fill_global_tables();
+void* run_fill_global_tables(void* udata);
+void fill_global_table_rows(uint32_t start_pid, uint32_t end_pid, const uint64_t* hashed_nodes);
+void* run_balance_namespaces(void* udata);
 void set_replication_factor_ap(as_namespace* ns);
 int find_working_master_ap(const as_partition* p, const sl_ix_t* ns_sl_ix, const as_namespace* ns);
 uint32_t find_duplicates_ap(const as_partition* p, const cf_node* ns_node_seq, const sl_ix_t* ns_sl_ix, const struct as_namespace_s* ns, uint32_t working_master_n, cf_node dupls[]);
@@ -158,8 +176,8 @@ as_partition_balance_synchronize_migrations()
 		for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
 			as_partition* p = &ns->partitions[pid];
 
-			cf_mutex_lock(&p->lock);
-			cf_mutex_unlock(&p->lock);
+			as_partition_lock(p);
+			as_partition_unlock(p);
 		}
 	}
 
@@ -232,12 +250,12 @@ as_partition_balance_revert_to_orphan()
 		for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
 			as_partition* p = &ns->partitions[pid];
 
-			cf_mutex_lock(&p->lock);
+			as_partition_lock(p);
 
 			as_partition_freeze(p);
 			as_partition_isolate_version(ns, p);
 
-			cf_mutex_unlock(&p->lock);
+			as_partition_unlock(p);
 		}
 
 		ns->n_unavailable_partitions = AS_PARTITIONS;
@@ -265,22 +283,54 @@ as_partition_balance()
 	g_cluster_size = as_exchange_cluster_size();
 	g_succession = as_exchange_succession_unsafe();
 
+	uint64_t start_us = cf_getus();
+
 	// Each partition separately shuffles the node succession list to generate
 	// its own node sequence.
 	fill_global_tables();
 
+	uint64_t tables_done_us = cf_getus();
+
+	// Namespaces are independent - balance them in parallel, each queueing its
+	// own migrations, then combine the queues in namespace order.
+	cf_queue mqs[g_config.n_namespaces];
+
+	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
+		cf_queue_init(&mqs[ns_ix], sizeof(pb_task), AS_PARTITIONS, false);
+	}
+
+	balance_job job = {
+			.n_units = g_config.n_namespaces,
+			.mqs = mqs
+	};
+
+	as_set_index_balance_lock();
+
+	run_balance_workers(run_balance_namespaces, &job);
+
+	as_set_index_balance_unlock();
+
 	cf_queue mq;
 
 	cf_queue_init(&mq, sizeof(pb_task), g_config.n_namespaces * AS_PARTITIONS,
 			false);
 
-	as_set_index_balance_lock();
-
 	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
-		balance_namespace(g_config.namespaces[ns_ix], &mq);
+		pb_task task;
+
+		while (cf_queue_pop(&mqs[ns_ix], &task, CF_QUEUE_NOWAIT) ==
+				CF_QUEUE_OK) {
+			cf_queue_push(&mq, &task);
+		}
+
+		cf_queue_destroy(&mqs[ns_ix]);
 	}
 
-	as_set_index_balance_unlock();
+	uint64_t balance_done_us = cf_getus();
+
+	cf_info(AS_PARTITION, "balance took %lu us - node tables %lu us, %u namespaces %lu us",
+			balance_done_us - start_us, tables_done_us - start_us,
+			g_config.n_namespaces, balance_done_us - tables_done_us);
 
 	prepare_for_appeals();
 
@@ -323,11 +373,11 @@ as_partition_balance_remaining_migrations()
 bool
 as_partition_pending_migrations(as_partition* p)
 {
-	cf_mutex_lock(&p->lock);
+	as_partition_lock(p);
 
 	bool pending = p->pending_immigrations + p->pending_emigrations != 0;
 
-	cf_mutex_unlock(&p->lock);
+	as_partition_unlock(p);
 
 	return pending;
 }
@@ -338,19 +388,19 @@ as_partition_emigrate_done(as_namespace* ns, uint32_t pid,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	as_partition_lock(p);
 
 	if (! g_allow_migrations || orig_cluster_key != as_exchange_cluster_key()) {
 		cf_debug(AS_PARTITION, "{%s:%u} emigrate_done - cluster key mismatch",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return;
 	}
 
 	if (p->pending_emigrations == 0) {
 		cf_warning(AS_PARTITION, "{%s:%u} emigrate_done - no pending emigrations",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return;
 	}
 
@@ -398,7 +448,7 @@ as_partition_emigrate_done(as_namespace* ns, uint32_t pid,
 		}
 	}
 
-	cf_mutex_unlock(&p->lock);
+	as_partition_unlock(p);
 
 	if (w_ix >= 0) {
 		while (cf_queue_pop(&mq, &task, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
@@ -415,13 +465,13 @@ as_partition_immigrate_start(as_namespace* ns, uint32_t pid,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	as_partition_lock(p);
 
 	if (! g_allow_migrations || orig_cluster_key != as_exchange_cluster_key() ||
 			immigrate_yield()) {
 		cf_debug(AS_PARTITION, "{%s:%u} immigrate_start - cluster key mismatch",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_AGAIN;
 	}
 
@@ -431,13 +481,13 @@ as_partition_immigrate_start(as_namespace* ns, uint32_t pid,
 		cf_debug(AS_PARTITION, "{%s:%u} immigrate_start - exceeded max_num_incoming",
 				ns->name, pid);
 		cf_atomic32_decr(&g_migrate_num_incoming);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_AGAIN;
 	}
 
 	if (! partition_immigration_is_valid(p, source_node, ns, "start")) {
 		cf_atomic32_decr(&g_migrate_num_incoming);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_FAIL;
 	}
 
@@ -446,7 +496,7 @@ as_partition_immigrate_start(as_namespace* ns, uint32_t pid,
 		as_storage_save_pmeta(ns, p);
 	}
 
-	cf_mutex_unlock(&p->lock);
+	as_partition_unlock(p);
 
 	return AS_MIGRATE_OK;
 }
@@ -457,19 +507,19 @@ as_partition_immigrate_done(as_namespace* ns, uint32_t pid,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	as_partition_lock(p);
 
 	if (! g_allow_migrations || orig_cluster_key != as_exchange_cluster_key()) {
 		cf_debug(AS_PARTITION, "{%s:%u} immigrate_done - cluster key mismatch",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_FAIL;
 	}
 
 	cf_atomic32_decr(&g_migrate_num_incoming);
 
 	if (! partition_immigration_is_valid(p, source_node, ns, "done")) {
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_FAIL;
 	}
 
@@ -495,7 +545,7 @@ as_partition_immigrate_done(as_namespace* ns, uint32_t pid,
 			cf_atomic32_incr(&g_partition_generation);
 		}
 
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_OK;
 	}
 
@@ -515,7 +565,7 @@ as_partition_immigrate_done(as_namespace* ns, uint32_t pid,
 	}
 
 	if (p->pending_immigrations != 0) {
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_OK;
 	}
 
@@ -546,7 +596,7 @@ as_partition_immigrate_done(as_namespace* ns, uint32_t pid,
 		}
 	}
 
-	cf_mutex_unlock(&p->lock);
+	as_partition_unlock(p);
 
 	while (cf_queue_pop(&mq, &task, 0) == CF_QUEUE_OK) {
 		as_migrate_emigrate(&task);
@@ -563,19 +613,19 @@ as_partition_migrations_all_done(as_namespace* ns, uint32_t pid,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	as_partition_lock(p);
 
 	if (! g_allow_migrations || orig_cluster_key != as_exchange_cluster_key()) {
 		cf_debug(AS_PARTITION, "{%s:%u} all_done - cluster key mismatch",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_FAIL;
 	}
 
 	if (p->pending_emigrations != 0) {
 		cf_debug(AS_PARTITION, "{%s:%u} all_done - eagain",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return AS_MIGRATE_AGAIN;
 	}
 
@@ -592,7 +642,7 @@ as_partition_migrations_all_done(as_namespace* ns, uint32_t pid,
 		}
 	}
 
-	cf_mutex_unlock(&p->lock);
+	as_partition_unlock(p);
 
 	return AS_MIGRATE_OK;
 }
@@ -603,18 +653,18 @@ as_partition_signal_done(as_namespace* ns, uint32_t pid,
 {
 	as_partition* p = &ns->partitions[pid];
 
-	cf_mutex_lock(&p->lock);
+	as_partition_lock(p);
 
 	if (! g_allow_migrations || orig_cluster_key != as_exchange_cluster_key()) {
 		cf_debug(AS_PARTITION, "{%s:%u} signal_done - cluster key mismatch",
 				ns->name, pid);
-		cf_mutex_unlock(&p->lock);
+		as_partition_unlock(p);
 		return;
 	}
 
 	cf_atomic_int_decr(&ns->migrate_signals_remaining);
 
-	cf_mutex_unlock(&p->lock);
+	as_partition_unlock(p);
 }
 
 
@@ -655,13 +705,41 @@ drop_trees(as_namespace* ns, as_partition* p)
 		return; // CP signals can get here - 0e/0r versions are witnesses
 	}
 
-	as_index_tree_release(ns, p->tree);
+	as_index_tree* tree = p->tree;
+
 	p->tree = NULL;
 
+	// Lock-free reservations may have just picked up the tree.
+	as_partition_wait_for_readers();
+	as_index_tree_release(ns, tree);
+
 	// TODO - consider p->n_tombstones?
 	cf_atomic32_set(&p->max_void_time, 0);
 }
 
+// Returns when all of job's units are done. A single unit runs inline.
+void
+run_balance_workers(cf_thread_run_fn run, balance_job* job)
+{
+	uint32_t n_threads = job->n_units < MAX_BALANCE_THREADS ?
+			job->n_units : MAX_BALANCE_THREADS;
+
+	if (n_threads <= 1) {
+		run(job);
+		return;
+	}
+
+	cf_tid tids[n_threads];
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		tids[i] = cf_thread_create_joinable(run, job);
+	}
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		cf_thread_join(tids[i]);
+	}
+}
+
 
 //==========================================================
 // Local helpers - balance partitions.
@@ -721,8 +799,37 @@ fill_global_tables()
 				sizeof(cf_node));
 	}
 
+	// Rows are independent - build the tables in parallel by pid range.
+	balance_job job = {
+			.n_units = AS_PARTITIONS / PIDS_PER_TABLE_JOB,
+			.hashed_nodes = hashed_nodes
+	};
+
+	run_balance_workers(run_fill_global_tables, &job);
+}
+
+void*
+run_fill_global_tables(void* udata)
+{
+	balance_job* job = (balance_job*)udata;
+	uint32_t unit;
+
+	while ((unit = as_faa_uint32(&job->next_unit, 1)) < job->n_units) {
+		uint32_t start_pid = unit * PIDS_PER_TABLE_JOB;
+
+		fill_global_table_rows(start_pid, start_pid + PIDS_PER_TABLE_JOB,
+				job->hashed_nodes);
+	}
+
+	return NULL;
+}
+
+void
+fill_global_table_rows(uint32_t start_pid, uint32_t end_pid,
+		const uint64_t* hashed_nodes)
+{
 	// Build the node sequence table.
-	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+	for (uint32_t pid = start_pid; pid < end_pid; pid++) {
 		inter_hash h;
 
 		h.hashed_pid = g_hashed_pids[pid];
@@ -756,6 +863,19 @@ fill_global_tables()
 	}
 }
 
+void*
+run_balance_namespaces(void* udata)
+{
+	balance_job* job = (balance_job*)udata;
+	uint32_t ns_ix;
+
+	while ((ns_ix = as_faa_uint32(&job->next_unit, 1)) < job->n_units) {
+		balance_namespace(g_config.namespaces[ns_ix], &job->mqs[ns_ix]);
+	}
+
+	return NULL;
+}
+
 void
 balance_namespace_ap(as_namespace* ns, cf_queue* mq)
 {
@@ -846,7 +966,7 @@ balance_namespace_ap(as_namespace* ns, cf_queue* mq)
 				}
 			}
 
-			cf_mutex_lock(&p->lock);
+			as_partition_lock(p);
 
 			p->working_master = (cf_node)0;
 
@@ -854,6 +974,7 @@ balance_namespace_ap(as_namespace* ns, cf_queue* mq)
 			memcpy(p->replicas, ns_node_seq, p->n_replicas * sizeof(cf_node));
 
 			p->n_dupl = 0;
+			p->n_unmigrated_hits = 0;
 
 			p->pending_emigrations = 0;
 			p->pending_lead_emigrations = 0;
@@ -969,7 +1090,7 @@ balance_namespace_ap(as_namespace* ns, cf_queue* mq)
 		for (uint32_t pid = start_pid; pid < end_pid; pid++) {
 			as_partition* p = &ns->partitions[pid];
 
-			cf_mutex_unlock(&p->lock);
+			as_partition_unlock(p);
 		}
 	}
 
@@ -22,10 +22,13 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <stdexcept>
 
+#include <s2cellid.h>
+#include <s2latlng.h>
 #include <s2regioncoverer.h>
 
 extern "C" {
@@ -68,6 +71,95 @@ public:
 	S2Region * m_regionp;
 };
 
+// Helpers for recognizing the canonical point form without a JSON parse.
+
+static const char *
+skip_ws(const char * p, const char * end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+		++p;
+	}
+	return p;
+}
+
+static const char *
+skip_token(const char * p, const char * end, const char * token)
+{
+	size_t len = strlen(token);
+
+	p = skip_ws(p, end);
+
+	if ((size_t)(end - p) < len || memcmp(p, token, len) != 0) {
+		return NULL;
+	}
+	return p + len;
+}
+
+static const char *
+parse_number(const char * p, const char * end, double * valp)
+{
+	p = skip_ws(p, end);
+
+	// Only plain JSON number characters - strtod() also takes hex, inf, etc.
+	const char * q = p;
+
+	while (q < end && ((*q >= '0' && *q <= '9') || *q == '-' || *q == '+' ||
+			*q == '.' || *q == 'e' || *q == 'E')) {
+		++q;
+	}
+
+	// Hex would make strtod() read past what we've checked.
+	if (q == p || q == end || *q == 'x' || *q == 'X') {
+		return NULL;
+	}
+
+	// Safe - the number is followed by a non-number character in the buffer.
+	char * numend;
+	*valp = strtod(p, &numend);
+
+	return numend == q ? q : NULL;
+}
+
+// Recognizes {"type": "Point", "coordinates": [lng, lat]} with any
+// whitespace. Returns false, without warning, for anything else.
+static bool
+parse_simple_point(const char * buf, size_t bufsz, uint64_t * cellidp)
+{
+	const char * end = buf + bufsz;
+	const char * p = buf;
+	double lng;
+	double lat;
+
+	if (! (p = skip_token(p, end, "{")) ||
+			! (p = skip_token(p, end, "\"type\"")) ||
+			! (p = skip_token(p, end, ":")) ||
+			! (p = skip_token(p, end, "\"Point\"")) ||
+			! (p = skip_token(p, end, ",")) ||
+			! (p = skip_token(p, end, "\"coordinates\"")) ||
+			! (p = skip_token(p, end, ":")) ||
+			! (p = skip_token(p, end, "[")) ||
+			! (p = parse_number(p, end, &lng)) ||
+			! (p = skip_token(p, end, ",")) ||
+			! (p = parse_number(p, end, &lat)) ||
+			! (p = skip_token(p, end, "]")) ||
+			! (p = skip_token(p, end, "}"))) {
+		return false;
+	}
+
+	if (skip_ws(p, end) != end) {
+		return false;
+	}
+
+	S2LatLng latlng = S2LatLng::FromDegrees(lat, lng);
+
+	if (! latlng.is_valid()) {
+		return false; // let the full parser report it
+	}
+
+	*cellidp = S2CellId::FromPoint(latlng.ToPoint()).id();
+	return true;
+}
+
 bool
 geo_parse(const as_namespace * ns,
 		  const char * buf,
@@ -75,6 +167,12 @@ geo_parse(const as_namespace * ns,
 		  uint64_t * cellidp,
 		  geo_region_t * regionp)
 {
+	// Most stored GeoJSON is simple points - skip the JSON parser for them.
+	if (parse_simple_point(buf, bufsz, cellidp)) {
+		*regionp = NULL;
+		return true;
+	}
+
 	try
 	{
 		PointRegionHandler prhandler(ns);
@@ -168,6 +266,50 @@ geo_region_cover(const as_namespace * ns,
 	}
 }
 
+// Cells wholly inside the region - points in them need no exact check.
+bool
+geo_region_interior(const as_namespace * ns,
+					geo_region_t region,
+					uint32_t maxnumcells,
+					uint64_t * cellminp,
+					uint64_t * cellmaxp,
+					uint32_t * numcellsp)
+{
+	try
+	{
+		S2Region * regionp = (S2Region *) region;
+
+		S2RegionCoverer coverer;
+		coverer.set_min_level(ns->geo2dsphere_within_min_level);
+		coverer.set_max_level(ns->geo2dsphere_within_max_level);
+		coverer.set_max_cells(maxnumcells);
+		coverer.set_level_mod(ns->geo2dsphere_within_level_mod);
+
+		vector<S2CellId> interior;
+		coverer.GetInteriorCovering(*regionp, &interior);
+
+		// Interior coverings can't overflow like coverings, but be safe.
+		if (interior.size() > maxnumcells) {
+			interior.resize(maxnumcells);
+		}
+
+		for (size_t ii = 0; ii < interior.size(); ++ii)
+		{
+			cellminp[ii] = interior[ii].range_min().id();
+			cellmaxp[ii] = interior[ii].range_max().id();
+		}
+
+		*numcellsp = interior.size();
+		return true;
+	}
+	catch (exception const & ex)
+	{
+		cf_warning(AS_GEO, (char *) "geo_region_interior failed: %s",
+				   ex.what());
+		return false;
+	}
+}
+
 bool
 geo_point_centers(uint64_t cellidval,
 				  uint32_t maxnumcenters,
@@ -44,6 +44,7 @@
 #include "citrusleaf/cf_byte_order.h"
 #include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_digest.h"
+#include "citrusleaf/cf_hash_math.h"
 #include "citrusleaf/cf_ll.h"
 
 #include "arenax.h"
@@ -76,6 +77,7 @@
 #include "query/query_manager.h"
 #include "sindex/sindex.h"
 #include "sindex/sindex_tree.h"
+#include "storage/storage.h"
 #include "transaction/rw_utils.h"
 #include "transaction/udf.h"
 #include "transaction/write.h"
@@ -99,10 +101,111 @@ typedef enum {
 #define INIT_BUF_BUILDER_SIZE (1024U * 1024U * 7U / 4U) // 1.75M
 #define QUERY_CHUNK_LIMIT (1024U * 1024U)
 
+// Chunks a conn_query_job may queue while its socket is busy.
+#define MAX_PENDING_CHUNKS 8
+
 #define MAX_ACTIVE_TRANSACTIONS 200
 
 #define DEFAULT_TTL_NS 1000000000 // 1 second
 
+// Device-order PI queries - number of index entries per prefetched chunk.
+#define DEVICE_ORDER_CHUNK_SIZE 1024
+
+// Region query coverings are cached - set-associative, LRU within a set.
+#define GEO_CACHE_N_SETS 1024
+#define GEO_CACHE_N_WAYS 4
+
+// Points in a region's interior cells match without the exact S2 check.
+#define MAX_INTERIOR_CELLS 64
+
+typedef struct geo_cache_ele_s {
+	uint64_t key; // 0 means empty
+	uint32_t last_used;
+	uint32_t n_r;
+	as_query_range_start_end* r; // sorted
+	uint32_t n_interior;
+	as_query_range_start_end* interior; // sorted
+} geo_cache_ele;
+
+typedef struct geo_cache_set_s {
+	cf_mutex lock;
+	geo_cache_ele eles[GEO_CACHE_N_WAYS];
+} geo_cache_set;
+
+// Covering depends on these as well as the region itself.
+typedef struct geo_cache_cfg_s {
+	uint32_t ns_ix;
+	uint16_t min_level;
+	uint16_t max_level;
+	uint16_t max_cells;
+	uint16_t level_mod;
+} geo_cache_cfg;
+
+// Basic si-query responses are cached per partition - set-associative, LRU
+// within a set. An entry is good while its partition's record writes, sindex
+// changes and version are as they were when it was filled.
+#define RESULT_CACHE_N_SETS 4096
+#define RESULT_CACHE_N_WAYS 4
+
+typedef struct result_cache_stamp_s {
+	uint64_t n_writes;
+	uint64_t n_si_mods;
+	as_partition_version version;
+} result_cache_stamp;
+
+typedef struct result_cache_ele_s {
+	uint64_t key; // 0 means empty
+	uint32_t ns_ix;
+	uint32_t last_used;
+	result_cache_stamp stamp;
+	uint32_t min_void_time; // 0 means no record in entry expires
+	uint32_t n_recs;
+	uint32_t sz;
+	uint8_t* buf;
+} result_cache_ele;
+
+typedef struct result_cache_set_s {
+	cf_mutex lock;
+	result_cache_ele eles[RESULT_CACHE_N_WAYS];
+} result_cache_set;
+
+// Background queries - internal transactions are enqueued in batches.
+#define BG_TR_BATCH_SIZE 32
+
+typedef struct bg_tr_batch_s {
+	as_query_job* _job;
+	uint32_t* n_active_tr;
+	uint32_t n_trs;
+	as_transaction trs[BG_TR_BATCH_SIZE];
+} bg_tr_batch;
+
+// Wire size of an integer range - start and end, each length-prefixed.
+#define INTEGER_RANGE_SZ ((sizeof(uint32_t) * 2) + (sizeof(uint64_t) * 2))
+
+// Index intersection - drives a reduce, skipping records not in the set.
+typedef struct and_filter_s {
+	as_query_job* _job;
+	const cf_arenax_handle* handles; // sorted
+	uint32_t n_handles;
+	as_sindex_reduce_fn cb;
+	void* udata;
+} and_filter;
+
+// Top-K basic queries - responses are held in memory until the job finishes.
+#define MAX_TOP_K (10 * 1024)
+#define TOP_K_DESCENDING 0x01
+
+
+//==========================================================
+// Globals.
+//
+
+static geo_cache_set g_geo_cache[GEO_CACHE_N_SETS];
+static uint32_t g_geo_cache_tick = 0;
+
+static result_cache_set g_result_cache[RESULT_CACHE_N_SETS];
+static uint32_t g_result_cache_tick = 0;
+
 
 //==========================================================
 // Forward declarations.
@@ -126,6 +229,7 @@ static query_type get_query_type(const as_transaction* tr);
 static bool get_query_set(const as_transaction* tr, as_namespace* ns, char* set_name, uint16_t* set_id);
 static bool get_query_pids(const as_transaction* tr, as_query_pid** p_pids, uint16_t* n_pids_requested);
 static bool get_query_range(const as_transaction* tr, as_namespace* ns, as_query_range** range_r);
+static bool get_query_and_ranges(const as_transaction* tr, as_query_job* _job);
 static bool get_query_rps(const as_transaction* tr, uint32_t* rps);
 
 static bool get_query_socket_timeout(const as_transaction* tr, int32_t* timeout);
@@ -134,16 +238,29 @@ static bool get_query_sample_max(const as_transaction* tr, uint64_t* sample_max)
 static bool get_query_filter_exp(const as_transaction* tr, as_exp** exp);
 
 static bool range_from_msg_integer(const uint8_t* data, as_query_range* range, uint32_t len);
-static bool range_from_msg_string(const uint8_t* data, as_query_range* range, uint32_t len);
+static bool range_from_msg_string(const as_namespace* ns, const uint8_t* data, as_query_range* range, uint32_t len);
+static bool range_from_msg_ordered_string(const as_namespace* ns, const char* startp, uint32_t startl, const uint8_t* data, uint32_t len, as_query_range* range);
 static bool range_from_msg_geojson(as_namespace* ns, const uint8_t* data, as_query_range* range, uint32_t len);
 static void sort_geo_range(as_query_geo_range* geo);
+static void set_geo_interior(as_namespace* ns, as_query_geo_range* geo);
+static bool point_in_interior(const as_query_geo_range* geo, uint64_t cellid);
+static uint64_t geo_cache_key(const as_namespace* ns, const char* json, uint32_t len);
+static bool geo_cache_get(uint64_t key, as_query_geo_range* geo);
+static void geo_cache_put(uint64_t key, const as_query_geo_range* geo);
 
 static bool find_sindex(as_query_job* _job);
+static bool find_and_sindexes(as_query_job* _job);
+static void query_sindex_reduce(as_query_job* _job, as_partition_reservation* rsv, int64_t bval, cf_digest* keyd, as_sindex_reduce_fn cb, void* udata);
+static uint32_t collect_and_handles(as_query_job* _job, uint32_t pid, cf_arenax_handle** handles_r);
+static bool and_filter_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata);
+static int handle_cmp(const void* pa, const void* pb);
 static bool validate_background_query_rps(const as_namespace* ns, uint32_t* rps);
+static void flush_bg_tr_batch(bg_tr_batch* batch);
 
 static size_t send_blocking_response_chunk(as_file_handle* fd_h, uint8_t* buf, size_t size, int32_t timeout, bool compress, as_proto_comp_stat* comp_stat);
 
 static bool record_matches_query(as_query_job* _job, as_storage_rd* rd);
+static bool record_matches_and_ranges(const as_query_job* _job, as_storage_rd* rd);
 static bool record_matches_query_cdt(as_query_job* _job, const as_bin* b);
 static bool match_mapkeys_foreach(msgpack_in* key, msgpack_in* val, void* udata);
 static bool match_mapvalues_foreach(msgpack_in* key, msgpack_in* val, void* udata);
@@ -157,11 +274,30 @@ static bool match_geojson_element(const as_query_job* _job, msgpack_in* element)
 // Inlines & macros.
 //
 
+static inline int
+strings_cmp(const char* s1, size_t len1, const char* s2, size_t len2)
+{
+	int cmp = memcmp(s1, s2, len1 < len2 ? len1 : len2);
+
+	if (cmp != 0) {
+		return cmp;
+	}
+
+	return len1 < len2 ? -1 : (len1 > len2 ? 1 : 0);
+}
+
 static inline bool
-strings_match(const as_query_range* range, const char* str, size_t len)
+strings_match(const as_namespace* ns, const as_query_range* range,
+		const char* str, size_t len)
 {
+	if (range->str_ordered) {
+		return strings_cmp(range->str_buf, range->str_len, str, len) <= 0 &&
+				strings_cmp(str, len, range->str_buf + range->str_len,
+						range->str_end_len) <= 0;
+	}
+
 	return range->str_len == len &&
-			range->u.r.start == as_sindex_string_to_bval(str, len) &&
+			range->u.r.start == as_sindex_string_to_bval(ns, str, len) &&
 			memcmp(range->str_stub, str, len < sizeof(range->str_stub) ?
 					len : sizeof(range->str_stub)) == 0;
 }
@@ -477,8 +613,9 @@ get_query_range(const as_transaction* tr, as_namespace* ns,
 	uint8_t n_ranges = *data++;
 	len--;
 
-	if (n_ranges != 1) {
-		cf_warning(AS_QUERY, "%u ranges - only 1 supported", n_ranges);
+	if (n_ranges == 0 || n_ranges > 1 + AS_QUERY_MAX_AND_RANGES) {
+		cf_warning(AS_QUERY, "%u ranges - only 1 to %u supported", n_ranges,
+				1 + AS_QUERY_MAX_AND_RANGES);
 		return false;
 	}
 
@@ -523,7 +660,7 @@ get_query_range(const as_transaction* tr, as_namespace* ns,
 		success = range_from_msg_integer(data, range, len);
 		break;
 	case AS_PARTICLE_TYPE_STRING:
-		success = range_from_msg_string(data, range, len);
+		success = range_from_msg_string(ns, data, range, len);
 		break;
 	case AS_PARTICLE_TYPE_GEOJSON:
 		success = range_from_msg_geojson(ns, data, range, len);
@@ -597,6 +734,103 @@ get_query_range(const as_transaction* tr, as_namespace* ns,
 		}
 	}
 
+	f = as_msg_field_get(&tr->msgp->msg, AS_MSG_FIELD_TYPE_INDEX_EXPRESSION);
+
+	if (f != NULL) {
+		if (range->ctx_buf != NULL) {
+			cf_warning(AS_QUERY, "index context and expression are exclusive");
+			return false;
+		}
+
+		// Matched byte-for-byte against the sindex's expression - not built.
+		range->exp_buf_sz = as_msg_field_get_value_sz(f);
+
+		if (range->exp_buf_sz == 0) {
+			cf_warning(AS_QUERY, "cannot parse index expression");
+			return false;
+		}
+
+		range->exp_buf = cf_malloc(range->exp_buf_sz);
+		memcpy(range->exp_buf, f->data, range->exp_buf_sz);
+	}
+
+	return true;
+}
+
+// Ranges after the first are ANDed with it, and are integer ranges on plain
+// bins - as must the first be. The first was parsed by get_query_range().
+static bool
+get_query_and_ranges(const as_transaction* tr, as_query_job* _job)
+{
+	if (! as_transaction_has_where_clause(tr)) {
+		return true;
+	}
+
+	const as_msg_field* f = as_msg_field_get(&tr->msgp->msg,
+			AS_MSG_FIELD_TYPE_INDEX_RANGE);
+	const uint8_t* data = f->data;
+	const uint8_t* end = data + as_msg_field_get_value_sz(f);
+	uint8_t n_ranges = *data++;
+
+	if (n_ranges == 1) {
+		return true;
+	}
+
+	const as_query_range* range = _job->range;
+
+	if (range->bin_type != AS_PARTICLE_TYPE_INTEGER ||
+			range->itype != AS_SINDEX_ITYPE_DEFAULT ||
+			range->ctx_buf != NULL || range->exp_buf != NULL) {
+		cf_warning(AS_QUERY, "multiple ranges must all be integer ranges on plain bins");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < n_ranges; i++) {
+		if (data >= end ||
+				(size_t)(end - data) < 1 + *data + 1 + INTEGER_RANGE_SZ) {
+			cf_warning(AS_QUERY, "cannot parse index range %u", i);
+			return false;
+		}
+
+		uint8_t bin_name_len = *data++;
+
+		if (bin_name_len == 0 || bin_name_len >= AS_BIN_NAME_MAX_SZ) {
+			cf_warning(AS_QUERY, "invalid bin name length %u", bin_name_len);
+			return false;
+		}
+
+		const uint8_t* bin_name = data;
+
+		data += bin_name_len;
+
+		as_particle_type bin_type = *data++;
+
+		if (i == 0) {
+			data += INTEGER_RANGE_SZ;
+			continue;
+		}
+
+		if (bin_type != AS_PARTICLE_TYPE_INTEGER) {
+			cf_warning(AS_QUERY, "multiple ranges must all be integer ranges on plain bins");
+			return false;
+		}
+
+		as_query_range* and_range = cf_calloc(1, sizeof(as_query_range));
+
+		// Link it to the job so that as_job_destroy will clean it.
+		_job->and_ranges[_job->n_and_ranges++] = and_range;
+
+		memcpy(and_range->bin_name, bin_name, bin_name_len); // null-terminated
+		and_range->bin_type = bin_type;
+		and_range->itype = AS_SINDEX_ITYPE_DEFAULT;
+
+		if (! range_from_msg_integer(data, and_range, INTEGER_RANGE_SZ)) {
+			return false;
+		}
+
+		data += INTEGER_RANGE_SZ;
+	}
+
 	return true;
 }
 
@@ -732,7 +966,8 @@ range_from_msg_integer(const uint8_t* data, as_query_range* range, uint32_t len)
 }
 
 static bool
-range_from_msg_string(const uint8_t* data, as_query_range* range, uint32_t len)
+range_from_msg_string(const as_namespace* ns, const uint8_t* data,
+		as_query_range* range, uint32_t len)
 {
 	if (len < sizeof(uint32_t)) {
 		cf_warning(AS_QUERY, "cannot parse string range");
@@ -756,10 +991,15 @@ range_from_msg_string(const uint8_t* data, as_query_range* range, uint32_t len)
 
 	const char* startp = (const char*)data;
 
+	if (ns->sindex_ordered_strings) {
+		return range_from_msg_ordered_string(ns, startp, startl,
+				data + startl, len - startl, range);
+	}
+
 	// Currently, clients also send an 'end' string which is identical to the
 	// 'start' string. Ignore that here for performance, since it's redundant.
 
-	range->u.r.start = as_sindex_string_to_bval(startp, startl);
+	range->u.r.start = as_sindex_string_to_bval(ns, startp, startl);
 	range->u.r.end = range->u.r.start;
 
 	range->str_len = startl;
@@ -773,6 +1013,60 @@ range_from_msg_string(const uint8_t* data, as_query_range* range, uint32_t len)
 	return true;
 }
 
+static bool
+range_from_msg_ordered_string(const as_namespace* ns, const char* startp,
+		uint32_t startl, const uint8_t* data, uint32_t len,
+		as_query_range* range)
+{
+	// Ordered strings honor the 'end' string - a prefix query is a range from
+	// the prefix to the prefix followed by 0xff bytes.
+
+	if (len < sizeof(uint32_t)) {
+		cf_warning(AS_QUERY, "cannot parse string range end");
+		return false;
+	}
+
+	uint32_t endl = cf_swap_from_be32(*((uint32_t*)data));
+
+	if (endl >= MAX_STRING_KSIZE) {
+		cf_warning(AS_QUERY, "query string too long - %u", endl);
+		return false;
+	}
+
+	data += sizeof(uint32_t);
+	len -= (uint32_t)sizeof(uint32_t);
+
+	if (len < endl) {
+		cf_warning(AS_QUERY, "cannot parse string range end");
+		return false;
+	}
+
+	const char* endp = (const char*)data;
+
+	if (strings_cmp(startp, startl, endp, endl) > 0) {
+		cf_warning(AS_QUERY, "invalid string range - start after end");
+		return false;
+	}
+
+	range->u.r.start = as_sindex_string_to_bval(ns, startp, startl);
+	range->u.r.end = as_sindex_string_to_bval(ns, endp, endl);
+
+	range->str_ordered = true;
+	range->str_len = startl;
+	range->str_end_len = endl;
+	range->str_buf = cf_malloc(startl + endl + 1); // +1 for zero-size ranges
+
+	memcpy(range->str_buf, startp, startl);
+	memcpy(range->str_buf + startl, endp, endl);
+
+	range->isrange = range->u.r.start != range->u.r.end;
+
+	cf_debug(AS_QUERY, "query on strings %.*s ... %.*s", startl, startp, endl,
+			endp);
+
+	return true;
+}
+
 static bool
 range_from_msg_geojson(as_namespace* ns, const uint8_t* data,
 		as_query_range* range, uint32_t len)
@@ -829,6 +1123,20 @@ range_from_msg_geojson(as_namespace* ns, const uint8_t* data,
 		}
 	}
 	else { // points-inside-region query
+		uint64_t key = geo_cache_key(ns, startp, startl);
+
+		cf_atomic64_incr(&ns->geo_region_query_count);
+
+		// The region is still parsed above - it's needed for post-filtering.
+		if (geo_cache_get(key, geo)) {
+			cf_atomic64_add(&ns->geo_region_query_cells, geo->num_r);
+			cf_atomic64_incr(&ns->geo_region_query_cache_hits);
+
+			range->isrange = true;
+
+			return true;
+		}
+
 		uint64_t cellmin[MAX_REGION_CELLS];
 		uint64_t cellmax[MAX_REGION_CELLS];
 		uint32_t ncells;
@@ -843,7 +1151,6 @@ range_from_msg_geojson(as_namespace* ns, const uint8_t* data,
 		geo->r = cf_calloc(ncells, sizeof(as_query_range_start_end));
 		geo->num_r = (uint8_t)ncells;
 
-		cf_atomic64_incr(&ns->geo_region_query_count);
 		cf_atomic64_add(&ns->geo_region_query_cells, ncells);
 
 		// Geospatial queries use multiple srange elements. Many of the fields
@@ -852,6 +1159,12 @@ range_from_msg_geojson(as_namespace* ns, const uint8_t* data,
 			geo->r[i].start = (int64_t)cellmin[i];
 			geo->r[i].end = (int64_t)cellmax[i];
 		}
+
+		set_geo_interior(ns, geo);
+
+		// Cache sorted, so cache hits needn't sort.
+		sort_geo_range(geo);
+		geo_cache_put(key, geo);
 	}
 
 	// Sort the GEO ranges so that the client can resume based on the bval.
@@ -890,143 +1203,478 @@ sort_geo_range(as_query_geo_range* geo)
 	}
 }
 
-static bool
-find_sindex(as_query_job* _job)
+// Failure just means every candidate gets the exact check.
+static void
+set_geo_interior(as_namespace* ns, as_query_geo_range* geo)
 {
-	as_query_range* range = _job->range;
+	uint64_t cellmin[MAX_INTERIOR_CELLS];
+	uint64_t cellmax[MAX_INTERIOR_CELLS];
+	uint32_t ncells;
 
-	if (range == NULL) {
-		return true;
+	if (! geo_region_interior(ns, geo->region, MAX_INTERIOR_CELLS, cellmin,
+			cellmax, &ncells) || ncells == 0) {
+		return;
 	}
 
-	if (! as_bin_get_id(_job->ns, range->bin_name, &range->bin_id)) {
-		cf_warning(AS_QUERY, "bin %s not found", range->bin_name);
-		return false;
+	geo->interior = cf_malloc(ncells * sizeof(as_query_range_start_end));
+	geo->num_interior = (uint8_t)ncells;
+
+	// Interior coverings come back normalized - sorted and disjoint.
+	for (uint32_t i = 0; i < ncells; i++) {
+		geo->interior[i].start = (int64_t)cellmin[i];
+		geo->interior[i].end = (int64_t)cellmax[i];
 	}
+}
 
-	_job->si = as_sindex_lookup_by_defn(_job->ns, _job->set_id, range->bin_id,
-			range->bin_type, range->itype, range->ctx_buf, range->ctx_buf_sz);
+static bool
+point_in_interior(const as_query_geo_range* geo, uint64_t cellid)
+{
+	uint32_t lo = 0;
+	uint32_t hi = geo->num_interior;
 
-	if (_job->si == NULL) {
-		return false;
-	}
+	// Find the last cell starting at or before cellid.
+	while (lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
 
-	if (! _job->is_short) {
-		strcpy(_job->si_name, _job->si->iname);
+		if ((uint64_t)geo->interior[mid].start <= cellid) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
 	}
 
-	return true;
+	return lo != 0 && cellid <= (uint64_t)geo->interior[lo - 1].end;
+}
+
+static uint64_t
+geo_cache_key(const as_namespace* ns, const char* json, uint32_t len)
+{
+	geo_cache_cfg cfg = {
+			.ns_ix = ns->ix,
+			.min_level = ns->geo2dsphere_within_min_level,
+			.max_level = ns->geo2dsphere_within_max_level,
+			.max_cells = ns->geo2dsphere_within_max_cells,
+			.level_mod = ns->geo2dsphere_within_level_mod
+	};
+
+	uint64_t key = cf_wyhash64((const void*)json, len) ^
+			(cf_wyhash64((const void*)&cfg, sizeof(cfg)) * 0x9e3779b97f4a7c15);
+
+	return key == 0 ? 1 : key; // 0 means empty
 }
 
 static bool
-validate_background_query_rps(const as_namespace* ns, uint32_t* rps)
+geo_cache_get(uint64_t key, as_query_geo_range* geo)
 {
-	if (*rps > ns->background_query_max_rps) {
-		cf_warning(AS_QUERY, "query rps %u exceeds 'background-query-max-rps' %u",
-				*rps, ns->background_query_max_rps);
-		return false;
-	}
+	geo_cache_set* set = &g_geo_cache[key % GEO_CACHE_N_SETS];
 
-	if (*rps == 0) {
-		*rps = ns->background_query_max_rps;
+	cf_mutex_lock(&set->lock);
+
+	for (uint32_t i = 0; i < GEO_CACHE_N_WAYS; i++) {
+		geo_cache_ele* ele = &set->eles[i];
+
+		if (ele->key == key) {
+			size_t sz = ele->n_r * sizeof(as_query_range_start_end);
+
+			geo->r = cf_malloc(sz);
+			memcpy(geo->r, ele->r, sz);
+			geo->num_r = (uint8_t)ele->n_r;
+
+			if (ele->n_interior != 0) {
+				sz = ele->n_interior * sizeof(as_query_range_start_end);
+
+				geo->interior = cf_malloc(sz);
+				memcpy(geo->interior, ele->interior, sz);
+				geo->num_interior = (uint8_t)ele->n_interior;
+			}
+
+			ele->last_used = as_aaf_uint32(&g_geo_cache_tick, 1);
+
+			cf_mutex_unlock(&set->lock);
+			return true;
+		}
 	}
 
-	return true;
+	cf_mutex_unlock(&set->lock);
+
+	return false;
 }
 
-static size_t
-send_blocking_response_chunk(as_file_handle* fd_h, uint8_t* buf, size_t size,
-		int32_t timeout, bool compress, as_proto_comp_stat* comp_stat)
+static void
+geo_cache_put(uint64_t key, const as_query_geo_range* geo)
 {
-	cf_socket* sock = &fd_h->sock;
-	as_proto* proto = (as_proto*)buf;
+	size_t sz = geo->num_r * sizeof(as_query_range_start_end);
+	as_query_range_start_end* r = cf_malloc(sz);
 
-	proto->version = PROTO_VERSION;
-	proto->type = PROTO_TYPE_AS_MSG;
-	proto->sz = size - sizeof(as_proto);
-	as_proto_swap(proto);
+	memcpy(r, geo->r, sz);
 
-	const uint8_t* msgp = (const uint8_t*)buf;
+	as_query_range_start_end* interior = NULL;
 
-	if (compress) {
-		msgp = as_proto_compress(msgp, &size, comp_stat);
+	if (geo->num_interior != 0) {
+		size_t interior_sz = geo->num_interior * sizeof(as_query_range_start_end);
+
+		interior = cf_malloc(interior_sz);
+		memcpy(interior, geo->interior, interior_sz);
 	}
 
-	if (cf_socket_send_all(sock, msgp, size, MSG_NOSIGNAL, timeout) < 0) {
-		cf_warning(AS_QUERY, "error sending to %s - fd %d sz %lu %s",
-				fd_h->client, CSFD(sock), size, cf_strerror(errno));
-		return 0;
+	geo_cache_set* set = &g_geo_cache[key % GEO_CACHE_N_SETS];
+
+	cf_mutex_lock(&set->lock);
+
+	geo_cache_ele* victim = &set->eles[0];
+
+	for (uint32_t i = 0; i < GEO_CACHE_N_WAYS; i++) {
+		geo_cache_ele* ele = &set->eles[i];
+
+		if (ele->key == key || ele->key == 0) {
+			victim = ele;
+			break;
+		}
+
+		// Unsigned difference handles tick wrap.
+		if (g_geo_cache_tick - ele->last_used >
+				g_geo_cache_tick - victim->last_used) {
+			victim = ele;
+		}
 	}
 
-	return sizeof(as_proto) + size;
-}
+	as_query_range_start_end* old_r = victim->r;
+	as_query_range_start_end* old_interior = victim->interior;
 
-static inline bool
-record_changed_since_start(const as_query_job* _job, const as_record *r)
-{
-	return r->last_update_time > _job->start_ms_clepoch;
+	victim->key = key;
+	victim->last_used = as_aaf_uint32(&g_geo_cache_tick, 1);
+	victim->n_r = geo->num_r;
+	victim->r = r;
+	victim->n_interior = geo->num_interior;
+	victim->interior = interior;
+
+	cf_mutex_unlock(&set->lock);
+
+	if (old_r != NULL) {
+		cf_free(old_r);
+	}
+
+	if (old_interior != NULL) {
+		cf_free(old_interior);
+	}
 }
 
 static bool
-record_matches_query(as_query_job* _job, as_storage_rd* rd)
+find_sindex(as_query_job* _job)
 {
-	if (! record_changed_since_start(_job, rd->r) &&
-			_job->si->ktype != AS_PARTICLE_TYPE_GEOJSON && // geo needs to check bounds anyway
-			_job->si->ktype != AS_PARTICLE_TYPE_STRING) { // strings need to check for hash collisions
+	as_query_range* range = _job->range;
+
+	if (range == NULL) {
 		return true;
 	}
 
-	as_bin stack_bins[RECORD_MAX_BINS]; // never single-bin
+	if (! as_bin_get_id(_job->ns, range->bin_name, &range->bin_id)) {
+		cf_warning(AS_QUERY, "bin %s not found", range->bin_name);
+		return false;
+	}
 
-	if (as_storage_rd_load_bins(rd, stack_bins) < 0) {
-		return false; // for now - not separating error from false positive
+	_job->si = as_sindex_lookup_by_defn(_job->ns, _job->set_id, range->bin_id,
+			range->bin_type, range->itype, range->ctx_buf, range->ctx_buf_sz,
+			range->exp_buf, range->exp_buf_sz);
+
+	if (_job->si == NULL) {
+		return false;
 	}
 
-	const as_query_range* range = _job->range;
-	const as_sindex* si = _job->si;
+	if (! _job->is_short) {
+		strcpy(_job->si_name, _job->si->iname);
+	}
 
-	const as_bin* b = as_bin_get_by_id_live(rd, si->bin_id);
+	return find_and_sindexes(_job);
+}
 
-	if (b == NULL) {
-		return false;
+// The first range always drives the reduce - client resume points are in its
+// bvals. The others are intersected most selective first, so an empty result
+// stops collection early.
+static bool
+find_and_sindexes(as_query_job* _job)
+{
+	if (_job->n_and_ranges == 0 || ! _job->si->readable) {
+		return true; // caller rejects unreadable sindex
 	}
 
-	as_particle_type type = as_bin_get_particle_type(b);
-	as_bin ctx_bin = { 0 };
+	uint64_t n_ests[AS_QUERY_MAX_AND_RANGES];
 
-	if (range->ctx_buf != NULL) {
-		if (type != AS_PARTICLE_TYPE_LIST && type != AS_PARTICLE_TYPE_MAP) {
+	for (uint32_t i = 0; i < _job->n_and_ranges; i++) {
+		as_query_range* range = _job->and_ranges[i];
+
+		if (! as_bin_get_id(_job->ns, range->bin_name, &range->bin_id)) {
+			cf_warning(AS_QUERY, "bin %s not found", range->bin_name);
 			return false;
 		}
 
-		if (! as_bin_cdt_get_by_context(b, si->ctx_buf, si->ctx_buf_sz,
-				&ctx_bin, false)) {
+		as_sindex* si = as_sindex_lookup_by_defn(_job->ns, _job->set_id,
+				range->bin_id, range->bin_type, range->itype, NULL, 0, NULL, 0);
+
+		if (si == NULL) {
 			return false;
 		}
 
-		type = as_bin_get_particle_type(&ctx_bin);
+		_job->and_sis[i] = si; // link it to the job so it's released
 
-		if (type == AS_PARTICLE_TYPE_GEOJSON &&
-				! as_bin_cdt_context_geojson_parse(&ctx_bin)) {
+		if (! si->readable) {
+			cf_warning(AS_QUERY, "sindex %s not readable", si->iname);
 			return false;
 		}
 
-		b = &ctx_bin;
+		n_ests[i] = as_sindex_tree_estimate_range(si, range->u.r.start,
+				range->u.r.end);
 	}
 
-	bool ret = false;
+	for (uint32_t i = 1; i < _job->n_and_ranges; i++) {
+		for (uint32_t j = i; j > 0 && n_ests[j] < n_ests[j - 1]; j--) {
+			uint64_t n_est = n_ests[j];
+			as_sindex* si = _job->and_sis[j];
+			as_query_range* range = _job->and_ranges[j];
 
-	switch (type) {
-		case AS_PARTICLE_TYPE_INTEGER:
-			if ((type != si->ktype) || (type != range->bin_type)) {
-				break;
-			}
+			n_ests[j] = n_ests[j - 1];
+			_job->and_sis[j] = _job->and_sis[j - 1];
+			_job->and_ranges[j] = _job->and_ranges[j - 1];
 
-			int64_t i = as_bin_particle_integer_value(b);
+			n_ests[j - 1] = n_est;
+			_job->and_sis[j - 1] = si;
+			_job->and_ranges[j - 1] = range;
+		}
+	}
 
-			// Start and end are same for point query.
-			ret = range->u.r.start <= i && i <= range->u.r.end;
-			break;
+	return true;
+}
+
+static void
+query_sindex_reduce(as_query_job* _job, as_partition_reservation* rsv,
+		int64_t bval, cf_digest* keyd, as_sindex_reduce_fn cb, void* udata)
+{
+	if (_job->n_and_ranges == 0) {
+		as_sindex_tree_query(_job->si, _job->range, rsv, bval, keyd, cb,
+				udata);
+		return;
+	}
+
+	cf_arenax_handle* handles;
+	uint32_t n_handles = collect_and_handles(_job, rsv->p->id, &handles);
+
+	if (n_handles != 0) {
+		and_filter af = {
+				._job = _job,
+				.handles = handles,
+				.n_handles = n_handles,
+				.cb = cb,
+				.udata = udata
+		};
+
+		as_sindex_tree_query(_job->si, _job->range, rsv, bval, keyd,
+				and_filter_reduce_cb, (void*)&af);
+	}
+
+	if (handles != NULL) {
+		cf_free(handles);
+	}
+}
+
+// Intersects, in place, the sorted handle sets of all the AND ranges.
+static uint32_t
+collect_and_handles(as_query_job* _job, uint32_t pid,
+		cf_arenax_handle** handles_r)
+{
+	cf_arenax_handle* handles;
+	uint32_t n_handles = as_sindex_tree_collect_handles(_job->and_sis[0],
+			_job->and_ranges[0], pid, &handles);
+
+	for (uint32_t i = 1; i < _job->n_and_ranges && n_handles != 0; i++) {
+		cf_arenax_handle* other;
+		uint32_t n_other = as_sindex_tree_collect_handles(_job->and_sis[i],
+				_job->and_ranges[i], pid, &other);
+		uint32_t n_kept = 0;
+		uint32_t j = 0;
+
+		for (uint32_t k = 0; k < n_handles && j < n_other; k++) {
+			while (j < n_other && other[j] < handles[k]) {
+				j++;
+			}
+
+			if (j < n_other && other[j] == handles[k]) {
+				handles[n_kept++] = handles[k];
+			}
+		}
+
+		n_handles = n_kept;
+
+		if (other != NULL) {
+			cf_free(other);
+		}
+	}
+
+	*handles_r = handles;
+
+	return n_handles;
+}
+
+static bool
+and_filter_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
+{
+	and_filter* af = (and_filter*)udata;
+
+	if (bsearch(&r_ref->r_h, af->handles, af->n_handles,
+			sizeof(cf_arenax_handle), handle_cmp) == NULL) {
+		as_record_done(r_ref, af->_job->ns);
+		as_incr_uint64(&af->_job->n_filtered_and);
+		return true;
+	}
+
+	return af->cb(r_ref, bval, af->udata);
+}
+
+static int
+handle_cmp(const void* pa, const void* pb)
+{
+	cf_arenax_handle a = *(const cf_arenax_handle*)pa;
+	cf_arenax_handle b = *(const cf_arenax_handle*)pb;
+
+	return a > b ? 1 : (a < b ? -1 : 0);
+}
+
+static bool
+validate_background_query_rps(const as_namespace* ns, uint32_t* rps)
+{
+	if (*rps > ns->background_query_max_rps) {
+		cf_warning(AS_QUERY, "query rps %u exceeds 'background-query-max-rps' %u",
+				*rps, ns->background_query_max_rps);
+		return false;
+	}
+
+	if (*rps == 0) {
+		*rps = ns->background_query_max_rps;
+	}
+
+	return true;
+}
+
+static void
+flush_bg_tr_batch(bg_tr_batch* batch)
+{
+	if (batch->n_trs == 0) {
+		return;
+	}
+
+	// Prefer not reaching target RPS to queue buildup and transaction timeouts.
+	while (as_load_uint32(batch->n_active_tr) + batch->n_trs >
+			MAX_ACTIVE_TRANSACTIONS) {
+		usleep(1000);
+	}
+
+	as_add_uint32(batch->n_active_tr, batch->n_trs);
+	as_service_enqueue_background_batch(batch->trs, batch->n_trs);
+
+	batch->n_trs = 0;
+}
+
+static size_t
+send_blocking_response_chunk(as_file_handle* fd_h, uint8_t* buf, size_t size,
+		int32_t timeout, bool compress, as_proto_comp_stat* comp_stat)
+{
+	cf_socket* sock = &fd_h->sock;
+	as_proto* proto = (as_proto*)buf;
+
+	proto->version = PROTO_VERSION;
+	proto->type = PROTO_TYPE_AS_MSG;
+	proto->sz = size - sizeof(as_proto);
+	as_proto_swap(proto);
+
+	const uint8_t* msgp = (const uint8_t*)buf;
+
+	if (compress) {
+		msgp = as_proto_compress(msgp, &size, comp_stat);
+	}
+
+	if (cf_socket_send_all(sock, msgp, size, MSG_NOSIGNAL, timeout) < 0) {
+		cf_warning(AS_QUERY, "error sending to %s - fd %d sz %lu %s",
+				fd_h->client, CSFD(sock), size, cf_strerror(errno));
+		return 0;
+	}
+
+	return sizeof(as_proto) + size;
+}
+
+static inline bool
+record_changed_since_start(const as_query_job* _job, const as_record *r)
+{
+	return r->last_update_time > _job->start_ms_clepoch;
+}
+
+static bool
+record_matches_query(as_query_job* _job, as_storage_rd* rd)
+{
+	if (! record_changed_since_start(_job, rd->r) &&
+			_job->si->ktype != AS_PARTICLE_TYPE_GEOJSON && // geo needs to check bounds anyway
+			_job->si->ktype != AS_PARTICLE_TYPE_STRING) { // strings need to check for hash collisions
+		return true;
+	}
+
+	as_bin stack_bins[RECORD_MAX_BINS]; // never single-bin
+
+	if (as_storage_rd_load_bins(rd, stack_bins) < 0) {
+		return false; // for now - not separating error from false positive
+	}
+
+	const as_query_range* range = _job->range;
+	const as_sindex* si = _job->si;
+
+	const as_bin* b = as_bin_get_by_id_live(rd, si->bin_id);
+
+	if (b == NULL) {
+		return false;
+	}
+
+	as_particle_type type = as_bin_get_particle_type(b);
+	as_bin ctx_bin = { 0 };
+
+	if (range->ctx_buf != NULL) {
+		if (type != AS_PARTICLE_TYPE_LIST && type != AS_PARTICLE_TYPE_MAP) {
+			return false;
+		}
+
+		if (! as_bin_cdt_get_by_context(b, si->ctx_buf, si->ctx_buf_sz,
+				&ctx_bin, false)) {
+			return false;
+		}
+
+		type = as_bin_get_particle_type(&ctx_bin);
+
+		if (type == AS_PARTICLE_TYPE_GEOJSON &&
+				! as_bin_cdt_context_geojson_parse(&ctx_bin)) {
+			return false;
+		}
+
+		b = &ctx_bin;
+	}
+	else if (range->exp_buf != NULL) {
+		if (! as_sindex_exp_eval(si, b, &ctx_bin)) {
+			return false;
+		}
+
+		type = as_bin_get_particle_type(&ctx_bin);
+		b = &ctx_bin;
+	}
+
+	bool ret = false;
+
+	switch (type) {
+		case AS_PARTICLE_TYPE_INTEGER:
+			if ((type != si->ktype) || (type != range->bin_type)) {
+				break;
+			}
+
+			int64_t i = as_bin_particle_integer_value(b);
+
+			// Start and end are same for point query.
+			ret = range->u.r.start <= i && i <= range->u.r.end;
+			break;
 		case AS_PARTICLE_TYPE_STRING:
 			if ((type != si->ktype) || (type != range->bin_type)) {
 				break;
@@ -1035,7 +1683,7 @@ record_matches_query(as_query_job* _job, as_storage_rd* rd)
 			char* str;
 			uint32_t len = as_bin_particle_string_ptr(b, &str);
 
-			ret = strings_match(range, str, len);
+			ret = strings_match(_job->ns, range, str, len);
 			break;
 		case AS_PARTICLE_TYPE_GEOJSON:
 			if ((type != si->ktype) || (type != range->bin_type)) {
@@ -1043,10 +1691,13 @@ record_matches_query(as_query_job* _job, as_storage_rd* rd)
 			}
 
 			as_namespace* ns = _job->ns;
+			const as_query_geo_range* geo = &range->u.geo;
 
-			bool iswithin = as_particle_geojson_match(b->particle,
-					range->u.geo.cellid, range->u.geo.region,
-					ns->geo2dsphere_within_strict);
+			// Points well inside the region skip the exact S2 check.
+			bool iswithin = (geo->num_interior != 0 && point_in_interior(geo,
+					as_particle_geojson_point_cellid(b->particle))) ||
+					as_particle_geojson_match(b->particle, geo->cellid,
+							geo->region, ns->geo2dsphere_within_strict);
 
 			if (iswithin) {
 				cf_atomic64_incr(&ns->geo_region_query_points);
@@ -1067,13 +1718,41 @@ record_matches_query(as_query_job* _job, as_storage_rd* rd)
 			break;
 	}
 
-	if (range->ctx_buf != NULL) {
+	if (range->ctx_buf != NULL || range->exp_buf != NULL) {
 		as_bin_particle_destroy(&ctx_bin);
 	}
 
+	// Unchanged records matched the intersection - only recheck changed ones.
+	if (ret && _job->n_and_ranges != 0) {
+		ret = record_matches_and_ranges(_job, rd);
+	}
+
 	return ret;
 }
 
+// Only called with bins loaded, for records changed since the job started.
+static bool
+record_matches_and_ranges(const as_query_job* _job, as_storage_rd* rd)
+{
+	for (uint32_t i = 0; i < _job->n_and_ranges; i++) {
+		const as_query_range* range = _job->and_ranges[i];
+		const as_bin* b = as_bin_get_by_id_live(rd, _job->and_sis[i]->bin_id);
+
+		if (b == NULL ||
+				as_bin_get_particle_type(b) != AS_PARTICLE_TYPE_INTEGER) {
+			return false;
+		}
+
+		int64_t v = as_bin_particle_integer_value(b);
+
+		if (v < range->u.r.start || v > range->u.r.end) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static bool
 record_matches_query_cdt(as_query_job* _job, const as_bin* b)
 {
@@ -1203,7 +1882,7 @@ match_string_element(const as_query_job* _job, msgpack_in* element)
 	str++;
 	str_sz--;
 
-	return strings_match(range, (const char*)str, str_sz);
+	return strings_match(_job->ns, range, (const char*)str, str_sz);
 }
 
 static bool
@@ -1241,12 +1920,22 @@ typedef struct conn_query_job_s {
 	bool compress_response;
 	uint64_t net_io_bytes;
 	uint64_t net_io_ns;
+
+	// Chunks handed off by threads which found the socket busy:
+	cf_mutex chunks_lock;
+	uint32_t n_pending;
+	cf_buf_builder* pending[MAX_PENDING_CHUNKS];
+	uint32_t n_spares;
+	cf_buf_builder* spares[MAX_PENDING_CHUNKS];
 } conn_query_job;
 
 static void conn_query_job_init(conn_query_job* job, const as_transaction* tr);
 static void conn_query_job_destroy(conn_query_job* job);
 static void conn_query_job_finish(conn_query_job* job);
 static bool conn_query_job_send_response(conn_query_job* job, uint8_t* buf, size_t size);
+static bool conn_query_job_send_chunk(conn_query_job* job, cf_buf_builder** bb_r);
+static bool conn_query_job_send_locked(conn_query_job* job, uint8_t* buf, size_t size);
+static void conn_query_job_send_pending(conn_query_job* job);
 static void conn_query_job_release_fd(conn_query_job* job, bool force_close);
 static void conn_query_job_info(conn_query_job* job, as_mon_jobstat* stat);
 
@@ -1258,6 +1947,7 @@ static void
 conn_query_job_init(conn_query_job* job, const as_transaction* tr)
 {
 	cf_mutex_init(&job->fd_lock);
+	cf_mutex_init(&job->chunks_lock);
 
 	job->fd_h = tr->from.proto_fd_h;
 	job->fd_timeout = CF_SOCKET_TIMEOUT;
@@ -1280,6 +1970,15 @@ conn_query_job_finish(conn_query_job* job)
 {
 	as_query_job* _job = (as_query_job*)job;
 
+	// All threads are done - send anything handed off but not yet sent.
+	conn_query_job_send_pending(job);
+
+	for (uint32_t i = 0; i < job->n_spares; i++) {
+		cf_buf_builder_free(job->spares[i]);
+	}
+
+	cf_mutex_destroy(&job->chunks_lock);
+
 	if (job->fd_h) {
 		if (_job->is_short) {
 			conn_query_job_release_fd(job, false);
@@ -1305,13 +2004,71 @@ conn_query_job_finish(conn_query_job* job)
 
 static bool
 conn_query_job_send_response(conn_query_job* job, uint8_t* buf, size_t size)
+{
+	cf_mutex_lock(&job->fd_lock);
+
+	bool ok = conn_query_job_send_locked(job, buf, size);
+
+	cf_mutex_unlock(&job->fd_lock);
+
+	return ok;
+}
+
+// Sends a mid-stream chunk. If another thread is sending, hands the chunk off
+// to be sent by that thread, and carries on with a spare buffer. On return,
+// *bb_r is empty, with the proto header reserved.
+static bool
+conn_query_job_send_chunk(conn_query_job* job, cf_buf_builder** bb_r)
 {
 	as_query_job* _job = (as_query_job*)job;
+	cf_buf_builder* bb = *bb_r;
 
-	cf_mutex_lock(&job->fd_lock);
+	if (! cf_mutex_trylock(&job->fd_lock)) {
+		cf_mutex_lock(&job->chunks_lock);
+
+		if (job->n_pending < MAX_PENDING_CHUNKS) {
+			job->pending[job->n_pending++] = bb;
+
+			*bb_r = job->n_spares != 0 ?
+					job->spares[--job->n_spares] :
+					cf_buf_builder_create(INIT_BUF_BUILDER_SIZE);
+
+			cf_mutex_unlock(&job->chunks_lock);
+
+			cf_buf_builder_reset(*bb_r);
+			cf_buf_builder_reserve(bb_r, (int)sizeof(as_proto), NULL);
+
+			// In case the sending thread finished before seeing our chunk.
+			conn_query_job_send_pending(job);
+
+			return _job->abandoned == 0;
+		}
+
+		cf_mutex_unlock(&job->chunks_lock);
+
+		// Too many chunks queued - wait for the socket.
+		cf_mutex_lock(&job->fd_lock);
+	}
+
+	bool ok = conn_query_job_send_locked(job, bb->buf, bb->used_sz);
+
+	cf_mutex_unlock(&job->fd_lock);
+
+	cf_buf_builder_reset(bb);
+	cf_buf_builder_reserve(bb_r, (int)sizeof(as_proto), NULL);
+
+	conn_query_job_send_pending(job);
+
+	return ok;
+}
+
+// Caller must hold fd_lock.
+static bool
+conn_query_job_send_locked(conn_query_job* job, uint8_t* buf, size_t size)
+{
+	as_query_job* _job = (as_query_job*)job;
 
 	if (! job->fd_h) {
-		cf_mutex_unlock(&job->fd_lock);
 		// Job already abandoned.
 		return false;
 	}
@@ -1331,7 +2088,6 @@ conn_query_job_send_response(conn_query_job* job, uint8_t* buf, size_t size)
 				AS_QUERY_RESPONSE_TIMEOUT : AS_QUERY_RESPONSE_ERROR;
 
 		conn_query_job_release_fd(job, true);
-		cf_mutex_unlock(&job->fd_lock);
 		as_query_manager_abandon_job(_job, reason);
 		return false;
 	}
@@ -1342,10 +2098,48 @@ conn_query_job_send_response(conn_query_job* job, uint8_t* buf, size_t size)
 
 	job->net_io_bytes += size_sent;
 
-	cf_mutex_unlock(&job->fd_lock);
 	return true;
 }
 
+// Sends handed-off chunks, unless another thread holds the socket - it will.
+static void
+conn_query_job_send_pending(conn_query_job* job)
+{
+	while (as_load_uint32(&job->n_pending) != 0 &&
+			cf_mutex_trylock(&job->fd_lock)) {
+		while (true) {
+			cf_mutex_lock(&job->chunks_lock);
+
+			if (job->n_pending == 0) {
+				cf_mutex_unlock(&job->chunks_lock);
+				break;
+			}
+
+			cf_buf_builder* bb = job->pending[--job->n_pending];
+
+			cf_mutex_unlock(&job->chunks_lock);
+
+			conn_query_job_send_locked(job, bb->buf, bb->used_sz);
+
+			cf_mutex_lock(&job->chunks_lock);
+
+			if (job->n_spares < MAX_PENDING_CHUNKS) {
+				job->spares[job->n_spares++] = bb;
+				bb = NULL;
+			}
+
+			cf_mutex_unlock(&job->chunks_lock);
+
+			if (bb != NULL) {
+				cf_buf_builder_free(bb);
+			}
+		}
+
+		cf_mutex_unlock(&job->fd_lock);
+		// Re-check - a chunk may have been handed off as we unlocked.
+	}
+}
+
 static void
 conn_query_job_release_fd(conn_query_job* job, bool force_close)
 {
@@ -1373,6 +2167,20 @@ conn_query_job_info(conn_query_job* job, as_mon_jobstat* stat)
 // basic_query_job typedefs and forward declarations.
 //
 
+typedef struct top_k_ele_s {
+	int64_t key;
+	uint32_t sz;
+	uint8_t* buf; // record response, as built for the buf-builder
+} top_k_ele;
+
+// Root is the worst element kept - the first to be replaced.
+typedef struct top_k_heap_s {
+	uint32_t k;
+	bool desc;
+	uint32_t n_eles;
+	top_k_ele* eles;
+} top_k_heap;
+
 typedef struct basic_query_job_s {
 	// Base object must be first:
 	conn_query_job _base;
@@ -1381,10 +2189,20 @@ typedef struct basic_query_job_s {
 	uint64_t end_ns;
 	bool old_client; // TODO - temporary - won't need after January 2023
 	bool no_bin_data;
+	bool raw_flat; // respond with stored flat records, not client bins
+	bool index_only; // only selected bin is the (integer) sindex bin
+	bool filter_on_bval; // filter reads only the (integer) sindex bin
 	uint64_t sample_max;
 	uint64_t sample_count;
 	as_exp* filter_exp;
 	cf_vector* bin_ids;
+
+	uint32_t top_k; // 0 means stream all matching records
+	uint16_t top_k_bin_id;
+	cf_mutex top_k_lock;
+	top_k_heap top_k_merged;
+
+	uint64_t cache_key; // 0 means responses aren't cached
 } basic_query_job;
 
 static void basic_query_job_slice(as_query_job* _job, as_partition_reservation* rsv, cf_buf_builder** bb_r);
@@ -1402,13 +2220,56 @@ static const as_query_vtable basic_query_job_vtable = {
 typedef struct basic_query_slice_s {
 	basic_query_job* job;
 	cf_buf_builder** bb_r;
+	top_k_heap top_k;
+
+	// For the result cache:
+	bool flushed; // a chunk was sent - partition's responses not all in bb
+	uint32_t n_recs;
+	uint32_t min_void_time;
 } basic_query_slice;
 
+typedef struct device_order_chunk_s {
+	basic_query_slice* slice;
+	uint16_t set_id;
+	uint32_t n_visited;
+	uint32_t n_keyds;
+	cf_digest keyds[DEVICE_ORDER_CHUNK_SIZE];
+	cf_digest last_keyd; // last digest collected in this chunk
+	cf_digest resume_keyd; // last digest processed - set index only
+	bool has_resume;
+	as_index_cursor cursor; // last digest processed - tree only
+	bool stopped;
+} device_order_chunk;
+
 static void basic_query_job_init(basic_query_job* job);
 static bool basic_query_get_bin_ids(const as_transaction* tr, as_namespace* ns, cf_vector** bin_ids);
+static bool basic_query_get_top_k(const as_transaction* tr, basic_query_job* job);
+static bool basic_query_get_raw_flat(const as_transaction* tr, basic_query_job* job);
+static bool basic_query_top_k_add(basic_query_slice* slice, as_storage_rd* rd, bool send_bval, int64_t bval);
+static void basic_query_append_top_k(basic_query_job* job, cf_buf_builder** bb_r);
+static bool top_k_keeps(const top_k_heap* heap, int64_t key);
+static void top_k_push(top_k_heap* heap, const top_k_ele* ele);
+static void top_k_pop(top_k_heap* heap, top_k_ele* ele);
+static void top_k_merge(top_k_heap* dst, top_k_heap* src);
+static void top_k_free(top_k_heap* heap);
+static uint64_t result_cache_key(const as_transaction* tr, const as_query_job* _job);
+static void basic_query_cached_reduce(basic_query_slice* slice, as_partition_reservation* rsv);
+static void result_cache_stamp_get(const as_query_job* _job, const as_partition_reservation* rsv, result_cache_stamp* stamp);
+static bool result_cache_get(as_namespace* ns, uint64_t key, const result_cache_stamp* stamp, cf_buf_builder** bb_r, uint32_t* n_recs);
+static void result_cache_put(as_namespace* ns, uint64_t key, const result_cache_stamp* stamp, const basic_query_slice* slice, const uint8_t* buf, uint32_t sz);
+static void basic_pi_query_reduce_tree(basic_query_slice* slice, as_index_tree* tree, const cf_digest* keyd);
+static void basic_pi_query_job_filter_cb(as_index* const* rs, uint32_t n_rs, uint8_t* keep, void* udata);
 static bool basic_pi_query_job_reduce_cb(as_index_ref* r_ref, void* udata);
 static bool basic_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata);
 static bool basic_query_filter_meta(const basic_query_job* job, const as_record* r, as_exp** exp);
+static bool basic_query_use_index_only(const basic_query_job* job);
+static bool basic_query_use_filter_on_bval(const basic_query_job* job);
+static bool basic_query_filter_bval(const basic_query_job* job, as_index* r, int64_t bval, as_exp** exp);
+static bool basic_pi_query_use_device_order(const basic_query_job* job);
+static void basic_pi_query_device_order(basic_query_slice* slice, as_index_tree* tree, cf_digest* keyd);
+static bool device_order_reduce(as_namespace* ns, as_index_tree* tree, device_order_chunk* chunk, as_index_cursor* cursor, as_index_reduce_fn cb);
+static bool device_order_collect_cb(as_index_ref* r_ref, void* udata);
+static bool device_order_process_cb(as_index_ref* r_ref, void* udata);
 
 //----------------------------------------------------------
 // basic_query_job public API.
@@ -1438,6 +2299,7 @@ basic_query_job_start(as_transaction* tr, as_namespace* ns)
 	if (! get_query_set(tr, ns, _job->set_name, &_job->set_id) ||
 			! get_query_pids(tr, &_job->pids, &_job->n_pids_requested) ||
 			! get_query_range(tr, ns, &_job->range) ||
+			! get_query_and_ranges(tr, _job) ||
 			! get_query_rps(tr, &_job->rps)) {
 		cf_warning(AS_QUERY, "basic query job failed msg field processing");
 		as_query_job_destroy(_job);
@@ -1479,7 +2341,8 @@ basic_query_job_start(as_transaction* tr, as_namespace* ns)
 
 	if (! get_query_sample_max(tr, &job->sample_max) ||
 			! basic_query_get_bin_ids(tr, ns, &job->bin_ids) ||
-			! get_query_filter_exp(tr, &job->filter_exp)) {
+			! get_query_filter_exp(tr, &job->filter_exp) ||
+			! basic_query_get_top_k(tr, job)) {
 		cf_warning(AS_QUERY, "basic query job failed msg field processing");
 		conn_query_job_destroy(conn_job);
 		as_query_job_destroy(_job);
@@ -1488,10 +2351,25 @@ basic_query_job_start(as_transaction* tr, as_namespace* ns)
 
 	job->no_bin_data = (m->info1 & AS_MSG_INFO1_GET_NO_BINS) != 0;
 
-	int result = as_security_check_rps(tr->from.proto_fd_h, _job->rps,
-			PERM_QUERY, false, &_job->rps_udata);
-
-	if (result != AS_OK) {
+	if (! basic_query_get_raw_flat(tr, job)) {
+		cf_warning(AS_QUERY, "basic query job failed msg field processing");
+		conn_query_job_destroy(conn_job);
+		as_query_job_destroy(_job);
+		return AS_ERR_PARAMETER;
+	}
+
+	job->index_only = basic_query_use_index_only(job);
+	job->filter_on_bval = basic_query_use_filter_on_bval(job);
+
+	if (ns->query_result_cache_size != 0 && _job->si != NULL &&
+			job->top_k == 0 && job->sample_max == 0 && ! job->raw_flat) {
+		job->cache_key = result_cache_key(tr, _job);
+	}
+
+	int result = as_security_check_rps(tr->from.proto_fd_h, _job->rps,
+			PERM_QUERY, false, &_job->rps_udata);
+
+	if (result != AS_OK) {
 		cf_warning(AS_QUERY, "basic query job failed quota %d", result);
 		conn_query_job_destroy(conn_job);
 		as_query_job_destroy(_job);
@@ -1545,6 +2423,11 @@ basic_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 	}
 	else if (rsv == NULL) { // this thread finished all its partitions
 		if (_job->is_short) {
+			// Short queries run in one thread - all top-K results are in.
+			if (job->top_k != 0 && _job->abandoned == 0) {
+				basic_query_append_top_k(job, bb_r);
+			}
+
 			as_msg_fin_bufbuilder(bb_r, _job->abandoned);
 			// Won't send fin later in finish().
 		}
@@ -1584,7 +2467,11 @@ basic_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 		return;
 	}
 
-	basic_query_slice slice = { job, bb_r };
+	basic_query_slice slice = {
+			.job = job,
+			.bb_r = bb_r,
+			.top_k = { .k = job->top_k, .desc = job->top_k_merged.desc }
+	};
 
 	if (job->sample_max == 0 || job->sample_count < job->sample_max) {
 		int64_t bval = 0;
@@ -1600,18 +2487,31 @@ basic_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 		}
 
 		if (_job->si != NULL) {
-			as_sindex_tree_query(_job->si, _job->range, rsv, bval, keyd,
-					basic_query_job_reduce_cb, (void*)&slice);
+			if (job->cache_key != 0 && keyd == NULL) {
+				basic_query_cached_reduce(&slice, rsv);
+			}
+			else {
+				query_sindex_reduce(_job, rsv, bval, keyd,
+						basic_query_job_reduce_cb, (void*)&slice);
+			}
+		}
+		else if (basic_pi_query_use_device_order(job)) {
+			basic_pi_query_device_order(&slice, tree, keyd);
 		}
 		else {
 			if (! as_set_index_reduce(_job->ns, tree, _job->set_id, keyd,
 					basic_pi_query_job_reduce_cb, (void*)&slice)) {
-				as_index_reduce_from_live(tree, keyd,
-						basic_pi_query_job_reduce_cb, (void*)&slice);
+				basic_pi_query_reduce_tree(&slice, tree, keyd);
 			}
 		}
 	}
 
+	if (slice.top_k.n_eles != 0) {
+		cf_mutex_lock(&job->top_k_lock);
+		top_k_merge(&job->top_k_merged, &slice.top_k);
+		cf_mutex_unlock(&job->top_k_lock);
+	}
+
 	if (job->old_client && _job->pids != NULL) {
 		as_msg_pid_done_bufbuilder(bb_r, rsv->p->id, AS_OK);
 	}
@@ -1625,6 +2525,22 @@ basic_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 static void
 basic_query_job_finish(as_query_job* _job)
 {
+	basic_query_job* job = (basic_query_job*)_job;
+
+	if (job->top_k != 0 && ! _job->is_short && _job->abandoned == 0) {
+		cf_buf_builder* bb = cf_buf_builder_create(INIT_BUF_BUILDER_SIZE);
+
+		cf_buf_builder_reserve(&bb, (int)sizeof(as_proto), NULL);
+		basic_query_append_top_k(job, &bb);
+
+		if (bb->used_sz > sizeof(as_proto)) {
+			conn_query_job_send_response((conn_query_job*)job, bb->buf,
+					bb->used_sz);
+		}
+
+		cf_buf_builder_free(bb);
+	}
+
 	conn_query_job_finish((conn_query_job*)_job);
 
 	as_namespace* ns = _job->ns;
@@ -1695,100 +2611,630 @@ basic_query_job_finish(as_query_job* _job)
 	}
 }
 
-static void
-basic_query_job_destroy(as_query_job* _job)
-{
-	basic_query_job* job = (basic_query_job*)_job;
+static void
+basic_query_job_destroy(as_query_job* _job)
+{
+	basic_query_job* job = (basic_query_job*)_job;
+
+	if (job->bin_ids != NULL) {
+		cf_vector_destroy(job->bin_ids);
+	}
+
+	as_exp_destroy(job->filter_exp);
+
+	top_k_free(&job->top_k_merged);
+	cf_mutex_destroy(&job->top_k_lock);
+}
+
+static void
+basic_query_job_info(as_query_job* _job, as_mon_jobstat* stat)
+{
+	strcpy(stat->job_type, query_type_str(QUERY_TYPE_BASIC));
+	conn_query_job_info((conn_query_job*)_job, stat);
+}
+
+//----------------------------------------------------------
+// basic_query_job utilities.
+//
+
+static void
+basic_query_job_init(basic_query_job* job)
+{
+	cf_mutex_init(&job->top_k_lock);
+}
+
+static bool
+basic_query_get_bin_ids(const as_transaction* tr, as_namespace* ns,
+		cf_vector** bin_ids)
+{
+	bool has_binlist = as_transaction_has_query_binlist(tr);
+	const as_msg* m = &tr->msgp->msg;
+	bool has_ops = m->n_ops > 0;
+
+	if (has_binlist && has_ops) {
+		cf_warning(AS_QUERY, "both binlist and ops cannot be specified");
+		return false;
+	}
+
+	if (! has_binlist && ! has_ops) {
+		return true;
+	}
+	// else - bin selection requested.
+
+	if (ns->single_bin) {
+		cf_warning(AS_QUERY, "can't select bins - single-bin namespace");
+		return false;
+	}
+
+	// TODO - temporary - won't need bin-list support after January 2023.
+	if (has_binlist) {
+		const as_msg_field* f = as_msg_field_get(m,
+				AS_MSG_FIELD_TYPE_QUERY_BINLIST);
+		const uint8_t* data = f->data;
+		uint32_t n_bins = *data++; // only <= 255 bins (ops do more)
+
+		*bin_ids = cf_vector_create(sizeof(uint16_t), n_bins, 0);
+
+		for (uint32_t i = 0; i < n_bins; ++i) {
+			size_t len = *data++;
+			uint16_t id;
+
+			if (! as_bin_get_id_w_len(ns, (const char*)data, len, &id)) {
+				continue;
+			}
+
+			cf_vector_append_unique(*bin_ids, &id);
+			data += len;
+		}
+
+		return true;
+	}
+	// else - has ops
+
+	*bin_ids = cf_vector_create(sizeof(uint16_t), m->n_ops, 0);
+
+	as_msg_op* op = NULL;
+	uint16_t n = 0;
+
+	while ((op = as_msg_op_iterate(m, op, &n)) != NULL) {
+		uint16_t id;
+
+		if (! as_bin_get_id_w_len(ns, (const char*)op->name, op->name_sz,
+				&id)) {
+			continue;
+		}
+
+		cf_vector_append_unique(*bin_ids, &id);
+	}
+
+	return true;
+}
+
+static bool
+basic_query_get_top_k(const as_transaction* tr, basic_query_job* job)
+{
+	if (! as_transaction_has_top_k(tr)) {
+		return true;
+	}
+
+	const as_msg_field* f = as_msg_field_get(&tr->msgp->msg,
+			AS_MSG_FIELD_TYPE_TOP_K);
+	uint32_t sz = as_msg_field_get_value_sz(f);
+
+	// Format - k (4 bytes), flags (1 byte), name of integer bin to order by.
+	if (sz <= sizeof(uint32_t) + 1) {
+		cf_warning(AS_QUERY, "top-k field size %u too small", sz);
+		return false;
+	}
+
+	if (job->sample_max != 0) {
+		cf_warning(AS_QUERY, "both top-k and sample-max cannot be specified");
+		return false;
+	}
+
+	uint32_t k = cf_swap_from_be32(*(uint32_t*)f->data);
+
+	if (k == 0 || k > MAX_TOP_K) {
+		cf_warning(AS_QUERY, "top-k %u must be between 1 and %u", k,
+				MAX_TOP_K);
+		return false;
+	}
+
+	uint8_t flags = f->data[sizeof(uint32_t)];
+	const char* name = (const char*)f->data + sizeof(uint32_t) + 1;
+	size_t name_sz = sz - sizeof(uint32_t) - 1;
+
+	if (! as_bin_get_id_w_len(((as_query_job*)job)->ns, name, name_sz,
+			&job->top_k_bin_id)) {
+		cf_warning(AS_QUERY, "top-k bin %.*s not found", (int)name_sz, name);
+		return false;
+	}
+
+	job->top_k = k;
+	job->top_k_merged.k = k;
+	job->top_k_merged.desc = (flags & TOP_K_DESCENDING) != 0;
+
+	return true;
+}
+
+// Raw flat responses are for backup - whole records, in storage format.
+static bool
+basic_query_get_raw_flat(const as_transaction* tr, basic_query_job* job)
+{
+	if (! as_transaction_has_raw_flat(tr)) {
+		return true;
+	}
+
+	if (job->no_bin_data || job->bin_ids != NULL || job->top_k != 0) {
+		cf_warning(AS_QUERY, "raw-flat can't be combined with bin selection, no-bins or top-k");
+		return false;
+	}
+
+	job->raw_flat = true;
+
+	return true;
+}
+
+static bool
+basic_query_top_k_add(basic_query_slice* slice, as_storage_rd* rd,
+		bool send_bval, int64_t bval)
+{
+	basic_query_job* job = slice->job;
+	as_query_job* _job = (as_query_job*)job;
+	as_namespace* ns = _job->ns;
+	as_bin stack_bins[ns->single_bin ? 1 : RECORD_MAX_BINS];
+
+	// Need the order-by bin even when no bins are returned.
+	if (as_storage_rd_load_bins(rd, stack_bins) < 0) {
+		cf_warning(AS_QUERY, "job %lu - record unreadable", _job->trid);
+		return false;
+	}
+
+	as_bin* b = as_bin_get_by_id_live(rd, job->top_k_bin_id);
+
+	if (b == NULL || as_bin_get_particle_type(b) != AS_PARTICLE_TYPE_INTEGER) {
+		return true; // records without the integer bin can't be ranked
+	}
+
+	int64_t key = as_bin_particle_integer_value(b);
+
+	if (! top_k_keeps(&slice->top_k, key)) {
+		return true;
+	}
+
+	// Build the response in place, then move it out of the buf-builder.
+	size_t start_sz = (*slice->bb_r)->used_sz;
+
+	as_msg_make_response_bufbuilder(slice->bb_r, rd, job->no_bin_data,
+			job->bin_ids, send_bval, bval);
+
+	cf_buf_builder* bb = *slice->bb_r;
+	top_k_ele ele = {
+			.key = key,
+			.sz = (uint32_t)(bb->used_sz - start_sz)
+	};
+
+	ele.buf = cf_malloc(ele.sz);
+	memcpy(ele.buf, bb->buf + start_sz, ele.sz);
+	bb->used_sz = start_sz;
+
+	top_k_push(&slice->top_k, &ele);
+
+	return true;
+}
+
+static void
+basic_query_append_top_k(basic_query_job* job, cf_buf_builder** bb_r)
+{
+	top_k_heap* heap = &job->top_k_merged;
+	uint32_t n_eles = heap->n_eles;
+
+	if (n_eles == 0) {
+		return;
+	}
+
+	// Popping yields the worst first - fill from the back to send best first.
+	top_k_ele* sorted = cf_malloc(n_eles * sizeof(top_k_ele));
+
+	for (uint32_t i = n_eles; i != 0; i--) {
+		top_k_pop(heap, &sorted[i - 1]);
+	}
+
+	bool send_ok = true;
+
+	for (uint32_t i = 0; i < n_eles; i++) {
+		top_k_ele* ele = &sorted[i];
+
+		if (send_ok) {
+			uint8_t* buf;
+
+			cf_buf_builder_reserve(bb_r, (int)ele->sz, &buf);
+			memcpy(buf, ele->buf, ele->sz);
+
+			cf_buf_builder* bb = *bb_r;
+
+			if (bb->used_sz > QUERY_CHUNK_LIMIT) {
+				send_ok = conn_query_job_send_response((conn_query_job*)job,
+						bb->buf, bb->used_sz);
+
+				cf_buf_builder_reset(bb);
+				cf_buf_builder_reserve(bb_r, (int)sizeof(as_proto), NULL);
+			}
+		}
+
+		cf_free(ele->buf);
+	}
+
+	cf_free(sorted);
+}
+
+static inline bool
+top_k_worse(const top_k_heap* heap, int64_t a, int64_t b)
+{
+	return heap->desc ? a < b : a > b;
+}
+
+static bool
+top_k_keeps(const top_k_heap* heap, int64_t key)
+{
+	return heap->n_eles < heap->k || top_k_worse(heap, heap->eles[0].key, key);
+}
+
+static void
+top_k_sift_down(top_k_heap* heap, uint32_t i)
+{
+	top_k_ele* eles = heap->eles;
+
+	while (true) {
+		uint32_t worst = i;
+		uint32_t l = (2 * i) + 1;
+		uint32_t r = l + 1;
+
+		if (l < heap->n_eles && top_k_worse(heap, eles[l].key,
+				eles[worst].key)) {
+			worst = l;
+		}
+
+		if (r < heap->n_eles && top_k_worse(heap, eles[r].key,
+				eles[worst].key)) {
+			worst = r;
+		}
+
+		if (worst == i) {
+			return;
+		}
+
+		top_k_ele tmp = eles[i];
+
+		eles[i] = eles[worst];
+		eles[worst] = tmp;
+		i = worst;
+	}
+}
+
+// Caller must have checked top_k_keeps().
+static void
+top_k_push(top_k_heap* heap, const top_k_ele* ele)
+{
+	if (heap->eles == NULL) {
+		heap->eles = cf_malloc(heap->k * sizeof(top_k_ele));
+	}
+
+	if (heap->n_eles == heap->k) {
+		cf_free(heap->eles[0].buf);
+		heap->eles[0] = *ele;
+		top_k_sift_down(heap, 0);
+		return;
+	}
+
+	top_k_ele* eles = heap->eles;
+	uint32_t i = heap->n_eles++;
+
+	eles[i] = *ele;
+
+	while (i != 0) {
+		uint32_t parent = (i - 1) / 2;
+
+		if (! top_k_worse(heap, eles[i].key, eles[parent].key)) {
+			break;
+		}
+
+		top_k_ele tmp = eles[i];
+
+		eles[i] = eles[parent];
+		eles[parent] = tmp;
+		i = parent;
+	}
+}
+
+static void
+top_k_pop(top_k_heap* heap, top_k_ele* ele)
+{
+	*ele = heap->eles[0];
+	heap->eles[0] = heap->eles[--heap->n_eles];
+	top_k_sift_down(heap, 0);
+}
+
+// Moves the elements of src which make the cut into dst, and empties src.
+static void
+top_k_merge(top_k_heap* dst, top_k_heap* src)
+{
+	for (uint32_t i = 0; i < src->n_eles; i++) {
+		top_k_ele* ele = &src->eles[i];
+
+		if (top_k_keeps(dst, ele->key)) {
+			top_k_push(dst, ele);
+		}
+		else {
+			cf_free(ele->buf);
+		}
+	}
+
+	cf_free(src->eles);
+	src->eles = NULL;
+	src->n_eles = 0;
+}
+
+static void
+top_k_free(top_k_heap* heap)
+{
+	for (uint32_t i = 0; i < heap->n_eles; i++) {
+		cf_free(heap->eles[i].buf);
+	}
+
+	if (heap->eles != NULL) {
+		cf_free(heap->eles);
+	}
+}
+
+// Everything in the request that shapes the responses - volatile fields (trid,
+// timeouts, pids and resume points) are left out.
+static uint64_t
+result_cache_key(const as_transaction* tr, const as_query_job* _job)
+{
+	const cl_msg* msgp = tr->msgp;
+	const as_msg* m = &msgp->msg;
+	const uint8_t flags[] = { m->info1, m->info2, m->info3, _job->pids != NULL };
+
+	uint64_t key = cf_wyhash64((const void*)flags, sizeof(flags)) ^
+			((uint64_t)(_job->ns->ix + 1) * 0x9e3779b97f4a7c15);
+	const as_msg_field* f = (const as_msg_field*)m->data;
+
+	for (uint16_t n = 0; n < m->n_fields; n++) {
+		switch (f->type) {
+		case AS_MSG_FIELD_TYPE_TRID:
+		case AS_MSG_FIELD_TYPE_SOCKET_TIMEOUT:
+		case AS_MSG_FIELD_TYPE_RECS_PER_SEC:
+		case AS_MSG_FIELD_TYPE_PID_ARRAY:
+		case AS_MSG_FIELD_TYPE_DIGEST_ARRAY:
+		case AS_MSG_FIELD_TYPE_BVAL_ARRAY:
+			break;
+		default:
+			// Type byte and value are contiguous, and field_sz covers both.
+			key = (key * 0x9e3779b97f4a7c15) ^
+					cf_wyhash64((const void*)&f->type, f->field_sz);
+			break;
+		}
+
+		f = as_msg_field_get_next((as_msg_field*)f);
+	}
+
+	// Ops (bins to return) are everything after the fields.
+	const uint8_t* ops = (const uint8_t*)f;
+	const uint8_t* end = msgp->proto.body + msgp->proto.sz;
+
+	if (ops < end) {
+		key = (key * 0x9e3779b97f4a7c15) ^
+				cf_wyhash64((const void*)ops, (size_t)(end - ops));
+	}
+
+	return key == 0 ? 1 : key; // 0 means not cached
+}
+
+static void
+basic_query_cached_reduce(basic_query_slice* slice,
+		as_partition_reservation* rsv)
+{
+	basic_query_job* job = slice->job;
+	as_query_job* _job = (as_query_job*)job;
+	as_namespace* ns = _job->ns;
+
+	uint64_t key = job->cache_key ^
+			((uint64_t)(rsv->p->id + 1) * 0xff51afd7ed558ccd);
+
+	key = key == 0 ? 1 : key;
+
+	// Stamp before the reduce - writes during it make the entry stale.
+	result_cache_stamp stamp;
+
+	result_cache_stamp_get(_job, rsv, &stamp);
+
+	uint32_t n_recs;
+
+	if (result_cache_get(ns, key, &stamp, slice->bb_r, &n_recs)) {
+		as_incr_uint64(&ns->n_si_query_cache_hits);
+		as_add_uint64(&_job->n_succeeded, n_recs);
+
+		cf_buf_builder* bb = *slice->bb_r;
+
+		if (bb->used_sz > QUERY_CHUNK_LIMIT) {
+			conn_query_job_send_chunk((conn_query_job*)job, slice->bb_r);
+		}
+
+		return;
+	}
+
+	as_incr_uint64(&ns->n_si_query_cache_misses);
+
+	size_t start_sz = (*slice->bb_r)->used_sz;
+
+	query_sindex_reduce(_job, rsv, 0, NULL, basic_query_job_reduce_cb,
+			(void*)slice);
+
+	if (slice->flushed || _job->abandoned != 0) {
+		return;
+	}
+
+	cf_buf_builder* bb = *slice->bb_r;
+
+	result_cache_put(ns, key, &stamp, slice, bb->buf + start_sz,
+			(uint32_t)(bb->used_sz - start_sz));
+}
+
+// Counters only grow, so a sum over the query's sindexes changes if any does.
+static void
+result_cache_stamp_get(const as_query_job* _job,
+		const as_partition_reservation* rsv, result_cache_stamp* stamp)
+{
+	uint32_t pid = rsv->p->id;
+
+	stamp->n_writes = as_load_uint64(&_job->ns->si_query_cache_writes[pid]);
+	stamp->n_si_mods = as_sindex_tree_n_mods(_job->si, pid);
+
+	for (uint32_t i = 0; i < _job->n_and_ranges; i++) {
+		stamp->n_si_mods += as_sindex_tree_n_mods(_job->and_sis[i], pid);
+	}
+
+	stamp->version = rsv->p->version;
+}
+
+static bool
+result_cache_get(as_namespace* ns, uint64_t key, const result_cache_stamp* stamp,
+		cf_buf_builder** bb_r, uint32_t* n_recs)
+{
+	result_cache_set* set = &g_result_cache[key % RESULT_CACHE_N_SETS];
+
+	cf_mutex_lock(&set->lock);
+
+	for (uint32_t i = 0; i < RESULT_CACHE_N_WAYS; i++) {
+		result_cache_ele* ele = &set->eles[i];
+
+		if (ele->key != key || ele->ns_ix != ns->ix) {
+			continue;
+		}
+
+		if (memcmp(&ele->stamp, stamp, sizeof(result_cache_stamp)) != 0 ||
+				(ele->min_void_time != 0 &&
+						ele->min_void_time <= as_record_void_time_get())) {
+			break; // stale - put() will replace it
+		}
+
+		if (ele->sz != 0) {
+			uint8_t* p;
+
+			cf_buf_builder_reserve(bb_r, (int)ele->sz, &p);
+			memcpy(p, ele->buf, ele->sz);
+		}
 
-	if (job->bin_ids != NULL) {
-		cf_vector_destroy(job->bin_ids);
+		*n_recs = ele->n_recs;
+		ele->last_used = as_aaf_uint32(&g_result_cache_tick, 1);
+
+		cf_mutex_unlock(&set->lock);
+		return true;
 	}
 
-	as_exp_destroy(job->filter_exp);
+	cf_mutex_unlock(&set->lock);
+
+	return false;
 }
 
 static void
-basic_query_job_info(as_query_job* _job, as_mon_jobstat* stat)
+result_cache_put(as_namespace* ns, uint64_t key, const result_cache_stamp* stamp,
+		const basic_query_slice* slice, const uint8_t* buf, uint32_t sz)
 {
-	strcpy(stat->job_type, query_type_str(QUERY_TYPE_BASIC));
-	conn_query_job_info((conn_query_job*)_job, stat);
-}
+	uint8_t* copy = NULL;
 
-//----------------------------------------------------------
-// basic_query_job utilities.
-//
+	if (sz != 0) {
+		copy = cf_malloc(sz);
+		memcpy(copy, buf, sz);
+	}
 
-static void
-basic_query_job_init(basic_query_job* job)
-{
-	(void)job;
-}
+	result_cache_set* set = &g_result_cache[key % RESULT_CACHE_N_SETS];
 
-static bool
-basic_query_get_bin_ids(const as_transaction* tr, as_namespace* ns,
-		cf_vector** bin_ids)
-{
-	bool has_binlist = as_transaction_has_query_binlist(tr);
-	const as_msg* m = &tr->msgp->msg;
-	bool has_ops = m->n_ops > 0;
+	cf_mutex_lock(&set->lock);
 
-	if (has_binlist && has_ops) {
-		cf_warning(AS_QUERY, "both binlist and ops cannot be specified");
-		return false;
-	}
+	result_cache_ele* victim = &set->eles[0];
 
-	if (! has_binlist && ! has_ops) {
-		return true;
-	}
-	// else - bin selection requested.
+	for (uint32_t i = 0; i < RESULT_CACHE_N_WAYS; i++) {
+		result_cache_ele* ele = &set->eles[i];
 
-	if (ns->single_bin) {
-		cf_warning(AS_QUERY, "can't select bins - single-bin namespace");
-		return false;
+		if ((ele->key == key && ele->ns_ix == ns->ix) || ele->key == 0) {
+			victim = ele;
+			break;
+		}
+
+		// Unsigned difference handles tick wrap.
+		if (g_result_cache_tick - ele->last_used >
+				g_result_cache_tick - victim->last_used) {
+			victim = ele;
+		}
 	}
 
-	// TODO - temporary - won't need bin-list support after January 2023.
-	if (has_binlist) {
-		const as_msg_field* f = as_msg_field_get(m,
-				AS_MSG_FIELD_TYPE_QUERY_BINLIST);
-		const uint8_t* data = f->data;
-		uint32_t n_bins = *data++; // only <= 255 bins (ops do more)
+	uint64_t freed_sz = victim->key != 0 && victim->ns_ix == ns->ix ?
+			victim->sz : 0;
 
-		*bin_ids = cf_vector_create(sizeof(uint16_t), n_bins, 0);
+	if (as_load_uint64(&ns->si_query_cache_bytes) - freed_sz + sz >
+			ns->query_result_cache_size) {
+		cf_mutex_unlock(&set->lock);
 
-		for (uint32_t i = 0; i < n_bins; ++i) {
-			size_t len = *data++;
-			uint16_t id;
+		if (copy != NULL) {
+			cf_free(copy);
+		}
 
-			if (! as_bin_get_id_w_len(ns, (const char*)data, len, &id)) {
-				continue;
-			}
+		return;
+	}
 
-			cf_vector_append_unique(*bin_ids, &id);
-			data += len;
-		}
+	uint8_t* old_buf = victim->buf;
 
-		return true;
+	if (victim->key != 0) {
+		as_add_uint64(&g_config.namespaces[victim->ns_ix]->si_query_cache_bytes,
+				-(int64_t)victim->sz);
 	}
-	// else - has ops
 
-	*bin_ids = cf_vector_create(sizeof(uint16_t), m->n_ops, 0);
+	victim->key = key;
+	victim->ns_ix = ns->ix;
+	victim->last_used = as_aaf_uint32(&g_result_cache_tick, 1);
+	victim->stamp = *stamp;
+	victim->min_void_time = slice->min_void_time;
+	victim->n_recs = slice->n_recs;
+	victim->sz = sz;
+	victim->buf = copy;
 
-	as_msg_op* op = NULL;
-	uint16_t n = 0;
+	as_add_uint64(&ns->si_query_cache_bytes, sz);
 
-	while ((op = as_msg_op_iterate(m, op, &n)) != NULL) {
-		uint16_t id;
+	cf_mutex_unlock(&set->lock);
 
-		if (! as_bin_get_id_w_len(ns, (const char*)op->name, op->name_sz,
-				&id)) {
-			continue;
-		}
+	if (old_buf != NULL) {
+		cf_free(old_buf);
+	}
+}
 
-		cf_vector_append_unique(*bin_ids, &id);
+static void
+basic_pi_query_reduce_tree(basic_query_slice* slice, as_index_tree* tree,
+		const cf_digest* keyd)
+{
+	const as_exp* exp = slice->job->filter_exp;
+
+	if (exp != NULL && as_exp_metadata_batchable(exp)) {
+		as_index_reduce_from_live_filtered(tree, keyd,
+				basic_pi_query_job_filter_cb, basic_pi_query_job_reduce_cb,
+				(void*)slice);
+	}
+	else {
+		as_index_reduce_from_live(tree, keyd, basic_pi_query_job_reduce_cb,
+				(void*)slice);
 	}
+}
 
-	return true;
+// Skips records whose metadata can't pass the filter before they're locked -
+// those kept are still filtered as usual by the reduce callback.
+static void
+basic_pi_query_job_filter_cb(as_index* const* rs, uint32_t n_rs, uint8_t* keep,
+		void* udata)
+{
+	basic_query_slice* slice = (basic_query_slice*)udata;
+
+	as_exp_matches_metadata_batch(slice->job->filter_exp, rs, n_rs, keep);
 }
 
 static bool
@@ -1830,6 +3276,18 @@ basic_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 		return true;
 	}
 
+	if (filter_exp != NULL && job->filter_on_bval &&
+			! basic_query_filter_bval(job, r, bval, &filter_exp)) {
+		as_record_done(r_ref, ns);
+		as_incr_uint64(&_job->n_filtered_bins);
+		return true;
+	}
+
+	// The sindex entry holds the only bin asked for - if the record hasn't
+	// changed since the query started, and has no stored key, don't read it.
+	bool from_index = job->index_only && filter_exp == NULL &&
+			r->key_stored == 0 && ! record_changed_since_start(_job, r);
+
 	as_storage_rd rd;
 
 	as_storage_record_open(ns, r, &rd);
@@ -1870,10 +3328,49 @@ basic_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 
 	bool send_bval = _job->si != NULL && _job->pids != NULL;
 
-	if (job->no_bin_data) {
+	if (job->top_k != 0) {
+		bool ok = basic_query_top_k_add(slice, &rd, send_bval, bval);
+
+		as_storage_record_close(&rd);
+		as_record_done(r_ref, ns);
+		as_incr_uint64(ok ? &_job->n_succeeded : &_job->n_failed);
+
+		if (! _job->is_short) {
+			throttle_sleep(_job);
+		}
+
+		return true;
+	}
+
+	if (job->raw_flat) {
+		if (! as_storage_rd_load_pickle(&rd)) {
+			cf_warning(AS_QUERY, "job %lu - record unreadable", _job->trid);
+			as_storage_record_close(&rd);
+			as_record_done(r_ref, ns);
+			as_incr_uint64(&_job->n_failed);
+			return true;
+		}
+
+		as_msg_make_raw_flat_response_bufbuilder(slice->bb_r, &rd, send_bval,
+				bval);
+		cf_free(rd.pickle);
+	}
+	else if (job->no_bin_data) {
 		as_msg_make_response_bufbuilder(slice->bb_r, &rd, true, NULL, send_bval,
 				bval);
 	}
+	else if (from_index) {
+		as_bin b = { .id = _job->si->bin_id };
+
+		as_bin_set_int(&b, bval);
+
+		rd.bins = &b;
+		rd.n_bins = 1;
+
+		as_msg_make_response_bufbuilder(slice->bb_r, &rd, false, job->bin_ids,
+				send_bval, bval);
+		as_incr_uint64(&ns->n_si_query_index_only_records);
+	}
 	else {
 		as_bin stack_bins[ns->single_bin ? 1 : RECORD_MAX_BINS];
 
@@ -1889,9 +3386,15 @@ basic_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 				send_bval, bval);
 	}
 
+	if (r->void_time != 0 && (slice->min_void_time == 0 ||
+			r->void_time < slice->min_void_time)) {
+		slice->min_void_time = r->void_time;
+	}
+
 	as_storage_record_close(&rd);
 	as_record_done(r_ref, ns);
 	as_incr_uint64(&_job->n_succeeded);
+	slice->n_recs++;
 
 	if (last_sample) {
 		return false;
@@ -1906,13 +3409,8 @@ basic_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 	// If we exceed the proto size limit, send accumulated data back to client
 	// and reset the buf-builder to start a new proto.
 	if (bb->used_sz > QUERY_CHUNK_LIMIT) {
-		if (! conn_query_job_send_response((conn_query_job*)job, bb->buf,
-				bb->used_sz)) {
-			return true;
-		}
-
-		cf_buf_builder_reset(bb);
-		cf_buf_builder_reserve(slice->bb_r, (int)sizeof(as_proto), NULL);
+		conn_query_job_send_chunk((conn_query_job*)job, slice->bb_r);
+		slice->flushed = true;
 	}
 
 	return true;
@@ -1942,6 +3440,214 @@ basic_query_filter_meta(const basic_query_job* job, const as_record* r,
 	return tv == AS_EXP_TRUE;
 }
 
+static inline bool
+sindex_bval_is_bin_value(const as_sindex* si)
+{
+	// Only a scalar integer bin's value is its sindex bval.
+	return si->ktype == AS_PARTICLE_TYPE_INTEGER &&
+			si->itype == AS_SINDEX_ITYPE_DEFAULT && si->ctx_buf == NULL &&
+			si->exp == NULL;
+}
+
+static bool
+basic_query_use_index_only(const basic_query_job* job)
+{
+	const as_query_job* _job = (const as_query_job*)job;
+	const as_sindex* si = _job->si;
+	const as_namespace* ns = _job->ns;
+
+	if (si == NULL || job->no_bin_data || job->bin_ids == NULL ||
+			ns->storage_data_in_memory) {
+		return false;
+	}
+
+	if (! sindex_bval_is_bin_value(si)) {
+		return false;
+	}
+
+	if (cf_vector_size(job->bin_ids) != 1) {
+		return false;
+	}
+
+	uint16_t bin_id;
+
+	cf_vector_get(job->bin_ids, 0, &bin_id);
+
+	return bin_id == si->bin_id;
+}
+
+static bool
+basic_query_use_filter_on_bval(const basic_query_job* job)
+{
+	const as_query_job* _job = (const as_query_job*)job;
+	const as_sindex* si = _job->si;
+
+	return si != NULL && job->filter_exp != NULL &&
+			! _job->ns->storage_data_in_memory &&
+			sindex_bval_is_bin_value(si) &&
+			as_exp_refs_only_bin(job->filter_exp, si->bin_name);
+}
+
+// Evaluate a filter that reads only the sindex bin against the sindex key,
+// before any storage read. Returns false if the record is filtered out.
+static bool
+basic_query_filter_bval(const basic_query_job* job, as_index* r, int64_t bval,
+		as_exp** exp)
+{
+	const as_query_job* _job = (const as_query_job*)job;
+
+	if (record_changed_since_start(_job, r)) {
+		return true; // bval may be stale - caller must read bins
+	}
+
+	as_namespace* ns = _job->ns;
+	as_storage_rd rd;
+
+	as_storage_record_open(ns, r, &rd);
+
+	as_bin b = { .id = _job->si->bin_id };
+
+	as_bin_set_int(&b, bval);
+
+	rd.bins = &b;
+	rd.n_bins = 1;
+
+	as_exp_ctx ctx = { .ns = ns, .r = r, .rd = &rd };
+	bool matches = as_exp_matches_record(*exp, &ctx);
+
+	as_storage_record_close(&rd);
+
+	*exp = NULL; // filter resolved
+
+	return matches;
+}
+
+static bool
+basic_pi_query_use_device_order(const basic_query_job* job)
+{
+	as_namespace* ns = ((as_query_job*)job)->ns;
+
+	// Metadata-only queries don't read the device.
+	return ns->storage_scan_device_order &&
+			ns->storage_type == AS_STORAGE_ENGINE_SSD &&
+			! ns->storage_data_in_memory && ! job->no_bin_data;
+}
+
+// Walk the partition in chunks - for each chunk, first collect the digests and
+// read the records in device order, merging nearby records into single reads,
+// then process the chunk in digest order, using the prefetched data.
+static void
+basic_pi_query_device_order(basic_query_slice* slice, as_index_tree* tree,
+		cf_digest* keyd)
+{
+	as_query_job* _job = (as_query_job*)slice->job;
+	as_namespace* ns = _job->ns;
+	device_order_chunk* chunk = cf_malloc(sizeof(device_order_chunk));
+
+	chunk->slice = slice;
+	chunk->set_id = _job->set_id;
+	chunk->has_resume = keyd != NULL;
+	chunk->stopped = false;
+
+	if (keyd != NULL) {
+		chunk->resume_keyd = *keyd;
+	}
+
+	as_index_cursor_init(&chunk->cursor, tree, keyd);
+
+	while (true) {
+		chunk->n_visited = 0;
+		chunk->n_keyds = 0;
+
+		as_index_cursor collect_cursor = chunk->cursor;
+		bool done = device_order_reduce(ns, tree, chunk, &collect_cursor,
+				device_order_collect_cb);
+
+		if (chunk->n_visited == 0) {
+			if (done) {
+				break;
+			}
+
+			// Nothing live in the tree chunk, but more beyond it.
+			chunk->cursor = collect_cursor;
+			continue;
+		}
+
+		as_storage_read_prefetch(ns, chunk->keyds, chunk->n_keyds);
+		device_order_reduce(ns, tree, chunk, &chunk->cursor,
+				device_order_process_cb);
+		as_storage_read_prefetch_clear();
+
+		if (chunk->stopped || done) {
+			break;
+		}
+
+		// For set index - if all of the chunk was deleted meanwhile, skip past.
+		if (! chunk->has_resume ||
+				cf_digest_compare(&chunk->resume_keyd, &chunk->last_keyd) > 0) {
+			chunk->resume_keyd = chunk->last_keyd;
+			chunk->has_resume = true;
+		}
+	}
+
+	cf_free(chunk);
+}
+
+// Returns true if there's nothing beyond this chunk. The tree is walked with a
+// cursor, collecting no more than a chunk - set index sprigs are walked whole.
+static bool
+device_order_reduce(as_namespace* ns, as_index_tree* tree,
+		device_order_chunk* chunk, as_index_cursor* cursor,
+		as_index_reduce_fn cb)
+{
+	cf_digest* keyd = chunk->has_resume ? &chunk->resume_keyd : NULL;
+
+	if (as_set_index_reduce(ns, tree, chunk->set_id, keyd, cb,
+			(void*)chunk)) {
+		return chunk->n_visited < DEVICE_ORDER_CHUNK_SIZE;
+	}
+
+	as_index_cursor_next(cursor, DEVICE_ORDER_CHUNK_SIZE, cb, (void*)chunk);
+
+	return as_index_cursor_done(cursor);
+}
+
+static bool
+device_order_collect_cb(as_index_ref* r_ref, void* udata)
+{
+	device_order_chunk* chunk = (device_order_chunk*)udata;
+	as_index* r = r_ref->r;
+
+	if (! excluded_set(r, chunk->set_id)) {
+		chunk->keyds[chunk->n_keyds++] = r->keyd;
+	}
+
+	chunk->last_keyd = r->keyd;
+	as_record_done(r_ref, ((as_query_job*)chunk->slice->job)->ns);
+
+	return ++chunk->n_visited < DEVICE_ORDER_CHUNK_SIZE;
+}
+
+static bool
+device_order_process_cb(as_index_ref* r_ref, void* udata)
+{
+	device_order_chunk* chunk = (device_order_chunk*)udata;
+
+	// Reduce order is descending - stop after passing the collected chunk.
+	cf_digest keyd = r_ref->r->keyd;
+	bool last = cf_digest_compare(&keyd, &chunk->last_keyd) <= 0;
+
+	chunk->resume_keyd = keyd;
+	chunk->has_resume = true;
+
+	if (! basic_pi_query_job_reduce_cb(r_ref, (void*)chunk->slice)) {
+		chunk->stopped = true;
+		return false;
+	}
+
+	return ! last;
+}
+
 
 //==============================================================================
 // aggr_query_job derived class implementation.
@@ -2027,6 +3733,7 @@ aggr_query_job_start(as_transaction* tr, as_namespace* ns)
 
 	if (! get_query_set(tr, ns, _job->set_name, &_job->set_id) ||
 			! get_query_range(tr, ns, &_job->range) ||
+			! get_query_and_ranges(tr, _job) ||
 			! get_query_rps(tr, &_job->rps)) {
 		cf_warning(AS_QUERY, "aggregation query job failed msg field processing");
 		as_query_job_destroy(_job);
@@ -2124,8 +3831,8 @@ aggr_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 	aggr_query_slice slice = { job, &ll, &bb };
 
 	if (_job->si != NULL) {
-		as_sindex_tree_query(_job->si, _job->range, rsv, 0, NULL,
-				aggr_query_job_reduce_cb, (void*)&slice);
+		query_sindex_reduce(_job, rsv, 0, NULL, aggr_query_job_reduce_cb,
+				(void*)&slice);
 	}
 	else {
 		if (! as_set_index_reduce(_job->ns, rsv->tree, _job->set_id, NULL,
@@ -2386,12 +4093,7 @@ aggr_query_add_val_response(aggr_query_slice* slice, const as_val* val,
 	// If we exceed the proto size limit, send accumulated data back to client
 	// and reset the buf-builder to start a new proto.
 	if (bb->used_sz > QUERY_CHUNK_LIMIT) {
-		if (! conn_query_job_send_response(conn_job, bb->buf, bb->used_sz)) {
-			return;
-		}
-
-		cf_buf_builder_reset(bb);
-		cf_buf_builder_reserve(slice->bb_r, (int)sizeof(as_proto), NULL);
+		conn_query_job_send_chunk(conn_job, slice->bb_r);
 	}
 }
 
@@ -2453,9 +4155,11 @@ udf_bg_query_job_start(as_transaction* tr, as_namespace* ns)
 	as_query_job* _job = (as_query_job*)job;
 
 	as_query_job_init(_job, &udf_bg_query_job_vtable, tr, ns);
+	_job->weight = QUERY_WEIGHT_BACKGROUND;
 
 	if (! get_query_set(tr, ns, _job->set_name, &_job->set_id) ||
 			! get_query_range(tr, ns, &_job->range) ||
+			! get_query_and_ranges(tr, _job) ||
 			! get_query_rps(tr, &_job->rps)) {
 		cf_warning(AS_QUERY, "udf-bg query job failed msg field processing");
 		as_query_job_destroy(_job);
@@ -2559,17 +4263,22 @@ udf_bg_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 {
 	(void)bb_r;
 
+	udf_bg_query_job* job = (udf_bg_query_job*)_job;
+	bg_tr_batch batch = { ._job = _job, .n_active_tr = &job->n_active_tr };
+
 	if (_job->si != NULL) {
-		as_sindex_tree_query(_job->si, _job->range, rsv, 0, NULL,
-				udf_bg_query_job_reduce_cb, (void*)_job);
+		query_sindex_reduce(_job, rsv, 0, NULL, udf_bg_query_job_reduce_cb,
+				(void*)&batch);
 	}
 	else {
 		if (! as_set_index_reduce(_job->ns, rsv->tree, _job->set_id, NULL,
-				udf_bg_pi_query_job_reduce_cb, (void*)_job)) {
+				udf_bg_pi_query_job_reduce_cb, (void*)&batch)) {
 			as_index_reduce_live(rsv->tree, udf_bg_pi_query_job_reduce_cb,
-					(void*)_job);
+					(void*)&batch);
 		}
 	}
+
+	flush_bg_tr_batch(&batch);
 }
 
 static void
@@ -2649,7 +4358,8 @@ udf_bg_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 {
 	(void)bval;
 
-	as_query_job* _job = (as_query_job*)udata;
+	bg_tr_batch* batch = (bg_tr_batch*)udata;
+	as_query_job* _job = batch->_job;
 	udf_bg_query_job* job = (udf_bg_query_job*)_job;
 	as_namespace* ns = _job->ns;
 
@@ -2687,18 +4397,14 @@ udf_bg_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 	// Release record lock before throttling and enqueuing transaction.
 	as_record_done(r_ref, ns);
 
-	// Prefer not reaching target RPS to queue buildup and transaction timeouts.
-	while (as_load_uint32(&job->n_active_tr) > MAX_ACTIVE_TRANSACTIONS) {
-		usleep(1000);
-	}
-
 	throttle_sleep(_job);
 
-	as_transaction tr;
-	as_transaction_init_iudf(&tr, ns, &keyd, &job->origin);
+	as_transaction_init_iudf(&batch->trs[batch->n_trs++], ns, &keyd,
+			&job->origin);
 
-	as_incr_uint32(&job->n_active_tr);
-	as_service_enqueue_internal(&tr);
+	if (batch->n_trs == BG_TR_BATCH_SIZE) {
+		flush_bg_tr_batch(batch);
+	}
 
 	return true;
 }
@@ -2786,9 +4492,11 @@ ops_bg_query_job_start(as_transaction* tr, as_namespace* ns)
 	as_query_job* _job = (as_query_job*)job;
 
 	as_query_job_init(_job, &ops_bg_query_job_vtable, tr, ns);
+	_job->weight = QUERY_WEIGHT_BACKGROUND;
 
 	if (! get_query_set(tr, ns, _job->set_name, &_job->set_id) ||
 			! get_query_range(tr, ns, &_job->range) ||
+			! get_query_and_ranges(tr, _job) ||
 			! get_query_rps(tr, &_job->rps)) {
 		cf_warning(AS_QUERY, "ops-bg query job failed msg field processing");
 		as_query_job_destroy(_job);
@@ -2897,17 +4605,22 @@ ops_bg_query_job_slice(as_query_job* _job, as_partition_reservation* rsv,
 {
 	(void)bb_r;
 
+	ops_bg_query_job* job = (ops_bg_query_job*)_job;
+	bg_tr_batch batch = { ._job = _job, .n_active_tr = &job->n_active_tr };
+
 	if (_job->si != NULL) {
-		as_sindex_tree_query(_job->si, _job->range, rsv, 0, NULL,
-				ops_bg_query_job_reduce_cb, (void*)_job);
+		query_sindex_reduce(_job, rsv, 0, NULL, ops_bg_query_job_reduce_cb,
+				(void*)&batch);
 	}
 	else {
 		if (! as_set_index_reduce(_job->ns, rsv->tree, _job->set_id, NULL,
-				ops_bg_pi_query_job_reduce_cb, (void*)_job)) {
+				ops_bg_pi_query_job_reduce_cb, (void*)&batch)) {
 			as_index_reduce_live(rsv->tree, ops_bg_pi_query_job_reduce_cb,
-					(void*)_job);
+					(void*)&batch);
 		}
 	}
+
+	flush_bg_tr_batch(&batch);
 }
 
 static void
@@ -3043,7 +4756,8 @@ ops_bg_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 {
 	(void)bval;
 
-	as_query_job* _job = (as_query_job*)udata;
+	bg_tr_batch* batch = (bg_tr_batch*)udata;
+	as_query_job* _job = batch->_job;
 	ops_bg_query_job* job = (ops_bg_query_job*)_job;
 	as_namespace* ns = _job->ns;
 
@@ -3081,18 +4795,14 @@ ops_bg_query_job_reduce_cb(as_index_ref* r_ref, int64_t bval, void* udata)
 	// Release record lock before throttling and enqueuing transaction.
 	as_record_done(r_ref, ns);
 
-	// Prefer not reaching target RPS to queue buildup and transaction timeouts.
-	while (as_load_uint32(&job->n_active_tr) > MAX_ACTIVE_TRANSACTIONS) {
-		usleep(1000);
-	}
-
 	throttle_sleep(_job);
 
-	as_transaction tr;
-	as_transaction_init_iops(&tr, ns, &keyd, &job->origin);
+	as_transaction_init_iops(&batch->trs[batch->n_trs++], ns, &keyd,
+			&job->origin);
 
-	as_incr_uint32(&job->n_active_tr);
-	as_service_enqueue_internal(&tr);
+	if (batch->n_trs == BG_TR_BATCH_SIZE) {
+		flush_bg_tr_batch(batch);
+	}
 
 	return true;
 }
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "aerospike/as_atomic.h"
@@ -41,6 +42,7 @@
 
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/index.h"
 #include "base/monitor.h"
 #include "base/proto.h"
 #include "base/security.h"
@@ -48,6 +50,9 @@
 #include "fabric/partition.h"
 #include "geospatial/geospatial.h"
 #include "query/query_manager.h"
+#include "sindex/sindex.h"
+#include "sindex/sindex_tree.h"
+#include "storage/storage.h"
 
 #include "warnings.h"
 
@@ -60,6 +65,11 @@
 #define SLEEP_CAP (1000L * 10) // don't sleep more than 10 ms
 #define STREAK_MAX (1000L * 200) // spawn up to one thread per 200 ms
 
+typedef struct pid_size_s {
+	uint64_t size;
+	uint16_t pid;
+} pid_size;
+
 
 //==========================================================
 // Globals.
@@ -72,9 +82,11 @@ static uint32_t g_query_job_trid = 0;
 // Forward declarations.
 //
 
+static void order_pids(as_query_job* _job);
+static int pid_size_cmp(const void* pa, const void* pb);
 static void finish(as_query_job* _job);
 static void range_free(as_query_range* range);
-static uint32_t throttle_sleep(as_query_job* _job, uint64_t count, uint64_t now);
+static uint32_t throttle_sleep(as_query_job* _job, uint32_t rps, uint64_t count, uint64_t now);
 
 
 //==========================================================
@@ -131,6 +143,7 @@ as_query_job_init(as_query_job* _job, const as_query_vtable* vtable,
 	_job->trid = query_job_trid(as_transaction_trid(tr));
 	_job->ns = ns;
 	_job->start_ns = tr->start_time;
+	_job->weight = QUERY_WEIGHT_FOREGROUND;
 
 	strcpy(_job->client, tr->from.proto_fd_h->client);
 }
@@ -140,19 +153,31 @@ as_query_job_run(void* pv_job)
 {
 	as_query_job* _job = (as_query_job*)pv_job;
 
+	// Pooled thread - account heap usage to queries until the job is done.
+	int32_t old_arena = cf_alloc_set_thread_sys(CF_ALLOC_SYS_QUERY);
+
+	// Short queries are as latency sensitive as transactions.
+	as_storage_io_class old_io_class = as_storage_set_thread_io_class(
+			_job->is_short ? AS_STORAGE_IO_FOREGROUND : AS_STORAGE_IO_BACKGROUND);
+
 	if (! _job->is_short && ! _job->started) {
 		_job->base_sys_tid = cf_thread_sys_tid();
+
+		// Only this thread is running - order before adding others.
+		order_pids(_job);
+
 		_job->started = true;
 
-		if (_job->rps == 0) {
+		if (as_query_manager_job_rps(_job) == 0) {
 			as_query_manager_add_max_job_threads(_job);
 		}
 	}
 
 	cf_buf_builder* bb = NULL;
-	uint32_t pid;
+	uint32_t ix;
 
-	while ((pid = as_faa_uint32(&_job->pid, 1)) < AS_PARTITIONS) {
+	while ((ix = as_faa_uint32(&_job->pid, 1)) < AS_PARTITIONS) {
+		uint32_t pid = _job->pid_order != NULL ? _job->pid_order[ix] : ix;
 		as_partition_reservation rsv;
 
 		if (_job->pids == NULL) {
@@ -209,6 +234,9 @@ as_query_job_run(void* pv_job)
 		}
 	}
 
+	as_storage_set_thread_io_class(old_io_class);
+	cf_alloc_set_thread_arena(old_arena);
+
 	return NULL;
 }
 
@@ -218,19 +246,29 @@ as_query_job_throttle(as_query_job* _job)
 	uint64_t count;
 	uint64_t now;
 
+	// May be less than the job's own rps, if sharing a global budget.
+	uint32_t rps = as_query_manager_job_rps(_job);
+
+	if (rps != _job->throttle_rps) {
+		// Restart rate tracking from here at the new rate.
+		_job->throttle_rps = rps;
+		_job->base_us = cf_getus();
+		_job->base_count = as_load_uint64(&_job->n_throttled);
+	}
+
 	if (cf_thread_sys_tid() != _job->base_sys_tid) {
-		if (_job->rps == 0) {
+		if (rps == 0) {
 			return 0;
 		}
 
 		count = as_aaf_uint64(&_job->n_throttled, 1);
 		now = cf_getus();
 
-		return throttle_sleep(_job, count, now);
+		return throttle_sleep(_job, rps, count, now);
 	}
 	// else - only base thread adds extra threads.
 
-	if (_job->rps == 0) {
+	if (rps == 0) {
 		if (_job->pid < AS_PARTITIONS - 1) {
 			// Don't re-add threads that drop near the end.
 			as_query_manager_add_max_job_threads(_job);
@@ -242,7 +280,7 @@ as_query_job_throttle(as_query_job* _job)
 	count = as_aaf_uint64(&_job->n_throttled, 1);
 	now = cf_getus();
 
-	uint32_t sleep_us =  throttle_sleep(_job, count, now);
+	uint32_t sleep_us =  throttle_sleep(_job, rps, count, now);
 
 	if (sleep_us != 0) {
 		return sleep_us;
@@ -283,6 +321,10 @@ as_query_job_destroy(as_query_job* _job)
 		cf_free(_job->pids);
 	}
 
+	if (_job->pid_order != NULL) {
+		cf_free(_job->pid_order);
+	}
+
 	if (_job->si != NULL) {
 		as_sindex_release(_job->si);
 	}
@@ -291,6 +333,14 @@ as_query_job_destroy(as_query_job* _job)
 		range_free(_job->range);
 	}
 
+	for (uint32_t i = 0; i < _job->n_and_ranges; i++) {
+		if (_job->and_sis[i] != NULL) {
+			as_sindex_release(_job->and_sis[i]);
+		}
+
+		range_free(_job->and_ranges[i]);
+	}
+
 	cf_free(_job);
 }
 
@@ -315,6 +365,7 @@ as_query_job_info(as_query_job* _job, as_mon_jobstat* stat)
 	stat->recs_throttled = _job->n_throttled;
 	stat->recs_filtered_meta = _job->n_filtered_meta;
 	stat->recs_filtered_bins = _job->n_filtered_bins;
+	stat->recs_filtered_and = _job->n_filtered_and;
 	stat->recs_succeeded = _job->n_succeeded;
 	stat->recs_failed = _job->n_failed;
 
@@ -346,6 +397,61 @@ as_query_job_info(as_query_job* _job, as_mon_jobstat* stat)
 // Local helpers.
 //
 
+// Hand out the biggest partitions first, so an oversized partition doesn't
+// start last and leave the other threads idle at the end of the job.
+static void
+order_pids(as_query_job* _job)
+{
+	as_namespace* ns = _job->ns;
+	pid_size* sizes = cf_malloc(AS_PARTITIONS * sizeof(pid_size));
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		uint64_t size = 0;
+
+		if (_job->pids == NULL || _job->pids[pid].requested) {
+			if (_job->si != NULL) {
+				size = _job->si->btrees[pid]->n_keys;
+			}
+			else {
+				as_partition* p = &ns->partitions[pid];
+
+				cf_mutex_lock(&p->lock);
+
+				if (p->tree != NULL) {
+					size = as_index_tree_size(p->tree);
+				}
+
+				cf_mutex_unlock(&p->lock);
+			}
+		}
+
+		sizes[pid] = (pid_size){ .size = size, .pid = (uint16_t)pid };
+	}
+
+	qsort(sizes, AS_PARTITIONS, sizeof(pid_size), pid_size_cmp);
+
+	_job->pid_order = cf_malloc(AS_PARTITIONS * sizeof(uint16_t));
+
+	for (uint32_t ix = 0; ix < AS_PARTITIONS; ix++) {
+		_job->pid_order[ix] = sizes[ix].pid;
+	}
+
+	cf_free(sizes);
+}
+
+static int
+pid_size_cmp(const void* pa, const void* pb)
+{
+	const pid_size* a = (const pid_size*)pa;
+	const pid_size* b = (const pid_size*)pb;
+
+	if (a->size != b->size) {
+		return a->size > b->size ? -1 : 1;
+	}
+
+	return a->pid < b->pid ? -1 : (a->pid > b->pid ? 1 : 0);
+}
+
 static void
 finish(as_query_job* _job)
 {
@@ -360,6 +466,13 @@ finish(as_query_job* _job)
 		as_sindex_release(_job->si);
 		_job->si = NULL;
 	}
+
+	for (uint32_t i = 0; i < _job->n_and_ranges; i++) {
+		if (_job->and_sis[i] != NULL) {
+			as_sindex_release(_job->and_sis[i]);
+			_job->and_sis[i] = NULL;
+		}
+	}
 }
 
 // So that calloc'ed but not fully initialized range is freed correctly.
@@ -371,22 +484,34 @@ range_free(as_query_range* range)
 	if (range->bin_type == AS_PARTICLE_TYPE_GEOJSON) {
 		cf_free(range->u.geo.r);
 
+		if (range->u.geo.interior != NULL) {
+			cf_free(range->u.geo.interior);
+		}
+
 		if (range->u.geo.region) {
 			geo_region_destroy(range->u.geo.region);
 		}
 	}
 
+	if (range->str_buf != NULL) {
+		cf_free(range->str_buf);
+	}
+
 	if (range->ctx_buf != NULL) {
 		cf_free(range->ctx_buf);
 	}
 
+	if (range->exp_buf != NULL) {
+		cf_free(range->exp_buf);
+	}
+
 	cf_free(range);
 }
 
 static uint32_t
-throttle_sleep(as_query_job* _job, uint64_t count, uint64_t now)
+throttle_sleep(as_query_job* _job, uint32_t rps, uint64_t count, uint64_t now)
 {
-	uint64_t target_us = ((count - _job->base_count) * 1000000) / _job->rps;
+	uint64_t target_us = ((count - _job->base_count) * 1000000) / rps;
 	int64_t sleep_us = (int64_t)(target_us - (now - _job->base_us));
 
 	if (sleep_us > SLEEP_MIN) {
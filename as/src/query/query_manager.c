@@ -75,6 +75,7 @@ static as_query_manager g_mgr;
 //
 
 static void add_query_job_thread(as_query_job* _job);
+static void assign_fair_rps(void);
 static void evict_finished_jobs(void);
 static int abort_cb(void* buf, void* udata);
 static int info_cb(void* buf, void* udata);
@@ -125,8 +126,11 @@ as_query_manager_start_job(as_query_job* _job)
 		}
 
 		cf_queue_push(g_mgr.active_jobs, &_job);
+		assign_fair_rps();
 	}
 
+	_job->throttle_rps = _job->is_short ? _job->rps : _job->fair_rps;
+
 	add_query_job_thread(_job);
 
 	cf_mutex_unlock(&g_mgr.lock);
@@ -205,6 +209,7 @@ as_query_manager_finish_job(as_query_job* _job)
 	cf_mutex_lock(&g_mgr.lock);
 
 	remove_active(_job->trid);
+	assign_fair_rps();
 
 	_job->finish_ns = cf_getns();
 	cf_queue_push(g_mgr.finished_jobs, &_job);
@@ -328,6 +333,29 @@ as_query_manager_get_active_job_count(void)
 	return cf_queue_sz(g_mgr.active_jobs);
 }
 
+uint32_t
+as_query_manager_job_rps(as_query_job* _job)
+{
+	if (_job->is_short) {
+		return _job->rps;
+	}
+
+	uint32_t max_rps = as_load_uint32(&g_config.query_max_rps);
+
+	// Pick up dynamic changes of query-max-rps.
+	if (max_rps != as_load_uint32(&g_mgr.fair_max_rps)) {
+		cf_mutex_lock(&g_mgr.lock);
+
+		if (max_rps != g_mgr.fair_max_rps) {
+			assign_fair_rps();
+		}
+
+		cf_mutex_unlock(&g_mgr.lock);
+	}
+
+	return as_load_uint32(&_job->fair_rps);
+}
+
 
 //==========================================================
 // Local helpers.
@@ -342,6 +370,76 @@ add_query_job_thread(as_query_job* _job)
 	cf_thread_create_transient(as_query_job_run, _job);
 }
 
+// Call under lock. Shares query-max-rps among active long jobs by weight.
+static void
+assign_fair_rps(void)
+{
+	uint32_t max_rps = as_load_uint32(&g_config.query_max_rps);
+
+	g_mgr.fair_max_rps = max_rps;
+
+	uint32_t n_jobs = cf_queue_sz(g_mgr.active_jobs);
+
+	if (n_jobs == 0) {
+		return;
+	}
+
+	as_query_job* _jobs[n_jobs];
+	info_item item = { _jobs };
+
+	cf_queue_reduce(g_mgr.active_jobs, info_cb, &item);
+
+	if (max_rps == 0) {
+		for (uint32_t i = 0; i < n_jobs; i++) {
+			as_store_uint32(&_jobs[i]->fair_rps, _jobs[i]->rps);
+		}
+
+		return;
+	}
+
+	bool assigned[n_jobs];
+	uint64_t budget = max_rps;
+	uint64_t total_weight = 0;
+
+	for (uint32_t i = 0; i < n_jobs; i++) {
+		assigned[i] = false;
+		total_weight += _jobs[i]->weight;
+	}
+
+	// Jobs whose own rps is below their share keep their own rps, and what
+	// they leave is shared among the rest - repeat until no job is capped.
+	bool capped = true;
+
+	while (capped) {
+		capped = false;
+
+		for (uint32_t i = 0; i < n_jobs; i++) {
+			as_query_job* _job = _jobs[i];
+
+			if (assigned[i] || _job->rps == 0 ||
+					(uint64_t)_job->rps * total_weight >
+							budget * _job->weight) {
+				continue;
+			}
+
+			as_store_uint32(&_job->fair_rps, _job->rps);
+			budget -= _job->rps;
+			total_weight -= _job->weight;
+			assigned[i] = true;
+			capped = true;
+		}
+	}
+
+	for (uint32_t i = 0; i < n_jobs; i++) {
+		if (! assigned[i]) {
+			uint64_t share = (budget * _jobs[i]->weight) / total_weight;
+
+			as_store_uint32(&_jobs[i]->fair_rps,
+					share == 0 ? 1 : (uint32_t)share);
+		}
+	}
+}
+
 static void
 evict_finished_jobs(void)
 {
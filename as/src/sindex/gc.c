@@ -28,6 +28,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "aerospike/as_atomic.h"
@@ -42,6 +44,7 @@
 #include "base/datamodel.h"
 #include "base/index.h"
 #include "base/stats.h"
+#include "fabric/partition.h"
 #include "sindex/sindex.h"
 #include "sindex/sindex_tree.h"
 
@@ -58,13 +61,20 @@ typedef struct rlist_ele_s {
 
 #define THROTTLE_THRESHOLD (64 * 1024 * 1024)
 
+typedef struct pid_count_s {
+	uint32_t count;
+	uint16_t pid;
+} pid_count;
+
 
 //==========================================================
 // Forward declarations.
 //
 
 static void gc_ns_cycle(as_namespace* ns);
-static void gc_ns(as_namespace* ns);
+static uint32_t gc_order_pids(const uint32_t* n_pid, uint16_t* pids);
+static int pid_count_cmp(const void* pa, const void* pb);
+static void gc_ns(as_namespace* ns, const uint16_t* pids, uint32_t n_pids);
 
 
 //==========================================================
@@ -119,6 +129,7 @@ as_sindex_gc_record(as_namespace* ns, as_index_ref* r_ref)
 	rlist_ele ele = { .r_h = r_ref->r_h };
 
 	cf_queue_push(ns->si_gc_rlist, &ele);
+	ns->si_gc_rlist_n_pid[as_partition_getid(&r_ref->r->keyd)]++;
 
 	ns->si_gc_rlist_full = cf_queue_sz(ns->si_gc_rlist) >= THROTTLE_THRESHOLD;
 
@@ -162,6 +173,28 @@ as_sindex_gc_tree(as_namespace* ns, as_index_tree* tree)
 	cf_mutex_unlock(&ns->si_gc_list_mutex);
 }
 
+// Sindex bulk loads collect record handles before inserting them - while held,
+// a GC cycle won't sweep (and then free) records deleted since collection.
+uint32_t
+as_sindex_gc_hold(as_namespace* ns)
+{
+	cf_mutex_lock(&ns->si_gc_list_mutex);
+
+	uint32_t epoch = ns->si_gc_hold_epoch;
+
+	as_incr_uint32(&ns->si_gc_n_holds[epoch]);
+
+	cf_mutex_unlock(&ns->si_gc_list_mutex);
+
+	return epoch;
+}
+
+void
+as_sindex_gc_release_hold(as_namespace* ns, uint32_t epoch)
+{
+	as_decr_uint32(&ns->si_gc_n_holds[epoch]);
+}
+
 
 //==========================================================
 // Local helpers.
@@ -184,9 +217,41 @@ gc_ns_cycle(as_namespace* ns)
 	ns->si_gc_rlist = cf_queue_create(sizeof(rlist_ele), false);
 	ns->si_gc_tlist = cf_queue_create(sizeof(as_index_tree*), false);
 
+	uint32_t* n_pid = cf_malloc(sizeof(ns->si_gc_rlist_n_pid));
+
+	memcpy(n_pid, ns->si_gc_rlist_n_pid, sizeof(ns->si_gc_rlist_n_pid));
+	memset(ns->si_gc_rlist_n_pid, 0, sizeof(ns->si_gc_rlist_n_pid));
+
+	// Partitions with dropped trees must be swept too - put them first.
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		for (uint32_t tree_id = 0; tree_id < MAX_NUM_TREE_IDS; tree_id++) {
+			if (ns->si_gc_tlist_map[pid][tree_id]) {
+				n_pid[pid] = UINT32_MAX;
+				break;
+			}
+		}
+	}
+
+	uint32_t epoch = ns->si_gc_hold_epoch;
+
+	ns->si_gc_hold_epoch = epoch ^ 1;
+
 	cf_mutex_unlock(&ns->si_gc_list_mutex);
 
-	gc_ns(ns);
+	// Holds taken before the swap may have collected records now in rlist -
+	// wait for them to be inserted so the sweep below finds them.
+	while (as_load_uint32(&ns->si_gc_n_holds[epoch]) != 0) {
+		usleep(1000);
+	}
+
+	uint16_t* pids = cf_malloc(AS_PARTITIONS * sizeof(uint16_t));
+	uint32_t n_pids = gc_order_pids(n_pid, pids);
+
+	cf_free(n_pid);
+
+	gc_ns(ns, pids, n_pids);
+
+	cf_free(pids);
 
 	rlist_ele ele;
 
@@ -219,10 +284,51 @@ gc_ns_cycle(as_namespace* ns)
 	cf_queue_destroy(tlist);
 }
 
+// Only partitions that had records deleted (or trees dropped) can have keys
+// to clean - sweep just those, busiest first.
+static uint32_t
+gc_order_pids(const uint32_t* n_pid, uint16_t* pids)
+{
+	pid_count* counts = cf_malloc(AS_PARTITIONS * sizeof(pid_count));
+	uint32_t n_pids = 0;
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		if (n_pid[pid] != 0) {
+			counts[n_pids++] = (pid_count){
+					.count = n_pid[pid],
+					.pid = (uint16_t)pid
+			};
+		}
+	}
+
+	qsort(counts, n_pids, sizeof(pid_count), pid_count_cmp);
+
+	for (uint32_t i = 0; i < n_pids; i++) {
+		pids[i] = counts[i].pid;
+	}
+
+	cf_free(counts);
+
+	return n_pids;
+}
+
+static int
+pid_count_cmp(const void* pa, const void* pb)
+{
+	const pid_count* a = (const pid_count*)pa;
+	const pid_count* b = (const pid_count*)pb;
+
+	if (a->count != b->count) {
+		return a->count > b->count ? -1 : 1;
+	}
+
+	return a->pid < b->pid ? -1 : (a->pid > b->pid ? 1 : 0);
+}
+
 static void
-gc_ns(as_namespace* ns)
+gc_ns(as_namespace* ns, const uint16_t* pids, uint32_t n_pids)
 {
-	cf_info(AS_SINDEX, "{%s} sindex-gc-start", ns->name);
+	cf_info(AS_SINDEX, "{%s} sindex-gc-start: partitions %u", ns->name, n_pids);
 
 	uint64_t start_ms = cf_getms();
 	uint64_t n_cleaned = ns->n_sindex_gc_cleaned;
@@ -241,7 +347,7 @@ gc_ns(as_namespace* ns)
 
 		SINDEX_GRUNLOCK();
 
-		as_sindex_tree_gc(si);
+		as_sindex_tree_gc(si, pids, n_pids);
 
 		as_sindex_release(si);
 	}
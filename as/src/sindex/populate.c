@@ -38,12 +38,15 @@
 
 #include "cf_thread.h"
 #include "log.h"
+#include "xmem.h"
 
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/exp.h"
 #include "base/index.h"
 #include "base/set_index.h"
 #include "fabric/partition.h"
+#include "sindex/gc.h"
 #include "sindex/sindex.h"
 #include "sindex/sindex_tree.h"
 #include "storage/storage.h"
@@ -84,6 +87,7 @@ typedef struct populate_cb_info_s {
 	as_namespace* ns;
 	as_sindex* si;
 	as_index_tree* tree;
+	as_sindex_bulk* bulk; // NULL if inserting record by record
 	uint64_t* p_n_total_reduced;
 	bool* p_aborted;
 	uint32_t n_reduced;
@@ -143,10 +147,11 @@ as_sindex_populate_startup(void)
 			continue;
 		}
 
-		if (! ns->storage_data_in_memory) {
+		if (! ns->storage_data_in_memory && ! ns->sindexes_built_at_load) {
 			populate_startup(ns);
 		}
-		// else - data-in-memory (cold or cool restart) - already built sindex.
+		// else - data-in-memory (cold or cool restart), or cold start sweep -
+		// already built sindex.
 
 		mark_all_readable(ns);
 
@@ -372,6 +377,12 @@ run_populate(void* udata)
 			.p_aborted = &popi->aborted
 	};
 
+	// Bulk load relies on sindex GC's rlist to keep deleted records' handles
+	// valid until they're inserted - not used for data-in-memory or all-flash.
+	bool use_bulk = ! ns->storage_data_in_memory &&
+			ns->xmem_type != CF_XMEM_TYPE_FLASH;
+
+	as_sindex_bulk bulk;
 	uint32_t pid;
 
 	while ((pid = as_faa_uint32(&popi->pid, 1)) < AS_PARTITIONS) {
@@ -391,11 +402,24 @@ run_populate(void* udata)
 
 		cbi.tree = tree;
 
+		uint32_t epoch = 0;
+
+		if (use_bulk) {
+			epoch = as_sindex_gc_hold(ns);
+			as_sindex_tree_bulk_start(popi->si, pid, &bulk);
+			cbi.bulk = &bulk;
+		}
+
 		if (! as_set_index_reduce(ns, tree, popi->si->set_id, NULL,
 				populate_reduce_cb, &cbi)) {
 			as_index_reduce_live(tree, populate_reduce_cb, &cbi);
 		}
 
+		if (use_bulk) {
+			as_sindex_tree_bulk_finish(&bulk, popi->aborted);
+			as_sindex_gc_release_hold(ns, epoch);
+		}
+
 		as_partition_release(&rsv);
 	}
 
@@ -456,7 +480,12 @@ populate_reduce_cb(as_index_ref* r_ref, void* udata)
 		return true;
 	}
 
-	as_sindex_put_rd(si, &rd, r_ref);
+	if (cbi->bulk != NULL) {
+		as_sindex_bulk_put_rd(cbi->bulk, &rd, r_ref);
+	}
+	else {
+		as_sindex_put_rd(si, &rd, r_ref);
+	}
 
 	as_storage_record_close(&rd);
 	as_record_done(r_ref, ns);
@@ -507,6 +536,18 @@ run_destroy_sindex(void* udata)
 			cf_free(si->ctx_buf);
 		}
 
+		if (si->exp != NULL) {
+			as_exp_destroy(si->exp);
+		}
+
+		if (si->exp_b64 != NULL) {
+			cf_free(si->exp_b64);
+		}
+
+		if (si->exp_buf != NULL) {
+			cf_free(si->exp_buf);
+		}
+
 		cf_rc_free(si);
 	}
 
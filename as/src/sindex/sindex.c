@@ -48,8 +48,10 @@
 #include "base/cdt.h"
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/exp.h"
 #include "base/index.h"
 #include "base/smd.h"
+#include "fabric/partition.h"
 #include "geospatial/geospatial.h"
 #include "sindex/gc.h"
 #include "sindex/populate.h"
@@ -75,6 +77,10 @@ typedef struct as_sindex_def_s {
 	char* ctx_b64;
 	uint8_t* ctx_buf;
 	uint32_t ctx_buf_sz;
+	char* exp_b64;
+	uint8_t* exp_buf;
+	uint32_t exp_buf_sz;
+	as_exp* exp;
 } as_sindex_def;
 
 typedef struct defn_hash_ele_s {
@@ -126,7 +132,7 @@ static bool bin_bitmap_is_set(const as_namespace* ns, uint32_t bin_id);
 static uint32_t si_arr_by_set_and_bin(const as_namespace* ns, uint16_t set_id, uint16_t bin_id, as_sindex** si_arr);
 static uint32_t sbins_arr_from_bin(as_namespace* ns, uint16_t set_id, const as_bin* b, as_sindex_bin* start_sbin, as_sindex_op op);
 static cf_ll* si_list_by_defn(const as_namespace* ns, uint16_t set_id, uint16_t bin_id);
-static as_sindex* si_by_defn(const as_namespace* ns, uint16_t set_id, uint16_t bin_id, as_particle_type ktype, as_sindex_type itype, const uint8_t* ctx_buf, uint32_t ctx_buf_sz);
+static as_sindex* si_by_defn(const as_namespace* ns, uint16_t set_id, uint16_t bin_id, as_particle_type ktype, as_sindex_type itype, const uint8_t* ctx_buf, uint32_t ctx_buf_sz, const uint8_t* exp_buf, uint32_t exp_buf_sz);
 static bool compare_ctx(const uint8_t* ctx1_buf, uint32_t ctx1_buf_sz, const uint8_t* ctx2_buf, uint32_t ctx2_buf_sz);
 
 static bool sbin_from_bin(as_sindex* si, const as_bin* b, as_sindex_bin* sbin);
@@ -185,6 +191,18 @@ as_sindex_def_free(as_sindex_def* def)
 	if (def->ctx_buf != NULL) {
 		cf_free(def->ctx_buf);
 	}
+
+	if (def->exp != NULL) {
+		as_exp_destroy(def->exp);
+	}
+
+	if (def->exp_b64 != NULL) {
+		cf_free(def->exp_b64);
+	}
+
+	if (def->exp_buf != NULL) {
+		cf_free(def->exp_buf);
+	}
 }
 
 static inline uint32_t
@@ -338,6 +356,35 @@ as_sindex_put_rd(as_sindex* si, as_storage_rd* rd, as_index_ref* r_ref)
 	}
 }
 
+void
+as_sindex_bulk_put_rd(as_sindex_bulk* bulk, as_storage_rd* rd,
+		as_index_ref* r_ref)
+{
+	as_sindex* si = bulk->si;
+	as_bin* b = as_bin_get_live(rd, si->bin_name);
+
+	if (b == NULL) {
+		return;
+	}
+
+	as_sindex_bin sbin;
+
+	init_sbin(&sbin, AS_SINDEX_OP_INSERT, si);
+
+	if (sbin_from_bin(si, b, &sbin)) {
+		// Mark record for sindex before collection.
+		as_index_set_in_sindex(r_ref->r);
+
+		for (uint32_t j = 0; j < sbin.n_values; j++) {
+			int64_t bval = j == 0 ? sbin.val : sbin.values[j];
+
+			as_sindex_tree_bulk_add(bulk, bval, r_ref->r_h);
+		}
+
+		sbin_free(&sbin);
+	}
+}
+
 
 //==========================================================
 // Public API - modify sindexes from writes/deletes.
@@ -430,7 +477,8 @@ as_sindex_sbin_free_all(as_sindex_bin* sbin, uint32_t n_sbins)
 as_sindex*
 as_sindex_lookup_by_defn(const as_namespace* ns, uint16_t set_id,
 		uint16_t bin_id, as_particle_type ktype, as_sindex_type itype,
-		const uint8_t* ctx_buf, uint32_t ctx_buf_sz)
+		const uint8_t* ctx_buf, uint32_t ctx_buf_sz, const uint8_t* exp_buf,
+		uint32_t exp_buf_sz)
 {
 	SINDEX_GRLOCK();
 
@@ -440,11 +488,11 @@ as_sindex_lookup_by_defn(const as_namespace* ns, uint16_t set_id,
 	}
 
 	as_sindex* si = si_by_defn(ns, set_id, bin_id, ktype, itype, ctx_buf,
-			ctx_buf_sz);
+			ctx_buf_sz, exp_buf, exp_buf_sz);
 
 	if (si == NULL && set_id != INVALID_SET_ID) {
 		si = si_by_defn(ns, INVALID_SET_ID, bin_id, ktype, itype, ctx_buf,
-				ctx_buf_sz);
+				ctx_buf_sz, exp_buf, exp_buf_sz);
 	}
 
 	if (si != NULL) {
@@ -456,6 +504,26 @@ as_sindex_lookup_by_defn(const as_namespace* ns, uint16_t set_id,
 	return si;
 }
 
+// Evaluates an expression sindex's expression against the sindex bin alone -
+// valid since the expression reads no other record data. Caller must destroy
+// rb's particle if true is returned.
+bool
+as_sindex_exp_eval(const as_sindex* si, const as_bin* b, as_bin* rb)
+{
+	as_storage_rd rd = {
+			.ns = si->ns,
+			.bins = (as_bin*)b,
+			.n_bins = 1
+	};
+
+	as_exp_ctx ctx = {
+			.ns = si->ns,
+			.rd = &rd
+	};
+
+	return as_exp_eval(si->exp, &ctx, rb, NULL, false);
+}
+
 
 //==========================================================
 // Public API - GC.
@@ -570,6 +638,135 @@ as_sindex_stats_str(as_namespace* ns, char* iname, cf_dyn_buf* db)
 	return true;
 }
 
+bool
+as_sindex_estimate_str(as_namespace* ns, const char* iname, int64_t start,
+		int64_t end, cf_dyn_buf* db)
+{
+	SINDEX_GRLOCK();
+
+	as_sindex* si = as_sindex_lookup_by_iname_lockfree(ns, iname);
+
+	if (si == NULL) {
+		SINDEX_GRUNLOCK();
+		return false;
+	}
+
+	uint64_t n_keys = as_sindex_tree_n_keys(si);
+	uint64_t n_est = as_sindex_tree_estimate_range(si, start, end);
+
+	info_append_uint64(db, "entries", n_keys);
+	info_append_uint64(db, "estimated_entries", n_est);
+	info_append_format(db, "estimated_pct", "%.3f",
+			n_keys == 0 ? 0.0 : (double)(n_est * 100) / (double)n_keys);
+	info_append_bool(db, "has_histogram", si->has_hist);
+
+	cf_dyn_buf_chomp(db);
+
+	SINDEX_GRUNLOCK();
+
+	return true;
+}
+
+// Aggregates are over index entries, so records of the set lacking the bin,
+// or with a bin of the wrong type, don't contribute. Deleted and expired
+// records contribute until sindex GC removes their entries.
+bool
+as_sindex_aggregate_str(as_namespace* ns, const char* iname, bool master_only,
+		cf_dyn_buf* db)
+{
+	SINDEX_GRLOCK();
+
+	as_sindex* si = as_sindex_lookup_by_iname_lockfree(ns, iname);
+
+	if (si == NULL) {
+		SINDEX_GRUNLOCK();
+		return false;
+	}
+
+	as_sindex_tree_agg agg = { 0 };
+	uint32_t n_pids = 0;
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		// Unlocked - a partition changing hands may be missed or counted.
+		if (master_only &&
+				ns->partitions[pid].working_master != g_config.self_node) {
+			continue;
+		}
+
+		as_sindex_tree_aggregate(si, pid, &agg);
+		n_pids++;
+	}
+
+	info_append_uint32(db, "partitions", n_pids);
+	info_append_bool(db, "readable", si->readable);
+	info_append_uint64(db, "entries", agg.n_keys);
+
+	// Other key types index hashes of values.
+	if (si->ktype == AS_PARTICLE_TYPE_INTEGER) {
+		info_append_format(db, "sum", "%ld", agg.sum);
+
+		if (agg.n_keys != 0) {
+			info_append_format(db, "min", "%ld", agg.min);
+			info_append_format(db, "max", "%ld", agg.max);
+		}
+	}
+
+	cf_dyn_buf_chomp(db);
+
+	SINDEX_GRUNLOCK();
+
+	return true;
+}
+
+// Like the aggregates, but resolves each entry's record in the primary index,
+// so deleted, expired and truncated records don't count.
+bool
+as_sindex_count_str(as_namespace* ns, const char* iname, int64_t start,
+		int64_t end, bool master_only, const as_sindex_count_filter* filter,
+		cf_dyn_buf* db)
+{
+	SINDEX_GRLOCK();
+
+	as_sindex* si = as_sindex_lookup_by_iname_lockfree(ns, iname);
+
+	if (si == NULL) {
+		SINDEX_GRUNLOCK();
+		return false;
+	}
+
+	uint64_t n_counted = 0;
+	uint32_t n_pids = 0;
+
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		// Unlocked - a partition changing hands may be missed or counted.
+		if (master_only &&
+				ns->partitions[pid].working_master != g_config.self_node) {
+			continue;
+		}
+
+		as_partition_reservation rsv;
+
+		as_partition_reserve(ns, pid, &rsv);
+
+		if (rsv.tree != NULL) {
+			n_counted += as_sindex_tree_count(si, &rsv, start, end, filter);
+			n_pids++;
+		}
+
+		as_partition_release(&rsv);
+	}
+
+	info_append_uint32(db, "partitions", n_pids);
+	info_append_bool(db, "readable", si->readable);
+	info_append_uint64(db, "count", n_counted);
+
+	cf_dyn_buf_chomp(db);
+
+	SINDEX_GRUNLOCK();
+
+	return true;
+}
+
 void
 as_sindex_list_str(const as_namespace* ns, bool b64, cf_dyn_buf* db)
 {
@@ -609,6 +806,17 @@ as_sindex_list_str(const as_namespace* ns, bool b64, cf_dyn_buf* db)
 			}
 		}
 
+		if (si->exp != NULL) {
+			cf_dyn_buf_append_string(db, ":exp=");
+
+			if (b64) {
+				cf_dyn_buf_append_string(db, si->exp_b64);
+			}
+			else {
+				as_exp_display(si->exp, db);
+			}
+		}
+
 		if (si->readable) {
 			cf_dyn_buf_append_string(db, ":state=RW");
 		}
@@ -624,18 +832,21 @@ as_sindex_list_str(const as_namespace* ns, bool b64, cf_dyn_buf* db)
 
 void
 as_sindex_build_smd_key(const char* ns_name, const char* set_name,
-		const char* bin_name, const char* cdt_ctx, as_sindex_type itype,
-		as_particle_type ktype, char* smd_key)
+		const char* bin_name, const char* cdt_ctx, const char* exp,
+		as_sindex_type itype, as_particle_type ktype, char* smd_key)
 {
 	// ns-name|<set-name>|bin-name|itype|ktype
 
-	sprintf(smd_key, "%s|%s|%s%s%s|%c|%c",
+	sprintf(smd_key, "%s|%s|%s%s%s%s%s|%c|%c",
 			ns_name,
 			set_name == NULL ? "" : set_name,
 			bin_name,
 			// The 'c' prefix ensures older nodes reject entries with a context.
 			cdt_ctx == NULL ? "" : "|c",
 			cdt_ctx == NULL ? "" : cdt_ctx,
+			// Likewise the 'x' prefix for entries with an expression.
+			exp == NULL ? "" : "|x",
+			exp == NULL ? "" : exp,
 			itype_to_smd_char(itype),
 			ktype_to_smd_char(ktype));
 }
@@ -689,6 +900,41 @@ as_sindex_cdt_ctx_b64_decode(const char* ctx_b64, uint32_t ctx_b64_len,
 	return (int32_t)buf_sz_out;
 }
 
+// The expression is built over the decoded wire buffer, so the buffer must
+// outlive it.
+int32_t
+as_sindex_exp_b64_decode(const char* exp_b64, uint32_t exp_b64_len,
+		const char* bin_name, uint8_t** buf_r, as_exp** exp_r)
+{
+	uint32_t buf_sz = cf_b64_decoded_buf_size(exp_b64_len);
+	uint32_t buf_sz_out;
+	uint8_t* buf = cf_malloc(buf_sz);
+
+	if (! cf_b64_validate_and_decode(exp_b64, exp_b64_len, buf, &buf_sz_out)) {
+		cf_free(buf);
+		return -1;
+	}
+
+	as_exp* exp = as_exp_build_buf(buf, buf_sz_out, false);
+
+	if (exp == NULL) {
+		cf_free(buf);
+		return -2;
+	}
+
+	// Indexed values are computed from the bin alone, on write and populate.
+	if (! as_exp_is_bin_function(exp, bin_name)) {
+		as_exp_destroy(exp);
+		cf_free(buf);
+		return -3;
+	}
+
+	*buf_r = buf;
+	*exp_r = exp;
+
+	return (int32_t)buf_sz_out;
+}
+
 
 //==========================================================
 // Local helpers - create, delete, rename sindexes.
@@ -790,6 +1036,8 @@ smd_item_to_def(const char* smd_key, const char* smd_value, as_sindex_def* def)
 
 	const char* ctx_start = NULL;
 	uint32_t ctx_len = 0;
+	const char* exp_start = NULL;
+	uint32_t exp_len = 0;
 
 	if (*read == 'c') {
 		if (tok == NULL) {
@@ -809,6 +1057,24 @@ smd_item_to_def(const char* smd_key, const char* smd_value, as_sindex_def* def)
 		read = tok + 1;
 		tok = strchr(read, TOK_CHAR_DELIMITER);
 	}
+	else if (*read == 'x') {
+		if (tok == NULL) {
+			cf_warning(AS_SINDEX, "smd - expression missing delimiter");
+			return false;
+		}
+
+		exp_start = read + 1;
+		exp_len = (uint32_t)(tok - exp_start);
+
+		if (exp_len >= EXP_B64_MAX_SZ) {
+			cf_warning(AS_SINDEX, "smd - expression too long");
+			return false;
+		}
+
+		// Parsed at the end, like context.
+		read = tok + 1;
+		tok = strchr(read, TOK_CHAR_DELIMITER);
+	}
 
 	if (tok == NULL) {
 		cf_warning(AS_SINDEX, "smd - itype missing delimiter");
@@ -873,6 +1139,30 @@ smd_item_to_def(const char* smd_key, const char* smd_value, as_sindex_def* def)
 		def->ctx_buf_sz = (uint32_t)buf_sz;
 	}
 
+	if (exp_start != NULL) {
+		char* exp_b64 = cf_malloc(exp_len + 1);
+		uint8_t* buf = NULL;
+		as_exp* exp = NULL;
+
+		memcpy(exp_b64, exp_start, exp_len);
+		exp_b64[exp_len] = '\0';
+
+		int32_t buf_sz = as_sindex_exp_b64_decode(exp_b64, exp_len,
+				def->bin_name, &buf, &exp);
+
+		if (buf_sz < 0) {
+			cf_warning(AS_SINDEX, "smd - invalid expression decode result %d",
+					buf_sz);
+			cf_free(exp_b64);
+			return false;
+		}
+
+		def->exp_b64 = exp_b64;
+		def->exp_buf = buf;
+		def->exp_buf_sz = (uint32_t)buf_sz;
+		def->exp = exp;
+	}
+
 	return true;
 }
 
@@ -915,7 +1205,8 @@ smd_create(as_sindex_def* def, bool startup)
 	}
 
 	if ((cur_si = si_by_defn(ns, set_id, bin_id, def->ktype, def->itype,
-			def->ctx_buf, def->ctx_buf_sz)) != NULL) {
+			def->ctx_buf, def->ctx_buf_sz, def->exp_buf,
+			def->exp_buf_sz)) != NULL) {
 		cf_info(AS_SINDEX, "SINDEX CREATE: renaming %s to %s", cur_si->iname,
 				def->iname);
 
@@ -943,6 +1234,10 @@ smd_create(as_sindex_def* def, bool startup)
 			.ctx_b64 = def->ctx_b64,
 			.ctx_buf = def->ctx_buf,
 			.ctx_buf_sz = def->ctx_buf_sz,
+			.exp_b64 = def->exp_b64,
+			.exp_buf = def->exp_buf,
+			.exp_buf_sz = def->exp_buf_sz,
+			.exp = def->exp,
 			.n_btrees = AS_PARTITIONS
 	};
 
@@ -953,6 +1248,9 @@ smd_create(as_sindex_def* def, bool startup)
 	// These are now owned by si - don't free outside.
 	def->ctx_b64 = NULL;
 	def->ctx_buf = NULL;
+	def->exp_b64 = NULL;
+	def->exp_buf = NULL;
+	def->exp = NULL;
 
 	if (ns->flat_sindexes == NULL) {
 		add_to_sindexes(si);
@@ -1017,7 +1315,7 @@ smd_drop(as_sindex_def* def)
 	}
 
 	as_sindex* si = si_by_defn(ns, set_id, bin_id, def->ktype, def->itype,
-			def->ctx_buf, def->ctx_buf_sz);
+			def->ctx_buf, def->ctx_buf_sz, def->exp_buf, def->exp_buf_sz);
 
 	if (si == NULL) {
 		cf_warning(AS_SINDEX, "SINDEX DROP: defn not found");
@@ -1264,7 +1562,7 @@ si_list_by_defn(const as_namespace* ns, uint16_t set_id, uint16_t bin_id)
 static as_sindex*
 si_by_defn(const as_namespace* ns, uint16_t set_id, uint16_t bin_id,
 		as_particle_type ktype, as_sindex_type itype, const uint8_t* ctx_buf,
-		uint32_t ctx_buf_sz)
+		uint32_t ctx_buf_sz, const uint8_t* exp_buf, uint32_t exp_buf_sz)
 {
 	cf_ll* si_ll = si_list_by_defn(ns, set_id, bin_id);
 
@@ -1279,7 +1577,8 @@ si_by_defn(const as_namespace* ns, uint16_t set_id, uint16_t bin_id,
 		as_sindex* si = prop_ele->si;
 
 		if (si->ktype == ktype && si->itype == itype &&
-				compare_ctx(si->ctx_buf, si->ctx_buf_sz, ctx_buf, ctx_buf_sz)) {
+				compare_ctx(si->ctx_buf, si->ctx_buf_sz, ctx_buf, ctx_buf_sz) &&
+				compare_ctx(si->exp_buf, si->exp_buf_sz, exp_buf, exp_buf_sz)) {
 			return si;
 		}
 
@@ -1336,6 +1635,15 @@ sbin_from_bin(as_sindex* si, const as_bin* b, as_sindex_bin* sbin)
 
 		b = &ctx_bin;
 	}
+	else if (si->exp != NULL) {
+		// Index the expression's value - ctx_bin holds it.
+		if (! as_sindex_exp_eval(si, b, &ctx_bin)) {
+			return false;
+		}
+
+		type = as_bin_get_particle_type(&ctx_bin);
+		b = &ctx_bin;
+	}
 
 	bool rv;
 
@@ -1354,7 +1662,7 @@ sbin_from_bin(as_sindex* si, const as_bin* b, as_sindex_bin* sbin)
 		cf_crash(AS_SINDEX, "invalid index type %d", si->itype);
 	}
 
-	if (si->ctx_buf != NULL) {
+	if (si->ctx_buf != NULL || si->exp != NULL) {
 		as_bin_particle_destroy(&ctx_bin);
 	}
 
@@ -1382,7 +1690,7 @@ sbin_from_simple_bin(as_sindex* si, const as_bin* b, as_sindex_bin* sbin)
 			return false;
 		}
 
-		add_value_to_sbin(sbin, as_sindex_string_to_bval(str, len));
+		add_value_to_sbin(sbin, as_sindex_string_to_bval(si->ns, str, len));
 
 		return true;
 	}
@@ -1530,7 +1838,8 @@ add_string_from_msgpack(msgpack_in* element, as_sindex_bin* sbin)
 	str++;
 	str_sz--;
 
-	add_value_to_sbin(sbin, as_sindex_string_to_bval((const char*)str, str_sz));
+	add_value_to_sbin(sbin, as_sindex_string_to_bval(sbin->si->ns,
+			(const char*)str, str_sz));
 }
 
 static void
@@ -43,9 +43,10 @@
 
 void
 as_sindex_arena_init(as_sindex_arena* arena, key_t key_base, uint32_t ele_sz,
-		size_t stage_sz)
+		size_t stage_sz, const char* flash_dir)
 {
 	arena->key_base = key_base;
+	arena->flash_dir = flash_dir;
 
 	arena->ele_sz = ele_sz;
 	arena->stage_capacity = (uint32_t)(stage_sz / ele_sz);
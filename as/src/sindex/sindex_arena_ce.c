@@ -26,6 +26,15 @@
 
 #include "sindex/sindex_arena.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
 #include "citrusleaf/alloc.h"
 
 #include "log.h"
@@ -33,6 +42,13 @@
 #include "warnings.h"
 
 
+//==========================================================
+// Forward declarations.
+//
+
+static uint8_t* flash_stage_map(const as_sindex_arena* arena);
+
+
 //==========================================================
 // Private API - for enterprise separation only.
 //
@@ -46,14 +62,20 @@ si_arena_add_stage(as_sindex_arena* arena)
 				SI_ARENA_MAX_STAGES);
 	}
 
-	arena->stages[arena->n_stages++] = cf_malloc(arena->stage_sz);
+	arena->stages[arena->n_stages++] = arena->flash_dir != NULL ?
+			flash_stage_map(arena) : cf_malloc(arena->stage_sz);
 }
 
 void
 si_arena_reset(as_sindex_arena* arena)
 {
 	for (uint32_t i = 0; i < arena->n_stages; i++) {
-		cf_free(arena->stages[i]);
+		if (arena->flash_dir != NULL) {
+			munmap(arena->stages[i], arena->stage_sz);
+		}
+		else {
+			cf_free(arena->stages[i]);
+		}
 	}
 
 	arena->free_h = 0;
@@ -65,3 +87,49 @@ si_arena_reset(as_sindex_arena* arena)
 	arena->n_stages = 0;
 	memset(arena->stages, 0, sizeof(arena->stages));
 }
+
+
+//==========================================================
+// Local helpers.
+//
+
+// Stage is an unlinked file on flash, mapped shared - the page cache keeps the
+// hot part of the tree (upper levels, busy leaves) in memory and the kernel
+// writes dirty pages back in the background. Nothing needs to survive a
+// restart - sindexes are rebuilt at startup - so the file is unlinked at once.
+static uint8_t*
+flash_stage_map(const as_sindex_arena* arena)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/sindex-stage-XXXXXX", arena->flash_dir);
+
+	int fd = mkstemp(path);
+
+	if (fd == -1) {
+		cf_crash(AS_SINDEX, "failed to create arena stage file in %s: %s",
+				arena->flash_dir, cf_strerror(errno));
+	}
+
+	unlink(path);
+
+	if (ftruncate(fd, (off_t)arena->stage_sz) != 0) {
+		cf_crash(AS_SINDEX, "failed to size arena stage file in %s: %s",
+				arena->flash_dir, cf_strerror(errno));
+	}
+
+	void* stage = mmap(NULL, arena->stage_sz, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+
+	if (stage == MAP_FAILED) {
+		cf_crash(AS_SINDEX, "failed to map arena stage file in %s: %s",
+				arena->flash_dir, cf_strerror(errno));
+	}
+
+	close(fd);
+
+	// Tree lookups hop between nodes - readahead would only waste cache.
+	madvise(stage, arena->stage_sz, MADV_RANDOM);
+
+	return (uint8_t*)stage;
+}
@@ -31,20 +31,24 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <xmmintrin.h>
 
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_digest.h"
 #include "citrusleaf/cf_hash_math.h"
+#include "citrusleaf/cf_random.h"
 
 #include "arenax.h"
 #include "bits.h"
 #include "log.h"
 #include "xmem.h"
 
+#include "base/cfg.h"
 #include "base/datamodel.h"
 #include "base/index.h"
 #include "fabric/partition.h"
@@ -66,11 +70,18 @@
 
 #define MAX_GC_BURST 1000
 #define MAX_GC_BURST_AF 30 // limit primary index IO under sindex tree lock
+#define GC_CLOCK_CHECK_INTERVAL 32 // keys between lock-hold time checks
 
 #define MAX_QUERY_BURST 100
 
 #define MAX_CARDINALITY_BURST 1000
 
+#define HIST_N_SAMPLES (64 * SINDEX_HIST_N_BUCKETS)
+
+#define BULK_KEYS_START_CAPACITY 1024
+#define BULK_DELETES_START_CAPACITY 64
+#define HANDLES_START_CAPACITY 1024
+
 #define CACHE_LINE_SZ 64
 
 #define HLL_N_INDEX_BITS 16
@@ -98,11 +109,14 @@ typedef struct gc_collect_cb_info_s {
 	as_namespace* ns;
 
 	uint32_t max_burst;
+	uint64_t max_lock_ns; // 0 means bounded only by max_burst
+	uint64_t start_ns;
 
 	uint32_t n_keys_reduced;
 	uint32_t n_keys;
 	si_btree_key* keys;
 
+	bool stopped;
 	search_key last;
 } gc_collect_cb_info;
 
@@ -119,6 +133,35 @@ typedef struct query_collect_cb_info_s {
 	search_key last;
 } query_collect_cb_info;
 
+typedef struct count_cb_info_s {
+	as_namespace* ns;
+	cf_arenax* arena;
+	as_index_tree* tree;
+	const as_sindex_count_filter* filter;
+
+	uint32_t n_keys_reduced;
+	uint64_t n_counted;
+
+	search_key last;
+} count_cb_info;
+
+typedef struct handles_collect_cb_info_s {
+	cf_arenax* arena;
+
+	uint32_t n_keys_reduced;
+	uint32_t n_handles;
+	uint32_t capacity;
+	cf_arenax_handle* handles;
+
+	search_key last;
+} handles_collect_cb_info;
+
+typedef struct si_bulk_key_s {
+	int64_t bval;
+	cf_digest keyd;
+	cf_arenax_handle r_h;
+} si_bulk_key;
+
 typedef struct hyperloglog_s {
 	uint8_t registers[HLL_REGISTERS_SZ];
 } hyperloglog;
@@ -130,6 +173,8 @@ typedef struct cardinality_collect_cb_info_s {
 	hyperloglog* bval_hll;
 	hyperloglog* rec_hll;
 
+	int64_t* samples; // reservoir of HIST_N_SAMPLES bvals
+
 	uint32_t n_keys_reduced;
 
 	search_key last;
@@ -144,12 +189,27 @@ static void gc_reduce_and_delete(as_sindex* si, si_btree* bt);
 static bool gc_collect_cb(const si_btree_key* key, void* udata);
 static void query_reduce(si_btree* bt, as_partition_reservation* rsv, int64_t start_bval, int64_t end_bval, int64_t resume_bval, cf_digest* keyd, bool de_dup, as_sindex_reduce_fn cb, void* udata);
 static bool query_collect_cb(const si_btree_key* key, void* udata);
-static void cardinality_reduce(as_sindex* si, si_btree* bt, uint64_t* n_keys, hyperloglog* bval_hll, hyperloglog* rec_hll);
+static bool count_cb(const si_btree_key* key, void* udata);
+static bool count_filter_match(const as_sindex_count_filter* filter, const as_index* r);
+static bool handles_collect_cb(const si_btree_key* key, void* udata);
+static int handle_cmp(const void* pa, const void* pb);
+static void cardinality_reduce(as_sindex* si, si_btree* bt, uint64_t* n_keys, hyperloglog* bval_hll, hyperloglog* rec_hll, int64_t* samples);
+static void build_hist(as_sindex* si, int64_t* samples, uint32_t n_samples);
+static int bval_sort_cmp(const void* pa, const void* pb);
+static int bval_sort_cmp_unsigned(const void* pa, const void* pb);
 static bool cardinality_collect_cb(const si_btree_key* key, void* udata);
 
 static si_btree* si_btree_create(cf_arenax* arena, as_sindex_arena* si_arena, bool unsigned_bvals, uint32_t si_id, uint16_t tree_ix);
 static void si_btree_destroy(si_btree* bt);
 static bool si_btree_put(si_btree* bt, const si_btree_key* key);
+static bool si_btree_delete_key(si_btree* bt, const si_btree_key* key, bool log);
+static bool si_btree_put_locked(si_btree* bt, const si_btree_key* key);
+static bool si_btree_delete_locked(si_btree* bt, const si_btree_key* key);
+static void si_btree_min_max(si_btree* bt, int64_t* min, int64_t* max);
+
+static int bulk_key_cmp(const void* pa, const void* pb, void* udata);
+static si_arena_handle bulk_build(const si_btree* bt, si_btree_key* keys, uint32_t n_keys, uint64_t* n_nodes);
+static void bulk_merge_live(si_btree* bt, si_arena_handle node_h);
 
 static void btree_destroy(si_btree* bt, si_arena_handle node_h);
 static bool btree_put(si_btree* bt, si_btree_node* node, const si_btree_key* key);
@@ -170,6 +230,7 @@ static void move_keys(const si_btree* bt, si_btree_node* dst, uint32_t dst_i, si
 static void move_children(const si_btree* bt, si_btree_node* dst, uint32_t dst_i, si_btree_node* src, uint32_t src_i, uint32_t n_children);
 static key_bound greatest_lower_bound(const si_btree* bt, const si_btree_node* node, const si_btree_key* key);
 static key_bound left_bound(const si_btree* bt, const si_btree_node* node, const search_key* skey);
+static uint32_t leaf_end(const si_btree* bt, const si_btree_node* node, uint32_t from, const search_key* end_skey);
 static void split_child(si_btree* bt, si_btree_node* node, uint32_t i, si_btree_node* child);
 static void merge_children(si_btree* bt, si_btree_node* node, uint32_t i, si_btree_node* left, si_arena_handle right_h);
 
@@ -388,11 +449,48 @@ as_sindex_tree_mem_size(const as_sindex* si)
 	return n_nodes * si->ns->si_arena->ele_sz; // ignore si_btree overhead
 }
 
+uint64_t
+as_sindex_tree_n_mods(const as_sindex* si, uint32_t pid)
+{
+	return as_load_uint64(&si->btrees[pid]->n_mods);
+}
+
+// Count and sum are maintained on every put and delete - only min and max need
+// the tree, and then only its outermost paths.
 void
-as_sindex_tree_gc(as_sindex* si)
+as_sindex_tree_aggregate(const as_sindex* si, uint32_t pid,
+		as_sindex_tree_agg* agg)
 {
-	for (uint32_t ix = 0; ix < si->n_btrees; ix++) {
-		gc_reduce_and_delete(si, si->btrees[ix]);
+	si_btree* bt = si->btrees[pid];
+
+	pthread_rwlock_rdlock(&bt->lock);
+
+	if (bt->n_keys != 0) {
+		int64_t min;
+		int64_t max;
+
+		si_btree_min_max(bt, &min, &max);
+
+		if (agg->n_keys == 0 || min < agg->min) {
+			agg->min = min;
+		}
+
+		if (agg->n_keys == 0 || max > agg->max) {
+			agg->max = max;
+		}
+
+		agg->n_keys += bt->n_keys;
+		agg->sum = (int64_t)((uint64_t)agg->sum + bt->sum_bvals);
+	}
+
+	pthread_rwlock_unlock(&bt->lock);
+}
+
+void
+as_sindex_tree_gc(as_sindex* si, const uint16_t* pids, uint32_t n_pids)
+{
+	for (uint32_t i = 0; i < n_pids; i++) {
+		gc_reduce_and_delete(si, si->btrees[pids[i]]);
 	}
 }
 
@@ -423,7 +521,7 @@ as_sindex_tree_delete(as_sindex* si, int64_t bval, cf_arenax_handle r_h)
 			.r_h = r_h
 	};
 
-	return si_btree_delete(bt, &key);
+	return si_btree_delete_key(bt, &key, true);
 }
 
 void
@@ -452,6 +550,72 @@ as_sindex_tree_query(as_sindex* si, const as_query_range* range,
 			range->de_dup, cb, udata);
 }
 
+// Records with keys in [start, end] that pass the filter - resolves primary
+// index entries but never reads storage. Entries of CDT indexes are counted,
+// not records.
+uint64_t
+as_sindex_tree_count(as_sindex* si, as_partition_reservation* rsv,
+		int64_t start, int64_t end, const as_sindex_count_filter* filter)
+{
+	si_btree* bt = si->btrees[rsv->p->id];
+
+	count_cb_info ci = {
+			.ns = rsv->ns,
+			.arena = bt->arena,
+			.tree = rsv->tree,
+			.filter = filter,
+			.last = { .bval = start }
+	};
+
+	search_key end_skey = { .bval = end };
+
+	while (true) {
+		si_btree_reduce(bt, &ci.last, &end_skey, count_cb, &ci);
+
+		if (ci.n_keys_reduced != MAX_CARDINALITY_BURST) {
+			break;
+		}
+
+		ci.n_keys_reduced = 0;
+	}
+
+	return ci.n_counted;
+}
+
+// Sorted primary index handles of a partition's keys in [start, end] - lets a
+// query intersect indexes before reading any records. Caller frees.
+uint32_t
+as_sindex_tree_collect_handles(as_sindex* si, const as_query_range* range,
+		uint32_t pid, cf_arenax_handle** handles_r)
+{
+	si_btree* bt = si->btrees[pid];
+
+	handles_collect_cb_info ci = {
+			.arena = bt->arena,
+			.last = { .bval = range->u.r.start }
+	};
+
+	search_key end_skey = { .bval = range->u.r.end };
+
+	while (true) {
+		si_btree_reduce(bt, &ci.last, &end_skey, handles_collect_cb, &ci);
+
+		if (ci.n_keys_reduced != MAX_QUERY_BURST) {
+			break;
+		}
+
+		ci.n_keys_reduced = 0;
+	}
+
+	if (ci.n_handles > 1) {
+		qsort(ci.handles, ci.n_handles, sizeof(cf_arenax_handle), handle_cmp);
+	}
+
+	*handles_r = ci.handles;
+
+	return ci.n_handles;
+}
+
 void
 as_sindex_tree_collect_cardinality(as_sindex* si)
 {
@@ -459,12 +623,13 @@ as_sindex_tree_collect_cardinality(as_sindex* si)
 	hyperloglog bval_hll = { { 0 } };
 	hyperloglog* rec_hll = si->itype == AS_SINDEX_ITYPE_DEFAULT ?
 			NULL : cf_calloc(1, sizeof(hyperloglog));
+	int64_t* samples = cf_malloc(HIST_N_SAMPLES * sizeof(int64_t));
 
 	for (uint32_t ix = 0; ix < si->n_btrees; ix++) {
 		si_btree* bt = si->btrees[ix];
 
 		if (bt->n_keys != 0) {
-			cardinality_reduce(si, bt, &n_keys, &bval_hll, rec_hll);
+			cardinality_reduce(si, bt, &n_keys, &bval_hll, rec_hll, samples);
 
 			usleep(100);
 		}
@@ -484,6 +649,171 @@ as_sindex_tree_collect_cardinality(as_sindex* si)
 	else {
 		si->keys_per_rec = n_keys == 0 ? 0 : 1;
 	}
+
+	build_hist(si, samples,
+			n_keys < HIST_N_SAMPLES ? (uint32_t)n_keys : HIST_N_SAMPLES);
+
+	cf_free(samples);
+}
+
+// Estimate of keys with bval in [start, end] - interpolates within buckets.
+uint64_t
+as_sindex_tree_estimate_range(const as_sindex* si, int64_t start, int64_t end)
+{
+	uint64_t n_keys = as_sindex_tree_n_keys(si);
+
+	if (start == end) {
+		return si->keys_per_bval < n_keys ? si->keys_per_bval : n_keys;
+	}
+
+	if (! si->has_hist) {
+		return n_keys;
+	}
+
+	bool is_unsigned = si->ktype == AS_PARTICLE_TYPE_GEOJSON;
+	double d_start = is_unsigned ? (double)(uint64_t)start : (double)start;
+	double d_end = is_unsigned ? (double)(uint64_t)end : (double)end;
+	double n_buckets = 0.0;
+
+	for (uint32_t i = 0; i < SINDEX_HIST_N_BUCKETS; i++) {
+		int64_t lo = si->hist_bounds[i];
+		int64_t hi = si->hist_bounds[i + 1];
+		double d_lo = is_unsigned ? (double)(uint64_t)lo : (double)lo;
+		double d_hi = is_unsigned ? (double)(uint64_t)hi : (double)hi;
+
+		if (d_hi < d_start || d_lo > d_end) {
+			continue;
+		}
+
+		if (d_lo >= d_start && d_hi <= d_end) {
+			n_buckets += 1.0;
+			continue;
+		}
+
+		double from = d_lo > d_start ? d_lo : d_start;
+		double to = d_hi < d_end ? d_hi : d_end;
+
+		n_buckets += d_hi == d_lo ? 1.0 : (to - from) / (d_hi - d_lo);
+	}
+
+	return (uint64_t)((double)n_keys * n_buckets / SINDEX_HIST_N_BUCKETS);
+}
+
+void
+as_sindex_tree_bulk_start(as_sindex* si, uint32_t pid, as_sindex_bulk* bulk)
+{
+	si_btree* bt = si->btrees[pid];
+
+	*bulk = (as_sindex_bulk){
+			.si = si,
+			.pid = pid
+	};
+
+	pthread_rwlock_wrlock(&bt->lock);
+
+	cf_assert(! bt->bulk_loading, AS_SINDEX, "bulk load already in progress");
+
+	bt->bulk_loading = true;
+
+	pthread_rwlock_unlock(&bt->lock);
+}
+
+void
+as_sindex_tree_bulk_add(as_sindex_bulk* bulk, int64_t bval,
+		cf_arenax_handle r_h)
+{
+	if (bulk->n_keys == bulk->capacity) {
+		bulk->capacity = bulk->capacity == 0 ?
+				BULK_KEYS_START_CAPACITY : bulk->capacity * 2;
+		bulk->keys = cf_realloc(bulk->keys,
+				bulk->capacity * sizeof(si_bulk_key));
+	}
+
+	as_index* r = cf_arenax_resolve(bulk->si->ns->arena, r_h);
+
+	bulk->keys[bulk->n_keys++] = (si_bulk_key){
+			.bval = bval,
+			.keyd = r->keyd,
+			.r_h = r_h
+	};
+}
+
+void
+as_sindex_tree_bulk_finish(as_sindex_bulk* bulk, bool abort)
+{
+	si_btree* bt = bulk->si->btrees[bulk->pid];
+
+	si_arena_handle root_h = 0;
+	uint64_t n_nodes = 0;
+	uint32_t n_keys = 0;
+	uint64_t sum_bvals = 0;
+
+	if (! abort && bulk->n_keys != 0) {
+		qsort_r(bulk->keys, bulk->n_keys, sizeof(si_bulk_key), bulk_key_cmp,
+				bt);
+
+		si_btree_key* keys = cf_malloc(bulk->n_keys * sizeof(si_btree_key));
+
+		for (uint32_t i = 0; i < bulk->n_keys; i++) {
+			const si_bulk_key* bkey = &bulk->keys[i];
+
+			// A record may repeat a value - keep one key.
+			if (i != 0 && bulk_key_cmp(bkey - 1, bkey, bt) == 0) {
+				continue;
+			}
+
+			keys[n_keys++] = (si_btree_key){
+					.bval = bkey->bval,
+					.keyd_stub = get_keyd_stub(&bkey->keyd),
+					.r_h = bkey->r_h
+			};
+
+			sum_bvals += (uint64_t)bkey->bval;
+		}
+
+		root_h = bulk_build(bt, keys, n_keys, &n_nodes);
+
+		cf_free(keys);
+	}
+
+	if (bulk->keys != NULL) {
+		cf_free(bulk->keys);
+	}
+
+	pthread_rwlock_wrlock(&bt->lock);
+
+	if (n_keys != 0) {
+		si_arena_handle live_root_h = bt->root_h;
+
+		bt->root_h = root_h;
+		bt->n_nodes = n_nodes;
+		bt->n_keys = n_keys;
+		bt->sum_bvals = sum_bvals;
+
+		// Writers removed these since collection - remove stale copies.
+		for (uint32_t i = 0; i < bt->n_bulk_deletes; i++) {
+			if (si_btree_delete_locked(bt, &bt->bulk_deletes[i])) {
+				bt->n_keys--;
+				bt->sum_bvals -= (uint64_t)bt->bulk_deletes[i].bval;
+			}
+		}
+
+		// Keys written during the build are newer than those collected.
+		bulk_merge_live(bt, live_root_h);
+	}
+
+	bt->bulk_loading = false;
+	as_store_uint64(&bt->n_mods, bt->n_mods + 1);
+
+	if (bt->bulk_deletes != NULL) {
+		cf_free(bt->bulk_deletes);
+		bt->bulk_deletes = NULL;
+	}
+
+	bt->n_bulk_deletes = 0;
+	bt->bulk_deletes_capacity = 0;
+
+	pthread_rwlock_unlock(&bt->lock);
 }
 
 
@@ -505,12 +835,16 @@ gc_reduce_and_delete(as_sindex* si, si_btree* bt)
 	gc_collect_cb_info ci = {
 			.ns = ns,
 			.max_burst = max_burst,
+			.max_lock_ns = (uint64_t)
+					as_load_uint32(&g_config.sindex_gc_max_lock_us) * 1000,
 			.keys = keys
 	};
 
 	while (! si->dropped) {
 		search_key* last = first ? NULL : &ci.last;
 
+		ci.start_ns = ci.max_lock_ns == 0 ? 0 : cf_getns();
+
 		si_btree_reduce(bt, last, NULL, gc_collect_cb, &ci);
 
 		first = false;
@@ -522,12 +856,13 @@ gc_reduce_and_delete(as_sindex* si, si_btree* bt)
 		si->n_gc_cleaned += ci.n_keys;
 		ns->n_sindex_gc_cleaned += ci.n_keys;
 
-		if (ci.n_keys_reduced != max_burst) {
+		if (! ci.stopped) {
 			return; // done with this physical tree
 		}
 
 		ci.n_keys_reduced = 0;
 		ci.n_keys = 0;
+		ci.stopped = false;
 	}
 }
 
@@ -544,7 +879,13 @@ gc_collect_cb(const si_btree_key* key, void* udata)
 		ci->keys[ci->n_keys++] = *key;
 	}
 
-	if (++ci->n_keys_reduced == ci->max_burst) {
+	++ci->n_keys_reduced;
+
+	// Bound the read lock hold by key count, and by time if configured.
+	if (ci->n_keys_reduced == ci->max_burst ||
+			(ci->max_lock_ns != 0 &&
+					ci->n_keys_reduced % GC_CLOCK_CHECK_INTERVAL == 0 &&
+					cf_getns() - ci->start_ns > ci->max_lock_ns)) {
 		ci->last = (search_key){
 				.bval = key->bval,
 				.has_digest = true,
@@ -552,6 +893,8 @@ gc_collect_cb(const si_btree_key* key, void* udata)
 				.keyd = r->keyd
 		};
 
+		ci->stopped = true;
+
 		return false; // stops si_btree_reduce()
 	}
 
@@ -615,7 +958,7 @@ query_reduce(si_btree* bt, as_partition_reservation* rsv, int64_t start_bval,
 					.olock = as_index_olock_from_keyd(rsv->tree, &r->keyd)
 			};
 
-			cf_mutex_lock(r_ref.olock);
+			as_index_olock_lock(r_ref.olock);
 
 			as_index_release(r);
 
@@ -629,7 +972,7 @@ query_reduce(si_btree* bt, as_partition_reservation* rsv, int64_t start_bval,
 				do_more = cb(&r_ref, key->bval, udata);
 			}
 			else {
-				cf_mutex_unlock(r_ref.olock);
+				as_index_olock_unlock(r_ref.olock);
 			}
 		}
 
@@ -682,9 +1025,99 @@ query_collect_cb(const si_btree_key* key, void* udata)
 	return true;
 }
 
+// Unlocked peek at the index entry, as when collecting keys for queries.
+static bool
+count_cb(const si_btree_key* key, void* udata)
+{
+	count_cb_info* ci = (count_cb_info*)udata;
+
+	as_index* r = cf_arenax_resolve(ci->arena, key->r_h);
+
+	if (r->tree_id == ci->tree->id && r->generation != 0 &&
+			! as_record_is_doomed(r, ci->ns) &&
+			(ci->filter == NULL || count_filter_match(ci->filter, r))) {
+		ci->n_counted++;
+	}
+
+	if (++ci->n_keys_reduced == MAX_CARDINALITY_BURST) {
+		ci->last = (search_key){
+				.bval = key->bval,
+				.has_digest = true,
+				.keyd_stub = get_keyd_stub(&r->keyd),
+				.keyd = r->keyd
+		};
+
+		return false; // stops si_btree_reduce() - releases tree lock
+	}
+
+	return true;
+}
+
+static bool
+count_filter_match(const as_sindex_count_filter* filter, const as_index* r)
+{
+	if (filter->has_set && as_index_get_set_id(r) != filter->set_id) {
+		return false;
+	}
+
+	uint32_t void_time = r->void_time;
+
+	if (filter->min_void_time != 0 && void_time != 0 &&
+			void_time < filter->min_void_time) {
+		return false;
+	}
+
+	if (filter->max_void_time != 0 &&
+			(void_time == 0 || void_time > filter->max_void_time)) {
+		return false;
+	}
+
+	return true;
+}
+
+// Stale entries are fine - callers validate the records they read.
+static bool
+handles_collect_cb(const si_btree_key* key, void* udata)
+{
+	handles_collect_cb_info* ci = (handles_collect_cb_info*)udata;
+
+	if (ci->n_handles == ci->capacity) {
+		ci->capacity = ci->capacity == 0 ?
+				HANDLES_START_CAPACITY : ci->capacity * 2;
+		ci->handles = cf_realloc(ci->handles,
+				ci->capacity * sizeof(cf_arenax_handle));
+	}
+
+	ci->handles[ci->n_handles++] = key->r_h;
+
+	if (++ci->n_keys_reduced == MAX_QUERY_BURST) {
+		as_index* r = cf_arenax_resolve(ci->arena, key->r_h);
+
+		ci->last = (search_key){
+				.bval = key->bval,
+				.has_digest = true,
+				.keyd_stub = get_keyd_stub(&r->keyd),
+				.keyd = r->keyd
+		};
+
+		return false; // stops si_btree_reduce() - releases tree lock
+	}
+
+	return true;
+}
+
+static int
+handle_cmp(const void* pa, const void* pb)
+{
+	cf_arenax_handle a = *(const cf_arenax_handle*)pa;
+	cf_arenax_handle b = *(const cf_arenax_handle*)pb;
+
+	return a > b ? 1 : (a < b ? -1 : 0);
+}
+
 static void
 cardinality_reduce(as_sindex* si, si_btree* bt, uint64_t* n_keys,
-		hyperloglog* bval_hll, hyperloglog* rec_hll)
+		hyperloglog* bval_hll, hyperloglog* rec_hll, int64_t* samples)
 {
 	as_namespace* ns = si->ns;
 
@@ -694,7 +1127,8 @@ cardinality_reduce(as_sindex* si, si_btree* bt, uint64_t* n_keys,
 			.ns = ns,
 			.n_keys = n_keys,
 			.bval_hll = bval_hll,
-			.rec_hll = rec_hll
+			.rec_hll = rec_hll,
+			.samples = samples
 	};
 
 	while (! si->dropped) {
@@ -718,7 +1152,19 @@ cardinality_collect_cb(const si_btree_key* key, void* udata)
 	cardinality_collect_cb_info* ci = (cardinality_collect_cb_info*)udata;
 	as_namespace* ns = ci->ns;
 
-	(*ci->n_keys)++;
+	uint64_t n_seen = (*ci->n_keys)++;
+
+	// Reservoir sampling - keeps a uniform sample across all btrees.
+	if (n_seen < HIST_N_SAMPLES) {
+		ci->samples[n_seen] = key->bval;
+	}
+	else {
+		uint64_t i = cf_get_rand64() % (n_seen + 1);
+
+		if (i < HIST_N_SAMPLES) {
+			ci->samples[i] = key->bval;
+		}
+	}
 
 	hll_add(ci->bval_hll, (const uint8_t*)&key->bval, sizeof(key->bval));
 
@@ -786,6 +1232,7 @@ si_btree_create(cf_arenax* arena, as_sindex_arena* si_arena,
 	bt->root_h = create_node(bt, true);
 	bt->n_nodes = 1;
 	bt->n_keys = 0;
+	bt->sum_bvals = 0;
 
 	return bt;
 }
@@ -803,6 +1250,59 @@ si_btree_put(si_btree* bt, const si_btree_key* key)
 {
 	pthread_rwlock_wrlock(&bt->lock);
 
+	bool added = si_btree_put_locked(bt, key);
+
+	if (added) {
+		bt->n_keys++;
+		bt->sum_bvals += (uint64_t)key->bval;
+		as_store_uint64(&bt->n_mods, bt->n_mods + 1);
+	}
+
+	pthread_rwlock_unlock(&bt->lock);
+	return added;
+}
+
+// Accessed from enterprise split.
+bool
+si_btree_delete(si_btree* bt, const si_btree_key* key)
+{
+	return si_btree_delete_key(bt, key, false);
+}
+
+static bool
+si_btree_delete_key(si_btree* bt, const si_btree_key* key, bool log)
+{
+	pthread_rwlock_wrlock(&bt->lock);
+
+	// Only writer deletes - GC only removes keys of records deleted before
+	// the bulk load's collection began.
+	if (log && bt->bulk_loading) {
+		if (bt->n_bulk_deletes == bt->bulk_deletes_capacity) {
+			bt->bulk_deletes_capacity = bt->bulk_deletes_capacity == 0 ?
+					BULK_DELETES_START_CAPACITY :
+					bt->bulk_deletes_capacity * 2;
+			bt->bulk_deletes = cf_realloc(bt->bulk_deletes,
+					bt->bulk_deletes_capacity * sizeof(si_btree_key));
+		}
+
+		bt->bulk_deletes[bt->n_bulk_deletes++] = *key;
+	}
+
+	bool deleted = si_btree_delete_locked(bt, key);
+
+	if (deleted) {
+		bt->n_keys--;
+		bt->sum_bvals -= (uint64_t)key->bval;
+		as_store_uint64(&bt->n_mods, bt->n_mods + 1);
+	}
+
+	pthread_rwlock_unlock(&bt->lock);
+	return deleted;
+}
+
+static bool
+si_btree_put_locked(si_btree* bt, const si_btree_key* key)
+{
 	si_btree_node* root = SI_RESOLVE(bt->root_h);
 
 	if (root->n_keys == root->max_degree - 1) {
@@ -818,32 +1318,18 @@ si_btree_put(si_btree* bt, const si_btree_key* key)
 		root = new_root;
 	}
 
-	if (! btree_put(bt, root, key)) {
-		pthread_rwlock_unlock(&bt->lock);
-		return false;
-	}
-
-	bt->n_keys++;
-
-	pthread_rwlock_unlock(&bt->lock);
-	return true;
+	return btree_put(bt, root, key);
 }
 
-// Accessed from enterprise split.
-bool
-si_btree_delete(si_btree* bt, const si_btree_key* key)
+static bool
+si_btree_delete_locked(si_btree* bt, const si_btree_key* key)
 {
-	pthread_rwlock_wrlock(&bt->lock);
-
 	si_btree_node* root = SI_RESOLVE(bt->root_h);
 
 	if (! btree_delete(bt, root, KEY_MODE_MATCH, key, NULL)) {
-		pthread_rwlock_unlock(&bt->lock);
 		return false;
 	}
 
-	bt->n_keys--;
-
 	if (root->n_keys == 0 && root->leaf == 0) {
 		si_arena_handle root_h = bt->root_h;
 
@@ -854,10 +1340,30 @@ si_btree_delete(si_btree* bt, const si_btree_key* key)
 		bt->n_nodes--;
 	}
 
-	pthread_rwlock_unlock(&bt->lock);
 	return true;
 }
 
+// Tree must be non-empty - all leaves of a non-empty tree have keys.
+static void
+si_btree_min_max(si_btree* bt, int64_t* min, int64_t* max)
+{
+	si_btree_node* node = SI_RESOLVE(bt->root_h);
+
+	while (node->leaf == 0) {
+		node = SI_RESOLVE(const_children(bt, node)[0]);
+	}
+
+	*min = const_key(bt, node, 0)->bval;
+
+	node = SI_RESOLVE(bt->root_h);
+
+	while (node->leaf == 0) {
+		node = SI_RESOLVE(const_children(bt, node)[node->n_keys]);
+	}
+
+	*max = const_key(bt, node, node->n_keys - 1)->bval;
+}
+
 // Accessed from enterprise split.
 void
 si_btree_reduce(si_btree* bt, const search_key* start_skey,
@@ -871,6 +1377,181 @@ si_btree_reduce(si_btree* bt, const search_key* start_skey,
 }
 
 
+//==========================================================
+// Local helpers - histogram.
+//
+
+static void
+build_hist(as_sindex* si, int64_t* samples, uint32_t n_samples)
+{
+	if (n_samples == 0) {
+		si->has_hist = false;
+		return;
+	}
+
+	bool is_unsigned = si->ktype == AS_PARTICLE_TYPE_GEOJSON;
+
+	qsort(samples, n_samples, sizeof(int64_t),
+			is_unsigned ? bval_sort_cmp_unsigned : bval_sort_cmp);
+
+	for (uint32_t i = 0; i <= SINDEX_HIST_N_BUCKETS; i++) {
+		uint64_t ix = ((uint64_t)(n_samples - 1) * i) / SINDEX_HIST_N_BUCKETS;
+
+		si->hist_bounds[i] = samples[ix];
+	}
+
+	si->has_hist = true;
+}
+
+static int
+bval_sort_cmp(const void* pa, const void* pb)
+{
+	return bval_cmp(*(const int64_t*)pa, *(const int64_t*)pb);
+}
+
+static int
+bval_sort_cmp_unsigned(const void* pa, const void* pb)
+{
+	return bval_cmp_unsigned(*(const int64_t*)pa, *(const int64_t*)pb);
+}
+
+
+//==========================================================
+// Local helpers - bulk load.
+//
+
+static int
+bulk_key_cmp(const void* pa, const void* pb, void* udata)
+{
+	const si_bulk_key* a = (const si_bulk_key*)pa;
+	const si_bulk_key* b = (const si_bulk_key*)pb;
+	const si_btree* bt = (const si_btree*)udata;
+
+	int32_t cmp = bt->unsigned_bvals ?
+			bval_cmp_unsigned(a->bval, b->bval) : bval_cmp(a->bval, b->bval);
+
+	if (cmp != 0) {
+		return cmp;
+	}
+
+	// Same order as key_cmp() - stub first, then whole digest.
+
+	uint8_t stub_a = get_keyd_stub(&a->keyd);
+	uint8_t stub_b = get_keyd_stub(&b->keyd);
+
+	if (stub_a != stub_b) {
+		return stub_a > stub_b ? 1 : -1;
+	}
+
+	return cf_digest_compare(&a->keyd, &b->keyd);
+}
+
+// Builds packed nodes bottom-up from sorted, unique keys. Keys are spread
+// evenly across each level so every non-root node meets its minimum degree.
+// Separators are compacted to the front of keys[] as each level is built.
+static si_arena_handle
+bulk_build(const si_btree* bt, si_btree_key* keys, uint32_t n_keys,
+		uint64_t* n_nodes)
+{
+	uint32_t n_leaves = (n_keys + bt->leaf_order) / bt->leaf_order;
+	si_arena_handle* children = cf_malloc(n_leaves * sizeof(si_arena_handle));
+
+	uint32_t n_leaf_keys = n_keys - (n_leaves - 1);
+	uint32_t per = n_leaf_keys / n_leaves;
+	uint32_t extra = n_leaf_keys % n_leaves;
+	uint32_t src = 0;
+	uint32_t n_seps = 0;
+
+	for (uint32_t j = 0; j < n_leaves; j++) {
+		uint32_t n = per + (j < extra ? 1 : 0);
+		si_arena_handle h = create_node(bt, true);
+		si_btree_node* node = SI_RESOLVE(h);
+
+		memcpy(mut_key(bt, node, 0), &keys[src], n * sizeof(si_btree_key));
+		node->n_keys = (uint16_t)n;
+		src += n;
+
+		children[j] = h;
+
+		if (j != n_leaves - 1) {
+			keys[n_seps++] = keys[src++];
+		}
+	}
+
+	*n_nodes = n_leaves;
+
+	uint32_t n_children = n_leaves;
+
+	while (n_children > 1) {
+		uint32_t n_parents = (n_children + bt->inner_order - 1) /
+				bt->inner_order;
+
+		per = n_children / n_parents;
+		extra = n_children % n_parents;
+
+		uint32_t child_src = 0;
+		uint32_t key_src = 0;
+
+		n_seps = 0;
+
+		for (uint32_t j = 0; j < n_parents; j++) {
+			uint32_t n = per + (j < extra ? 1 : 0);
+			si_arena_handle h = create_node(bt, false);
+			si_btree_node* node = SI_RESOLVE(h);
+
+			memcpy(mut_children(bt, node), &children[child_src],
+					n * sizeof(si_arena_handle));
+			memcpy(mut_key(bt, node, 0), &keys[key_src],
+					(n - 1) * sizeof(si_btree_key));
+			node->n_keys = (uint16_t)(n - 1);
+			child_src += n;
+			key_src += n - 1;
+
+			children[j] = h;
+
+			if (j != n_parents - 1) {
+				keys[n_seps++] = keys[key_src++];
+			}
+		}
+
+		*n_nodes += n_parents;
+		n_children = n_parents;
+	}
+
+	si_arena_handle root_h = children[0];
+
+	cf_free(children);
+
+	return root_h;
+}
+
+// Moves all keys of the live tree into the bulk tree, freeing live nodes.
+static void
+bulk_merge_live(si_btree* bt, si_arena_handle node_h)
+{
+	si_btree_node* node = SI_RESOLVE(node_h);
+
+	for (uint32_t i = 0; i < node->n_keys; i++) {
+		const si_btree_key* key = const_key(bt, node, i);
+
+		if (si_btree_put_locked(bt, key)) {
+			bt->n_keys++;
+			bt->sum_bvals += (uint64_t)key->bval;
+		}
+	}
+
+	if (node->leaf == 0) {
+		const si_arena_handle* children = const_children(bt, node);
+
+		for (uint32_t i = 0; i <= node->n_keys; i++) {
+			bulk_merge_live(bt, children[i]);
+		}
+	}
+
+	as_sindex_arena_free(bt->si_arena, node_h);
+}
+
+
 //==========================================================
 // Local helpers - lowest btree layer.
 //
@@ -1027,6 +1708,21 @@ btree_reduce(si_btree* bt, si_btree_node* node, const search_key* start_skey,
 
 	const si_btree_key* key_cb = const_key(bt, node, i);
 
+	if (children == NULL) {
+		// Leaf - find the end of the range once, then no compares per key.
+		uint32_t end = leaf_end(bt, node, i, end_skey);
+
+		for (; i < end; i++) {
+			if (! cb(key_cb, udata)) {
+				return false;
+			}
+
+			key_cb++;
+		}
+
+		return end == node->n_keys;
+	}
+
 	while (++i <= node->n_keys) {
 		if (end_skey != NULL && end_skey_cmp(bt, end_skey, key_cb) < 0) {
 			return false;
@@ -1475,6 +2171,36 @@ left_bound(const si_btree* bt, const si_btree_node* node,
 }
 #endif
 
+// Index of the first key from 'from' on past the end of the range, or n_keys.
+// Long runs of one bval (low-cardinality bins) usually end past the leaf, so
+// check the last key before searching.
+static uint32_t
+leaf_end(const si_btree* bt, const si_btree_node* node, uint32_t from,
+		const search_key* end_skey)
+{
+	if (end_skey == NULL || from >= node->n_keys ||
+			end_skey_cmp(bt, end_skey,
+					const_key(bt, node, node->n_keys - 1)) >= 0) {
+		return node->n_keys;
+	}
+
+	uint32_t lower = from;
+	uint32_t upper = node->n_keys - 1; // known past the end
+
+	while (lower < upper) {
+		uint32_t i = (lower + upper) / 2;
+
+		if (end_skey_cmp(bt, end_skey, const_key(bt, node, i)) < 0) {
+			upper = i;
+		}
+		else {
+			lower = i + 1;
+		}
+	}
+
+	return lower;
+}
+
 static void
 split_child(si_btree* bt, si_btree_node* node, uint32_t i, si_btree_node* child)
 {
@@ -116,3 +116,36 @@ pwrite_all(int fd, const void* buf, size_t size, off_t offset)
 
 	return true;
 }
+
+// Note - advances iov entries past anything a partial write wrote.
+bool
+pwritev_all(int fd, struct iovec* iov, int n_iov, off_t offset)
+{
+	while (n_iov != 0) {
+		ssize_t result = pwritev(fd, iov, n_iov, offset);
+
+		if (result < 0) {
+			return false; // let the caller log errors
+		}
+
+		if (result == 0) { // should only happen if caller passed 0 size
+			errno = EINVAL;
+			return false;
+		}
+
+		offset += result;
+
+		while (n_iov != 0 && (size_t)result >= iov->iov_len) {
+			result -= (ssize_t)iov->iov_len;
+			iov++;
+			n_iov--;
+		}
+
+		if (n_iov != 0) {
+			iov->iov_base = (uint8_t*)iov->iov_base + result;
+			iov->iov_len -= (size_t)result;
+		}
+	}
+
+	return true;
+}
@@ -20,16 +20,88 @@
  * along with this program.  If not, see http://www.gnu.org/licenses/
  */
 
+//==========================================================
+// Includes.
+//
+
+#include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_queue.h"
 
+#include "log.h"
+
+#include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/index.h"
 #include "base/proto.h"
+#include "base/set_index.h"
 #include "fabric/partition.h"
 #include "storage/flat.h"
 #include "storage/storage.h"
 
 
+//==========================================================
+// Typedefs & constants.
+//
+
+// Record snapshot - written on clean shutdown, reloaded (once) at startup so a
+// restart doesn't have to refill the namespace by migration. The CE substitute
+// for keeping data in shared memory - CE bins are heap particles, which can't
+// outlive the process.
+#define SNAPSHOT_MAGIC 0x3150414e534d454dUL // "MEMSNAP1"
+#define SNAPSHOT_VERSION 1
+
+#define SNAPSHOT_BUF_SZ (8 * 1024 * 1024)
+
+typedef struct snapshot_header_s {
+	uint64_t magic;
+	uint32_t version;
+	char ns_name[AS_ID_NAMESPACE_SZ];
+	uint64_t n_records;
+	uint64_t records_sz; // bytes following the partition metadata
+} snapshot_header;
+
+typedef struct snapshot_pmeta_s {
+	as_partition_version version;
+	uint8_t tree_id;
+	uint8_t pad[7];
+} snapshot_pmeta;
+
+// Layout following header:
+// - AS_PARTITIONS snapshot_pmeta, in pid order
+// - n_records of (uint32_t pickle_sz, pickle)
+
+typedef struct snapshot_write_info_s {
+	as_namespace* ns;
+	FILE* file;
+	uint64_t n_records;
+	uint64_t records_sz;
+	bool ok;
+} snapshot_write_info;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static bool snapshot_write_cb(as_index_ref* r_ref, void* udata);
+static bool snapshot_read(as_namespace* ns, FILE* file, const char* path);
+static void snapshot_apply(as_namespace* ns, uint8_t* pickle, uint32_t pickle_sz, uint32_t now);
+
+
+//==========================================================
+// Public API.
+//
+
+
 void
 as_storage_start_tomb_raider_memory(as_namespace* ns)
 {
@@ -60,7 +132,270 @@ as_storage_record_write_memory(as_storage_rd* rd)
 	return 0;
 }
 
+// Reload records saved by as_storage_shutdown_memory(). Partition versions are
+// restored directly, so as_storage_load_pmeta_memory() has nothing to do.
+void
+as_storage_load_memory(as_namespace* ns, cf_queue* complete_q)
+{
+	const char* path = ns->memory_snapshot_file;
+
+	if (path != NULL) {
+		FILE* file = fopen(path, "r");
+
+		if (file == NULL) {
+			if (errno != ENOENT) {
+				cf_warning(AS_STORAGE, "{%s} can't open memory snapshot %s: %s",
+						ns->name, path, cf_strerror(errno));
+			}
+		}
+		else {
+			if (! snapshot_read(ns, file, path)) {
+				cf_warning(AS_STORAGE, "{%s} ignoring memory snapshot %s",
+						ns->name, path);
+			}
+
+			fclose(file);
+
+			// Snapshot is good for one restart only.
+			unlink(path);
+		}
+	}
+
+	void* _t = NULL;
+
+	cf_queue_push(complete_q, &_t);
+}
+
 void
 as_storage_load_pmeta_memory(as_namespace *ns, as_partition *p)
 {
 }
+
+// Called with all partitions shut down, so trees are blocked and records can't
+// change underneath us.
+void
+as_storage_shutdown_memory(as_namespace* ns)
+{
+	char tmp_path[PATH_MAX];
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", ns->memory_snapshot_file);
+
+	FILE* file = fopen(tmp_path, "w");
+
+	if (file == NULL) {
+		cf_warning(AS_STORAGE, "{%s} can't create memory snapshot %s: %s",
+				ns->name, tmp_path, cf_strerror(errno));
+		return;
+	}
+
+	setvbuf(file, NULL, _IOFBF, SNAPSHOT_BUF_SZ);
+
+	cf_info(AS_STORAGE, "{%s} writing memory snapshot ...", ns->name);
+
+	snapshot_header header = {
+			.magic = SNAPSHOT_MAGIC,
+			.version = SNAPSHOT_VERSION
+	};
+
+	strcpy(header.ns_name, ns->name);
+
+	// Placeholder header - rewritten with counts at the end.
+	snapshot_write_info info = {
+			.ns = ns,
+			.file = file,
+			.ok = fwrite(&header, sizeof(header), 1, file) == 1
+	};
+
+	for (uint32_t pid = 0; info.ok && pid < AS_PARTITIONS; pid++) {
+		as_partition* p = &ns->partitions[pid];
+		snapshot_pmeta pmeta = {
+				.version = p->version,
+				.tree_id = p->tree_id
+		};
+
+		info.ok = fwrite(&pmeta, sizeof(pmeta), 1, file) == 1;
+	}
+
+	for (uint32_t pid = 0; info.ok && pid < AS_PARTITIONS; pid++) {
+		as_index_reduce_blocked(ns->partitions[pid].tree, snapshot_write_cb,
+				&info);
+	}
+
+	header.n_records = info.n_records;
+	header.records_sz = info.records_sz;
+
+	if (info.ok) {
+		info.ok = fseek(file, 0, SEEK_SET) == 0 &&
+				fwrite(&header, sizeof(header), 1, file) == 1 &&
+				fflush(file) == 0 && fsync(fileno(file)) == 0;
+	}
+
+	if (fclose(file) != 0) {
+		info.ok = false;
+	}
+
+	if (! info.ok || rename(tmp_path, ns->memory_snapshot_file) != 0) {
+		cf_warning(AS_STORAGE, "{%s} failed writing memory snapshot %s: %s",
+				ns->name, tmp_path, cf_strerror(errno));
+		unlink(tmp_path);
+		return;
+	}
+
+	cf_info(AS_STORAGE, "{%s} wrote memory snapshot %s - %lu records (%lu bytes)",
+			ns->name, ns->memory_snapshot_file, info.n_records,
+			info.records_sz);
+}
+
+
+//==========================================================
+// Local helpers - memory snapshot.
+//
+
+static bool
+snapshot_write_cb(as_index_ref* r_ref, void* udata)
+{
+	snapshot_write_info* info = (snapshot_write_info*)udata;
+	as_namespace* ns = info->ns;
+	as_record* r = r_ref->r;
+
+	if (! as_record_is_live(r) || as_record_is_doomed(r, ns)) {
+		return true;
+	}
+
+	as_storage_rd rd;
+
+	as_storage_record_open(ns, r, &rd);
+	as_storage_rd_load_pickle(&rd); // can't fail for data-in-memory
+	as_storage_record_close(&rd);
+
+	uint32_t pickle_sz = (uint32_t)rd.pickle_sz;
+
+	info->ok = fwrite(&pickle_sz, sizeof(pickle_sz), 1, info->file) == 1 &&
+			fwrite(rd.pickle, pickle_sz, 1, info->file) == 1;
+
+	cf_free(rd.pickle);
+
+	info->n_records++;
+	info->records_sz += sizeof(pickle_sz) + pickle_sz;
+
+	return info->ok;
+}
+
+static bool
+snapshot_read(as_namespace* ns, FILE* file, const char* path)
+{
+	snapshot_header header;
+	struct stat st;
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+			header.magic != SNAPSHOT_MAGIC ||
+			header.version != SNAPSHOT_VERSION ||
+			strcmp(header.ns_name, ns->name) != 0 ||
+			fstat(fileno(file), &st) != 0 ||
+			(uint64_t)st.st_size != sizeof(header) +
+					(AS_PARTITIONS * sizeof(snapshot_pmeta)) +
+					header.records_sz) {
+		return false;
+	}
+
+	snapshot_pmeta* pmetas = cf_malloc(AS_PARTITIONS * sizeof(snapshot_pmeta));
+
+	if (fread(pmetas, sizeof(snapshot_pmeta), AS_PARTITIONS, file) !=
+			AS_PARTITIONS) {
+		cf_free(pmetas);
+		return false;
+	}
+
+	cf_info(AS_STORAGE, "{%s} loading %lu records from memory snapshot %s",
+			ns->name, header.n_records, path);
+
+	// As for a device - partitions with data get versions and trees now.
+	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
+		as_partition* p = &ns->partitions[pid];
+
+		p->tree_id = pmetas[pid].tree_id;
+
+		if (as_partition_version_has_data(&pmetas[pid].version)) {
+			p->version = pmetas[pid].version;
+			p->tree = as_index_tree_create(&ns->tree_shared, p->tree_id,
+					as_partition_tree_done, (void*)p);
+
+			as_set_index_create_all(ns, p->tree);
+		}
+	}
+
+	cf_free(pmetas);
+
+	uint32_t now = as_record_void_time_get();
+	uint32_t buf_sz = 0;
+	uint8_t* buf = NULL;
+
+	for (uint64_t i = 0; i < header.n_records; i++) {
+		uint32_t pickle_sz;
+
+		if (fread(&pickle_sz, sizeof(pickle_sz), 1, file) != 1) {
+			break; // can't happen - file size was checked
+		}
+
+		if (pickle_sz > buf_sz) {
+			buf = cf_realloc(buf, pickle_sz);
+			buf_sz = pickle_sz;
+		}
+
+		if (fread(buf, pickle_sz, 1, file) != 1) {
+			break;
+		}
+
+		snapshot_apply(ns, buf, pickle_sz, now);
+	}
+
+	cf_free(buf);
+
+	cf_info(AS_STORAGE, "{%s} loaded memory snapshot - %lu objects", ns->name,
+			ns->n_objects);
+
+	return true;
+}
+
+static void
+snapshot_apply(as_namespace* ns, uint8_t* pickle, uint32_t pickle_sz,
+		uint32_t now)
+{
+	if (pickle_sz < sizeof(as_flat_record)) {
+		return;
+	}
+
+	const as_flat_record* flat = (const as_flat_record*)pickle;
+	as_partition* p = &ns->partitions[as_partition_getid(&flat->keyd)];
+
+	if (p->tree == NULL) {
+		return;
+	}
+
+	as_partition_reservation rsv = {
+			.ns = ns,
+			.p = p,
+			.tree = p->tree
+	};
+
+	// Applied like an immigration into an empty partition.
+	as_remote_record rr = {
+			.via = VIA_MIGRATION,
+			.src = g_config.self_node,
+			.rsv = &rsv,
+			.pickle = pickle,
+			.pickle_sz = pickle_sz
+	};
+
+	if (! as_flat_unpack_remote_record_meta(ns, &rr)) {
+		cf_warning(AS_STORAGE, "{%s} bad memory snapshot record", ns->name);
+		return;
+	}
+
+	// Skip records that expired while we were down.
+	if (rr.void_time != 0 && rr.void_time <= now) {
+		return;
+	}
+
+	as_record_replace_if_better(&rr);
+}
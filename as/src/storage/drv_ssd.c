@@ -38,8 +38,13 @@
 #include <unistd.h>
 #include <linux/fs.h> // for BLKGETSIZE64
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/param.h> // for MAX()
 
+#if defined(__x86_64__)
+#include <emmintrin.h> // for _mm_clflush(), _mm_sfence()
+#endif
+
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_atomic.h"
@@ -51,17 +56,21 @@
 #include "bits.h"
 #include "cf_mutex.h"
 #include "cf_thread.h"
+#include "hardware.h"
 #include "hist.h"
 #include "log.h"
 #include "os.h"
 #include "pool.h"
+#include "uring.h"
 #include "vmapx.h"
 
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/device_heat.h"
 #include "base/health.h"
 #include "base/index.h"
 #include "base/nsup.h"
+#include "base/probes.h"
 #include "base/proto.h"
 #include "base/set_index.h"
 #include "base/truncate.h"
@@ -69,6 +78,7 @@
 #include "sindex/sindex.h"
 #include "storage/drv_common.h"
 #include "storage/flat.h"
+#include "storage/record_cache.h"
 #include "storage/storage.h"
 #include "transaction/rw_utils.h"
 
@@ -82,6 +92,116 @@
 
 #define WRITE_IN_PLACE 1
 
+// How often a group commit leader checks queued swbs have been written.
+#define COMMIT_POLL_US 20
+
+// Most swbs the shadow thread writes per pass.
+#define SHADOW_MAX_BATCH 16
+
+// Number of defrag-eligible wblocks a defrag thread chooses among.
+#define DEFRAG_WINDOW 64
+
+// How long a background read waits before re-checking its class's depth.
+#define BACKGROUND_READ_WAIT_US 100
+
+// Adaptive defrag pacing (defrag-target-read-us) bounds - run flat out with
+// less than this much free space above min-avail-pct.
+#define DEFRAG_PACE_MIN_BACKOFF_US 100
+#define DEFRAG_PACE_MAX_SLEEP_US (100 * 1000)
+#define DEFRAG_PACE_CRITICAL_PCT 5
+
+// Batch read prefetch - merge reads at most this far apart in a wblock, and
+// don't hold more than this much per thread.
+#define PREFETCH_MAX_GAP (32 * 1024)
+#define PREFETCH_MAX_SIZE (4 * 1024 * 1024)
+
+// Cold start sweep - read at most this far ahead of the record parsers, using
+// at most this many reader threads per device.
+#define COLD_START_READ_AHEAD_SIZE (16 * 1024 * 1024)
+#define COLD_START_MAX_READERS 8
+
+// Cold start sweep - stop after this many contiguous unused wblocks.
+#define COLD_START_MAX_UNUSED_WBLOCKS 10
+
+
+//==========================================================
+// Typedefs.
+//
+
+typedef struct prefetch_rec_s {
+	drv_ssd		*ssd;
+	uint64_t	offset;
+	uint64_t	end_offset;
+	uint32_t	wblock_id;
+} prefetch_rec;
+
+typedef struct prefetch_extent_s {
+	drv_ssd		*ssd;
+	uint32_t	wblock_id;
+	uint32_t	n_frees;
+	uint64_t	offset;
+	uint64_t	end_offset;
+	uint8_t		*buf;
+} prefetch_extent;
+
+typedef struct cold_start_span_s {
+	uint32_t	indent;
+	uint32_t	size;
+	uint32_t	pid;
+} cold_start_span;
+
+struct cold_start_reader_s;
+
+typedef struct cold_start_wblock_s {
+	struct cold_start_reader_s *reader; // owner - returns to its free_q
+	uint8_t		*buf;
+	uint64_t	file_offset;
+	uint32_t	n_pending;	// parsers not yet done with this wblock
+	uint32_t	n_spans;
+	uint32_t	capacity;
+	cold_start_span *spans;
+} cold_start_wblock;
+
+struct cold_start_sweep_s;
+
+typedef struct cold_start_reader_s {
+	struct cold_start_sweep_s *sweep;
+	uint32_t	ix;
+	cf_queue	*free_q;	// cold_start_wblock pointers ready to read into
+	cf_queue	*full_q;	// cold_start_wblock pointers read, in file order
+	cf_tid		tid;
+} cold_start_reader;
+
+typedef struct cold_start_parser_s {
+	struct cold_start_sweep_s *sweep;
+	uint32_t	ix;
+	cf_queue	*work_q;	// cold_start_wblock pointers, NULL to stop
+	cf_tid		tid;
+} cold_start_parser;
+
+typedef struct cold_start_sweep_s {
+	drv_ssds	*ssds;
+	drv_ssd		*ssd;
+	bool		read_shadow;
+	uint32_t	done;		// set when sweep stops - readers then exit
+	uint32_t	n_readers;
+	uint32_t	n_parsers;
+	uint32_t	n_wblocks;
+	cold_start_wblock *wblocks;
+	cold_start_reader readers[COLD_START_MAX_READERS];
+	cold_start_parser *parsers;
+} cold_start_sweep;
+
+
+//==========================================================
+// Globals.
+//
+
+// Batch sub-transactions processed inline run on the thread that prefetched.
+static __thread prefetch_extent *g_prefetch_extents = NULL;
+static __thread uint32_t g_n_prefetch_extents = 0;
+static __thread uint32_t g_prefetch_capacity = 0;
+
 
 //==========================================================
 // Miscellaneous utility functions.
@@ -198,6 +318,159 @@ ssd_shadow_fd_put(drv_ssd *ssd, int fd)
 }
 
 
+// Smooth device read latency (1/8 weight per sample) - racy updates are fine,
+// it only steers offloading of device-bound transactions.
+static inline void
+ssd_track_read_latency(as_namespace *ns, uint64_t lat_us)
+{
+	uint32_t prev = ns->storage_read_latency_us;
+
+	ns->storage_read_latency_us =
+			(uint32_t)(((uint64_t)prev * 7 + lat_us) / 8);
+}
+
+
+// Same smoothing, per device - steers defrag pacing.
+static inline void
+ssd_track_device_read_latency(drv_ssd *ssd, uint64_t lat_us)
+{
+	uint32_t prev = ssd->read_latency_us;
+
+	ssd->read_latency_us = (uint32_t)(((uint64_t)prev * 7 + lat_us) / 8);
+	ssd->n_timed_reads++;
+}
+
+
+// With background-read-depth set, each background class may have that many
+// reads in flight per device - only one while foreground reads are in flight.
+// Foreground reads are counted only so background ones can yield. Returns the
+// class to pass to ssd_read_end().
+static uint32_t
+ssd_read_begin(drv_ssd *ssd)
+{
+	uint32_t depth = as_load_uint32(&ssd->ns->storage_background_read_depth);
+
+	if (depth == 0) {
+		return AS_STORAGE_N_IO_CLASSES; // not tracked
+	}
+
+	as_storage_io_class io_class = g_storage_io_class;
+	uint32_t *n_reads = &ssd->n_class_reads[io_class];
+
+	if (io_class == AS_STORAGE_IO_FOREGROUND) {
+		as_incr_uint32(n_reads);
+		return io_class;
+	}
+
+	while (true) {
+		uint32_t limit = as_load_uint32(
+				&ssd->n_class_reads[AS_STORAGE_IO_FOREGROUND]) != 0 ? 1 : depth;
+		uint32_t n = as_load_uint32(n_reads);
+
+		if (n < limit && as_cas_uint32(n_reads, n, n + 1)) {
+			return io_class;
+		}
+
+		usleep(BACKGROUND_READ_WAIT_US);
+	}
+}
+
+
+static inline void
+ssd_read_end(drv_ssd *ssd, uint32_t io_class)
+{
+	if (io_class != AS_STORAGE_N_IO_CLASSES) {
+		as_decr_uint32(&ssd->n_class_reads[io_class]);
+	}
+}
+
+
+#ifndef MAP_SHARED_VALIDATE
+#define MAP_SHARED_VALIDATE 0x03
+#endif
+
+#ifndef MAP_SYNC
+#define MAP_SYNC 0x80000
+#endif
+
+// MAP_SYNC guarantees file metadata is durable at page fault, so a store is
+// durable once flushed from CPU caches - no msync or fsync. The kernel refuses
+// MAP_SYNC for files not on a DAX filesystem.
+static void
+ssd_dax_map(drv_ssd *ssd, int fd)
+{
+	void *map = mmap(NULL, ssd->file_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
+
+	if (map == MAP_FAILED) {
+		cf_crash(AS_DRV_SSD, "%s: dax-map failed - file must be on a DAX filesystem: %s",
+				ssd->name, cf_strerror(errno));
+	}
+
+	ssd->dax_map = (uint8_t *)map;
+
+	cf_info(AS_DRV_SSD, "%s: dax-mapped %lu bytes", ssd->name, ssd->file_size);
+}
+
+
+// Replaces pwrite of a wblock - memcpy, then flush the lines to persistence.
+static void
+ssd_dax_write(drv_ssd *ssd, const void *buf, size_t size, off_t offset)
+{
+	uint8_t *to = ssd->dax_map + offset;
+
+	memcpy(to, buf, size);
+
+#if defined(__x86_64__)
+	for (size_t i = 0; i < size; i += 64) {
+		_mm_clflush(to + i);
+	}
+
+	_mm_sfence();
+#else
+	// Offset is wblock-aligned, so page-aligned.
+	if (msync(to, size, MS_SYNC) != 0) {
+		cf_crash(AS_DRV_SSD, "%s: DEVICE FAILED msync: errno %d (%s)",
+				ssd->name, errno, cf_strerror(errno));
+	}
+#endif
+}
+
+
+// Read via the calling thread's polled io_uring if configured, else (or if the
+// device doesn't support polled IO) fall back to a blocking pread. Only valid
+// for O_DIRECT fds. A dax-mapped file is read by direct load instead.
+static bool
+ssd_pread_all(const as_namespace *ns, drv_ssd *ssd, int fd, void *buf,
+		size_t size, off_t offset)
+{
+	if (ssd->dax_map != NULL) {
+		memcpy(buf, ssd->dax_map + offset, size);
+		return true;
+	}
+
+	if (ns->storage_read_io_uring) {
+		cf_uring *ring = cf_uring_thread_ring();
+
+		if (ring != NULL) {
+			if (cf_uring_pread_all(ring, fd, buf, size, offset)) {
+				return true;
+			}
+
+			if (errno != EOPNOTSUPP && errno != EINVAL) {
+				return false; // let the caller log errors
+			}
+
+			cf_warning(AS_DRV_SSD, "%s: polled io_uring reads not supported - using pread",
+					ssd->name);
+			cf_uring_thread_disable();
+		}
+	}
+
+	return pread_all(fd, buf, size, offset);
+}
+
+
 // Decide which device a record belongs on.
 static inline uint32_t
 ssd_get_file_id(drv_ssds *ssds, cf_digest *keyd)
@@ -211,6 +484,7 @@ static inline void
 push_wblock_to_write_q(drv_ssd* ssd, const ssd_write_buf* swb)
 {
 	cf_atomic32_incr(&ssd->ns->n_wblocks_to_flush);
+	cf_atomic64_incr(&ssd->n_wblocks_queued);
 	cf_queue_push(ssd->swb_write_q, &swb);
 }
 
@@ -227,6 +501,8 @@ push_wblock_to_free_q(drv_ssd *ssd, uint32_t wblock_id)
 	cf_assert(wblock_id < ssd->n_wblocks, AS_DRV_SSD,
 			"pushing bad wblock_id %d to free_wblock_q", (int32_t)wblock_id);
 
+	as_incr_uint32(&ssd->wblock_state[wblock_id].n_frees);
+
 	cf_queue_push(ssd->free_wblock_q, &wblock_id);
 }
 
@@ -324,10 +600,12 @@ ssd_release_vacated_wblock(drv_ssd *ssd, uint32_t wblock_id,
 }
 
 
+// Marks may be either kind, whatever record-checksums was when written.
 static inline bool
 ssd_check_end_mark(const uint8_t *mark, const as_flat_record *flat)
 {
-	return *(uint32_t*)mark == ssd_make_end_mark(flat);
+	return *(uint32_t*)mark == ssd_make_end_mark(flat) ||
+			*(uint32_t*)mark == ssd_make_crc_end_mark(flat, mark);
 }
 
 
@@ -337,14 +615,25 @@ ssd_find_and_check_end_mark(const uint8_t *at, const as_flat_record *flat)
 	uint32_t match = ssd_make_end_mark(flat);
 
 	for (uint32_t i = 0; i < RBLOCK_SIZE; i++) {
-		if (*(uint32_t*)at == match) {
-			return at;
+		if (*(uint32_t*)(at - i) == match) {
+			return at - i;
+		}
+	}
+
+	// Not a hash mark - extend one CRC across the candidate positions.
+	const uint8_t *lowest = at - (RBLOCK_SIZE - 1);
+	uint32_t crc = cf_crc32c(0, flat, (size_t)(lowest - (const uint8_t*)flat));
+	const uint8_t *found = NULL;
+
+	for (const uint8_t *mark = lowest; mark <= at; mark++) {
+		if (*(uint32_t*)mark == cf_swap_to_le32(crc & 0x7FFFffff)) {
+			found = mark; // keep going - want the last match, as above
 		}
 
-		at--;
+		crc = cf_crc32c(crc, mark, 1);
 	}
 
-	return NULL;
+	return found;
 }
 
 
@@ -354,12 +643,20 @@ ssd_find_and_check_end_mark(const uint8_t *at, const as_flat_record *flat)
 
 #define VACATED_CAPACITY_STEP 128 // allocate in 1K chunks
 
+#define SWB_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Free swbs beyond this are destroyed on release - power of 2.
+#define SWB_FREE_Q_CAPACITY 256
+
 static inline ssd_write_buf*
 swb_create(drv_ssd *ssd)
 {
 	ssd_write_buf *swb = (ssd_write_buf*)cf_malloc(sizeof(ssd_write_buf));
 
-	swb->buf = cf_valloc(ssd->write_block_size);
+	swb->buf = ssd->ns->storage_numa_local_write_buffers ?
+			cf_topo_alloc_local(ssd->write_block_size, ssd->swb_numa_node,
+					ssd->write_block_size % SWB_HUGE_PAGE_SIZE == 0) :
+			cf_valloc(ssd->write_block_size);
 
 	swb->n_vacated = 0;
 	swb->vacated_capacity = VACATED_CAPACITY_STEP;
@@ -372,8 +669,17 @@ swb_create(drv_ssd *ssd)
 static inline void
 swb_destroy(ssd_write_buf *swb)
 {
+	drv_ssd *ssd = swb->ssd;
+
 	cf_free(swb->vacated_wblocks);
-	cf_free(swb->buf);
+
+	if (ssd->ns->storage_numa_local_write_buffers) {
+		cf_topo_free_local(swb->buf, ssd->write_block_size);
+	}
+	else {
+		cf_free(swb->buf);
+	}
+
 	cf_free(swb);
 }
 
@@ -383,6 +689,9 @@ swb_reset(ssd_write_buf *swb)
 	swb->use_post_write_q = false;
 	swb->wblock_id = STORAGE_INVALID_WBLOCK;
 	swb->pos = 0;
+	swb->dirty_lo = 0;
+	swb->shadow_lagging = false;
+	swb->write_life = RWH_WRITE_LIFE_NOT_SET;
 }
 
 #define swb_reserve(_swb) cf_atomic32_incr(&(_swb)->rc)
@@ -406,8 +715,10 @@ swb_release(ssd_write_buf *swb)
 	if (0 == cf_atomic32_decr(&swb->rc)) {
 		swb_reset(swb);
 
-		// Put the swb back on the free queue for reuse.
-		cf_queue_push(swb->ssd->swb_free_q, &swb);
+		// Put the swb back on the free queue for reuse, if there's room.
+		if (! cf_ring_queue_push(&swb->ssd->swb_free_q, &swb)) {
+			swb_destroy(swb);
+		}
 	}
 }
 
@@ -455,7 +766,7 @@ swb_get(drv_ssd *ssd, bool use_reserve)
 
 	ssd_write_buf *swb;
 
-	if (CF_QUEUE_OK != cf_queue_pop(ssd->swb_free_q, &swb, CF_QUEUE_NOWAIT)) {
+	if (! cf_ring_queue_pop(&ssd->swb_free_q, &swb, CF_RING_QUEUE_NOWAIT)) {
 		swb = swb_create(ssd);
 		swb->rc = 0;
 		swb->n_writers = 0;
@@ -464,12 +775,18 @@ swb_get(drv_ssd *ssd, bool use_reserve)
 		swb->ssd = ssd;
 		swb->wblock_id = STORAGE_INVALID_WBLOCK;
 		swb->pos = 0;
+		swb->dirty_lo = 0;
+		swb->shadow_lagging = false;
+		swb->write_life = RWH_WRITE_LIFE_NOT_SET;
 	}
 
 	// Find a device block to write to.
 	if (cf_queue_pop(ssd->free_wblock_q, &swb->wblock_id, CF_QUEUE_NOWAIT) !=
 			CF_QUEUE_OK && ! pop_pristine_wblock_id(ssd, &swb->wblock_id)) {
-		cf_queue_push(ssd->swb_free_q, &swb);
+		if (! cf_ring_queue_push(&ssd->swb_free_q, &swb)) {
+			swb_destroy(swb);
+		}
+
 		return NULL;
 	}
 
@@ -493,6 +810,7 @@ swb_get(drv_ssd *ssd, bool use_reserve)
 
 	swb_reserve(swb);
 	p_wblock_state->swb = swb;
+	p_wblock_state->write_time = cf_get_seconds();
 
 	cf_mutex_unlock(&p_wblock_state->LOCK);
 
@@ -640,6 +958,8 @@ defrag_move_record(drv_ssd *src_ssd, uint32_t src_wblock_id,
 			cf_mutex_unlock(&ssd->defrag_lock);
 			return;
 		}
+
+		swb->write_life = RWH_WRITE_LIFE_EXTREME; // survivors live longest
 	}
 
 	// Check if there's enough space in defrag buffer - if not, enqueue it to be
@@ -660,6 +980,7 @@ defrag_move_record(drv_ssd *src_ssd, uint32_t src_wblock_id,
 			usleep(10 * 1000);
 		}
 
+		swb->write_life = RWH_WRITE_LIFE_EXTREME;
 		ssd->defrag_swb = swb;
 	}
 
@@ -678,6 +999,7 @@ defrag_move_record(drv_ssd *src_ssd, uint32_t src_wblock_id,
 	cf_atomic64_add(&ssd->inuse_size, (int64_t)write_size);
 	cf_atomic32_add(&ssd->wblock_state[swb->wblock_id].inuse_sz,
 			(int32_t)write_size);
+	cf_atomic64_add(&ssd->n_defrag_bytes_moved, (int64_t)write_size);
 
 	// If we just defragged into a new destination swb, count it.
 	if (swb_add_unique_vacated_wblock(swb, src_ssd->file_id, src_wblock_id)) {
@@ -748,6 +1070,8 @@ ssd_defrag_wblock(drv_ssd *ssd, uint32_t wblock_id, uint8_t *read_buf)
 {
 	int record_count = 0;
 
+	ASD_PROBE3(defrag__wblock_start, ssd->ns->ix, ssd->file_id, wblock_id);
+
 	ssd_wblock_state* p_wblock_state = &ssd->wblock_state[wblock_id];
 
 	cf_assert(p_wblock_state->n_vac_dests == 0, AS_DRV_SSD,
@@ -756,7 +1080,24 @@ ssd_defrag_wblock(drv_ssd *ssd, uint32_t wblock_id, uint8_t *read_buf)
 	// Make sure this can't decrement to 0 while defragging this wblock.
 	cf_atomic32_set(&p_wblock_state->n_vac_dests, 1);
 
-	if (cf_atomic32_get(p_wblock_state->inuse_sz) == 0) {
+	uint32_t inuse_sz = cf_atomic32_get(p_wblock_state->inuse_sz);
+
+	cf_atomic64_add(&ssd->n_defrag_bytes_reclaimed,
+			(int64_t)(ssd->write_block_size - inuse_sz));
+
+	if (ssd->ns->storage_benchmarks_enabled) {
+		uint32_t now = cf_get_seconds();
+		uint32_t write_time = p_wblock_state->write_time;
+
+		// Age in seconds since the wblock was allocated for writing.
+		histogram_insert_raw(ssd->hist_defrag_wblock_age,
+				write_time != 0 && write_time < now ? now - write_time : 0);
+
+		// Live bytes - i.e. the bytes defrag will move to free this wblock.
+		histogram_insert_raw(ssd->hist_defrag_wblock_live, inuse_sz);
+	}
+
+	if (inuse_sz == 0) {
 		cf_atomic64_incr(&ssd->n_wblock_defrag_io_skips);
 		goto Finished;
 	}
@@ -765,8 +1106,10 @@ ssd_defrag_wblock(drv_ssd *ssd, uint32_t wblock_id, uint8_t *read_buf)
 	uint64_t file_offset = WBLOCK_ID_TO_OFFSET(ssd, wblock_id);
 
 	uint64_t start_ns = ssd->ns->storage_benchmarks_enabled ? cf_getns() : 0;
+	uint32_t io_class = ssd_read_begin(ssd);
 
 	if (! pread_all(fd, read_buf, ssd->write_block_size, (off_t)file_offset)) {
+		ssd_read_end(ssd, io_class);
 		cf_warning(AS_DRV_SSD, "%s: read failed: errno %d (%s)", ssd->name,
 				errno, cf_strerror(errno));
 		close(fd);
@@ -774,6 +1117,8 @@ ssd_defrag_wblock(drv_ssd *ssd, uint32_t wblock_id, uint8_t *read_buf)
 		goto Finished;
 	}
 
+	ssd_read_end(ssd, io_class);
+
 	if (start_ns != 0) {
 		histogram_insert_data_point(ssd->hist_large_block_read, start_ns);
 	}
@@ -826,6 +1171,14 @@ ssd_defrag_wblock(drv_ssd *ssd, uint32_t wblock_id, uint8_t *read_buf)
 			break;
 		}
 
+		// Moving would re-mark the record - at least report it was corrupt.
+		if (ssd->ns->storage_record_checksums &&
+				ssd_find_and_check_end_mark((const uint8_t*)flat +
+						record_size - END_MARK_SZ, flat) == NULL) {
+			cf_warning(AS_DRV_SSD, "%s: bad checksum defragging %pD", ssd->name,
+					&flat->keyd);
+		}
+
 		// Found a good record, move it if it's current.
 		int rv = ssd_record_defrag(ssd, wblock_id, flat,
 				OFFSET_TO_RBLOCK_ID(file_offset + indent));
@@ -846,10 +1199,115 @@ Finished:
 
 	ssd_release_vacated_wblock(ssd, wblock_id, p_wblock_state);
 
+	ASD_PROBE4(defrag__wblock_done, ssd->ns->ix, ssd->file_id, wblock_id,
+			record_count);
+
 	return record_count;
 }
 
 
+// Cost-benefit (as in LFS) - favor wblocks with the most dead space and the
+// least recently written (i.e. least likely to lose more) live data.
+static double
+defrag_score(const drv_ssd *ssd, uint32_t wblock_id, uint32_t now)
+{
+	const ssd_wblock_state *p_wblock_state = &ssd->wblock_state[wblock_id];
+	double u = (double)cf_atomic32_get(p_wblock_state->inuse_sz) /
+			(double)ssd->write_block_size;
+	uint32_t write_time = p_wblock_state->write_time;
+	double age = write_time < now ? (double)(now - write_time) + 1.0 : 1.0;
+
+	return ((1.0 - u) * age) / (1.0 + u);
+}
+
+
+// Remove and return the best defrag candidate from the window.
+static uint32_t
+defrag_window_select(const drv_ssd *ssd, uint32_t *window, uint32_t *n_window)
+{
+	uint32_t now = cf_get_seconds();
+	uint32_t best_ix = 0;
+	double best_score = defrag_score(ssd, window[0], now);
+
+	for (uint32_t i = 1; i < *n_window; i++) {
+		double score = defrag_score(ssd, window[i], now);
+
+		if (score > best_score) {
+			best_score = score;
+			best_ix = i;
+		}
+	}
+
+	uint32_t wblock_id = window[best_ix];
+
+	window[best_ix] = window[--(*n_window)];
+
+	return wblock_id;
+}
+
+
+static inline uint32_t
+defrag_q_size(const drv_ssd *ssd)
+{
+	return cf_queue_sz(ssd->defrag_wblock_q) +
+			as_load_uint32(&ssd->n_defrag_held);
+}
+
+
+// Pace defrag by foreground read latency and free space. Run flat out when the
+// device had no reads since the last wblock, or free space is nearly exhausted.
+// Otherwise back off exponentially while reads are slower than the target, and
+// ease off the backoff while they're not.
+static uint32_t
+defrag_pace_sleep_us(drv_ssd *ssd, uint32_t target_us,
+		uint64_t *p_prev_n_timed_reads)
+{
+	as_namespace *ns = ssd->ns;
+	uint64_t n_timed_reads = as_load_uint64(&ssd->n_timed_reads);
+	bool idle = n_timed_reads == *p_prev_n_timed_reads;
+
+	*p_prev_n_timed_reads = n_timed_reads;
+
+	uint64_t critical_pct = ns->storage_min_avail_pct + DEFRAG_PACE_CRITICAL_PCT;
+	uint32_t sleep_us = ssd->defrag_sleep_us;
+
+	if (idle || (uint64_t)num_free_wblocks(ssd) * 100 <
+			(uint64_t)ssd->n_wblocks * critical_pct) {
+		sleep_us = 0;
+	}
+	else if (as_load_uint32(&ssd->read_latency_us) > target_us) {
+		sleep_us = sleep_us < DEFRAG_PACE_MIN_BACKOFF_US ?
+				DEFRAG_PACE_MIN_BACKOFF_US :
+				MIN(sleep_us * 2, DEFRAG_PACE_MAX_SLEEP_US);
+	}
+	else {
+		sleep_us -= sleep_us / 4;
+	}
+
+	as_store_uint32(&ssd->defrag_sleep_us, sleep_us);
+
+	return sleep_us;
+}
+
+
+// With numa-local write buffers, keep the device's write and defrag threads on
+// the same NUMA node as its buffers and PCIe root. Auto-pin owns affinity when
+// configured, so defer to it.
+static void
+ssd_pin_to_numa_node(const drv_ssd *ssd)
+{
+	if (ssd->swb_numa_node == CF_TOPO_INVALID_INDEX ||
+			g_config.auto_pin != CF_TOPO_AUTO_PIN_NONE) {
+		return;
+	}
+
+	if (! cf_topo_pin_to_os_numa_node(ssd->swb_numa_node)) {
+		cf_warning(AS_DRV_SSD, "%s: can't pin thread to NUMA node %hu",
+				ssd->name, ssd->swb_numa_node);
+	}
+}
+
+
 // Thread "run" function to service a device's defrag queue.
 void*
 run_defrag(void *pv_data)
@@ -859,24 +1317,45 @@ run_defrag(void *pv_data)
 	uint32_t wblock_id;
 	uint8_t *read_buf = cf_valloc(ssd->write_block_size);
 
+	// Rather than strictly FIFO, choose among a window of queued wblocks.
+	uint32_t window[DEFRAG_WINDOW];
+	uint32_t n_window = 0;
+
+	uint64_t prev_n_timed_reads = 0;
+
+	ssd->defrag_sleep_us = ns->storage_defrag_sleep;
+
+	as_storage_set_thread_io_class(AS_STORAGE_IO_DEFRAG);
+	ssd_pin_to_numa_node(ssd);
+
 	while (true) {
 		uint32_t q_min = as_load_uint32(&ns->storage_defrag_queue_min);
 
 		if (q_min == 0) {
-			cf_queue_pop(ssd->defrag_wblock_q, &wblock_id, CF_QUEUE_FOREVER);
-		}
-		else {
-			if (cf_queue_sz(ssd->defrag_wblock_q) <= q_min) {
-				usleep(1000 * 50);
-				continue;
+			if (n_window == 0) {
+				cf_queue_pop(ssd->defrag_wblock_q, &window[n_window++],
+						CF_QUEUE_FOREVER);
 			}
+		}
+		else if (defrag_q_size(ssd) <= q_min) {
+			usleep(1000 * 50);
+			continue;
+		}
 
-			cf_queue_pop(ssd->defrag_wblock_q, &wblock_id, CF_QUEUE_NOWAIT);
+		while (n_window < DEFRAG_WINDOW && cf_queue_pop(ssd->defrag_wblock_q,
+				&window[n_window], CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			n_window++;
 		}
 
+		wblock_id = defrag_window_select(ssd, window, &n_window);
+		as_store_uint32(&ssd->n_defrag_held, n_window);
+
 		ssd_defrag_wblock(ssd, wblock_id, read_buf);
 
-		uint32_t sleep_us = ns->storage_defrag_sleep;
+		uint32_t target_us = as_load_uint32(&ns->storage_defrag_target_read_us);
+		uint32_t sleep_us = target_us == 0 ?
+				ns->storage_defrag_sleep :
+				defrag_pace_sleep_us(ssd, target_us, &prev_n_timed_reads);
 
 		if (sleep_us != 0) {
 			usleep(sleep_us);
@@ -1064,19 +1543,24 @@ ssd_load_wblock_queues(drv_ssds *ssds)
 }
 
 
-void
-ssd_wblock_init(drv_ssd *ssd)
-{
-	uint32_t n_wblocks = (uint32_t)(ssd->file_size / ssd->write_block_size);
+typedef struct wblock_init_job_s {
+	drv_ssd *ssd;
+	uint32_t from_id;
+	uint32_t to_id;
+} wblock_init_job;
 
-	cf_info(AS_DRV_SSD, "%s has %u wblocks of size %u", ssd->name, n_wblocks,
-			ssd->write_block_size);
+// Don't bother splitting smaller ranges across threads.
+#define MIN_WBLOCKS_PER_INIT_JOB (1024 * 1024)
 
-	ssd->n_wblocks = n_wblocks;
-	ssd->wblock_state = cf_malloc(n_wblocks * sizeof(ssd_wblock_state));
+// Thread "run" function to initialize a range of a device's wblock states.
+void*
+run_wblock_init(void *pv_data)
+{
+	wblock_init_job *job = (wblock_init_job*)pv_data;
+	drv_ssd *ssd = job->ssd;
 
 	// Device header wblocks' inuse_sz will (also) be 0 but that doesn't matter.
-	for (uint32_t i = 0; i < n_wblocks; i++) {
+	for (uint32_t i = job->from_id; i < job->to_id; i++) {
 		ssd_wblock_state * p_wblock_state = &ssd->wblock_state[i];
 
 		cf_atomic32_set(&p_wblock_state->inuse_sz, 0);
@@ -1084,7 +1568,65 @@ ssd_wblock_init(drv_ssd *ssd)
 		p_wblock_state->swb = NULL;
 		p_wblock_state->state = WBLOCK_STATE_NONE;
 		p_wblock_state->n_vac_dests = 0;
+		p_wblock_state->n_frees = 0;
+		p_wblock_state->write_time = 0;
+	}
+
+	return NULL;
+}
+
+
+void
+ssd_wblock_init(drv_ssds *ssds)
+{
+	// Split this task across devices, and big devices across multiple threads.
+	uint32_t max_jobs_per_ssd = cf_topo_count_cpus() / (uint32_t)ssds->n_ssds;
+
+	if (max_jobs_per_ssd == 0) {
+		max_jobs_per_ssd = 1;
 	}
+
+	wblock_init_job *jobs = cf_malloc(ssds->n_ssds * max_jobs_per_ssd *
+			sizeof(wblock_init_job));
+	cf_tid tids[ssds->n_ssds * max_jobs_per_ssd];
+	uint32_t n_jobs = 0;
+
+	for (int i = 0; i < ssds->n_ssds; i++) {
+		drv_ssd *ssd = &ssds->ssds[i];
+		uint32_t n_wblocks = (uint32_t)(ssd->file_size / ssd->write_block_size);
+
+		cf_info(AS_DRV_SSD, "%s has %u wblocks of size %u", ssd->name,
+				n_wblocks, ssd->write_block_size);
+
+		ssd->n_wblocks = n_wblocks;
+		ssd->wblock_state = cf_malloc(n_wblocks * sizeof(ssd_wblock_state));
+
+		uint32_t n_ssd_jobs = n_wblocks / MIN_WBLOCKS_PER_INIT_JOB;
+
+		if (n_ssd_jobs == 0) {
+			n_ssd_jobs = 1;
+		}
+		else if (n_ssd_jobs > max_jobs_per_ssd) {
+			n_ssd_jobs = max_jobs_per_ssd;
+		}
+
+		for (uint32_t j = 0; j < n_ssd_jobs; j++) {
+			wblock_init_job *job = &jobs[n_jobs];
+
+			job->ssd = ssd;
+			job->from_id = (uint32_t)((uint64_t)n_wblocks * j / n_ssd_jobs);
+			job->to_id = (uint32_t)((uint64_t)n_wblocks * (j + 1) / n_ssd_jobs);
+
+			tids[n_jobs++] = cf_thread_create_joinable(run_wblock_init,
+					(void*)job);
+		}
+	}
+
+	for (uint32_t j = 0; j < n_jobs; j++) {
+		cf_thread_join(tids[j]);
+	}
+
+	cf_free(jobs);
 }
 
 
@@ -1092,6 +1634,218 @@ ssd_wblock_init(drv_ssd *ssd)
 // Record reading utilities.
 //
 
+static int
+prefetch_rec_compare(const void *pa, const void *pb)
+{
+	const prefetch_rec *a = (const prefetch_rec *)pa;
+	const prefetch_rec *b = (const prefetch_rec *)pb;
+
+	if (a->ssd->file_id != b->ssd->file_id) {
+		return a->ssd->file_id < b->ssd->file_id ? -1 : 1;
+	}
+
+	return a->offset < b->offset ? -1 : (a->offset > b->offset ? 1 : 0);
+}
+
+
+// Queues an extent - its data isn't valid until prefetch_read_extents().
+static void
+prefetch_add_extent(drv_ssd *ssd, uint32_t wblock_id, uint64_t offset,
+		uint64_t end_offset)
+{
+	ssd_wblock_state *wblock_state = &ssd->wblock_state[wblock_id];
+
+	// Read the free count before checking the swb and reading - if the wblock
+	// is freed (and reused) after this, consumers will ignore the extent.
+	uint32_t n_frees = as_load_uint32(&wblock_state->n_frees);
+
+	cf_mutex_lock(&wblock_state->LOCK);
+
+	bool in_swb = wblock_state->swb != NULL;
+
+	cf_mutex_unlock(&wblock_state->LOCK);
+
+	if (in_swb) {
+		return; // sub-transactions will read from the swb
+	}
+
+	if (g_n_prefetch_extents == g_prefetch_capacity) {
+		g_prefetch_capacity = g_prefetch_capacity == 0 ?
+				16 : g_prefetch_capacity * 2;
+		g_prefetch_extents = cf_realloc(g_prefetch_extents,
+				g_prefetch_capacity * sizeof(prefetch_extent));
+	}
+
+	g_prefetch_extents[g_n_prefetch_extents++] = (prefetch_extent){
+			.ssd = ssd,
+			.wblock_id = wblock_id,
+			.n_frees = n_frees,
+			.offset = offset,
+			.end_offset = end_offset,
+			.buf = cf_valloc(end_offset - offset)
+	};
+}
+
+
+static void
+prefetch_read_failed(prefetch_extent *e, int fd, int err)
+{
+	drv_ssd *ssd = e->ssd;
+
+	cf_warning(AS_DRV_SSD, "{%s} prefetch %s: IO failed errno %d (%s) size %lu",
+			ssd->ns->name, ssd->name, err, cf_strerror(err),
+			e->end_offset - e->offset);
+	close(fd);
+	as_decr_uint32(&ssd->n_fds);
+}
+
+
+// Issues every queued extent's read at once on the thread's io_uring,
+// completions arriving in any order. Returns false, with nothing read, if the
+// ring can't be used. Extents that fail are marked by freeing their buf.
+static bool
+prefetch_read_extents_uring(as_namespace *ns, uint32_t first)
+{
+	cf_uring *ring = cf_uring_thread_ring();
+
+	if (ring == NULL) {
+		return false;
+	}
+
+	uint32_t n_reads = g_n_prefetch_extents - first;
+	cf_uring_read *reads = cf_malloc(n_reads * sizeof(cf_uring_read));
+
+	for (uint32_t i = 0; i < n_reads; i++) {
+		prefetch_extent *e = &g_prefetch_extents[first + i];
+
+		reads[i] = (cf_uring_read){
+				.fd = ssd_fd_get(e->ssd),
+				.buf = e->buf,
+				.size = e->end_offset - e->offset,
+				.offset = (off_t)e->offset
+		};
+	}
+
+	uint64_t start_ns = ns->storage_benchmarks_enabled ? cf_getns() : 0;
+	bool ok = cf_uring_pread_batch(ring, reads, n_reads);
+
+	for (uint32_t i = 0; i < n_reads; i++) {
+		prefetch_extent *e = &g_prefetch_extents[first + i];
+
+		if (! ok) {
+			ssd_fd_put(e->ssd, reads[i].fd);
+			continue;
+		}
+
+		if (reads[i].err == 0) {
+			if (start_ns != 0) {
+				histogram_insert_data_point(e->ssd->hist_read, start_ns);
+			}
+
+			ssd_fd_put(e->ssd, reads[i].fd);
+			continue;
+		}
+
+		if (reads[i].err == EOPNOTSUPP || reads[i].err == EINVAL) {
+			// Let the blocking path redo it - and notice polled IO is out.
+			int fd = reads[i].fd;
+
+			if (! ssd_pread_all(ns, e->ssd, fd, e->buf,
+					e->end_offset - e->offset, (off_t)e->offset)) {
+				prefetch_read_failed(e, fd, errno);
+				cf_free(e->buf);
+				e->buf = NULL;
+				continue;
+			}
+
+			ssd_fd_put(e->ssd, fd);
+			continue;
+		}
+
+		prefetch_read_failed(e, reads[i].fd, reads[i].err);
+		cf_free(e->buf);
+		e->buf = NULL;
+	}
+
+	cf_free(reads);
+
+	return ok;
+}
+
+
+// Reads extents queued from index first on. Failed extents are dropped -
+// their sub-transactions will read (and fail) individually.
+static void
+prefetch_read_extents(as_namespace *ns, uint32_t first)
+{
+	drv_ssds *ssds = (drv_ssds*)ns->storage_private;
+
+	if (first == g_n_prefetch_extents) {
+		return;
+	}
+
+	if (! (ns->storage_read_io_uring && ssds->ssds[0].dax_map == NULL &&
+			prefetch_read_extents_uring(ns, first))) {
+		for (uint32_t i = first; i < g_n_prefetch_extents; i++) {
+			prefetch_extent *e = &g_prefetch_extents[i];
+			drv_ssd *ssd = e->ssd;
+			int fd = ssd_fd_get(ssd);
+
+			uint64_t start_ns = ns->storage_benchmarks_enabled ? cf_getns() : 0;
+
+			if (! ssd_pread_all(ns, ssd, fd, e->buf, e->end_offset - e->offset,
+					(off_t)e->offset)) {
+				prefetch_read_failed(e, fd, errno);
+				cf_free(e->buf);
+				e->buf = NULL;
+				continue;
+			}
+
+			if (start_ns != 0) {
+				histogram_insert_data_point(ssd->hist_read, start_ns);
+			}
+
+			ssd_fd_put(ssd, fd);
+		}
+	}
+
+	uint32_t n_kept = first;
+
+	for (uint32_t i = first; i < g_n_prefetch_extents; i++) {
+		if (g_prefetch_extents[i].buf != NULL) {
+			g_prefetch_extents[n_kept++] = g_prefetch_extents[i];
+		}
+	}
+
+	g_n_prefetch_extents = n_kept;
+}
+
+
+// Returns a pointer to the record's (still encrypted) bytes if a current
+// prefetch extent covers it.
+static const uint8_t *
+prefetch_find(const drv_ssd *ssd, uint32_t wblock_id, uint64_t record_offset,
+		uint64_t record_end_offset)
+{
+	for (uint32_t i = 0; i < g_n_prefetch_extents; i++) {
+		const prefetch_extent *e = &g_prefetch_extents[i];
+
+		if (e->ssd == ssd && e->wblock_id == wblock_id &&
+				record_offset >= e->offset &&
+				record_end_offset <= e->end_offset) {
+			if (e->n_frees !=
+					as_load_uint32(&ssd->wblock_state[wblock_id].n_frees)) {
+				return NULL; // wblock freed since prefetch - data not valid
+			}
+
+			return e->buf + (record_offset - e->offset);
+		}
+	}
+
+	return NULL;
+}
+
+
 int
 ssd_read_record(as_storage_rd *rd, bool pickle_only)
 {
@@ -1136,6 +1890,9 @@ ssd_read_record(as_storage_rd *rd, bool pickle_only)
 
 	swb_check_and_reserve(&ssd->wblock_state[wblock_id], &swb);
 
+	as_record_cache *read_cache =
+			((drv_ssds*)ns->storage_private)->read_cache;
+
 	if (swb) {
 		// Data is in write buffer, so read it from there.
 		cf_atomic32_incr(&ns->n_reads_from_cache);
@@ -1149,6 +1906,13 @@ ssd_read_record(as_storage_rd *rd, bool pickle_only)
 
 		ssd_decrypt_whole(ssd, record_offset, r->n_rblocks, flat);
 	}
+	else if (read_cache != NULL && (read_buf = as_record_cache_get(read_cache,
+			&r->keyd, r->rblock_id, record_size)) != NULL) {
+		// Data is in record cache - already decrypted and checked.
+		cf_atomic32_incr(&ns->n_reads_from_cache);
+
+		flat = (as_flat_record*)read_buf;
+	}
 	else {
 		// Normal case - data is read from device.
 		cf_atomic32_incr(&ns->n_reads_from_device);
@@ -1158,35 +1922,85 @@ ssd_read_record(as_storage_rd *rd, bool pickle_only)
 		size_t read_size = read_end_offset - read_offset;
 		uint64_t record_buf_indent = record_offset - read_offset;
 
-		read_buf = cf_valloc(read_size);
-
-		int fd = rd->read_page_cache ? ssd_fd_cache_get(ssd) : ssd_fd_get(ssd);
+		const uint8_t *prefetched = g_n_prefetch_extents == 0 ? NULL :
+				prefetch_find(ssd, wblock_id, record_offset, record_end_offset);
 
-		uint64_t start_ns = ns->storage_benchmarks_enabled ? cf_getns() : 0;
-		uint64_t start_us = as_health_sample_device_read() ? cf_getus() : 0;
+		if (prefetched != NULL) {
+			read_size = record_size;
+			record_buf_indent = 0;
 
-		if (! pread_all(fd, read_buf, read_size, (off_t)read_offset)) {
-			cf_warning(AS_DRV_SSD, "{%s} read %s: IO failed errno %d (%s) size %lu digest %pD",
-					ns->name, ssd->name, errno, cf_strerror(errno), read_size,
-					&r->keyd);
-			cf_free(read_buf);
-			close(fd);
-			as_decr_uint32(rd->read_page_cache ?
-					&ssd->n_cache_fds : &ssd->n_fds);
-			return -1;
+			read_buf = cf_malloc(record_size);
+			memcpy(read_buf, prefetched, record_size);
 		}
+		else if (ssd->dax_map != NULL) {
+			// A direct load - no IO alignment needed.
+			read_size = record_size;
+			record_buf_indent = 0;
 
-		if (start_ns != 0) {
-			histogram_insert_data_point(ssd->hist_read, start_ns);
+			read_buf = cf_malloc(record_size);
+			memcpy(read_buf, ssd->dax_map + record_offset, record_size);
 		}
+		else {
+			read_buf = cf_valloc(read_size);
 
-		as_health_add_device_latency(ns->ix, r->file_id, start_us);
+			int fd = rd->read_page_cache ? ssd_fd_cache_get(ssd) : ssd_fd_get(ssd);
 
-		if (rd->read_page_cache) {
-			ssd_fd_cache_put(ssd, fd);
-		}
-		else {
-			ssd_fd_put(ssd, fd);
+			uint64_t start_ns = ns->storage_benchmarks_enabled ? cf_getns() : 0;
+			uint64_t start_us = as_health_sample_device_read() ? cf_getus() : 0;
+			uint64_t heat_start_us = as_device_heat_read_start(ns);
+			uint64_t lat_start_us = ns->storage_read_offload_us != 0 ||
+					ns->storage_defrag_target_read_us != 0 ? cf_getus() : 0;
+
+			ASD_PROBE3(storage__read_start, ns->ix, r->file_id, read_size);
+
+			uint32_t io_class = ssd_read_begin(ssd);
+
+			bool ok = rd->read_page_cache ?
+					pread_all(fd, read_buf, read_size, (off_t)read_offset) :
+					ssd_pread_all(ns, ssd, fd, read_buf, read_size,
+							(off_t)read_offset);
+
+			ssd_read_end(ssd, io_class);
+
+			if (! ok) {
+				cf_warning(AS_DRV_SSD, "{%s} read %s: IO failed errno %d (%s) size %lu digest %pD",
+						ns->name, ssd->name, errno, cf_strerror(errno), read_size,
+						&r->keyd);
+				cf_free(read_buf);
+				close(fd);
+				as_decr_uint32(rd->read_page_cache ?
+						&ssd->n_cache_fds : &ssd->n_fds);
+				return -1;
+			}
+
+			if (start_ns != 0) {
+				histogram_insert_data_point(ssd->hist_read, start_ns);
+			}
+
+			ASD_PROBE3(storage__read_done, ns->ix, r->file_id, read_size);
+
+			as_health_add_device_latency(ns->ix, r->file_id, start_us);
+			as_device_heat_add(ns, r->file_id, AS_DEVICE_HEAT_READ,
+					heat_start_us);
+
+			if (lat_start_us != 0) {
+				uint64_t lat_us = cf_getus() - lat_start_us;
+
+				if (ns->storage_read_offload_us != 0) {
+					ssd_track_read_latency(ns, lat_us);
+				}
+
+				if (ns->storage_defrag_target_read_us != 0) {
+					ssd_track_device_read_latency(ssd, lat_us);
+				}
+			}
+
+			if (rd->read_page_cache) {
+				ssd_fd_cache_put(ssd, fd);
+			}
+			else {
+				ssd_fd_put(ssd, fd);
+			}
 		}
 
 		flat = (as_flat_record*)(read_buf + record_buf_indent);
@@ -1216,9 +2030,23 @@ ssd_read_record(as_storage_rd *rd, bool pickle_only)
 			return -1;
 		}
 
+		if (ns->storage_record_checksums && ! ssd->pi_protected &&
+				! pickle_only && ssd_find_and_check_end_mark((const uint8_t*)flat +
+						record_size - END_MARK_SZ, flat) == NULL) {
+			cf_warning(AS_DRV_SSD, "{%s} read %s: bad checksum digest %pD",
+					ns->name, ssd->name, &r->keyd);
+			cf_free(read_buf);
+			return -1;
+		}
+
 		if (ns->storage_benchmarks_enabled) {
 			histogram_insert_raw(ns->device_read_size_hist, read_size);
 		}
+
+		if (read_cache != NULL) {
+			as_record_cache_put(read_cache, &r->keyd, r->rblock_id,
+					(const uint8_t*)flat, record_size);
+		}
 	}
 
 	rd->flat = flat;
@@ -1280,6 +2108,19 @@ as_storage_record_load_bins_ssd(as_storage_rd *rd)
 		return -AS_ERR_UNKNOWN;
 	}
 
+	if (rd->bin_proj != NULL) {
+		int n_bins = as_flat_unpack_projected_bins(rd->ns, rd->flat_bins,
+				rd->flat_end, rd->flat_n_bins, rd->bin_proj, rd->bins);
+
+		if (n_bins < 0) {
+			return n_bins;
+		}
+
+		rd->n_bins = (uint16_t)n_bins;
+
+		return AS_OK;
+	}
+
 	int result = as_flat_unpack_bins(rd->ns, rd->flat_bins, rd->flat_end,
 			rd->flat_n_bins, rd->bins);
 
@@ -1332,10 +2173,128 @@ as_storage_record_load_pickle_ssd(as_storage_rd *rd)
 }
 
 
+// Read records for a set of batch sub-transactions in as few device IOs as
+// possible - records close together in the same wblock are read in one IO.
+// With io_uring, all the IOs are in flight together, so one slow device only
+// delays the batch by its own latency. Sub-transactions subsequently
+// processed on this thread use the results.
+void
+as_storage_read_prefetch_ssd(as_namespace *ns, const cf_digest *keyds,
+		uint32_t n_keys)
+{
+	drv_ssds *ssds = (drv_ssds*)ns->storage_private;
+	bool async = ns->storage_read_io_uring && ssds->ssds[0].dax_map == NULL;
+	uint32_t first_extent = g_n_prefetch_extents;
+	prefetch_rec *recs = cf_malloc(n_keys * sizeof(prefetch_rec));
+	uint32_t n_recs = 0;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_partition_reservation rsv;
+
+		as_partition_reserve(ns, as_partition_getid(&keyds[i]), &rsv);
+
+		as_index_ref r_ref;
+
+		if (as_record_get(rsv.tree, &keyds[i], &r_ref) == 0) {
+			as_record *r = r_ref.r;
+
+			if (STORAGE_RBLOCK_IS_VALID(r->rblock_id) &&
+					r->file_id < ssds->n_ssds) {
+				drv_ssd *ssd = &ssds->ssds[r->file_id];
+				uint64_t offset = RBLOCK_ID_TO_OFFSET(r->rblock_id);
+				uint32_t wblock_id = OFFSET_TO_WBLOCK_ID(ssd, offset);
+
+				if (wblock_id < ssd->n_wblocks) {
+					recs[n_recs++] = (prefetch_rec){
+							.ssd = ssd,
+							.offset = BYTES_DOWN_TO_IO_MIN(ssd, offset),
+							.end_offset = BYTES_UP_TO_IO_MIN(ssd, offset +
+									N_RBLOCKS_TO_SIZE(r->n_rblocks)),
+							.wblock_id = wblock_id
+					};
+				}
+			}
+
+			as_record_done(&r_ref, ns);
+		}
+
+		as_partition_release(&rsv);
+	}
+
+	qsort(recs, n_recs, sizeof(prefetch_rec), prefetch_rec_compare);
+
+	uint64_t total_sz = 0;
+	uint32_t i = 0;
+
+	while (i < n_recs && total_sz < PREFETCH_MAX_SIZE) {
+		prefetch_rec *first = &recs[i];
+		uint64_t end_offset = first->end_offset;
+		uint32_t n_merged = 1;
+
+		for (i++; i < n_recs; i++) {
+			prefetch_rec *next = &recs[i];
+
+			if (next->ssd != first->ssd || next->wblock_id != first->wblock_id ||
+					next->offset > end_offset + PREFETCH_MAX_GAP) {
+				break;
+			}
+
+			if (next->end_offset > end_offset) {
+				end_offset = next->end_offset;
+			}
+
+			n_merged++;
+		}
+
+		// Lone records only gain by overlapping with the batch's other IOs.
+		if (n_merged > 1 || async) {
+			prefetch_add_extent(first->ssd, first->wblock_id, first->offset,
+					end_offset);
+			total_sz += end_offset - first->offset;
+		}
+	}
+
+	cf_free(recs);
+
+	prefetch_read_extents(ns, first_extent);
+}
+
+
+void
+as_storage_read_prefetch_clear_ssd(void)
+{
+	for (uint32_t i = 0; i < g_n_prefetch_extents; i++) {
+		cf_free(g_prefetch_extents[i].buf);
+	}
+
+	g_n_prefetch_extents = 0;
+}
+
+
 //==========================================================
 // Record writing utilities.
 //
 
+// The hint applies to the device (inode), not the fd, so only set it when the
+// stream changes. NVMe drivers map these hints to FDP placement handles (or
+// streams) where supported. Concurrent flushers may race - benign.
+static void
+ssd_set_write_life(drv_ssd *ssd, int fd, uint64_t write_life)
+{
+	if (write_life == as_load_uint64(&ssd->write_life)) {
+		return;
+	}
+
+	if (fcntl(fd, F_SET_RW_HINT, &write_life) != 0) {
+		cf_ticker_warning(AS_DRV_SSD, "%s: failed setting write lifetime hint: errno %d (%s)",
+				ssd->name, errno, cf_strerror(errno));
+		return;
+	}
+
+	as_store_uint64(&ssd->write_life, write_life);
+}
+
+
 void
 ssd_flush_swb(drv_ssd *ssd, ssd_write_buf *swb)
 {
@@ -1352,17 +2311,33 @@ ssd_flush_swb(drv_ssd *ssd, ssd_write_buf *swb)
 	int fd = ssd_fd_get(ssd);
 	off_t write_offset = (off_t)WBLOCK_ID_TO_OFFSET(ssd, swb->wblock_id);
 
+	if (ssd->ns->storage_write_lifetime_hints) {
+		ssd_set_write_life(ssd, fd, swb->write_life);
+	}
+
 	uint64_t start_ns = ssd->ns->storage_benchmarks_enabled ? cf_getns() : 0;
+	uint64_t heat_start_us = as_device_heat_write_start(ssd->ns);
 
-	if (! pwrite_all(fd, swb->buf, ssd->write_block_size, write_offset)) {
+	ASD_PROBE3(storage__write_start, ssd->ns->ix, ssd->file_id, swb->wblock_id);
+
+	if (ssd->dax_map != NULL) {
+		ssd_dax_write(ssd, swb->buf, ssd->write_block_size, write_offset);
+	}
+	else if (! pwrite_all(fd, swb->buf, ssd->write_block_size, write_offset)) {
 		cf_crash(AS_DRV_SSD, "%s: DEVICE FAILED write: errno %d (%s)",
 				ssd->name, errno, cf_strerror(errno));
 	}
 
+	ASD_PROBE3(storage__write_done, ssd->ns->ix, ssd->file_id, swb->wblock_id);
+
 	if (start_ns != 0) {
 		histogram_insert_data_point(ssd->hist_write, start_ns);
+		histogram_insert_raw(ssd->hist_wblock_fill, swb->pos);
 	}
 
+	as_device_heat_add(ssd->ns, (uint32_t)ssd->file_id, AS_DEVICE_HEAT_WRITE,
+			heat_start_us);
+
 	ssd_fd_put(ssd, fd);
 }
 
@@ -1442,6 +2417,8 @@ run_write(void *arg)
 {
 	drv_ssd *ssd = (drv_ssd*)arg;
 
+	ssd_pin_to_numa_node(ssd);
+
 	while (ssd->running) {
 		ssd_write_buf *swb;
 
@@ -1456,6 +2433,14 @@ run_write(void *arg)
 		ssd_flush_swb(ssd, swb);
 
 		if (ssd->shadow_name) {
+			// With shadow-max-lag, the shadow write is off the write queue's
+			// books - it's bounded separately.
+			if (as_load_uint32(&ssd->ns->storage_shadow_max_lag_q) != 0) {
+				swb->shadow_lagging = true;
+				cf_atomic32_incr(&ssd->ns->n_shadow_wblocks_lagging);
+				cf_atomic32_decr(&ssd->ns->n_wblocks_to_flush);
+			}
+
 			// Queue for shadow device write.
 			cf_queue_push(ssd->swb_shadow_q, &swb);
 		}
@@ -1467,6 +2452,7 @@ run_write(void *arg)
 			ssd_post_write(ssd, swb);
 
 			cf_atomic32_decr(&ssd->ns->n_wblocks_to_flush);
+			cf_atomic64_incr(&ssd->n_wblocks_flushed);
 		}
 	} // infinite event loop waiting for block to write
 
@@ -1474,52 +2460,204 @@ run_write(void *arg)
 }
 
 
+// Write a run of swbs with consecutive wblock-ids to the shadow device in one
+// (large, sequential) write.
+static void
+ssd_shadow_flush_swb_run(drv_ssd *ssd, ssd_write_buf **swbs, uint32_t n_swbs)
+{
+	if (n_swbs == 1) {
+		ssd_shadow_flush_swb(ssd, swbs[0]);
+		return;
+	}
+
+	struct iovec iov[SHADOW_MAX_BATCH];
+
+	for (uint32_t i = 0; i < n_swbs; i++) {
+		iov[i].iov_base = swbs[i]->buf;
+		iov[i].iov_len = ssd->write_block_size;
+	}
+
+	int fd = ssd_shadow_fd_get(ssd);
+	off_t write_offset = (off_t)WBLOCK_ID_TO_OFFSET(ssd, swbs[0]->wblock_id);
+
+	uint64_t start_ns = ssd->ns->storage_benchmarks_enabled ? cf_getns() : 0;
+
+	if (! pwritev_all(fd, iov, (int)n_swbs, write_offset)) {
+		cf_crash(AS_DRV_SSD, "%s: DEVICE FAILED write: errno %d (%s)",
+				ssd->shadow_name, errno, cf_strerror(errno));
+	}
+
+	if (start_ns != 0) {
+		histogram_insert_data_point(ssd->hist_shadow_write, start_ns);
+	}
+
+	ssd_shadow_fd_put(ssd, fd);
+}
+
+
 // Thread "run" function that flushes write buffers to shadow device.
 void *
 run_shadow(void *arg)
 {
 	drv_ssd *ssd = (drv_ssd*)arg;
+	ssd_write_buf *batch[SHADOW_MAX_BATCH];
 
 	while (ssd->running) {
-		ssd_write_buf *swb;
-
-		if (CF_QUEUE_OK != cf_queue_pop(ssd->swb_shadow_q, &swb, 100)) {
+		if (CF_QUEUE_OK != cf_queue_pop(ssd->swb_shadow_q, &batch[0], 100)) {
 			continue;
 		}
 
-		// Sanity checks (optional).
-		ssd_write_sanity_checks(ssd, swb);
+		// Take whatever else has backed up, to coalesce into fewer writes.
+		uint32_t n_batch = 1;
+
+		while (n_batch < SHADOW_MAX_BATCH && cf_queue_pop(ssd->swb_shadow_q,
+				&batch[n_batch], CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			n_batch++;
+		}
+
+		// Sort by wblock-id (insertion sort - batch is small).
+		for (uint32_t i = 1; i < n_batch; i++) {
+			ssd_write_buf *swb = batch[i];
+			uint32_t j = i;
+
+			for ( ; j > 0 && batch[j - 1]->wblock_id > swb->wblock_id; j--) {
+				batch[j] = batch[j - 1];
+			}
+
+			batch[j] = swb;
+		}
+
+		for (uint32_t i = 0; i < n_batch; i++) {
+			// Sanity checks (optional).
+			ssd_write_sanity_checks(ssd, batch[i]);
+		}
+
+		// Flush to the shadow device, a run of consecutive wblocks at a time.
+		uint32_t run_start = 0;
+
+		for (uint32_t i = 1; i <= n_batch; i++) {
+			if (i == n_batch ||
+					batch[i]->wblock_id != batch[i - 1]->wblock_id + 1) {
+				ssd_shadow_flush_swb_run(ssd, &batch[run_start], i - run_start);
+				run_start = i;
+			}
+		}
+
+		cf_atomic64_incr(&ssd->n_shadow_batches);
+		cf_atomic64_add(&ssd->n_shadow_batch_wblocks, (int64_t)n_batch);
+
+		for (uint32_t i = 0; i < n_batch; i++) {
+			ssd_write_buf *swb = batch[i];
+
+			if (swb->shadow_lagging) {
+				swb->shadow_lagging = false;
+				cf_atomic32_decr(&ssd->ns->n_shadow_wblocks_lagging);
+			}
+			else {
+				cf_atomic32_decr(&ssd->ns->n_wblocks_to_flush);
+			}
+
+			// If this swb was a defrag destination, release the sources.
+			swb_release_all_vacated_wblocks(swb);
+
+			// Transfer to post-write queue, or release swb, as appropriate.
+			ssd_post_write(ssd, swb);
+
+			cf_atomic64_incr(&ssd->n_wblocks_flushed);
+		}
+	}
+
+	return NULL;
+}
+
+
+void
+ssd_start_write_threads(drv_ssds *ssds)
+{
+	cf_info(AS_DRV_SSD, "{%s} starting write threads", ssds->ns->name);
+
+	for (int i = 0; i < ssds->n_ssds; i++) {
+		drv_ssd *ssd = &ssds->ssds[i];
+
+		ssd->write_tid = cf_thread_create_joinable(run_write, (void*)ssd);
+
+		if (ssd->shadow_name) {
+			ssd->shadow_tid = cf_thread_create_joinable(run_shadow, (void*)ssd);
+		}
+	}
+
+	ssds->write_threads_started = true;
+}
+
+
+// Upper TTL limits of all but the last TTL band, in seconds.
+static const uint32_t TTL_STREAM_LIMITS[MAX_TTL_WRITE_STREAMS - 1] = {
+		60 * 60,				// 1 hour
+		60 * 60 * 24,			// 1 day
+		60 * 60 * 24 * 7,		// 1 week
+		60 * 60 * 24 * 30,		// 30 days
+		60 * 60 * 24 * 90,		// 90 days
+		60 * 60 * 24 * 365,		// 1 year
+		60 * 60 * 24 * 365 * 4	// 4 years
+};
+
+// Group records by remaining TTL, so wblocks tend to expire all together.
+// Records that never expire go in the last band.
+static inline uint32_t
+ssd_ttl_stream(const as_namespace *ns, const as_record *r)
+{
+	uint32_t n_streams = as_load_uint32(&ns->storage_ttl_write_streams);
+
+	if (n_streams <= 1 || r->void_time == 0) {
+		return n_streams - 1;
+	}
+
+	uint32_t now = as_record_void_time_get();
+	uint32_t ttl = r->void_time > now ? r->void_time - now : 0;
+
+	for (uint32_t i = 0; i < n_streams - 1; i++) {
+		if (ttl < TTL_STREAM_LIMITS[i]) {
+			return i;
+		}
+	}
 
-		// Flush to the shadow device.
-		ssd_shadow_flush_swb(ssd, swb);
+	return n_streams - 1;
+}
 
-		// If this swb was a defrag destination, release the sources.
-		swb_release_all_vacated_wblocks(swb);
 
-		// Transfer to post-write queue, or release swb, as appropriate.
-		ssd_post_write(ssd, swb);
+// Keep large records apart from small ones, so wblocks full of (typically
+// long-lived) large records aren't emptied out by small-record churn and then
+// defragged, copying the large records along.
+static inline uint32_t
+ssd_write_stream(const as_namespace *ns, const as_record *r, uint32_t write_sz)
+{
+	uint32_t large_sz = as_load_uint32(&ns->storage_large_record_stream_size);
 
-		cf_atomic32_decr(&ssd->ns->n_wblocks_to_flush);
+	if (large_sz != 0 && write_sz >= large_sz) {
+		return LARGE_RECORD_STREAM;
 	}
 
-	return NULL;
+	return ssd_ttl_stream(ns, r);
 }
 
 
-void
-ssd_start_write_threads(drv_ssds *ssds)
+// Spread TTL streams over the short to extreme lifetime hints. Large records
+// are (typically) written once and read many times.
+static inline uint64_t
+ssd_stream_write_life(const as_namespace *ns, uint32_t stream)
 {
-	cf_info(AS_DRV_SSD, "{%s} starting write threads", ssds->ns->name);
-
-	for (int i = 0; i < ssds->n_ssds; i++) {
-		drv_ssd *ssd = &ssds->ssds[i];
+	if (stream == LARGE_RECORD_STREAM) {
+		return RWH_WRITE_LIFE_LONG;
+	}
 
-		ssd->write_tid = cf_thread_create_joinable(run_write, (void*)ssd);
+	uint32_t n_streams = as_load_uint32(&ns->storage_ttl_write_streams);
 
-		if (ssd->shadow_name) {
-			ssd->shadow_tid = cf_thread_create_joinable(run_shadow, (void*)ssd);
-		}
+	if (n_streams <= 1) {
+		return RWH_WRITE_LIFE_MEDIUM;
 	}
+
+	return RWH_WRITE_LIFE_SHORT + ((stream *
+			(RWH_WRITE_LIFE_EXTREME - RWH_WRITE_LIFE_SHORT)) / (n_streams - 1));
 }
 
 
@@ -1575,7 +2713,9 @@ ssd_buffer_bins(as_storage_rd *rd)
 
 	// Reserve the portion of the current swb where this record will be written.
 
-	current_swb *cur_swb = &ssd->current_swbs[rd->which_current_swb];
+	uint32_t stream = ssd_write_stream(ns, r, write_sz);
+	current_swb *cur_swb = &ssd->current_swbs[(rd->which_current_swb *
+			N_STREAMS_PER_CURRENT_SWB) + stream];
 
 	cf_mutex_lock(&cur_swb->lock);
 
@@ -1592,6 +2732,7 @@ ssd_buffer_bins(as_storage_rd *rd)
 		}
 
 		swb->use_post_write_q = write_uses_post_write_q(rd);
+		swb->write_life = ssd_stream_write_life(ns, stream);
 	}
 
 	// Check if there's enough space in current buffer - if not, enqueue it to
@@ -1612,6 +2753,7 @@ ssd_buffer_bins(as_storage_rd *rd)
 		}
 
 		swb->use_post_write_q = write_uses_post_write_q(rd);
+		swb->write_life = ssd_stream_write_life(ns, stream);
 	}
 
 	uint32_t n_rblocks = ROUNDED_SIZE_TO_N_RBLOCKS(write_sz);
@@ -1623,13 +2765,29 @@ ssd_buffer_bins(as_storage_rd *rd)
 	uint32_t swb_pos;
 	int rv = 0;
 
-	if (n_rblocks == r->n_rblocks &&
+	bool prev_in_swb = STORAGE_RBLOCK_IS_VALID(r->rblock_id) &&
 			swb->wblock_id == RBLOCK_ID_TO_WBLOCK_ID(ssd, r->rblock_id) &&
-			ssd->file_id == r->file_id) {
+			ssd->file_id == r->file_id;
+	uint32_t prev_pos = prev_in_swb ?
+			(uint32_t)(RBLOCK_ID_TO_OFFSET(r->rblock_id) -
+					WBLOCK_ID_TO_OFFSET(ssd, swb->wblock_id)) : 0;
+
+	if (prev_in_swb && n_rblocks == r->n_rblocks) {
 		// Stored size is unchanged, and previous version is in this buffer -
 		// just overwrite at the previous position.
-		swb_pos = RBLOCK_ID_TO_OFFSET(r->rblock_id) -
-				WBLOCK_ID_TO_OFFSET(ssd, swb->wblock_id);
+		swb_pos = prev_pos;
+		rv = WRITE_IN_PLACE;
+	}
+	else if (prev_in_swb && n_rblocks > r->n_rblocks &&
+			prev_pos + N_RBLOCKS_TO_SIZE(r->n_rblocks) == swb->pos &&
+			prev_pos + write_sz <= ssd->write_block_size) {
+		// Record grew, but previous version is the last one in this buffer -
+		// extend it in place rather than append another full copy. Typical of
+		// repeated small updates (e.g. list appends) to a large hot record.
+		// Shrinking is never done in place - the tail beyond the new end may
+		// already be flushed, and would not parse on cold start.
+		swb_pos = prev_pos;
+		swb->pos = prev_pos + write_sz;
 		rv = WRITE_IN_PLACE;
 	}
 	else {
@@ -1642,6 +2800,10 @@ ssd_buffer_bins(as_storage_rd *rd)
 	cf_atomic32_incr(&swb->n_writers);
 	swb->dirty = true;
 
+	if (swb_pos < swb->dirty_lo) {
+		swb->dirty_lo = swb_pos;
+	}
+
 	cf_mutex_unlock(&cur_swb->lock);
 	// May now write this record concurrently with others in this swb.
 
@@ -1656,7 +2818,12 @@ ssd_buffer_bins(as_storage_rd *rd)
 		memcpy(flat_in_swb, flat, flat_sz);
 	}
 
-	ssd_add_end_mark((uint8_t*)flat_in_swb + flat_sz, flat_in_swb);
+	if (ns->storage_record_checksums) {
+		ssd_add_crc_end_mark((uint8_t*)flat_in_swb + flat_sz, flat_in_swb);
+	}
+	else {
+		ssd_add_end_mark((uint8_t*)flat_in_swb + flat_sz, flat_in_swb);
+	}
 
 	// Make a pickle if needed.
 	if (rd->keep_pickle) {
@@ -1671,6 +2838,15 @@ ssd_buffer_bins(as_storage_rd *rd)
 
 	uint64_t write_offset = WBLOCK_ID_TO_OFFSET(ssd, swb->wblock_id) + swb_pos;
 
+	as_record_cache *read_cache = ((drv_ssds*)ns->storage_private)->read_cache;
+
+	// Keep hot records cached across updates - cache holds decrypted records.
+	if (read_cache != NULL) {
+		as_record_cache_update(read_cache, &r->keyd,
+				OFFSET_TO_RBLOCK_ID(write_offset), (const uint8_t*)flat_in_swb,
+				write_sz);
+	}
+
 	ssd_encrypt(ssd, write_offset, flat_in_swb);
 
 	if (rv != WRITE_IN_PLACE) {
@@ -1686,6 +2862,20 @@ ssd_buffer_bins(as_storage_rd *rd)
 		cf_atomic32_add(&ssd->wblock_state[swb->wblock_id].inuse_sz,
 				(int32_t)write_sz);
 	}
+	else if (n_rblocks != r->n_rblocks) {
+		// Extended in place - account only for the growth.
+		uint32_t grown_sz = N_RBLOCKS_TO_SIZE(n_rblocks) -
+				N_RBLOCKS_TO_SIZE(r->n_rblocks);
+
+		as_namespace_adjust_set_device_bytes(ns, as_index_get_set_id(r),
+				(int64_t)grown_sz);
+
+		r->n_rblocks = n_rblocks;
+
+		cf_atomic64_add(&ssd->inuse_size, (int64_t)grown_sz);
+		cf_atomic32_add(&ssd->wblock_state[swb->wblock_id].inuse_sz,
+				(int32_t)grown_sz);
+	}
 
 	// We are finished writing to the buffer.
 	cf_atomic32_decr(&swb->n_writers);
@@ -1723,6 +2913,7 @@ ssd_write(as_storage_rd *rd)
 
 	cf_assert(rd->ssd, AS_DRV_SSD, "{%s} null ssd", rd->ns->name);
 
+	// Note - ssd_buffer_bins() replaces any cached version of the record.
 	int rv = ssd_write_bins(rd);
 
 	if (rv == 0 && old_ssd) {
@@ -1829,23 +3020,34 @@ as_storage_dump_wb_summary_ssd(const as_namespace *ns)
 
 #define LOG_STATS_INTERVAL_sec 20
 
+// Per current swb stream flush bookkeeping - owned by the maintenance thread.
+typedef struct swb_flush_state_s {
+	uint64_t	n_writes;		// stream's n_wblocks_written at last check
+	uint32_t	pos;			// current swb fill at last check
+	uint64_t	check_us;		// time of last check
+	uint64_t	defer_us;		// when we started deferring the flush (0 = not)
+} swb_flush_state;
+
 void
 ssd_log_stats(drv_ssd *ssd, uint64_t *p_prev_n_total_writes,
 		uint64_t *p_prev_n_defrag_reads, uint64_t *p_prev_n_defrag_writes,
 		uint64_t *p_prev_n_defrag_io_skips, uint64_t *p_prev_n_direct_frees,
-		uint64_t *p_prev_n_tomb_raider_reads)
+		uint64_t *p_prev_n_partial_flushes, uint64_t *p_prev_n_tomb_raider_reads)
 {
 	uint64_t n_defrag_reads = cf_atomic64_get(ssd->n_defrag_wblock_reads);
 	uint64_t n_defrag_writes = cf_atomic64_get(ssd->n_defrag_wblock_writes);
 
 	uint64_t n_total_writes = n_defrag_writes;
 
-	for (uint8_t c = 0; c < N_CURRENT_SWBS; c++) {
+	for (uint8_t c = 0; c < N_CURRENT_SWB_STREAMS; c++) {
 		n_total_writes += ssd->current_swbs[c].n_wblocks_written;
 	}
 
 	uint64_t n_defrag_io_skips = cf_atomic64_get(ssd->n_wblock_defrag_io_skips);
 	uint64_t n_direct_frees = cf_atomic64_get(ssd->n_wblock_direct_frees);
+	uint64_t n_partial_flushes = cf_atomic64_get(ssd->n_partial_flushes);
+	uint64_t n_partial_flush_bytes =
+			cf_atomic64_get(ssd->n_partial_flush_bytes);
 
 	float total_write_rate = (float)(n_total_writes - *p_prev_n_total_writes) /
 			(float)LOG_STATS_INTERVAL_sec;
@@ -1858,6 +3060,21 @@ ssd_log_stats(drv_ssd *ssd, uint64_t *p_prev_n_total_writes,
 			(float)LOG_STATS_INTERVAL_sec;
 	float direct_free_rate = (float)(n_direct_frees - *p_prev_n_direct_frees) /
 			(float)LOG_STATS_INTERVAL_sec;
+	float partial_flush_rate =
+			(float)(n_partial_flushes - *p_prev_n_partial_flushes) /
+			(float)LOG_STATS_INTERVAL_sec;
+
+	// Device wblock writes per wblock of new (non-defrag) data, this interval.
+	uint64_t n_interval_writes = n_total_writes - *p_prev_n_total_writes;
+	uint64_t n_interval_defrag_writes = n_defrag_writes - *p_prev_n_defrag_writes;
+	float write_amp = n_interval_writes <= n_interval_defrag_writes ? 0.0f :
+			(float)n_interval_writes /
+			(float)(n_interval_writes - n_interval_defrag_writes);
+
+	// Average fill of partially flushed wblocks, as a percentage.
+	float partial_flush_fill_pct = n_partial_flushes == 0 ? 0.0f :
+			(float)(n_partial_flush_bytes * 100) /
+			(float)(n_partial_flushes * ssd->write_block_size);
 
 	uint64_t n_tomb_raider_reads = ssd->n_tomb_raider_reads;
 	char tomb_raider_str[64];
@@ -1882,8 +3099,12 @@ ssd_log_stats(drv_ssd *ssd, uint64_t *p_prev_n_total_writes,
 	*shadow_str = 0;
 
 	if (ssd->shadow_name) {
-		sprintf(shadow_str, " shadow-write-q %u",
-				cf_queue_sz(ssd->swb_shadow_q));
+		uint64_t n_shadow_batches = cf_atomic64_get(ssd->n_shadow_batches);
+
+		sprintf(shadow_str, " shadow-write-q %u shadow-batch-wblocks %.1f",
+				cf_queue_sz(ssd->swb_shadow_q), n_shadow_batches == 0 ? 0.0f :
+						(float)cf_atomic64_get(ssd->n_shadow_batch_wblocks) /
+								(float)n_shadow_batches);
 	}
 
 	uint32_t free_wblock_q_sz = cf_queue_sz(ssd->free_wblock_q);
@@ -1895,21 +3116,43 @@ ssd_log_stats(drv_ssd *ssd, uint64_t *p_prev_n_total_writes,
 			ssd->inuse_size, n_free_wblocks,
 			cf_queue_sz(ssd->swb_write_q),
 			n_total_writes, total_write_rate,
-			cf_queue_sz(ssd->defrag_wblock_q), n_defrag_reads, defrag_read_rate,
+			defrag_q_size(ssd), n_defrag_reads, defrag_read_rate,
 			n_defrag_writes, defrag_write_rate,
 			shadow_str, tomb_raider_str);
 
-	cf_detail(AS_DRV_SSD, "{%s} %s: free-wblocks (%u,%u) defrag-io-skips (%lu,%.1f) direct-frees (%lu,%.1f)",
+	cf_detail(AS_DRV_SSD, "{%s} %s: free-wblocks (%u,%u) defrag-io-skips (%lu,%.1f) direct-frees (%lu,%.1f) write-amp %.2f",
 			ssd->ns->name, ssd->name,
 			free_wblock_q_sz, n_pristine_wblocks,
 			n_defrag_io_skips, defrag_io_skip_rate,
-			n_direct_frees, direct_free_rate);
+			n_direct_frees, direct_free_rate, write_amp);
+
+	if (n_partial_flushes != 0) {
+		cf_info(AS_DRV_SSD, "{%s} %s: partial-flush (%lu,%.1f) partial-flush-fill-pct %.1f",
+				ssd->ns->name, ssd->name,
+				n_partial_flushes, partial_flush_rate, partial_flush_fill_pct);
+	}
+
+	uint64_t n_group_commits = cf_atomic64_get(ssd->n_group_commits);
+
+	if (n_group_commits != 0) {
+		cf_info(AS_DRV_SSD, "{%s} %s: group-commits %lu writes-per-group-commit %.1f",
+				ssd->ns->name, ssd->name, n_group_commits,
+				(float)cf_atomic64_get(ssd->n_group_commit_writes) /
+						(float)n_group_commits);
+	}
+
+	if (ssd->ns->storage_defrag_target_read_us != 0) {
+		cf_info(AS_DRV_SSD, "{%s} %s: read-latency-us %u defrag-sleep-us %u",
+				ssd->ns->name, ssd->name, as_load_uint32(&ssd->read_latency_us),
+				as_load_uint32(&ssd->defrag_sleep_us));
+	}
 
 	*p_prev_n_total_writes = n_total_writes;
 	*p_prev_n_defrag_reads = n_defrag_reads;
 	*p_prev_n_defrag_writes = n_defrag_writes;
 	*p_prev_n_defrag_io_skips = n_defrag_io_skips;
 	*p_prev_n_direct_frees = n_direct_frees;
+	*p_prev_n_partial_flushes = n_partial_flushes;
 	*p_prev_n_tomb_raider_reads = n_tomb_raider_reads;
 
 	if (n_free_wblocks == 0) {
@@ -1922,11 +3165,12 @@ void
 ssd_free_swbs(drv_ssd *ssd)
 {
 	// Try to recover swbs, 16 at a time, down to 16.
-	for (uint32_t i = 0; i < 16 && cf_queue_sz(ssd->swb_free_q) > 16; i++) {
+	for (uint32_t i = 0; i < 16 && cf_ring_queue_sz(&ssd->swb_free_q) > 16;
+			i++) {
 		ssd_write_buf* swb;
 
-		if (CF_QUEUE_OK !=
-				cf_queue_pop(ssd->swb_free_q, &swb, CF_QUEUE_NOWAIT)) {
+		if (! cf_ring_queue_pop(&ssd->swb_free_q, &swb,
+				CF_RING_QUEUE_NOWAIT)) {
 			break;
 		}
 
@@ -1935,15 +3179,66 @@ ssd_free_swbs(drv_ssd *ssd)
 }
 
 
+// Decide whether to hold back flushing an under-filled current swb, given the
+// rate at which records have been arriving in it since the last check.
+static bool
+ssd_defer_flush(const drv_ssd *ssd, const ssd_write_buf *swb,
+		swb_flush_state *fs, uint64_t now)
+{
+	as_namespace *ns = ssd->ns;
+	uint32_t min_fill_pct = as_load_uint32(&ns->storage_flush_min_fill_pct);
+	uint64_t max_defer_us = as_load_uint64(&ns->storage_flush_max_defer_us);
+
+	if (min_fill_pct == 0 || max_defer_us == 0) {
+		return false;
+	}
+
+	uint32_t target_pos = (uint32_t)
+			(((uint64_t)ssd->write_block_size * min_fill_pct) / 100);
+
+	if (swb->pos >= target_pos) {
+		return false;
+	}
+
+	if (fs->defer_us == 0) {
+		fs->defer_us = now;
+	}
+
+	uint64_t deferred_us = now - fs->defer_us;
+
+	// Don't hold records back longer than the configured bound.
+	if (deferred_us >= max_defer_us) {
+		return false;
+	}
+
+	uint32_t n_arrived = swb->pos > fs->pos ? swb->pos - fs->pos : 0;
+
+	// Nothing arriving - waiting won't fill it.
+	if (n_arrived == 0 || now <= fs->check_us) {
+		return false;
+	}
+
+	// Time to reach the target fill at the current arrival rate.
+	uint64_t fill_us = ((uint64_t)(target_pos - swb->pos) *
+			(now - fs->check_us)) / n_arrived;
+
+	return deferred_us + fill_us <= max_defer_us;
+}
+
+
 void
-ssd_flush_current_swb(drv_ssd *ssd, uint8_t which, uint64_t *p_prev_n_writes)
+ssd_flush_current_swb(drv_ssd *ssd, uint8_t which, swb_flush_state *fs,
+		uint64_t now)
 {
 	current_swb *cur_swb = &ssd->current_swbs[which];
 	uint64_t n_writes = as_load_uint64(&cur_swb->n_wblocks_written);
 
 	// If there's an active write load, we don't need to flush.
-	if (n_writes != *p_prev_n_writes) {
-		*p_prev_n_writes = n_writes;
+	if (n_writes != fs->n_writes) {
+		fs->n_writes = n_writes;
+		fs->pos = 0;
+		fs->check_us = now;
+		fs->defer_us = 0;
 		return;
 	}
 
@@ -1952,11 +3247,14 @@ ssd_flush_current_swb(drv_ssd *ssd, uint8_t which, uint64_t *p_prev_n_writes)
 	n_writes = as_load_uint64(&cur_swb->n_wblocks_written);
 
 	// Must check under the lock, could be racing a current swb just queued.
-	if (n_writes != *p_prev_n_writes) {
+	if (n_writes != fs->n_writes) {
 
 		cf_mutex_unlock(&cur_swb->lock);
 
-		*p_prev_n_writes = n_writes;
+		fs->n_writes = n_writes;
+		fs->pos = 0;
+		fs->check_us = now;
+		fs->defer_us = 0;
 		return;
 	}
 
@@ -1965,21 +3263,175 @@ ssd_flush_current_swb(drv_ssd *ssd, uint8_t which, uint64_t *p_prev_n_writes)
 
 	ssd_write_buf *swb = cur_swb->swb;
 
+	if (swb && swb->dirty && ssd_defer_flush(ssd, swb, fs, now)) {
+		fs->pos = swb->pos;
+		fs->check_us = now;
+
+		cf_mutex_unlock(&cur_swb->lock);
+		return;
+	}
+
+	fs->pos = swb ? swb->pos : 0;
+	fs->check_us = now;
+	fs->defer_us = 0;
+
 	if (swb && swb->dirty) {
 		swb->dirty = false;
 
+		cf_atomic64_incr(&ssd->n_partial_flushes);
+		cf_atomic64_add(&ssd->n_partial_flush_bytes, (int64_t)swb->pos);
+
 		// Flush it.
 		ssd_flush_swb(ssd, swb);
 
 		if (ssd->shadow_name) {
 			ssd_shadow_flush_swb(ssd, swb);
 		}
+
+		swb->dirty_lo = swb->pos;
 	}
 
 	cf_mutex_unlock(&cur_swb->lock);
 }
 
 
+// Write only the part of a current swb written since its last commit, widened
+// to IO alignment. A wblock's first commit writes it whole, so the device never
+// holds a stale tail behind committed records. Call under the current swb lock.
+static void
+ssd_commit_current_swb(drv_ssd *ssd, ssd_write_buf *swb)
+{
+	if (swb->dirty_lo == 0 || ssd->dax_map != NULL) {
+		ssd_flush_swb(ssd, swb);
+
+		if (ssd->shadow_name) {
+			ssd_shadow_flush_swb(ssd, swb);
+		}
+
+		return;
+	}
+
+	// Wait for all writers to finish.
+	while (cf_atomic32_get(swb->n_writers) != 0) {
+		;
+	}
+
+	uint64_t align = ssd->shadow_name ?
+			MAX(ssd->io_min_size, ssd->shadow_io_min_size) : ssd->io_min_size;
+	uint32_t from = (uint32_t)(swb->dirty_lo & ~(align - 1));
+	uint32_t to = (uint32_t)((swb->pos + align - 1) & ~(align - 1));
+	off_t write_offset = (off_t)WBLOCK_ID_TO_OFFSET(ssd, swb->wblock_id) + from;
+
+	int fd = ssd_fd_get(ssd);
+	uint64_t start_ns = ssd->ns->storage_benchmarks_enabled ? cf_getns() : 0;
+
+	if (! pwrite_all(fd, &swb->buf[from], to - from, write_offset)) {
+		cf_crash(AS_DRV_SSD, "%s: DEVICE FAILED write: errno %d (%s)",
+				ssd->name, errno, cf_strerror(errno));
+	}
+
+	if (start_ns != 0) {
+		histogram_insert_data_point(ssd->hist_write, start_ns);
+	}
+
+	ssd_fd_put(ssd, fd);
+
+	if (ssd->shadow_name) {
+		fd = ssd_shadow_fd_get(ssd);
+
+		if (! pwrite_all(fd, &swb->buf[from], to - from, write_offset)) {
+			cf_crash(AS_DRV_SSD, "%s: DEVICE FAILED write: errno %d (%s)",
+					ssd->shadow_name, errno, cf_strerror(errno));
+		}
+
+		ssd_shadow_fd_put(ssd, fd);
+	}
+}
+
+
+// Leader's work - make everything buffered on the device so far durable.
+static void
+ssd_commit_group(drv_ssd *ssd)
+{
+	for (uint32_t i = 0; i < N_CURRENT_SWB_STREAMS; i++) {
+		current_swb *cur_swb = &ssd->current_swbs[i];
+
+		cf_mutex_lock(&cur_swb->lock);
+
+		ssd_write_buf *swb = cur_swb->swb;
+
+		if (swb != NULL && swb->dirty) {
+			swb->dirty = false;
+
+			ssd_commit_current_swb(ssd, swb);
+
+			swb->dirty_lo = swb->pos;
+		}
+
+		cf_mutex_unlock(&cur_swb->lock);
+	}
+
+	// Group members' records may be in swbs queued since - wait for those. Any
+	// queued after the loop above were already committed by it.
+	uint64_t n_queued = cf_atomic64_get(ssd->n_wblocks_queued);
+
+	while (cf_atomic64_get(ssd->n_wblocks_flushed) < n_queued) {
+		usleep(COMMIT_POLL_US);
+	}
+
+	cf_atomic64_incr(&ssd->n_group_commits);
+}
+
+
+// Called after a commit-to-device write is buffered - returns when it's on the
+// device. The first writer in leads a group commit. Writers arriving while it
+// waits out commit-window-us join its group, later ones wait for the next - so
+// one device write acknowledges many transactions.
+void
+ssd_group_commit(drv_ssd *ssd)
+{
+	pthread_mutex_lock(&ssd->commit_lock);
+
+	cf_atomic64_incr(&ssd->n_group_commit_writes);
+
+	// Need a group commit that begins after this write was buffered.
+	uint64_t seq = ssd->commit_seq_started + 1;
+
+	while (ssd->commit_seq_done < seq) {
+		if (ssd->committing) {
+			pthread_cond_wait(&ssd->commit_cond, &ssd->commit_lock);
+			continue;
+		}
+
+		ssd->committing = true;
+
+		uint32_t window_us = as_load_uint32(&ssd->ns->storage_commit_window_us);
+
+		if (window_us != 0) {
+			pthread_mutex_unlock(&ssd->commit_lock);
+			usleep(window_us);
+			pthread_mutex_lock(&ssd->commit_lock);
+		}
+
+		// Close the group - later arrivals need the next one.
+		uint64_t group_seq = ++ssd->commit_seq_started;
+
+		pthread_mutex_unlock(&ssd->commit_lock);
+
+		ssd_commit_group(ssd);
+
+		pthread_mutex_lock(&ssd->commit_lock);
+
+		ssd->commit_seq_done = group_seq;
+		ssd->committing = false;
+
+		pthread_cond_broadcast(&ssd->commit_cond);
+	}
+
+	pthread_mutex_unlock(&ssd->commit_lock);
+}
+
+
 void
 ssd_flush_defrag_swb(drv_ssd *ssd, uint64_t *p_prev_n_defrag_writes)
 {
@@ -2010,6 +3462,9 @@ ssd_flush_defrag_swb(drv_ssd *ssd, uint64_t *p_prev_n_defrag_writes)
 	ssd_write_buf *swb = ssd->defrag_swb;
 
 	if (swb && swb->n_vacated != 0) {
+		cf_atomic64_incr(&ssd->n_partial_flushes);
+		cf_atomic64_add(&ssd->n_partial_flush_bytes, (int64_t)swb->pos);
+
 		// Flush it.
 		ssd_flush_swb(ssd, swb);
 
@@ -2083,9 +3538,10 @@ run_ssd_maintenance(void *udata)
 	uint64_t prev_n_defrag_writes = 0;
 	uint64_t prev_n_defrag_io_skips = 0;
 	uint64_t prev_n_direct_frees = 0;
+	uint64_t prev_n_partial_flushes = 0;
 	uint64_t prev_n_tomb_raider_reads = 0;
 
-	uint64_t prev_n_writes_flush[N_CURRENT_SWBS] = { 0 };
+	swb_flush_state flush_states[N_CURRENT_SWB_STREAMS] = { { 0 } };
 
 	uint64_t prev_n_defrag_writes_flush = 0;
 
@@ -2094,10 +3550,10 @@ run_ssd_maintenance(void *udata)
 
 	uint64_t prev_log_stats = now;
 	uint64_t prev_free_swbs = now;
-	uint64_t prev_flush[N_CURRENT_SWBS];
+	uint64_t prev_flush[N_CURRENT_SWB_STREAMS];
 	uint64_t prev_defrag_flush = now;
 
-	for (uint8_t c = 0; c < N_CURRENT_SWBS; c++) {
+	for (uint8_t c = 0; c < N_CURRENT_SWB_STREAMS; c++) {
 		prev_flush[c] = now;
 	}
 
@@ -2116,7 +3572,8 @@ run_ssd_maintenance(void *udata)
 		if (now >= prev_log_stats + LOG_STATS_INTERVAL) {
 			ssd_log_stats(ssd, &prev_n_total_writes, &prev_n_defrag_reads,
 					&prev_n_defrag_writes, &prev_n_defrag_io_skips,
-					&prev_n_direct_frees, &prev_n_tomb_raider_reads);
+					&prev_n_direct_frees, &prev_n_partial_flushes,
+					&prev_n_tomb_raider_reads);
 			prev_log_stats = now;
 			next = next_time(now, LOG_STATS_INTERVAL, next);
 		}
@@ -2129,9 +3586,9 @@ run_ssd_maintenance(void *udata)
 
 		uint64_t flush_max_us = ssd_flush_max_us(ns);
 
-		for (uint8_t c = 0; c < N_CURRENT_SWBS; c++) {
+		for (uint8_t c = 0; c < N_CURRENT_SWB_STREAMS; c++) {
 			if (flush_max_us != 0 && now >= prev_flush[c] + flush_max_us) {
-				ssd_flush_current_swb(ssd, c, &prev_n_writes_flush[c]);
+				ssd_flush_current_swb(ssd, c, &flush_states[c], now);
 				prev_flush[c] = now;
 				next = next_time(now, flush_max_us, next);
 			}
@@ -2358,6 +3815,13 @@ ssd_write_header(drv_ssd *ssd, uint8_t *header, uint8_t *from, size_t size)
 // Cold start utilities.
 //
 
+static void *run_cold_start_read(void *udata);
+static void cold_start_find_records(drv_ssd *ssd, cold_start_wblock *wb,
+		bool prefetch, uint32_t *p_n_unused_wblocks);
+static void *run_cold_start_parse(void *udata);
+static void ssd_cold_start_put_sindex(as_namespace *ns, as_index_ref *r_ref,
+		const uint8_t *p_read, const uint8_t *end, uint32_t n_bins);
+
 bool
 prefer_existing_record(const as_namespace* ns, const as_flat_record* flat,
 		uint32_t block_void_time, const as_index* r)
@@ -2466,12 +3930,18 @@ ssd_cold_start_add_record(drv_ssds* ssds, drv_ssd* ssd,
 		if (prefer_existing_record(ns, flat, opt_meta.void_time, r)) {
 			ssd_cold_start_adjust_cenotaph(ns, flat, opt_meta.void_time, r);
 			as_record_done(&r_ref, ns);
-			ssd->record_add_older_counter++;
+			as_incr_uint64(&ssd->record_add_older_counter);
 			return;
 		}
 	}
 	// The record we're now reading is the latest version (so far) ...
 
+	// Keep the cold start eviction histogram in step with the index.
+	bool hist_evictable = ns->cold_start_evict_hist != NULL &&
+			drv_is_set_evictable(ns, &opt_meta);
+	uint32_t hist_old_void_time = hist_evictable && ! is_create ?
+			r->void_time : 0;
+
 	// Skip records that have expired.
 	if (opt_meta.void_time != 0 && ns->cold_start_now > opt_meta.void_time) {
 		if (! is_create) {
@@ -2479,9 +3949,10 @@ ssd_cold_start_add_record(drv_ssds* ssds, drv_ssd* ssd,
 			as_set_index_delete_live(ns, p_partition->tree, r, r_ref.r_h);
 		}
 
+		as_cold_start_evict_hist_update(ns, hist_old_void_time, 0);
 		as_index_delete(p_partition->tree, &flat->keyd);
 		as_record_done(&r_ref, ns);
-		ssd->record_add_expired_counter++;
+		as_incr_uint64(&ssd->record_add_expired_counter);
 		return;
 	}
 
@@ -2493,9 +3964,10 @@ ssd_cold_start_add_record(drv_ssds* ssds, drv_ssd* ssd,
 			as_set_index_delete_live(ns, p_partition->tree, r, r_ref.r_h);
 		}
 
+		as_cold_start_evict_hist_update(ns, hist_old_void_time, 0);
 		as_index_delete(p_partition->tree, &flat->keyd);
 		as_record_done(&r_ref, ns);
-		ssd->record_add_evicted_counter++;
+		as_incr_uint64(&ssd->record_add_evicted_counter);
 		return;
 	}
 
@@ -2508,6 +3980,9 @@ ssd_cold_start_add_record(drv_ssds* ssds, drv_ssd* ssd,
 	r->generation = flat->generation;
 	r->void_time = opt_meta.void_time;
 
+	as_cold_start_evict_hist_update(ns, hist_old_void_time,
+			hist_evictable ? r->void_time : 0);
+
 	// Set/reset the records's XDR-write status.
 	ssd_cold_start_init_xdr_state(flat, r);
 
@@ -2564,7 +4039,7 @@ ssd_cold_start_add_record(drv_ssds* ssds, drv_ssd* ssd,
 						rd.n_bins);
 			}
 
-			as_bin_destroy_all(old_bins, n_old_bins);
+			as_bin_destroy_all_stored(r, old_bins, n_old_bins);
 			as_storage_rd_update_bin_space(&rd);
 		}
 
@@ -2572,155 +4047,405 @@ ssd_cold_start_add_record(drv_ssds* ssds, drv_ssd* ssd,
 		as_storage_record_close(&rd);
 	}
 	else {
+		// Pipelined sindex build - swap the previous version's entries (read
+		// back from its rblock) for this version's.
+		if (ns->sindexes_built_at_load) {
+			remove_from_sindex(ns, &r_ref); // no-op unless in sindex
+		}
+
 		drv_apply_opt_meta(r, ns, &opt_meta);
+
+		if (ns->sindexes_built_at_load && set_has_sindex(r, ns)) {
+			ssd_cold_start_put_sindex(ns, &r_ref, p_read, end, opt_meta.n_bins);
+		}
 	}
 
 	if (is_create) {
-		ssd->record_add_unique_counter++;
+		as_incr_uint64(&ssd->record_add_unique_counter);
 	}
 	else if (STORAGE_RBLOCK_IS_VALID(r->rblock_id)) {
 		// Replacing an existing record, undo its previous storage accounting.
 		ssd_block_free(&ssds->ssds[r->file_id], r->rblock_id, r->n_rblocks,
 				"record-add");
-		ssd->record_add_replace_counter++;
+		as_incr_uint64(&ssd->record_add_replace_counter);
 	}
 	else {
 		cf_warning(AS_DRV_SSD, "replacing record with invalid rblock-id");
 	}
 
-	ssd_cold_start_transition_record(ns, flat, &opt_meta, p_partition->tree,
-			&r_ref, is_create);
+	ssd_cold_start_transition_record(ns, flat, &opt_meta, p_partition->tree,
+			&r_ref, is_create);
+
+	uint32_t wblock_id = RBLOCK_ID_TO_WBLOCK_ID(ssd, rblock_id);
+
+	// Parser threads may share this device and wblock.
+	cf_atomic64_add(&ssd->inuse_size, (int64_t)record_size);
+	cf_atomic32_add(&ssd->wblock_state[wblock_id].inuse_sz,
+			(int32_t)record_size);
+
+	// Set/reset the record's storage information.
+	r->file_id = ssd->file_id;
+	r->rblock_id = rblock_id;
+
+	as_namespace_adjust_set_device_bytes(ns, as_index_get_set_id(r),
+			DELTA_N_RBLOCKS_TO_SIZE(flat->n_rblocks, r->n_rblocks));
+
+	r->n_rblocks = flat->n_rblocks;
+
+	as_record_done(&r_ref, ns);
+}
+
+
+// Bins point into the record just read - sindex entries copy what they need.
+static void
+ssd_cold_start_put_sindex(as_namespace *ns, as_index_ref *r_ref,
+		const uint8_t *p_read, const uint8_t *end, uint32_t n_bins)
+{
+	as_storage_rd rd;
+
+	as_storage_record_open(ns, r_ref->r, &rd);
+
+	as_bin bins[n_bins == 0 ? 1 : n_bins];
+
+	rd.n_bins = (uint16_t)n_bins;
+	rd.bins = bins;
+
+	if (as_flat_unpack_bins(ns, p_read, end, rd.n_bins, rd.bins) < 0) {
+		cf_warning(AS_DRV_SSD, "%pD - unpack bins for sindex failed",
+				&r_ref->r->keyd);
+	}
+	else {
+		as_sindex_put_all_rd(ns, &rd, r_ref);
+	}
+
+	as_storage_record_close(&rd);
+}
+
+
+// Sweep through a storage device to rebuild the index. Reader threads keep
+// wblocks read ahead, this thread finds the records in each wblock in order,
+// and parser threads add them to the index - each parser owns a disjoint set
+// of partitions.
+void
+ssd_cold_start_sweep(drv_ssds *ssds, drv_ssd *ssd)
+{
+	size_t wblock_size = ssd->write_block_size;
+
+	cold_start_sweep sweep = {
+			.ssds = ssds,
+			.ssd = ssd,
+			.read_shadow = ssd->shadow_name != NULL,
+			.n_parsers = ssds->ns->storage_cold_start_threads
+	};
+
+	sweep.n_wblocks = COLD_START_READ_AHEAD_SIZE / wblock_size;
+
+	if (sweep.n_wblocks < 2) {
+		sweep.n_wblocks = 2;
+	}
+
+	sweep.n_readers = sweep.n_wblocks / 2;
+
+	if (sweep.n_readers > COLD_START_MAX_READERS) {
+		sweep.n_readers = COLD_START_MAX_READERS;
+	}
+
+	sweep.n_wblocks -= sweep.n_wblocks % sweep.n_readers;
+	sweep.wblocks = cf_malloc(sweep.n_wblocks * sizeof(cold_start_wblock));
+	sweep.parsers = cf_malloc(sweep.n_parsers * sizeof(cold_start_parser));
+
+	for (uint32_t i = 0; i < sweep.n_readers; i++) {
+		cold_start_reader *reader = &sweep.readers[i];
+
+		reader->sweep = &sweep;
+		reader->ix = i;
+		reader->free_q = cf_queue_create(sizeof(cold_start_wblock*), true);
+		reader->full_q = cf_queue_create(sizeof(cold_start_wblock*), true);
+	}
+
+	for (uint32_t i = 0; i < sweep.n_wblocks; i++) {
+		cold_start_wblock *wb = &sweep.wblocks[i];
+
+		wb->reader = &sweep.readers[i % sweep.n_readers];
+		wb->buf = cf_valloc(wblock_size);
+		wb->n_spans = 0;
+		wb->capacity = 0;
+		wb->spans = NULL;
+
+		cf_queue_push(wb->reader->free_q, &wb);
+	}
+
+	for (uint32_t i = 0; i < sweep.n_parsers; i++) {
+		cold_start_parser *parser = &sweep.parsers[i];
+
+		parser->sweep = &sweep;
+		parser->ix = i;
+		parser->work_q = cf_queue_create(sizeof(cold_start_wblock*), true);
+		parser->tid = cf_thread_create_joinable(run_cold_start_parse,
+				(void*)parser);
+	}
+
+	for (uint32_t i = 0; i < sweep.n_readers; i++) {
+		cold_start_reader *reader = &sweep.readers[i];
+
+		reader->tid = cf_thread_create_joinable(run_cold_start_read,
+				(void*)reader);
+	}
+
+	// Loop over all wblocks, unless we encounter 10 contiguous unused wblocks.
+
+	ssd->sweep_wblock_id = ssd->first_wblock_id;
+
+	uint64_t file_offset = DRV_HEADER_SIZE;
+	uint32_t n_unused_wblocks = 0;
+	uint32_t n = 0;
+
+	bool prefetch = cf_arenax_want_prefetch(ssd->ns->arena);
+
+	while (file_offset < ssd->file_size &&
+			n_unused_wblocks < COLD_START_MAX_UNUSED_WBLOCKS) {
+		cold_start_reader *reader = &sweep.readers[n++ % sweep.n_readers];
+		cold_start_wblock *wb;
+
+		cf_queue_pop(reader->full_q, &wb, CF_QUEUE_FOREVER);
+
+		cf_assert(wb->file_offset == file_offset, AS_DRV_SSD,
+				"%s: cold start read out of order", ssd->name);
+
+		if (prefetch) {
+			ssd_prefetch_wblock(ssd, file_offset, wb->buf);
+		}
+
+		cold_start_find_records(ssd, wb, prefetch, &n_unused_wblocks);
+
+		if (wb->n_spans == 0) {
+			cf_queue_push(reader->free_q, &wb);
+		}
+		else {
+			as_store_uint32(&wb->n_pending, sweep.n_parsers);
+
+			for (uint32_t i = 0; i < sweep.n_parsers; i++) {
+				cf_queue_push(sweep.parsers[i].work_q, &wb);
+			}
+		}
+
+		file_offset += wblock_size;
+		ssd->sweep_wblock_id++;
+	}
+
+	as_store_uint32(&sweep.done, 1);
 
-	uint32_t wblock_id = RBLOCK_ID_TO_WBLOCK_ID(ssd, rblock_id);
+	// Parsers return all wblocks to the readers' free queues before they exit,
+	// so the readers can't stay blocked.
 
-	ssd->inuse_size += record_size;
-	ssd->wblock_state[wblock_id].inuse_sz += record_size;
+	for (uint32_t i = 0; i < sweep.n_parsers; i++) {
+		cold_start_parser *parser = &sweep.parsers[i];
+		cold_start_wblock *null_wb = NULL;
 
-	// Set/reset the record's storage information.
-	r->file_id = ssd->file_id;
-	r->rblock_id = rblock_id;
+		cf_queue_push(parser->work_q, &null_wb);
+		cf_thread_join(parser->tid);
+		cf_queue_destroy(parser->work_q);
+	}
 
-	as_namespace_adjust_set_device_bytes(ns, as_index_get_set_id(r),
-			DELTA_N_RBLOCKS_TO_SIZE(flat->n_rblocks, r->n_rblocks));
+	for (uint32_t i = 0; i < sweep.n_readers; i++) {
+		cold_start_reader *reader = &sweep.readers[i];
 
-	r->n_rblocks = flat->n_rblocks;
+		cf_thread_join(reader->tid);
+		cf_queue_destroy(reader->free_q);
+		cf_queue_destroy(reader->full_q);
+	}
 
-	as_record_done(&r_ref, ns);
+	for (uint32_t i = 0; i < sweep.n_wblocks; i++) {
+		cf_free(sweep.wblocks[i].buf);
+
+		if (sweep.wblocks[i].spans != NULL) {
+			cf_free(sweep.wblocks[i].spans);
+		}
+	}
+
+	cf_free(sweep.wblocks);
+	cf_free(sweep.parsers);
+
+	ssd->pristine_wblock_id = ssd->sweep_wblock_id - n_unused_wblocks;
+
+	ssd->sweep_wblock_id = (uint32_t)(ssd->file_size / wblock_size);
 }
 
 
-// Sweep through a storage device to rebuild the index.
-void
-ssd_cold_start_sweep(drv_ssds *ssds, drv_ssd *ssd)
+// Thread "run" function to read wblocks ahead of a cold start sweep - each
+// reader reads every n_readers'th wblock.
+static void *
+run_cold_start_read(void *udata)
 {
+	cold_start_reader *reader = (cold_start_reader*)udata;
+	cold_start_sweep *sweep = reader->sweep;
+	drv_ssd *ssd = sweep->ssd;
 	size_t wblock_size = ssd->write_block_size;
 
-	uint8_t *buf = cf_valloc(wblock_size);
-
-	bool read_shadow = ssd->shadow_name;
+	bool read_shadow = sweep->read_shadow;
 	const char *read_ssd_name = read_shadow ? ssd->shadow_name : ssd->name;
 	int fd = read_shadow ? ssd_shadow_fd_get(ssd) : ssd_fd_get(ssd);
 	int write_fd = read_shadow ? ssd_fd_get(ssd) : -1;
 
-	// Loop over all wblocks, unless we encounter 10 contiguous unused wblocks.
+	uint64_t stride = (uint64_t)sweep->n_readers * wblock_size;
 
-	ssd->sweep_wblock_id = ssd->first_wblock_id;
+	for (uint64_t file_offset = DRV_HEADER_SIZE + reader->ix * wblock_size;
+			file_offset < ssd->file_size; file_offset += stride) {
+		cold_start_wblock *wb;
 
-	uint64_t file_offset = DRV_HEADER_SIZE;
-	uint32_t n_unused_wblocks = 0;
+		cf_queue_pop(reader->free_q, &wb, CF_QUEUE_FOREVER);
 
-	bool prefetch = cf_arenax_want_prefetch(ssd->ns->arena);
+		if (as_load_uint32(&sweep->done) != 0) {
+			break;
+		}
 
-	while (file_offset < ssd->file_size && n_unused_wblocks < 10) {
-		if (! pread_all(fd, buf, wblock_size, (off_t)file_offset)) {
+		if (! pread_all(fd, wb->buf, wblock_size, (off_t)file_offset)) {
 			cf_crash(AS_DRV_SSD, "%s: read failed: errno %d (%s)",
 					read_ssd_name, errno, cf_strerror(errno));
 		}
 
-		if (read_shadow && ! pwrite_all(write_fd, (void*)buf, wblock_size,
+		if (read_shadow && ! pwrite_all(write_fd, (void*)wb->buf, wblock_size,
 				(off_t)file_offset)) {
 			cf_crash(AS_DRV_SSD, "%s: write failed: errno %d (%s)", ssd->name,
 					errno, cf_strerror(errno));
 		}
 
-		if (prefetch) {
-			ssd_prefetch_wblock(ssd, file_offset, buf);
-		}
+		wb->file_offset = file_offset;
 
-		size_t indent = 0; // current offset within wblock, in bytes
+		cf_queue_push(reader->full_q, &wb);
+	}
 
-		while (indent < wblock_size) {
-			as_flat_record *flat = (as_flat_record*)&buf[indent];
+	if (fd != -1) {
+		read_shadow ? ssd_shadow_fd_put(ssd, fd) : ssd_fd_put(ssd, fd);
+	}
 
-			if (! prefetch) {
-				ssd_decrypt(ssd, file_offset + indent, flat);
-			}
+	if (write_fd != -1) {
+		ssd_fd_put(ssd, write_fd);
+	}
 
-			// Look for record magic.
-			if (flat->magic != AS_FLAT_MAGIC) {
-				// Should always find a record at beginning of used wblock. if
-				// not, we've likely encountered the unused part of the device.
-				if (indent == 0) {
-					n_unused_wblocks++;
-					break; // try next wblock
-				}
-				// else - nothing more in this wblock, but keep looking for
-				// magic - necessary if we want to be able to increase
-				// write-block-size across restarts.
+	return NULL;
+}
 
-				indent += RBLOCK_SIZE;
-				continue; // try next rblock
-			}
 
-			if (n_unused_wblocks != 0) {
-				cf_warning(AS_DRV_SSD, "%s: found used wblock after skipping %u unused",
-						ssd->name, n_unused_wblocks);
+// Find the records in a wblock just read, for the parsers to add.
+static void
+cold_start_find_records(drv_ssd *ssd, cold_start_wblock *wb, bool prefetch,
+		uint32_t *p_n_unused_wblocks)
+{
+	size_t wblock_size = ssd->write_block_size;
+	uint8_t *buf = wb->buf;
 
-				n_unused_wblocks = 0; // restart contiguous count
-			}
+	wb->n_spans = 0;
 
-			uint32_t record_size = N_RBLOCKS_TO_SIZE(flat->n_rblocks);
+	size_t indent = 0; // current offset within wblock, in bytes
 
-			if (record_size < DRV_RECORD_MIN_SIZE) {
-				cf_warning(AS_DRV_SSD, "%s: record too small: size %u",
-						ssd->name, record_size);
-				indent += RBLOCK_SIZE;
-				continue; // try next rblock
-			}
+	while (indent < wblock_size) {
+		as_flat_record *flat = (as_flat_record*)&buf[indent];
 
-			size_t next_indent = indent + record_size;
+		if (! prefetch) {
+			ssd_decrypt(ssd, wb->file_offset + indent, flat);
+		}
 
-			// Sanity-check for wblock overruns.
-			if (next_indent > wblock_size) {
-				cf_warning(AS_DRV_SSD, "%s: record crosses wblock boundary: size %u",
-						ssd->name, record_size);
-				break; // skip this record, try next wblock
+		// Look for record magic.
+		if (flat->magic != AS_FLAT_MAGIC) {
+			// Should always find a record at beginning of used wblock. if
+			// not, we've likely encountered the unused part of the device.
+			if (indent == 0) {
+				(*p_n_unused_wblocks)++;
+				break; // try next wblock
 			}
+			// else - nothing more in this wblock, but keep looking for
+			// magic - necessary if we want to be able to increase
+			// write-block-size across restarts.
 
-			// Found a record - try to add it to the index.
-			ssd_cold_start_add_record(ssds, ssd, flat,
-					OFFSET_TO_RBLOCK_ID(file_offset + indent), record_size);
+			indent += RBLOCK_SIZE;
+			continue; // try next rblock
+		}
 
-			indent = next_indent;
+		if (*p_n_unused_wblocks != 0) {
+			cf_warning(AS_DRV_SSD, "%s: found used wblock after skipping %u unused",
+					ssd->name, *p_n_unused_wblocks);
+
+			*p_n_unused_wblocks = 0; // restart contiguous count
 		}
 
-		file_offset += wblock_size;
-		ssd->sweep_wblock_id++;
-	}
+		uint32_t record_size = N_RBLOCKS_TO_SIZE(flat->n_rblocks);
 
-	ssd->pristine_wblock_id = ssd->sweep_wblock_id - n_unused_wblocks;
+		if (record_size < DRV_RECORD_MIN_SIZE) {
+			cf_warning(AS_DRV_SSD, "%s: record too small: size %u",
+					ssd->name, record_size);
+			indent += RBLOCK_SIZE;
+			continue; // try next rblock
+		}
 
-	ssd->sweep_wblock_id = (uint32_t)(ssd->file_size / wblock_size);
+		size_t next_indent = indent + record_size;
 
-	if (fd != -1) {
-		read_shadow ? ssd_shadow_fd_put(ssd, fd) : ssd_fd_put(ssd, fd);
+		// Sanity-check for wblock overruns.
+		if (next_indent > wblock_size) {
+			cf_warning(AS_DRV_SSD, "%s: record crosses wblock boundary: size %u",
+					ssd->name, record_size);
+			break; // skip this record, try next wblock
+		}
+
+		// Found a record - a parser will try to add it to the index.
+		if (wb->n_spans == wb->capacity) {
+			wb->capacity = wb->capacity == 0 ? 256 : wb->capacity * 2;
+			wb->spans = cf_realloc(wb->spans,
+					wb->capacity * sizeof(cold_start_span));
+		}
+
+		cold_start_span *span = &wb->spans[wb->n_spans++];
+
+		span->indent = (uint32_t)indent;
+		span->size = record_size;
+		span->pid = as_partition_getid(&flat->keyd);
+
+		indent = next_indent;
 	}
+}
 
-	if (write_fd != -1) {
-		ssd_fd_put(ssd, write_fd);
+
+// Thread "run" function to add records found by a cold start sweep - each
+// parser adds records only for its own partitions, so parsers never contend
+// for a record.
+static void *
+run_cold_start_parse(void *udata)
+{
+	cold_start_parser *parser = (cold_start_parser*)udata;
+	cold_start_sweep *sweep = parser->sweep;
+	drv_ssds *ssds = sweep->ssds;
+	drv_ssd *ssd = sweep->ssd;
+
+	CF_ALLOC_SET_NS_ARENA_DIM(ssds->ns);
+
+	while (true) {
+		cold_start_wblock *wb;
+
+		cf_queue_pop(parser->work_q, &wb, CF_QUEUE_FOREVER);
+
+		if (wb == NULL) {
+			break;
+		}
+
+		for (uint32_t i = 0; i < wb->n_spans; i++) {
+			cold_start_span *span = &wb->spans[i];
+
+			if (span->pid % sweep->n_parsers != parser->ix) {
+				continue;
+			}
+
+			ssd_cold_start_add_record(ssds, ssd,
+					(as_flat_record*)&wb->buf[span->indent],
+					OFFSET_TO_RBLOCK_ID(wb->file_offset + span->indent),
+					span->size);
+		}
+
+		if (as_aaf_uint32(&wb->n_pending, -1) == 0) {
+			cf_queue_push(wb->reader->free_q, &wb);
+		}
 	}
 
-	cf_free(buf);
+	return NULL;
 }
 
 
@@ -2755,7 +4480,7 @@ run_ssd_cold_start(void *udata)
 		ns->loading_records = false;
 		ssd_cold_start_drop_cenotaphs(ns);
 
-		cf_mutex_destroy(&ns->cold_start_evict_lock);
+		as_cold_start_evict_done(ns);
 
 		as_truncate_list_cenotaphs(ns);
 		as_truncate_done_startup(ns); // set truncate last-update-times in sets' vmap
@@ -2806,12 +4531,101 @@ start_loading_records(drv_ssds *ssds, cf_queue *complete_q)
 //
 
 #define PROGRESS_RESOLUTION 1000
+#define N_SI_MARK_THREADS 16
+
+typedef struct si_mark_info_s {
+	drv_ssds* ssds;
+	uint32_t pid;
+} si_mark_info;
+
+typedef struct si_mark_cb_info_s {
+	drv_ssds* ssds;
+	uint32_t n_skipped;
+} si_mark_cb_info;
 
+static void si_startup_mark_wblocks(drv_ssds* ssds);
+static void* run_si_mark(void* udata);
+static bool si_mark_reduce_cb(as_index_ref* r_ref, void* udata);
 static void* run_si_startup(void* udata);
 static void si_startup_sweep(drv_ssds* ssds, drv_ssd* ssd);
 static void si_startup_do_record(drv_ssds* ssds, drv_ssd* ssd,
 		as_flat_record* flat, uint64_t rblock_id, uint32_t record_size);
 
+// Use the (already resumed or cold-started) index to find which wblocks hold
+// records in sets with sindexes, so the device sweep can skip the rest.
+static void
+si_startup_mark_wblocks(drv_ssds* ssds)
+{
+	for (int i = 0; i < ssds->n_ssds; i++) {
+		drv_ssd* ssd = &ssds->ssds[i];
+
+		ssd->si_wblock_marks = cf_calloc(ssd->n_wblocks, sizeof(uint8_t));
+	}
+
+	si_mark_info info = { .ssds = ssds };
+	cf_tid tids[N_SI_MARK_THREADS];
+
+	for (uint32_t i = 0; i < N_SI_MARK_THREADS; i++) {
+		tids[i] = cf_thread_create_joinable(run_si_mark, &info);
+	}
+
+	for (uint32_t i = 0; i < N_SI_MARK_THREADS; i++) {
+		cf_thread_join(tids[i]);
+	}
+}
+
+static void*
+run_si_mark(void* udata)
+{
+	si_mark_info* info = (si_mark_info*)udata;
+	drv_ssds* ssds = info->ssds;
+	as_namespace* ns = ssds->ns;
+
+	si_mark_cb_info cbi = { .ssds = ssds };
+
+	uint32_t pid;
+
+	while ((pid = as_faa_uint32(&info->pid, 1)) < AS_PARTITIONS) {
+		as_index_tree* tree = ns->partitions[pid].tree;
+
+		// Sweep ignores records in trees that we don't own.
+		if (tree == NULL || ! ssds->get_state_from_storage[pid]) {
+			continue;
+		}
+
+		as_index_reduce_live(tree, si_mark_reduce_cb, &cbi);
+	}
+
+	as_add_uint64(&ns->si_n_recs_checked, cbi.n_skipped);
+
+	return NULL;
+}
+
+static bool
+si_mark_reduce_cb(as_index_ref* r_ref, void* udata)
+{
+	si_mark_cb_info* cbi = (si_mark_cb_info*)udata;
+	drv_ssds* ssds = cbi->ssds;
+	as_namespace* ns = ssds->ns;
+	as_index* r = r_ref->r;
+
+	if (set_has_sindex(r, ns)) {
+		drv_ssd* ssd = &ssds->ssds[r->file_id];
+		uint32_t wblock_id = RBLOCK_ID_TO_WBLOCK_ID(ssd, r->rblock_id);
+
+		as_store_uint8(&ssd->si_wblock_marks[wblock_id], 1);
+	}
+	// Sweep won't count records that aren't in a sindex - count them here.
+	else if (++cbi->n_skipped == PROGRESS_RESOLUTION) {
+		as_add_uint64(&ns->si_n_recs_checked, PROGRESS_RESOLUTION);
+		cbi->n_skipped = 0;
+	}
+
+	as_record_done(r_ref, ns);
+
+	return true;
+}
+
 static void*
 run_si_startup(void* udata)
 {
@@ -2853,6 +4667,12 @@ si_startup_sweep(drv_ssds* ssds, drv_ssd* ssd)
 			continue;
 		}
 
+		// Don't read wblocks without records in sets with sindexes.
+		if (ssd->si_wblock_marks != NULL &&
+				ssd->si_wblock_marks[ssd->sweep_wblock_id] == 0) {
+			continue;
+		}
+
 		if (! pread_all(fd, buf, wblock_size, (off_t)file_offset)) {
 			cf_crash(AS_DRV_SSD, "%s: read failed: errno %d (%s)", ssd->name,
 					errno, cf_strerror(errno));
@@ -2985,7 +4805,11 @@ si_startup_do_record(drv_ssds* ssds, drv_ssd* ssd, as_flat_record* flat,
 		return;
 	}
 
-	if (++ssd->record_add_unique_counter == PROGRESS_RESOLUTION) {
+	bool set_has_si = set_has_sindex(r, ns);
+
+	// If wblocks were marked, records not in a sindex were already counted.
+	if ((set_has_si || ssd->si_wblock_marks == NULL) &&
+			++ssd->record_add_unique_counter == PROGRESS_RESOLUTION) {
 		as_add_uint64(&ns->si_n_recs_checked, PROGRESS_RESOLUTION);
 		ssd->record_add_unique_counter = 0;
 	}
@@ -3000,7 +4824,7 @@ si_startup_do_record(drv_ssds* ssds, drv_ssd* ssd, as_flat_record* flat,
 		return;
 	}
 
-	if (! set_has_sindex(r, ns)) {
+	if (! set_has_si) {
 		as_record_done(&r_ref, ns);
 		return; // not in a sindex
 	}
@@ -3059,6 +4883,23 @@ ssd_init_pristine_wblock_id(drv_ssd *ssd, uint64_t offset)
 }
 
 
+typedef struct header_read_job_s {
+	drv_ssd *ssd;
+	drv_header *header;
+} header_read_job;
+
+// Thread "run" function to read and validate a device's header.
+void*
+run_read_header(void *pv_data)
+{
+	header_read_job *job = (header_read_job*)pv_data;
+
+	job->header = ssd_read_header(job->ssd);
+
+	return NULL;
+}
+
+
 void
 ssd_init_synchronous(drv_ssds *ssds)
 {
@@ -3074,11 +4915,24 @@ ssd_init_synchronous(drv_ssds *ssds)
 	drv_header *headers[n_ssds];
 	int first_used = -1;
 
+	// Read the headers in parallel - each may wait on a slow device.
+	header_read_job jobs[n_ssds];
+	cf_tid tids[n_ssds];
+
+	for (int i = 0; i < n_ssds; i++) {
+		jobs[i].ssd = &ssds->ssds[i];
+		tids[i] = cf_thread_create_joinable(run_read_header, (void*)&jobs[i]);
+	}
+
+	for (int i = 0; i < n_ssds; i++) {
+		cf_thread_join(tids[i]);
+	}
+
 	// Check all the headers. Pick one as the representative.
 	for (int i = 0; i < n_ssds; i++) {
 		drv_ssd *ssd = &ssds->ssds[i];
 
-		headers[i] = ssd_read_header(ssd);
+		headers[i] = jobs[i].header;
 
 		if (! headers[i]) {
 			headers[i] = ssd_init_header(ns, ssd);
@@ -3216,6 +5070,11 @@ ssd_init_synchronous(drv_ssds *ssds)
 		return; // warm restart, or warm restart phase of cool restart, is done
 	}
 
+	// Cold start - sindexes (defined by now) are fed by the sweep itself, so
+	// data-not-in-memory namespaces don't need a second pass to populate them.
+	ns->sindexes_built_at_load = ! ns->storage_data_in_memory &&
+			as_sindex_n_sindexes(ns) != 0;
+
 	// Cold start - we can now create our partition trees.
 	for (uint32_t pid = 0; pid < AS_PARTITIONS; pid++) {
 		if (ssds->get_state_from_storage[pid]) {
@@ -3229,8 +5088,7 @@ ssd_init_synchronous(drv_ssds *ssds)
 	}
 
 	// Initialize the cold start expiration and eviction machinery.
-	cf_mutex_init(&ns->cold_start_evict_lock);
-	ns->cold_start_now = now;
+	as_cold_start_evict_init(ns, now);
 }
 
 
@@ -3452,6 +5310,10 @@ ssd_init_files(as_namespace *ns, drv_ssds **ssds_p)
 			cf_crash(AS_DRV_SSD, "unable to truncate file: errno %d", errno);
 		}
 
+		if (ns->storage_dax_map) {
+			ssd_dax_map(ssd, fd);
+		}
+
 		close(fd);
 
 		ns->drive_size += ssd->file_size; // increment total storage size
@@ -3561,6 +5423,56 @@ ssd_set_pristine_offset(drv_ssds *ssds)
 }
 
 
+// NUMA node of the device's PCIe root, if all its physical devices agree.
+static uint16_t
+ssd_numa_node(const drv_ssd *ssd)
+{
+	cf_storage_device_info *info = cf_storage_get_device_info(ssd->name);
+
+	if (info == NULL || info->n_phys == 0) {
+		cf_warning(AS_DRV_SSD, "%s: can't determine NUMA node", ssd->name);
+		return CF_TOPO_INVALID_INDEX;
+	}
+
+	uint16_t numa_node = info->phys[0].numa_node;
+
+	for (uint32_t i = 1; i < info->n_phys; i++) {
+		if (info->phys[i].numa_node != numa_node) {
+			cf_warning(AS_DRV_SSD, "%s: spans NUMA nodes", ssd->name);
+			return CF_TOPO_INVALID_INDEX;
+		}
+	}
+
+	if (numa_node != CF_TOPO_INVALID_INDEX) {
+		cf_info(AS_DRV_SSD, "%s: write buffers on NUMA node %hu", ssd->name,
+				numa_node);
+	}
+
+	return numa_node;
+}
+
+
+static bool
+ssd_pi_protected(const drv_ssd *ssd)
+{
+	cf_storage_device_info *info = cf_storage_get_device_info(ssd->name);
+
+	if (info == NULL || info->n_phys == 0) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < info->n_phys; i++) {
+		if (! info->phys[i].integrity) {
+			return false;
+		}
+	}
+
+	cf_info(AS_DRV_SSD, "%s: has end-to-end protection", ssd->name);
+
+	return true;
+}
+
+
 static void
 ssd_set_trusted(drv_ssds *ssds)
 {
@@ -3602,11 +5514,21 @@ as_storage_init_ssd(as_namespace *ns)
 
 	cf_mutex_init(&ssds->flush_lock);
 
+	if (ns->storage_read_cache_size != 0) {
+		ssds->read_cache = as_record_cache_create(ns->storage_read_cache_size);
+	}
+
 	// The queue limit is more efficient to work with.
 	ns->storage_max_write_q = (uint32_t)
 			(ssds->n_ssds * ns->storage_max_write_cache /
 					ns->storage_write_block_size);
 
+	// Rounded up - any non-zero lag allows at least a wblock.
+	ns->storage_shadow_max_lag_q = (uint32_t)
+			((ssds->n_ssds * ns->storage_shadow_max_lag +
+					ns->storage_write_block_size - 1) /
+							ns->storage_write_block_size);
+
 	// Minimize how often we recalculate this.
 	ns->defrag_lwm_size =
 			(ns->storage_write_block_size * ns->storage_defrag_lwm_pct) / 100;
@@ -3630,7 +5552,7 @@ as_storage_init_ssd(as_namespace *ns)
 		ssd->ns = ns;
 		ssd->file_id = i;
 
-		for (uint8_t c = 0; c < N_CURRENT_SWBS; c++) {
+		for (uint8_t c = 0; c < N_CURRENT_SWB_STREAMS; c++) {
 			cf_mutex_init(&ssd->current_swbs[c].lock);
 		}
 
@@ -3645,7 +5567,9 @@ as_storage_init_ssd(as_namespace *ns)
 		// Non-fresh devices will initialize this appropriately later.
 		ssd->pristine_wblock_id = first_wblock_id;
 
-		ssd_wblock_init(ssd);
+		ssd->swb_numa_node = ns->storage_numa_local_write_buffers ?
+				ssd_numa_node(ssd) : CF_TOPO_INVALID_INDEX;
+		ssd->pi_protected = ssd_pi_protected(ssd);
 
 		// Note: free_wblock_q, defrag_wblock_q created after loading devices.
 
@@ -3662,7 +5586,7 @@ as_storage_init_ssd(as_namespace *ns)
 			ssd->swb_shadow_q = cf_queue_create(sizeof(void*), true);
 		}
 
-		ssd->swb_free_q = cf_queue_create(sizeof(void*), true);
+		cf_ring_queue_init(&ssd->swb_free_q, sizeof(void*), SWB_FREE_Q_CAPACITY);
 
 		if (! ns->storage_data_in_memory) {
 			// TODO - hide the storage_commit_to_device usage.
@@ -3684,9 +5608,23 @@ as_storage_init_ssd(as_namespace *ns)
 			ssd->hist_shadow_write = histogram_create(histname, HIST_MILLISECONDS);
 		}
 
+		snprintf(histname, sizeof(histname), "{%s}-%s-wblock-fill", ns->name, ssd->name);
+		ssd->hist_wblock_fill = histogram_create(histname, HIST_SIZE);
+
+		snprintf(histname, sizeof(histname), "{%s}-%s-defrag-wblock-age", ns->name, ssd->name);
+		ssd->hist_defrag_wblock_age = histogram_create(histname, HIST_COUNT);
+
+		snprintf(histname, sizeof(histname), "{%s}-%s-defrag-wblock-live", ns->name, ssd->name);
+		ssd->hist_defrag_wblock_live = histogram_create(histname, HIST_SIZE);
+
+		pthread_mutex_init(&ssd->commit_lock, NULL);
+		pthread_cond_init(&ssd->commit_cond, NULL);
+
 		ssd_init_commit(ssd);
 	}
 
+	ssd_wblock_init(ssds);
+
 	// Will load headers and, if warm or cool restart, resume persisted index.
 	ssd_init_synchronous(ssds);
 }
@@ -3748,6 +5686,11 @@ as_storage_sindex_build_all_ssd(as_namespace* ns)
 {
 	drv_ssds* ssds = (drv_ssds*)ns->storage_private;
 
+	// With setless sindexes every record is in a sindex - nothing to skip.
+	if (ns->n_setless_sindexes == 0) {
+		si_startup_mark_wblocks(ssds);
+	}
+
 	cf_tid tids[ssds->n_ssds];
 
 	for (int i = 0; i < ssds->n_ssds; i++) {
@@ -3757,6 +5700,15 @@ as_storage_sindex_build_all_ssd(as_namespace* ns)
 	for (int i = 0; i < ssds->n_ssds; i++) {
 		cf_thread_join(tids[i]);
 	}
+
+	for (int i = 0; i < ssds->n_ssds; i++) {
+		drv_ssd* ssd = &ssds->ssds[i];
+
+		if (ssd->si_wblock_marks != NULL) {
+			cf_free(ssd->si_wblock_marks);
+			ssd->si_wblock_marks = NULL;
+		}
+	}
 }
 
 
@@ -3816,6 +5768,10 @@ as_storage_destroy_record_ssd(as_namespace *ns, as_record *r)
 		drv_ssds *ssds = (drv_ssds*)ns->storage_private;
 		drv_ssd *ssd = &ssds->ssds[r->file_id];
 
+		if (ssds->read_cache != NULL) {
+			as_record_cache_remove(ssds->read_cache, &r->keyd);
+		}
+
 		ssd_block_free(ssd, r->rblock_id, r->n_rblocks, "destroy");
 
 		as_namespace_adjust_set_device_bytes(ns, as_index_get_set_id(r),
@@ -3898,6 +5854,15 @@ as_storage_overloaded_ssd(const as_namespace *ns, uint32_t margin,
 		return true;
 	}
 
+	uint32_t lag_q = as_load_uint32(&ns->storage_shadow_max_lag_q);
+
+	if (lag_q != 0 && ns->n_shadow_wblocks_lagging > lag_q + margin) {
+		cf_atomic64_incr(&ns->n_shadow_lag_throttles);
+		cf_ticker_warning(AS_DRV_SSD, "{%s} %s fail: shadow lag too deep: exceeds max %u",
+				ns->name, tag, lag_q + margin);
+		return true;
+	}
+
 	return false;
 }
 
@@ -4096,13 +6061,18 @@ as_storage_device_stats_ssd(const struct as_namespace_s *ns, uint32_t device_ix,
 	stats->write_q_sz = cf_queue_sz(ssd->swb_write_q);
 	stats->n_writes = 0;
 
-	for (uint8_t c = 0; c < N_CURRENT_SWBS; c++) {
+	for (uint8_t c = 0; c < N_CURRENT_SWB_STREAMS; c++) {
 		stats->n_writes += ssd->current_swbs[c].n_wblocks_written;
 	}
 
-	stats->defrag_q_sz = cf_queue_sz(ssd->defrag_wblock_q);
+	stats->defrag_q_sz = defrag_q_size(ssd);
 	stats->n_defrag_reads = ssd->n_defrag_wblock_reads;
 	stats->n_defrag_writes = ssd->n_defrag_wblock_writes;
+	stats->n_defrag_bytes_moved = ssd->n_defrag_bytes_moved;
+	stats->n_defrag_bytes_reclaimed = ssd->n_defrag_bytes_reclaimed;
+
+	stats->n_partial_flushes = ssd->n_partial_flushes;
+	stats->n_partial_flush_bytes = ssd->n_partial_flush_bytes;
 
 	stats->shadow_write_q_sz = ssd->swb_shadow_q ?
 			cf_queue_sz(ssd->swb_shadow_q) : 0;
@@ -4127,10 +6097,30 @@ as_storage_ticker_stats_ssd(as_namespace *ns)
 		if (ssd->hist_shadow_write) {
 			histogram_dump(ssd->hist_shadow_write);
 		}
+
+		histogram_dump(ssd->hist_wblock_fill);
+		histogram_dump(ssd->hist_defrag_wblock_age);
+		histogram_dump(ssd->hist_defrag_wblock_live);
 	}
 }
 
 
+bool
+as_storage_read_cache_stats_ssd(const as_namespace *ns, uint64_t *n_bytes,
+		uint64_t *n_hits, uint64_t *n_misses)
+{
+	drv_ssds *ssds = (drv_ssds*)ns->storage_private;
+
+	if (ssds->read_cache == NULL) {
+		return false;
+	}
+
+	as_record_cache_stats(ssds->read_cache, n_bytes, n_hits, n_misses);
+
+	return true;
+}
+
+
 void
 as_storage_histogram_clear_ssd(as_namespace *ns)
 {
@@ -4146,6 +6136,10 @@ as_storage_histogram_clear_ssd(as_namespace *ns)
 		if (ssd->hist_shadow_write) {
 			histogram_clear(ssd->hist_shadow_write);
 		}
+
+		histogram_clear(ssd->hist_wblock_fill);
+		histogram_clear(ssd->hist_defrag_wblock_age);
+		histogram_clear(ssd->hist_defrag_wblock_live);
 	}
 }
 
@@ -4170,10 +6164,17 @@ as_storage_shutdown_ssd(as_namespace *ns)
 {
 	drv_ssds *ssds = (drv_ssds*)ns->storage_private;
 
+	// Nothing was written since the (cold start) scan - nothing to flush.
+	if (! ssds->write_threads_started) {
+		ssd_set_pristine_offset(ssds);
+		ssd_set_trusted(ssds);
+		return;
+	}
+
 	for (int i = 0; i < ssds->n_ssds; i++) {
 		drv_ssd *ssd = &ssds->ssds[i];
 
-		for (uint8_t c = 0; c < N_CURRENT_SWBS; c++) {
+		for (uint8_t c = 0; c < N_CURRENT_SWB_STREAMS; c++) {
 			current_swb* cur_swb = &ssd->current_swbs[c];
 
 			// Stop the maintenance thread from (also) flushing the swbs.
@@ -26,21 +26,149 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "citrusleaf/cf_atomic.h"
+
+#include "arenax.h"
+#include "cf_thread.h"
 #include "log.h"
 
 #include "base/datamodel.h"
 #include "base/index.h"
+#include "base/set_index.h"
 #include "storage/drv_common.h"
 #include "storage/flat.h"
 #include "storage/storage.h"
 #include "transaction/rw_utils.h"
 
 
+#define N_RESUME_THREADS 16
+
+typedef struct resume_info_s {
+	drv_ssds* ssds;
+	uint32_t next_pid;
+} resume_info;
+
+typedef struct resume_tree_info_s {
+	drv_ssds* ssds;
+	as_partition* p;
+	uint64_t n_elements;
+} resume_tree_info;
+
+static void* run_resume_trees(void* udata);
+static bool resume_reduce_cb(as_index_ref* r_ref, void* udata);
+
+// Only reached when the index was resumed from a snapshot - rebuild storage
+// accounting and stats from the index, instead of scanning devices.
 void
 ssd_resume_devices(drv_ssds* ssds)
 {
-	// Should not get here - for enterprise version only.
-	cf_crash(AS_DRV_SSD, "community edition called ssd_resume_devices()");
+	as_namespace* ns = ssds->ns;
+
+	cf_info(AS_DRV_SSD, "{%s} resuming devices from index", ns->name);
+
+	resume_info ri = {
+			.ssds = ssds,
+			.next_pid = 0
+	};
+
+	cf_tid tids[N_RESUME_THREADS];
+
+	for (uint32_t i = 0; i < N_RESUME_THREADS; i++) {
+		tids[i] = cf_thread_create_joinable(run_resume_trees, (void*)&ri);
+	}
+
+	for (uint32_t i = 0; i < N_RESUME_THREADS; i++) {
+		cf_thread_join(tids[i]);
+	}
+
+	for (int i = 0; i < ssds->n_ssds; i++) {
+		drv_ssd* ssd = &ssds->ssds[i];
+
+		cf_info(AS_DRV_SSD, "device %s: resumed %lu used bytes", ssd->name,
+				cf_atomic64_get(ssd->inuse_size));
+	}
+
+	cf_info(AS_DRV_SSD, "{%s} resumed %lu objects", ns->name, ns->n_objects);
+}
+
+static void*
+run_resume_trees(void* udata)
+{
+	resume_info* ri = (resume_info*)udata;
+	as_namespace* ns = ri->ssds->ns;
+	uint32_t pid;
+
+	while ((pid = as_faa_uint32(&ri->next_pid, 1)) < AS_PARTITIONS) {
+		as_partition* p = &ns->partitions[pid];
+
+		if (p->tree == NULL) {
+			continue;
+		}
+
+		// Tree-ids were just restored from the device headers.
+		p->tree->id = p->tree_id;
+
+		resume_tree_info rti = {
+				.ssds = ri->ssds,
+				.p = p,
+				.n_elements = 0
+		};
+
+		as_index_reduce(p->tree, resume_reduce_cb, (void*)&rti);
+
+		p->tree->n_elements = rti.n_elements;
+	}
+
+	return NULL;
+}
+
+static bool
+resume_reduce_cb(as_index_ref* r_ref, void* udata)
+{
+	resume_tree_info* rti = (resume_tree_info*)udata;
+	drv_ssds* ssds = rti->ssds;
+	as_namespace* ns = ssds->ns;
+	as_index_tree* tree = rti->p->tree;
+	as_record* r = r_ref->r;
+
+	// Nothing references the record, and sindexes are repopulated later.
+	r->rc = 0;
+	r->in_sindex = 0;
+
+	int8_t file_id = ssds->device_translation[r->file_id];
+
+	if (file_id < 0) {
+		cf_crash(AS_DRV_SSD, "{%s} resumed record %pD on missing device %u",
+				ns->name, &r->keyd, r->file_id);
+	}
+
+	r->file_id = (uint8_t)file_id;
+
+	drv_ssd* ssd = &ssds->ssds[file_id];
+	uint32_t size = N_RBLOCKS_TO_SIZE(r->n_rblocks);
+	uint32_t wblock_id = RBLOCK_ID_TO_WBLOCK_ID(ssd, r->rblock_id);
+
+	cf_assert(wblock_id < ssd->n_wblocks, AS_DRV_SSD,
+			"%s: resumed record %pD has bad rblock-id %lu", ssd->name,
+			&r->keyd, (uint64_t)r->rblock_id);
+
+	cf_atomic64_add(&ssd->inuse_size, (int64_t)size);
+	cf_atomic32_add(&ssd->wblock_state[wblock_id].inuse_sz, (int32_t)size);
+
+	uint16_t set_id = as_index_get_set_id(r);
+
+	cf_atomic64_incr(&ns->n_objects);
+	as_namespace_reserve_set_id(ns, set_id);
+	as_namespace_adjust_set_device_bytes(ns, set_id, (int64_t)size);
+	as_set_index_insert(ns, tree, set_id, r_ref->r_h);
+
+	cf_atomic32_setmax(&rti->p->max_void_time, (int32_t)r->void_time);
+
+	rti->n_elements++;
+
+	as_record_done(r_ref, ns);
+
+	return true;
 }
 
 void*
@@ -158,7 +286,14 @@ ssd_flush_max_us(const as_namespace *ns)
 int
 ssd_write_bins(as_storage_rd *rd)
 {
-	return ssd_buffer_bins(rd);
+	int rv = ssd_buffer_bins(rd);
+
+	// Buffered (possibly in place) - with commit-to-device, wait until durable.
+	if (rv >= 0 && rd->ns->storage_commit_to_device) {
+		ssd_group_commit(rd->ssd);
+	}
+
+	return rv;
 }
 
 void
@@ -124,6 +124,39 @@ as_flat_pack_record(const as_storage_rd* rd, uint32_t n_rblocks,
 	flatten_bins(rd, buf, NULL);
 }
 
+// Rewrites metadata in an existing flat record from the index, leaving bins
+// (possibly compressed) untouched. Fails if the layout would change, i.e. if a
+// void-time would be added or removed.
+bool
+as_flat_touch_record(const as_record* r, as_flat_record* flat)
+{
+	as_flat_extra_flags extra_flags = get_flat_extra_flags(r);
+
+	if ((r->void_time != 0) != (flat->has_void_time == 1) ||
+			flat_extra_flags_used(&extra_flags) !=
+					(flat->has_extra_flags == 1)) {
+		return false;
+	}
+
+	flat->last_update_time = r->last_update_time;
+	flat->generation = r->generation;
+
+	set_flat_xdr_state(r, flat);
+
+	uint8_t* at = flat->data;
+
+	if (flat->has_extra_flags == 1) {
+		*(as_flat_extra_flags*)at = extra_flags;
+		at += sizeof(as_flat_extra_flags);
+	}
+
+	if (flat->has_void_time == 1) {
+		*(uint32_t*)at = r->void_time;
+	}
+
+	return true;
+}
+
 bool
 as_flat_unpack_remote_record_meta(as_namespace* ns, as_remote_record* rr)
 {
@@ -405,6 +438,134 @@ as_flat_unpack_bins(as_namespace* ns, const uint8_t* at, const uint8_t* end,
 	return 0;
 }
 
+// Like as_flat_unpack_bins(), but skips past (without decoding) bins not named
+// in proj. Returns the number of bins unpacked, or a negative error. Not for
+// single-bin or data-in-memory namespaces.
+int
+as_flat_unpack_projected_bins(as_namespace* ns, const uint8_t* at,
+		const uint8_t* end, uint16_t n_bins, const as_flat_bin_proj* proj,
+		as_bin* bins)
+{
+	uint16_t n_unpacked = 0;
+	uint16_t i;
+
+	for (i = 0; i < n_bins && n_unpacked < proj->n_names; i++) {
+		if (at >= end) {
+			cf_warning(AS_FLAT, "incomplete flat bin");
+			break;
+		}
+
+		size_t name_len = *at++;
+
+		if (name_len >= AS_BIN_NAME_MAX_SZ) {
+			cf_warning(AS_FLAT, "bad flat bin name");
+			break;
+		}
+
+		if (at + name_len > end) {
+			cf_warning(AS_FLAT, "incomplete flat bin");
+			break;
+		}
+
+		const uint8_t* name = at;
+		bool wanted = false;
+
+		for (uint32_t n = 0; n < proj->n_names; n++) {
+			if (proj->name_lens[n] == name_len &&
+					memcmp(proj->names[n], name, name_len) == 0) {
+				wanted = true;
+				break;
+			}
+		}
+
+		at += name_len;
+
+		if (! wanted) {
+			if (at >= end) {
+				cf_warning(AS_FLAT, "incomplete flat bin");
+				break;
+			}
+
+			if ((*at & BIN_HAS_META) != 0) {
+				uint8_t flags = *at++;
+
+				if ((flags & BIN_HAS_LUT) != 0) {
+					at += sizeof(flat_bin_lut);
+				}
+
+				if ((at = skip_bin_src_id(flags, at, end)) == NULL) {
+					break;
+				}
+			}
+
+			if ((at = as_particle_skip_flat(at, end)) == NULL) {
+				break;
+			}
+
+			continue;
+		}
+
+		as_bin* b = &bins[n_unpacked];
+
+		if (! as_bin_set_id_from_name_w_len(ns, b, name, name_len)) {
+			cf_warning(AS_FLAT, "flat bin name failed to assign id");
+			break;
+		}
+
+		as_bin_clear_meta(b);
+
+		if (at >= end) {
+			cf_warning(AS_FLAT, "incomplete flat bin");
+			break;
+		}
+
+		if ((*at & BIN_HAS_META) != 0) {
+			uint8_t flags = *at++;
+
+			if ((flags & BIN_UNKNOWN_FLAGS) != 0) {
+				cf_warning(AS_FLAT, "unknown bin flags");
+				break;
+			}
+
+			unpack_bin_xdr_write(flags, b);
+
+			if ((flags & BIN_HAS_LUT) != 0) {
+				if (at + sizeof(flat_bin_lut) > end) {
+					cf_warning(AS_FLAT, "incomplete flat bin");
+					break;
+				}
+
+				b->lut = ((flat_bin_lut*)at)->lut;
+				at += sizeof(flat_bin_lut);
+			}
+
+			if ((at = unpack_bin_src_id(flags, at, end, b)) == NULL) {
+				break;
+			}
+		}
+
+		if ((at = as_bin_particle_cast_from_flat(b, at, end)) == NULL) {
+			break;
+		}
+
+		n_unpacked++;
+	}
+
+	// Stopping early without finding all wanted bins means we hit an error.
+	if (i < n_bins && n_unpacked < proj->n_names) {
+		as_bin_destroy_all_dim(ns, bins, n_unpacked);
+		return -AS_ERR_UNKNOWN;
+	}
+
+	if (at > end) {
+		cf_warning(AS_FLAT, "incomplete flat bin");
+		as_bin_destroy_all_dim(ns, bins, n_unpacked);
+		return -AS_ERR_UNKNOWN;
+	}
+
+	return (int)n_unpacked;
+}
+
 const uint8_t*
 as_flat_check_packed_bins(const uint8_t* at, const uint8_t* end,
 		uint32_t n_bins, bool single_bin)
@@ -0,0 +1,483 @@
+/*
+ * record_cache.c
+ *
+ * Copyright (C) 2020 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+/* SYNOPSIS
+ * Memory-bounded cache of (decrypted) flat records read from device, keyed by
+ * digest. Eviction is CLOCK, and admission is TinyLFU-style - a new record
+ * only displaces the CLOCK victim if it's been accessed more often recently,
+ * per a small count-min sketch. Both are per lock stripe. Writes replace the
+ * cached version of records already admitted, so hot records stay resident.
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "storage/record_cache.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_digest.h"
+
+#include "cf_mutex.h"
+#include "log.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define N_STRIPES 256 // stripe is selected by one digest byte
+
+#define SKETCH_DEPTH 4
+#define SKETCH_WIDTH 1024 // power of 2
+#define SKETCH_MAX 15
+#define SKETCH_AGING_PERIOD (SKETCH_WIDTH * 10)
+
+#define INITIAL_N_BUCKETS 64
+
+// Don't let one record take more than this fraction of a stripe.
+#define MAX_ENTRY_FRACTION 8
+
+typedef struct cache_entry_s {
+	struct cache_entry_s* next; // hash chain
+	struct cache_entry_s* clock_prev;
+	struct cache_entry_s* clock_next;
+	cf_digest keyd;
+	uint64_t rblock_id;
+	uint32_t size;
+	bool referenced;
+	uint8_t data[];
+} cache_entry;
+
+typedef struct cache_stripe_s {
+	cf_mutex lock;
+	cache_entry** buckets;
+	uint32_t n_buckets;
+	uint32_t n_entries;
+	uint64_t n_bytes;
+	cache_entry* hand;
+	uint32_t n_sketch_adds;
+	uint8_t sketch[SKETCH_DEPTH][SKETCH_WIDTH];
+} cache_stripe;
+
+struct as_record_cache_s {
+	uint64_t stripe_max_bytes;
+	uint64_t n_hits;
+	uint64_t n_misses;
+	cache_stripe stripes[N_STRIPES];
+};
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void sketch_increment(cache_stripe* stripe, const cf_digest* keyd);
+static uint32_t sketch_estimate(const cache_stripe* stripe, const cf_digest* keyd);
+static cache_entry** find_entry(cache_stripe* stripe, const cf_digest* keyd);
+static void remove_entry(cache_stripe* stripe, cache_entry** p_e);
+static cache_entry** find_victim(cache_stripe* stripe);
+static void insert_entry(cache_stripe* stripe, cache_entry* e);
+static bool make_room(as_record_cache* rc, cache_stripe* stripe, size_t sz, uint32_t freq);
+static void add_entry(cache_stripe* stripe, const cf_digest* keyd, uint64_t rblock_id, const uint8_t* buf, uint32_t size, bool referenced);
+static void grow_buckets(cache_stripe* stripe);
+
+
+//==========================================================
+// Inlines & macros.
+//
+
+static inline cache_stripe*
+get_stripe(as_record_cache* rc, const cf_digest* keyd)
+{
+	return &rc->stripes[keyd->digest[16]];
+}
+
+static inline uint32_t
+bucket_ix(const cache_stripe* stripe, const cf_digest* keyd)
+{
+	return *(uint32_t*)&keyd->digest[12] & (stripe->n_buckets - 1);
+}
+
+static inline uint32_t
+sketch_ix(const cf_digest* keyd, uint32_t row)
+{
+	return *(uint16_t*)&keyd->digest[2 + (row * 2)] & (SKETCH_WIDTH - 1);
+}
+
+static inline size_t
+entry_size(uint32_t size)
+{
+	return sizeof(cache_entry) + size;
+}
+
+
+//==========================================================
+// Public API.
+//
+
+as_record_cache*
+as_record_cache_create(uint64_t max_bytes)
+{
+	as_record_cache* rc = cf_calloc(1, sizeof(as_record_cache));
+
+	rc->stripe_max_bytes = max_bytes / N_STRIPES;
+
+	for (uint32_t i = 0; i < N_STRIPES; i++) {
+		cache_stripe* stripe = &rc->stripes[i];
+
+		cf_mutex_init(&stripe->lock);
+		stripe->n_buckets = INITIAL_N_BUCKETS;
+		stripe->buckets = cf_calloc(INITIAL_N_BUCKETS, sizeof(cache_entry*));
+	}
+
+	return rc;
+}
+
+// Returns an allocated copy of the cached record, or NULL if not cached. Entry
+// is only valid if the record hasn't moved, e.g. by defrag.
+uint8_t*
+as_record_cache_get(as_record_cache* rc, const cf_digest* keyd,
+		uint64_t rblock_id, uint32_t size)
+{
+	cache_stripe* stripe = get_stripe(rc, keyd);
+	uint8_t* buf = NULL;
+
+	cf_mutex_lock(&stripe->lock);
+
+	sketch_increment(stripe, keyd);
+
+	cache_entry** p_e = find_entry(stripe, keyd);
+
+	if (*p_e != NULL) {
+		cache_entry* e = *p_e;
+
+		if (e->rblock_id == rblock_id && e->size == size) {
+			e->referenced = true;
+			buf = cf_malloc(size);
+			memcpy(buf, e->data, size);
+		}
+		else {
+			remove_entry(stripe, p_e);
+		}
+	}
+
+	cf_mutex_unlock(&stripe->lock);
+
+	if (buf != NULL) {
+		as_incr_uint64(&rc->n_hits);
+	}
+	else {
+		as_incr_uint64(&rc->n_misses);
+	}
+
+	return buf;
+}
+
+void
+as_record_cache_put(as_record_cache* rc, const cf_digest* keyd,
+		uint64_t rblock_id, const uint8_t* buf, uint32_t size)
+{
+	size_t sz = entry_size(size);
+
+	if (sz > rc->stripe_max_bytes / MAX_ENTRY_FRACTION) {
+		return;
+	}
+
+	cache_stripe* stripe = get_stripe(rc, keyd);
+
+	cf_mutex_lock(&stripe->lock);
+
+	cache_entry** p_e = find_entry(stripe, keyd);
+
+	if (*p_e != NULL) {
+		remove_entry(stripe, p_e);
+	}
+
+	if (make_room(rc, stripe, sz, sketch_estimate(stripe, keyd))) {
+		add_entry(stripe, keyd, rblock_id, buf, size, false);
+	}
+	// else - not admitted.
+
+	cf_mutex_unlock(&stripe->lock);
+}
+
+// Replace a cached record with its newly written version. Records not already
+// cached are not admitted - reads decide what's hot. Caller holds the record
+// lock, so readers can't race to re-cache the old version.
+void
+as_record_cache_update(as_record_cache* rc, const cf_digest* keyd,
+		uint64_t rblock_id, const uint8_t* buf, uint32_t size)
+{
+	cache_stripe* stripe = get_stripe(rc, keyd);
+
+	cf_mutex_lock(&stripe->lock);
+
+	cache_entry** p_e = find_entry(stripe, keyd);
+
+	if (*p_e == NULL) {
+		cf_mutex_unlock(&stripe->lock);
+		return;
+	}
+
+	cache_entry* e = *p_e;
+
+	if (e->size == size) {
+		e->rblock_id = rblock_id;
+		e->referenced = true;
+		memcpy(e->data, buf, size);
+
+		cf_mutex_unlock(&stripe->lock);
+		return;
+	}
+
+	remove_entry(stripe, p_e);
+
+	size_t sz = entry_size(size);
+
+	// Already admitted - may displace any victim.
+	if (sz <= rc->stripe_max_bytes / MAX_ENTRY_FRACTION &&
+			make_room(rc, stripe, sz, SKETCH_MAX + 1)) {
+		add_entry(stripe, keyd, rblock_id, buf, size, true);
+	}
+
+	cf_mutex_unlock(&stripe->lock);
+}
+
+void
+as_record_cache_remove(as_record_cache* rc, const cf_digest* keyd)
+{
+	cache_stripe* stripe = get_stripe(rc, keyd);
+
+	cf_mutex_lock(&stripe->lock);
+
+	cache_entry** p_e = find_entry(stripe, keyd);
+
+	if (*p_e != NULL) {
+		remove_entry(stripe, p_e);
+	}
+
+	cf_mutex_unlock(&stripe->lock);
+}
+
+void
+as_record_cache_stats(as_record_cache* rc, uint64_t* n_bytes, uint64_t* n_hits,
+		uint64_t* n_misses)
+{
+	uint64_t total = 0;
+
+	for (uint32_t i = 0; i < N_STRIPES; i++) {
+		total += as_load_uint64(&rc->stripes[i].n_bytes);
+	}
+
+	*n_bytes = total;
+	*n_hits = as_load_uint64(&rc->n_hits);
+	*n_misses = as_load_uint64(&rc->n_misses);
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+sketch_increment(cache_stripe* stripe, const cf_digest* keyd)
+{
+	for (uint32_t row = 0; row < SKETCH_DEPTH; row++) {
+		uint8_t* counter = &stripe->sketch[row][sketch_ix(keyd, row)];
+
+		if (*counter < SKETCH_MAX) {
+			(*counter)++;
+		}
+	}
+
+	// Age all counters periodically, so the sketch tracks recent frequency.
+	if (++stripe->n_sketch_adds == SKETCH_AGING_PERIOD) {
+		for (uint32_t row = 0; row < SKETCH_DEPTH; row++) {
+			for (uint32_t i = 0; i < SKETCH_WIDTH; i++) {
+				stripe->sketch[row][i] >>= 1;
+			}
+		}
+
+		stripe->n_sketch_adds = 0;
+	}
+}
+
+static uint32_t
+sketch_estimate(const cache_stripe* stripe, const cf_digest* keyd)
+{
+	uint32_t min = SKETCH_MAX;
+
+	for (uint32_t row = 0; row < SKETCH_DEPTH; row++) {
+		uint32_t count = stripe->sketch[row][sketch_ix(keyd, row)];
+
+		if (count < min) {
+			min = count;
+		}
+	}
+
+	return min;
+}
+
+// Returns the link pointing at the entry - pointing at NULL if not found.
+static cache_entry**
+find_entry(cache_stripe* stripe, const cf_digest* keyd)
+{
+	cache_entry** p_e = &stripe->buckets[bucket_ix(stripe, keyd)];
+
+	while (*p_e != NULL && cf_digest_compare(&(*p_e)->keyd, keyd) != 0) {
+		p_e = &(*p_e)->next;
+	}
+
+	return p_e;
+}
+
+static void
+remove_entry(cache_stripe* stripe, cache_entry** p_e)
+{
+	cache_entry* e = *p_e;
+
+	*p_e = e->next;
+
+	if (e->clock_next == e) {
+		stripe->hand = NULL;
+	}
+	else {
+		e->clock_prev->clock_next = e->clock_next;
+		e->clock_next->clock_prev = e->clock_prev;
+
+		if (stripe->hand == e) {
+			stripe->hand = e->clock_next;
+		}
+	}
+
+	stripe->n_entries--;
+	as_store_uint64(&stripe->n_bytes, stripe->n_bytes - entry_size(e->size));
+
+	cf_free(e);
+}
+
+// Advance the CLOCK hand to the first unreferenced entry. Caller guarantees
+// the stripe isn't empty.
+static cache_entry**
+find_victim(cache_stripe* stripe)
+{
+	while (stripe->hand->referenced) {
+		stripe->hand->referenced = false;
+		stripe->hand = stripe->hand->clock_next;
+	}
+
+	return find_entry(stripe, &stripe->hand->keyd);
+}
+
+static void
+insert_entry(cache_stripe* stripe, cache_entry* e)
+{
+	if (stripe->n_entries == stripe->n_buckets) {
+		grow_buckets(stripe);
+	}
+
+	uint32_t ix = bucket_ix(stripe, &e->keyd);
+
+	e->next = stripe->buckets[ix];
+	stripe->buckets[ix] = e;
+
+	// Insert just behind the hand, so it's the last to be examined.
+	if (stripe->hand == NULL) {
+		e->clock_prev = e;
+		e->clock_next = e;
+		stripe->hand = e;
+	}
+	else {
+		e->clock_next = stripe->hand;
+		e->clock_prev = stripe->hand->clock_prev;
+		e->clock_prev->clock_next = e;
+		stripe->hand->clock_prev = e;
+	}
+
+	stripe->n_entries++;
+	as_store_uint64(&stripe->n_bytes, stripe->n_bytes + entry_size(e->size));
+}
+
+// Evict CLOCK victims until sz fits, unless a victim is at least as frequently
+// accessed as the candidate.
+static bool
+make_room(as_record_cache* rc, cache_stripe* stripe, size_t sz, uint32_t freq)
+{
+	while (stripe->n_bytes + sz > rc->stripe_max_bytes) {
+		cache_entry** p_victim = find_victim(stripe);
+
+		if (freq <= sketch_estimate(stripe, &(*p_victim)->keyd)) {
+			return false;
+		}
+
+		remove_entry(stripe, p_victim);
+	}
+
+	return true;
+}
+
+static void
+add_entry(cache_stripe* stripe, const cf_digest* keyd, uint64_t rblock_id,
+		const uint8_t* buf, uint32_t size, bool referenced)
+{
+	cache_entry* e = cf_malloc(entry_size(size));
+
+	e->keyd = *keyd;
+	e->rblock_id = rblock_id;
+	e->size = size;
+	e->referenced = referenced;
+	memcpy(e->data, buf, size);
+
+	insert_entry(stripe, e);
+}
+
+static void
+grow_buckets(cache_stripe* stripe)
+{
+	uint32_t old_n_buckets = stripe->n_buckets;
+	cache_entry** old_buckets = stripe->buckets;
+
+	stripe->n_buckets = old_n_buckets * 2;
+	stripe->buckets = cf_calloc(stripe->n_buckets, sizeof(cache_entry*));
+
+	for (uint32_t i = 0; i < old_n_buckets; i++) {
+		cache_entry* e = old_buckets[i];
+
+		while (e != NULL) {
+			cache_entry* next = e->next;
+			uint32_t ix = bucket_ix(stripe, &e->keyd);
+
+			e->next = stripe->buckets[ix];
+			stripe->buckets[ix] = e;
+			e = next;
+		}
+	}
+
+	cf_free(old_buckets);
+}
@@ -26,12 +26,15 @@
 
 #include "storage/storage.h"
 
+#include <errno.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/syscall.h>
 
+#include "aerospike/as_atomic.h"
 #include "citrusleaf/cf_digest.h"
 #include "citrusleaf/cf_queue.h"
 
@@ -46,12 +49,35 @@
 #include "sindex/sindex.h"
 
 
+//==========================================================
+// Typedefs & constants.
+//
+
+// From linux/ioprio.h, which older kernel headers lack.
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_PRIO_VALUE(_class, _level) \
+	(((_class) << IOPRIO_CLASS_SHIFT) | (_level))
+
+// Kernel priority for each class - foreground keeps the default (none, i.e.
+// derived from CPU nice), background classes take the lowest best-effort
+// levels, defrag just above others since it's needed to free space.
+static const int IO_CLASS_IOPRIO[AS_STORAGE_N_IO_CLASSES] = {
+		[AS_STORAGE_IO_FOREGROUND] = 0,
+		[AS_STORAGE_IO_BACKGROUND] = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 7),
+		[AS_STORAGE_IO_DEFRAG] = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 6)
+};
+
+
 //==========================================================
 // Globals.
 //
 
 uint64_t g_unique_data_size = 0;
 
+__thread as_storage_io_class g_storage_io_class = AS_STORAGE_IO_FOREGROUND;
+
 
 //==========================================================
 // Generic "base class" functions that call through
@@ -112,7 +138,7 @@ as_storage_init()
 
 typedef void (*as_storage_load_fn)(as_namespace *ns, cf_queue *complete_q);
 static const as_storage_load_fn as_storage_load_table[AS_NUM_STORAGE_ENGINES] = {
-	NULL, // memory has no load phase
+	as_storage_load_memory, // only reloads a memory snapshot, if configured
 	as_storage_load_pmem,
 	as_storage_load_ssd
 };
@@ -245,7 +271,7 @@ as_storage_start_tomb_raider()
 
 typedef void (*as_storage_shutdown_fn)(as_namespace *ns);
 static const as_storage_shutdown_fn as_storage_shutdown_table[AS_NUM_STORAGE_ENGINES] = {
-	NULL, // memory has no shutdown phase - unreachable
+	as_storage_shutdown_memory, // only with memory-snapshot-file
 	as_storage_shutdown_pmem,
 	as_storage_shutdown_ssd
 };
@@ -258,7 +284,8 @@ as_storage_shutdown(uint32_t instance)
 	for (uint32_t ns_ix = 0; ns_ix < g_config.n_namespaces; ns_ix++) {
 		as_namespace *ns = g_config.namespaces[ns_ix];
 
-		if (ns->storage_type == AS_STORAGE_ENGINE_MEMORY) {
+		if (ns->storage_type == AS_STORAGE_ENGINE_MEMORY &&
+				ns->memory_snapshot_file == NULL) {
 			cf_info(AS_STORAGE, "{%s} storage-engine memory - nothing to do",
 					ns->name);
 			continue;
@@ -333,6 +360,7 @@ as_storage_record_create(as_namespace *ns, as_record *r, as_storage_rd *rd)
 	rd->key = NULL;
 	rd->which_current_swb = SWB_MASTER;
 	rd->read_page_cache = false;
+	rd->bin_proj = NULL;
 	rd->resolve_writes = false;
 	rd->xdr_bin_writes = false;
 	rd->bin_luts = false;
@@ -372,6 +400,7 @@ as_storage_record_open(as_namespace *ns, as_record *r, as_storage_rd *rd)
 	rd->key = NULL;
 	rd->which_current_swb = SWB_MASTER;
 	rd->read_page_cache = false;
+	rd->bin_proj = NULL;
 	rd->resolve_writes = false;
 	rd->xdr_bin_writes = false;
 	rd->bin_luts = false;
@@ -481,6 +510,12 @@ static const as_storage_record_write_fn as_storage_record_write_table[AS_NUM_STO
 int
 as_storage_record_write(as_storage_rd *rd)
 {
+	// Cached si-query responses for this partition may now be stale.
+	if (rd->ns->query_result_cache_size != 0) {
+		as_incr_uint64(&rd->ns->si_query_cache_writes[
+				as_partition_getid(&rd->r->keyd)]);
+	}
+
 	if (as_storage_record_write_table[rd->ns->storage_type]) {
 		return as_storage_record_write_table[rd->ns->storage_type](rd);
 	}
@@ -509,6 +544,31 @@ as_storage_overloaded(const as_namespace *ns, uint32_t margin, const char* tag)
 	return false;
 }
 
+//--------------------------------------
+// as_storage_shed_low_priority
+//
+
+bool
+as_storage_shed_low_priority(const as_namespace *ns, const char* tag)
+{
+	uint32_t pct = ns->storage_shed_low_priority_pct;
+
+	// Only SSD namespaces report a write queue depth.
+	if (pct == 0 || ns->storage_type != AS_STORAGE_ENGINE_SSD) {
+		return false;
+	}
+
+	uint32_t limit = (uint32_t)(((uint64_t)ns->storage_max_write_q * pct) / 100);
+
+	if (ns->n_wblocks_to_flush > limit) {
+		cf_ticker_warning(AS_STORAGE, "{%s} %s shed: queue depth exceeds low priority max %u",
+				ns->name, tag, limit);
+		return true;
+	}
+
+	return false;
+}
+
 //--------------------------------------
 // as_storage_defrag_sweep
 //
@@ -799,6 +859,32 @@ as_storage_record_device_size(const as_namespace *ns, const as_record *r)
 	return 0;
 }
 
+//--------------------------------------
+// as_storage_read_prefetch
+//
+
+typedef void (*as_storage_read_prefetch_fn)(as_namespace *ns, const cf_digest *keyds, uint32_t n_keys);
+static const as_storage_read_prefetch_fn as_storage_read_prefetch_table[AS_NUM_STORAGE_ENGINES] = {
+	NULL, // memory doesn't need this
+	NULL, // pmem reads are cheap enough
+	as_storage_read_prefetch_ssd
+};
+
+void
+as_storage_read_prefetch(as_namespace *ns, const cf_digest *keyds,
+		uint32_t n_keys)
+{
+	if (as_storage_read_prefetch_table[ns->storage_type]) {
+		as_storage_read_prefetch_table[ns->storage_type](ns, keyds, n_keys);
+	}
+}
+
+void
+as_storage_read_prefetch_clear(void)
+{
+	as_storage_read_prefetch_clear_ssd();
+}
+
 
 //==========================================================
 // Generic functions that don't use "v-tables".
@@ -944,3 +1030,26 @@ as_storage_rd_load_pickle(as_storage_rd *rd)
 
 	return as_storage_record_load_pickle(rd);
 }
+
+// The class gates device reads (see background-read-depth) and also sets the
+// thread's kernel I/O priority, which the block layer's schedulers (and NVMe
+// devices with priority support) honor.
+as_storage_io_class
+as_storage_set_thread_io_class(as_storage_io_class io_class)
+{
+	as_storage_io_class prev = g_storage_io_class;
+
+	if (io_class == prev) {
+		return prev;
+	}
+
+	g_storage_io_class = io_class;
+
+	if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+			IO_CLASS_IOPRIO[io_class]) != 0) {
+		cf_detail(AS_STORAGE, "failed to set I/O priority: %s",
+				cf_strerror(errno));
+	}
+
+	return prev;
+}
@@ -77,6 +77,8 @@ dup_res_make_message(rw_request* rw, as_transaction* tr)
 	as_namespace* ns = tr->rsv.ns;
 	msg* m = rw->dest_msg;
 
+	cf_atomic32_incr(&tr->rsv.p->n_unmigrated_hits);
+
 	msg_set_uint32(m, RW_FIELD_OP, RW_OP_DUP);
 	msg_set_buf(m, RW_FIELD_NAMESPACE, (uint8_t*)ns->name, strlen(ns->name),
 			MSG_SET_COPY);
@@ -120,6 +122,7 @@ dup_res_setup_rw(rw_request* rw, as_transaction* tr, dup_res_done_cb dup_res_cb,
 	// Hereafter, rw must release the reservation - happens in destructor.
 
 	rw->end_time = tr->end_time;
+	rw->dispatch_time = tr->dispatch_time;
 	// Note - don't need as_transaction's other 'container' members.
 
 	rw->dup_res_cb = dup_res_cb;
@@ -467,6 +467,14 @@ proxyer_handle_client_response(msg* m, proxy_request* pr)
 		return AS_ERR_UNKNOWN;
 	}
 
+	// Tell the client it sent this to the wrong node, so it can refresh its
+	// partition map now rather than at its next poll.
+	cl_msg* msgp = (cl_msg*)proto;
+
+	if (proto_sz >= sizeof(cl_msg) && msgp->proto.type == PROTO_TYPE_AS_MSG) {
+		msgp->msg.info4 |= AS_MSG_INFO4_PARTITION_MAP_STALE;
+	}
+
 	as_file_handle* fd_h = pr->from.proto_fd_h;
 
 	if (cf_socket_send_all(&fd_h->sock, proto, proto_sz, MSG_NOSIGNAL,
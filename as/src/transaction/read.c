@@ -41,12 +41,17 @@
 #include "base/batch.h"
 #include "base/cfg.h"
 #include "base/datamodel.h"
+#include "base/hot_keys.h"
 #include "base/exp.h"
 #include "base/index.h"
+#include "base/probes.h"
 #include "base/proto.h"
+#include "base/set_hist.h"
+#include "base/slow_log.h"
 #include "base/transaction.h"
 #include "base/transaction_policy.h"
 #include "fabric/partition.h"
+#include "storage/flat.h"
 #include "storage/storage.h"
 #include "transaction/duplicate_resolve.h"
 #include "transaction/proxy.h"
@@ -71,6 +76,9 @@ void send_read_response(as_transaction* tr, as_msg_op** ops,
 void read_timeout_cb(rw_request* rw);
 
 transaction_status read_local(as_transaction* tr);
+bool read_local_optimistic(as_transaction* tr, transaction_status* status);
+bool read_bin_projection(as_msg* m, const uint8_t** names, uint8_t* name_lens,
+		as_flat_bin_proj* proj);
 void read_local_done(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 		int result_code);
 
@@ -387,6 +395,9 @@ send_read_response(as_transaction* tr, as_msg_op** ops, as_bin** response_bins,
 	// Note - if tr was setup from rw, rw->from.any has been set null and
 	// informs timeout it lost the race.
 
+	ASD_PROBE3(trans__response, as_probe_keyd(&tr->keyd), tr->result_code,
+			tr->origin);
+
 	switch (tr->origin) {
 	case FROM_CLIENT:
 		BENCHMARK_NEXT_DATA_POINT(tr, read, local);
@@ -402,6 +413,8 @@ send_read_response(as_transaction* tr, as_msg_op** ops, as_bin** response_bins,
 		}
 		BENCHMARK_NEXT_DATA_POINT(tr, read, response);
 		HIST_ACTIVATE_INSERT_DATA_POINT(tr, read_hist);
+		as_set_hist_insert(tr, AS_SET_HIST_READ);
+		as_slow_log_insert(tr, AS_SLOW_LOG_READ);
 		client_read_update_stats(tr->rsv.ns, tr->result_code);
 		break;
 	case FROM_PROXY:
@@ -425,8 +438,10 @@ send_read_response(as_transaction* tr, as_msg_op** ops, as_bin** response_bins,
 		break;
 	case FROM_BATCH:
 		BENCHMARK_NEXT_DATA_POINT(tr, batch_sub, read_local);
+		as_slow_log_insert(tr, AS_SLOW_LOG_BATCH_SUB); // before msgp is released
 		as_batch_add_result(tr, n_bins, response_bins, ops);
 		BENCHMARK_NEXT_DATA_POINT(tr, batch_sub, response);
+		as_set_hist_insert(tr, AS_SET_HIST_BATCH_SUB);
 		batch_sub_read_update_stats(tr->rsv.ns, tr->result_code);
 		break;
 	default:
@@ -485,6 +500,14 @@ read_local(as_transaction* tr)
 	as_msg* m = &tr->msgp->msg;
 	as_namespace* ns = tr->rsv.ns;
 
+	as_hot_keys_sample(ns, &tr->keyd, false);
+
+	transaction_status status;
+
+	if (ns->optimistic_reads && read_local_optimistic(tr, &status)) {
+		return status;
+	}
+
 	as_index_ref r_ref;
 
 	if (as_record_get(tr->rsv.tree, &tr->keyd, &r_ref) != 0) {
@@ -492,8 +515,14 @@ read_local(as_transaction* tr)
 		return TRANS_DONE_ERROR;
 	}
 
+	ASD_PROBE2(trans__record_locked, as_probe_keyd(&tr->keyd), ns->ix);
+
+	BENCHMARK_NEXT_DATA_POINT_FROM(tr, read, FROM_CLIENT, record_lock);
+
 	as_record* r = r_ref.r;
 
+	tr->set_id = as_index_get_set_id(r);
+
 	// Make sure the message set name (if it's there) is correct.
 	if (! set_name_check(tr, r)) {
 		read_local_done(tr, &r_ref, NULL, AS_ERR_PARAMETER);
@@ -570,7 +599,21 @@ read_local(as_transaction* tr)
 
 	as_bin stack_bins[ns->single_bin ? 1 : RECORD_MAX_BINS];
 
-	if ((result = as_storage_rd_load_bins(&rd, stack_bins)) < 0) {
+	const uint8_t* proj_names[m->n_ops];
+	uint8_t proj_name_lens[m->n_ops];
+	as_flat_bin_proj proj;
+
+	// Wide records - don't unpack bins the ops won't touch.
+	if (! ns->single_bin && ! ns->storage_data_in_memory &&
+			(m->info1 & AS_MSG_INFO1_GET_ALL) == 0 &&
+			read_bin_projection(m, proj_names, proj_name_lens, &proj)) {
+		rd.bin_proj = &proj;
+	}
+
+	result = as_storage_rd_load_bins(&rd, stack_bins);
+	rd.bin_proj = NULL;
+
+	if (result < 0) {
 		cf_warning(AS_RW, "{%s} read_local: failed as_storage_rd_load_bins() %pD", ns->name, &tr->keyd);
 		read_local_done(tr, &r_ref, &rd, -result);
 		return TRANS_DONE_ERROR;
@@ -610,6 +653,8 @@ read_local(as_transaction* tr)
 		as_msg_op* op = 0;
 		uint16_t n = 0;
 
+		as_bin_cdt_ctx_cache_reset();
+
 		while ((op = as_msg_op_iterate(m, op, &n)) != NULL) {
 			if (op->op == AS_MSG_OP_READ) {
 				as_bin* b = as_bin_get_live_w_len(&rd, op->name, op->name_sz);
@@ -775,6 +820,92 @@ read_local(as_transaction* tr)
 }
 
 
+// Collect the bins named by read ops, if every op reads only its named bin.
+bool
+read_bin_projection(as_msg* m, const uint8_t** names, uint8_t* name_lens,
+		as_flat_bin_proj* proj)
+{
+	if (m->n_ops == 0) {
+		return false;
+	}
+
+	as_msg_op* op = NULL;
+	uint16_t n = 0;
+	uint32_t n_names = 0;
+
+	while ((op = as_msg_op_iterate(m, op, &n)) != NULL) {
+		switch (op->op) {
+		case AS_MSG_OP_READ:
+		case AS_MSG_OP_BITS_READ:
+		case AS_MSG_OP_HLL_READ:
+		case AS_MSG_OP_CDT_READ:
+			names[n_names] = op->name;
+			name_lens[n_names] = op->name_sz;
+			n_names++;
+			break;
+		default:
+			return false; // e.g. expression reads may touch any bin
+		}
+	}
+
+	proj->n_names = n_names;
+	proj->names = names;
+	proj->name_lens = name_lens;
+
+	return true;
+}
+
+// Metadata-only reads that need nothing beyond the index element can answer
+// from a lockless snapshot of it. Returns false if caller must lock and read.
+bool
+read_local_optimistic(as_transaction* tr, transaction_status* status)
+{
+	as_msg* m = &tr->msgp->msg;
+	as_namespace* ns = tr->rsv.ns;
+
+	if ((m->info1 & AS_MSG_INFO1_GET_NO_BINS) == 0 || ns->cp ||
+			as_transaction_has_key(tr) || as_transaction_has_predexp(tr)) {
+		return false;
+	}
+
+	if (! (tr->origin == FROM_CLIENT || (tr->origin == FROM_BATCH &&
+			as_batch_get_predexp(tr->from.batch_shared) == NULL))) {
+		return false;
+	}
+
+	as_index snapshot;
+	int rv = as_index_get_optimistic(tr->rsv.tree, &tr->keyd, &snapshot);
+
+	if (rv == -2) {
+		return false;
+	}
+
+	as_record* r = &snapshot;
+
+	if (rv == -1 || as_record_is_doomed(r, ns) || ! as_record_is_live(r)) {
+		read_local_done(tr, NULL, NULL, AS_ERR_NOT_FOUND);
+		*status = TRANS_DONE_ERROR;
+		return true;
+	}
+
+	tr->set_id = as_index_get_set_id(r);
+
+	if (! set_name_check(tr, r)) {
+		read_local_done(tr, NULL, NULL, AS_ERR_PARAMETER);
+		*status = TRANS_DONE_ERROR;
+		return true;
+	}
+
+	tr->generation = r->generation;
+	tr->void_time = r->void_time;
+	tr->last_update_time = r->last_update_time;
+
+	read_local_done(tr, NULL, NULL, AS_OK);
+	*status = TRANS_DONE_SUCCESS;
+
+	return true;
+}
+
 void
 read_local_done(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 		int result_code)
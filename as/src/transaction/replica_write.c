@@ -43,6 +43,7 @@
 #include "base/datamodel.h"
 #include "base/health.h"
 #include "base/index.h"
+#include "base/probes.h"
 #include "base/proto.h"
 #include "base/set_index.h"
 #include "base/transaction.h"
@@ -134,6 +135,9 @@ repl_write_setup_rw(rw_request* rw, as_transaction* tr,
 	rw->generation = tr->generation;
 	rw->void_time = tr->void_time;
 	rw->last_update_time = tr->last_update_time;
+	rw->set_id = tr->set_id;
+	rw->dispatch_time = tr->dispatch_time;
+	rw->master_done_time = tr->master_done_time;
 
 	rw->repl_write_cb = repl_write_cb;
 	rw->timeout_cb = timeout_cb;
@@ -165,6 +169,9 @@ repl_write_reset_rw(rw_request* rw, as_transaction* tr, repl_write_done_cb cb)
 	rw->generation = tr->generation;
 	rw->void_time = tr->void_time;
 	rw->last_update_time = tr->last_update_time;
+	rw->set_id = tr->set_id;
+	rw->dispatch_time = tr->dispatch_time;
+	rw->master_done_time = tr->master_done_time;
 
 	rw->repl_write_cb = cb;
 
@@ -400,6 +407,8 @@ repl_write_handle_ack(cf_node node, msg* m)
 
 	rw->dest_complete[i] = true;
 
+	ASD_PROBE3(repl__ack, as_probe_keyd(keyd), node, result_code);
+
 	as_health_add_ns_latency(node, ns_ix, AS_HEALTH_NS_REPL_LAT,
 			rw->repl_start_us);
 
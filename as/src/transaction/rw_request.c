@@ -37,6 +37,7 @@
 #include "cf_mutex.h"
 #include "dynbuf.h"
 #include "log.h"
+#include "slab.h"
 
 #include "base/datamodel.h"
 #include "base/proto.h"
@@ -62,11 +63,21 @@ typedef struct rw_wait_ele_s {
 
 static cf_atomic32 g_rw_tid = 0;
 
+// Transactions waiting on an rw_request are copied into these.
+static cf_slab* g_wait_ele_slab;
+
 
 //==========================================================
 // Public API.
 //
 
+void
+rw_request_init(void)
+{
+	g_wait_ele_slab = cf_slab_create(sizeof(rw_wait_ele), "rw-wait-ele");
+}
+
+
 rw_request*
 rw_request_create(cf_digest* keyd)
 {
@@ -91,6 +102,9 @@ rw_request_create(cf_digest* keyd)
 	rw->generation			= 0;
 	rw->void_time			= 0;
 	rw->last_update_time	= 0;
+	rw->set_id				= INVALID_SET_ID;
+	rw->dispatch_time		= 0;
+	rw->master_done_time	= 0;
 	// End of as_transaction look-alike.
 
 	cf_mutex_init(&rw->lock);
@@ -187,7 +201,7 @@ rw_request_destroy(rw_request* rw)
 		tr->from_flags |= FROM_FLAG_RESTART;
 		as_service_enqueue_internal(tr);
 
-		cf_free(e);
+		cf_slab_free(g_wait_ele_slab, e);
 		e = next;
 	}
 }
@@ -196,7 +210,7 @@ rw_request_destroy(rw_request* rw)
 void
 rw_request_wait_q_push(rw_request* rw, as_transaction* tr)
 {
-	rw_wait_ele* e = cf_malloc(sizeof(rw_wait_ele));
+	rw_wait_ele* e = cf_slab_alloc(g_wait_ele_slab);
 
 	as_transaction_copy_head((as_transaction*)e->tr_head, tr);
 	tr->from.any = NULL;
@@ -220,8 +234,7 @@ rw_request_wait_q_push(rw_request* rw, as_transaction* tr)
 void
 rw_request_wait_q_push_head(rw_request* rw, as_transaction* tr)
 {
-	rw_wait_ele* e = cf_malloc(sizeof(rw_wait_ele));
-	cf_assert(e, AS_RW, "alloc rw_wait_ele");
+	rw_wait_ele* e = cf_slab_alloc(g_wait_ele_slab);
 
 	as_transaction_copy_head((as_transaction*)e->tr_head, tr);
 	tr->from.any = NULL;
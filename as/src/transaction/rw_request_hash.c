@@ -89,12 +89,17 @@ COMPILER_ASSERT(sizeof(rw_mt) / sizeof(msg_template) == NUM_RW_FIELDS);
 
 #define RETRANSMIT_PERIOD_US (5 * 1000) // 5 ms
 
+// Sharded so that inserts and deletes don't all contend on one hash's element
+// count, and so the retransmit thread only locks one shard's buckets at a time.
+#define N_RW_HASH_SHARDS 64
+#define N_RW_HASH_SHARD_BUCKETS (4 * 1024)
+
 
 //==========================================================
 // Globals.
 //
 
-static cf_rchash* g_rw_request_hash = NULL;
+static cf_rchash* g_rw_request_hashes[N_RW_HASH_SHARDS];
 
 
 //==========================================================
@@ -102,6 +107,7 @@ static cf_rchash* g_rw_request_hash = NULL;
 //
 
 uint32_t rw_request_hash_fn(const void* key);
+cf_rchash* rw_request_hash_shard(const rw_request_hkey* hkey);
 transaction_status handle_hot_key(rw_request* rw0, as_transaction* tr);
 
 void* run_retransmit(void* arg);
@@ -118,8 +124,13 @@ int rw_msg_cb(cf_node id, msg* m, void* udata);
 void
 as_rw_init()
 {
-	g_rw_request_hash = cf_rchash_create(rw_request_hash_fn,
-			rw_request_hdestroy, sizeof(rw_request_hkey), 32 * 1024);
+	rw_request_init();
+
+	for (uint32_t i = 0; i < N_RW_HASH_SHARDS; i++) {
+		g_rw_request_hashes[i] = cf_rchash_create(rw_request_hash_fn,
+				rw_request_hdestroy, sizeof(rw_request_hkey),
+				N_RW_HASH_SHARD_BUCKETS);
+	}
 
 	cf_thread_create_detached(run_retransmit, NULL);
 
@@ -131,7 +142,13 @@ as_rw_init()
 uint32_t
 rw_request_hash_count()
 {
-	return cf_rchash_get_size(g_rw_request_hash);
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < N_RW_HASH_SHARDS; i++) {
+		count += cf_rchash_get_size(g_rw_request_hashes[i]);
+	}
+
+	return count;
 }
 
 
@@ -139,12 +156,14 @@ transaction_status
 rw_request_hash_insert(rw_request_hkey* hkey, rw_request* rw,
 		as_transaction* tr)
 {
-	while (cf_rchash_put_unique(g_rw_request_hash, hkey, rw) != CF_RCHASH_OK) {
+	cf_rchash* h = rw_request_hash_shard(hkey);
+
+	while (cf_rchash_put_unique(h, hkey, rw) != CF_RCHASH_OK) {
 		// rw_request with this digest already in hash - get it.
 
 		rw_request* rw0;
 
-		if (cf_rchash_get(g_rw_request_hash, hkey, (void**)&rw0) !=
+		if (cf_rchash_get(h, hkey, (void**)&rw0) !=
 				CF_RCHASH_OK) {
 			// But now it's gone - try insertion again immediately.
 			continue;
@@ -168,7 +187,7 @@ rw_request_hash_insert(rw_request_hkey* hkey, rw_request* rw,
 void
 rw_request_hash_delete(rw_request_hkey* hkey, rw_request* rw)
 {
-	cf_rchash_delete_object(g_rw_request_hash, hkey, rw);
+	cf_rchash_delete_object(rw_request_hash_shard(hkey), hkey, rw);
 }
 
 
@@ -177,7 +196,7 @@ rw_request_hash_get(rw_request_hkey* hkey)
 {
 	rw_request* rw = NULL;
 
-	cf_rchash_get(g_rw_request_hash, hkey, (void**)&rw);
+	cf_rchash_get(rw_request_hash_shard(hkey), hkey, (void**)&rw);
 
 	return rw;
 }
@@ -205,6 +224,15 @@ rw_request_hash_fn(const void* key)
 }
 
 
+// Uses digest bits independent of those rw_request_hash_fn() uses.
+cf_rchash*
+rw_request_hash_shard(const rw_request_hkey* hkey)
+{
+	return g_rw_request_hashes[hkey->keyd.digest[DIGEST_RAND_BASE_BYTE] %
+			N_RW_HASH_SHARDS];
+}
+
+
 transaction_status
 handle_hot_key(rw_request* rw0, as_transaction* tr)
 {
@@ -250,8 +278,12 @@ run_retransmit(void* arg)
 		now.now_ns = cf_getns();
 		now.now_ms = now.now_ns / 1000000;
 
-		if (cf_rchash_get_size(g_rw_request_hash) != 0) {
-			cf_rchash_reduce(g_rw_request_hash, retransmit_reduce_fn, &now);
+		for (uint32_t i = 0; i < N_RW_HASH_SHARDS; i++) {
+			cf_rchash* h = g_rw_request_hashes[i];
+
+			if (cf_rchash_get_size(h) != 0) {
+				cf_rchash_reduce(h, retransmit_reduce_fn, &now);
+			}
 		}
 
 		uint64_t lap_us = (cf_getns() - now.now_ns) / 1000;
@@ -42,6 +42,7 @@
 #include "base/datamodel.h"
 #include "base/exp.h"
 #include "base/index.h"
+#include "base/probes.h"
 #include "base/proto.h"
 #include "base/transaction.h"
 #include "fabric/fabric.h"
@@ -87,6 +88,8 @@ send_rw_messages(rw_request* rw)
 
 		msg_incr_ref(rw->dest_msg);
 
+		ASD_PROBE2(repl__send, as_probe_keyd(&rw->keyd), rw->dest_nodes[i]);
+
 		if (as_fabric_send(rw->dest_nodes[i], rw->dest_msg,
 				AS_FABRIC_CHANNEL_RW) != AS_FABRIC_SUCCESS) {
 			as_fabric_msg_put(rw->dest_msg);
@@ -102,6 +105,8 @@ send_rw_messages_forget(rw_request* rw)
 	for (uint32_t i = 0; i < rw->n_dest_nodes; i++) {
 		msg_incr_ref(rw->dest_msg);
 
+		ASD_PROBE2(repl__send, as_probe_keyd(&rw->keyd), rw->dest_nodes[i]);
+
 		if (as_fabric_send(rw->dest_nodes[i], rw->dest_msg,
 				AS_FABRIC_CHANNEL_RW) != AS_FABRIC_SUCCESS) {
 			as_fabric_msg_put(rw->dest_msg);
@@ -708,3 +713,35 @@ write_dim_unwind(as_bin* old_bins, uint32_t n_old_bins, as_bin* new_bins,
 
 	// The index element's as_bin_space pointer still points at old bins.
 }
+
+
+// Like write_dim_unwind(), but old bins are found in the record's bin space,
+// which a failed write hasn't replaced - spares copying every old bin up front.
+void
+write_dim_unwind_stored(const as_record* r, as_bin* new_bins,
+		uint32_t n_new_bins, as_bin* cleanup_bins, uint32_t n_cleanup_bins)
+{
+	for (uint32_t i_new = 0; i_new < n_new_bins; i_new++) {
+		as_bin* b_new = &new_bins[i_new];
+
+		// Embedded particles have no-op destructors - skip search of old bins.
+		if (! as_bin_is_live(b_new) || as_bin_is_embedded_particle(b_new)) {
+			continue;
+		}
+
+		if (b_new->particle != as_bin_get_stored_particle(r, b_new->id)) {
+			as_bin_particle_destroy(b_new);
+		}
+	}
+
+	for (uint32_t i_cleanup = 0; i_cleanup < n_cleanup_bins; i_cleanup++) {
+		as_bin* b_cleanup = &cleanup_bins[i_cleanup];
+
+		if (b_cleanup->particle !=
+				as_bin_get_stored_particle(r, b_cleanup->id)) {
+			as_bin_particle_destroy(b_cleanup);
+		}
+	}
+
+	// The index element's as_bin_space pointer still points at old bins.
+}
@@ -54,8 +54,13 @@
 #include "base/cfg.h"
 #include "base/datamodel.h"
 #include "base/exp.h"
+#include "base/hot_keys.h"
 #include "base/index.h"
+#include "base/nsup.h"
+#include "base/probes.h"
 #include "base/proto.h"
+#include "base/set_hist.h"
+#include "base/slow_log.h"
 #include "base/transaction.h"
 #include "base/transaction_policy.h"
 #include "base/udf_aerospike.h"
@@ -371,6 +376,14 @@ as_udf_start(as_transaction* tr)
 		return TRANS_DONE_ERROR;
 	}
 
+	// Back off low priority work before foreground writes hit the limit.
+	if (is_low_priority(tr) &&
+			as_storage_shed_low_priority(tr->rsv.ns, "udf")) {
+		tr->result_code = AS_ERR_DEVICE_OVERLOAD;
+		send_udf_response(tr, NULL);
+		return TRANS_DONE_ERROR;
+	}
+
 	// Create rw_request and add to hash.
 	rw_request_hkey hkey = { tr->rsv.ns->ix, tr->keyd };
 	rw_request* rw = rw_request_create(&tr->keyd);
@@ -404,6 +417,7 @@ as_udf_start(as_transaction* tr)
 	// else - no duplicate resolution phase, apply operation to master.
 
 	status = udf_master(rw, tr);
+	as_slow_log_mark_master_done(tr);
 
 	BENCHMARK_NEXT_DATA_POINT_FROM(tr, udf, FROM_CLIENT, master);
 	BENCHMARK_NEXT_DATA_POINT_FROM(tr, batch_sub, FROM_BATCH, udf_master);
@@ -530,6 +544,7 @@ udf_dup_res_cb(rw_request* rw)
 	}
 
 	transaction_status status = udf_master(rw, &tr);
+	as_slow_log_mark_master_done(&tr);
 
 	BENCHMARK_NEXT_DATA_POINT_FROM((&tr), udf, FROM_CLIENT, master);
 	BENCHMARK_NEXT_DATA_POINT_FROM((&tr), batch_sub, FROM_BATCH, udf_master);
@@ -621,6 +636,9 @@ send_udf_response(as_transaction* tr, cf_dyn_buf* db)
 	// Note - if tr was setup from rw, rw->from.any has been set null and
 	// informs timeout it lost the race.
 
+	ASD_PROBE3(trans__response, as_probe_keyd(&tr->keyd), tr->result_code,
+			tr->origin);
+
 	clear_delete_response_metadata(tr);
 
 	switch (tr->origin) {
@@ -637,6 +655,8 @@ send_udf_response(as_transaction* tr, cf_dyn_buf* db)
 		}
 		BENCHMARK_NEXT_DATA_POINT(tr, udf, response);
 		HIST_ACTIVATE_INSERT_DATA_POINT(tr, udf_hist);
+		as_set_hist_insert(tr, AS_SET_HIST_UDF);
+		as_slow_log_insert(tr, AS_SLOW_LOG_UDF);
 		client_udf_update_stats(tr->rsv.ns, tr->result_code);
 		break;
 	case FROM_PROXY:
@@ -659,6 +679,7 @@ send_udf_response(as_transaction* tr, cf_dyn_buf* db)
 		}
 		break;
 	case FROM_BATCH:
+		as_slow_log_insert(tr, AS_SLOW_LOG_BATCH_SUB); // before msgp is released
 		if (db != NULL && db->used_sz != 0) {
 			as_batch_add_made_result(tr->from.batch_shared,
 					tr->from_data.batch_index, (cl_msg*)db->buf, db->used_sz);
@@ -667,6 +688,7 @@ send_udf_response(as_transaction* tr, cf_dyn_buf* db)
 			as_batch_add_ack(tr);
 		}
 		BENCHMARK_NEXT_DATA_POINT(tr, batch_sub, response);
+		as_set_hist_insert(tr, AS_SET_HIST_BATCH_SUB);
 		batch_sub_udf_update_stats(tr->rsv.ns, tr->result_code);
 		break;
 	case FROM_IUDF:
@@ -738,6 +760,8 @@ udf_master(rw_request* rw, as_transaction* tr)
 {
 	CF_ALLOC_SET_NS_ARENA_DIM(tr->rsv.ns);
 
+	as_hot_keys_sample(tr->rsv.ns, &tr->keyd, true);
+
 	udf_def def;
 	udf_call call = { .def = &def, .tr = tr };
 
@@ -794,6 +818,10 @@ udf_master_apply(udf_call* call, rw_request* rw)
 		return UDF_OPTYPE_WAITING;
 	}
 
+	if (get_rv == 0) {
+		tr->set_id = as_index_get_set_id(r);
+	}
+
 	// Internal UDFs must not create records.
 	if (tr->origin == FROM_IUDF && (get_rv != 0 || ! as_record_is_live(r))) {
 		if (get_rv == 0) {
@@ -1143,7 +1171,8 @@ udf_master_write(udf_record* urecord, rw_request* rw)
 		}
 		else {
 			udf_update_sindex(urecord);
-			as_bin_destroy_all(urecord->cleanup_bins, urecord->n_cleanup_bins);
+			as_bin_destroy_all_stored(r, urecord->cleanup_bins,
+					urecord->n_cleanup_bins);
 			as_storage_rd_update_bin_space(rd);
 		}
 
@@ -1156,6 +1185,7 @@ udf_master_write(udf_record* urecord, rw_request* rw)
 	tr->generation = r->generation;
 	tr->void_time = r->void_time;
 	tr->last_update_time = r->last_update_time;
+	tr->set_id = as_index_get_set_id(r);
 
 	// Handle deletion if appropriate.
 	if (is_delete) {
@@ -1165,6 +1195,8 @@ udf_master_write(udf_record* urecord, rw_request* rw)
 	// Or (normally) adjust max void-time.
 	else if (r->void_time != 0) {
 		cf_atomic32_setmax(&tr->rsv.p->max_void_time, (int32_t)r->void_time);
+		as_nsup_expire_index_add(ns, tr->rsv.p->id, urecord->r_ref->r_h,
+				r->void_time);
 	}
 
 	will_replicate(r, ns);
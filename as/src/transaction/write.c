@@ -45,9 +45,14 @@
 #include "base/datamodel.h"
 #include "base/exp.h"
 #include "base/expop.h"
+#include "base/hot_keys.h"
 #include "base/index.h"
+#include "base/nsup.h"
+#include "base/probes.h"
 #include "base/proto.h"
+#include "base/set_hist.h"
 #include "base/set_index.h"
+#include "base/slow_log.h"
 #include "base/transaction.h"
 #include "base/transaction_policy.h"
 #include "base/truncate.h"
@@ -55,6 +60,7 @@
 #include "fabric/fabric.h"
 #include "fabric/partition.h"
 #include "sindex/sindex.h"
+#include "storage/flat.h"
 #include "storage/storage.h"
 #include "transaction/duplicate_resolve.h"
 #include "transaction/proxy.h"
@@ -109,10 +115,13 @@ int write_master_ssd_single_bin(as_transaction* tr, as_index_ref* r_ref,
 int write_master_ssd(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 		bool must_fetch_data, bool record_level_replace, rw_request* rw,
 		bool* is_delete);
+bool write_master_ssd_touch(as_transaction* tr, as_storage_rd* rd,
+		rw_request* rw, int* result);
 
 int write_master_bin_ops(as_transaction* tr, as_storage_rd* rd,
 		cf_ll_buf* particles_llb, as_bin* cleanup_bins,
 		uint32_t* p_n_cleanup_bins, cf_dyn_buf* db);
+int write_master_raw_flat_bins(as_transaction* tr, as_storage_rd* rd);
 int write_master_bin_ops_loop(as_transaction* tr, as_storage_rd* rd,
 		as_msg_op** ops, as_bin* response_bins, uint32_t* p_n_response_bins,
 		as_bin* result_bins, uint32_t* p_n_result_bins,
@@ -268,6 +277,14 @@ as_write_start(as_transaction* tr)
 		return TRANS_DONE_ERROR;
 	}
 
+	// Back off low priority work before foreground writes hit the limit.
+	if (is_low_priority(tr) &&
+			as_storage_shed_low_priority(tr->rsv.ns, "write")) {
+		tr->result_code = AS_ERR_DEVICE_OVERLOAD;
+		send_write_response(tr, NULL);
+		return TRANS_DONE_ERROR;
+	}
+
 	// Create rw_request and add to hash.
 	rw_request_hkey hkey = { tr->rsv.ns->ix, tr->keyd };
 	rw_request* rw = rw_request_create(&tr->keyd);
@@ -301,6 +318,7 @@ as_write_start(as_transaction* tr)
 	// else - no duplicate resolution phase, apply operation to master.
 
 	status = write_master(rw, tr);
+	as_slow_log_mark_master_done(tr);
 
 	BENCHMARK_NEXT_DATA_POINT_FROM(tr, write, FROM_CLIENT, master);
 	BENCHMARK_NEXT_DATA_POINT_FROM(tr, batch_sub, FROM_BATCH, write_master);
@@ -402,6 +420,7 @@ write_dup_res_cb(rw_request* rw)
 	}
 
 	transaction_status status = write_master(rw, &tr);
+	as_slow_log_mark_master_done(&tr);
 
 	BENCHMARK_NEXT_DATA_POINT_FROM((&tr), write, FROM_CLIENT, master);
 	BENCHMARK_NEXT_DATA_POINT_FROM((&tr), batch_sub, FROM_BATCH, write_master);
@@ -496,6 +515,9 @@ send_write_response(as_transaction* tr, cf_dyn_buf* db)
 	// Note - if tr was setup from rw, rw->from.any has been set null and
 	// informs timeout it lost the race.
 
+	ASD_PROBE3(trans__response, as_probe_keyd(&tr->keyd), tr->result_code,
+			tr->origin);
+
 	clear_delete_response_metadata(tr);
 
 	switch (tr->origin) {
@@ -512,6 +534,8 @@ send_write_response(as_transaction* tr, cf_dyn_buf* db)
 		}
 		BENCHMARK_NEXT_DATA_POINT(tr, write, response);
 		HIST_ACTIVATE_INSERT_DATA_POINT(tr, write_hist);
+		as_set_hist_insert(tr, AS_SET_HIST_WRITE);
+		as_slow_log_insert(tr, AS_SLOW_LOG_WRITE);
 		client_write_update_stats(tr->rsv.ns, tr->result_code,
 				as_transaction_is_xdr(tr));
 		break;
@@ -537,6 +561,7 @@ send_write_response(as_transaction* tr, cf_dyn_buf* db)
 		}
 		break;
 	case FROM_BATCH:
+		as_slow_log_insert(tr, AS_SLOW_LOG_BATCH_SUB); // before msgp is released
 		if (db && db->used_sz != 0) {
 			as_batch_add_made_result(tr->from.batch_shared,
 					tr->from_data.batch_index, (cl_msg*)db->buf, db->used_sz);
@@ -545,6 +570,7 @@ send_write_response(as_transaction* tr, cf_dyn_buf* db)
 			as_batch_add_ack(tr);
 		}
 		BENCHMARK_NEXT_DATA_POINT(tr, batch_sub, response);
+		as_set_hist_insert(tr, AS_SET_HIST_BATCH_SUB);
 		batch_sub_write_update_stats(tr->rsv.ns, tr->result_code);
 		break;
 	case FROM_IOPS:
@@ -616,6 +642,8 @@ write_master(rw_request* rw, as_transaction* tr)
 {
 	CF_ALLOC_SET_NS_ARENA_DIM(tr->rsv.ns);
 
+	as_hot_keys_sample(tr->rsv.ns, &tr->keyd, true);
+
 	//------------------------------------------------------
 	// Perform checks that don't need to loop over ops, or
 	// create or find (and lock) the as_index.
@@ -708,6 +736,10 @@ write_master(rw_request* rw, as_transaction* tr)
 		}
 	}
 
+	ASD_PROBE2(trans__record_locked, as_probe_keyd(&tr->keyd), ns->ix);
+
+	BENCHMARK_NEXT_DATA_POINT_FROM(tr, write, FROM_CLIENT, record_lock);
+
 	// Enforce record-level create-only existence policy.
 	if ((m->info2 & AS_MSG_INFO2_CREATE_ONLY) != 0 &&
 			! record_created && as_record_is_live(r)) {
@@ -879,6 +911,7 @@ write_master(rw_request* rw, as_transaction* tr)
 	tr->generation = r->generation;
 	tr->void_time = r->void_time;
 	tr->last_update_time = r->last_update_time;
+	tr->set_id = as_index_get_set_id(r);
 
 	// Handle deletion if appropriate.
 	if (is_delete) {
@@ -889,6 +922,7 @@ write_master(rw_request* rw, as_transaction* tr)
 	// Or (normally) adjust max void-time.
 	else if (r->void_time != 0) {
 		cf_atomic32_setmax(&tr->rsv.p->max_void_time, (int32_t)r->void_time);
+		as_nsup_expire_index_add(ns, tr->rsv.p->id, r_ref.r_h, r->void_time);
 	}
 
 	will_replicate(r, ns);
@@ -917,6 +951,8 @@ write_master_failed(as_transaction* tr, as_index_ref* r_ref,
 	as_namespace* ns = tr->rsv.ns;
 
 	if (r_ref) {
+		tr->set_id = as_index_get_set_id(r_ref->r);
+
 		if (rd) {
 			as_storage_record_close(rd);
 		}
@@ -1025,6 +1061,18 @@ write_master_policies(as_transaction* tr, bool* p_must_not_create,
 		return AS_ERR_PARAMETER;
 	}
 
+	if (as_transaction_has_raw_flat(tr)) {
+		if (ns->storage_data_in_memory || ns->single_bin) {
+			cf_warning(AS_RW, "{%s} write_master: raw flat write not supported in data-in-memory or single-bin namespace %pD", ns->name, &tr->keyd);
+			return AS_ERR_UNSUPPORTED_FEATURE;
+		}
+
+		if (m->n_ops != 1 || ! record_level_replace) {
+			cf_warning(AS_RW, "{%s} write_master: raw flat write must be a single op with record-level replace %pD", ns->name, &tr->keyd);
+			return AS_ERR_PARAMETER;
+		}
+	}
+
 	bool single_bin_write_first = false;
 	bool has_read_op = false;
 	bool has_read_all_op = false;
@@ -1353,31 +1401,25 @@ write_master_dim(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 	as_namespace* ns = tr->rsv.ns;
 	as_record* r = rd->r;
 
-	as_bin old_bins[RECORD_MAX_BINS];
-
-	as_storage_rd_load_bins(rd, old_bins);
-
 	// For memory accounting, note current usage.
 	uint32_t memory_bytes = as_storage_record_mem_size(ns, r);
 
 	//------------------------------------------------------
-	// Copy existing bins to new space, and keep old bins
-	// intact for sindex adjustment and so it's possible to
+	// Copy existing bins to new space - the only copy. The
+	// stored bins stay intact until the bin space is
+	// replaced, so they serve for sindex adjustment and to
 	// unwind on failure.
 	//
 
-	uint32_t n_old_bins = rd->n_bins;
+	as_bin stack_bins[RECORD_MAX_BINS + m->n_ops]; // can't be more than this
 
-	as_bin stack_bins[n_old_bins + m->n_ops]; // can't be more than this
+	as_storage_rd_load_bins(rd, stack_bins);
+
+	uint32_t n_old_bins = rd->n_bins;
 
 	if (record_level_replace) {
 		rd->n_bins = 0;
 	}
-	else if (n_old_bins != 0) {
-		memcpy(stack_bins, old_bins, n_old_bins * sizeof(as_bin));
-	}
-
-	rd->bins = stack_bins;
 
 	// Collect bins (old or intermediate versions) to destroy on cleanup.
 	// Note - one delete-all op may destroy many bins. Size is max possible + 1.
@@ -1407,7 +1449,7 @@ write_master_dim(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 
 	if (result != 0) {
 		unwind_index_metadata(&old_metadata, r);
-		write_dim_unwind(old_bins, n_old_bins, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
+		write_dim_unwind_stored(r, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
 		return result;
 	}
 
@@ -1423,13 +1465,13 @@ write_master_dim(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 				(n_old_bins == 0 || ! as_record_is_live(r))) {
 			// Didn't exist or was bin cemetery (tombstone bit not yet updated).
 			unwind_index_metadata(&old_metadata, r);
-			write_dim_unwind(old_bins, n_old_bins, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
+			write_dim_unwind_stored(r, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
 			return AS_ERR_NOT_FOUND;
 		}
 
 		if ((result = validate_delete_durability(tr)) != AS_OK) {
 			unwind_index_metadata(&old_metadata, r);
-			write_dim_unwind(old_bins, n_old_bins, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
+			write_dim_unwind_stored(r, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
 			return result;
 		}
 	}
@@ -1444,7 +1486,7 @@ write_master_dim(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 	if ((result = as_storage_record_write(rd)) < 0) {
 		cf_detail(AS_RW, "{%s} write_master: failed as_storage_record_write() %pD", ns->name, &tr->keyd);
 		unwind_index_metadata(&old_metadata, r);
-		write_dim_unwind(old_bins, n_old_bins, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
+		write_dim_unwind_stored(r, rd->bins, rd->n_bins, cleanup_bins, n_cleanup_bins);
 		return -result;
 	}
 
@@ -1457,7 +1499,16 @@ write_master_dim(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 	// Success - adjust sindex, looking at old and new bins.
 	//
 
-	if (set_has_sindex(r, ns)) {
+	bool has_sindex = set_has_sindex(r, ns);
+
+	// Old bins are only copied out of the bin space if needed.
+	as_bin old_bins[n_old_bins];
+
+	if (has_sindex || record_level_replace) {
+		as_bin_load_stored(r, old_bins);
+	}
+
+	if (has_sindex) {
 		update_sindex(ns, r_ref, old_bins, n_old_bins, rd->bins, rd->n_bins);
 	}
 	else {
@@ -1470,10 +1521,10 @@ write_master_dim(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 	//
 
 	if (record_level_replace) {
-		as_bin_destroy_all(old_bins, n_old_bins);
+		as_bin_destroy_all_stored(r, old_bins, n_old_bins);
 	}
 
-	as_bin_destroy_all(cleanup_bins, n_cleanup_bins);
+	as_bin_destroy_all_stored(r, cleanup_bins, n_cleanup_bins);
 
 	//------------------------------------------------------
 	// Final changes to record data in as_index.
@@ -1605,12 +1656,19 @@ write_master_ssd(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 	bool set_has_si = set_has_sindex(r, ns);
 	bool si_needs_bins = set_has_si && r->in_sindex == 1;
 
+	int result;
+
+	// Touch-only - rewrite the stored record with new metadata, skipping bins.
+	if (write_master_ssd_touch(tr, rd, rw, &result)) {
+		return result;
+	}
+
 	// For sindex, we must read existing record even if replacing.
 	rd->ignore_record_on_device = ! must_fetch_data && ! si_needs_bins;
 
 	as_bin stack_bins[RECORD_MAX_BINS + m->n_ops];
 
-	int result = as_storage_rd_load_bins(rd, stack_bins);
+	result = as_storage_rd_load_bins(rd, stack_bins);
 
 	if (result < 0) {
 		cf_warning(AS_RW, "{%s} write_master: failed as_storage_rd_load_bins() %pD", ns->name, &tr->keyd);
@@ -1657,8 +1715,15 @@ write_master_ssd(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 
 	cf_ll_buf_define(particles_llb, STACK_PARTICLES_SIZE);
 
-	if ((result = write_master_bin_ops(tr, rd, &particles_llb, NULL, NULL,
-			&rw->response_db)) != 0) {
+	if (as_transaction_has_raw_flat(tr)) {
+		result = write_master_raw_flat_bins(tr, rd);
+	}
+	else {
+		result = write_master_bin_ops(tr, rd, &particles_llb, NULL, NULL,
+				&rw->response_db);
+	}
+
+	if (result != 0) {
 		cf_ll_buf_free(&particles_llb);
 		unwind_index_metadata(&old_metadata, r);
 		return result;
@@ -1734,6 +1799,88 @@ write_master_ssd(as_transaction* tr, as_index_ref* r_ref, as_storage_rd* rd,
 }
 
 
+// Returns false if the transaction isn't touch-only, or the stored record can't
+// be patched in place - caller then does a full read-modify-write. Otherwise
+// the record's stored image (bins untouched, even if compressed) is rewritten
+// with new generation and void-time, and doubles as the replica pickle.
+bool
+write_master_ssd_touch(as_transaction* tr, as_storage_rd* rd, rw_request* rw,
+		int* result)
+{
+	// Shortcut pointers.
+	as_msg* m = &tr->msgp->msg;
+	as_namespace* ns = tr->rsv.ns;
+	as_record* r = rd->r;
+
+	if (ns->storage_type != AS_STORAGE_ENGINE_SSD || g_config.downgrading ||
+			as_transaction_is_xdr(tr) ||
+			(m->info1 & AS_MSG_INFO1_GET_ALL) != 0 ||
+			! as_record_is_live(r) || r->has_bin_meta == 1 ||
+			// Already read for a filter, or a key to add to the record.
+			rd->flat != NULL || (rd->key != NULL && r->key_stored == 0)) {
+		return false;
+	}
+
+	as_msg_op* op = NULL;
+	uint16_t i = 0;
+
+	while ((op = as_msg_op_iterate(m, op, &i)) != NULL) {
+		if (op->op != AS_MSG_OP_TOUCH) {
+			return false;
+		}
+	}
+
+	if (! as_storage_record_load_pickle(rd)) {
+		return false; // full path will fail and report it
+	}
+
+	uint8_t* pickle = rd->pickle;
+
+	index_metadata old_metadata;
+
+	stash_index_metadata(r, &old_metadata);
+	advance_record_version(tr, r);
+
+	bool touched = as_flat_touch_record(r, (as_flat_record*)pickle);
+	int rv = 0;
+
+	if (touched) {
+		rd->orig_pickle_sz = rd->pickle_sz;
+
+		rv = as_storage_record_write(rd);
+	}
+
+	// Note - if keeping a pickle, the write replaced ours with its own copy.
+	if (rd->pickle == pickle) {
+		rd->pickle = NULL;
+		rd->pickle_sz = 0;
+		rd->orig_pickle_sz = 0;
+	}
+
+	cf_free(pickle);
+
+	if (! touched) {
+		// Void-time added or removed - stored layout changes.
+		unwind_index_metadata(&old_metadata, r);
+		return false;
+	}
+
+	if (rv < 0) {
+		cf_detail(AS_RW, "{%s} write_master: failed as_storage_record_write() %pD", ns->name, &tr->keyd);
+		unwind_index_metadata(&old_metadata, r);
+		*result = -rv;
+		return true;
+	}
+
+	as_record_transition_stats(r, ns, &old_metadata);
+	pickle_all(rd, rw);
+
+	*result = 0;
+
+	return true;
+}
+
+
 //==========================================================
 // write_master() - apply record updates.
 //
@@ -1811,6 +1958,78 @@ write_master_bin_ops(as_transaction* tr, as_storage_rd* rd,
 }
 
 
+// Restore path for backups taken as raw flat records - the single op's value
+// is a pickle, unpacked straight into the (empty, since it's a replace) new
+// bins array. Non-data-in-memory only, so particles point into the message.
+int
+write_master_raw_flat_bins(as_transaction* tr, as_storage_rd* rd)
+{
+	// Shortcut pointers.
+	as_msg* m = &tr->msgp->msg;
+	as_namespace* ns = tr->rsv.ns;
+
+	uint16_t n = 0;
+	as_msg_op* op = as_msg_op_iterate(m, NULL, &n);
+
+	if (op->op != AS_MSG_OP_WRITE ||
+			op->particle_type != AS_PARTICLE_TYPE_BLOB ||
+			op->name_sz != sizeof(AS_MSG_RAW_FLAT_FORMAT) - 1 ||
+			memcmp(op->name, AS_MSG_RAW_FLAT_FORMAT, op->name_sz) != 0) {
+		cf_warning(AS_RW, "{%s} write_master: raw flat op must be a %s blob write %pD", ns->name, AS_MSG_RAW_FLAT_FORMAT, &tr->keyd);
+		return AS_ERR_PARAMETER;
+	}
+
+	as_remote_record rr = {
+			.rsv = &tr->rsv,
+			.pickle = (uint8_t*)as_msg_op_get_value_p(op),
+			.pickle_sz = as_msg_op_get_value_sz(op)
+	};
+
+	if (! as_flat_unpack_remote_record_meta(ns, &rr)) {
+		cf_warning(AS_RW, "{%s} write_master: bad raw flat record %pD", ns->name, &tr->keyd);
+		return AS_ERR_PARAMETER;
+	}
+
+	if (cf_digest_compare(rr.keyd, &tr->keyd) != 0) {
+		cf_warning(AS_RW, "{%s} write_master: raw flat record digest mismatch %pD", ns->name, &tr->keyd);
+		return AS_ERR_PARAMETER;
+	}
+
+	if (rr.set_name_len != rd->set_name_len || (rr.set_name_len != 0 &&
+			memcmp(rr.set_name, rd->set_name, rr.set_name_len) != 0)) {
+		cf_warning(AS_RW, "{%s} write_master: raw flat record set mismatch %pD", ns->name, &tr->keyd);
+		return AS_ERR_PARAMETER;
+	}
+
+	if (rr.n_bins > RECORD_MAX_BINS) {
+		cf_warning(AS_RW, "{%s} write_master: raw flat record has too many bins %pD", ns->name, &tr->keyd);
+		return AS_ERR_PARAMETER;
+	}
+
+	int result = as_flat_unpack_remote_bins(&rr, rd->bins);
+
+	if (result < 0) {
+		cf_warning(AS_RW, "{%s} write_master: failed unpacking raw flat bins %pD", ns->name, &tr->keyd);
+		return -result;
+	}
+
+	rd->n_bins = rr.n_bins;
+
+	// Bin metadata is the restoring write's, not the backed-up record's.
+	for (uint16_t i = 0; i < rd->n_bins; i++) {
+		as_bin_clear_meta(&rd->bins[i]);
+	}
+
+	// The stored key travels in the pickle.
+	if (rd->key == NULL && rr.key != NULL) {
+		rd->key = rr.key;
+		rd->key_size = rr.key_size;
+	}
+
+	return 0;
+}
+
+
 int
 write_master_bin_ops_loop(as_transaction* tr, as_storage_rd* rd,
 		as_msg_op** ops, as_bin* response_bins, uint32_t* p_n_response_bins,
@@ -1836,7 +2055,14 @@ write_master_bin_ops_loop(as_transaction* tr, as_storage_rd* rd,
 	as_msg_op* op = NULL;
 	uint16_t i = 0;
 
+	as_bin_cdt_ctx_cache_reset();
+
 	while ((op = as_msg_op_iterate(m, op, &i)) != NULL) {
+		// Writes may free particles - cached CDT contexts could go stale.
+		if (! OP_IS_READ(op->op)) {
+			as_bin_cdt_ctx_cache_reset();
+		}
+
 		if (! resolve_bin(rd, op, msg_lut, m->n_ops, &n_won, &result)) {
 			if (result != AS_OK) {
 				return result;
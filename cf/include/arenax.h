@@ -62,6 +62,12 @@ typedef enum {
 	CF_ARENAX_ERR_UNKNOWN
 } cf_arenax_err;
 
+// CE stage placement - passed as xmem_type_cfg for CF_XMEM_TYPE_MEM.
+typedef struct cf_arenax_mem_cfg_s {
+	bool				numa_interleave;
+	bool				huge_pages;
+} cf_arenax_mem_cfg;
+
 //------------------------------------------------
 // For enterprise separation only.
 //
@@ -83,7 +89,7 @@ typedef struct cf_arenax_s {
 	key_t				key_base;
 	uint32_t			element_size;
 	uint32_t			stage_capacity; // derived
-	uint32_t			unused_1;
+	uint32_t			huge_stage_count; // CE stats only
 	uint32_t			unused_2;
 	size_t				stage_size;
 
@@ -125,6 +131,14 @@ typedef struct free_element_s {
 
 #define FREE_MAGIC 0xff1234ff
 
+// Link in the last 8 bytes - same as next_h above for 64-byte elements.
+static inline cf_arenax_handle*
+free_element_next_h(const cf_arenax* arena, free_element* p_free_element)
+{
+	return (cf_arenax_handle*)((uint8_t*)p_free_element +
+			arena->element_size - sizeof(cf_arenax_handle));
+}
+
 typedef struct cf_arenax_puddle_s {
 	uint64_t free_h: 40;
 } __attribute__((packed)) cf_arenax_puddle;
@@ -144,6 +158,7 @@ cf_arenax_handle cf_arenax_alloc(cf_arenax* arena, cf_arenax_puddle* puddle);
 void cf_arenax_free(cf_arenax* arena, cf_arenax_handle h, cf_arenax_puddle* puddle);
 
 bool cf_arenax_is_stage_address(cf_arenax* arena, const void* address);
+bool cf_arenax_compact(cf_arenax* arena, uint64_t* n_free, uint64_t* released_sz);
 
 bool cf_arenax_want_prefetch(cf_arenax* arena);
 void cf_arenax_reclaim(cf_arenax* arena, cf_arenax_puddle* puddles, uint32_t n_puddles);
@@ -156,6 +171,14 @@ cf_arenax_resolve(const cf_arenax* arena, cf_arenax_handle h)
 			((h & ELEMENT_ID_MASK) * arena->element_size);
 }
 
+// For speculative unlocked reads - is handle inside an existing stage?
+static inline bool
+cf_arenax_handle_in_range(const cf_arenax* arena, cf_arenax_handle h)
+{
+	return (h >> ELEMENT_ID_NUM_BITS) < arena->stage_count &&
+			(h & ELEMENT_ID_MASK) < arena->stage_capacity;
+}
+
 
 //==========================================================
 // Private API - for enterprise separation only.
@@ -177,6 +200,7 @@ cf_arenax_expand_handle(uint32_t* stage_id, uint32_t* element_id,
 }
 
 cf_arenax_err cf_arenax_add_stage(cf_arenax* arena);
+void cf_arenax_remove_last_stage(cf_arenax* arena);
 
 cf_arenax_handle cf_arenax_alloc_chunked(cf_arenax* arena, cf_arenax_puddle* puddle);
 void cf_arenax_free_chunked(cf_arenax* arena, cf_arenax_handle h, cf_arenax_puddle* puddle);
@@ -52,6 +52,19 @@ typedef struct cf_thread_stats_s {
 	uint32_t n_pool_active;
 } cf_thread_stats;
 
+#define CF_THREAD_MAX_ROLES 256
+
+// Over the last cf_thread_sample_stats() interval - percentages are summed
+// over the role's threads, so 100 is one CPU's worth.
+typedef struct cf_thread_role_stats_s {
+	char name[64]; // run function of the thread, or of a pool thread's request
+	uint32_t n_threads;
+	uint32_t cpu_pct;
+	uint32_t wait_pct; // runnable but waiting for a CPU
+	uint64_t vcsw_per_sec;
+	uint64_t ivcsw_per_sec;
+} cf_thread_role_stats;
+
 
 //==========================================================
 // Globals.
@@ -69,8 +82,13 @@ void cf_thread_create_transient(cf_thread_run_fn run, void* udata);
 cf_tid cf_thread_create_detached(cf_thread_run_fn run, void* udata);
 cf_tid cf_thread_create_joinable(cf_thread_run_fn run, void* udata);
 void cf_thread_get_stats(cf_thread_stats* stats);
+void cf_thread_sample_stats(void);
+uint32_t cf_thread_get_role_stats(cf_thread_role_stats* stats, uint32_t max_stats);
 int32_t cf_thread_traces(char* key, cf_dyn_buf* db);
 void cf_thread_traces_action(int32_t sig_num, siginfo_t* info, void* ctx);
+void cf_thread_profile_set_rate(uint32_t rate);
+int32_t cf_thread_profile(char* key, cf_dyn_buf* db);
+void cf_thread_profile_action(int32_t sig_num, siginfo_t* info, void* ctx);
 void cf_thread_realloc(void** pp, size_t* psz);
 void cf_thread_add_exit(cf_thread_exit_fn cb, void* udata);
 void cf_thread_remove_exit(cf_thread_exit_fn cb);
@@ -0,0 +1,39 @@
+/*
+ * crc32c.h
+ *
+ * Copyright (C) 2020 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+//==========================================================
+// Public API.
+//
+
+// CRC-32C (Castagnoli). Uses SSE4.2 or ARMv8 CRC instructions when the CPU
+// has them, otherwise a table. Pass 0 to start, a previous result to continue.
+uint32_t cf_crc32c(uint32_t crc, const void* buf, size_t size);
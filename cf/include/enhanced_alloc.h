@@ -51,6 +51,25 @@ typedef enum {
 	CF_ALLOC_DEBUG_ALL
 } cf_alloc_debug;
 
+// Subsystems whose threads allocate from their own arena, for accounting.
+typedef enum {
+	CF_ALLOC_SYS_TRANSACTION,
+	CF_ALLOC_SYS_FABRIC,
+	CF_ALLOC_SYS_QUERY,
+
+	CF_ALLOC_N_SYS
+} cf_alloc_sys;
+
+#define CF_ALLOC_MAX_BINS 64
+
+// Occupancy of an arena's small size classes ("bins") - regions in use, as a
+// percentage of the regions in the runs each class currently holds.
+typedef struct cf_alloc_bin_util_s {
+	uint32_t n_bins;
+	size_t sz[CF_ALLOC_MAX_BINS]; // region size - ascending
+	uint32_t util_pct[CF_ALLOC_MAX_BINS];
+} cf_alloc_bin_util;
+
 
 //==========================================================
 // Public API - arena management and stats.
@@ -65,7 +84,16 @@ int32_t cf_alloc_create_arena(void);
 #define CF_ALLOC_SET_NS_ARENA_DIM(ns) \
 	(g_ns_arena = ns->storage_data_in_memory ? ns->jem_arena : -1)
 
+int32_t cf_alloc_set_thread_sys(cf_alloc_sys sys);
+int32_t cf_alloc_set_thread_arena(int32_t arena);
+size_t cf_alloc_arena_kbytes(int32_t arena);
+void cf_alloc_sys_stats(size_t sys_kbytes[CF_ALLOC_N_SYS]);
+const char *cf_alloc_sys_name(cf_alloc_sys sys);
+
 void cf_alloc_heap_stats(size_t *allocated_kbytes, size_t *active_kbytes, size_t *mapped_kbytes, double *efficiency_pct, uint32_t *site_count);
+void cf_alloc_arena_bin_util(int32_t arena, cf_alloc_bin_util *util);
+bool cf_alloc_bin_util_sparse(const cf_alloc_bin_util *util, size_t sz, uint32_t lwm_pct);
+void cf_alloc_arena_purge(int32_t arena);
 void cf_alloc_log_stats(const char *file, const char *opts);
 void cf_alloc_log_site_infos(const char *file);
 
@@ -93,6 +121,9 @@ void *cf_alloc_realloc_arena(void *p, size_t sz, int32_t arena);
 
 #define cf_valloc(_sz)           valloc(_sz)
 
+// For defragmentation - moves an allocation to a fresh region in the arena.
+void *cf_alloc_relocate_arena(void *p, size_t sz, int32_t arena);
+
 #define cf_strdup(_s)            strdup(_s)
 #define cf_strndup(_s, _n)       strndup(_s, _n)
 
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <sched.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -49,6 +50,9 @@ typedef uint32_t cf_topo_napi_id;
 void cf_topo_config(cf_topo_auto_pin auto_pin, cf_topo_numa_node_index a_numa_node,
 		const cf_addr_list *addrs);
 void cf_topo_force_map_memory(const uint8_t *from, size_t size);
+void *cf_topo_alloc_local(size_t size, cf_topo_numa_node_index i_os_numa_node, bool huge_pages);
+void cf_topo_free_local(void *p, size_t size);
+void *cf_topo_try_alloc(size_t size, bool interleave, bool huge_pages, bool *hugetlb);
 void cf_topo_migrate_memory(void);
 void cf_topo_info(void);
 
@@ -62,6 +66,10 @@ cf_topo_napi_id cf_topo_socket_napi_id(const cf_socket *sock);
 void cf_topo_pin_to_core(cf_topo_core_index i_core);
 void cf_topo_pin_to_cpu(cf_topo_cpu_index i_cpu);
 
+bool cf_topo_parse_os_cpu_list(const char *list, cpu_set_t *mask);
+void cf_topo_pin_to_os_cpus(const cpu_set_t *mask);
+bool cf_topo_pin_to_os_numa_node(cf_topo_numa_node_index i_os_numa_node);
+
 #define CF_STORAGE_MAX_PHYS 100
 
 typedef struct cf_storage_device_s {
@@ -72,6 +80,7 @@ typedef struct cf_storage_device_s {
 		char *dev_path;
 		cf_topo_numa_node_index numa_node;
 		int32_t nvme_age;
+		bool integrity; // end-to-end protection (T10 PI)
 	} phys[CF_STORAGE_MAX_PHYS];
 } cf_storage_device_info;
 
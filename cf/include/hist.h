@@ -26,6 +26,7 @@
 // Includes.
 //
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "dynbuf.h"
@@ -52,6 +53,8 @@ typedef struct histogram_s histogram;
 // Public API.
 //
 
+void histogram_set_significant_digits(uint32_t digits);
+
 histogram* histogram_create(const char* name, histogram_scale scale);
 void histogram_clear(histogram* h);
 void histogram_rescale(histogram* h, histogram_scale scale);
@@ -64,4 +67,5 @@ void histogram_insert_raw_unsafe(histogram* h, uint64_t value);
 void histogram_save_info(histogram* h);
 void histogram_get_info(histogram* h, cf_dyn_buf* db);
 
-void histogram_get_latencies(histogram* h, cf_dyn_buf* db);
+void histogram_get_latencies(histogram* h, bool percentiles, cf_dyn_buf* db);
+void histogram_get_counts_over_us(histogram* h, uint64_t us, uint64_t* p_total, uint64_t* p_over);
@@ -197,6 +197,9 @@ void cf_log_get_level(uint32_t id, const char* context_str, cf_dyn_buf* db);
 void cf_log_get_all_levels(uint32_t id, cf_dyn_buf* db);
 bool cf_log_check_level(cf_log_context context, cf_log_level level);
 void cf_log_rotate(void);
+void cf_log_start_async(void);
+void cf_log_stop_async(void);
+uint64_t cf_log_n_dropped(void);
 
 
 //==========================================================
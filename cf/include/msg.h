@@ -145,11 +145,7 @@ typedef struct msg_buf_ele_s {
 //
 
 // Free up a "msg" object.
-static inline void
-msg_put(msg *m)
-{
-	cf_rc_free(m);
-}
+void msg_put(msg *m);
 
 //------------------------------------------------
 // Lifecycle.
@@ -172,6 +168,7 @@ msg_incr_ref(msg *m)
 
 size_t msg_get_wire_size(const msg *m);
 size_t msg_get_template_fixed_sz(const msg_template *mt, size_t mt_count);
+size_t msg_get_iov_buf_sz(const msg *m, size_t *max_iov_r);
 size_t msg_to_iov_buf(const msg *m, uint8_t *buf, size_t buf_sz, uint32_t *msg_sz_r);
 size_t msg_to_wire(const msg *m, uint8_t *buf);
 
@@ -61,15 +61,24 @@ typedef int (*cf_rchash_reduce_fn)(const void* key, void* object, void* udata);
 // clean up the object's "internals".
 typedef void (*cf_rchash_destructor_fn)(void* object);
 
-// Private data.
+// Private data - open-addressing tables, one per lock stripe.
+typedef struct cf_rchash_stripe_s {
+	cf_mutex lock;
+	uint32_t mask; // capacity - 1
+	uint32_t growth_left; // empty slots usable before rehash
+	uint32_t n_used;
+	uint8_t* ctrl; // control bytes - capacity + one cloned group
+	uint8_t* slots;
+} cf_rchash_stripe;
+
 typedef struct cf_rchash_s {
 	cf_rchash_hash_fn h_fn;
 	cf_rchash_destructor_fn d_fn;
 	uint32_t key_size;
-	uint32_t n_buckets;
+	uint32_t slot_size;
+	uint32_t n_stripes; // power of 2
 	uint32_t n_elements;
-	void* table;
-	cf_mutex* bucket_locks;
+	cf_rchash_stripe* stripes;
 } cf_rchash;
 
 
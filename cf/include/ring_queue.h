@@ -0,0 +1,74 @@
+/*
+ * ring_queue.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Bounded lock-free multi-producer multi-consumer queue. Push fails when the
+// queue is full - the caller decides what to do with the element.
+
+#define CF_RING_QUEUE_FOREVER (-1)
+#define CF_RING_QUEUE_NOWAIT 0
+
+#define CF_RING_QUEUE_PAD 64
+
+typedef struct cf_ring_queue_s {
+	uint32_t mask; // capacity - 1
+	uint32_t ele_sz;
+	uint32_t cell_sz;
+	uint8_t* cells;
+
+	// Producers, consumers and waiters each get their own cache line.
+
+	uint8_t pad0[CF_RING_QUEUE_PAD];
+	uint64_t write_pos;
+
+	uint8_t pad1[CF_RING_QUEUE_PAD];
+	uint64_t read_pos;
+
+	uint8_t pad2[CF_RING_QUEUE_PAD];
+	uint32_t wake_seq; // futex word for blocking pops
+	uint32_t n_waiters;
+} cf_ring_queue;
+
+
+//==========================================================
+// Public API.
+//
+
+void cf_ring_queue_init(cf_ring_queue* q, uint32_t ele_sz, uint32_t capacity);
+void cf_ring_queue_destroy(cf_ring_queue* q);
+
+bool cf_ring_queue_push(cf_ring_queue* q, const void* ele);
+bool cf_ring_queue_pop(cf_ring_queue* q, void* ele, int32_t ms_wait);
+uint32_t cf_ring_queue_sz(const cf_ring_queue* q);
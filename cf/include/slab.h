@@ -0,0 +1,66 @@
+/*
+ * slab.h
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+typedef struct cf_slab_s cf_slab;
+
+#define CF_SLAB_MAX 64
+#define CF_SLAB_NAME_SZ 32
+
+typedef struct cf_slab_stats_s {
+	char name[CF_SLAB_NAME_SZ];
+	size_t obj_sz;
+	uint64_t n_objects; // from heap, in use or cached
+	uint64_t n_depot_objects; // cached in depot - excludes per-thread caches
+} cf_slab_stats;
+
+
+//==========================================================
+// Public API.
+//
+
+// Slabs are never destroyed. Objects are cached per thread, and full caches
+// are shared between threads via the slab's depot.
+
+cf_slab* cf_slab_create(size_t sz, const char* name);
+void* cf_slab_alloc(cf_slab* slab);
+void cf_slab_free(cf_slab* slab, void* p);
+
+// Reference-counted objects - use with cf_rc_reserve() & cf_rc_release().
+cf_slab* cf_slab_create_rc(size_t sz, const char* name);
+void* cf_slab_rc_alloc(cf_slab* slab);
+void cf_slab_rc_free(cf_slab* slab, void* body);
+
+uint32_t cf_slab_get_stats(cf_slab_stats* stats, uint32_t max_stats);
@@ -264,6 +264,7 @@ void cf_socket_keep_alive(cf_socket *sock, int32_t idle, int32_t interval, int32
 void cf_socket_set_send_buffer(cf_socket *sock, int32_t size);
 void cf_socket_set_receive_buffer(cf_socket *sock, int32_t size);
 void cf_socket_set_window(cf_socket *sock, int32_t size);
+void cf_socket_set_busy_poll(cf_socket *sock, int32_t us);
 
 void cf_socket_init(cf_socket *sock);
 bool cf_socket_exists(cf_socket *sock);
@@ -0,0 +1,61 @@
+/*
+ * uring.h
+ *
+ * Copyright (C) 2020 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+#pragma once
+
+//==========================================================
+// Includes.
+//
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+typedef struct cf_uring_s cf_uring;
+
+// One read of a batch - buf, size and offset advance as bytes arrive.
+typedef struct cf_uring_read_s {
+	int fd;
+	void* buf;
+	size_t size;
+	off_t offset;
+	int err; // out - 0 or errno
+} cf_uring_read;
+
+
+//==========================================================
+// Public API.
+//
+
+cf_uring* cf_uring_create(uint32_t n_entries, bool poll);
+void cf_uring_destroy(cf_uring* ring);
+bool cf_uring_pread_all(cf_uring* ring, int fd, void* buf, size_t size, off_t offset);
+bool cf_uring_pread_batch(cf_uring* ring, cf_uring_read* reads, uint32_t n_reads);
+
+cf_uring* cf_uring_thread_ring(void);
+void cf_uring_thread_disable(void);
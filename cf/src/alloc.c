@@ -110,6 +110,15 @@ static __thread uint32_t g_thread_site_infos[MAX_SITES];
 bool g_alloc_started = false;
 static int32_t g_startup_arena = -1;
 
+// Subsystem arenas are consecutive - first one here, -1 until created.
+static int32_t g_first_sys_arena = -1;
+
+static const char *SYS_NAMES[CF_ALLOC_N_SYS] = {
+		[CF_ALLOC_SYS_TRANSACTION] = "transaction",
+		[CF_ALLOC_SYS_FABRIC] = "fabric",
+		[CF_ALLOC_SYS_QUERY] = "query"
+};
+
 static cf_alloc_debug g_debug;
 static bool g_indent;
 static bool g_salt;
@@ -554,6 +563,20 @@ cf_alloc_set_debug(cf_alloc_debug debug_allocations, bool indent_allocations,
 	g_indent = indent_allocations;
 	g_salt = salt_allocations;
 
+	// Create the subsystem arenas now - after the startup arena, which has to
+	// be arena N_ARENAS, but before any subsystem thread runs.
+
+	for (uint32_t sys = 0; sys < CF_ALLOC_N_SYS; sys++) {
+		int32_t arena = cf_alloc_create_arena();
+
+		if (sys == 0) {
+			g_first_sys_arena = arena;
+		}
+		else if (arena != g_first_sys_arena + (int32_t)sys) {
+			cf_crash(CF_ALLOC, "non-consecutive subsystem arena %d", arena);
+		}
+	}
+
 	g_alloc_started = true;
 }
 
@@ -573,9 +596,39 @@ cf_alloc_create_arena(void)
 	return arena;
 }
 
-void
-cf_alloc_heap_stats(size_t *allocated_kbytes, size_t *active_kbytes, size_t *mapped_kbytes,
-		double *efficiency_pct, uint32_t *site_count)
+int32_t
+cf_alloc_set_thread_sys(cf_alloc_sys sys)
+{
+	return cf_alloc_set_thread_arena(g_first_sys_arena + (int32_t)sys);
+}
+
+int32_t
+cf_alloc_set_thread_arena(int32_t arena)
+{
+	// Flush the thread cache, so objects cached from the old arena aren't
+	// handed out - and accounted - as if they came from the new one.
+
+	int err = jem_mallctl("thread.tcache.flush", NULL, NULL, NULL, 0);
+
+	if (err != 0) {
+		cf_crash(CF_ALLOC, "error while flushing thread cache: %d (%s)", err, cf_strerror(err));
+	}
+
+	unsigned new_arena = (unsigned)arena;
+	unsigned old_arena;
+	size_t len = sizeof(old_arena);
+
+	err = jem_mallctl("thread.arena", &old_arena, &len, &new_arena, len);
+
+	if (err != 0) {
+		cf_crash(CF_ALLOC, "failed to set thread arena %d: %d (%s)", arena, err, cf_strerror(err));
+	}
+
+	return (int32_t)old_arena;
+}
+
+static void
+refresh_stats(void)
 {
 	uint64_t epoch = 1;
 	size_t len = sizeof(epoch);
@@ -585,11 +638,76 @@ cf_alloc_heap_stats(size_t *allocated_kbytes, size_t *active_kbytes, size_t *map
 	if (err != 0) {
 		cf_crash(CF_ALLOC, "failed to retrieve epoch: %d (%s)", err, cf_strerror(err));
 	}
+}
+
+static size_t
+arena_allocated(int32_t arena)
+{
+	static const char *classes[] = { "small", "large", "huge" };
+
+	size_t total = 0;
+
+	for (uint32_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+		char name[64];
+
+		snprintf(name, sizeof(name), "stats.arenas.%d.%s.allocated", arena,
+				classes[i]);
+
+		size_t allocated;
+		size_t len = sizeof(allocated);
+
+		int err = jem_mallctl(name, &allocated, &len, NULL, 0);
+
+		if (err != 0) {
+			cf_crash(CF_ALLOC, "failed to retrieve %s: %d (%s)", name, err, cf_strerror(err));
+		}
+
+		total += allocated;
+	}
+
+	return total;
+}
+
+size_t
+cf_alloc_arena_kbytes(int32_t arena)
+{
+	refresh_stats();
+
+	return arena_allocated(arena) / 1024;
+}
+
+void
+cf_alloc_sys_stats(size_t sys_kbytes[CF_ALLOC_N_SYS])
+{
+	if (g_first_sys_arena < 0) {
+		memset(sys_kbytes, 0, sizeof(size_t) * CF_ALLOC_N_SYS);
+		return;
+	}
+
+	refresh_stats();
+
+	for (uint32_t sys = 0; sys < CF_ALLOC_N_SYS; sys++) {
+		sys_kbytes[sys] = arena_allocated(g_first_sys_arena + (int32_t)sys) /
+				1024;
+	}
+}
+
+const char *
+cf_alloc_sys_name(cf_alloc_sys sys)
+{
+	return SYS_NAMES[sys];
+}
+
+void
+cf_alloc_heap_stats(size_t *allocated_kbytes, size_t *active_kbytes, size_t *mapped_kbytes,
+		double *efficiency_pct, uint32_t *site_count)
+{
+	refresh_stats();
 
 	size_t allocated;
-	len = sizeof(allocated);
+	size_t len = sizeof(allocated);
 
-	err = jem_mallctl("stats.allocated", &allocated, &len, NULL, 0);
+	int err = jem_mallctl("stats.allocated", &allocated, &len, NULL, 0);
 
 	if (err != 0) {
 		cf_crash(CF_ALLOC, "failed to retrieve stats.allocated: %d (%s)", err, cf_strerror(err));
@@ -635,6 +753,102 @@ cf_alloc_heap_stats(size_t *allocated_kbytes, size_t *active_kbytes, size_t *map
 	}
 }
 
+void
+cf_alloc_arena_bin_util(int32_t arena, cf_alloc_bin_util *util)
+{
+	refresh_stats();
+
+	unsigned n_bins;
+	size_t len = sizeof(n_bins);
+
+	int err = jem_mallctl("arenas.nbins", &n_bins, &len, NULL, 0);
+
+	if (err != 0) {
+		cf_crash(CF_ALLOC, "failed to retrieve arenas.nbins: %d (%s)", err, cf_strerror(err));
+	}
+
+	util->n_bins = n_bins > CF_ALLOC_MAX_BINS ? CF_ALLOC_MAX_BINS : n_bins;
+
+	for (uint32_t i = 0; i < util->n_bins; i++) {
+		char name[64];
+		size_t sz;
+		uint32_t nregs;
+		size_t curregs;
+		size_t curruns;
+
+		snprintf(name, sizeof(name), "arenas.bin.%u.size", i);
+		len = sizeof(sz);
+		err = jem_mallctl(name, &sz, &len, NULL, 0);
+
+		if (err == 0) {
+			snprintf(name, sizeof(name), "arenas.bin.%u.nregs", i);
+			len = sizeof(nregs);
+			err = jem_mallctl(name, &nregs, &len, NULL, 0);
+		}
+
+		if (err == 0) {
+			snprintf(name, sizeof(name), "stats.arenas.%d.bins.%u.curregs",
+					arena, i);
+			len = sizeof(curregs);
+			err = jem_mallctl(name, &curregs, &len, NULL, 0);
+		}
+
+		if (err == 0) {
+			snprintf(name, sizeof(name), "stats.arenas.%d.bins.%u.curruns",
+					arena, i);
+			len = sizeof(curruns);
+			err = jem_mallctl(name, &curruns, &len, NULL, 0);
+		}
+
+		if (err != 0) {
+			cf_crash(CF_ALLOC, "failed to retrieve %s: %d (%s)", name, err, cf_strerror(err));
+		}
+
+		size_t capacity = curruns * nregs;
+
+		util->sz[i] = sz;
+		util->util_pct[i] = capacity == 0 ?
+				100 : (uint32_t)((curregs * 100) / capacity);
+	}
+}
+
+// Is an allocation of this size in a class whose runs are under lwm_pct full?
+// Large allocations have their own runs, so are never sparse.
+bool
+cf_alloc_bin_util_sparse(const cf_alloc_bin_util *util, size_t sz,
+		uint32_t lwm_pct)
+{
+	uint32_t lo = 0;
+	uint32_t hi = util->n_bins;
+
+	while (lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+
+		if (util->sz[mid] < sz) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	return lo < util->n_bins && util->util_pct[lo] < lwm_pct;
+}
+
+void
+cf_alloc_arena_purge(int32_t arena)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "arena.%d.purge", arena);
+
+	int err = jem_mallctl(name, NULL, NULL, NULL, 0);
+
+	if (err != 0) {
+		cf_warning(CF_ALLOC, "failed %s: %d (%s)", name, err, cf_strerror(err));
+	}
+}
+
 static void
 line_to_log(void *data, const char *line)
 {
@@ -736,9 +950,13 @@ static bool
 is_transient(int32_t arena)
 {
 	// Note that this also considers -1 (i.e., the default thread arena)
-	// to be transient, in addition to arenas 0 .. (N_ARENAS - 1).
+	// to be transient, in addition to arenas 0 .. (N_ARENAS - 1). Subsystem
+	// arenas are just accounting buckets for default allocations, so they're
+	// transient, too.
 
-	return arena < N_ARENAS;
+	return arena < N_ARENAS || (g_first_sys_arena >= 0 &&
+			arena >= g_first_sys_arena &&
+			arena < g_first_sys_arena + CF_ALLOC_N_SYS);
 }
 
 static bool
@@ -966,6 +1184,36 @@ cf_alloc_malloc_arena(size_t sz, int32_t arena)
 	return p_indent;
 }
 
+void *
+cf_alloc_relocate_arena(void *p_indent, size_t sz, int32_t arena)
+{
+	if (want_debug(arena)) {
+		void *p2_indent = do_mallocx(sz, arena, __builtin_return_address(0));
+
+		cf_assert(p2_indent != NULL, CF_ALLOC, "relocate failed sz %zu arena %d",
+				sz, arena);
+
+		memcpy(p2_indent, p_indent, sz);
+		do_free(p_indent, __builtin_return_address(0));
+
+		return p2_indent;
+	}
+
+	// Bypass thread caches - the new region must come from the arena's runs,
+	// which hand out the lowest-addressed free region of the fullest runs, and
+	// the old region must go straight back to its run, so sparse runs empty.
+	int32_t flags = MALLOCX_ARENA(arena) | MALLOCX_TCACHE_NONE;
+	void *p2 = jem_mallocx(sz == 0 ? 1 : sz, flags);
+
+	cf_assert(p2 != NULL, CF_ALLOC, "relocate failed sz %zu arena %d", sz,
+			arena);
+
+	memcpy(p2, p_indent, sz);
+	jem_dallocx(p_indent, MALLOCX_TCACHE_NONE);
+
+	return p2;
+}
+
 void *
 __attribute__ ((noinline))
 malloc(size_t sz)
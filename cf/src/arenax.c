@@ -30,6 +30,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
 #include <sys/types.h>
 
 #include "citrusleaf/alloc.h"
@@ -82,7 +85,7 @@ cf_arenax_init(cf_arenax* arena, cf_xmem_type xmem_type,
 	arena->element_size = element_size;
 	arena->chunk_count = chunk_count;
 	arena->stage_capacity = (uint32_t)(stage_size / element_size);
-	arena->unused_1 = 0;
+	arena->huge_stage_count = 0;
 	arena->unused_2 = 0;
 	arena->stage_size = stage_size;
 
@@ -137,12 +140,14 @@ cf_arenax_alloc(cf_arenax* arena, cf_arenax_puddle* puddle)
 
 		free_element* p_free_element = cf_arenax_resolve(arena, h);
 
-		arena->free_h = p_free_element->next_h;
+		arena->free_h = *free_element_next_h(arena, p_free_element);
 	}
 	// Otherwise keep end-allocating.
 	else {
 		if (arena->at_element_id >= arena->stage_capacity) {
-			if (cf_arenax_add_stage(arena) != CF_ARENAX_OK) {
+			// Compaction may have left stages beyond at_stage_id.
+			if (arena->at_stage_id + 1 >= arena->stage_count &&
+					cf_arenax_add_stage(arena) != CF_ARENAX_OK) {
 				cf_mutex_unlock(&arena->lock);
 				return 0;
 			}
@@ -175,7 +180,7 @@ cf_arenax_free(cf_arenax* arena, cf_arenax_handle h, cf_arenax_puddle* puddle)
 	cf_mutex_lock(&arena->lock);
 
 	p_free_element->magic = FREE_MAGIC;
-	p_free_element->next_h = arena->free_h;
+	*free_element_next_h(arena, p_free_element) = arena->free_h;
 	arena->free_h = h;
 
 	cf_mutex_unlock(&arena->lock);
@@ -199,3 +204,122 @@ cf_arenax_is_stage_address(cf_arenax* arena, const void* address)
 
 	return found;
 }
+
+// Rebuild the free list in ascending handle order so new elements pack low in
+// the arena, then pull the end-allocation point back over trailing free
+// elements and return their memory to the OS. Live elements are never moved -
+// sindex and set index entries hold their handles. Stages stay mapped, so
+// speculative readers never fault, and are refilled before any new stage is
+// added. Blocks allocation and freeing for the duration.
+bool
+cf_arenax_compact(cf_arenax* arena, uint64_t* n_free, uint64_t* released_sz)
+{
+	*n_free = 0;
+	*released_sz = 0;
+
+	// Shared or persistent memory doesn't give pages back via madvise().
+	if (arena->xmem_type != CF_XMEM_TYPE_MEM || arena->chunk_count != 1) {
+		return false;
+	}
+
+	cf_mutex_lock(&arena->lock);
+
+	uint64_t capacity = arena->stage_capacity;
+	uint64_t n_elements = ((uint64_t)arena->at_stage_id * capacity) +
+			arena->at_element_id;
+	uint64_t* bits = cf_try_malloc(((n_elements + 63) / 64) * sizeof(uint64_t));
+
+	if (bits == NULL) {
+		cf_mutex_unlock(&arena->lock);
+		cf_warning(CF_ARENAX, "can't allocate compaction bitmap");
+		return false;
+	}
+
+	memset(bits, 0, ((n_elements + 63) / 64) * sizeof(uint64_t));
+
+	for (cf_arenax_handle h = arena->free_h; h != 0;
+			h = *free_element_next_h(arena, cf_arenax_resolve(arena, h))) {
+		uint64_t i = ((h >> ELEMENT_ID_NUM_BITS) * capacity) +
+				(h & ELEMENT_ID_MASK);
+
+		if (i >= n_elements) {
+			cf_crash(CF_ARENAX, "free handle %lx beyond end of arena", h);
+		}
+
+		bits[i / 64] |= 1UL << (i % 64);
+		(*n_free)++;
+	}
+
+#define IS_FREE(_i) ((bits[(_i) / 64] & (1UL << ((_i) % 64))) != 0)
+
+	// The null element is never on the free list, so this stops at 1 latest.
+	uint64_t new_n_elements = n_elements;
+
+	while (IS_FREE(new_n_elements - 1)) {
+		new_n_elements--;
+	}
+
+	arena->free_h = 0;
+
+	for (uint64_t i = new_n_elements; i-- != 0; ) {
+		if (IS_FREE(i)) {
+			cf_arenax_handle h;
+
+			cf_arenax_set_handle(&h, (uint32_t)(i / capacity),
+					(uint32_t)(i % capacity));
+
+			free_element* p_free_element = cf_arenax_resolve(arena, h);
+
+			p_free_element->magic = FREE_MAGIC;
+			*free_element_next_h(arena, p_free_element) = arena->free_h;
+			arena->free_h = h;
+		}
+	}
+
+#undef IS_FREE
+
+	cf_free(bits);
+
+	*n_free -= n_elements - new_n_elements;
+
+	// Keep at_element_id in 1..capacity - alloc adds or reuses a stage at
+	// capacity.
+	uint32_t new_stage_id = (uint32_t)((new_n_elements - 1) / capacity);
+
+	arena->at_stage_id = new_stage_id;
+	arena->at_element_id =
+			(uint32_t)(new_n_elements - ((uint64_t)new_stage_id * capacity));
+
+	// Give back pages between the new end and the old end.
+	uint64_t page_sz = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint32_t old_stage_id = (uint32_t)((n_elements - 1) / capacity);
+	uint64_t old_end = (n_elements - ((uint64_t)old_stage_id * capacity)) *
+			arena->element_size;
+
+	for (uint32_t s = new_stage_id; s <= old_stage_id; s++) {
+		uint64_t start = s == new_stage_id ?
+				(uint64_t)arena->at_element_id * arena->element_size : 0;
+		uint64_t end = s == old_stage_id ? old_end : arena->stage_size;
+
+		start = (start + page_sz - 1) & -page_sz;
+		end = (end + page_sz - 1) & -page_sz;
+
+		if (start >= end) {
+			continue;
+		}
+
+		size_t size = end - start;
+
+		if (madvise(arena->stages[s] + start, size, MADV_DONTNEED) < 0) {
+			cf_detail(CF_ARENAX, "madvise(MADV_DONTNEED) failed on stage %u",
+					s);
+			continue;
+		}
+
+		*released_sz += size;
+	}
+
+	cf_mutex_unlock(&arena->lock);
+
+	return true;
+}
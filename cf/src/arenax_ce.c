@@ -31,6 +31,7 @@
 
 #include "citrusleaf/alloc.h"
 
+#include "hardware.h"
 #include "log.h"
 
 
@@ -65,7 +66,18 @@ cf_arenax_add_stage(cf_arenax* arena)
 		return CF_ARENAX_ERR_STAGE_CREATE;
 	}
 
-	uint8_t* p_stage = (uint8_t*)cf_try_malloc(arena->stage_size);
+	const cf_arenax_mem_cfg* cfg = (const cf_arenax_mem_cfg*)
+			arena->xmem_type_cfg;
+	uint8_t* p_stage;
+	bool hugetlb = false;
+
+	if (cfg != NULL && (cfg->numa_interleave || cfg->huge_pages)) {
+		p_stage = (uint8_t*)cf_topo_try_alloc(arena->stage_size,
+				cfg->numa_interleave, cfg->huge_pages, &hugetlb);
+	}
+	else {
+		p_stage = (uint8_t*)cf_try_malloc(arena->stage_size);
+	}
 
 	if (! p_stage) {
 		cf_ticker_warning(CF_ARENAX,
@@ -74,11 +86,38 @@ cf_arenax_add_stage(cf_arenax* arena)
 		return CF_ARENAX_ERR_STAGE_CREATE;
 	}
 
+	if (hugetlb) {
+		arena->huge_stage_count++;
+	}
+
 	arena->stages[arena->stage_count++] = p_stage;
 
 	return CF_ARENAX_OK;
 }
 
+// Free the most recently added arena stage - matches cf_arenax_add_stage().
+void
+cf_arenax_remove_last_stage(cf_arenax* arena)
+{
+	const cf_arenax_mem_cfg* cfg = (const cf_arenax_mem_cfg*)
+			arena->xmem_type_cfg;
+	uint8_t* p_stage = arena->stages[--arena->stage_count];
+
+	arena->stages[arena->stage_count] = NULL;
+
+	if (cfg != NULL && (cfg->numa_interleave || cfg->huge_pages)) {
+		// Stats only - we don't track which stages got explicit huge pages.
+		if (arena->huge_stage_count > arena->stage_count) {
+			arena->huge_stage_count--;
+		}
+
+		cf_topo_free_local(p_stage, arena->stage_size);
+	}
+	else {
+		cf_free(p_stage);
+	}
+}
+
 cf_arenax_handle
 cf_arenax_alloc_chunked(cf_arenax* arena, cf_arenax_puddle* puddle)
 {
@@ -31,18 +31,23 @@
 #include <pthread.h>
 #include <signal.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_ll.h"
 #include "citrusleaf/cf_queue.h"
 
 #include "cf_mutex.h"
 #include "dynbuf.h"
 #include "log.h"
+#include "shash.h"
 
 #include "warnings.h"
 
@@ -58,6 +63,14 @@ typedef struct thread_req_s {
 
 #define MAX_N_ADDRS 50
 
+// Cumulative, from /proc/self/task/<tid>/schedstat and status.
+typedef struct sched_counters_s {
+	uint64_t cpu_ns;
+	uint64_t wait_ns;
+	uint64_t n_vcsw;
+	uint64_t n_ivcsw;
+} sched_counters;
+
 typedef struct thread_info_s {
 	cf_ll_element link; // base object must be first
 	cf_thread_run_fn run;
@@ -65,8 +78,45 @@ typedef struct thread_info_s {
 	pid_t sys_tid;
 	uint32_t n_addrs;
 	void* addrs[MAX_N_ADDRS];
+	cf_thread_run_fn role; // for pool threads, run of the current request
+	timer_t profile_timer;
+	bool has_profile_timer;
+	bool has_sched_prev;
+	sched_counters sched_prev;
 } thread_info;
 
+typedef struct role_sample_s {
+	cf_thread_run_fn role;
+	uint32_t n_threads;
+	sched_counters delta;
+} role_sample;
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#define PROFILE_MAX_ADDRS 32
+#define PROFILE_SKIP_ADDRS 2 // the signal handler and its trampoline
+#define PROFILE_RING_SZ 4096
+#define PROFILE_MAX_STACKS (16 * 1024)
+#define PROFILE_DRAIN_US (1000 * 1000)
+
+// Zeroed before filling - hashed and compared as bytes.
+typedef struct profile_key_s {
+	cf_thread_run_fn role;
+	uint32_t n_addrs;
+	void* addrs[PROFILE_MAX_ADDRS];
+} profile_key;
+
+#define PROFILE_SLOT_EMPTY 0
+#define PROFILE_SLOT_BUSY 1
+#define PROFILE_SLOT_READY 2
+
+typedef struct profile_slot_s {
+	uint32_t state;
+	profile_key key;
+} profile_slot;
+
 typedef struct thread_alloc_s {
 	void** pp;
 	size_t* psz;
@@ -106,6 +156,24 @@ static __thread uint32_t g_n_allocs = 0;
 static __thread thread_exit* g_exits = NULL;
 static __thread uint32_t g_n_exits = 0;
 
+// Samples per second of thread CPU time - 0 means not profiling.
+static uint32_t g_profile_rate = 0;
+static cf_mutex g_profile_lock = CF_MUTEX_INIT;
+static bool g_profile_started = false;
+
+// Written by signal handlers, drained into g_profile_stacks.
+static profile_slot g_profile_ring[PROFILE_RING_SZ];
+static uint32_t g_profile_ring_ix = 0;
+static uint64_t g_profile_n_dropped = 0;
+static cf_shash* g_profile_stacks; // profile_key -> uint64_t count
+
+// Per-role increases over the last cf_thread_sample_stats() interval.
+static cf_mutex g_sched_lock = CF_MUTEX_INIT;
+static uint64_t g_sched_sample_ns = 0;
+static uint64_t g_sched_interval_ns = 0;
+static role_sample g_role_samples[CF_THREAD_MAX_ROLES];
+static uint32_t g_n_role_samples = 0;
+
 
 //==========================================================
 // Forward declarations.
@@ -121,6 +189,16 @@ static void* joinable_shim_fn(void* udata);
 static int32_t collect_traces_cb(cf_ll_element* ele, void* udata);
 static int32_t print_traces_cb(cf_ll_element* ele, void* udata);
 static void cleanup(void);
+static void create_profile_timer(thread_info* info);
+static void arm_profile_timer(const thread_info* info, uint32_t rate);
+static int32_t arm_profile_timer_cb(cf_ll_element* ele, void* udata);
+static void* run_profile_drain(void* udata);
+static void drain_profile_ring(void);
+static uint32_t profile_key_hash_fn(const void* key);
+static int print_profile_reduce_fn(const void* key, void* value, void* udata);
+static void append_symbol(cf_dyn_buf* db, const char* sym, void* addr);
+static int32_t sample_sched_cb(cf_ll_element* ele, void* udata);
+static bool read_sched_counters(pid_t sys_tid, sched_counters* counters);
 
 
 //==========================================================
@@ -136,6 +214,11 @@ cf_thread_init(void)
 	cf_queue_init(&g_thread_req_q, sizeof(thread_req), 8, true);
 
 	cf_ll_init(&g_thread_list, NULL, true);
+
+	// The first backtrace() may allocate - not allowed in a signal handler.
+	void* addrs[1];
+
+	backtrace(addrs, 1);
 }
 
 void
@@ -216,6 +299,61 @@ cf_thread_get_stats(cf_thread_stats* stats)
 	stats->n_pool_active = g_n_pool_active;
 }
 
+// Samples every registered thread's CPU time, run-queue wait and context
+// switches, and aggregates their increases since the previous call by role.
+void
+cf_thread_sample_stats(void)
+{
+	cf_mutex_lock(&g_sched_lock);
+
+	uint64_t now_ns = cf_getns();
+
+	g_sched_interval_ns = g_sched_sample_ns == 0 ? 0 : now_ns - g_sched_sample_ns;
+	g_sched_sample_ns = now_ns;
+	g_n_role_samples = 0;
+
+	cf_ll_reduce(&g_thread_list, true, sample_sched_cb, NULL);
+
+	cf_mutex_unlock(&g_sched_lock);
+}
+
+uint32_t
+cf_thread_get_role_stats(cf_thread_role_stats* stats, uint32_t max_stats)
+{
+	cf_mutex_lock(&g_sched_lock);
+
+	uint64_t interval_ns = g_sched_interval_ns;
+	uint32_t n_stats = interval_ns == 0 ? 0 : g_n_role_samples;
+
+	if (n_stats > max_stats) {
+		n_stats = max_stats;
+	}
+
+	for (uint32_t i = 0; i < n_stats; i++) {
+		const role_sample* sample = &g_role_samples[i];
+		cf_thread_role_stats* rs = &stats[i];
+		void* role = (void*)sample->role;
+		char** role_sym = backtrace_symbols(&role, 1);
+		cf_dyn_buf_define_size(db, sizeof(rs->name));
+
+		append_symbol(&db, role_sym == NULL ? NULL : role_sym[0], role);
+		free(role_sym);
+
+		snprintf(rs->name, sizeof(rs->name), "%.*s", (int)db.used_sz, db.buf);
+		cf_dyn_buf_free(&db);
+
+		rs->n_threads = sample->n_threads;
+		rs->cpu_pct = (uint32_t)(sample->delta.cpu_ns * 100 / interval_ns);
+		rs->wait_pct = (uint32_t)(sample->delta.wait_ns * 100 / interval_ns);
+		rs->vcsw_per_sec = sample->delta.n_vcsw * 1000000000 / interval_ns;
+		rs->ivcsw_per_sec = sample->delta.n_ivcsw * 1000000000 / interval_ns;
+	}
+
+	cf_mutex_unlock(&g_sched_lock);
+
+	return n_stats;
+}
+
 int32_t
 cf_thread_traces(char* key, cf_dyn_buf* db)
 {
@@ -254,6 +392,99 @@ cf_thread_traces_action(int32_t sig_num, siginfo_t* info, void* ctx)
 	g_traces_done++;
 }
 
+// Starts, re-rates or stops (rate 0) sampling of every registered thread's
+// stack, on its own CPU time - idle threads cost nothing.
+void
+cf_thread_profile_set_rate(uint32_t rate)
+{
+	cf_mutex_lock(&g_profile_lock);
+
+	if (rate != 0 && ! g_profile_started) {
+		g_profile_stacks = cf_shash_create(profile_key_hash_fn,
+				sizeof(profile_key), sizeof(uint64_t), 1024, true);
+		cf_thread_create_detached(run_profile_drain, NULL);
+		g_profile_started = true;
+	}
+
+	as_store_uint32(&g_profile_rate, rate);
+
+	cf_ll_reduce(&g_thread_list, true, arm_profile_timer_cb, &rate);
+
+	cf_mutex_unlock(&g_profile_lock);
+}
+
+// Folded stacks, as flame graph tools take them, separated by ',' - e.g.
+// "run_service;as_tsvc_process_transaction;...;as_index_get 17". Returns the
+// samples taken since the last call. Samples lost to a full ring or too many
+// distinct stacks show up as a "[dropped]" stack.
+int32_t
+cf_thread_profile(char* key, cf_dyn_buf* db)
+{
+	(void)key;
+
+	cf_mutex_lock(&g_profile_lock);
+
+	if (! g_profile_started) {
+		cf_mutex_unlock(&g_profile_lock);
+		cf_dyn_buf_append_string(db, "not-profiling");
+		return 0;
+	}
+
+	drain_profile_ring();
+	cf_shash_reduce(g_profile_stacks, print_profile_reduce_fn, db);
+
+	cf_mutex_unlock(&g_profile_lock);
+
+	uint64_t n_dropped = as_load_uint64(&g_profile_n_dropped);
+
+	if (n_dropped != 0) {
+		as_add_uint64(&g_profile_n_dropped, -(int64_t)n_dropped);
+		cf_dyn_buf_append_format(db, "[dropped] %lu,", n_dropped);
+	}
+
+	cf_dyn_buf_chomp_char(db, ',');
+
+	return 0;
+}
+
+// Must be async-signal-safe - no locks, no allocation.
+void
+cf_thread_profile_action(int32_t sig_num, siginfo_t* info, void* ctx)
+{
+	(void)sig_num;
+	(void)info;
+	(void)ctx;
+
+	thread_info* tinfo = g_thread_info;
+
+	if (tinfo == NULL) {
+		return;
+	}
+
+	profile_slot* slot = &g_profile_ring[as_faa_uint32(&g_profile_ring_ix, 1) %
+			PROFILE_RING_SZ];
+
+	if (! as_cas_uint32(&slot->state, PROFILE_SLOT_EMPTY, PROFILE_SLOT_BUSY)) {
+		as_incr_uint64(&g_profile_n_dropped);
+		return;
+	}
+
+	void* addrs[PROFILE_MAX_ADDRS + PROFILE_SKIP_ADDRS];
+	int32_t n_addrs = backtrace(addrs, PROFILE_MAX_ADDRS + PROFILE_SKIP_ADDRS);
+
+	memset(&slot->key, 0, sizeof(slot->key));
+	slot->key.role = tinfo->role;
+
+	if (n_addrs > PROFILE_SKIP_ADDRS) {
+		slot->key.n_addrs = (uint32_t)n_addrs - PROFILE_SKIP_ADDRS;
+		memcpy(slot->key.addrs, &addrs[PROFILE_SKIP_ADDRS],
+				sizeof(void*) * slot->key.n_addrs);
+	}
+
+	as_fence_rls();
+	as_store_uint32(&slot->state, PROFILE_SLOT_READY);
+}
+
 void
 cf_thread_realloc(void** pp, size_t* psz)
 {
@@ -331,7 +562,9 @@ run_pool(void* udata)
 
 		cf_queue_pop(&g_thread_req_q, &treq, CF_QUEUE_FOREVER);
 
+		g_thread_info->role = treq.run;
 		treq.run(treq.udata);
+		g_thread_info->role = run_pool;
 
 		cleanup();
 		as_decr_uint32(&g_n_pool_active);
@@ -347,6 +580,7 @@ make_thread_info(cf_thread_run_fn run, void* udata)
 
 	info->run = run;
 	info->udata = udata;
+	info->role = run;
 
 	return info;
 }
@@ -357,14 +591,25 @@ register_thread_info(void* udata)
 	g_thread_info = (thread_info*)udata;
 	g_thread_info->sys_tid = cf_thread_sys_tid();
 
+	create_profile_timer(g_thread_info);
+
 	cf_ll_append(&g_thread_list, &g_thread_info->link);
+
+	// After appending - a concurrent rate change either sees us or is seen.
+	arm_profile_timer(g_thread_info, as_load_uint32(&g_profile_rate));
 }
 
 static void
 deregister_thread_info(void)
 {
 	cf_ll_delete(&g_thread_list, &g_thread_info->link);
+
+	if (g_thread_info->has_profile_timer) {
+		timer_delete(g_thread_info->profile_timer);
+	}
+
 	cf_free(g_thread_info);
+	g_thread_info = NULL;
 }
 
 static void*
@@ -492,3 +737,261 @@ cleanup(void)
 		g_n_exits = 0;
 	}
 }
+
+
+
+//==========================================================
+// Local helpers - sampling profiler.
+//
+
+// Called on the thread itself - the clock is the calling thread's.
+static void
+create_profile_timer(thread_info* info)
+{
+	struct sigevent sev;
+
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify = SIGEV_THREAD_ID;
+	sev.sigev_signo = SIGPROF;
+	sev.sigev_notify_thread_id = info->sys_tid;
+
+	if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &info->profile_timer) < 0) {
+		cf_warning(CF_MISC, "failed to create profile timer for thread %d: %d (%s)",
+				info->sys_tid, errno, cf_strerror(errno));
+		return;
+	}
+
+	info->has_profile_timer = true;
+}
+
+static void
+arm_profile_timer(const thread_info* info, uint32_t rate)
+{
+	if (! info->has_profile_timer) {
+		return;
+	}
+
+	uint64_t period_ns = rate == 0 ? 0 : 1000000000UL / rate;
+
+	struct itimerspec its = {
+			.it_interval = {
+					.tv_sec = (time_t)(period_ns / 1000000000),
+					.tv_nsec = (long)(period_ns % 1000000000)
+			}
+	};
+
+	its.it_value = its.it_interval; // all zero disarms
+
+	timer_settime(info->profile_timer, 0, &its, NULL);
+}
+
+static int32_t
+arm_profile_timer_cb(cf_ll_element* ele, void* udata)
+{
+	arm_profile_timer((thread_info*)ele, *(uint32_t*)udata);
+
+	return 0;
+}
+
+static void*
+run_profile_drain(void* udata)
+{
+	(void)udata;
+
+	while (true) {
+		usleep(PROFILE_DRAIN_US);
+
+		cf_mutex_lock(&g_profile_lock);
+		drain_profile_ring();
+		cf_mutex_unlock(&g_profile_lock);
+	}
+
+	return NULL;
+}
+
+// Called with g_profile_lock held.
+static void
+drain_profile_ring(void)
+{
+	for (uint32_t i = 0; i < PROFILE_RING_SZ; i++) {
+		profile_slot* slot = &g_profile_ring[i];
+
+		if (as_load_uint32(&slot->state) != PROFILE_SLOT_READY) {
+			continue;
+		}
+
+		as_fence_acq();
+
+		uint64_t count = 0;
+
+		if (cf_shash_get(g_profile_stacks, &slot->key, &count) ==
+				CF_SHASH_OK ||
+				cf_shash_get_size(g_profile_stacks) < PROFILE_MAX_STACKS) {
+			count++;
+			cf_shash_put(g_profile_stacks, &slot->key, &count);
+		}
+		else {
+			as_incr_uint64(&g_profile_n_dropped);
+		}
+
+		as_store_uint32(&slot->state, PROFILE_SLOT_EMPTY);
+	}
+}
+
+static uint32_t
+profile_key_hash_fn(const void* key)
+{
+	const profile_key* pkey = (const profile_key*)key;
+	uint64_t h = (uint64_t)pkey->role;
+
+	for (uint32_t i = 0; i < pkey->n_addrs; i++) {
+		h = (h * 31) ^ (uint64_t)pkey->addrs[i];
+	}
+
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+// Called with g_profile_lock held - removes what it prints.
+static int
+print_profile_reduce_fn(const void* key, void* value, void* udata)
+{
+	const profile_key* pkey = (const profile_key*)key;
+	cf_dyn_buf* db = (cf_dyn_buf*)udata;
+	void* role = (void*)pkey->role;
+	char** role_sym = backtrace_symbols(&role, 1);
+
+	append_symbol(db, role_sym == NULL ? NULL : role_sym[0], role);
+	free(role_sym);
+
+	char** syms = backtrace_symbols(pkey->addrs, (int32_t)pkey->n_addrs);
+
+	// Outermost frame first.
+	for (uint32_t i = pkey->n_addrs; i > 0; i--) {
+		cf_dyn_buf_append_char(db, ';');
+		append_symbol(db, syms == NULL ? NULL : syms[i - 1],
+				pkey->addrs[i - 1]);
+	}
+
+	free(syms);
+
+	cf_dyn_buf_append_format(db, " %lu,", *(uint64_t*)value);
+
+	return CF_SHASH_REDUCE_DELETE;
+}
+
+// Symbols look like "path(function+0x1f) [0x...]" - keep just the function, or
+// the (ASLR-stripped) address if there isn't one.
+static void
+append_symbol(cf_dyn_buf* db, const char* sym, void* addr)
+{
+	const char* start = sym == NULL ? NULL : strchr(sym, '(');
+
+	if (start != NULL) {
+		start++;
+
+		size_t len = strcspn(start, "+)");
+
+		if (len != 0) {
+			cf_dyn_buf_append_buf(db, (const uint8_t*)start, len);
+			return;
+		}
+	}
+
+	cf_dyn_buf_append_format(db, "0x%lx", cf_log_strip_aslr(addr));
+}
+
+
+//==========================================================
+// Local helpers - scheduling stats.
+//
+
+// Called with g_sched_lock held. A thread's first sample only sets its
+// baseline. Pool threads count towards the role they're running now.
+static int32_t
+sample_sched_cb(cf_ll_element* ele, void* udata)
+{
+	(void)udata;
+
+	thread_info* info = (thread_info*)ele;
+	sched_counters now;
+
+	if (! read_sched_counters(info->sys_tid, &now)) {
+		return 0;
+	}
+
+	sched_counters prev = info->has_sched_prev ? info->sched_prev : now;
+
+	info->sched_prev = now;
+	info->has_sched_prev = true;
+
+	cf_thread_run_fn role = info->role;
+	role_sample* sample = NULL;
+
+	for (uint32_t i = 0; i < g_n_role_samples; i++) {
+		if (g_role_samples[i].role == role) {
+			sample = &g_role_samples[i];
+			break;
+		}
+	}
+
+	if (sample == NULL) {
+		if (g_n_role_samples == CF_THREAD_MAX_ROLES) {
+			return 0;
+		}
+
+		sample = &g_role_samples[g_n_role_samples++];
+		memset(sample, 0, sizeof(role_sample));
+		sample->role = role;
+	}
+
+	sample->n_threads++;
+	sample->delta.cpu_ns += now.cpu_ns - prev.cpu_ns;
+	sample->delta.wait_ns += now.wait_ns - prev.wait_ns;
+	sample->delta.n_vcsw += now.n_vcsw - prev.n_vcsw;
+	sample->delta.n_ivcsw += now.n_ivcsw - prev.n_ivcsw;
+
+	return 0;
+}
+
+static bool
+read_sched_counters(pid_t sys_tid, sched_counters* counters)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/schedstat", sys_tid);
+
+	FILE* fh = fopen(path, "r");
+
+	if (fh == NULL) {
+		return false; // thread just exited, or kernel without schedstat
+	}
+
+	int n_read = fscanf(fh, "%lu %lu", &counters->cpu_ns, &counters->wait_ns);
+
+	fclose(fh);
+
+	if (n_read != 2) {
+		return false;
+	}
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/status", sys_tid);
+	fh = fopen(path, "r");
+
+	if (fh == NULL) {
+		return false;
+	}
+
+	char line[256];
+
+	counters->n_vcsw = 0;
+	counters->n_ivcsw = 0;
+
+	while (fgets(line, sizeof(line), fh) != NULL) {
+		sscanf(line, "voluntary_ctxt_switches: %lu", &counters->n_vcsw);
+		sscanf(line, "nonvoluntary_ctxt_switches: %lu", &counters->n_ivcsw);
+	}
+
+	fclose(fh);
+
+	return true;
+}
@@ -0,0 +1,197 @@
+/*
+ * crc32c.c
+ *
+ * Copyright (C) 2020 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "crc32c.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define CRC32C_POLY 0x82F63B78 // reflected Castagnoli polynomial
+
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const uint8_t* buf, size_t size);
+
+
+//==========================================================
+// Globals.
+//
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+static crc32c_fn g_crc32c_fn;
+static uint32_t g_table[256];
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void crc32c_init(void);
+static uint32_t crc32c_sw(uint32_t crc, const uint8_t* buf, size_t size);
+
+
+//==========================================================
+// Public API.
+//
+
+uint32_t
+cf_crc32c(uint32_t crc, const void* buf, size_t size)
+{
+	pthread_once(&g_init_once, crc32c_init);
+
+	return ~g_crc32c_fn(~crc, (const uint8_t*)buf, size);
+}
+
+
+//==========================================================
+// Local helpers - hardware.
+//
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+static uint32_t
+crc32c_hw(uint32_t crc, const uint8_t* buf, size_t size)
+{
+	uint64_t crc64 = crc;
+
+	while (size >= sizeof(uint64_t)) {
+		uint64_t v;
+
+		memcpy(&v, buf, sizeof(v));
+		crc64 = _mm_crc32_u64(crc64, v);
+		buf += sizeof(v);
+		size -= sizeof(v);
+	}
+
+	crc = (uint32_t)crc64;
+
+	while (size-- != 0) {
+		crc = _mm_crc32_u8(crc, *buf++);
+	}
+
+	return crc;
+}
+
+static bool
+crc32c_hw_supported(void)
+{
+	__builtin_cpu_init();
+
+	return __builtin_cpu_supports("sse4.2") != 0;
+}
+
+#elif defined(__aarch64__)
+
+static uint32_t
+crc32c_hw(uint32_t crc, const uint8_t* buf, size_t size)
+{
+	while (size >= sizeof(uint64_t)) {
+		uint64_t v;
+
+		memcpy(&v, buf, sizeof(v));
+		__asm__(".arch_extension crc\n\tcrc32cx %w0, %w0, %x1"
+				: "+r" (crc) : "r" (v));
+		buf += sizeof(v);
+		size -= sizeof(v);
+	}
+
+	while (size-- != 0) {
+		uint32_t v = *buf++;
+
+		__asm__(".arch_extension crc\n\tcrc32cb %w0, %w0, %w1"
+				: "+r" (crc) : "r" (v));
+	}
+
+	return crc;
+}
+
+static bool
+crc32c_hw_supported(void)
+{
+	return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#else
+
+static bool
+crc32c_hw_supported(void)
+{
+	return false;
+}
+
+#endif
+
+
+//==========================================================
+// Local helpers - generic.
+//
+
+static void
+crc32c_init(void)
+{
+#if defined(__x86_64__) || defined(__aarch64__)
+	if (crc32c_hw_supported()) {
+		g_crc32c_fn = crc32c_hw;
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+
+		for (uint32_t k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+		}
+
+		g_table[i] = crc;
+	}
+
+	g_crc32c_fn = crc32c_sw;
+}
+
+static uint32_t
+crc32c_sw(uint32_t crc, const uint8_t* buf, size_t size)
+{
+	while (size-- != 0) {
+		crc = g_table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc;
+}
@@ -57,6 +57,12 @@ get_new_size(int alloc, int used, int requested)
 	}
 	else {
 		backoff = MAX_BACKOFF;
+
+		// Grow big buffers geometrically - multi-MB info responses would
+		// otherwise be copied over and over in fixed-size steps.
+		if (new_sz < (size_t)alloc + (size_t)alloc / 2) {
+			new_sz = (size_t)alloc + (size_t)alloc / 2;
+		}
 	}
 
 	return new_sz + (backoff - (new_sz % backoff));
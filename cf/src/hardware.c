@@ -42,6 +42,7 @@
 #include <unistd.h>
 
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
@@ -68,6 +69,11 @@
 
 #include "warnings.h"
 
+// Only available in Linux kernel version 3.8 and later.
+#if !defined MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << 26)
+#endif
+
 // Only available in Linux kernel version 3.19 and later; but we'd like to
 // allow compilation with older kernel headers.
 #if !defined SO_INCOMING_CPU
@@ -476,23 +482,13 @@ read_device_numbers(const char *path, uint32_t *major, uint32_t *minor)
 	return CF_OS_FILE_RES_OK;
 }
 
-static cf_os_file_res
-read_list(const char *path, cpu_set_t *mask)
+static bool
+parse_list(const char *buff, cpu_set_t *mask)
 {
-	cf_detail(CF_HARDWARE, "reading list from file %s", path);
-	char buff[1000];
-	size_t limit = sizeof(buff);
-	cf_os_file_res res = cf_os_read_file(path, buff, &limit);
-
-	if (res != CF_OS_FILE_RES_OK) {
-		return res;
-	}
-
-	buff[limit - 1] = '\0';
 	cf_detail(CF_HARDWARE, "parsing list \"%s\"", buff);
 
 	CPU_ZERO(mask);
-	char *walker = buff;
+	const char *walker = buff;
 
 	while (true) {
 		char *delim;
@@ -507,13 +503,11 @@ read_list(const char *path, cpu_set_t *mask)
 			thru = strtoul(walker, &delim, 10);
 		}
 		else {
-			cf_warning(CF_HARDWARE, "invalid list \"%s\" in %s", buff, path);
-			return CF_OS_FILE_RES_ERROR;
+			return false;
 		}
 
 		if (from >= CPU_SETSIZE || thru >= CPU_SETSIZE || from > thru) {
-			cf_warning(CF_HARDWARE, "invalid list \"%s\" in %s", buff, path);
-			return CF_OS_FILE_RES_ERROR;
+			return false;
 		}
 
 		cf_detail(CF_HARDWARE, "marking %d through %d", (int32_t)from, (int32_t)thru);
@@ -533,6 +527,28 @@ read_list(const char *path, cpu_set_t *mask)
 	mask_to_string(mask, buff2, sizeof(buff2));
 	cf_detail(CF_HARDWARE, "list \"%s\" -> mask %s", buff, buff2);
 
+	return true;
+}
+
+static cf_os_file_res
+read_list(const char *path, cpu_set_t *mask)
+{
+	cf_detail(CF_HARDWARE, "reading list from file %s", path);
+	char buff[1000];
+	size_t limit = sizeof(buff);
+	cf_os_file_res res = cf_os_read_file(path, buff, &limit);
+
+	if (res != CF_OS_FILE_RES_OK) {
+		return res;
+	}
+
+	buff[limit - 1] = '\0';
+
+	if (! parse_list(buff, mask)) {
+		cf_warning(CF_HARDWARE, "invalid list \"%s\" in %s", buff, path);
+		return CF_OS_FILE_RES_ERROR;
+	}
+
 	return CF_OS_FILE_RES_OK;
 }
 
@@ -984,6 +1000,41 @@ cf_topo_pin_to_cpu(cf_topo_cpu_index i_cpu)
 	pin_to_os_cpu(g_cpu_index_to_os_cpu_index[i_cpu]);
 }
 
+// Parses a kernel-style OS CPU list, e.g. "0-3,8".
+bool
+cf_topo_parse_os_cpu_list(const char *list, cpu_set_t *mask)
+{
+	return parse_list(list, mask) && CPU_COUNT(mask) != 0;
+}
+
+void
+cf_topo_pin_to_os_cpus(const cpu_set_t *mask)
+{
+	char buff[1000];
+	mask_to_string((cpu_set_t *)mask, buff, sizeof(buff));
+	cf_detail(CF_HARDWARE, "pinning to OS CPU mask %s", buff);
+
+	if (sched_setaffinity(0, sizeof(cpu_set_t), mask) < 0) {
+		cf_crash(CF_HARDWARE, "error while pinning thread to OS CPU mask %s: %d (%s)",
+				buff, errno, cf_strerror(errno));
+	}
+}
+
+bool
+cf_topo_pin_to_os_numa_node(cf_topo_numa_node_index i_os_numa_node)
+{
+	for (cf_topo_numa_node_index i = 0; i < g_n_numa_nodes; ++i) {
+		if (g_numa_node_index_to_os_numa_node_index[i] == i_os_numa_node) {
+			cf_detail(CF_HARDWARE, "pinning to OS NUMA node %hu", i_os_numa_node);
+			cf_topo_pin_to_os_cpus(&g_numa_node_os_cpus_online[i]);
+			return true;
+		}
+	}
+
+	cf_detail(CF_HARDWARE, "no online CPUs on OS NUMA node %hu", i_os_numa_node);
+	return false;
+}
+
 static check_proc_res
 check_proc(const char *name, int32_t argc, const char *argv[])
 {
@@ -1909,6 +1960,116 @@ cf_topo_force_map_memory(const uint8_t *from, size_t size)
 	}
 }
 
+// Pre-faulted anonymous mapping, preferring the given (OS) NUMA node. Tries
+// explicit huge pages, then transparent huge pages, if asked.
+void *
+cf_topo_alloc_local(size_t size, cf_topo_numa_node_index i_os_numa_node,
+		bool huge_pages)
+{
+	void *p = MAP_FAILED;
+
+	if (huge_pages) {
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+
+	if (p == MAP_FAILED) {
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (p == MAP_FAILED) {
+			cf_crash(CF_HARDWARE, "failed to map %zu bytes: %d (%s)", size,
+					errno, cf_strerror(errno));
+		}
+
+		if (huge_pages && madvise(p, size, MADV_HUGEPAGE) < 0) {
+			cf_detail(CF_HARDWARE, "madvise(MADV_HUGEPAGE) failed: %d (%s)",
+					errno, cf_strerror(errno));
+		}
+	}
+
+	if (i_os_numa_node < 64) {
+		uint64_t mask = 1UL << i_os_numa_node;
+
+		// Unlike select(), we have to pass "number of valid bits + 1".
+		if (syscall(__NR_mbind, p, size, MPOL_PREFERRED, &mask, 65, 0) < 0) {
+			cf_detail(CF_HARDWARE, "mbind() to NUMA node %hu failed: %d (%s)",
+					i_os_numa_node, errno, cf_strerror(errno));
+		}
+	}
+
+	// Fault everything in now, on the chosen node.
+	memset(p, 0, size);
+
+	return p;
+}
+
+void
+cf_topo_free_local(void *p, size_t size)
+{
+	munmap(p, size);
+}
+
+// Like cf_topo_alloc_local(), but fails gracefully, prefers 1G over 2M explicit
+// huge pages, and optionally interleaves pages across all NUMA nodes.
+void *
+cf_topo_try_alloc(size_t size, bool interleave, bool huge_pages, bool *hugetlb)
+{
+	void *p = MAP_FAILED;
+
+	*hugetlb = false;
+
+	if (huge_pages) {
+		if (size % (1UL << 30) == 0) {
+			p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_1GB,
+					-1, 0);
+		}
+
+		if (p == MAP_FAILED) {
+			p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		}
+
+		*hugetlb = p != MAP_FAILED;
+	}
+
+	if (p == MAP_FAILED) {
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (p == MAP_FAILED) {
+			return NULL;
+		}
+
+		if (huge_pages && madvise(p, size, MADV_HUGEPAGE) < 0) {
+			cf_detail(CF_HARDWARE, "madvise(MADV_HUGEPAGE) failed: %d (%s)",
+					errno, cf_strerror(errno));
+		}
+	}
+
+	// Pointless if we're pinned to a single NUMA node.
+	if (interleave && g_i_numa_node == INVALID_INDEX && g_n_numa_nodes > 1) {
+		uint64_t mask = 0;
+
+		for (cf_topo_numa_node_index i = 0; i < g_n_numa_nodes; i++) {
+			os_numa_node_index i_os = g_numa_node_index_to_os_numa_node_index[i];
+
+			if (i_os < 64) {
+				mask |= 1UL << i_os;
+			}
+		}
+
+		// Unlike select(), we have to pass "number of valid bits + 1".
+		if (syscall(__NR_mbind, p, size, MPOL_INTERLEAVE, &mask, 65, 0) < 0) {
+			cf_detail(CF_HARDWARE, "mbind() interleave failed: %d (%s)",
+					errno, cf_strerror(errno));
+		}
+	}
+
+	return p;
+}
+
 void
 cf_topo_migrate_memory(void)
 {
@@ -2401,6 +2562,25 @@ get_nvme_age(const char *dev_path)
 	return age;
 }
 
+static bool
+get_integrity(const char *sys_path)
+{
+	char sys_format[DEVICE_PATH_SIZE + 20];
+	snprintf(sys_format, sizeof(sys_format), "%s/integrity/format", sys_path);
+
+	char buff[100];
+	size_t limit = sizeof(buff);
+
+	if (cf_os_read_file(sys_format, buff, &limit) != CF_OS_FILE_RES_OK) {
+		return false;
+	}
+
+	buff[limit - 1] = '\0';
+	cf_detail(CF_HARDWARE, "integrity format \"%s\"", buff);
+
+	return strncmp(buff, "none", 4) != 0;
+}
+
 static void
 update_path_data(path_data_t *data)
 {
@@ -2453,6 +2633,7 @@ visit_children(path_data_t *data, dev_node_t *node)
 		info->phys[n_phys].dev_path = node->dev_path;
 		info->phys[n_phys].numa_node = get_numa_node(node->sys_home);
 		info->phys[n_phys].nvme_age = -1;
+		info->phys[n_phys].integrity = get_integrity(node->sys_home);
 
 		++info->n_phys;
 		return;
@@ -51,12 +51,32 @@
 #define N_BUCKETS (1 + 64)
 #define N_LATENCY_COLS (1 + 16)
 
+// Counts are sharded - threads are spread over shards so the hottest
+// histograms don't bounce one set of cache lines between all CPUs. Shards are
+// summed when read.
+#define N_SHARDS 8 // must be power of 2
+#define SHARD_STRIDE 80 // N_BUCKETS padded so shards don't share cache lines
+
+// HDR counts - latency histograms also count nanoseconds in log-linear
+// buckets, 2^(sub_bits - 1) per power of 2, for percentiles.
+#define MIN_SIGNIFICANT_DIGITS 1
+#define MAX_SIGNIFICANT_DIGITS 2
+
+#define N_PERCENTILES 5
+
 struct histogram_s {
 	char name[HISTOGRAM_NAME_SIZE];
 	histogram_scale scale;
 	const char* scale_tag;
 	uint32_t time_div;
-	uint64_t counts[N_BUCKETS];
+	uint64_t counts[N_SHARDS][SHARD_STRIDE];
+
+	// HDR related - latency histograms only.
+	uint32_t hdr_sub_bits;
+	uint32_t n_hdr_buckets;
+	uint64_t* hdr_counts; // N_SHARDS rows of n_hdr_buckets
+	uint64_t* hdr_prev; // summed counts at last dump
+	uint64_t* hdr_diff; // scratch for dump
 
 	// Size histogram related.
 	cf_mutex info_lock;
@@ -68,6 +88,7 @@ struct histogram_s {
 	uint64_t overs[N_LATENCY_COLS];
 	cf_mutex dump_lock;
 	char dump_output[150];
+	char pct_output[250];
 };
 
 #define HIST_TAG_MILLISECONDS	"msec"
@@ -91,6 +112,22 @@ static const char* SNAPSHOT_TAGS[] = {
 
 COMPILER_ASSERT(sizeof(SNAPSHOT_TAGS) / sizeof(const char*) == N_BUCKETS + 1);
 
+static const double PERCENTILES[N_PERCENTILES] = {
+		50.0, 90.0, 99.0, 99.9, 99.99
+};
+
+static const char* PERCENTILE_TAGS[N_PERCENTILES] = {
+		"p50", "p90", "p99", "p99.9", "p99.99"
+};
+
+// sub_bits is the smallest n with 2^n >= 2 * 10^digits - as for HdrHistogram.
+static const uint32_t SUB_BITS[MAX_SIGNIFICANT_DIGITS + 1] = { 0, 5, 8 };
+
+static uint32_t g_hdr_sub_bits = 5;
+
+static uint32_t g_next_shard = 0;
+static __thread uint32_t g_shard = N_SHARDS; // N_SHARDS means not yet assigned
+
 //------------------------------------------------
 // BYTE_MSB[n] returns the position of the most
 // significant bit. If no bits are set (n = 0) it
@@ -123,6 +160,13 @@ static const char BYTE_MSB[] = {
 };
 
 
+//==========================================================
+// Forward declarations.
+//
+
+static void dump_percentiles(histogram* h, double tps);
+
+
 //==========================================================
 // Inlines & macros.
 //
@@ -162,6 +206,74 @@ msb(uint64_t n)
 	return -1;
 }
 
+//------------------------------------------------
+// Shard for the calling thread - assigned round-
+// robin on the thread's first insert.
+//
+static inline uint32_t
+thread_shard(void)
+{
+	if (g_shard == N_SHARDS) {
+		g_shard = as_faa_uint32(&g_next_shard, 1) & (N_SHARDS - 1);
+	}
+
+	return g_shard;
+}
+
+//------------------------------------------------
+// HDR bucket index. Values below 2^sub_bits get
+// their own bucket. Above that, each power of 2
+// is split into 2^(sub_bits - 1) equal buckets.
+//
+static inline uint32_t
+hdr_index(uint32_t sub_bits, uint64_t value)
+{
+	if (value < (1UL << sub_bits)) {
+		return (uint32_t)value;
+	}
+
+	uint32_t shift = (uint32_t)msb(value) - sub_bits;
+
+	return (shift << (sub_bits - 1)) + (uint32_t)(value >> shift);
+}
+
+//------------------------------------------------
+// Highest value that maps to an HDR bucket.
+//
+static inline uint64_t
+hdr_bucket_max(uint32_t sub_bits, uint32_t ix)
+{
+	if (ix < (1U << sub_bits)) {
+		return ix;
+	}
+
+	uint32_t shift = (ix >> (sub_bits - 1)) - 1;
+	uint64_t top = ix - (shift << (sub_bits - 1));
+
+	return (top << shift) + ((1UL << shift) - 1);
+}
+
+static inline uint32_t
+hdr_n_buckets(uint32_t sub_bits)
+{
+	return (66 - sub_bits) << (sub_bits - 1);
+}
+
+//------------------------------------------------
+// Sum the shards.
+//
+static inline uint64_t
+sum_counts(const histogram* h, uint32_t b)
+{
+	uint64_t count = 0;
+
+	for (uint32_t s = 0; s < N_SHARDS; s++) {
+		count += as_load_uint64(&h->counts[s][b]);
+	}
+
+	return count;
+}
+
 //------------------------------------------------
 // Add a final semicolon and null-terminate.
 //
@@ -178,8 +290,22 @@ append_semicolon(char* out)
 //
 
 //------------------------------------------------
-// Create a histogram. There's no destroy(), but
-// you can just cf_free() the histogram.
+// Set HDR precision for latency histograms
+// created after this call.
+//
+void
+histogram_set_significant_digits(uint32_t digits)
+{
+	cf_assert(digits >= MIN_SIGNIFICANT_DIGITS &&
+			digits <= MAX_SIGNIFICANT_DIGITS, AS_INFO,
+			"bad significant digits %u", digits);
+
+	g_hdr_sub_bits = SUB_BITS[digits];
+}
+
+//------------------------------------------------
+// Create a histogram. There's no destroy() - size
+// and count histograms can just be cf_free()'d.
 //
 histogram*
 histogram_create(const char* name, histogram_scale scale)
@@ -222,6 +348,24 @@ histogram_create(const char* name, histogram_scale scale)
 
 	memset((void*)h->counts, 0, sizeof(h->counts));
 
+	if (h->time_div != 0) {
+		h->hdr_sub_bits = g_hdr_sub_bits;
+		h->n_hdr_buckets = hdr_n_buckets(h->hdr_sub_bits);
+
+		size_t sz = sizeof(uint64_t) * h->n_hdr_buckets;
+
+		h->hdr_counts = cf_calloc(N_SHARDS, sz);
+		h->hdr_prev = cf_calloc(1, sz);
+		h->hdr_diff = cf_malloc(sz);
+	}
+	else {
+		h->hdr_sub_bits = 0;
+		h->n_hdr_buckets = 0;
+		h->hdr_counts = NULL;
+		h->hdr_prev = NULL;
+		h->hdr_diff = NULL;
+	}
+
 	cf_mutex_init(&h->info_lock);
 	h->info_snapshot = NULL;
 
@@ -230,6 +374,7 @@ histogram_create(const char* name, histogram_scale scale)
 	memset((void*)h->overs, 0, sizeof(h->overs));
 	cf_mutex_init(&h->dump_lock);
 	append_semicolon(h->dump_output);
+	append_semicolon(h->pct_output);
 
 	return h;
 }
@@ -242,6 +387,13 @@ histogram_clear(histogram* h)
 {
 	memset((void*)h->counts, 0, sizeof(h->counts));
 
+	if (h->hdr_counts != NULL) {
+		size_t sz = sizeof(uint64_t) * h->n_hdr_buckets;
+
+		memset((void*)h->hdr_counts, 0, N_SHARDS * sz);
+		memset((void*)h->hdr_prev, 0, sz);
+	}
+
 	// We don't want/need to do anything with a saved snapshot.
 
 	h->timestamp = 0;
@@ -251,6 +403,7 @@ histogram_clear(histogram* h)
 	cf_mutex_lock(&h->dump_lock);
 
 	append_semicolon(h->dump_output);
+	append_semicolon(h->pct_output);
 
 	cf_mutex_unlock(&h->dump_lock);
 }
@@ -297,7 +450,7 @@ histogram_dump(histogram* h)
 	uint64_t subtotals[N_BUCKETS];
 
 	for (uint32_t b = 0; b < N_BUCKETS; b++) {
-		counts[b] = as_load_uint64(&h->counts[b]);
+		counts[b] = sum_counts(h, b);
 
 		if (counts[b] != 0) {
 			if (i > b) {
@@ -386,6 +539,8 @@ histogram_dump(histogram* h)
 
 	append_semicolon(out);
 
+	dump_percentiles(h, tps);
+
 	cf_mutex_unlock(&h->dump_lock);
 
 	// Store for next time.
@@ -441,7 +596,15 @@ histogram_insert_data_point(histogram* h, uint64_t start_ns)
 		}
 	}
 
-	as_incr_uint64(&h->counts[bucket]);
+	uint32_t shard = thread_shard();
+
+	as_incr_uint64(&h->counts[shard][bucket]);
+
+	// Clock went backwards - count as 0 like the bucket above.
+	uint64_t delta_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+
+	as_incr_uint64(&h->hdr_counts[(shard * h->n_hdr_buckets) +
+			hdr_index(h->hdr_sub_bits, delta_ns)]);
 
 	return end_ns;
 }
@@ -462,7 +625,7 @@ histogram_insert_data_point(histogram* h, uint64_t start_ns)
 void
 histogram_insert_raw(histogram* h, uint64_t value)
 {
-	as_incr_uint64(&h->counts[msb(value)]);
+	as_incr_uint64(&h->counts[thread_shard()][msb(value)]);
 }
 
 //------------------------------------------------
@@ -471,7 +634,38 @@ histogram_insert_raw(histogram* h, uint64_t value)
 void
 histogram_insert_raw_unsafe(histogram* h, uint64_t value)
 {
-	h->counts[msb(value)]++;
+	h->counts[0][msb(value)]++;
+}
+
+//------------------------------------------------
+// Get cumulative counts of all data points, and of
+// those at or above the specified latency, rounded
+// down to a bucket edge. For time-scaled
+// histograms only. Thread safe, but the counts may
+// be slightly inconsistent.
+//
+void
+histogram_get_counts_over_us(histogram* h, uint64_t us, uint64_t* p_total,
+		uint64_t* p_over)
+{
+	uint64_t value = (us * 1000) / h->time_div;
+	int first_over = value == 0 ? 0 : msb(value);
+
+	uint64_t total = 0;
+	uint64_t over = 0;
+
+	for (uint32_t b = 0; b < N_BUCKETS; b++) {
+		uint64_t count = sum_counts(h, b);
+
+		total += count;
+
+		if ((int)b >= first_over) {
+			over += count;
+		}
+	}
+
+	*p_total = total;
+	*p_over = over;
 }
 
 //------------------------------------------------
@@ -492,7 +686,7 @@ histogram_save_info(histogram* h)
 	char* at = h->info_snapshot + prefix_len;
 
 	for (uint32_t b = 0; b < N_BUCKETS; b++) {
-		uint64_t count = h->counts[b];
+		uint64_t count = sum_counts(h, b);
 
 		if (count != 0) {
 			at += sprintf(at, ":[%s-%s)=%lu", SNAPSHOT_TAGS[b],
@@ -518,17 +712,83 @@ histogram_get_info(histogram* h, cf_dyn_buf* db)
 }
 
 //------------------------------------------------
-// Retrieve threshold info for one time-slice.
+// Retrieve threshold info, or percentiles, for
+// one time-slice.
 //
 void
-histogram_get_latencies(histogram* h, cf_dyn_buf* db)
+histogram_get_latencies(histogram* h, bool percentiles, cf_dyn_buf* db)
 {
 	cf_dyn_buf_append_string(db, h->name);
 	cf_dyn_buf_append_char(db, ':');
 
 	cf_mutex_lock(&h->dump_lock);
 
-	cf_dyn_buf_append_string(db, h->dump_output);
+	cf_dyn_buf_append_string(db, percentiles ? h->pct_output : h->dump_output);
 
 	cf_mutex_unlock(&h->dump_lock);
 }
+
+
+//==========================================================
+// Local helpers.
+//
+
+//------------------------------------------------
+// Generate percentiles for the time-slice since
+// the last dump. Call with dump_lock held. Each
+// percentile is reported as the highest value in
+// its HDR bucket, in the histogram's units.
+//
+static void
+dump_percentiles(histogram* h, double tps)
+{
+	uint32_t n_buckets = h->n_hdr_buckets;
+	uint64_t diff_total = 0;
+
+	for (uint32_t b = 0; b < n_buckets; b++) {
+		uint64_t count = 0;
+
+		for (uint32_t s = 0; s < N_SHARDS; s++) {
+			count += as_load_uint64(&h->hdr_counts[(s * n_buckets) + b]);
+		}
+
+		h->hdr_diff[b] = count - h->hdr_prev[b];
+		h->hdr_prev[b] = count;
+		diff_total += h->hdr_diff[b];
+	}
+
+	char* out = h->pct_output;
+
+	if (h->timestamp == 0) {
+		append_semicolon(out);
+		return;
+	}
+
+	out += sprintf(out, "%s,%.1f", h->scale_tag, tps);
+
+	uint64_t cum = 0;
+	uint32_t b = 0;
+
+	for (uint32_t p = 0; p < N_PERCENTILES; p++) {
+		// Rank of the data point at this percentile, 1-based.
+		uint64_t rank = (uint64_t)((PERCENTILES[p] * (double)diff_total) /
+				100.0 + 0.999999);
+
+		if (rank == 0) {
+			rank = 1;
+		}
+
+		while (b < n_buckets && cum + h->hdr_diff[b] < rank) {
+			cum += h->hdr_diff[b];
+			b++;
+		}
+
+		double value = diff_total == 0 || b == n_buckets ? 0.0 :
+				(double)hdr_bucket_max(h->hdr_sub_bits, b) /
+						(double)h->time_div;
+
+		out += sprintf(out, ",%s=%.3f", PERCENTILE_TAGS[p], value);
+	}
+
+	append_semicolon(out);
+}
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 
 #include "cf_mutex.h"
@@ -65,6 +66,28 @@ struct linear_hist_s {
 #define PREFIX_SIZE (5 + 1 + 5 + 1 + 10 + 1 + 10 + 1 + 12 + 1 + 10 + 1 + 7 + 1)
 
 
+//==========================================================
+// Inlines & macros.
+//
+
+static inline uint32_t
+get_bucket(const linear_hist *h, uint32_t point)
+{
+	int32_t offset = (int32_t)(point - h->start);
+	int32_t bucket = 0;
+
+	if (offset > 0) {
+		bucket = offset / h->bucket_width;
+
+		if (bucket >= (int32_t)h->num_buckets) {
+			bucket = h->num_buckets - 1;
+		}
+	}
+
+	return (uint32_t)bucket;
+}
+
+
 //==========================================================
 // Public API.
 //
@@ -196,18 +219,27 @@ linear_hist_merge(linear_hist *h1, linear_hist *h2)
 void
 linear_hist_insert_data_point(linear_hist *h, uint32_t point)
 {
-	int32_t offset = (int32_t)(point - h->start);
-	int32_t bucket = 0;
-
-	if (offset > 0) {
-		bucket = offset / h->bucket_width;
+	h->counts[get_bucket(h, point)]++;
+}
 
-		if (bucket >= (int32_t)h->num_buckets) {
-			bucket = h->num_buckets - 1;
-		}
-	}
+//------------------------------------------------
+// As above, but safe for concurrent inserters.
+// Still not safe against concurrent clear/reset.
+//
+void
+linear_hist_insert_data_point_safe(linear_hist *h, uint32_t point)
+{
+	as_incr_uint64(&h->counts[get_bucket(h, point)]);
+}
 
-	h->counts[bucket]++;
+//------------------------------------------------
+// Remove a data point previously inserted with
+// linear_hist_insert_data_point_safe().
+//
+void
+linear_hist_remove_data_point_safe(linear_hist *h, uint32_t point)
+{
+	as_decr_uint64(&h->counts[get_bucket(h, point)]);
 }
 
 //------------------------------------------------
@@ -40,11 +40,14 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "aerospike/as_atomic.h"
 #include "aerospike/as_log.h"
 #include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
 #include "citrusleaf/cf_digest.h"
 
 #include "cf_mutex.h"
+#include "cf_thread.h"
 #include "os.h"
 #include "shash.h"
 
@@ -159,6 +162,35 @@ typedef struct cf_log_cache_hkey_s {
 
 #define MAX_BACKTRACE_DEPTH 50
 
+// Async logging - each thread queues formatted lines in its own ring, which
+// only it writes and only the drainer (holding g_drain_lock) reads.
+#define RING_SZ (32 * 1024) // must be power of 2
+#define REC_PAD_LEN UINT32_MAX // marks skipped space at end of ring
+
+typedef struct log_rec_hdr_s {
+	uint32_t len; // of line, not including header or alignment
+	uint32_t sink_mask;
+} log_rec_hdr;
+
+typedef struct log_ring_s {
+	struct log_ring_s* next; // list of rings is protected by g_drain_lock
+	uint32_t orphaned; // thread exited - free when drained
+	uint8_t pad0[52];
+
+	uint64_t write_pos; // only the owner thread writes
+	uint8_t pad1[56];
+
+	uint64_t read_pos; // only the drainer writes
+	uint8_t pad2[56];
+
+	uint8_t buf[RING_SZ];
+} log_ring;
+
+#define BATCH_SZ (16 * 1024) // per sink, per drain
+#define WRITER_IDLE_US 1000
+#define DROPPED_REPORT_MS 1000
+#define STOP_ASYNC_TRIES 100 // ms to wait for drainer when stopping
+
 extern char __executable_start;
 extern char __etext;
 
@@ -177,6 +209,19 @@ static bool g_sinks_activated = false;
 static uint32_t g_n_sinks = 0;
 static cf_log_sink g_sinks[MAX_SINKS];
 
+static uint32_t g_async_running = 0;
+static uint32_t g_rotate_pending = 0;
+static uint64_t g_n_dropped = 0;
+static cf_mutex g_drain_lock = CF_MUTEX_INIT;
+static log_ring* g_rings = NULL;
+static __thread log_ring* g_ring = NULL;
+static __thread bool g_ring_retired = false;
+static __thread bool g_in_push = false; // signal handlers may log mid-push
+
+// Only used by drainer.
+static char g_batches[MAX_SINKS][BATCH_SZ];
+static uint32_t g_batch_szs[MAX_SINKS];
+
 
 //==========================================================
 // Forward declarations.
@@ -188,9 +233,20 @@ static bool get_context(const char* context_str, cf_log_context* context);
 static bool get_level(const char* level_str, cf_log_level* level);
 static void update_most_verbose_level(cf_log_context context);
 static void log_write(cf_log_context context, cf_log_level level, const char* file_name, int line, const char* format, va_list argp);
+static void write_sinks(uint32_t sink_mask, const char* buf, size_t sz);
 static int sprintf_now(char* buf);
 static int cache_reduce_fn(const void* key, void* data, void* udata);
 
+static bool ring_push(const char* buf, uint32_t len, uint32_t sink_mask);
+static bool ring_enqueue(const char* buf, uint32_t len, uint32_t sink_mask);
+static void ring_exit_cb(void* udata);
+static void* run_writer(void* udata);
+static bool drain_rings(void);
+static bool drain_ring(log_ring* ring);
+static void batch_append(uint32_t i, const uint8_t* line, uint32_t len);
+static void batch_flush(uint32_t i);
+static void rotate_sinks(void);
+
 static void register_custom_conversions(void);
 static int digest_fn(FILE* stream, const struct printf_info* info, const void* const* args);
 static int digest_arginfo_fn(const struct printf_info* info, size_t n, int* argtypes, int* size);
@@ -462,30 +518,54 @@ cf_log_check_level(cf_log_context context, cf_log_level level)
 void
 cf_log_rotate(void)
 {
-	fprintf(stderr, "rotating log files\n");
-
-	for (uint32_t i = 0; i < g_n_sinks; i++) {
-		cf_log_sink* sink = &g_sinks[i];
+	if (as_load_uint32(&g_async_running) != 0) {
+		// We may be in a signal handler on the writer thread - let the writer
+		// reopen files between drains.
+		as_store_uint32(&g_rotate_pending, 1);
+		return;
+	}
 
-		if (sink->path == NULL) {
-			continue;
-		}
+	rotate_sinks();
+}
 
-		static cf_mutex lock = CF_MUTEX_INIT;
+// Start the background writer - call after daemonizing, since fork() doesn't
+// carry threads. Before this, lines are written synchronously.
+void
+cf_log_start_async(void)
+{
+	cf_thread_create_detached(run_writer, NULL);
 
-		cf_mutex_lock(&lock); // so concurrent SIGHUPs can't double-close
+	as_store_uint32(&g_async_running, 1);
+}
 
-		int old_fd = sink->fd;
+// Flush queued lines and write synchronously from now on. Used for fatal
+// errors and shutdown, so doesn't wait forever for a stuck drainer.
+void
+cf_log_stop_async(void)
+{
+	if (as_load_uint32(&g_async_running) == 0) {
+		return;
+	}
 
-		sink->fd = open(sink->path, CF_LOG_OPEN_FLAGS, cf_os_log_perms());
+	as_store_uint32(&g_async_running, 0);
 
-		usleep(1000); // threads may be interrupted while writing to old fd
-		close(old_fd);
+	for (uint32_t i = 0; i < STOP_ASYNC_TRIES; i++) {
+		if (cf_mutex_trylock(&g_drain_lock)) {
+			drain_rings();
+			cf_mutex_unlock(&g_drain_lock);
+			return;
+		}
 
-		cf_mutex_unlock(&lock);
+		usleep(1000);
 	}
 }
 
+uint64_t
+cf_log_n_dropped(void)
+{
+	return as_load_uint64(&g_n_dropped);
+}
+
 
 //==========================================================
 // Public API - write to log.
@@ -586,6 +666,9 @@ cf_log_dump_cache(void)
 void
 cf_log_stack_trace(void* ctx)
 {
+	// We're about to die - don't leave anything queued.
+	cf_log_stop_async();
+
 	ucontext_t* uc = (ucontext_t*)ctx;
 	mcontext_t* mc = (mcontext_t*)&uc->uc_mcontext;
 	uint64_t* gregs = (uint64_t*)&mc->gregs[0];
@@ -733,14 +816,33 @@ log_write(cf_log_context context, cf_log_level level, const char* file_name,
 		return;
 	}
 
-	for (uint32_t i = 0; i < g_n_sinks; i++) {
-		cf_log_sink* sink = &g_sinks[i];
+	uint32_t sink_mask = 0;
 
-		if (level > sink->levels[context]) {
-			continue;
+	for (uint32_t i = 0; i < g_n_sinks; i++) {
+		if (level <= g_sinks[i].levels[context]) {
+			sink_mask |= 1U << i;
 		}
+	}
+
+	if (level == CF_CRITICAL) {
+		// We may be about to die - flush queued lines and write this directly.
+		cf_log_stop_async();
+	}
+	else if (as_load_uint32(&g_async_running) != 0 &&
+			ring_push(buf, (uint32_t)pos, sink_mask)) {
+		return;
+	}
 
-		write_all(sink->fd, buf, (size_t)pos);
+	write_sinks(sink_mask, buf, (size_t)pos);
+}
+
+static void
+write_sinks(uint32_t sink_mask, const char* buf, size_t sz)
+{
+	for (uint32_t i = 0; i < g_n_sinks; i++) {
+		if ((sink_mask & (1U << i)) != 0) {
+			write_all(g_sinks[i].fd, buf, sz);
+		}
 	}
 }
 
@@ -810,6 +912,265 @@ cache_reduce_fn(const void* key, void* data, void* udata)
 }
 
 
+//==========================================================
+// Local helpers - async logging.
+//
+
+// Returns false if the caller must write synchronously. A full ring drops the
+// line - a slow disk must not stall service threads.
+static bool
+ring_push(const char* buf, uint32_t len, uint32_t sink_mask)
+{
+	if (g_in_push) {
+		return false;
+	}
+
+	g_in_push = true;
+
+	bool rv = ring_enqueue(buf, len, sink_mask);
+
+	g_in_push = false;
+
+	return rv;
+}
+
+static bool
+ring_enqueue(const char* buf, uint32_t len, uint32_t sink_mask)
+{
+	log_ring* ring = g_ring;
+
+	if (ring == NULL) {
+		if (g_ring_retired) {
+			return false;
+		}
+
+		ring = cf_malloc(sizeof(log_ring));
+
+		ring->orphaned = 0;
+		ring->write_pos = 0;
+		ring->read_pos = 0;
+
+		cf_mutex_lock(&g_drain_lock);
+
+		ring->next = g_rings;
+		g_rings = ring;
+
+		cf_mutex_unlock(&g_drain_lock);
+
+		g_ring = ring;
+		cf_thread_add_exit(ring_exit_cb, ring);
+	}
+
+	uint32_t rec_sz = (uint32_t)sizeof(log_rec_hdr) + ((len + 7) & ~7U);
+	uint64_t write_pos = ring->write_pos;
+	uint32_t offset = (uint32_t)(write_pos & (RING_SZ - 1));
+	uint32_t tail_sz = RING_SZ - offset;
+	uint32_t need_sz = rec_sz > tail_sz ? tail_sz + rec_sz : rec_sz;
+
+	if (write_pos + need_sz - as_load_uint64(&ring->read_pos) > RING_SZ) {
+		as_incr_uint64(&g_n_dropped);
+		return true;
+	}
+
+	if (rec_sz > tail_sz) {
+		// Skip the end of the ring - records are contiguous.
+		((log_rec_hdr*)(ring->buf + offset))->len = REC_PAD_LEN;
+		write_pos += tail_sz;
+		offset = 0;
+	}
+
+	log_rec_hdr* hdr = (log_rec_hdr*)(ring->buf + offset);
+
+	hdr->len = len;
+	hdr->sink_mask = sink_mask;
+	memcpy(hdr + 1, buf, len);
+
+	as_fence_rls();
+	as_store_uint64(&ring->write_pos, write_pos + rec_sz);
+
+	return true;
+}
+
+static void
+ring_exit_cb(void* udata)
+{
+	log_ring* ring = (log_ring*)udata;
+
+	// Later exit callbacks may still log - they'll write synchronously.
+	g_ring = NULL;
+	g_ring_retired = true;
+
+	as_fence_rls();
+	as_store_uint32(&ring->orphaned, 1);
+}
+
+static void*
+run_writer(void* udata)
+{
+	(void)udata;
+
+	// Write our own lines synchronously - a signal handler logging on this
+	// thread mustn't queue while we hold g_drain_lock.
+	g_ring_retired = true;
+
+	uint64_t last_dropped = 0;
+	uint64_t last_report_ms = 0;
+
+	while (true) {
+		if (as_load_uint32(&g_rotate_pending) != 0) {
+			as_store_uint32(&g_rotate_pending, 0);
+
+			cf_mutex_lock(&g_drain_lock);
+			rotate_sinks();
+			cf_mutex_unlock(&g_drain_lock);
+		}
+
+		cf_mutex_lock(&g_drain_lock);
+
+		bool drained = drain_rings();
+
+		cf_mutex_unlock(&g_drain_lock);
+
+		uint64_t n_dropped = as_load_uint64(&g_n_dropped);
+		uint64_t now_ms = cf_getms();
+
+		if (n_dropped != last_dropped &&
+				now_ms - last_report_ms >= DROPPED_REPORT_MS) {
+			cf_warning(CF_MISC, "log rings full - dropped %lu lines",
+					n_dropped - last_dropped);
+
+			last_dropped = n_dropped;
+			last_report_ms = now_ms;
+		}
+
+		if (! drained) {
+			usleep(WRITER_IDLE_US);
+		}
+	}
+
+	return NULL;
+}
+
+// Call with g_drain_lock held. Returns true if anything was written.
+static bool
+drain_rings(void)
+{
+	bool drained = false;
+	log_ring** p_ring = &g_rings;
+
+	while (*p_ring != NULL) {
+		log_ring* ring = *p_ring;
+
+		// Check before draining - an orphan's final lines are then visible.
+		bool orphaned = as_load_uint32(&ring->orphaned) != 0;
+
+		as_fence_acq();
+
+		if (drain_ring(ring)) {
+			drained = true;
+		}
+
+		if (orphaned) {
+			*p_ring = ring->next;
+			cf_free(ring);
+			continue;
+		}
+
+		p_ring = &ring->next;
+	}
+
+	for (uint32_t i = 0; i < g_n_sinks; i++) {
+		batch_flush(i);
+	}
+
+	return drained;
+}
+
+static bool
+drain_ring(log_ring* ring)
+{
+	uint64_t read_pos = ring->read_pos;
+	uint64_t write_pos = as_load_uint64(&ring->write_pos);
+
+	if (read_pos == write_pos) {
+		return false;
+	}
+
+	as_fence_acq();
+
+	while (read_pos != write_pos) {
+		uint32_t offset = (uint32_t)(read_pos & (RING_SZ - 1));
+		const log_rec_hdr* hdr = (const log_rec_hdr*)(ring->buf + offset);
+
+		if (hdr->len == REC_PAD_LEN) {
+			read_pos += RING_SZ - offset;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < g_n_sinks; i++) {
+			if ((hdr->sink_mask & (1U << i)) != 0) {
+				batch_append(i, (const uint8_t*)(hdr + 1), hdr->len);
+			}
+		}
+
+		read_pos += sizeof(log_rec_hdr) + ((hdr->len + 7) & ~7U);
+	}
+
+	// Release the space - the batch copies are what get written.
+	as_fence_rls();
+	as_store_uint64(&ring->read_pos, read_pos);
+
+	return true;
+}
+
+static void
+batch_append(uint32_t i, const uint8_t* line, uint32_t len)
+{
+	if (g_batch_szs[i] + len > BATCH_SZ) {
+		batch_flush(i);
+	}
+
+	memcpy(g_batches[i] + g_batch_szs[i], line, len);
+	g_batch_szs[i] += len;
+}
+
+static void
+batch_flush(uint32_t i)
+{
+	if (g_batch_szs[i] != 0) {
+		write_all(g_sinks[i].fd, g_batches[i], g_batch_szs[i]);
+		g_batch_szs[i] = 0;
+	}
+}
+
+static void
+rotate_sinks(void)
+{
+	fprintf(stderr, "rotating log files\n");
+
+	for (uint32_t i = 0; i < g_n_sinks; i++) {
+		cf_log_sink* sink = &g_sinks[i];
+
+		if (sink->path == NULL) {
+			continue;
+		}
+
+		static cf_mutex lock = CF_MUTEX_INIT;
+
+		cf_mutex_lock(&lock); // so concurrent SIGHUPs can't double-close
+
+		int old_fd = sink->fd;
+
+		sink->fd = open(sink->path, CF_LOG_OPEN_FLAGS, cf_os_log_perms());
+
+		usleep(1000); // threads may be interrupted while writing to old fd
+		close(old_fd);
+
+		cf_mutex_unlock(&lock);
+	}
+}
+
+
 //==========================================================
 // Local helpers - custom conversions.
 //
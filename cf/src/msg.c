@@ -42,6 +42,7 @@
 #include "dynbuf.h"
 #include "log.h"
 #include "msgpack_in.h"
+#include "slab.h"
 #include "vector.h"
 
 
@@ -53,6 +54,7 @@ typedef struct msg_type_entry_s {
 	const msg_template *mt;
 	uint16_t entry_count;
 	uint32_t scratch_sz;
+	cf_slab *slab;
 } msg_type_entry;
 
 // msg field header on wire.
@@ -152,6 +154,15 @@ msg_type_register(msg_type type, const msg_template *mt, size_t mt_sz,
 
 	mte->mt = table;
 	mte->scratch_sz = (uint32_t)scratch_sz;
+
+	// Msgs of a type are all the same size - destroyed msgs are cached (per
+	// thread, then shared) to skip the allocator on the transaction hot path.
+	char slab_name[CF_SLAB_NAME_SZ];
+
+	sprintf(slab_name, "msg-type-%u", type);
+
+	mte->slab = cf_slab_create_rc(sizeof(msg) +
+			(sizeof(msg_field) * mte->entry_count) + scratch_sz, slab_name);
 }
 
 bool
@@ -169,7 +180,7 @@ msg_create(msg_type type)
 	uint16_t mt_count = mte->entry_count;
 	size_t u_sz = sizeof(msg) + (sizeof(msg_field) * mt_count);
 	size_t a_sz = u_sz + (size_t)mte->scratch_sz;
-	msg *m = cf_rc_alloc(a_sz);
+	msg *m = cf_slab_rc_alloc(mte->slab);
 
 	m->n_fields = mt_count;
 	m->bytes_used = (uint32_t)u_sz;
@@ -188,6 +199,12 @@ msg_create(msg_type type)
 	return m;
 }
 
+void
+msg_put(msg *m)
+{
+	cf_slab_rc_free(g_mte[m->type].slab, m);
+}
+
 void
 msg_destroy(msg *m)
 {
@@ -238,6 +255,35 @@ msg_get_template_fixed_sz(const msg_template *mt, size_t mt_count)
 	return sz;
 }
 
+// Returns the buf_sz msg_to_iov_buf() needs, and its maximum iovec count.
+size_t
+msg_get_iov_buf_sz(const msg *m, size_t *max_iov_r)
+{
+	uint32_t int_fields = 0;
+	uint32_t set_fields = 0;
+
+	for (uint16_t i = 0; i < m->n_fields; i++) {
+		const msg_field *mf = &m->f[i];
+
+		if (mf->is_set) {
+			set_fields++;
+
+			if (mf_type_is_int(mf_type(mf, m->type))) {
+				int_fields++;
+			}
+		}
+	}
+
+	uint32_t buf_fields = set_fields - int_fields;
+	uint32_t max_iov = MAX(1, 2 * buf_fields);
+
+	*max_iov_r = max_iov;
+
+	return max_iov * sizeof(struct iovec) + sizeof(msg_hdr) +
+			int_fields * (sizeof(msg_field_hdr) + sizeof(uint64_t)) +
+			buf_fields * BUF_FIELD_HDR_SZ;
+}
+
 // Returns iovec count.
 size_t
 msg_to_iov_buf(const msg *m, uint8_t *buf, size_t buf_sz, uint32_t *msg_sz_r)
@@ -1303,3 +1349,4 @@ msgpack_list_unpack_hdr(msgpack_in *mp, const msg *m, int field_id,
 
 	return true;
 }
+
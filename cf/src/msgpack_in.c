@@ -62,6 +62,30 @@ typedef struct {
 	bool has_nonstorage;
 } parse_meta;
 
+#define FIXSTR_SZ(__len) [0xa0 + (__len)] = 1 + (__len)
+
+// Whole element size, for elements whose type byte implies it - else 0, for
+// non-empty containers, longer headers, and exts which may be non-storage.
+static const uint8_t fixed_ele_sz[256] = {
+		[0x00 ... 0x7f] = 1, // positive fixint
+		[0x80] = 1, // empty fixmap
+		[0x90] = 1, // empty fixarray
+		FIXSTR_SZ(0), FIXSTR_SZ(1), FIXSTR_SZ(2), FIXSTR_SZ(3),
+		FIXSTR_SZ(4), FIXSTR_SZ(5), FIXSTR_SZ(6), FIXSTR_SZ(7),
+		FIXSTR_SZ(8), FIXSTR_SZ(9), FIXSTR_SZ(10), FIXSTR_SZ(11),
+		FIXSTR_SZ(12), FIXSTR_SZ(13), FIXSTR_SZ(14), FIXSTR_SZ(15),
+		FIXSTR_SZ(16), FIXSTR_SZ(17), FIXSTR_SZ(18), FIXSTR_SZ(19),
+		FIXSTR_SZ(20), FIXSTR_SZ(21), FIXSTR_SZ(22), FIXSTR_SZ(23),
+		FIXSTR_SZ(24), FIXSTR_SZ(25), FIXSTR_SZ(26), FIXSTR_SZ(27),
+		FIXSTR_SZ(28), FIXSTR_SZ(29), FIXSTR_SZ(30), FIXSTR_SZ(31),
+		[0xc0] = 1, [0xc2] = 1, [0xc3] = 1, // nil, false, true
+		[0xca] = 5, [0xcb] = 9, // float, double
+		[0xcc] = 2, [0xcd] = 3, [0xce] = 5, [0xcf] = 9, // uint 8/16/32/64
+		[0xd0] = 2, [0xd1] = 3, [0xd2] = 5, [0xd3] = 9, // int 8/16/32/64
+		[0xd6] = 6, [0xd7] = 10, [0xd8] = 18, // fixext 4/8/16
+		[0xe0 ... 0xff] = 1 // negative fixint
+};
+
 
 //==========================================================
 // Forward declarations.
@@ -76,6 +100,8 @@ static inline uint64_t extract_uint64(const uint8_t *ptr, uint8_t sz);
 static inline uint64_t extract_neg_int64(const uint8_t *ptr, uint8_t sz);
 static inline void cmp_parse_container(parse_meta *meta, uint32_t count);
 static inline msgpack_cmp_type msgpack_cmp_internal(parse_meta *meta0, parse_meta *meta1);
+static inline bool cmp_scalar_parse(parse_meta *meta);
+static inline bool msgpack_cmp_scalar(parse_meta *meta0, parse_meta *meta1, msgpack_cmp_type *ret);
 
 static inline uint32_t msgpack_compactify_element(uint8_t *dest, const uint8_t *src);
 static inline uint8_t *msgpack_compact_table(uint8_t *buf, const uint8_t * const end, uint32_t *count, bool *has_nonstorage, bool *not_compact);
@@ -500,7 +526,19 @@ msgpack_cmp(msgpack_in *mp0, msgpack_in *mp1)
 			.remain = 1
 	};
 
-	msgpack_cmp_type ret = msgpack_cmp_internal(&meta0, &meta1);
+	msgpack_cmp_type ret;
+
+	// Typed fast path - scalars leave nothing to skip afterwards.
+	if (msgpack_cmp_scalar(&meta0, &meta1, &ret)) {
+		mp0->has_nonstorage = false;
+		mp1->has_nonstorage = false;
+		mp0->offset = meta0.buf - mp0->buf;
+		mp1->offset = meta1.buf - mp1->buf;
+
+		return ret;
+	}
+
+	ret = msgpack_cmp_internal(&meta0, &meta1);
 
 	meta0.buf = msgpack_sz_internal(meta0.buf, meta0.end, meta0.remain,
 			&meta0.has_nonstorage);
@@ -534,6 +572,12 @@ msgpack_cmp_peek(const msgpack_in *mp0, const msgpack_in *mp1)
 			.remain = 1
 	};
 
+	msgpack_cmp_type ret;
+
+	if (msgpack_cmp_scalar(&meta0, &meta1, &ret)) {
+		return ret;
+	}
+
 	return msgpack_cmp_internal(&meta0, &meta1);
 }
 
@@ -1262,6 +1306,22 @@ msgpack_sz_internal(const uint8_t *buf, const uint8_t * const end,
 		uint32_t count, bool *has_nonstorage)
 {
 	for (uint32_t i = 0; i < count; i++) {
+		// Fast path - runs of scalars and short strings need one lookup each.
+		if (buf < end) {
+			uint32_t sz = fixed_ele_sz[*buf];
+
+			if (sz != 0) {
+				buf += sz;
+
+				if (buf > end) {
+					cf_warning(AS_PARTICLE, "msgpack_sz_internal: invalid at i %u count %u", i, count);
+					return NULL;
+				}
+
+				continue;
+			}
+		}
+
 		buf = msgpack_sz_table(buf, end, &count, has_nonstorage);
 
 		if (buf > end || buf == NULL) {
@@ -1729,6 +1789,163 @@ msgpack_cmp_internal(parse_meta *meta0, parse_meta *meta1)
 	return end_result;
 }
 
+// Ints and strings/blobs - what sorted leaderboards and most ordered
+// collections hold - decoded without the generic parse. Returns false, and
+// leaves meta alone, for anything else.
+static inline bool
+cmp_scalar_parse(parse_meta *meta)
+{
+	const uint8_t *buf = meta->buf;
+
+	if (buf >= meta->end) {
+		return false;
+	}
+
+	uint8_t b = *buf++;
+
+	if (b < 0x80) { // 8 bit combined unsigned integer
+		meta->i_num = b;
+		meta->type = MSGPACK_TYPE_INT;
+		meta->buf = buf;
+		return true;
+	}
+
+	if (b >= 0xe0) { // 8 bit combined negative integer
+		meta->i_num = (uint64_t)(int8_t)b;
+		meta->type = MSGPACK_TYPE_NEGINT;
+		meta->buf = buf;
+		return true;
+	}
+
+	uint32_t len;
+
+	switch (b) {
+	case 0xcc: // unsigned 8 bit integer
+	case 0xcd: // unsigned 16 bit integer
+	case 0xce: // unsigned 32 bit integer
+	case 0xcf: { // unsigned 64 bit integer
+		uint8_t sz = 1U << (b - 0xcc);
+
+		if (buf + sz > meta->end) {
+			return false;
+		}
+
+		meta->i_num = sz == 1 ? *buf : extract_uint64(buf, sz);
+		meta->type = MSGPACK_TYPE_INT;
+		meta->buf = buf + sz;
+		return true;
+	}
+	case 0xd0: // signed 8 bit integer
+	case 0xd1: // signed 16 bit integer
+	case 0xd2: // signed 32 bit integer
+	case 0xd3: { // signed 64 bit integer
+		uint8_t sz = 1U << (b - 0xd0);
+
+		if (buf + sz > meta->end) {
+			return false;
+		}
+
+		if ((*buf & 0x80) != 0) {
+			meta->i_num = sz == 1 ?
+					(uint64_t)(int8_t)*buf : extract_neg_int64(buf, sz);
+			meta->type = MSGPACK_TYPE_NEGINT;
+		}
+		else {
+			meta->i_num = sz == 1 ? *buf : extract_uint64(buf, sz);
+			meta->type = MSGPACK_TYPE_INT;
+		}
+
+		meta->buf = buf + sz;
+		return true;
+	}
+	case 0xc4:
+	case 0xd9: // string/raw bytes with 8 bit header
+		if (buf + 1 > meta->end) {
+			return false;
+		}
+
+		len = *buf;
+		buf += 1;
+		break;
+	case 0xc5:
+	case 0xda: // string/raw bytes with 16 bit header
+		if (buf + 2 > meta->end) {
+			return false;
+		}
+
+		len = cf_swap_from_be16(*(uint16_t *)buf);
+		buf += 2;
+		break;
+	case 0xc6:
+	case 0xdb: // string/raw bytes with 32 bit header
+		if (buf + 4 > meta->end) {
+			return false;
+		}
+
+		len = cf_swap_from_be32(*(uint32_t *)buf);
+		buf += 4;
+		break;
+	default:
+		if ((b & 0xe0) != 0xa0) {
+			return false; // not a scalar we handle - use the generic parse
+		}
+
+		len = b & 0x1f; // raw bytes with 8 bit combined header
+		break;
+	}
+
+	if (buf + len > meta->end) {
+		return false;
+	}
+
+	meta->data = buf;
+	meta->len = len;
+	meta->type = len == 0 ?
+			MSGPACK_TYPE_BYTES : bytes_internal_to_type(*buf, len);
+	meta->buf = buf + len;
+
+	return true;
+}
+
+// Same ordering as msgpack_cmp_internal(), for two scalars. Returns false,
+// leaving metas alone, if either element isn't one.
+static inline bool
+msgpack_cmp_scalar(parse_meta *meta0, parse_meta *meta1, msgpack_cmp_type *ret)
+{
+	parse_meta s0 = *meta0;
+	parse_meta s1 = *meta1;
+
+	if (! cmp_scalar_parse(&s0) || ! cmp_scalar_parse(&s1)) {
+		return false;
+	}
+
+	meta0->buf = s0.buf;
+	meta1->buf = s1.buf;
+
+	if (s0.type != s1.type) {
+		*ret = s0.type < s1.type ? MSGPACK_CMP_LESS : MSGPACK_CMP_GREATER;
+		return true;
+	}
+
+	if (s0.type == MSGPACK_TYPE_INT || s0.type == MSGPACK_TYPE_NEGINT) {
+		*ret = s0.i_num < s1.i_num ? MSGPACK_CMP_LESS :
+				(s0.i_num > s1.i_num ? MSGPACK_CMP_GREATER : MSGPACK_CMP_EQUAL);
+		return true;
+	}
+
+	int cmp = memcmp(s0.data, s1.data, s0.len < s1.len ? s0.len : s1.len);
+
+	if (cmp == 0) {
+		*ret = s0.len < s1.len ? MSGPACK_CMP_LESS :
+				(s0.len > s1.len ? MSGPACK_CMP_GREATER : MSGPACK_CMP_EQUAL);
+	}
+	else {
+		*ret = cmp < 0 ? MSGPACK_CMP_LESS : MSGPACK_CMP_GREATER;
+	}
+
+	return true;
+}
+
 static inline uint32_t
 msgpack_compactify_element(uint8_t *dest, const uint8_t *src)
 {
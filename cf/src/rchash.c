@@ -1,7 +1,7 @@
 /*
  * rchash.c
  *
- * Copyright (C) 2018-2020 Aerospike, Inc.
+ * Copyright (C) 2018-2026 Aerospike, Inc.
  *
  * Portions may be licensed to Aerospike, Inc. under one or more contributor
  * license agreements.
@@ -30,10 +30,15 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 #include "aerospike/as_atomic.h"
 #include "citrusleaf/alloc.h"
 #include "citrusleaf/cf_hash_math.h"
 
+#include "bits.h"
 #include "cf_mutex.h"
 #include "log.h"
 
@@ -42,29 +47,162 @@
 // Typedefs & constants.
 //
 
-typedef struct cf_rchash_ele_s {
-	struct cf_rchash_ele_s* next;
+// Each stripe is a "Swiss table" - a control byte per slot, probed a group of
+// 16 control bytes at a time. A full slot's control byte holds 7 bits of its
+// hash, so most non-matching slots are rejected without touching the slot.
+
+#define GROUP_SZ 16
+
+#define CTRL_EMPTY ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+// Full slots are 0x00 ... 0x7F.
+
+#define BUCKETS_PER_STRIPE 256
+#define MAX_STRIPES 64
+
+typedef struct cf_rchash_slot_s {
+	uint32_t hash; // user hash, kept for rehashing
+	uint32_t unused;
 	void* object; // this is a reference counted object
 	uint8_t key[];
-} cf_rchash_ele;
+} cf_rchash_slot;
 
 
 //==========================================================
 // Forward declarations.
 //
 
-// Generic utilities.
-static inline void cf_rchash_destroy_elements(cf_rchash* h);
-static inline uint32_t cf_rchash_calculate_hash(cf_rchash* h, const void* key);
-static inline cf_mutex* cf_rchash_lock(cf_rchash* h, uint32_t i);
-static inline void cf_rchash_unlock(cf_mutex* l);
-static inline cf_rchash_ele* cf_rchash_get_bucket(cf_rchash* h, uint32_t i);
-static inline void cf_rchash_fill_element(cf_rchash_ele* e, cf_rchash* h, const void* key, void* object);
-static inline void cf_rchash_size_incr(cf_rchash* h);
-static inline void cf_rchash_size_decr(cf_rchash* h);
+static void stripe_init(cf_rchash* h, cf_rchash_stripe* s, uint32_t capacity);
+static cf_rchash_slot* stripe_find(const cf_rchash* h, const cf_rchash_stripe* s, uint64_t mixed, const void* key, uint32_t* ix_r);
+static cf_rchash_slot* stripe_insert(cf_rchash* h, cf_rchash_stripe* s, uint64_t mixed);
+static void stripe_erase(cf_rchash* h, cf_rchash_stripe* s, uint32_t ix);
+static void stripe_rehash(cf_rchash* h, cf_rchash_stripe* s);
+static uint32_t find_free(const cf_rchash_stripe* s, uint64_t mixed);
 static inline void cf_rchash_release_object(cf_rchash* h, void* object);
 
 
+//==========================================================
+// Inlines & macros.
+//
+
+#define SLOT(_h, _s, _ix) \
+	((cf_rchash_slot*)((_s)->slots + (size_t)(_ix) * (_h)->slot_size))
+
+#define IS_FULL(_ctrl) (((_ctrl) & 0x80) == 0)
+
+// Spread the user's 32-bit hash over 64 bits (murmur3 finalizer) - user hash
+// functions may be weak in the bits we use for H1 and H2.
+static inline uint64_t
+mix_hash(uint32_t hash)
+{
+	uint64_t h = hash;
+
+	h *= 0xff51afd7ed558ccdUL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53UL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+// Probe start - bits 7 and up.
+static inline uint32_t
+h1(uint64_t mixed)
+{
+	return (uint32_t)(mixed >> 7);
+}
+
+// Stored in control byte - low 7 bits.
+static inline uint8_t
+h2(uint64_t mixed)
+{
+	return (uint8_t)(mixed & 0x7F);
+}
+
+static inline cf_rchash_stripe*
+get_stripe(const cf_rchash* h, uint64_t mixed)
+{
+	// High bits - independent of h1() bits for any practical capacity.
+	return &h->stripes[(uint32_t)(mixed >> 40) & (h->n_stripes - 1)];
+}
+
+#if defined(__x86_64__)
+
+static inline uint32_t
+group_match(const uint8_t* ctrl, uint8_t val)
+{
+	__m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+
+	return (uint32_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(group, _mm_set1_epi8((char)val)));
+}
+
+// Empty or deleted - i.e. high bit set.
+static inline uint32_t
+group_match_free(const uint8_t* ctrl)
+{
+	return (uint32_t)_mm_movemask_epi8(
+			_mm_loadu_si128((const __m128i*)ctrl));
+}
+
+#else
+
+static inline uint32_t
+group_match(const uint8_t* ctrl, uint8_t val)
+{
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < GROUP_SZ; i++) {
+		if (ctrl[i] == val) {
+			mask |= 1U << i;
+		}
+	}
+
+	return mask;
+}
+
+static inline uint32_t
+group_match_free(const uint8_t* ctrl)
+{
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < GROUP_SZ; i++) {
+		if (! IS_FULL(ctrl[i])) {
+			mask |= 1U << i;
+		}
+	}
+
+	return mask;
+}
+
+#endif
+
+// Keep the cloned group after the last slot in sync, so groups can be loaded
+// at any position without wrapping.
+static inline void
+set_ctrl(cf_rchash_stripe* s, uint32_t ix, uint8_t val)
+{
+	s->ctrl[ix] = val;
+
+	if (ix < GROUP_SZ) {
+		s->ctrl[s->mask + 1 + ix] = val;
+	}
+}
+
+static inline uint32_t
+capacity_to_growth(uint32_t capacity)
+{
+	// Max load factor 7/8.
+	return capacity - capacity / 8;
+}
+
+static inline uint32_t
+next_pow2(uint32_t n)
+{
+	return n <= 1 ? 1 : 1U << (cf_msb(n - 1) + 1);
+}
+
+
 //==========================================================
 // Public API - useful hash functions.
 //
@@ -78,7 +216,7 @@ cf_rchash_fn_u32(const void* key)
 }
 
 // Useful if key is a null-terminated string. (Note - since we use fixed-size
-// keys, key must still be padded to correctly compare keys in a bucket.)
+// keys, key must still be padded to correctly compare keys in a slot.)
 uint32_t
 cf_rchash_fn_zstr(const void* key)
 {
@@ -90,6 +228,8 @@ cf_rchash_fn_zstr(const void* key)
 // Public API.
 //
 
+// Note - n_buckets is now a sizing hint - it sets the number of lock stripes
+// and their initial capacity. Stripes grow as needed.
 cf_rchash*
 cf_rchash_create(cf_rchash_hash_fn h_fn, cf_rchash_destructor_fn d_fn,
 		uint32_t key_size, uint32_t n_buckets)
@@ -102,13 +242,31 @@ cf_rchash_create(cf_rchash_hash_fn h_fn, cf_rchash_destructor_fn d_fn,
 	h->h_fn = h_fn;
 	h->d_fn = d_fn;
 	h->key_size = key_size;
-	h->n_buckets = n_buckets;
+	h->slot_size = (sizeof(cf_rchash_slot) + key_size + 7) & ~7u;
 	h->n_elements = 0;
-	h->table = cf_calloc(n_buckets, sizeof(cf_rchash_ele) + key_size);
-	h->bucket_locks = cf_malloc(sizeof(cf_mutex) * n_buckets);
 
-	for (uint32_t i = 0; i < n_buckets; i++) {
-		cf_mutex_init(&h->bucket_locks[i]);
+	// Round down to a power of 2.
+	uint32_t n_stripes = n_buckets < BUCKETS_PER_STRIPE ?
+			1 : 1U << cf_msb(n_buckets / BUCKETS_PER_STRIPE);
+
+	if (n_stripes > MAX_STRIPES) {
+		n_stripes = MAX_STRIPES;
+	}
+
+	h->n_stripes = n_stripes;
+	h->stripes = cf_malloc(sizeof(cf_rchash_stripe) * n_stripes);
+
+	uint32_t capacity = next_pow2(n_buckets / n_stripes);
+
+	if (capacity < GROUP_SZ) {
+		capacity = GROUP_SZ;
+	}
+
+	for (uint32_t i = 0; i < n_stripes; i++) {
+		cf_rchash_stripe* s = &h->stripes[i];
+
+		cf_mutex_init(&s->lock);
+		stripe_init(h, s, capacity);
 	}
 
 	return h;
@@ -119,14 +277,21 @@ cf_rchash_destroy(cf_rchash* h)
 {
 	cf_assert(h != NULL, CF_MISC, "bad param");
 
-	cf_rchash_destroy_elements(h);
+	for (uint32_t i = 0; i < h->n_stripes; i++) {
+		cf_rchash_stripe* s = &h->stripes[i];
 
-	for (uint32_t i = 0; i < h->n_buckets; i++) {
-		cf_mutex_destroy(&h->bucket_locks[i]);
+		for (uint32_t ix = 0; ix <= s->mask; ix++) {
+			if (IS_FULL(s->ctrl[ix])) {
+				cf_rchash_release_object(h, SLOT(h, s, ix)->object);
+			}
+		}
+
+		cf_mutex_destroy(&s->lock);
+		cf_free(s->ctrl);
+		cf_free(s->slots);
 	}
 
-	cf_free(h->bucket_locks);
-	cf_free(h->table);
+	cf_free(h->stripes);
 	cf_free(h);
 }
 
@@ -145,47 +310,34 @@ cf_rchash_put(cf_rchash* h, const void* key, void* object)
 {
 	cf_assert(h != NULL && key != NULL && object != NULL, CF_MISC, "bad param");
 
-	uint32_t hash = cf_rchash_calculate_hash(h, key);
-	cf_rchash_ele* e = cf_rchash_get_bucket(h, hash);
-
-	cf_mutex* l = cf_rchash_lock(h, hash);
-
-	// Most common case should be insert into empty bucket.
-	if (e->object == NULL) {
-		cf_rchash_fill_element(e, h, key, object);
-		cf_rchash_unlock(l);
-		return;
-	}
+	uint32_t hash = h->h_fn(key);
+	uint64_t mixed = mix_hash(hash);
+	cf_rchash_stripe* s = get_stripe(h, mixed);
 
-	uint32_t key_size = h->key_size;
-	cf_rchash_ele* e_head = e;
+	cf_mutex_lock(&s->lock);
 
-	while (e != NULL) {
-		if (memcmp(e->key, key, key_size) != 0) {
-			e = e->next;
-			continue;
-		}
+	uint32_t ix;
+	cf_rchash_slot* slot = stripe_find(h, s, mixed, key, &ix);
 
+	if (slot != NULL) {
 		// In this case we're replacing the previous object with the new object.
-		void* free_object = e->object;
+		void* free_object = slot->object;
 
-		e->object = object;
+		slot->object = object;
 
-		cf_rchash_unlock(l);
+		cf_mutex_unlock(&s->lock);
 		cf_rchash_release_object(h, free_object);
 
 		return;
 	}
 
-	e = (cf_rchash_ele*)cf_malloc(sizeof(cf_rchash_ele) + key_size);
-
-	cf_rchash_fill_element(e, h, key, object);
+	slot = stripe_insert(h, s, mixed);
 
-	// Insert just after head.
-	e->next = e_head->next;
-	e_head->next = e;
+	slot->hash = hash;
+	slot->object = object;
+	memcpy(slot->key, key, h->key_size);
 
-	cf_rchash_unlock(l);
+	cf_mutex_unlock(&s->lock);
 }
 
 // Like cf_rchash_put(), but if key is already in hash, fail.
@@ -194,40 +346,27 @@ cf_rchash_put_unique(cf_rchash* h, const void* key, void* object)
 {
 	cf_assert(h != NULL && key != NULL && object != NULL, CF_MISC, "bad param");
 
-	uint32_t hash = cf_rchash_calculate_hash(h, key);
-	cf_rchash_ele* e = cf_rchash_get_bucket(h, hash);
+	uint32_t hash = h->h_fn(key);
+	uint64_t mixed = mix_hash(hash);
+	cf_rchash_stripe* s = get_stripe(h, mixed);
 
-	cf_mutex* l = cf_rchash_lock(h, hash);
+	cf_mutex_lock(&s->lock);
 
-	// Most common case should be insert into empty bucket.
-	if (e->object == NULL) {
-		cf_rchash_fill_element(e, h, key, object);
-		cf_rchash_unlock(l);
-		return CF_RCHASH_OK;
-	}
-
-	uint32_t key_size = h->key_size;
-	cf_rchash_ele* e_head = e;
+	uint32_t ix;
 
 	// Check for uniqueness of key - if not unique, fail!
-	while (e != NULL) {
-		if (memcmp(e->key, key, key_size) == 0) {
-			cf_rchash_unlock(l);
-			return CF_RCHASH_ERR_FOUND;
-		}
-
-		e = e->next;
+	if (stripe_find(h, s, mixed, key, &ix) != NULL) {
+		cf_mutex_unlock(&s->lock);
+		return CF_RCHASH_ERR_FOUND;
 	}
 
-	e = (cf_rchash_ele*)cf_malloc(sizeof(cf_rchash_ele) + key_size);
-
-	cf_rchash_fill_element(e, h, key, object);
+	cf_rchash_slot* slot = stripe_insert(h, s, mixed);
 
-	// Insert just after head.
-	e->next = e_head->next;
-	e_head->next = e;
+	slot->hash = hash;
+	slot->object = object;
+	memcpy(slot->key, key, h->key_size);
 
-	cf_rchash_unlock(l);
+	cf_mutex_unlock(&s->lock);
 
 	return CF_RCHASH_OK;
 }
@@ -243,36 +382,27 @@ cf_rchash_get(cf_rchash* h, const void* key, void** object_r)
 {
 	cf_assert(h != NULL && key != NULL, CF_MISC, "bad param");
 
-	uint32_t hash = cf_rchash_calculate_hash(h, key);
-	cf_rchash_ele* e = cf_rchash_get_bucket(h, hash);
+	uint64_t mixed = mix_hash(h->h_fn(key));
+	cf_rchash_stripe* s = get_stripe(h, mixed);
 
-	if (e->object == NULL) {
-		return CF_RCHASH_ERR_NOT_FOUND;
-	}
-
-	cf_mutex* l = cf_rchash_lock(h, hash);
-
-	uint32_t key_size = h->key_size;
-
-	while (e != NULL && e->object != NULL) {
-		if (memcmp(key, e->key, key_size) != 0) {
-			e = e->next;
-			continue;
-		}
+	cf_mutex_lock(&s->lock);
 
-		if (object_r != NULL) {
-			cf_rc_reserve(e->object);
-			*object_r = e->object;
-		}
+	uint32_t ix;
+	cf_rchash_slot* slot = stripe_find(h, s, mixed, key, &ix);
 
-		cf_rchash_unlock(l);
+	if (slot == NULL) {
+		cf_mutex_unlock(&s->lock);
+		return CF_RCHASH_ERR_NOT_FOUND;
+	}
 
-		return CF_RCHASH_OK;
+	if (object_r != NULL) {
+		cf_rc_reserve(slot->object);
+		*object_r = slot->object;
 	}
 
-	cf_rchash_unlock(l);
+	cf_mutex_unlock(&s->lock);
 
-	return CF_RCHASH_ERR_NOT_FOUND;
+	return CF_RCHASH_OK;
 }
 
 // Removes the key and object from the hash, releasing the "original" ref-count.
@@ -297,67 +427,30 @@ cf_rchash_delete_object(cf_rchash* h, const void* key, void* object)
 {
 	cf_assert(h != NULL && key != NULL, CF_MISC, "bad param");
 
-	uint32_t hash = cf_rchash_calculate_hash(h, key);
-	cf_rchash_ele* e = cf_rchash_get_bucket(h, hash);
-
-	if (e->object == NULL) {
-		return CF_RCHASH_ERR_NOT_FOUND;
-	}
-
-	cf_mutex* l = cf_rchash_lock(h, hash);
-
-	uint32_t key_size = h->key_size;
-	cf_rchash_ele* e_prev = NULL;
-
-	// Look for the element, remove and release if found.
-	while (e != NULL && e->object != NULL) {
-		if (memcmp(e->key, key, key_size) != 0) {
-			e_prev = e;
-			e = e->next;
-			continue;
-		}
-		// else - found it, remove from hash and release outside lock...
+	uint64_t mixed = mix_hash(h->h_fn(key));
+	cf_rchash_stripe* s = get_stripe(h, mixed);
 
-		// ... unless it's the wrong object.
-		if (object != NULL && object != e->object) {
-			cf_rchash_unlock(l);
-			return CF_RCHASH_ERR_NOT_FOUND;
-		}
+	cf_mutex_lock(&s->lock);
 
-		// Save pointers to release & free.
-		void* free_object = e->object;
-		cf_rchash_ele* free_e = NULL;
+	uint32_t ix;
+	cf_rchash_slot* slot = stripe_find(h, s, mixed, key, &ix);
 
-		// If not at head, patch pointers and free element.
-		if (e_prev != NULL) {
-			e_prev->next = e->next;
-			free_e = e;
-		}
-		// If at head with no next, empty head.
-		else if (e->next == NULL) {
-			e->object = NULL;
-		}
-		// If at head with a next, copy next into head and free next.
-		else {
-			free_e = e->next;
-			memcpy(e, e->next, sizeof(cf_rchash_ele) + key_size);
-		}
+	// Not found, or it's the wrong object.
+	if (slot == NULL || (object != NULL && object != slot->object)) {
+		cf_mutex_unlock(&s->lock);
+		return CF_RCHASH_ERR_NOT_FOUND;
+	}
 
-		cf_rchash_size_decr(h);
-		cf_rchash_unlock(l);
+	// Remove from hash and release outside lock.
+	void* free_object = slot->object;
 
-		cf_rchash_release_object(h, free_object);
-
-		if (free_e != NULL) {
-			cf_free(free_e);
-		}
+	stripe_erase(h, s, ix);
 
-		return CF_RCHASH_OK;
-	}
+	cf_mutex_unlock(&s->lock);
 
-	cf_rchash_unlock(l);
+	cf_rchash_release_object(h, free_object);
 
-	return CF_RCHASH_ERR_NOT_FOUND;
+	return CF_RCHASH_OK;
 }
 
 // Call the given function (reduce_fn) for every element in the tree.
@@ -370,65 +463,49 @@ cf_rchash_delete_object(cf_rchash* h, const void* key, void* object)
 //
 // If deleting an element causes the object ref-count to hit 0, the object
 // destructor is called and the object is freed.
+//
+// Note - reduce_fn is called with the element's stripe locked, so it must not
+// access this hash.
 int
 cf_rchash_reduce(cf_rchash* h, cf_rchash_reduce_fn reduce_fn, void* udata)
 {
 	cf_assert(h != NULL && reduce_fn != NULL, CF_MISC, "bad param");
 
-	uint32_t key_size = h->key_size;
+	for (uint32_t i = 0; i < h->n_stripes; i++) {
+		cf_rchash_stripe* s = &h->stripes[i];
 
-	for (uint32_t i = 0; i < h->n_buckets; i++) {
-		cf_rchash_ele* e = cf_rchash_get_bucket(h, i);
-
-		if (e->object == NULL) {
+		if (as_load_uint32(&s->n_used) == 0) {
 			continue;
 		}
 
-		cf_mutex* l = cf_rchash_lock(h, i);
+		cf_mutex_lock(&s->lock);
 
-		cf_rchash_ele* e_prev = NULL;
+		for (uint32_t ix = 0; ix <= s->mask; ix++) {
+			if (! IS_FULL(s->ctrl[ix])) {
+				continue;
+			}
 
-		while (e != NULL && e->object != NULL) {
-			int rv = reduce_fn(e->key, e->object, udata);
+			cf_rchash_slot* slot = SLOT(h, s, ix);
+			int rv = reduce_fn(slot->key, slot->object, udata);
 
 			if (rv == CF_RCHASH_OK) {
 				// Caller says keep going - most common case.
-
-				e_prev = e;
-				e = e->next;
+				continue;
 			}
-			else if (rv == CF_RCHASH_REDUCE_DELETE) {
-				// Caller says delete this element and keep going.
 
-				cf_rchash_release_object(h, e->object);
-				cf_rchash_size_decr(h);
-
-				// If not at head, patch pointers and free element.
-				if (e_prev != NULL) {
-					e_prev->next = e->next;
-					cf_free(e);
-					e = e_prev->next;
-				}
-				// If at head with no next, empty head.
-				else if (e->next == NULL) {
-					e->object = NULL;
-				}
-				// If at head with a next, copy next into head and free next.
-				else {
-					cf_rchash_ele* free_e = e->next;
-
-					memcpy(e, e->next, sizeof(cf_rchash_ele) + key_size);
-					cf_free(free_e);
-				}
-			}
-			else {
-				// Caller says stop iterating.
-				cf_rchash_unlock(l);
-				return rv;
+			if (rv == CF_RCHASH_REDUCE_DELETE) {
+				// Caller says delete this element and keep going.
+				cf_rchash_release_object(h, slot->object);
+				stripe_erase(h, s, ix);
+				continue;
 			}
+
+			// Caller says stop iterating.
+			cf_mutex_unlock(&s->lock);
+			return rv;
 		}
 
-		cf_rchash_unlock(l);
+		cf_mutex_unlock(&s->lock);
 	}
 
 	return CF_RCHASH_OK;
@@ -436,82 +513,142 @@ cf_rchash_reduce(cf_rchash* h, cf_rchash_reduce_fn reduce_fn, void* udata)
 
 
 //==========================================================
-// Local helpers - generic utilities.
+// Local helpers - open-addressing stripes.
 //
 
-static inline void
-cf_rchash_destroy_elements(cf_rchash* h)
+static void
+stripe_init(cf_rchash* h, cf_rchash_stripe* s, uint32_t capacity)
 {
-	for (uint32_t i = 0; i < h->n_buckets; i++) {
-		cf_rchash_ele* e = cf_rchash_get_bucket(h, i);
+	s->mask = capacity - 1;
+	s->growth_left = capacity_to_growth(capacity);
+	s->n_used = 0;
+	s->ctrl = cf_malloc(capacity + GROUP_SZ);
+	s->slots = cf_malloc((size_t)capacity * h->slot_size);
 
-		if (e->object == NULL) {
-			continue;
-		}
+	memset(s->ctrl, CTRL_EMPTY, capacity + GROUP_SZ);
+}
+
+static cf_rchash_slot*
+stripe_find(const cf_rchash* h, const cf_rchash_stripe* s, uint64_t mixed,
+		const void* key, uint32_t* ix_r)
+{
+	uint8_t tag = h2(mixed);
+	uint32_t pos = h1(mixed) & s->mask;
 
-		cf_rchash_release_object(h, e->object);
-		e = e->next; // skip the first, it's in place
+	// Triangular probing over groups visits every slot of a power of 2 table.
+	for (uint32_t step = GROUP_SZ; ; step += GROUP_SZ) {
+		const uint8_t* group = s->ctrl + pos;
+		uint32_t match = group_match(group, tag);
 
-		while (e != NULL) {
-			cf_rchash_ele* temp = e->next;
+		while (match != 0) {
+			uint32_t ix = (pos + cf_lsb64(match)) & s->mask;
+			cf_rchash_slot* slot = SLOT(h, s, ix);
 
-			cf_rchash_release_object(h, e->object);
-			cf_free(e);
-			e = temp;
+			if (memcmp(slot->key, key, h->key_size) == 0) {
+				*ix_r = ix;
+				return slot;
+			}
+
+			match &= match - 1;
 		}
+
+		// An empty slot ends the probe sequence - there's always one.
+		if (group_match(group, CTRL_EMPTY) != 0) {
+			return NULL;
+		}
+
+		pos = (pos + step) & s->mask;
 	}
 }
 
-static inline uint32_t
-cf_rchash_calculate_hash(cf_rchash* h, const void* key)
+// Caller has checked the key isn't already in the stripe, and fills the slot.
+static cf_rchash_slot*
+stripe_insert(cf_rchash* h, cf_rchash_stripe* s, uint64_t mixed)
 {
-	return h->h_fn(key) % h->n_buckets;
-}
+	uint32_t ix = find_free(s, mixed);
 
-static inline cf_mutex*
-cf_rchash_lock(cf_rchash* h, uint32_t i)
-{
-	cf_mutex* l = &h->bucket_locks[i];
+	// Reusing a deleted slot doesn't use up growth.
+	if (s->growth_left == 0 && s->ctrl[ix] == CTRL_EMPTY) {
+		stripe_rehash(h, s);
+		ix = find_free(s, mixed);
+	}
 
-	cf_mutex_lock(l);
+	if (s->ctrl[ix] == CTRL_EMPTY) {
+		s->growth_left--;
+	}
 
-	return l;
-}
+	set_ctrl(s, ix, h2(mixed));
+	s->n_used++;
+	as_incr_uint32(&h->n_elements);
 
-static inline void
-cf_rchash_unlock(cf_mutex* l)
-{
-	cf_mutex_unlock(l);
+	return SLOT(h, s, ix);
 }
 
-static inline cf_rchash_ele*
-cf_rchash_get_bucket(cf_rchash* h, uint32_t i)
+static void
+stripe_erase(cf_rchash* h, cf_rchash_stripe* s, uint32_t ix)
 {
-	return (cf_rchash_ele*)((uint8_t*)h->table +
-			((sizeof(cf_rchash_ele) + h->key_size) * i));
+	// Must leave a tombstone - other keys' probe sequences may pass this slot.
+	set_ctrl(s, ix, CTRL_DELETED);
+	s->n_used--;
+	as_decr_uint32(&h->n_elements);
 }
 
-static inline void
-cf_rchash_fill_element(cf_rchash_ele* e, cf_rchash* h, const void* key,
-		void* object)
+// Either grow, or rebuild at the same size to clear out tombstones.
+static void
+stripe_rehash(cf_rchash* h, cf_rchash_stripe* s)
 {
-	memcpy(e->key, key, h->key_size);
-	e->object = object;
-	cf_rchash_size_incr(h);
-}
+	uint32_t old_capacity = s->mask + 1;
+	uint8_t* old_ctrl = s->ctrl;
+	uint8_t* old_slots = s->slots;
+	uint32_t n_used = s->n_used;
 
-static inline void
-cf_rchash_size_incr(cf_rchash* h)
-{
-	as_incr_int32(&h->n_elements);
+	uint32_t capacity = n_used * 16 > old_capacity * 7 ?
+			old_capacity * 2 : old_capacity;
+
+	stripe_init(h, s, capacity);
+
+	for (uint32_t i = 0; i < old_capacity; i++) {
+		if (! IS_FULL(old_ctrl[i])) {
+			continue;
+		}
+
+		const cf_rchash_slot* old_slot =
+				(const cf_rchash_slot*)(old_slots + (size_t)i * h->slot_size);
+		uint64_t mixed = mix_hash(old_slot->hash);
+		uint32_t ix = find_free(s, mixed);
+
+		set_ctrl(s, ix, h2(mixed));
+		memcpy(SLOT(h, s, ix), old_slot, h->slot_size);
+	}
+
+	s->n_used = n_used;
+	s->growth_left -= n_used;
+
+	cf_free(old_ctrl);
+	cf_free(old_slots);
 }
 
-static inline void
-cf_rchash_size_decr(cf_rchash* h)
+static uint32_t
+find_free(const cf_rchash_stripe* s, uint64_t mixed)
 {
-	as_decr_int32(&h->n_elements);
+	uint32_t pos = h1(mixed) & s->mask;
+
+	for (uint32_t step = GROUP_SZ; ; step += GROUP_SZ) {
+		uint32_t match = group_match_free(s->ctrl + pos);
+
+		if (match != 0) {
+			return (pos + cf_lsb64(match)) & s->mask;
+		}
+
+		pos = (pos + step) & s->mask;
+	}
 }
 
+
+//==========================================================
+// Local helpers - generic utilities.
+//
+
 static inline void
 cf_rchash_release_object(cf_rchash* h, void* object)
 {
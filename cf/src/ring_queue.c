@@ -0,0 +1,258 @@
+/*
+ * ring_queue.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "ring_queue.h"
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/alloc.h"
+#include "citrusleaf/cf_clock.h"
+
+#include "log.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+// Each cell's sequence number says whose turn it is - equal to the position
+// when free for a producer, position + 1 when full for a consumer.
+typedef struct ring_cell_s {
+	uint64_t seq;
+	uint8_t data[];
+} ring_cell;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static bool try_pop(cf_ring_queue* q, void* ele);
+static void wake_waiter(cf_ring_queue* q);
+
+
+//==========================================================
+// Inlines & macros.
+//
+
+#define CELL(_q, _pos) \
+	((ring_cell*)((_q)->cells + ((_pos) & (_q)->mask) * (_q)->cell_sz))
+
+static inline void
+sys_futex(uint32_t* uaddr, int op, uint32_t val, const struct timespec* ts)
+{
+	syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
+
+
+//==========================================================
+// Public API.
+//
+
+void
+cf_ring_queue_init(cf_ring_queue* q, uint32_t ele_sz, uint32_t capacity)
+{
+	cf_assert(capacity != 0 && (capacity & (capacity - 1)) == 0, CF_MISC,
+			"ring queue capacity %u not a power of 2", capacity);
+
+	memset(q, 0, sizeof(cf_ring_queue));
+
+	q->mask = capacity - 1;
+	q->ele_sz = ele_sz;
+	q->cell_sz = (sizeof(ring_cell) + ele_sz + 7) & ~7u;
+	q->cells = cf_malloc((size_t)capacity * q->cell_sz);
+
+	for (uint32_t i = 0; i < capacity; i++) {
+		CELL(q, i)->seq = i;
+	}
+}
+
+void
+cf_ring_queue_destroy(cf_ring_queue* q)
+{
+	cf_free(q->cells);
+}
+
+bool
+cf_ring_queue_push(cf_ring_queue* q, const void* ele)
+{
+	uint64_t pos = as_load_uint64(&q->write_pos);
+	ring_cell* cell;
+
+	while (true) {
+		cell = CELL(q, pos);
+
+		uint64_t seq = as_load_uint64(&cell->seq);
+
+		as_fence_acq();
+
+		int64_t diff = (int64_t)(seq - pos);
+
+		if (diff == 0) {
+			if (as_cas_uint64(&q->write_pos, pos, pos + 1)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			return false; // full
+		}
+
+		pos = as_load_uint64(&q->write_pos);
+	}
+
+	memcpy(cell->data, ele, q->ele_sz);
+
+	as_fence_rls();
+	as_store_uint64(&cell->seq, pos + 1);
+
+	wake_waiter(q);
+
+	return true;
+}
+
+bool
+cf_ring_queue_pop(cf_ring_queue* q, void* ele, int32_t ms_wait)
+{
+	if (try_pop(q, ele)) {
+		return true;
+	}
+
+	if (ms_wait == CF_RING_QUEUE_NOWAIT) {
+		return false;
+	}
+
+	uint64_t deadline_ms = ms_wait == CF_RING_QUEUE_FOREVER ?
+			0 : cf_getms() + (uint64_t)ms_wait;
+	bool result = false;
+
+	as_faa_uint32(&q->n_waiters, 1);
+
+	while (true) {
+		// Sample before retrying - a push after this changes it, so the futex
+		// wait can't miss the push's wakeup.
+		uint32_t wake_seq = as_load_uint32(&q->wake_seq);
+
+		if (try_pop(q, ele)) {
+			result = true;
+			break;
+		}
+
+		if (deadline_ms == 0) {
+			sys_futex(&q->wake_seq, FUTEX_WAIT_PRIVATE, wake_seq, NULL);
+			continue;
+		}
+
+		uint64_t now_ms = cf_getms();
+
+		if (now_ms >= deadline_ms) {
+			break;
+		}
+
+		uint64_t wait_ms = deadline_ms - now_ms;
+		struct timespec ts = {
+				.tv_sec = (time_t)(wait_ms / 1000),
+				.tv_nsec = (long)((wait_ms % 1000) * 1000000)
+		};
+
+		sys_futex(&q->wake_seq, FUTEX_WAIT_PRIVATE, wake_seq, &ts);
+	}
+
+	as_faa_uint32(&q->n_waiters, -1);
+
+	return result;
+}
+
+uint32_t
+cf_ring_queue_sz(const cf_ring_queue* q)
+{
+	// Read consumer side first, so a racing pop can't make this negative.
+	uint64_t read_pos = as_load_uint64(&q->read_pos);
+	uint64_t write_pos = as_load_uint64(&q->write_pos);
+
+	return write_pos > read_pos ? (uint32_t)(write_pos - read_pos) : 0;
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static bool
+try_pop(cf_ring_queue* q, void* ele)
+{
+	uint64_t pos = as_load_uint64(&q->read_pos);
+	ring_cell* cell;
+
+	while (true) {
+		cell = CELL(q, pos);
+
+		uint64_t seq = as_load_uint64(&cell->seq);
+
+		as_fence_acq();
+
+		int64_t diff = (int64_t)(seq - (pos + 1));
+
+		if (diff == 0) {
+			if (as_cas_uint64(&q->read_pos, pos, pos + 1)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			return false; // empty
+		}
+
+		pos = as_load_uint64(&q->read_pos);
+	}
+
+	memcpy(ele, cell->data, q->ele_sz);
+
+	// Free the cell for the producer one lap ahead.
+	as_fence_rls();
+	as_store_uint64(&cell->seq, pos + q->mask + 1);
+
+	return true;
+}
+
+static void
+wake_waiter(cf_ring_queue* q)
+{
+	// Order the cell's publication before checking for waiters - pairs with
+	// the waiter's increment before its last try_pop().
+	as_fence_seq();
+
+	if (as_load_uint32(&q->n_waiters) != 0) {
+		as_faa_uint32(&q->wake_seq, 1);
+		sys_futex(&q->wake_seq, FUTEX_WAKE_PRIVATE, 1, NULL);
+	}
+}
@@ -0,0 +1,330 @@
+/*
+ * slab.c
+ *
+ * Copyright (C) 2026 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "slab.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aerospike/as_atomic.h"
+#include "citrusleaf/alloc.h"
+
+#include "cf_mutex.h"
+#include "cf_thread.h"
+#include "log.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+#define MAGAZINE_SZ 32 // objects per magazine
+#define DEPOT_MAX_FULL 64 // beyond this many full magazines, free to heap
+
+typedef struct magazine_s {
+	struct magazine_s* next; // only while in depot
+	uint32_t n_objects;
+	void* objects[MAGAZINE_SZ];
+} magazine;
+
+struct cf_slab_s {
+	char name[CF_SLAB_NAME_SZ];
+	uint32_t ix;
+	size_t obj_sz; // includes header, if reference-counted
+	bool rc;
+
+	cf_mutex depot_lock;
+	magazine* full;
+	magazine* empty;
+	uint32_t n_full;
+
+	uint64_t n_objects; // from heap, in use or cached
+};
+
+
+//==========================================================
+// Globals.
+//
+
+static cf_slab g_slabs[CF_SLAB_MAX];
+static uint32_t g_n_slabs = 0;
+static cf_mutex g_create_lock = CF_MUTEX_INIT;
+
+// Each thread has one magazine per slab it has used.
+static __thread magazine* g_loaded[CF_SLAB_MAX];
+static __thread bool g_exit_registered = false;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static cf_slab* slab_create(size_t sz, const char* name, bool rc);
+static magazine* depot_swap_for_full(cf_slab* slab, magazine* empty);
+static magazine* depot_swap_for_empty(cf_slab* slab, magazine* full);
+static void flush_magazines(void* udata);
+
+
+//==========================================================
+// Inlines & macros.
+//
+
+static inline void
+load_magazine(cf_slab* slab, magazine* mag)
+{
+	g_loaded[slab->ix] = mag;
+
+	if (! g_exit_registered) {
+		cf_thread_add_exit(flush_magazines, NULL);
+		g_exit_registered = true;
+	}
+}
+
+
+//==========================================================
+// Public API.
+//
+
+cf_slab*
+cf_slab_create(size_t sz, const char* name)
+{
+	return slab_create(sz, name, false);
+}
+
+void*
+cf_slab_alloc(cf_slab* slab)
+{
+	magazine* mag = g_loaded[slab->ix];
+
+	if (mag != NULL && mag->n_objects != 0) {
+		return mag->objects[--mag->n_objects];
+	}
+
+	// Loaded magazine is empty (or absent) - try swapping for a full one.
+	magazine* full = depot_swap_for_full(slab, mag);
+
+	if (full != NULL) {
+		load_magazine(slab, full);
+		return full->objects[--full->n_objects];
+	}
+
+	as_incr_uint64(&slab->n_objects);
+
+	return cf_malloc(slab->obj_sz);
+}
+
+void
+cf_slab_free(cf_slab* slab, void* p)
+{
+	magazine* mag = g_loaded[slab->ix];
+
+	if (mag != NULL && mag->n_objects != MAGAZINE_SZ) {
+		mag->objects[mag->n_objects++] = p;
+		return;
+	}
+
+	// Loaded magazine is full (or absent) - try swapping for an empty one.
+	magazine* empty = depot_swap_for_empty(slab, mag);
+
+	if (empty == NULL) {
+		// Depot is full - don't cache any more.
+		as_decr_uint64(&slab->n_objects);
+		cf_free(p);
+		return;
+	}
+
+	load_magazine(slab, empty);
+	empty->objects[empty->n_objects++] = p;
+}
+
+cf_slab*
+cf_slab_create_rc(size_t sz, const char* name)
+{
+	return slab_create(sizeof(cf_rc_header) + sz, name, true);
+}
+
+void*
+cf_slab_rc_alloc(cf_slab* slab)
+{
+	cf_assert(slab->rc, CF_ALLOC, "slab %s is not reference-counted",
+			slab->name);
+
+	cf_rc_header* head = cf_slab_alloc(slab);
+
+	head->rc = 1;
+	head->sz = (uint32_t)(slab->obj_sz - sizeof(cf_rc_header));
+
+	return head + 1; // body
+}
+
+void
+cf_slab_rc_free(cf_slab* slab, void* body)
+{
+	cf_slab_free(slab, (cf_rc_header*)body - 1);
+}
+
+uint32_t
+cf_slab_get_stats(cf_slab_stats* stats, uint32_t max_stats)
+{
+	uint32_t n_slabs = as_load_uint32(&g_n_slabs);
+
+	if (n_slabs > max_stats) {
+		n_slabs = max_stats;
+	}
+
+	for (uint32_t i = 0; i < n_slabs; i++) {
+		cf_slab* slab = &g_slabs[i];
+		cf_slab_stats* s = &stats[i];
+
+		strcpy(s->name, slab->name);
+		s->obj_sz = slab->obj_sz;
+		s->n_objects = as_load_uint64(&slab->n_objects);
+		s->n_depot_objects =
+				(uint64_t)as_load_uint32(&slab->n_full) * MAGAZINE_SZ;
+	}
+
+	return n_slabs;
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static cf_slab*
+slab_create(size_t sz, const char* name, bool rc)
+{
+	cf_mutex_lock(&g_create_lock);
+
+	cf_assert(g_n_slabs < CF_SLAB_MAX, CF_ALLOC, "too many slabs");
+
+	cf_slab* slab = &g_slabs[g_n_slabs];
+
+	strncpy(slab->name, name, CF_SLAB_NAME_SZ - 1);
+	slab->ix = g_n_slabs;
+	slab->obj_sz = sz;
+	slab->rc = rc;
+
+	cf_mutex_init(&slab->depot_lock);
+
+	// Publish only when fully initialized.
+	as_store_uint32(&g_n_slabs, g_n_slabs + 1);
+
+	cf_mutex_unlock(&g_create_lock);
+
+	return slab;
+}
+
+// Returns a full magazine, taking ownership of the empty one, if any.
+static magazine*
+depot_swap_for_full(cf_slab* slab, magazine* empty)
+{
+	cf_mutex_lock(&slab->depot_lock);
+
+	magazine* full = slab->full;
+
+	if (full == NULL) {
+		cf_mutex_unlock(&slab->depot_lock);
+		return NULL;
+	}
+
+	slab->full = full->next;
+	slab->n_full--;
+
+	if (empty != NULL) {
+		empty->next = slab->empty;
+		slab->empty = empty;
+	}
+
+	cf_mutex_unlock(&slab->depot_lock);
+
+	return full;
+}
+
+// Returns an empty magazine, taking ownership of the full one, if any. Returns
+// NULL if the depot can't take another full magazine.
+static magazine*
+depot_swap_for_empty(cf_slab* slab, magazine* full)
+{
+	cf_mutex_lock(&slab->depot_lock);
+
+	if (full != NULL) {
+		if (slab->n_full == DEPOT_MAX_FULL) {
+			cf_mutex_unlock(&slab->depot_lock);
+			return NULL;
+		}
+
+		full->next = slab->full;
+		slab->full = full;
+		slab->n_full++;
+	}
+
+	magazine* empty = slab->empty;
+
+	if (empty != NULL) {
+		slab->empty = empty->next;
+	}
+
+	cf_mutex_unlock(&slab->depot_lock);
+
+	if (empty == NULL) {
+		empty = cf_malloc(sizeof(magazine));
+	}
+
+	empty->n_objects = 0;
+
+	return empty;
+}
+
+// Called at thread exit - objects in this thread's magazines must not leak.
+static void
+flush_magazines(void* udata)
+{
+	(void)udata;
+
+	uint32_t n_slabs = as_load_uint32(&g_n_slabs);
+
+	for (uint32_t i = 0; i < n_slabs; i++) {
+		magazine* mag = g_loaded[i];
+
+		if (mag == NULL) {
+			continue;
+		}
+
+		cf_slab* slab = &g_slabs[i];
+
+		for (uint32_t j = 0; j < mag->n_objects; j++) {
+			cf_free(mag->objects[j]);
+		}
+
+		as_add_uint64(&slab->n_objects, -(int64_t)mag->n_objects);
+		cf_free(mag);
+
+		g_loaded[i] = NULL;
+	}
+}
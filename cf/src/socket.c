@@ -57,6 +57,10 @@
 #define TCP_USER_TIMEOUT 18
 #endif
 
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
 typedef struct dns_resolve_udata_s {
 	cf_ip_addr_from_string_cb cb;
 	void *udata;
@@ -702,6 +706,15 @@ cf_socket_set_window(cf_socket *sock, int32_t size)
 	forgive_setsockopt(sock->fd, SOL_TCP, TCP_WINDOW_CLAMP, &size, sizeof(size));
 }
 
+// Spin for incoming data on the NIC queue for up to 'us' microseconds before
+// sleeping - trades CPU for latency. Needs CAP_NET_ADMIN to raise the value
+// above net.core.busy_read.
+void
+cf_socket_set_busy_poll(cf_socket *sock, int32_t us)
+{
+	forgive_setsockopt(sock->fd, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us));
+}
+
 void
 cf_socket_init(cf_socket *sock)
 {
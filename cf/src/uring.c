@@ -0,0 +1,461 @@
+/*
+ * uring.c
+ *
+ * Copyright (C) 2020 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ */
+
+//==========================================================
+// Includes.
+//
+
+#include "uring.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "citrusleaf/alloc.h"
+
+#include "log.h"
+
+
+//==========================================================
+// Typedefs & constants.
+//
+
+struct cf_uring_s {
+	int fd;
+
+	uint32_t* sq_head;
+	uint32_t* sq_tail;
+	uint32_t sq_mask;
+	uint32_t* sq_array;
+	struct io_uring_sqe* sqes;
+
+	uint32_t* cq_head;
+	uint32_t* cq_tail;
+	uint32_t cq_mask;
+	struct io_uring_cqe* cqes;
+
+	uint32_t sq_entries;
+
+	void* sq_ptr;
+	size_t sq_sz;
+	void* cq_ptr;
+	size_t cq_sz;
+	size_t sqes_sz;
+};
+
+// Enough for a batch's reads to be in flight together.
+#define THREAD_RING_ENTRIES 64
+
+#define RING_DISABLED ((cf_uring*)-1)
+
+
+//==========================================================
+// Globals.
+//
+
+static pthread_key_t g_thread_ring_key;
+static pthread_once_t g_thread_ring_once = PTHREAD_ONCE_INIT;
+
+static __thread cf_uring* g_thread_ring = NULL;
+
+
+//==========================================================
+// Forward declarations.
+//
+
+static void thread_ring_key_create(void);
+static void thread_ring_destroy(void* udata);
+static void queue_read(cf_uring* ring, int fd, struct iovec* iov, off_t offset, uint64_t user_data);
+static bool submit_and_wait(cf_uring* ring, int fd, void* buf, size_t size, off_t offset, int32_t* res);
+
+
+//==========================================================
+// Inlines & macros.
+//
+
+static inline int
+sys_io_uring_setup(uint32_t entries, struct io_uring_params* p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete,
+		uint32_t flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+			NULL, 0);
+}
+
+
+//==========================================================
+// Public API.
+//
+
+cf_uring*
+cf_uring_create(uint32_t n_entries, bool poll)
+{
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+
+	if (poll) {
+		p.flags |= IORING_SETUP_IOPOLL;
+	}
+
+	int fd = sys_io_uring_setup(n_entries, &p);
+
+	if (fd < 0) {
+		cf_warning(CF_OS, "io_uring setup failed: errno %d (%s)", errno,
+				cf_strerror(errno));
+		return NULL;
+	}
+
+	cf_uring* ring = cf_calloc(1, sizeof(cf_uring));
+
+	ring->fd = fd;
+	ring->sq_entries = p.sq_entries;
+	ring->sq_sz = p.sq_off.array + (p.sq_entries * sizeof(uint32_t));
+	ring->cq_sz = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+
+	bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+	if (single_mmap && ring->cq_sz > ring->sq_sz) {
+		ring->sq_sz = ring->cq_sz;
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_sz, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+	if (ring->sq_ptr == MAP_FAILED) {
+		cf_warning(CF_OS, "io_uring sq mmap failed: errno %d (%s)", errno,
+				cf_strerror(errno));
+		close(fd);
+		cf_free(ring);
+		return NULL;
+	}
+
+	if (single_mmap) {
+		ring->cq_ptr = ring->sq_ptr;
+	}
+	else {
+		ring->cq_ptr = mmap(NULL, ring->cq_sz, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+		if (ring->cq_ptr == MAP_FAILED) {
+			cf_warning(CF_OS, "io_uring cq mmap failed: errno %d (%s)", errno,
+					cf_strerror(errno));
+			munmap(ring->sq_ptr, ring->sq_sz);
+			close(fd);
+			cf_free(ring);
+			return NULL;
+		}
+	}
+
+	ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_sz, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+	if (ring->sqes == MAP_FAILED) {
+		cf_warning(CF_OS, "io_uring sqes mmap failed: errno %d (%s)", errno,
+				cf_strerror(errno));
+
+		if (! single_mmap) {
+			munmap(ring->cq_ptr, ring->cq_sz);
+		}
+
+		munmap(ring->sq_ptr, ring->sq_sz);
+		close(fd);
+		cf_free(ring);
+		return NULL;
+	}
+
+	uint8_t* sq = (uint8_t*)ring->sq_ptr;
+
+	ring->sq_head = (uint32_t*)(sq + p.sq_off.head);
+	ring->sq_tail = (uint32_t*)(sq + p.sq_off.tail);
+	ring->sq_mask = *(uint32_t*)(sq + p.sq_off.ring_mask);
+	ring->sq_array = (uint32_t*)(sq + p.sq_off.array);
+
+	uint8_t* cq = (uint8_t*)ring->cq_ptr;
+
+	ring->cq_head = (uint32_t*)(cq + p.cq_off.head);
+	ring->cq_tail = (uint32_t*)(cq + p.cq_off.tail);
+	ring->cq_mask = *(uint32_t*)(cq + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+	return ring;
+}
+
+void
+cf_uring_destroy(cf_uring* ring)
+{
+	munmap(ring->sqes, ring->sqes_sz);
+
+	if (ring->cq_ptr != ring->sq_ptr) {
+		munmap(ring->cq_ptr, ring->cq_sz);
+	}
+
+	munmap(ring->sq_ptr, ring->sq_sz);
+	close(ring->fd);
+	cf_free(ring);
+}
+
+// Same contract as pread_all() - on failure returns false with errno set.
+bool
+cf_uring_pread_all(cf_uring* ring, int fd, void* buf, size_t size,
+		off_t offset)
+{
+	while (size != 0) {
+		int32_t res;
+
+		if (! submit_and_wait(ring, fd, buf, size, offset, &res)) {
+			return false;
+		}
+
+		if (res < 0) {
+			errno = -res;
+			return false;
+		}
+
+		if (res == 0) { // should only happen if caller passed 0 size
+			errno = EINVAL;
+			return false;
+		}
+
+		buf += res;
+		offset += res;
+		size -= (size_t)res;
+	}
+
+	return true;
+}
+
+// Keeps up to a ring's worth of reads in flight, reaping completions in any
+// order and resubmitting short reads. Returns false only if the ring itself
+// fails (errno set) - per-read failures are in each read's err.
+bool
+cf_uring_pread_batch(cf_uring* ring, cf_uring_read* reads, uint32_t n_reads)
+{
+	struct iovec* iovs = cf_malloc(n_reads * sizeof(struct iovec));
+	uint32_t next = 0;
+	uint32_t n_in_flight = 0;
+	uint32_t to_submit = 0;
+
+	while (next < n_reads || n_in_flight != 0) {
+		while (next < n_reads && n_in_flight < ring->sq_entries) {
+			cf_uring_read* read = &reads[next];
+
+			read->err = 0;
+			iovs[next] = (struct iovec){
+					.iov_base = read->buf, .iov_len = read->size };
+
+			queue_read(ring, read->fd, &iovs[next], read->offset, next);
+			next++;
+			n_in_flight++;
+			to_submit++;
+		}
+
+		int rv = sys_io_uring_enter(ring->fd, to_submit, 1,
+				IORING_ENTER_GETEVENTS);
+
+		if (rv < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+
+			if (to_submit == n_in_flight) {
+				// Nothing in flight - unqueue, and let the caller fall back.
+				__atomic_store_n(ring->sq_tail, *ring->sq_tail - to_submit,
+						__ATOMIC_RELEASE);
+				cf_free(iovs);
+				return false;
+			}
+
+			// Reads in flight still own their buffers - can't bail out.
+			cf_warning(CF_OS, "io_uring enter failed: errno %d (%s)", errno,
+					cf_strerror(errno));
+			continue;
+		}
+
+		to_submit -= (uint32_t)rv;
+
+		uint32_t head = *ring->cq_head;
+
+		while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+			struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+			uint32_t ix = (uint32_t)cqe->user_data;
+			int32_t res = cqe->res;
+
+			__atomic_store_n(ring->cq_head, ++head, __ATOMIC_RELEASE);
+			n_in_flight--;
+
+			cf_uring_read* read = &reads[ix];
+
+			if (res <= 0) {
+				read->err = res < 0 ? -res : EINVAL;
+				continue;
+			}
+
+			read->buf += res;
+			read->offset += res;
+			read->size -= (size_t)res;
+
+			if (read->size != 0) {
+				iovs[ix] = (struct iovec){
+						.iov_base = read->buf, .iov_len = read->size };
+
+				queue_read(ring, read->fd, &iovs[ix], read->offset, ix);
+				n_in_flight++;
+				to_submit++;
+			}
+		}
+	}
+
+	cf_free(iovs);
+
+	return true;
+}
+
+// Lazily creates a polled ring for the calling thread. Returns NULL if rings
+// are unavailable (old kernel, etc.) or were disabled for this thread.
+cf_uring*
+cf_uring_thread_ring(void)
+{
+	if (g_thread_ring == RING_DISABLED) {
+		return NULL;
+	}
+
+	if (g_thread_ring != NULL) {
+		return g_thread_ring;
+	}
+
+	pthread_once(&g_thread_ring_once, thread_ring_key_create);
+
+	cf_uring* ring = cf_uring_create(THREAD_RING_ENTRIES, true);
+
+	if (ring == NULL) {
+		g_thread_ring = RING_DISABLED;
+		return NULL;
+	}
+
+	g_thread_ring = ring;
+	pthread_setspecific(g_thread_ring_key, ring);
+
+	return ring;
+}
+
+// Called when a ring turns out not to work for this thread's reads.
+void
+cf_uring_thread_disable(void)
+{
+	if (g_thread_ring != NULL && g_thread_ring != RING_DISABLED) {
+		pthread_setspecific(g_thread_ring_key, NULL);
+		cf_uring_destroy(g_thread_ring);
+	}
+
+	g_thread_ring = RING_DISABLED;
+}
+
+
+//==========================================================
+// Local helpers.
+//
+
+static void
+thread_ring_key_create(void)
+{
+	pthread_key_create(&g_thread_ring_key, thread_ring_destroy);
+}
+
+static void
+thread_ring_destroy(void* udata)
+{
+	cf_uring_destroy((cf_uring*)udata);
+}
+
+static void
+queue_read(cf_uring* ring, int fd, struct iovec* iov, off_t offset,
+		uint64_t user_data)
+{
+	uint32_t tail = *ring->sq_tail;
+	uint32_t ix = tail & ring->sq_mask;
+	struct io_uring_sqe* sqe = &ring->sqes[ix];
+
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = (uint64_t)offset;
+	sqe->addr = (uint64_t)(uintptr_t)iov;
+	sqe->len = 1;
+	sqe->user_data = user_data;
+
+	ring->sq_array[ix] = ix;
+
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static bool
+submit_and_wait(cf_uring* ring, int fd, void* buf, size_t size, off_t offset,
+		int32_t* res)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = size };
+
+	queue_read(ring, fd, &iov, offset, 0);
+
+	uint32_t to_submit = 1;
+
+	while (true) {
+		int rv = sys_io_uring_enter(ring->fd, to_submit, 1,
+				IORING_ENTER_GETEVENTS);
+
+		if (rv < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+
+			return false;
+		}
+
+		if (rv != 0) {
+			to_submit = 0;
+		}
+
+		uint32_t head = *ring->cq_head;
+
+		if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+			*res = ring->cqes[head & ring->cq_mask].res;
+			__atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+	}
+}